@@ -0,0 +1,145 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#include "liblwgeom_internal.h"
+#include "bytebuffer.h"
+#include "varint.h"
+
+/**
+* Allocate a new bytebuffer_t. Use bytebuffer_destroy to free.
+*/
+bytebuffer_t*
+bytebuffer_create(void)
+{
+	return bytebuffer_create_with_size(BYTEBUFFER_STARTSIZE);
+}
+
+/**
+* Allocate a new bytebuffer_t. Use bytebuffer_destroy to free.
+*/
+bytebuffer_t*
+bytebuffer_create_with_size(size_t size)
+{
+	bytebuffer_t *b;
+
+	if ( size < 1 )
+		size = 1;
+
+	b = lwalloc(sizeof(bytebuffer_t));
+	b->buf_start = lwalloc(size);
+	b->writecursor = b->buf_start;
+	b->capacity = size;
+	return b;
+}
+
+/**
+* Free the bytebuffer_t and all memory managed within it.
+*/
+void
+bytebuffer_destroy(bytebuffer_t *b)
+{
+	if ( ! b ) return;
+	if ( b->buf_start ) lwfree(b->buf_start);
+	lwfree(b);
+}
+
+/**
+* Reset the bytebuffer_t, keeping its memory for reuse.
+*/
+void
+bytebuffer_clear(bytebuffer_t *b)
+{
+	b->writecursor = b->buf_start;
+}
+
+/**
+* If necessary, expand the bytebuffer_t internal buffer to accomodate the
+* specified additional size.
+*/
+static inline void
+bytebuffer_makeroom(bytebuffer_t *b, size_t size_to_add)
+{
+	size_t current_size = (b->writecursor - b->buf_start);
+	size_t capacity = b->capacity;
+	size_t required_size = current_size + size_to_add;
+
+	while (capacity < required_size)
+		capacity *= 2;
+
+	if ( capacity > b->capacity )
+	{
+		b->buf_start = lwrealloc(b->buf_start, capacity);
+		b->capacity = capacity;
+		b->writecursor = b->buf_start + current_size;
+	}
+}
+
+void
+bytebuffer_append_byte(bytebuffer_t *b, const uint8_t val)
+{
+	bytebuffer_makeroom(b, 1);
+	*(b->writecursor)++ = val;
+}
+
+void
+bytebuffer_append_bulk(bytebuffer_t *b, const void *start, size_t size)
+{
+	bytebuffer_makeroom(b, size);
+	memcpy(b->writecursor, start, size);
+	b->writecursor += size;
+}
+
+void
+bytebuffer_append_bytebuffer(bytebuffer_t *b, const bytebuffer_t *src)
+{
+	bytebuffer_append_bulk(b, src->buf_start, bytebuffer_getlength(src));
+}
+
+/**
+* Append a signed integer as a zig-zag encoded varint
+*/
+void
+bytebuffer_append_varint(bytebuffer_t *b, const int64_t val)
+{
+	bytebuffer_makeroom(b, VARINT_MAX_SIZE);
+	b->writecursor += varint_s64_encode_buf(val, b->writecursor);
+}
+
+/**
+* Append an unsigned integer as a varint
+*/
+void
+bytebuffer_append_uvarint(bytebuffer_t *b, const uint64_t val)
+{
+	bytebuffer_makeroom(b, VARINT_MAX_SIZE);
+	b->writecursor += varint_u64_encode_buf(val, b->writecursor);
+}
+
+size_t
+bytebuffer_getlength(const bytebuffer_t *b)
+{
+	return (size_t)(b->writecursor - b->buf_start);
+}
+
+/**
+* Returns a newly allocated copy of the contents. The caller is
+* responsible for freeing it with lwfree.
+*/
+uint8_t*
+bytebuffer_get_buffer_copy(const bytebuffer_t *b, size_t *buffer_length)
+{
+	size_t len = bytebuffer_getlength(b);
+	uint8_t *buf = lwalloc(len ? len : 1);
+	memcpy(buf, b->buf_start, len);
+	if ( buffer_length )
+		*buffer_length = len;
+	return buf;
+}
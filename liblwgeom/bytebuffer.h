@@ -0,0 +1,44 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#ifndef _LIBLWGEOM_BYTEBUFFER_H
+#define _LIBLWGEOM_BYTEBUFFER_H 1
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BYTEBUFFER_STARTSIZE 128
+
+/*
+* A growable buffer of bytes, the binary sibling of stringbuffer_t
+*/
+typedef struct
+{
+	size_t capacity;
+	uint8_t *buf_start;
+	uint8_t *writecursor;
+}
+bytebuffer_t;
+
+extern bytebuffer_t *bytebuffer_create(void);
+extern bytebuffer_t *bytebuffer_create_with_size(size_t size);
+extern void bytebuffer_destroy(bytebuffer_t *b);
+extern void bytebuffer_clear(bytebuffer_t *b);
+extern void bytebuffer_append_byte(bytebuffer_t *b, const uint8_t val);
+extern void bytebuffer_append_bulk(bytebuffer_t *b, const void *start, size_t size);
+extern void bytebuffer_append_bytebuffer(bytebuffer_t *b, const bytebuffer_t *src);
+extern void bytebuffer_append_varint(bytebuffer_t *b, const int64_t val);
+extern void bytebuffer_append_uvarint(bytebuffer_t *b, const uint64_t val);
+extern size_t bytebuffer_getlength(const bytebuffer_t *b);
+extern uint8_t *bytebuffer_get_buffer_copy(const bytebuffer_t *b, size_t *buffer_length);
+
+#endif /* _LIBLWGEOM_BYTEBUFFER_H */
@@ -0,0 +1,200 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CUnit/Basic.h"
+
+#include "liblwgeom_internal.h"
+#include "cu_tester.h"
+
+/*
+** Global variables to hold the WKT result and the crs name
+*/
+static char *s;
+static char *srs;
+
+static int init_geojson_in_suite(void)
+{
+	s = NULL;
+	srs = NULL;
+	return 0;
+}
+
+static int clean_geojson_in_suite(void)
+{
+	if (s) free(s);
+	if (srs) lwfree(srs);
+	s = NULL;
+	srs = NULL;
+	return 0;
+}
+
+/*
+** Read the GeoJSON and keep the result as WKT, or NULL on error
+*/
+static void cu_geojson_in(char *json)
+{
+	LWGEOM *g;
+
+	if ( s ) free(s);
+	if ( srs ) lwfree(srs);
+	s = NULL;
+	cu_error_msg_reset();
+
+	g = lwgeom_from_geojson(json, &srs);
+	if ( ! g ) return;
+	s = lwgeom_to_wkt(g, WKT_ISO, 8, NULL);
+	lwgeom_free(g);
+}
+
+/*
+** Write the WKT out as GeoJSON and check it reads back the same
+*/
+static void cu_geojson_roundtrip(char *wkt)
+{
+	LWGEOM *g = lwgeom_from_wkt(wkt, LW_PARSER_CHECK_NONE);
+	char *json = lwgeom_to_geojson(g, NULL, 15, 0);
+
+	cu_geojson_in(json);
+	if ( ! s || strcmp(s, wkt) )
+		fprintf(stderr, "\nIn:   %s\nJSON: %s\nOut:  %s\n", wkt, json, s ? s : cu_error_msg);
+	CU_ASSERT_STRING_EQUAL(s ? s : "", wkt);
+
+	lwfree(json);
+	lwgeom_free(g);
+}
+
+static void test_geojson_in_roundtrip(void)
+{
+	cu_geojson_roundtrip("POINT(1 2)");
+	cu_geojson_roundtrip("POINT Z (1 2 3)");
+	cu_geojson_roundtrip("LINESTRING(0 0,1 1,2 -1.5)");
+	cu_geojson_roundtrip("POLYGON((0 0,0 10,10 10,10 0,0 0),(1 1,2 1,2 2,1 1))");
+	cu_geojson_roundtrip("MULTIPOINT(1 2,3 4)");
+	cu_geojson_roundtrip("MULTILINESTRING((0 0,1 1),(2 2,3 3))");
+	cu_geojson_roundtrip("MULTIPOLYGON(((0 0,0 1,1 1,0 0)),((2 2,2 3,3 3,2 2)))");
+	cu_geojson_roundtrip("MULTIPOLYGON Z (((0 0 1,0 1 1,1 1 1,0 0 1)))");
+	cu_geojson_roundtrip("GEOMETRYCOLLECTION(POINT(1 2),LINESTRING(0 0,1 1))");
+	cu_geojson_roundtrip("GEOMETRYCOLLECTION EMPTY");
+}
+
+static void test_geojson_in_syntax(void)
+{
+	/* Members in any order, names in any case, other members skipped */
+	cu_geojson_in("{\"coordinates\":[1,2],\"bbox\":[1,2,1,2],\"type\":\"Point\"}");
+	CU_ASSERT_STRING_EQUAL(s, "POINT(1 2)");
+	cu_geojson_in(" { \"TYPE\" : \"linestring\" , \"Coordinates\" : [ [ 1 , 2 ] , [ 3e1 , -4.5E-1 ] ] } ");
+	CU_ASSERT_STRING_EQUAL(s, "LINESTRING(1 2,30 -0.45)");
+	cu_geojson_in("{\"type\":\"Point\",\"properties\":{\"a\":[true,false,null,\"}\\\"\"]},\"coordinates\":[1,2]}");
+	CU_ASSERT_STRING_EQUAL(s, "POINT(1 2)");
+	cu_geojson_in("{\"geometries\":[{\"coordinates\":[1,2],\"type\":\"Point\"}],\"type\":\"GeometryCollection\"}");
+	CU_ASSERT_STRING_EQUAL(s, "GEOMETRYCOLLECTION(POINT(1 2))");
+	cu_geojson_in("{\"type\":\"GeometryCollection\",\"geometries\":[{\"type\":\"GeometryCollection\",\"geometries\":[{\"type\":\"Point\",\"coordinates\":[3,4]}]}]}");
+	CU_ASSERT_STRING_EQUAL(s, "GEOMETRYCOLLECTION(GEOMETRYCOLLECTION(POINT(3 4)))");
+
+	/* Empty coordinates */
+	cu_geojson_in("{\"type\":\"Point\",\"coordinates\":[]}");
+	CU_ASSERT_STRING_EQUAL(s, "POINT EMPTY");
+	cu_geojson_in("{\"type\":\"MultiPolygon\",\"coordinates\":[]}");
+	CU_ASSERT_STRING_EQUAL(s, "MULTIPOLYGON EMPTY");
+
+	/* Repeated points are dropped */
+	cu_geojson_in("{\"type\":\"LineString\",\"coordinates\":[[0,0],[0,0],[1,1]]}");
+	CU_ASSERT_STRING_EQUAL(s, "LINESTRING(0 0,1 1)");
+}
+
+static void test_geojson_in_z(void)
+{
+	/* Any Z makes the geometry 3D, missing ones are zero */
+	cu_geojson_in("{\"type\":\"LineString\",\"coordinates\":[[0,0],[1,1,5]]}");
+	CU_ASSERT_STRING_EQUAL(s, "LINESTRING Z (0 0 0,1 1 5)");
+	cu_geojson_in("{\"type\":\"MultiPoint\",\"coordinates\":[[0,0,1],[1,1]]}");
+	CU_ASSERT_STRING_EQUAL(s, "MULTIPOINT Z (0 0 1,1 1 0)");
+
+	/* Ordinates after Z are ignored */
+	cu_geojson_in("{\"type\":\"Point\",\"coordinates\":[1,2,3,4]}");
+	CU_ASSERT_STRING_EQUAL(s, "POINT Z (1 2 3)");
+}
+
+static void test_geojson_in_crs(void)
+{
+	cu_geojson_in("{\"type\":\"Point\",\"crs\":{\"type\":\"name\",\"properties\":{\"name\":\"EPSG:4326\"}},\"coordinates\":[1,2]}");
+	CU_ASSERT_STRING_EQUAL(s, "POINT(1 2)");
+	CU_ASSERT_STRING_EQUAL(srs, "EPSG:4326");
+
+	/* A crs without a type is ignored */
+	cu_geojson_in("{\"type\":\"Point\",\"crs\":{\"properties\":{\"name\":\"EPSG:4326\"}},\"coordinates\":[1,2]}");
+	CU_ASSERT_STRING_EQUAL(s, "POINT(1 2)");
+	CU_ASSERT_PTR_NULL(srs);
+}
+
+static void test_geojson_in_errors(void)
+{
+	cu_geojson_in("crashme");
+	CU_ASSERT_PTR_NULL(s);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "unexpected character (at offset 0)");
+
+	cu_geojson_in("{\"type\":\"Point\",\"coordinates\":[1,2]");
+	CU_ASSERT_PTR_NULL(s);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "unexpected end of data (at offset 35)");
+
+	cu_geojson_in("{\"type\":\"Point\",\"coordinates\":[1,.2]}");
+	CU_ASSERT_PTR_NULL(s);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "unexpected character (at offset 33)");
+
+	cu_geojson_in("{\"type\":\"Point\",\"coordinates\":[1,2]} x");
+	CU_ASSERT_PTR_NULL(s);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "unexpected character (at offset 37)");
+
+	cu_geojson_in("{ \"type\": \"Point\", \"crashme\": [100.0, 0.0] }");
+	CU_ASSERT_PTR_NULL(s);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "Unable to find 'coordinates' in GeoJSON string");
+
+	cu_geojson_in("{\"type\":\"GeometryCollection\",\"coordinates\":[]}");
+	CU_ASSERT_PTR_NULL(s);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "Unable to find 'geometries' in GeoJSON string");
+
+	cu_geojson_in("{\"coordinates\":[1,2]}");
+	CU_ASSERT_PTR_NULL(s);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "unknown GeoJSON type");
+
+	cu_geojson_in("{\"type\":\"Feature\",\"coordinates\":[1,2]}");
+	CU_ASSERT_PTR_NULL(s);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "invalid GeoJson representation");
+
+	cu_geojson_in("{\"type\":\"LineString\",\"coordinates\":[1,2]}");
+	CU_ASSERT_PTR_NULL(s);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "invalid GeoJSON representation");
+
+	cu_geojson_in("{\"type\":\"Point\",\"coordinates\":[1]}");
+	CU_ASSERT_PTR_NULL(s);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "Too few ordinates in GeoJSON");
+
+	cu_geojson_in("{\"type\":\"Point\",\"p\":[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]}");
+	CU_ASSERT_PTR_NULL(s);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "nesting too deep (at offset 51)");
+}
+
+/*
+** Used by test harness to register the tests in this file.
+*/
+CU_TestInfo geojson_in_tests[] =
+{
+	PG_TEST(test_geojson_in_roundtrip),
+	PG_TEST(test_geojson_in_syntax),
+	PG_TEST(test_geojson_in_z),
+	PG_TEST(test_geojson_in_crs),
+	PG_TEST(test_geojson_in_errors),
+	CU_TEST_INFO_NULL
+};
+CU_SuiteInfo geojson_in_suite = {"GeoJSON In Suite",  init_geojson_in_suite,  clean_geojson_in_suite, geojson_in_tests};
@@ -0,0 +1,173 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CUnit/Basic.h"
+
+#include "liblwgeom_internal.h"
+#include "cu_tester.h"
+
+/*
+** Global variable to hold WKT strings
+*/
+static char *s;
+
+static int init_twkb_in_suite(void)
+{
+	s = NULL;
+	return 0;
+}
+
+static int clean_twkb_in_suite(void)
+{
+	if (s) free(s);
+	s = NULL;
+	return 0;
+}
+
+/*
+** Write the WKT out as TWKB, read it back and keep the result as WKT
+*/
+static void cu_twkb_in(char *wkt, uint8_t variant, int8_t prec_xy, int8_t prec_z, int8_t prec_m)
+{
+	LWGEOM *g_a = lwgeom_from_wkt(wkt, LW_PARSER_CHECK_NONE);
+	LWGEOM *g_b;
+	uint8_t *twkb;
+	size_t twkb_size;
+
+	twkb = lwgeom_to_twkb(g_a, variant, prec_xy, prec_z, prec_m, &twkb_size);
+	g_b = lwgeom_from_twkb(twkb, twkb_size, LW_PARSER_CHECK_ALL);
+	if ( s ) free(s);
+	s = lwgeom_to_wkt(g_b, WKT_ISO, 8, NULL);
+	lwfree(twkb);
+	lwgeom_free(g_a);
+	lwgeom_free(g_b);
+}
+
+/*
+** Read a hex TWKB, and keep the result as WKT
+*/
+static void cu_twkb_from_hex(char *hex)
+{
+	uint8_t *twkb = bytes_from_hexbytes(hex, strlen(hex));
+	LWGEOM *g;
+
+	cu_error_msg_reset();
+	g = lwgeom_from_twkb(twkb, strlen(hex) / 2, LW_PARSER_CHECK_ALL);
+	if ( s ) free(s);
+	s = g ? lwgeom_to_wkt(g, WKT_ISO, 8, NULL) : NULL;
+	if ( g ) lwgeom_free(g);
+	lwfree(twkb);
+}
+
+static void test_twkb_in_point(void)
+{
+	cu_twkb_in("POINT(1 2)", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "POINT(1 2)");
+
+	cu_twkb_in("POINT(1.2345678 -2.3456789)", 0, 3, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "POINT(1.235 -2.346)");
+
+	cu_twkb_in("POINT(1234 5678)", 0, -2, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "POINT(1200 5700)");
+
+	cu_twkb_in("POINT(1.5 2.5 3.25 4.125)", TWKB_BBOX | TWKB_SIZE, 1, 2, 3);
+	CU_ASSERT_STRING_EQUAL(s, "POINT ZM (1.5 2.5 3.25 4.125)");
+
+	cu_twkb_in("POINTM(1 2 3.5)", 0, 0, 0, 1);
+	CU_ASSERT_STRING_EQUAL(s, "POINT M (1 2 3.5)");
+
+	cu_twkb_in("POINT EMPTY", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "POINT EMPTY");
+}
+
+static void test_twkb_in_linestring(void)
+{
+	cu_twkb_in("LINESTRING(1 1,-5 5,5 -5)", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "LINESTRING(1 1,-5 5,5 -5)");
+
+	cu_twkb_in("LINESTRING(0 0,0.1 0.1,1 1)", TWKB_BBOX | TWKB_SIZE, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "LINESTRING(0 0,1 1)");
+
+	cu_twkb_in("LINESTRING Z EMPTY", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "LINESTRING Z EMPTY");
+}
+
+static void test_twkb_in_polygon(void)
+{
+	cu_twkb_in("POLYGON((0 0,0 10,10 10,10 0,0 0),(1 1,1 2,2 2,1 1))", TWKB_BBOX, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "POLYGON((0 0,0 10,10 10,10 0,0 0),(1 1,1 2,2 2,1 1))");
+
+	/* Rings keep four points however much they collapse */
+	cu_twkb_in("POLYGON((0 0,0 0.1,0.1 0.1,0 0))", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "POLYGON((0 0,0 0,0 0,0 0))");
+}
+
+static void test_twkb_in_multi(void)
+{
+	cu_twkb_in("MULTIPOINT(0 0,1.5 1.5,-3 3)", TWKB_BBOX, 1, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "MULTIPOINT(0 0,1.5 1.5,-3 3)");
+
+	cu_twkb_in("MULTILINESTRING((0 0,1 1),(1 1,2 2))", TWKB_SIZE, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "MULTILINESTRING((0 0,1 1),(1 1,2 2))");
+
+	cu_twkb_in("MULTIPOLYGON(((0 0,0 1,1 1,0 0)),((5 5,5 6,6 6,5 5)))", TWKB_BBOX | TWKB_SIZE, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "MULTIPOLYGON(((0 0,0 1,1 1,0 0)),((5 5,5 6,6 6,5 5)))");
+
+	/* Ids are read past */
+	cu_twkb_from_hex("040402" "1428" "0000" "0202");
+	CU_ASSERT_STRING_EQUAL(s, "MULTIPOINT(0 0,1 1)");
+}
+
+static void test_twkb_in_collection(void)
+{
+	cu_twkb_in("GEOMETRYCOLLECTION(POINT(1 1),LINESTRING(0 0,1 1),POLYGON EMPTY,GEOMETRYCOLLECTION(MULTIPOINT(2 2)))", TWKB_BBOX | TWKB_SIZE, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "GEOMETRYCOLLECTION(POINT(1 1),LINESTRING(0 0,1 1),POLYGON EMPTY,GEOMETRYCOLLECTION(MULTIPOINT(2 2)))");
+
+	cu_twkb_in("GEOMETRYCOLLECTION EMPTY", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "GEOMETRYCOLLECTION EMPTY");
+}
+
+static void test_twkb_in_errors(void)
+{
+	/* Truncated linestring */
+	cu_twkb_from_hex("0200020000");
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "TWKB structure does not match expected size!");
+
+	/* Unknown type */
+	cu_twkb_from_hex("0900");
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "Unknown TWKB type (9)!");
+
+	/* One point line */
+	cu_twkb_from_hex("0200010000");
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "LineString must have at least two points");
+
+	/* Open ring */
+	cu_twkb_from_hex("030001" "04" "0000" "0002" "0200" "0000");
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "Polygon must have closed rings");
+}
+
+/*
+** Used by test harness to register the tests in this file.
+*/
+CU_TestInfo twkb_in_tests[] =
+{
+	PG_TEST(test_twkb_in_point),
+	PG_TEST(test_twkb_in_linestring),
+	PG_TEST(test_twkb_in_polygon),
+	PG_TEST(test_twkb_in_multi),
+	PG_TEST(test_twkb_in_collection),
+	PG_TEST(test_twkb_in_errors),
+	CU_TEST_INFO_NULL
+};
+CU_SuiteInfo twkb_in_suite = {"TWKB In Suite",  init_twkb_in_suite,  clean_twkb_in_suite, twkb_in_tests};
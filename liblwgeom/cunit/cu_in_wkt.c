@@ -16,6 +16,7 @@
 #include "CUnit/Basic.h"
 
 #include "liblwgeom_internal.h"
+#include "lwin_wkt.h"
 #include "cu_tester.h"
 
 /*
@@ -344,6 +345,82 @@ static void test_wkt_in_errlocation(void)
 
 }
 
+/*
+* The hand-written reader has to agree with the flex/bison one on
+* geometries, error messages and error locations.
+*/
+static void test_wkt_in_readers(void)
+{
+	static char *wkts[] =
+	{
+		"POINT(1 2)",
+		"point zm (1 2 3 4)",
+		"POINTM(1e3 -2.5E-2 .5)",
+		"POINT(1. -0 00012.50 1e400)",
+		"POINT(0.1234567890123456789 12345678901234567890)",
+		"SRID=4326;MULTIPOINT(0 0,(1 1))",
+		"srid=-1;LINESTRING EMPTY",
+		"LINESTRING(0 0,1 1,2 2,3 3,4 4)",
+		"POLYGON((0 0,1 0,1 1,0 0),(0.1 0.1,0.2 0.1,0.2 0.2,0.1 0.1))",
+		"MULTIPOLYGON(((0 0,1 0,1 1,0 0)),EMPTY)",
+		"GEOMETRYCOLLECTION(POINT(0 0),GEOMETRYCOLLECTION EMPTY,TIN(((0 0 0,1 0 0,0 1 0,0 0 0))))",
+		"COMPOUNDCURVE(CIRCULARSTRING(0 0,1 1,1 0),(1 0,0 1))",
+		"CURVEPOLYGON(COMPOUNDCURVE(CIRCULARSTRING(0 0,1 1,1 0),(1 0,0 0)))",
+		"MULTISURFACE(CURVEPOLYGON((0 0,1 0,1 1,0 0)),((0 0,1 0,1 1,0 0)))",
+		"POLYHEDRALSURFACE(((0 0 0,0 0 1,0 1 0,0 0 0)))",
+		"TRIANGLE((0 0,1 0,0 1,0 0))",
+		/* Errors */
+		"",
+		"POINT",
+		"POINT(1)",
+		"POINT(1 2 3 4 5)",
+		"POINT(1 2)#",
+		"POINT(1 2))",
+		"POINT(1 2",
+		"POINT Z (1 2)",
+		"POINTEMPTY",
+		"LINESTRING(0 0)",
+		"LINESTRING((0 0 0,1 1)",
+		"LINESTRING(0 0 0,1 1)",
+		"LINESTRING(0 0,1 1-)",
+		"POLYGON((0 0,1 0,1 1,0 1))",
+		"CIRCULARSTRING(0 0,1 1,2 2,3 3)",
+		"COMPOUNDCURVE(CIRCULARSTRING(0 0,1 1,1 0),(1 2,0 1))",
+		"TIN(((0 1 2,3 4 5,6 7 8,0 1 3)))",
+		"MULTIPOINT(0 0,,1 1)",
+		"SRID=4326 POINT(1 2)",
+		"GEOMETRYCOLLECTION Z (POINT M (1 2 3))"
+	};
+	LWGEOM_PARSER_RESULT p1, p2;
+	char *s1, *s2;
+	int i, rv1, rv2;
+
+	for ( i = 0; i < sizeof(wkts)/sizeof(char*); i++ )
+	{
+		lwgeom_parser_result_init(&p1);
+		lwgeom_parser_result_init(&p2);
+		rv1 = lwgeom_parse_wkt_bison(&p1, wkts[i], LW_PARSER_CHECK_ALL);
+		rv2 = lwgeom_parse_wkt_rd(&p2, wkts[i], LW_PARSER_CHECK_ALL);
+
+		CU_ASSERT_EQUAL(rv1, rv2);
+		CU_ASSERT_EQUAL(p1.errcode, p2.errcode);
+		CU_ASSERT_EQUAL(p1.errlocation, p2.errlocation);
+		CU_ASSERT_EQUAL((p1.geom == NULL), (p2.geom == NULL));
+		if ( p1.geom && p2.geom )
+		{
+			s1 = lwgeom_to_hexwkb(p1.geom, WKB_EXTENDED, NULL);
+			s2 = lwgeom_to_hexwkb(p2.geom, WKB_EXTENDED, NULL);
+			CU_ASSERT_STRING_EQUAL(s1, s2);
+			lwfree(s1);
+			lwfree(s2);
+		}
+		//printf("%s: %d %d %d\n", wkts[i], rv2, p2.errcode, p2.errlocation);
+
+		lwgeom_parser_result_free(&p1);
+		lwgeom_parser_result_free(&p2);
+	}
+}
+
 /*
 ** Used by test harness to register the tests in this file.
 */
@@ -365,6 +442,7 @@ CU_TestInfo wkt_in_tests[] =
 	PG_TEST(test_wkt_in_tin),
 	PG_TEST(test_wkt_in_polyhedralsurface),
 	PG_TEST(test_wkt_in_errlocation),
+	PG_TEST(test_wkt_in_readers),
 	CU_TEST_INFO_NULL
 };
 CU_SuiteInfo wkt_in_suite = {"WKT In Suite",  init_wkt_in_suite,  clean_wkt_in_suite, wkt_in_tests};
@@ -777,6 +777,82 @@ static void test_lwgeom_is_empty(void)
 
 }
 
+/*
+ * Test the direct GSERIALIZED accessors against their LWGEOM twins
+ */
+static void test_gserialized_summary(void)
+{
+	static char *wkts[] =
+	{
+		"POINT(0 0)",
+		"POINT EMPTY",
+		"LINESTRING(0 0,1 1,2 2)",
+		"LINESTRING EMPTY",
+		"POLYGON((0 0,10 0,10 10,0 10,0 0),(1 1,2 1,2 2,1 1))",
+		"POLYGON EMPTY",
+		"TRIANGLE((0 0,0 1,1 1,0 0))",
+		"CIRCULARSTRING(0 0,1 1,2 0)",
+		"COMPOUNDCURVE(CIRCULARSTRING(0 0,1 1,1 0),(1 0,0 1))",
+		"CURVEPOLYGON(CIRCULARSTRING(0 0,4 0,4 4,0 4,0 0),(1 1,3 3,3 1,1 1))",
+		"MULTIPOINT(0 0,1 1)",
+		"MULTILINESTRING((0 0,1 1),(2 2,3 3,4 4))",
+		"MULTIPOLYGON(((0 0,10 0,10 10,0 10,0 0)),((20 20,30 20,30 30,20 20),(21 21,22 21,22 22,21 21)))",
+		"MULTICURVE((0 0,5 5),CIRCULARSTRING(4 0,4 4,8 4))",
+		"MULTISURFACE(CURVEPOLYGON(CIRCULARSTRING(0 0,4 0,4 4,0 4,0 0)),((10 10,14 12,11 10,10 10)))",
+		"POLYHEDRALSURFACE(((0 0 0,0 0 1,0 1 1,0 0 0)),((0 0 0,0 1 0,1 0 0,0 0 0)))",
+		"TIN(((0 0 0,0 0 1,0 1 0,0 0 0)),((0 0 0,0 1 0,1 1 0,0 0 0)))",
+		"GEOMETRYCOLLECTION(POINT(0 0),POLYGON((0 0,1 0,1 1,0 0)),GEOMETRYCOLLECTION(LINESTRING(0 0,1 1)))",
+		"GEOMETRYCOLLECTION(POINT EMPTY,POLYGON((0 0,1 0,1 1,0 0)))",
+		"GEOMETRYCOLLECTION(GEOMETRYCOLLECTION EMPTY, POINT EMPTY, POLYGON EMPTY, GEOMETRYCOLLECTION(MULTIPOLYGON EMPTY))",
+		"GEOMETRYCOLLECTION EMPTY"
+	};
+	LWGEOM *geom;
+	GSERIALIZED *g;
+	int i, ngeoms;
+
+	for ( i = 0; i < sizeof(wkts)/sizeof(char*); i++ )
+	{
+		geom = lwgeom_from_wkt(wkts[i], LW_PARSER_CHECK_NONE);
+		g = gserialized_from_lwgeom(geom, 0, NULL);
+
+		CU_ASSERT_EQUAL(gserialized_is_empty(g), lwgeom_is_empty(geom));
+		CU_ASSERT_EQUAL(gserialized_count_vertices(g), lwgeom_count_vertices(geom));
+		CU_ASSERT_EQUAL(gserialized_count_rings(g), lwgeom_count_rings(geom));
+
+		ngeoms = lwgeom_is_empty(geom) ? 0 :
+		         lwgeom_is_collection(geom) ? lwgeom_as_lwcollection(geom)->ngeoms : 1;
+		CU_ASSERT_EQUAL(gserialized_get_ngeoms(g), ngeoms);
+
+		lwfree(g);
+		lwgeom_free(geom);
+	}
+}
+
+/*
+ * Deserialized point arrays are read-only views on the serialization
+ */
+static void test_lwgeom_from_gserialized_readonly(void)
+{
+	LWGEOM *geom;
+	LWPOLY *poly;
+	GSERIALIZED *g;
+	int i;
+
+	geom = lwgeom_from_wkt("POLYGON((0 0,10 0,10 10,0 10,0 0),(1 1,2 1,2 2,1 1))", LW_PARSER_CHECK_NONE);
+	g = gserialized_from_lwgeom(geom, 0, NULL);
+	lwgeom_free(geom);
+
+	poly = lwgeom_as_lwpoly(lwgeom_from_gserialized(g));
+	for ( i = 0; i < poly->nrings; i++ )
+	{
+		CU_ASSERT(FLAGS_GET_READONLY(poly->rings[i]->flags));
+		CU_ASSERT(poly->rings[i]->serialized_pointlist > (uint8_t*)g);
+		CU_ASSERT(poly->rings[i]->serialized_pointlist < (uint8_t*)g + SIZE_GET(g->size));
+	}
+	lwpoly_free(poly);
+	lwfree(g);
+}
+
 /*
  * Test lwgeom_same
  */
@@ -895,6 +971,8 @@ CU_TestInfo libgeom_tests[] =
 	PG_TEST(test_lwgeom_force_clockwise),
 	PG_TEST(test_lwgeom_calculate_gbox),
 	PG_TEST(test_lwgeom_is_empty),
+	PG_TEST(test_gserialized_summary),
+	PG_TEST(test_lwgeom_from_gserialized_readonly),
 	PG_TEST(test_lwgeom_same),
 	CU_TEST_INFO_NULL
 };
@@ -119,6 +119,40 @@ static void test_misc_wkb(void)
 		
 }
 
+static void test_misc_print_double(void)
+{
+	char buf[OUT_DOUBLE_BUFFER_SIZE];
+	int len;
+
+	len = lwprint_double(1.5, 15, buf, OUT_DOUBLE_BUFFER_SIZE);
+	CU_ASSERT_STRING_EQUAL(buf, "1.5");
+	CU_ASSERT_EQUAL(len, 3);
+	lwprint_double(-0.0000001, 5, buf, OUT_DOUBLE_BUFFER_SIZE);
+	CU_ASSERT_STRING_EQUAL(buf, "-0");
+	lwprint_double(123456.999999, 3, buf, OUT_DOUBLE_BUFFER_SIZE);
+	CU_ASSERT_STRING_EQUAL(buf, "123457");
+	lwprint_double(0.125, 2, buf, OUT_DOUBLE_BUFFER_SIZE);
+	CU_ASSERT_STRING_EQUAL(buf, "0.12");
+	lwprint_double(-2.0625, 9, buf, OUT_DOUBLE_BUFFER_SIZE);
+	CU_ASSERT_STRING_EQUAL(buf, "-2.0625");
+	lwprint_double(1.5e20, 9, buf, OUT_DOUBLE_BUFFER_SIZE);
+	CU_ASSERT_STRING_EQUAL(buf, "1.5e+20");
+
+	len = lwprint_double_sig(0.1 + 0.2, 15, buf, OUT_DOUBLE_BUFFER_SIZE);
+	CU_ASSERT_STRING_EQUAL(buf, "0.3");
+	CU_ASSERT_EQUAL(len, 3);
+	lwprint_double_sig(-1234.5678, 6, buf, OUT_DOUBLE_BUFFER_SIZE);
+	CU_ASSERT_STRING_EQUAL(buf, "-1234.57");
+	lwprint_double_sig(0.00012345, 3, buf, OUT_DOUBLE_BUFFER_SIZE);
+	CU_ASSERT_STRING_EQUAL(buf, "0.000123");
+	lwprint_double_sig(9.9999, 3, buf, OUT_DOUBLE_BUFFER_SIZE);
+	CU_ASSERT_STRING_EQUAL(buf, "10");
+	lwprint_double_sig(0.00001, 15, buf, OUT_DOUBLE_BUFFER_SIZE);
+	CU_ASSERT_STRING_EQUAL(buf, "1e-05");
+	lwprint_double_sig(-0.0, 15, buf, OUT_DOUBLE_BUFFER_SIZE);
+	CU_ASSERT_STRING_EQUAL(buf, "-0");
+}
+
 /*
 ** Used by the test harness to register the tests in this file.
 */
@@ -129,6 +163,7 @@ CU_TestInfo misc_tests[] =
 	PG_TEST(test_misc_count_vertices),
 	PG_TEST(test_misc_area),
 	PG_TEST(test_misc_wkb),
+	PG_TEST(test_misc_print_double),
 	CU_TEST_INFO_NULL
 };
 CU_SuiteInfo misc_suite = {"misc", NULL, NULL, misc_tests };
@@ -0,0 +1,165 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CUnit/Basic.h"
+
+#include "liblwgeom_internal.h"
+#include "cu_tester.h"
+
+/*
+** Global variable to hold hex MVT geometries
+*/
+static char *s;
+static uint8_t mvt_type;
+
+static int init_out_mvt_suite(void)
+{
+	s = NULL;
+	return 0;
+}
+
+static int clean_out_mvt_suite(void)
+{
+	if (s) free(s);
+	s = NULL;
+	return 0;
+}
+
+/*
+** Encode a WKT geometry into a tile covering the given bounds
+*/
+static void cu_mvt_bounds(char *wkt, double xmin, double ymin, double xmax, double ymax, uint32_t extent, uint32_t buffer)
+{
+	LWGEOM *g = lwgeom_from_wkt(wkt, LW_PARSER_CHECK_NONE);
+	GBOX bounds;
+	uint8_t *mvt;
+	size_t size;
+
+	memset(&bounds, 0, sizeof(GBOX));
+	bounds.xmin = xmin;
+	bounds.ymin = ymin;
+	bounds.xmax = xmax;
+	bounds.ymax = ymax;
+
+	mvt = lwgeom_to_mvt_geom(g, &bounds, extent, buffer, &mvt_type, &size);
+	if ( s ) free(s);
+	s = mvt ? hexbytes_from_bytes(mvt, size) : NULL;
+	if ( mvt ) lwfree(mvt);
+	lwgeom_free(g);
+}
+
+/*
+** A 4096 unit tile over the same map area, so only Y gets flipped
+*/
+static void cu_mvt(char *wkt)
+{
+	cu_mvt_bounds(wkt, 0, 0, 4096, 4096, 4096, 256);
+}
+
+static void test_mvt_point(void)
+{
+	cu_mvt("POINT(25 4079)");
+	CU_ASSERT_STRING_EQUAL(s, "093222");
+	CU_ASSERT_EQUAL(mvt_type, MVT_POINT);
+
+	cu_mvt("MULTIPOINT(5 4089,3 4094)");
+	CU_ASSERT_STRING_EQUAL(s, "110A0E0309");
+	CU_ASSERT_EQUAL(mvt_type, MVT_POINT);
+
+	/* Scaled into tile units */
+	cu_mvt_bounds("POINT(0.5 0.5)", 0, 0, 1, 1, 4096, 0);
+	CU_ASSERT_STRING_EQUAL(s, "0980208020");
+}
+
+static void test_mvt_linestring(void)
+{
+	cu_mvt("LINESTRING(2 4094,2 4086,10 4086)");
+	CU_ASSERT_STRING_EQUAL(s, "0904041200101000");
+	CU_ASSERT_EQUAL(mvt_type, MVT_LINESTRING);
+
+	/* Vertices that snap onto the one before are dropped */
+	cu_mvt("LINESTRING(2 4094,2.2 4094.1,2 4086,10 4086)");
+	CU_ASSERT_STRING_EQUAL(s, "0904041200101000");
+
+	/* The cursor carries on between parts */
+	cu_mvt("MULTILINESTRING((2 4094,2 4086,10 4086),(1 4095,3 4093))");
+	CU_ASSERT_STRING_EQUAL(s, "0904041200101000" "091111" "0A0404");
+
+	/* Lines collapsing onto a single cell are left out */
+	cu_mvt("LINESTRING(0 0,0.1 0.1)");
+	CU_ASSERT_PTR_NULL(s);
+}
+
+static void test_mvt_polygon(void)
+{
+	cu_mvt("POLYGON((3 4090,8 4084,20 4062,3 4090))");
+	CU_ASSERT_STRING_EQUAL(s, "09060C120A0C182C0F");
+	CU_ASSERT_EQUAL(mvt_type, MVT_POLYGON);
+
+	/* Shells are turned clockwise in tile space */
+	cu_mvt("POLYGON((3 4090,20 4062,8 4084,3 4090))");
+	CU_ASSERT_STRING_EQUAL(s, "09060C120A0C182C0F");
+
+	/* ... and holes anticlockwise */
+	cu_mvt("POLYGON((0 4096,10 4096,10 4086,0 4086,0 4096),(2 4094,2 4088,8 4088,8 4094,2 4094))");
+	CU_ASSERT_STRING_EQUAL(s, "090000" "1A" "140000141300" "0F" "09040F" "1A" "000C0C00000B" "0F");
+
+	/* Holes that collapse are left out */
+	cu_mvt("POLYGON((0 4096,10 4096,10 4086,0 4086,0 4096),(2 4094,2.1 4094,2.1 4093.9,2 4094))");
+	CU_ASSERT_STRING_EQUAL(s, "090000" "1A" "140000141300" "0F");
+
+	/* So are shells, with their holes */
+	cu_mvt("POLYGON((0 0,0.1 0,0.1 0.1,0 0))");
+	CU_ASSERT_PTR_NULL(s);
+}
+
+static void test_mvt_other(void)
+{
+	/* Outside the tile and its buffer */
+	cu_mvt("POINT(5000 5000)");
+	CU_ASSERT_PTR_NULL(s);
+
+	cu_mvt("LINESTRING(-300 -300,-500 -500)");
+	CU_ASSERT_PTR_NULL(s);
+
+	/* Inside the buffer is kept */
+	cu_mvt("POINT(-100 4196)");
+	CU_ASSERT_STRING_EQUAL(s, "09C701C701");
+
+	cu_mvt("POINT EMPTY");
+	CU_ASSERT_PTR_NULL(s);
+
+	/* Collections are used when they have a single type */
+	cu_mvt("GEOMETRYCOLLECTION(POINT(25 4079))");
+	CU_ASSERT_STRING_EQUAL(s, "093222");
+
+	cu_mvt("GEOMETRYCOLLECTION(POINT(25 4079),LINESTRING(2 4094,2 4086))");
+	CU_ASSERT_PTR_NULL(s);
+
+	cu_mvt("CIRCULARSTRING(0 4096,1 4095,2 4096)");
+	CU_ASSERT_EQUAL(mvt_type, MVT_LINESTRING);
+}
+
+/*
+** Used by test harness to register the tests in this file.
+*/
+CU_TestInfo out_mvt_tests[] =
+{
+	PG_TEST(test_mvt_point),
+	PG_TEST(test_mvt_linestring),
+	PG_TEST(test_mvt_polygon),
+	PG_TEST(test_mvt_other),
+	CU_TEST_INFO_NULL
+};
+CU_SuiteInfo out_mvt_suite = {"MVT Out Suite",  init_out_mvt_suite, clean_out_mvt_suite, out_mvt_tests};
@@ -215,7 +215,7 @@ static void out_svg_test_geoms(void)
 	/* Nested GeometryCollection */
 	do_svg_unsupported(
 	    "GEOMETRYCOLLECTION(POINT(0 1),GEOMETRYCOLLECTION(LINESTRING(2 3,4 5)))",
-	    "assvg_geom_buf: 'GeometryCollection' geometry type not supported.");
+	    "assvg_geom_sb: 'GeometryCollection' geometry type not supported.");
 
 	/* CircularString */
 	do_svg_unsupported(
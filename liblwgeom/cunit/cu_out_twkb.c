@@ -0,0 +1,225 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CUnit/Basic.h"
+
+#include "liblwgeom_internal.h"
+#include "varint.h"
+#include "cu_tester.h"
+
+/*
+** Global variable to hold hex TWKB strings
+*/
+static char *s;
+
+static int init_twkb_out_suite(void)
+{
+	s = NULL;
+	return 0;
+}
+
+static int clean_twkb_out_suite(void)
+{
+	if (s) free(s);
+	s = NULL;
+	return 0;
+}
+
+/*
+** Write a TWKB from a WKT string, as hex
+*/
+static void cu_twkb_idlist(char *wkt, int64_t *idlist, uint8_t variant, int8_t prec_xy, int8_t prec_z, int8_t prec_m)
+{
+	LWGEOM *g = lwgeom_from_wkt(wkt, LW_PARSER_CHECK_NONE);
+	size_t twkb_size;
+	uint8_t *twkb;
+
+	cu_error_msg_reset();
+	twkb = lwgeom_to_twkb_with_idlist(g, idlist, variant, prec_xy, prec_z, prec_m, &twkb_size);
+	if ( s ) free(s);
+	s = twkb ? hexbytes_from_bytes(twkb, twkb_size) : NULL;
+	if ( twkb ) lwfree(twkb);
+	lwgeom_free(g);
+}
+
+static void cu_twkb(char *wkt, uint8_t variant, int8_t prec_xy, int8_t prec_z, int8_t prec_m)
+{
+	cu_twkb_idlist(wkt, NULL, variant, prec_xy, prec_z, prec_m);
+}
+
+static void test_varint(void)
+{
+	uint8_t buf[VARINT_MAX_SIZE];
+	size_t size;
+
+	CU_ASSERT_EQUAL(varint_u64_encode_buf(1, buf), 1);
+	CU_ASSERT_EQUAL(buf[0], 0x01);
+
+	CU_ASSERT_EQUAL(varint_u64_encode_buf(300, buf), 2);
+	CU_ASSERT_EQUAL(buf[0], 0xAC);
+	CU_ASSERT_EQUAL(buf[1], 0x02);
+	CU_ASSERT_EQUAL(varint_u64_decode(buf, buf + 2, &size), 300);
+	CU_ASSERT_EQUAL(size, 2);
+
+	CU_ASSERT_EQUAL(zigzag64(0), 0);
+	CU_ASSERT_EQUAL(zigzag64(-1), 1);
+	CU_ASSERT_EQUAL(zigzag64(1), 2);
+	CU_ASSERT_EQUAL(zigzag64(-2), 3);
+	CU_ASSERT_EQUAL(unzigzag64(3), -2);
+
+	CU_ASSERT_EQUAL(varint_s64_encode_buf(INT64_MIN, buf), VARINT_MAX_SIZE);
+	CU_ASSERT_EQUAL(varint_s64_decode(buf, buf + VARINT_MAX_SIZE, &size), INT64_MIN);
+	CU_ASSERT_EQUAL(varint_s64_size(INT64_MAX), VARINT_MAX_SIZE);
+	CU_ASSERT_EQUAL(varint_s64_size(-64), 1);
+	CU_ASSERT_EQUAL(varint_s64_size(64), 2);
+
+	/* Running off the end */
+	cu_error_msg_reset();
+	varint_u64_decode(buf, buf + 1, &size);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "varint_u64_decode: varint extends past end of buffer");
+}
+
+static void test_twkb_out_point(void)
+{
+	cu_twkb("POINT(1 2)", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "01000204");
+
+	/* Half rounds away from zero */
+	cu_twkb("POINT(1.25 -2.5)", 0, 1, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "21001A31");
+
+	/* Negative precision drops digits before the decimal point */
+	cu_twkb("POINT(1234 5678)", 0, -1, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "1100F601F008");
+
+	cu_twkb("POINT(1 2 3)", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "0108010204" "06");
+
+	cu_twkb("POINTM(1 2 3)", 0, 0, 0, 2);
+	CU_ASSERT_STRING_EQUAL(s, "0108420204D804");
+
+	/* Single points never get a box */
+	cu_twkb("POINT(1 2)", TWKB_BBOX, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "01000204");
+
+	cu_twkb("POINT EMPTY", TWKB_BBOX | TWKB_SIZE, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "0110");
+}
+
+static void test_twkb_out_linestring(void)
+{
+	cu_twkb("LINESTRING(1 1,5 5)", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "02000202020808");
+
+	cu_twkb("LINESTRING(1 1,5 5)", TWKB_BBOX, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "0201" "02080208" "02" "0202" "0808");
+
+	cu_twkb("LINESTRING(1 1,5 5)", TWKB_SIZE, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "0202050202020808");
+
+	/* Vertices that round onto the one before are dropped */
+	cu_twkb("LINESTRING(0 0,0.1 0.1,1 1)", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "020002" "0000" "0202");
+
+	/* ... but not below the minimum for the type */
+	cu_twkb("LINESTRING(0 0,0.1 0.1)", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "020002" "0000" "0000");
+
+	cu_twkb("LINESTRING EMPTY", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "0210");
+}
+
+static void test_twkb_out_polygon(void)
+{
+	cu_twkb("POLYGON((0 0,0 1,1 1,0 0))", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "030001" "04" "0000" "0002" "0200" "0101");
+
+	cu_twkb("POLYGON((0 0 1,0 1 1,1 1 1,0 0 1))", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "03080101" "04" "000002" "000200" "020000" "010100");
+}
+
+static void test_twkb_out_multi(void)
+{
+	/* The delta runs on from one member to the next */
+	cu_twkb("MULTIPOINT(0 0,1 1)", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "040002" "0000" "0202");
+
+	cu_twkb("MULTILINESTRING((0 0,1 1),(1 1,2 2))", TWKB_BBOX, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "050100040004" "02" "02" "0000" "0202" "02" "0000" "0202");
+
+	{
+		int64_t ids[] = {10, 20};
+		cu_twkb_idlist("MULTIPOINT(0 0,1 1)", ids, 0, 0, 0, 0);
+		CU_ASSERT_STRING_EQUAL(s, "040402" "1428" "0000" "0202");
+	}
+
+	/* An empty member has no body to write */
+	{
+		LWMPOINT *mpt = lwmpoint_construct_empty(SRID_UNKNOWN, 0, 0);
+		size_t twkb_size;
+		mpt = lwmpoint_add_lwpoint(mpt, lwpoint_make2d(SRID_UNKNOWN, 1, 1));
+		mpt = lwmpoint_add_lwpoint(mpt, lwpoint_construct_empty(SRID_UNKNOWN, 0, 0));
+		cu_error_msg_reset();
+		lwfree(lwgeom_to_twkb((LWGEOM*)mpt, 0, 0, 0, 0, &twkb_size));
+		lwmpoint_free(mpt);
+	}
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "TWKB cannot represent an empty point inside a multipoint");
+}
+
+static void test_twkb_out_collection(void)
+{
+	/* Members are written whole, and start their deltas over */
+	cu_twkb("GEOMETRYCOLLECTION(POINT(1 1),POINT(1 1))", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "070002" "01000202" "01000202");
+
+	cu_twkb("GEOMETRYCOLLECTION(POINT(1 1),LINESTRING EMPTY)", TWKB_BBOX, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "070102000200" "02" "01000202" "0210");
+
+	cu_twkb("GEOMETRYCOLLECTION EMPTY", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(s, "0710");
+}
+
+static void test_twkb_out_errors(void)
+{
+	cu_twkb("CIRCULARSTRING(0 0,1 1,2 0)", 0, 0, 0, 0);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "Unsupported geometry type: CircularString [8]");
+
+	cu_twkb("POINT(1 2)", 0, 8, 0, 0);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "TWKB XY precision must be between -7 and 7");
+
+	cu_twkb("POINT(1 2 3)", 0, 0, -1, 0);
+	CU_ASSERT_STRING_EQUAL(cu_error_msg, "TWKB Z and M precision must be between 0 and 7");
+
+	{
+		int64_t ids[] = {1};
+		cu_twkb_idlist("POINT(1 2)", ids, 0, 0, 0, 0);
+		CU_ASSERT_STRING_EQUAL(cu_error_msg, "TWKB id lists are only allowed on multi-geometries and collections");
+	}
+}
+
+/*
+** Used by test harness to register the tests in this file.
+*/
+CU_TestInfo twkb_out_tests[] =
+{
+	PG_TEST(test_varint),
+	PG_TEST(test_twkb_out_point),
+	PG_TEST(test_twkb_out_linestring),
+	PG_TEST(test_twkb_out_polygon),
+	PG_TEST(test_twkb_out_multi),
+	PG_TEST(test_twkb_out_collection),
+	PG_TEST(test_twkb_out_errors),
+	CU_TEST_INFO_NULL
+};
+CU_SuiteInfo twkb_out_suite = {"TWKB Out Suite",  init_twkb_out_suite,  clean_twkb_out_suite, twkb_out_tests};
@@ -172,6 +172,80 @@ static void test_wkb_out_polyhedralsurface(void)
 //	printf("\nnew: %s\nold: %s\n",s,t);
 }
 
+/*
+** Check the direct GSERIALIZED writer against the LWGEOM one
+*/
+static void cu_wkb_gserialized(char *wkt, uint8_t variant)
+{
+	LWGEOM *g = lwgeom_from_wkt(wkt, LW_PARSER_CHECK_NONE);
+	GSERIALIZED *gser = gserialized_from_lwgeom(g, 0, NULL);
+	LWGEOM *g2 = lwgeom_from_gserialized(gser);
+	uint8_t *wkb1, *wkb2;
+	size_t size1, size2;
+
+	wkb1 = lwgeom_to_wkb(g2, variant, &size1);
+	wkb2 = gserialized_to_wkb(gser, variant, &size2);
+	CU_ASSERT_EQUAL(size1, size2);
+	if ( size1 == size2 )
+		CU_ASSERT(memcmp(wkb1, wkb2, size1) == 0);
+
+	lwfree(wkb1);
+	lwfree(wkb2);
+	lwgeom_free(g2);
+	lwfree(gser);
+	lwgeom_free(g);
+}
+
+static void test_wkb_out_gserialized(void)
+{
+	static char *wkts[] =
+	{
+		"POINT(0 0 0 0)",
+		"SRID=4;POINTM(1 1 1)",
+		"POINT EMPTY",
+		"LINESTRING(0 0 1,1 1 2,2 2 3)",
+		"LINESTRING EMPTY",
+		"SRID=4;POLYGON((0 0 0,0 1 0,1 1 0,1 0 0,0 0 0))",
+		"SRID=14;MULTIPOLYGON(((0 0 0,0 1 0,1 1 0,1 0 0,0 0 0)),((-1 -1 0,-1 2 0,2 2 0,2 -1 0,-1 -1 0),(0 0 0,0 1 0,1 1 0,1 0 0,0 0 0)))",
+		"SRID=4;MULTIPOINT(0 0 0,0 1 0,1 1 0,1 0 0,0 0 0)",
+		"GEOMETRYCOLLECTION(POINT EMPTY,LINESTRING EMPTY)",
+		"SRID=14;GEOMETRYCOLLECTION(POLYGON((0 0,0 1,1 1,1 0,0 0)),POINT EMPTY,POINT(1 1))",
+		"GEOMETRYCOLLECTION EMPTY",
+		"SRID=43;CIRCULARSTRING(-5 0 0 4, 0 5 1 3, 5 0 2 2, 10 -5 3 1, 15 0 4 0)",
+		"COMPOUNDCURVE(CIRCULARSTRING(0 0 0,0.26794919243112270647255365849413 1 3,0.5857864376269049511983112757903 1.4142135623730950488016887242097 1),(0.5857864376269049511983112757903 1.4142135623730950488016887242097 1,2 0 0,0 0 0))",
+		"CURVEPOLYGON(CIRCULARSTRING(-2 0 0 0,-1 -1 1 2,0 0 2 4,1 -1 3 6,2 0 4 8,0 2 2 4,-2 0 0 0),(-1 0 1 2,0 0.5 2 4,1 0 3 6,0 1 3 4,-1 0 1 2))",
+		"TRIANGLE((0 0,0 1,1 1,0 0))",
+		"TIN(((0 0 0,0 0 1,0 1 0,0 0 0)),((0 0 0,0 1 0,1 1 0,0 0 0)))",
+		"SRID=4;POLYHEDRALSURFACE(((0 0 0,0 0 1,0 1 0,0 0 0)),((0 0 0,0 1 0,1 1 0,0 0 0)))",
+		NULL
+	};
+	static uint8_t variants[] =
+	{
+		WKB_EXTENDED, WKB_EXTENDED | WKB_HEX, WKB_EXTENDED | WKB_XDR | WKB_HEX,
+		WKB_EXTENDED | WKB_NDR, WKB_EXTENDED | WKB_XDR, WKB_ISO | WKB_NDR,
+		WKB_ISO | WKB_XDR | WKB_HEX, WKB_SFSQL | WKB_NDR, WKB_SFSQL | WKB_XDR | WKB_HEX,
+		0
+	};
+	LWGEOM *g;
+	GSERIALIZED *gser;
+	int i, j;
+
+	for ( i = 0; wkts[i]; i++ )
+		for ( j = 0; variants[j]; j++ )
+			cu_wkb_gserialized(wkts[i], variants[j]);
+
+	/* The box on the serialized form is not part of the output */
+	g = lwgeom_from_wkt("SRID=4;LINESTRING(0 0,1 1)", LW_PARSER_CHECK_NONE);
+	lwgeom_add_bbox(g);
+	gser = gserialized_from_lwgeom(g, 0, NULL);
+	CU_ASSERT(FLAGS_GET_BBOX(gser->flags));
+	if ( s ) free(s);
+	s = gserialized_to_hexwkb(gser, WKB_XDR | WKB_EXTENDED, NULL);
+	CU_ASSERT_STRING_EQUAL(s, "00200000020000000400000002000000000000000000000000000000003FF00000000000003FF0000000000000");
+	lwfree(gser);
+	lwgeom_free(g);
+}
+
 /*
 ** Used by test harness to register the tests in this file.
 */
@@ -191,6 +265,7 @@ CU_TestInfo wkb_out_tests[] =
 	PG_TEST(test_wkb_out_multicurve),
 	PG_TEST(test_wkb_out_multisurface),
 	PG_TEST(test_wkb_out_polyhedralsurface),
+	PG_TEST(test_wkb_out_gserialized),
 	CU_TEST_INFO_NULL
 };
 CU_SuiteInfo wkb_out_suite = {"WKB Out Suite",  init_wkb_out_suite,  clean_wkb_out_suite, wkb_out_tests};
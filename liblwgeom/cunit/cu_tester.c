@@ -27,6 +27,9 @@ extern CU_SuiteInfo wkt_out_suite;
 extern CU_SuiteInfo wkt_in_suite;
 extern CU_SuiteInfo wkb_out_suite;
 extern CU_SuiteInfo wkb_in_suite;
+extern CU_SuiteInfo twkb_out_suite;
+extern CU_SuiteInfo twkb_in_suite;
+extern CU_SuiteInfo geojson_in_suite;
 extern CU_SuiteInfo libgeom_suite;
 extern CU_SuiteInfo split_suite;
 extern CU_SuiteInfo geodetic_suite;
@@ -39,6 +42,7 @@ extern CU_SuiteInfo out_kml_suite;
 extern CU_SuiteInfo out_geojson_suite;
 extern CU_SuiteInfo out_svg_suite;
 extern CU_SuiteInfo out_x3d_suite;
+extern CU_SuiteInfo out_mvt_suite;
 
 /*
 ** The main() function for setting up and running the tests.
@@ -60,6 +64,9 @@ int main(int argc, char *argv[])
 		wkt_in_suite,
 		wkb_out_suite,
 		wkb_in_suite,
+		twkb_out_suite,
+		twkb_in_suite,
+		geojson_in_suite,
 		libgeom_suite,
 		split_suite,
 		geodetic_suite,
@@ -72,6 +79,7 @@ int main(int argc, char *argv[])
 		out_geojson_suite,
 		out_svg_suite,
 		out_x3d_suite,
+		out_mvt_suite,
 		CU_SUITE_INFO_NULL
 	};
 
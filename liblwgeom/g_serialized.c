@@ -98,27 +98,140 @@ GSERIALIZED* gserialized_copy(const GSERIALIZED *g)
 	return g_out;
 }
 
-int gserialized_is_empty(const GSERIALIZED *g)
+/*
+* Pointer to the first serialized element, past the header and box.
+*/
+static const uint8_t* gserialized_get_data(const GSERIALIZED *g)
 {
-	uint8_t *p = (uint8_t*)g;
-	int i;
-	assert(g);
-
-	p += 8; /* Skip varhdr and srid/flags */
+	const uint8_t *p = (const uint8_t*)(g->data);
 	if( FLAGS_GET_BBOX(g->flags) )
 		p += gbox_serialized_size(g->flags); /* Skip the box */
-	p += 4; /* Skip type number */
-	
-	/* For point/line/circstring this is npoints */
+	return p;
+}
+
+size_t gserialized_buffer_summary(const uint8_t *data, uint8_t flags, int *is_empty, int *nvertices, int *nrings)
+{
+	uint32_t type = lw_get_uint32_t(data);
+	/* For point/line/circstring/triangle this is npoints */
 	/* For polygons this is nrings */
 	/* For collections this is ngeoms */
-	memcpy(&i, p, sizeof(int));
-	
-	/* If it is non-zero, it's not empty */
-	if ( i > 0 )
-		return LW_FALSE;
-	else
-		return LW_TRUE;	
+	uint32_t count = lw_get_uint32_t(data + 4);
+	size_t ptsize = FLAGS_NDIMS(flags) * sizeof(double);
+	size_t size = 8; /* Type and count */
+	int empty = LW_TRUE;
+	int vertices = 0;
+	int rings = 0;
+	int i;
+
+	switch ( type )
+	{
+	case POINTTYPE:
+	case LINETYPE:
+	case CIRCSTRINGTYPE:
+	case TRIANGLETYPE:
+		size += count * ptsize;
+		empty = (count == 0);
+		vertices = count;
+		if ( type == TRIANGLETYPE ) rings = 1;
+		break;
+	case POLYGONTYPE:
+		size += count * 4;
+		if ( count % 2 ) /* Padding */
+			size += 4;
+		for ( i = 0; i < count; i++ )
+		{
+			uint32_t npoints = lw_get_uint32_t(data + 8 + 4 * i);
+			size += npoints * ptsize;
+			vertices += npoints;
+		}
+		empty = (count == 0);
+		rings = count;
+		break;
+	case MULTIPOINTTYPE:
+	case MULTILINETYPE:
+	case MULTIPOLYGONTYPE:
+	case COMPOUNDTYPE:
+	case CURVEPOLYTYPE:
+	case MULTICURVETYPE:
+	case MULTISURFACETYPE:
+	case POLYHEDRALSURFACETYPE:
+	case TINTYPE:
+	case COLLECTIONTYPE:
+		for ( i = 0; i < count; i++ )
+		{
+			int subempty, subvertices, subrings;
+			size += gserialized_buffer_summary(data + size, flags, &subempty, &subvertices, &subrings);
+			if ( ! subempty ) empty = LW_FALSE;
+			vertices += subvertices;
+			rings += subrings;
+		}
+		/* Rings of a curve polygon are curves, which count none themselves */
+		if ( type == CURVEPOLYTYPE )
+			rings = count;
+		break;
+	default:
+		lwerror("Unsupported geometry type: %s [%d]", lwtype_name(type), type);
+	}
+
+	/* Empties count nothing, like lwgeom_count_vertices/rings */
+	if ( empty )
+	{
+		vertices = 0;
+		rings = 0;
+	}
+
+	if ( is_empty ) *is_empty = empty;
+	if ( nvertices ) *nvertices = vertices;
+	if ( nrings ) *nrings = rings;
+
+	return size;
+}
+
+int gserialized_is_empty(const GSERIALIZED *g)
+{
+	const uint8_t *p;
+	int empty;
+	assert(g);
+
+	p = gserialized_get_data(g);
+
+	/* Non-collections are empty when they have no points/rings */
+	if ( ! lwtype_is_collection(lw_get_uint32_t(p)) )
+		return lw_get_uint32_t(p + 4) == 0;
+
+	gserialized_buffer_summary(p, g->flags, &empty, NULL, NULL);
+	return empty;
+}
+
+int gserialized_count_vertices(const GSERIALIZED *g)
+{
+	int nvertices;
+	assert(g);
+	gserialized_buffer_summary(gserialized_get_data(g), g->flags, NULL, &nvertices, NULL);
+	return nvertices;
+}
+
+int gserialized_count_rings(const GSERIALIZED *g)
+{
+	int nrings;
+	assert(g);
+	gserialized_buffer_summary(gserialized_get_data(g), g->flags, NULL, NULL, &nrings);
+	return nrings;
+}
+
+int gserialized_get_ngeoms(const GSERIALIZED *g)
+{
+	const uint8_t *p;
+	assert(g);
+
+	if ( gserialized_is_empty(g) )
+		return 0;
+
+	p = gserialized_get_data(g);
+	if ( lwtype_is_collection(lw_get_uint32_t(p)) )
+		return lw_get_uint32_t(p + 4);
+
+	return 1;
 }
 
 char* gserialized_to_string(const GSERIALIZED *g)
@@ -162,12 +162,30 @@ int lwline_count_vertices(LWLINE *line);
 int lwpoly_count_vertices(LWPOLY *poly);
 int lwcollection_count_vertices(LWCOLLECTION *col);
 
+/*
+* Locale-independent number printing for the text writers
+*/
+int lwprint_double(double d, int maxdd, char *buf, size_t bufsize);
+int lwprint_double_sig(double d, int sigdigits, char *buf, size_t bufsize);
+
+/*
+* Fast locale-independent number reading for the text readers
+*/
+const char* lwread_double(const char *str, double *d);
+
 /*
 * Read from byte buffer
 */
 extern uint32_t lw_get_uint32_t(const uint8_t *loc);
 extern int32_t lw_get_int32_t(const uint8_t *loc);
 
+/*
+* Walk one serialized element, reporting its emptiness, vertex and ring
+* counts (as lwgeom_is_empty and lwgeom_count_vertices/rings would) and
+* returning the number of bytes it takes. Any output pointer can be NULL.
+*/
+size_t gserialized_buffer_summary(const uint8_t *data, uint8_t flags, int *is_empty, int *nvertices, int *nrings);
+
 /*
 * DP simplification
 */
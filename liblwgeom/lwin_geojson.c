@@ -0,0 +1,1017 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/**
+* @file
+* Single pass GeoJSON geometry reader.
+*
+* The text is read straight into the geometry: positions are converted
+* where they are found and written into point arrays that were sized by
+* a quick scan ahead, so no document tree is built. Members are matched
+* case insensitively and may come in any order; when "coordinates" or
+* "geometries" come before "type" their value is checked and skipped,
+* and read again once the type is known.
+*
+* Syntax errors are reported as "unexpected character (at offset N)" or
+* "unexpected end of data (at offset N)", as json-c did.
+*/
+
+#include <string.h>
+
+#include "liblwgeom_internal.h"
+#include "lwgeom_log.h"
+
+/* Deepest nesting of objects and arrays accepted, as in json-c */
+#define GEOJSON_MAX_DEPTH 32
+
+/* Longest member or type name that can match anything */
+#define GEOJSON_NAME_SIZE 32
+
+/**
+* Used for passing the parse state between the parsing functions.
+*/
+typedef struct
+{
+	const char *json;  /* Start of the input */
+	const char *pos;   /* Next character to read */
+	int depth;         /* Objects and arrays currently open */
+	int has2d;         /* Some part was built without a Z ordinate */
+	char *srs;         /* Name of the top level "crs", if any */
+	int error;         /* An error has been reported */
+}
+geojson_state;
+
+typedef struct
+{
+	const char *name;
+	uint8_t type;
+}
+geojson_type;
+
+static const geojson_type geojson_types[] =
+{
+	{"Point", POINTTYPE},
+	{"LineString", LINETYPE},
+	{"Polygon", POLYGONTYPE},
+	{"MultiPoint", MULTIPOINTTYPE},
+	{"MultiLineString", MULTILINETYPE},
+	{"MultiPolygon", MULTIPOLYGONTYPE},
+	{"GeometryCollection", COLLECTIONTYPE},
+	{NULL, 0}
+};
+
+#define GEOJSON_ISDIGIT(c) ((c) >= '0' && (c) <= '9')
+
+static LWGEOM* geojson_object(geojson_state *s, int top);
+
+/*
+* Errors are only reported once, as lwerror() may return.
+*/
+static void geojson_error(geojson_state *s, const char *msg)
+{
+	if ( s->error ) return;
+	s->error = LW_TRUE;
+	lwerror("%s", msg);
+}
+
+static void geojson_syntax_error(geojson_state *s)
+{
+	if ( s->error ) return;
+	s->error = LW_TRUE;
+	lwerror("%s (at offset %d)",
+	        *(s->pos) ? "unexpected character" : "unexpected end of data",
+	        (int)(s->pos - s->json));
+}
+
+/*
+* Something other than what the geometry needs was found: well formed
+* JSON of the wrong kind is a bad representation, anything else is
+* a syntax error.
+*/
+static void geojson_unexpected(geojson_state *s)
+{
+	if ( *(s->pos) && strchr("{[\"-0123456789tfn", *(s->pos)) )
+		geojson_error(s, "invalid GeoJSON representation");
+	else
+		geojson_syntax_error(s);
+}
+
+static inline void geojson_skip_ws(geojson_state *s)
+{
+	const char *p = s->pos;
+	while ( *p == ' ' || *p == '\n' || *p == '\r' || *p == '\t' )
+		p++;
+	s->pos = p;
+}
+
+/* Skip white space and the expected character */
+static inline int geojson_expect(geojson_state *s, char c)
+{
+	geojson_skip_ws(s);
+	if ( *(s->pos) != c )
+	{
+		geojson_syntax_error(s);
+		return LW_FAILURE;
+	}
+	s->pos++;
+	return LW_SUCCESS;
+}
+
+static int geojson_open(geojson_state *s)
+{
+	if ( ++(s->depth) > GEOJSON_MAX_DEPTH )
+	{
+		if ( ! s->error )
+		{
+			s->error = LW_TRUE;
+			lwerror("nesting too deep (at offset %d)", (int)(s->pos - s->json));
+		}
+		return LW_FAILURE;
+	}
+	return LW_SUCCESS;
+}
+
+static int geojson_hexdigit(char c)
+{
+	if ( GEOJSON_ISDIGIT(c) ) return c - '0';
+	if ( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+	if ( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+	return -1;
+}
+
+/*
+* Read the four hex digits of a \u escape at p.
+*/
+static int geojson_hex4(const char *p)
+{
+	int i, d, v = 0;
+	for ( i = 0; i < 4; i++ )
+	{
+		if ( (d = geojson_hexdigit(p[i])) < 0 )
+			return -1;
+		v = (v << 4) | d;
+	}
+	return v;
+}
+
+/*
+* Read a string at the current position. With buf NULL the decoded
+* string is returned in a new allocation, otherwise it is decoded into
+* buf, which is left empty if it is too small. Decoding never makes a
+* string longer than its quoted form, so the quoted length is a safe
+* size. Returns NULL on error.
+*/
+static char* geojson_string(geojson_state *s, char *buf, size_t size)
+{
+	const char *start, *p;
+	char *out, *o;
+
+	if ( *(s->pos) != '"' )
+	{
+		geojson_syntax_error(s);
+		return NULL;
+	}
+
+	/* Find the end of the string and check the escapes */
+	start = p = s->pos + 1;
+	while ( *p != '"' )
+	{
+		if ( *p == '\0' )
+		{
+			s->pos = p;
+			geojson_syntax_error(s);
+			return NULL;
+		}
+		if ( *p++ == '\\' )
+		{
+			if ( *p == 'u' )
+			{
+				if ( geojson_hex4(p + 1) < 0 )
+				{
+					s->pos = p;
+					geojson_syntax_error(s);
+					return NULL;
+				}
+				p += 5;
+			}
+			else if ( *p && strchr("\"\\/bfnrt", *p) )
+			{
+				p++;
+			}
+			else
+			{
+				s->pos = p;
+				geojson_syntax_error(s);
+				return NULL;
+			}
+		}
+	}
+	s->pos = p + 1;
+
+	if ( ! buf )
+	{
+		buf = lwalloc(p - start + 1);
+	}
+	else if ( (size_t)(p - start) >= size )
+	{
+		buf[0] = '\0';
+		return buf;
+	}
+
+	/* Decode, encoding \u escapes as UTF-8 */
+	for ( o = out = buf, p = start; *p != '"'; )
+	{
+		uint32_t c;
+
+		if ( *p != '\\' )
+		{
+			*o++ = *p++;
+			continue;
+		}
+		p++;
+		switch ( *p++ )
+		{
+		case 'b': *o++ = '\b'; continue;
+		case 'f': *o++ = '\f'; continue;
+		case 'n': *o++ = '\n'; continue;
+		case 'r': *o++ = '\r'; continue;
+		case 't': *o++ = '\t'; continue;
+		case 'u': break;
+		default: *o++ = p[-1]; continue;
+		}
+
+		c = geojson_hex4(p);
+		p += 4;
+		/* Join surrogate pairs */
+		if ( c >= 0xD800 && c < 0xDC00 && p[0] == '\\' && p[1] == 'u' )
+		{
+			int lo = geojson_hex4(p + 2);
+			if ( lo >= 0xDC00 && lo < 0xE000 )
+			{
+				c = 0x10000 + ((c - 0xD800) << 10) + (lo - 0xDC00);
+				p += 6;
+			}
+		}
+
+		if ( c < 0x80 )
+		{
+			*o++ = c;
+		}
+		else if ( c < 0x800 )
+		{
+			*o++ = 0xC0 | (c >> 6);
+			*o++ = 0x80 | (c & 0x3F);
+		}
+		else if ( c < 0x10000 )
+		{
+			*o++ = 0xE0 | (c >> 12);
+			*o++ = 0x80 | ((c >> 6) & 0x3F);
+			*o++ = 0x80 | (c & 0x3F);
+		}
+		else
+		{
+			*o++ = 0xF0 | (c >> 18);
+			*o++ = 0x80 | ((c >> 12) & 0x3F);
+			*o++ = 0x80 | ((c >> 6) & 0x3F);
+			*o++ = 0x80 | (c & 0x3F);
+		}
+	}
+	*o = '\0';
+	return out;
+}
+
+/*
+* Read a number, -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][-+]?[0-9]+)?
+*/
+static int geojson_number(geojson_state *s, double *d)
+{
+	const char *p = s->pos;
+
+	if ( *p == '-' ) p++;
+	if ( *p == '0' )
+		p++;
+	else if ( GEOJSON_ISDIGIT(*p) )
+		while ( GEOJSON_ISDIGIT(*p) ) p++;
+	else
+		goto fail;
+
+	if ( *p == '.' )
+	{
+		if ( ! GEOJSON_ISDIGIT(p[1]) )
+		{
+			p++;
+			goto fail;
+		}
+		p++;
+		while ( GEOJSON_ISDIGIT(*p) ) p++;
+	}
+
+	if ( *p == 'e' || *p == 'E' )
+	{
+		p++;
+		if ( *p == '-' || *p == '+' ) p++;
+		if ( ! GEOJSON_ISDIGIT(*p) )
+			goto fail;
+		while ( GEOJSON_ISDIGIT(*p) ) p++;
+	}
+
+	/* The WKT number syntax takes in the JSON one */
+	lwread_double(s->pos, d);
+	s->pos = p;
+	return LW_SUCCESS;
+
+fail:
+	s->pos = p;
+	geojson_syntax_error(s);
+	return LW_FAILURE;
+}
+
+/*
+* Check and skip over any value.
+*/
+static int geojson_skip_value(geojson_state *s)
+{
+	static const char *literals[] = { "true", "false", "null", NULL };
+	const char **lit;
+	char skip[1];
+	double d;
+	char close;
+
+	geojson_skip_ws(s);
+	switch ( *(s->pos) )
+	{
+	case '"':
+		return geojson_string(s, skip, sizeof(skip)) ? LW_SUCCESS : LW_FAILURE;
+	case '{':
+	case '[':
+		close = (*(s->pos) == '{') ? '}' : ']';
+		if ( ! geojson_open(s) )
+			return LW_FAILURE;
+		s->pos++;
+		geojson_skip_ws(s);
+		if ( *(s->pos) == close )
+		{
+			s->pos++;
+			s->depth--;
+			return LW_SUCCESS;
+		}
+		do
+		{
+			if ( close == '}' )
+			{
+				geojson_skip_ws(s);
+				if ( ! geojson_string(s, skip, sizeof(skip)) || ! geojson_expect(s, ':') )
+					return LW_FAILURE;
+			}
+			if ( ! geojson_skip_value(s) )
+				return LW_FAILURE;
+			geojson_skip_ws(s);
+		}
+		while ( *(s->pos) == ',' && s->pos++ );
+		if ( ! geojson_expect(s, close) )
+			return LW_FAILURE;
+		s->depth--;
+		return LW_SUCCESS;
+	case '-':
+	case '0': case '1': case '2': case '3': case '4':
+	case '5': case '6': case '7': case '8': case '9':
+		return geojson_number(s, &d);
+	default:
+		for ( lit = literals; *lit; lit++ )
+		{
+			size_t len = strlen(*lit);
+			if ( strncmp(s->pos, *lit, len) == 0 )
+			{
+				s->pos += len;
+				return LW_SUCCESS;
+			}
+		}
+		geojson_syntax_error(s);
+		return LW_FAILURE;
+	}
+}
+
+/*
+* Scan ahead over the array of positions at p, counting them and
+* noting whether any has a Z ordinate. Only used for sizing, so it
+* doesn't need to be exact on malformed input.
+*/
+static int geojson_count_positions(const char *p, int *hasz)
+{
+	int depth = 0, count = 0, commas = 0;
+
+	*hasz = LW_FALSE;
+	for ( ; *p; p++ )
+	{
+		switch ( *p )
+		{
+		case '[':
+			if ( ++depth == 2 )
+			{
+				count++;
+				commas = 0;
+			}
+			break;
+		case ']':
+			if ( depth == 2 && commas >= 2 )
+				*hasz = LW_TRUE;
+			if ( --depth == 0 )
+				return count;
+			break;
+		case ',':
+			if ( depth == 2 )
+				commas++;
+			break;
+		}
+	}
+	return count;
+}
+
+/*
+* Read a position into pt. Ordinates after the third are ignored.
+*/
+static int geojson_position(geojson_state *s, POINT4D *pt, int *hasz)
+{
+	double ord[3] = {0.0, 0.0, 0.0};
+	int n = 0;
+
+	geojson_skip_ws(s);
+	if ( *(s->pos) != '[' )
+	{
+		geojson_unexpected(s);
+		return LW_FAILURE;
+	}
+	s->pos++;
+
+	geojson_skip_ws(s);
+	if ( *(s->pos) != ']' )
+	{
+		do
+		{
+			double d;
+			geojson_skip_ws(s);
+			if ( *(s->pos) != '-' && ! GEOJSON_ISDIGIT(*(s->pos)) )
+			{
+				geojson_unexpected(s);
+				return LW_FAILURE;
+			}
+			if ( ! geojson_number(s, &d) )
+				return LW_FAILURE;
+			if ( n < 3 ) ord[n] = d;
+			n++;
+			geojson_skip_ws(s);
+		}
+		while ( *(s->pos) == ',' && s->pos++ );
+	}
+	if ( ! geojson_expect(s, ']') )
+		return LW_FAILURE;
+
+	if ( n < 2 )
+	{
+		geojson_error(s, "Too few ordinates in GeoJSON");
+		return LW_FAILURE;
+	}
+
+	pt->x = ord[0];
+	pt->y = ord[1];
+	pt->z = ord[2];
+	pt->m = 0.0;
+	*hasz = (n > 2);
+	return LW_SUCCESS;
+}
+
+/*
+* Read an array of positions. Repeated positions are dropped, as
+* ptarray_append_point() does, and the point array has a Z dimension
+* when any of its positions has one.
+*/
+static POINTARRAY* geojson_ptarray(geojson_state *s)
+{
+	POINTARRAY *pa;
+	POINT4D pt;
+	POINT4D prev = {0.0, 0.0, 0.0, 0.0};
+	int hasz, pthasz, count;
+
+	geojson_skip_ws(s);
+	if ( *(s->pos) != '[' )
+	{
+		geojson_unexpected(s);
+		return NULL;
+	}
+
+	count = geojson_count_positions(s->pos, &hasz);
+	pa = ptarray_construct_empty(hasz, 0, count > 0 ? count : 1);
+	if ( ! hasz ) s->has2d = LW_TRUE;
+
+	s->pos++;
+	geojson_skip_ws(s);
+	if ( *(s->pos) == ']' )
+	{
+		s->pos++;
+		return pa;
+	}
+
+	do
+	{
+		if ( ! geojson_position(s, &pt, &pthasz) )
+		{
+			ptarray_free(pa);
+			return NULL;
+		}
+
+		if ( pa->npoints == 0 || pt.x != prev.x || pt.y != prev.y || (hasz && pt.z != prev.z) )
+		{
+			/* Write straight into the storage sized by the scan */
+			if ( pa->npoints < pa->maxpoints )
+			{
+				double *dp = (double*)getPoint_internal(pa, pa->npoints);
+				dp[0] = pt.x;
+				dp[1] = pt.y;
+				if ( hasz ) dp[2] = pt.z;
+				pa->npoints++;
+			}
+			else
+			{
+				ptarray_append_point(pa, &pt, LW_TRUE);
+			}
+		}
+		prev = pt;
+		geojson_skip_ws(s);
+	}
+	while ( *(s->pos) == ',' && s->pos++ );
+
+	if ( ! geojson_expect(s, ']') )
+	{
+		ptarray_free(pa);
+		return NULL;
+	}
+	return pa;
+}
+
+/*
+* Read the "coordinates" of a single point, line or polygon.
+*/
+static LWGEOM* geojson_coordinates(geojson_state *s, uint8_t type)
+{
+	geojson_skip_ws(s);
+
+	if ( type == POINTTYPE )
+	{
+		POINTARRAY *pa;
+		POINT4D pt;
+		int hasz;
+
+		/* An empty array gives an empty point */
+		if ( *(s->pos) == '[' )
+		{
+			const char *p = s->pos + 1;
+			while ( *p == ' ' || *p == '\n' || *p == '\r' || *p == '\t' ) p++;
+			if ( *p == ']' )
+			{
+				s->pos = p + 1;
+				s->has2d = LW_TRUE;
+				return (LWGEOM*)lwpoint_construct_empty(SRID_UNKNOWN, 0, 0);
+			}
+		}
+
+		if ( ! geojson_position(s, &pt, &hasz) )
+			return NULL;
+		if ( ! hasz ) s->has2d = LW_TRUE;
+		pa = ptarray_construct_empty(hasz, 0, 1);
+		ptarray_append_point(pa, &pt, LW_TRUE);
+		return (LWGEOM*)lwpoint_construct(SRID_UNKNOWN, NULL, pa);
+	}
+	else if ( type == LINETYPE )
+	{
+		POINTARRAY *pa = geojson_ptarray(s);
+		if ( ! pa )
+			return NULL;
+		return (LWGEOM*)lwline_construct(SRID_UNKNOWN, NULL, pa);
+	}
+	else
+	{
+		LWPOLY *poly;
+
+		if ( *(s->pos) != '[' )
+		{
+			geojson_unexpected(s);
+			return NULL;
+		}
+		s->pos++;
+
+		poly = lwpoly_construct_empty(SRID_UNKNOWN, 0, 0);
+		geojson_skip_ws(s);
+		if ( *(s->pos) == ']' )
+		{
+			s->pos++;
+			s->has2d = LW_TRUE;
+			return (LWGEOM*)poly;
+		}
+
+		do
+		{
+			POINTARRAY *pa = geojson_ptarray(s);
+			if ( ! pa )
+			{
+				lwpoly_free(poly);
+				return NULL;
+			}
+			if ( FLAGS_GET_Z(pa->flags) )
+				FLAGS_SET_Z(poly->flags, 1);
+			lwpoly_add_ring(poly, pa);
+			geojson_skip_ws(s);
+		}
+		while ( *(s->pos) == ',' && s->pos++ );
+
+		if ( ! geojson_expect(s, ']') )
+		{
+			lwpoly_free(poly);
+			return NULL;
+		}
+		return (LWGEOM*)poly;
+	}
+}
+
+/*
+* Append a new member to a collection. The members are all fresh, so
+* the duplicate check of lwcollection_add_lwgeom() isn't needed.
+*/
+static void geojson_collection_add(LWCOLLECTION *col, LWGEOM *geom)
+{
+	lwcollection_reserve(col, col->ngeoms + 1);
+	col->geoms[col->ngeoms++] = geom;
+	if ( FLAGS_GET_Z(geom->flags) )
+		FLAGS_SET_Z(col->flags, 1);
+}
+
+/*
+* Read the "coordinates" of a multi-geometry, or the "geometries"
+* of a collection.
+*/
+static LWGEOM* geojson_members(geojson_state *s, uint8_t type)
+{
+	LWCOLLECTION *col;
+
+	geojson_skip_ws(s);
+	if ( *(s->pos) != '[' )
+	{
+		geojson_unexpected(s);
+		return NULL;
+	}
+	if ( ! geojson_open(s) )
+		return NULL;
+	s->pos++;
+
+	col = lwcollection_construct_empty(type, SRID_UNKNOWN, 0, 0);
+	geojson_skip_ws(s);
+	if ( *(s->pos) == ']' )
+	{
+		s->pos++;
+		s->depth--;
+		s->has2d = LW_TRUE;
+		return (LWGEOM*)col;
+	}
+
+	do
+	{
+		LWGEOM *geom;
+		switch ( type )
+		{
+		case MULTIPOINTTYPE:
+			geom = geojson_coordinates(s, POINTTYPE);
+			break;
+		case MULTILINETYPE:
+			geom = geojson_coordinates(s, LINETYPE);
+			break;
+		case MULTIPOLYGONTYPE:
+			geom = geojson_coordinates(s, POLYGONTYPE);
+			break;
+		default:
+			geom = geojson_object(s, LW_FALSE);
+		}
+		if ( ! geom )
+		{
+			lwcollection_free(col);
+			return NULL;
+		}
+		geojson_collection_add(col, geom);
+		geojson_skip_ws(s);
+	}
+	while ( *(s->pos) == ',' && s->pos++ );
+
+	if ( ! geojson_expect(s, ']') )
+	{
+		lwcollection_free(col);
+		return NULL;
+	}
+	s->depth--;
+	return (LWGEOM*)col;
+}
+
+static LWGEOM* geojson_value(geojson_state *s, uint8_t type)
+{
+	if ( lwtype_is_collection(type) )
+		return geojson_members(s, type);
+	return geojson_coordinates(s, type);
+}
+
+/*
+* Read a "crs" member, keeping the name from its properties when
+* it has a type.
+*/
+static int geojson_crs(geojson_state *s)
+{
+	char name[GEOJSON_NAME_SIZE];
+	char *srs = NULL;
+	int hastype = LW_FALSE;
+
+	geojson_skip_ws(s);
+	if ( *(s->pos) != '{' )
+		return geojson_skip_value(s);
+	if ( ! geojson_open(s) )
+		return LW_FAILURE;
+	s->pos++;
+
+	geojson_skip_ws(s);
+	if ( *(s->pos) != '}' )
+	{
+		do
+		{
+			geojson_skip_ws(s);
+			if ( ! geojson_string(s, name, sizeof(name)) || ! geojson_expect(s, ':') )
+				goto fail;
+			geojson_skip_ws(s);
+
+			if ( strcasecmp(name, "type") == 0 )
+			{
+				hastype = LW_TRUE;
+				if ( ! geojson_skip_value(s) )
+					goto fail;
+			}
+			else if ( strcasecmp(name, "properties") == 0 && *(s->pos) == '{' )
+			{
+				if ( ! geojson_open(s) )
+					goto fail;
+				s->pos++;
+				geojson_skip_ws(s);
+				if ( *(s->pos) != '}' )
+				{
+					do
+					{
+						geojson_skip_ws(s);
+						if ( ! geojson_string(s, name, sizeof(name)) || ! geojson_expect(s, ':') )
+							goto fail;
+						geojson_skip_ws(s);
+						if ( strcasecmp(name, "name") == 0 && *(s->pos) == '"' )
+						{
+							if ( srs ) lwfree(srs);
+							if ( ! (srs = geojson_string(s, NULL, 0)) )
+								goto fail;
+						}
+						else if ( ! geojson_skip_value(s) )
+						{
+							goto fail;
+						}
+						geojson_skip_ws(s);
+					}
+					while ( *(s->pos) == ',' && s->pos++ );
+				}
+				if ( ! geojson_expect(s, '}') )
+					goto fail;
+				s->depth--;
+			}
+			else if ( ! geojson_skip_value(s) )
+			{
+				goto fail;
+			}
+			geojson_skip_ws(s);
+		}
+		while ( *(s->pos) == ',' && s->pos++ );
+	}
+	if ( ! geojson_expect(s, '}') )
+		goto fail;
+	s->depth--;
+
+	if ( hastype && srs )
+	{
+		if ( s->srs ) lwfree(s->srs);
+		s->srs = srs;
+	}
+	else if ( srs )
+	{
+		lwfree(srs);
+	}
+	return LW_SUCCESS;
+
+fail:
+	if ( srs ) lwfree(srs);
+	return LW_FAILURE;
+}
+
+/*
+* Read a geometry object. When the geometry value comes before the
+* type it is skipped, and read again from its offset at the end.
+*/
+static LWGEOM* geojson_object(geojson_state *s, int top)
+{
+	char name[GEOJSON_NAME_SIZE];
+	const char *coordinates = NULL; /* Offsets of the last values seen */
+	const char *geometries = NULL;
+	const char *value, *end;
+	LWGEOM *geom = NULL;
+	const char *geomvalue = NULL;   /* Value geom was read from */
+	int geomtype = 0;               /* Type geom was read as */
+	int type = 0;                   /* -1 for a type we don't know */
+	const geojson_type *t;
+
+	geojson_skip_ws(s);
+	if ( *(s->pos) != '{' )
+	{
+		geojson_unexpected(s);
+		return NULL;
+	}
+	if ( ! geojson_open(s) )
+		return NULL;
+	s->pos++;
+
+	geojson_skip_ws(s);
+	if ( *(s->pos) != '}' )
+	{
+		do
+		{
+			geojson_skip_ws(s);
+			if ( ! geojson_string(s, name, sizeof(name)) || ! geojson_expect(s, ':') )
+				goto fail;
+			geojson_skip_ws(s);
+
+			if ( strcasecmp(name, "type") == 0 )
+			{
+				type = -1;
+				if ( *(s->pos) != '"' )
+				{
+					if ( ! geojson_skip_value(s) )
+						goto fail;
+				}
+				else
+				{
+					char tname[GEOJSON_NAME_SIZE];
+					if ( ! geojson_string(s, tname, sizeof(tname)) )
+						goto fail;
+					for ( t = geojson_types; t->name; t++ )
+					{
+						if ( strcasecmp(tname, t->name) == 0 )
+						{
+							type = t->type;
+							break;
+						}
+					}
+				}
+			}
+			else if ( strcasecmp(name, "coordinates") == 0 || strcasecmp(name, "geometries") == 0 )
+			{
+				int collection = (name[0] == 'g' || name[0] == 'G');
+
+				if ( collection )
+					geometries = s->pos;
+				else
+					coordinates = s->pos;
+
+				/* Read it now if the type says this is the one we need */
+				if ( type > 0 && (type == COLLECTIONTYPE) == collection )
+				{
+					if ( geom ) lwgeom_free(geom);
+					geomvalue = s->pos;
+					geomtype = type;
+					if ( ! (geom = geojson_value(s, type)) )
+						goto fail;
+				}
+				else if ( ! geojson_skip_value(s) )
+				{
+					goto fail;
+				}
+			}
+			else if ( top && strcasecmp(name, "crs") == 0 )
+			{
+				if ( ! geojson_crs(s) )
+					goto fail;
+			}
+			else if ( ! geojson_skip_value(s) )
+			{
+				goto fail;
+			}
+			geojson_skip_ws(s);
+		}
+		while ( *(s->pos) == ',' && s->pos++ );
+	}
+	if ( ! geojson_expect(s, '}') )
+		goto fail;
+	s->depth--;
+
+	if ( type == 0 )
+	{
+		geojson_error(s, "unknown GeoJSON type");
+		goto fail;
+	}
+	if ( type < 0 )
+	{
+		geojson_error(s, "invalid GeoJson representation");
+		goto fail;
+	}
+
+	value = (type == COLLECTIONTYPE) ? geometries : coordinates;
+	if ( ! value )
+	{
+		geojson_error(s, (type == COLLECTIONTYPE) ?
+		              "Unable to find 'geometries' in GeoJSON string" :
+		              "Unable to find 'coordinates' in GeoJSON string");
+		goto fail;
+	}
+
+	if ( geom && geomvalue == value && geomtype == type )
+		return geom;
+
+	/* Go back for the value, now that we know what it is */
+	if ( geom ) lwgeom_free(geom);
+	end = s->pos;
+	s->pos = value;
+	s->depth++;
+	geom = geojson_value(s, type);
+	s->depth--;
+	s->pos = end;
+	return geom;
+
+fail:
+	if ( geom ) lwgeom_free(geom);
+	return NULL;
+}
+
+/**
+* Read a GeoJSON geometry. Caller is responsible for freeing the result.
+*
+* @param srs returns the name from the "crs" member as a new string,
+* or NULL if there is none.
+*/
+LWGEOM* lwgeom_from_geojson(const char *geojson, char **srs)
+{
+	geojson_state s;
+	LWGEOM *geom;
+
+	*srs = NULL;
+	memset(&s, 0, sizeof(geojson_state));
+	s.json = s.pos = geojson;
+
+	geojson_skip_ws(&s);
+	if ( *(s.pos) == '{' )
+	{
+		geom = geojson_object(&s, LW_TRUE);
+	}
+	else
+	{
+		/* Well formed, but not an object */
+		if ( geojson_skip_value(&s) )
+		{
+			geojson_skip_ws(&s);
+			if ( *(s.pos) == '\0' )
+				geojson_error(&s, "unknown GeoJSON type");
+			else
+				geojson_syntax_error(&s);
+		}
+		geom = NULL;
+	}
+
+	if ( geom )
+	{
+		geojson_skip_ws(&s);
+		if ( *(s.pos) != '\0' )
+		{
+			geojson_syntax_error(&s);
+			lwgeom_free(geom);
+			geom = NULL;
+		}
+	}
+
+	if ( ! geom )
+	{
+		if ( s.srs ) lwfree(s.srs);
+		return NULL;
+	}
+
+	/* Parts without a Z get a zero one when others have it */
+	if ( FLAGS_GET_Z(geom->flags) && s.has2d )
+	{
+		LWGEOM *tmp = lwgeom_force_3dz(geom);
+		lwgeom_free(geom);
+		geom = tmp;
+	}
+
+	*srs = s.srs;
+	return geom;
+}
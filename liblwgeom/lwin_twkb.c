@@ -0,0 +1,387 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#include "lwout_twkb.h"
+
+#include <math.h>
+
+/**
+* Used for passing the parse state between the parsing functions.
+*/
+typedef struct
+{
+	const uint8_t *twkb; /* Points to start of TWKB */
+	const uint8_t *twkb_end; /* Points to end of TWKB */
+	const uint8_t *pos; /* Current parse position */
+	int check; /* Simple validity checks on geometries */
+	uint32_t lwtype; /* Current type we are handling */
+	uint8_t has_bbox;
+	uint8_t has_size;
+	uint8_t has_idlist;
+	uint8_t has_z;
+	uint8_t has_m;
+	uint8_t is_empty;
+	int ndims; /* Number of ordinates per vertex */
+	double factor[4]; /* 10^precision for each ordinate in use */
+	int64_t coords[4]; /* Last vertex read, as integers */
+} twkb_parse_state;
+
+
+/**
+* Internal function declarations.
+*/
+static LWGEOM* lwgeom_from_twkb_state(twkb_parse_state *s);
+
+
+/**********************************************************************/
+
+static inline void twkb_parse_state_advance(twkb_parse_state *s, size_t next)
+{
+	if( (s->pos + next) > s->twkb_end )
+	{
+		lwerror("TWKB structure does not match expected size!");
+		return;
+	}
+	s->pos += next;
+}
+
+static inline uint8_t byte_from_twkb_state(twkb_parse_state *s)
+{
+	uint8_t val;
+	if ( s->pos >= s->twkb_end )
+	{
+		lwerror("TWKB structure does not match expected size!");
+		return 0;
+	}
+	val = *(s->pos);
+	s->pos++;
+	return val;
+}
+
+static inline int64_t twkb_parse_state_varint(twkb_parse_state *s)
+{
+	size_t size;
+	int64_t val = varint_s64_decode(s->pos, s->twkb_end, &size);
+	twkb_parse_state_advance(s, size);
+	return val;
+}
+
+static inline uint64_t twkb_parse_state_uvarint(twkb_parse_state *s)
+{
+	size_t size;
+	uint64_t val = varint_u64_decode(s->pos, s->twkb_end, &size);
+	twkb_parse_state_advance(s, size);
+	return val;
+}
+
+static uint32_t lwtype_from_twkb_type(uint8_t twkb_type)
+{
+	switch ( twkb_type )
+	{
+	case TWKB_POINT_TYPE:
+		return POINTTYPE;
+	case TWKB_LINESTRING_TYPE:
+		return LINETYPE;
+	case TWKB_POLYGON_TYPE:
+		return POLYGONTYPE;
+	case TWKB_MULTIPOINT_TYPE:
+		return MULTIPOINTTYPE;
+	case TWKB_MULTILINESTRING_TYPE:
+		return MULTILINETYPE;
+	case TWKB_MULTIPOLYGON_TYPE:
+		return MULTIPOLYGONTYPE;
+	case TWKB_GEOMETRYCOLLECTION_TYPE:
+		return COLLECTIONTYPE;
+	default:
+		lwerror("Unknown TWKB type (%d)!", twkb_type);
+	}
+	return 0;
+}
+
+/**
+* Read the header of a geometry: type, precision, metadata, and skip
+* over the size and bounding box. The delta state starts over.
+*/
+static int header_from_twkb_state(twkb_parse_state *s)
+{
+	uint8_t type_precision = byte_from_twkb_state(s);
+	uint8_t metadata = byte_from_twkb_state(s);
+	int precision_xy = (int)unzigzag64((type_precision & 0xF0) >> 4);
+	int precision_z = 0;
+	int precision_m = 0;
+	int i;
+
+	s->lwtype = lwtype_from_twkb_type(type_precision & 0x0F);
+	if ( ! s->lwtype )
+		return LW_FAILURE;
+	s->has_bbox = (metadata & TWKB_HAS_BBOX) ? 1 : 0;
+	s->has_size = (metadata & TWKB_HAS_SIZE) ? 1 : 0;
+	s->has_idlist = (metadata & TWKB_HAS_IDLIST) ? 1 : 0;
+	s->is_empty = (metadata & TWKB_IS_EMPTY) ? 1 : 0;
+	s->has_z = s->has_m = 0;
+
+	if ( metadata & TWKB_HAS_EXTENDED_DIMS )
+	{
+		uint8_t extended = byte_from_twkb_state(s);
+		s->has_z = (extended & 0x01) ? 1 : 0;
+		s->has_m = (extended & 0x02) ? 1 : 0;
+		precision_z = (extended & 0x1C) >> 2;
+		precision_m = (extended & 0xE0) >> 5;
+	}
+
+	s->ndims = 2 + s->has_z + s->has_m;
+	s->factor[0] = s->factor[1] = pow(10, precision_xy);
+	i = 2;
+	if ( s->has_z )
+		s->factor[i++] = pow(10, precision_z);
+	if ( s->has_m )
+		s->factor[i++] = pow(10, precision_m);
+	memset(s->coords, 0, sizeof(s->coords));
+
+	/* Size is only useful to readers that want to skip us */
+	if ( s->has_size )
+	{
+		uint64_t size = twkb_parse_state_uvarint(s);
+		if ( size > (uint64_t)(s->twkb_end - s->pos) )
+			lwerror("TWKB structure does not match expected size!");
+	}
+
+	if ( s->has_bbox )
+		for ( i = 0; i < 2 * s->ndims; i++ )
+			twkb_parse_state_varint(s);
+
+	return LW_SUCCESS;
+}
+
+/**
+* Read npoints vertices, undoing the delta encoding and the precision
+* scaling.
+*/
+static POINTARRAY* ptarray_from_twkb_state(twkb_parse_state *s, uint64_t npoints)
+{
+	POINTARRAY *pa;
+	double *dlist;
+	int ndims = s->ndims;
+	uint64_t i;
+	int j;
+
+	/* Every ordinate takes at least one byte */
+	if ( npoints * ndims > (uint64_t)(s->twkb_end - s->pos) )
+	{
+		lwerror("TWKB structure does not match expected size!");
+		return NULL;
+	}
+
+	pa = ptarray_construct(s->has_z, s->has_m, npoints);
+	dlist = (double*)(pa->serialized_pointlist);
+	for ( i = 0; i < npoints; i++ )
+	{
+		for ( j = 0; j < ndims; j++ )
+		{
+			s->coords[j] += twkb_parse_state_varint(s);
+			*dlist++ = s->coords[j] / s->factor[j];
+		}
+	}
+	return pa;
+}
+
+static LWPOINT* lwpoint_from_twkb_state(twkb_parse_state *s)
+{
+	POINTARRAY *pa = ptarray_from_twkb_state(s, 1);
+	if ( pa == NULL )
+		return NULL;
+	return lwpoint_construct(SRID_UNKNOWN, NULL, pa);
+}
+
+static LWLINE* lwline_from_twkb_state(twkb_parse_state *s)
+{
+	uint64_t npoints = twkb_parse_state_uvarint(s);
+	POINTARRAY *pa;
+
+	if ( npoints == 0 )
+		return lwline_construct_empty(SRID_UNKNOWN, s->has_z, s->has_m);
+
+	pa = ptarray_from_twkb_state(s, npoints);
+	if ( pa == NULL )
+		return NULL;
+
+	if( s->check & LW_PARSER_CHECK_MINPOINTS && pa->npoints < 2 )
+	{
+		lwerror("%s must have at least two points", lwtype_name(s->lwtype));
+		return NULL;
+	}
+
+	return lwline_construct(SRID_UNKNOWN, NULL, pa);
+}
+
+static LWPOLY* lwpoly_from_twkb_state(twkb_parse_state *s)
+{
+	uint64_t nrings = twkb_parse_state_uvarint(s);
+	LWPOLY *poly = lwpoly_construct_empty(SRID_UNKNOWN, s->has_z, s->has_m);
+	uint64_t i;
+
+	for( i = 0; i < nrings; i++ )
+	{
+		uint64_t npoints = twkb_parse_state_uvarint(s);
+		POINTARRAY *pa = ptarray_from_twkb_state(s, npoints);
+		if ( pa == NULL )
+			return NULL;
+
+		/* Check for at least four points. */
+		if( s->check & LW_PARSER_CHECK_MINPOINTS && pa->npoints < 4 )
+		{
+			lwerror("%s must have at least four points in each ring", lwtype_name(s->lwtype));
+			return NULL;
+		}
+
+		/* Check that first and last points are the same. */
+		if( s->check & LW_PARSER_CHECK_CLOSURE && ! ptarray_isclosed2d(pa) )
+		{
+			lwerror("%s must have closed rings", lwtype_name(s->lwtype));
+			return NULL;
+		}
+
+		if ( lwpoly_add_ring(poly, pa) == LW_FAILURE )
+			lwerror("Unable to add ring to polygon");
+	}
+	return poly;
+}
+
+/*
+* Multi-geometries carry their members' bodies without headers, and the
+* running delta goes on from one member to the next.
+*/
+static LWCOLLECTION* lwmulti_from_twkb_state(twkb_parse_state *s)
+{
+	uint64_t ngeoms = twkb_parse_state_uvarint(s);
+	uint32_t multitype = s->lwtype;
+	LWCOLLECTION *col = lwcollection_construct_empty(multitype, SRID_UNKNOWN, s->has_z, s->has_m);
+	uint64_t i;
+
+	/* The ids are not kept on the geometry */
+	if ( s->has_idlist )
+		for ( i = 0; i < ngeoms; i++ )
+			twkb_parse_state_varint(s);
+
+	for ( i = 0; i < ngeoms; i++ )
+	{
+		LWGEOM *geom = NULL;
+
+		switch ( multitype )
+		{
+		case MULTIPOINTTYPE:
+			s->lwtype = POINTTYPE;
+			geom = lwpoint_as_lwgeom(lwpoint_from_twkb_state(s));
+			break;
+		case MULTILINETYPE:
+			s->lwtype = LINETYPE;
+			geom = lwline_as_lwgeom(lwline_from_twkb_state(s));
+			break;
+		case MULTIPOLYGONTYPE:
+			s->lwtype = POLYGONTYPE;
+			geom = lwpoly_as_lwgeom(lwpoly_from_twkb_state(s));
+			break;
+		}
+
+		if ( lwcollection_add_lwgeom(col, geom) == NULL )
+		{
+			lwerror("Unable to add geometry (%p) to collection (%p)", geom, col);
+			return NULL;
+		}
+	}
+	s->lwtype = multitype;
+	return col;
+}
+
+static LWCOLLECTION* lwcollection_from_twkb_state(twkb_parse_state *s)
+{
+	uint64_t ngeoms = twkb_parse_state_uvarint(s);
+	LWCOLLECTION *col = lwcollection_construct_empty(COLLECTIONTYPE, SRID_UNKNOWN, s->has_z, s->has_m);
+	uint64_t i;
+
+	if ( s->has_idlist )
+		for ( i = 0; i < ngeoms; i++ )
+			twkb_parse_state_varint(s);
+
+	for ( i = 0; i < ngeoms; i++ )
+	{
+		LWGEOM *geom = lwgeom_from_twkb_state(s);
+		if ( lwcollection_add_lwgeom(col, geom) == NULL )
+		{
+			lwerror("Unable to add geometry (%p) to collection (%p)", geom, col);
+			return NULL;
+		}
+	}
+	return col;
+}
+
+/**
+* GEOMETRY
+* Generic handling for TWKB geometries. Reads the header and hands off
+* to the type specific readers.
+*/
+static LWGEOM* lwgeom_from_twkb_state(twkb_parse_state *s)
+{
+	if ( header_from_twkb_state(s) == LW_FAILURE )
+		return NULL;
+
+	if ( s->is_empty )
+		return lwgeom_construct_empty(s->lwtype, SRID_UNKNOWN, s->has_z, s->has_m);
+
+	switch ( s->lwtype )
+	{
+	case POINTTYPE:
+		return lwpoint_as_lwgeom(lwpoint_from_twkb_state(s));
+	case LINETYPE:
+		return lwline_as_lwgeom(lwline_from_twkb_state(s));
+	case POLYGONTYPE:
+		return lwpoly_as_lwgeom(lwpoly_from_twkb_state(s));
+	case MULTIPOINTTYPE:
+	case MULTILINETYPE:
+	case MULTIPOLYGONTYPE:
+		return lwcollection_as_lwgeom(lwmulti_from_twkb_state(s));
+	case COLLECTIONTYPE:
+		return lwcollection_as_lwgeom(lwcollection_from_twkb_state(s));
+	default:
+		lwerror("Unsupported geometry type: %s [%d]", lwtype_name(s->lwtype), s->lwtype);
+	}
+	return NULL;
+}
+
+/**
+* TWKB inputs *must* have a declared size, to prevent malformed TWKB from
+* reading off the end of the memory segment.
+*
+* Check is a bitmask of: LW_PARSER_CHECK_MINPOINTS, LW_PARSER_CHECK_ODD,
+* LW_PARSER_CHECK_CLOSURE, LW_PARSER_CHECK_NONE, LW_PARSER_CHECK_ALL
+*/
+LWGEOM* lwgeom_from_twkb(const uint8_t *twkb, size_t twkb_size, char check)
+{
+	twkb_parse_state s;
+
+	if ( ! twkb )
+	{
+		lwerror("lwgeom_from_twkb: null input");
+		return NULL;
+	}
+
+	memset(&s, 0, sizeof(twkb_parse_state));
+	s.twkb = s.pos = twkb;
+	s.twkb_end = twkb + twkb_size;
+
+	/* Hand the check catch-all values */
+	if ( check & LW_PARSER_CHECK_NONE )
+		s.check = 0;
+	else
+		s.check = check;
+
+	return lwgeom_from_twkb_state(&s);
+}
@@ -274,10 +274,19 @@ POINTARRAY* wkt_parser_ptarray_add_coord(POINTARRAY *pa, POINT p)
 * Start a point array from the first coordinate.
 */
 POINTARRAY* wkt_parser_ptarray_new(POINT p)
+{
+	return wkt_parser_ptarray_new_with_size(p, 4);
+}
+
+/**
+* Start a point array from the first coordinate, with room for
+* maxpoints coordinates when the caller knows how many are coming.
+*/
+POINTARRAY* wkt_parser_ptarray_new_with_size(POINT p, int maxpoints)
 {
 	int ndims = FLAGS_NDIMS(p.flags);
 	LWDEBUG(4,"entered");
-	POINTARRAY *pa = ptarray_construct_empty((ndims>2), (ndims>3), 4);
+	POINTARRAY *pa = ptarray_construct_empty((ndims>2), (ndims>3), maxpoints);
 	if ( ! pa )
 	{
 		SET_PARSER_ERROR(PARSER_ERROR_OTHER);
@@ -832,6 +841,22 @@ void lwgeom_parser_result_free(LWGEOM_PARSER_RESULT *parser_result)
 	   it is a const *char */
 }
 
+/**
+* Parse a WKT geometry string into an LWGEOM structure, with the reader
+* chosen at build time (--with-wkt-parser). Both readers share the
+* builder functions above, so they return the same geometries and 
+* error messages. They use globals and are not re-entrant.
+* Note that parser_result.wkinput picks up a reference to wktstr.
+*/
+int lwgeom_parse_wkt(LWGEOM_PARSER_RESULT *parser_result, char *wktstr, int parser_check_flags)
+{
+#if POSTGIS_WKT_PARSER_BISON
+	return lwgeom_parse_wkt_bison(parser_result, wktstr, parser_check_flags);
+#else
+	return lwgeom_parse_wkt_rd(parser_result, wktstr, parser_check_flags);
+#endif
+}
+
 /*
 * Public function used for easy access to the parser.
 */
@@ -28,6 +28,12 @@ extern const char *parser_error_messages[];
 extern void wkt_lexer_init(char *str);
 extern void wkt_lexer_close(void);
 
+/*
+* The two WKT readers, lwgeom_parse_wkt() calls the one picked at build time.
+*/
+int lwgeom_parse_wkt_bison(LWGEOM_PARSER_RESULT *parser_result, char *wktstr, int parser_check_flags);
+int lwgeom_parse_wkt_rd(LWGEOM_PARSER_RESULT *parser_result, char *wktstr, int parser_check_flags);
+
 
 /*
 * Functions called from within the bison parser to construct geometries.
@@ -38,6 +44,7 @@ POINT wkt_parser_coord_3(double c1, double c2, double c3);
 POINT wkt_parser_coord_4(double c1, double c2, double c3, double c4);
 POINTARRAY* wkt_parser_ptarray_add_coord(POINTARRAY *pa, POINT p);
 POINTARRAY* wkt_parser_ptarray_new(POINT p);
+POINTARRAY* wkt_parser_ptarray_new_with_size(POINT p, int maxpoints);
 LWGEOM* wkt_parser_point_new(POINTARRAY *pa, char *dimensionality);
 LWGEOM* wkt_parser_linestring_new(POINTARRAY *pa, char *dimensionality);
 LWGEOM* wkt_parser_circularstring_new(POINTARRAY *pa, char *dimensionality);
@@ -171,12 +171,13 @@ void wkt_yyerror(const char *str)
 }
 
 /**
-* Parse a WKT geometry string into an LWGEOM structure. Note that this
-* process uses globals and is not re-entrant, so don't call it within itself
-* (eg, from within other functions in lwin_wkt.c) or from a threaded program.
+* Parse a WKT geometry string into an LWGEOM structure using the flex
+* lexer and bison grammar. Note that this process uses globals and is not
+* re-entrant, so don't call it within itself (eg, from within other 
+* functions in lwin_wkt.c) or from a threaded program.
 * Note that parser_result.wkinput picks up a reference to wktstr.
 */
-int lwgeom_parse_wkt(LWGEOM_PARSER_RESULT *parser_result, char *wktstr, int parser_check_flags)
+int lwgeom_parse_wkt_bison(LWGEOM_PARSER_RESULT *parser_result, char *wktstr, int parser_check_flags)
 {
 	int parse_rv = 0;
 
@@ -0,0 +1,739 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/**
+* @file
+* Single pass recursive descent reader for WKT and EWKT.
+*
+* This accepts exactly the language of lwin_wkt_lex.l and lwin_wkt_parse.y
+* and builds the geometries with the same wkt_parser_* functions from
+* lwin_wkt.c, so results and error messages are the same as from the
+* flex/bison reader. What it saves is the token and parser stack machinery,
+* the atof() calls on every coordinate, and the reallocations of point
+* arrays: the coordinates of a point array are counted before it is
+* allocated. Error locations are kept in wkt_yylloc, as the builder
+* functions report from there.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwin_wkt.h"
+#include "lwin_wkt_parse.h"
+#include "lwgeom_log.h"
+
+/**
+* Reading state. Tokens are only read when a decision needs them, at
+* the points where the bison parser reads its lookahead, so errors are
+* noticed and located the same way.
+*/
+typedef struct
+{
+	const char *wkt;      /* Start of the input */
+	const char *pos;      /* First character after the current token */
+	const char *tokstart; /* First character of the current token */
+	int token;            /* Current token, 0 at the end of the input */
+	int have_token;       /* Whether token has been read and not consumed */
+	double dval;          /* Value of a DOUBLE_TOK */
+	int ival;             /* Value of a SRID_TOK */
+	char *dims;           /* Value of a DIMENSIONALITY_TOK */
+}
+wkt_rd_state;
+
+typedef struct
+{
+	const char *word;
+	size_t len;
+	int token;
+}
+wkt_rd_keyword;
+
+/*
+* Keywords are matched case insensitively and the longest match wins,
+* which only matters for the dimensionality tags, hence the order.
+*/
+static const wkt_rd_keyword wkt_rd_keywords[] =
+{
+	{"GEOMETRYCOLLECTION", 18, COLLECTION_TOK},
+	{"MULTISURFACE", 12, MSURFACE_TOK},
+	{"MULTIPOLYGON", 12, MPOLYGON_TOK},
+	{"MULTICURVE", 10, MCURVE_TOK},
+	{"MULTILINESTRING", 15, MLINESTRING_TOK},
+	{"MULTIPOINT", 10, MPOINT_TOK},
+	{"CURVEPOLYGON", 12, CURVEPOLYGON_TOK},
+	{"POLYGON", 7, POLYGON_TOK},
+	{"COMPOUNDCURVE", 13, COMPOUNDCURVE_TOK},
+	{"CIRCULARSTRING", 14, CIRCULARSTRING_TOK},
+	{"LINESTRING", 10, LINESTRING_TOK},
+	{"POLYHEDRALSURFACE", 17, POLYHEDRALSURFACE_TOK},
+	{"TRIANGLE", 8, TRIANGLE_TOK},
+	{"TIN", 3, TIN_TOK},
+	{"POINT", 5, POINT_TOK},
+	{"EMPTY", 5, EMPTY_TOK},
+	{"ZM", 2, DIMENSIONALITY_TOK},
+	{"Z", 1, DIMENSIONALITY_TOK},
+	{"M", 1, DIMENSIONALITY_TOK},
+	{NULL, 0, 0}
+};
+
+#define WKT_RD_ISDIGIT(c) ((c) >= '0' && (c) <= '9')
+
+/* Stop on any error recorded by the builder functions, like WKT_ERROR() */
+#define WKT_RD_CHECK() { if ( global_parser_result.errcode != 0 ) return NULL; }
+
+/**
+* Read the next token into the state, keeping wkt_yylloc.last_column
+* at the end of it the way the flex lexer does.
+*/
+static void wkt_rd_lex(wkt_rd_state *s)
+{
+	const char *p = s->pos;
+	const wkt_rd_keyword *kw;
+
+	while ( *p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' )
+		p++;
+
+	s->tokstart = p;
+	wkt_yylloc.first_column = p - s->wkt;
+
+	switch ( *p )
+	{
+	case '\0':
+		s->token = 0;
+		break;
+	case '(':
+		s->token = LBRACKET_TOK;
+		p++;
+		break;
+	case ')':
+		s->token = RBRACKET_TOK;
+		p++;
+		break;
+	case ',':
+		s->token = COMMA_TOK;
+		p++;
+		break;
+	case ';':
+		s->token = SEMICOLON_TOK;
+		p++;
+		break;
+	case '-': case '.':
+	case '0': case '1': case '2': case '3': case '4':
+	case '5': case '6': case '7': case '8': case '9':
+	{
+		const char *end = lwread_double(p, &(s->dval));
+		if ( end )
+		{
+			s->token = DOUBLE_TOK;
+			p = end;
+			break;
+		}
+		goto unknown;
+	}
+	case 's': case 'S':
+	{
+		const char *d = p + 5;
+		if ( strncasecmp(p, "SRID=", 5) == 0 )
+		{
+			if ( *d == '-' ) d++;
+			if ( WKT_RD_ISDIGIT(*d) )
+			{
+				while ( WKT_RD_ISDIGIT(*d) ) d++;
+				s->ival = wkt_lexer_read_srid((char*)p);
+				s->token = SRID_TOK;
+				p = d;
+				break;
+			}
+		}
+		goto unknown;
+	}
+	default:
+		for ( kw = wkt_rd_keywords; kw->word; kw++ )
+		{
+			if ( (*p & 0xDF) == kw->word[0] && strncasecmp(p, kw->word, kw->len) == 0 )
+			{
+				s->token = kw->token;
+				if ( kw->token == DIMENSIONALITY_TOK )
+					s->dims = (char*)(kw->word);
+				p += kw->len;
+				break;
+			}
+		}
+		if ( kw->word )
+			break;
+
+unknown:
+		/* Error out and stop parsing on unexpected junk, as in the lexer */
+		p++;
+		s->token = 0;
+		global_parser_result.errcode = PARSER_ERROR_OTHER;
+		global_parser_result.message = parser_error_messages[PARSER_ERROR_OTHER];
+		global_parser_result.errlocation = p - s->wkt;
+	}
+
+	s->pos = p;
+	s->have_token = LW_TRUE;
+	wkt_yylloc.last_column = p - s->wkt;
+}
+
+static int wkt_rd_peek(wkt_rd_state *s)
+{
+	if ( ! s->have_token )
+		wkt_rd_lex(s);
+	return s->token;
+}
+
+static void wkt_rd_consume(wkt_rd_state *s)
+{
+	s->have_token = LW_FALSE;
+}
+
+static void wkt_rd_syntax_error(void)
+{
+	if ( ! global_parser_result.message )
+	{
+		global_parser_result.message = parser_error_messages[PARSER_ERROR_OTHER];
+		global_parser_result.errcode = PARSER_ERROR_OTHER;
+		global_parser_result.errlocation = wkt_yylloc.last_column;
+	}
+}
+
+static int wkt_rd_accept(wkt_rd_state *s, int token)
+{
+	if ( wkt_rd_peek(s) != token )
+		return LW_FALSE;
+	wkt_rd_consume(s);
+	return LW_TRUE;
+}
+
+static int wkt_rd_expect(wkt_rd_state *s, int token)
+{
+	if ( wkt_rd_accept(s, token) )
+		return LW_TRUE;
+	wkt_rd_syntax_error();
+	return LW_FALSE;
+}
+
+/**
+* Step over a geometry keyword and read the optional dimensionality tag
+* and EMPTY or the opening bracket that follow it.
+*/
+#define WKT_RD_FAILURE 0
+#define WKT_RD_EMPTY 1
+#define WKT_RD_OPEN 2
+
+static int wkt_rd_open(wkt_rd_state *s, char **dims)
+{
+	*dims = NULL;
+	wkt_rd_consume(s);
+	if ( wkt_rd_peek(s) == DIMENSIONALITY_TOK )
+	{
+		*dims = s->dims;
+		wkt_rd_consume(s);
+	}
+	if ( wkt_rd_accept(s, EMPTY_TOK) )
+		return WKT_RD_EMPTY;
+	if ( wkt_rd_expect(s, LBRACKET_TOK) )
+		return WKT_RD_OPEN;
+	return WKT_RD_FAILURE;
+}
+
+static int wkt_rd_coord(wkt_rd_state *s, POINT *p)
+{
+	double c[4];
+	int n = 0;
+
+	while ( n < 4 && wkt_rd_peek(s) == DOUBLE_TOK )
+	{
+		c[n++] = s->dval;
+		wkt_rd_consume(s);
+	}
+
+	switch ( n )
+	{
+	case 2:
+		*p = wkt_parser_coord_2(c[0], c[1]);
+		break;
+	case 3:
+		*p = wkt_parser_coord_3(c[0], c[1], c[2]);
+		break;
+	case 4:
+		*p = wkt_parser_coord_4(c[0], c[1], c[2], c[3]);
+		break;
+	default:
+		wkt_rd_syntax_error();
+		return LW_FALSE;
+	}
+
+	/* Junk after the last number has already been read */
+	return global_parser_result.errcode == 0;
+}
+
+/*
+* Number of coordinates in the point array the current token is in,
+* counting from the one just read. Only a size hint.
+*/
+static int wkt_rd_count_coords(const wkt_rd_state *s)
+{
+	const char *p = s->tokstart;
+	int n = 1;
+
+	for ( ; *p && *p != ')' && *p != '('; p++ )
+		if ( *p == ',' ) n++;
+	return n;
+}
+
+static POINTARRAY* wkt_rd_ptarray(wkt_rd_state *s)
+{
+	POINTARRAY *pa;
+	POINT p;
+
+	if ( ! wkt_rd_coord(s, &p) )
+		return NULL;
+
+	pa = wkt_parser_ptarray_new_with_size(p, wkt_rd_count_coords(s));
+	WKT_RD_CHECK();
+
+	while ( wkt_rd_accept(s, COMMA_TOK) )
+	{
+		if ( ! wkt_rd_coord(s, &p) )
+		{
+			ptarray_free(pa);
+			return NULL;
+		}
+		pa = wkt_parser_ptarray_add_coord(pa, p);
+		WKT_RD_CHECK();
+	}
+	return pa;
+}
+
+/* ( ptarray ) */
+static POINTARRAY* wkt_rd_ring(wkt_rd_state *s)
+{
+	POINTARRAY *pa;
+
+	if ( ! wkt_rd_expect(s, LBRACKET_TOK) )
+		return NULL;
+	if ( ! (pa = wkt_rd_ptarray(s)) )
+		return NULL;
+	if ( ! wkt_rd_expect(s, RBRACKET_TOK) )
+	{
+		ptarray_free(pa);
+		return NULL;
+	}
+	return pa;
+}
+
+/* ring, ring, ... with the closure check given by dimcheck */
+static LWGEOM* wkt_rd_ring_list(wkt_rd_state *s, char dimcheck)
+{
+	LWGEOM *poly;
+	POINTARRAY *pa;
+
+	if ( ! (pa = wkt_rd_ring(s)) )
+		return NULL;
+	poly = wkt_parser_polygon_new(pa, dimcheck);
+	WKT_RD_CHECK();
+
+	while ( wkt_rd_accept(s, COMMA_TOK) )
+	{
+		if ( ! (pa = wkt_rd_ring(s)) )
+		{
+			lwgeom_free(poly);
+			return NULL;
+		}
+		poly = wkt_parser_polygon_add_ring(poly, pa, dimcheck);
+		WKT_RD_CHECK();
+	}
+	return poly;
+}
+
+typedef LWGEOM* (*wkt_rd_element_fn)(wkt_rd_state *s);
+typedef LWGEOM* (*wkt_rd_new_fn)(LWGEOM *geom);
+typedef LWGEOM* (*wkt_rd_add_fn)(LWGEOM *col, LWGEOM *geom);
+
+/**
+* Read a comma separated list of elements, starting the container with
+* newfn and adding the rest of the elements with addfn.
+*/
+static LWGEOM* wkt_rd_list(wkt_rd_state *s, wkt_rd_element_fn element, wkt_rd_new_fn newfn, wkt_rd_add_fn addfn)
+{
+	LWGEOM *col, *geom;
+
+	if ( ! (geom = element(s)) )
+		return NULL;
+	col = newfn(geom);
+	WKT_RD_CHECK();
+
+	while ( wkt_rd_accept(s, COMMA_TOK) )
+	{
+		if ( ! (geom = element(s)) )
+		{
+			lwgeom_free(col);
+			return NULL;
+		}
+		col = addfn(col, geom);
+		WKT_RD_CHECK();
+	}
+	return col;
+}
+
+static LWGEOM* wkt_rd_geometry(wkt_rd_state *s);
+
+/* coordinate | ( coordinate ) */
+static LWGEOM* wkt_rd_point_untagged(wkt_rd_state *s)
+{
+	LWGEOM *geom;
+	POINT p;
+
+	if ( wkt_rd_accept(s, LBRACKET_TOK) )
+	{
+		if ( ! (wkt_rd_coord(s, &p) && wkt_rd_expect(s, RBRACKET_TOK)) )
+			return NULL;
+	}
+	else if ( ! wkt_rd_coord(s, &p) )
+	{
+		return NULL;
+	}
+	geom = wkt_parser_point_new(wkt_parser_ptarray_new(p), NULL);
+	WKT_RD_CHECK();
+	return geom;
+}
+
+/* ( ptarray ) */
+static LWGEOM* wkt_rd_linestring_untagged(wkt_rd_state *s)
+{
+	LWGEOM *geom;
+	POINTARRAY *pa;
+
+	if ( ! (pa = wkt_rd_ring(s)) )
+		return NULL;
+	geom = wkt_parser_linestring_new(pa, NULL);
+	WKT_RD_CHECK();
+	return geom;
+}
+
+/* ( ( ptarray ) ) */
+static LWGEOM* wkt_rd_triangle_untagged(wkt_rd_state *s)
+{
+	LWGEOM *geom;
+	POINTARRAY *pa;
+
+	if ( ! wkt_rd_expect(s, LBRACKET_TOK) )
+		return NULL;
+	if ( ! (pa = wkt_rd_ring(s)) )
+		return NULL;
+	if ( ! wkt_rd_expect(s, RBRACKET_TOK) )
+	{
+		ptarray_free(pa);
+		return NULL;
+	}
+	geom = wkt_parser_triangle_new(pa, NULL);
+	WKT_RD_CHECK();
+	return geom;
+}
+
+/* ( ring_list ), with the closure check given by dimcheck */
+static LWGEOM* wkt_rd_rings(wkt_rd_state *s, char dimcheck)
+{
+	LWGEOM *poly;
+
+	if ( ! wkt_rd_expect(s, LBRACKET_TOK) )
+		return NULL;
+	if ( ! (poly = wkt_rd_ring_list(s, dimcheck)) )
+		return NULL;
+	if ( ! wkt_rd_expect(s, RBRACKET_TOK) )
+	{
+		lwgeom_free(poly);
+		return NULL;
+	}
+	return poly;
+}
+
+static LWGEOM* wkt_rd_polygon_untagged(wkt_rd_state *s)
+{
+	return wkt_rd_rings(s, '2');
+}
+
+static LWGEOM* wkt_rd_patch(wkt_rd_state *s)
+{
+	return wkt_rd_rings(s, 'Z');
+}
+
+/* polygon | curvepolygon | polygon_untagged */
+static LWGEOM* wkt_rd_surface(wkt_rd_state *s)
+{
+	switch ( wkt_rd_peek(s) )
+	{
+	case POLYGON_TOK:
+	case CURVEPOLYGON_TOK:
+		return wkt_rd_geometry(s);
+	case LBRACKET_TOK:
+		return wkt_rd_polygon_untagged(s);
+	}
+	wkt_rd_syntax_error();
+	return NULL;
+}
+
+/* circularstring | compoundcurve | linestring | linestring_untagged */
+static LWGEOM* wkt_rd_curve(wkt_rd_state *s)
+{
+	switch ( wkt_rd_peek(s) )
+	{
+	case CIRCULARSTRING_TOK:
+	case COMPOUNDCURVE_TOK:
+	case LINESTRING_TOK:
+		return wkt_rd_geometry(s);
+	case LBRACKET_TOK:
+		return wkt_rd_linestring_untagged(s);
+	}
+	wkt_rd_syntax_error();
+	return NULL;
+}
+
+/* circularstring | linestring | linestring_untagged */
+static LWGEOM* wkt_rd_compound_element(wkt_rd_state *s)
+{
+	if ( wkt_rd_peek(s) == COMPOUNDCURVE_TOK )
+	{
+		wkt_rd_syntax_error();
+		return NULL;
+	}
+	return wkt_rd_curve(s);
+}
+
+/**
+* Read a tagged geometry, without the SRID prefix.
+*/
+static LWGEOM* wkt_rd_geometry(wkt_rd_state *s)
+{
+	LWGEOM *geom = NULL;
+	POINTARRAY *pa = NULL;
+	char *dims;
+	int token = wkt_rd_peek(s);
+	int type = 0;
+	int rv;
+
+	switch ( token )
+	{
+	case POINT_TOK:
+	case LINESTRING_TOK:
+	case CIRCULARSTRING_TOK:
+	case TRIANGLE_TOK:
+		if ( ! (rv = wkt_rd_open(s, &dims)) )
+			return NULL;
+		if ( rv == WKT_RD_OPEN )
+		{
+			if ( token == TRIANGLE_TOK )
+				pa = wkt_rd_ring(s);
+			else
+				pa = wkt_rd_ptarray(s);
+			if ( ! pa )
+				return NULL;
+			if ( ! wkt_rd_expect(s, RBRACKET_TOK) )
+			{
+				ptarray_free(pa);
+				return NULL;
+			}
+		}
+		if ( token == POINT_TOK )
+			geom = wkt_parser_point_new(pa, dims);
+		else if ( token == LINESTRING_TOK )
+			geom = wkt_parser_linestring_new(pa, dims);
+		else if ( token == CIRCULARSTRING_TOK )
+			geom = wkt_parser_circularstring_new(pa, dims);
+		else
+			geom = wkt_parser_triangle_new(pa, dims);
+		WKT_RD_CHECK();
+		return geom;
+
+	case POLYGON_TOK:
+		if ( ! (rv = wkt_rd_open(s, &dims)) )
+			return NULL;
+		if ( rv == WKT_RD_OPEN )
+		{
+			if ( ! (geom = wkt_rd_ring_list(s, '2')) )
+				return NULL;
+			if ( ! wkt_rd_expect(s, RBRACKET_TOK) )
+			{
+				lwgeom_free(geom);
+				return NULL;
+			}
+		}
+		geom = wkt_parser_polygon_finalize(geom, dims);
+		WKT_RD_CHECK();
+		return geom;
+
+	case CURVEPOLYGON_TOK:
+		if ( ! (rv = wkt_rd_open(s, &dims)) )
+			return NULL;
+		if ( rv == WKT_RD_OPEN )
+		{
+			geom = wkt_rd_list(s, wkt_rd_curve, wkt_parser_curvepolygon_new, wkt_parser_curvepolygon_add_ring);
+			if ( ! geom )
+				return NULL;
+			if ( ! wkt_rd_expect(s, RBRACKET_TOK) )
+			{
+				lwgeom_free(geom);
+				return NULL;
+			}
+		}
+		geom = wkt_parser_curvepolygon_finalize(geom, dims);
+		WKT_RD_CHECK();
+		return geom;
+
+	case COMPOUNDCURVE_TOK:
+	case MPOINT_TOK:
+	case MLINESTRING_TOK:
+	case MPOLYGON_TOK:
+	case MSURFACE_TOK:
+	case MCURVE_TOK:
+	case TIN_TOK:
+	case POLYHEDRALSURFACE_TOK:
+	case COLLECTION_TOK:
+		if ( ! (rv = wkt_rd_open(s, &dims)) )
+			return NULL;
+		if ( rv == WKT_RD_OPEN )
+		{
+			wkt_rd_element_fn element;
+			wkt_rd_add_fn addfn = wkt_parser_collection_add_geom;
+
+			switch ( token )
+			{
+			case COMPOUNDCURVE_TOK:
+				element = wkt_rd_compound_element;
+				addfn = wkt_parser_compound_add_geom;
+				break;
+			case MPOINT_TOK:
+				element = wkt_rd_point_untagged;
+				break;
+			case MLINESTRING_TOK:
+				element = wkt_rd_linestring_untagged;
+				break;
+			case MPOLYGON_TOK:
+				element = wkt_rd_polygon_untagged;
+				break;
+			case MSURFACE_TOK:
+				element = wkt_rd_surface;
+				break;
+			case MCURVE_TOK:
+				element = wkt_rd_curve;
+				break;
+			case TIN_TOK:
+				element = wkt_rd_triangle_untagged;
+				break;
+			case POLYHEDRALSURFACE_TOK:
+				element = wkt_rd_patch;
+				break;
+			default:
+				element = wkt_rd_geometry;
+			}
+
+			if ( ! (geom = wkt_rd_list(s, element, wkt_parser_collection_new, addfn)) )
+				return NULL;
+			if ( ! wkt_rd_expect(s, RBRACKET_TOK) )
+			{
+				lwgeom_free(geom);
+				return NULL;
+			}
+		}
+
+		switch ( token )
+		{
+		case COMPOUNDCURVE_TOK: type = COMPOUNDTYPE; break;
+		case MPOINT_TOK: type = MULTIPOINTTYPE; break;
+		case MLINESTRING_TOK: type = MULTILINETYPE; break;
+		case MPOLYGON_TOK: type = MULTIPOLYGONTYPE; break;
+		case MSURFACE_TOK: type = MULTISURFACETYPE; break;
+		case MCURVE_TOK: type = MULTICURVETYPE; break;
+		case TIN_TOK: type = TINTYPE; break;
+		case POLYHEDRALSURFACE_TOK: type = POLYHEDRALSURFACETYPE; break;
+		default: type = COLLECTIONTYPE;
+		}
+		geom = wkt_parser_collection_finalize(type, geom, dims);
+		WKT_RD_CHECK();
+		return geom;
+	}
+
+	wkt_rd_syntax_error();
+	return NULL;
+}
+
+/**
+* Parse a WKT geometry string into an LWGEOM structure with the
+* recursive descent reader. Like the bison reader this works through
+* global_parser_result, so it is not re-entrant.
+*/
+int lwgeom_parse_wkt_rd(LWGEOM_PARSER_RESULT *parser_result, char *wktstr, int parser_check_flags)
+{
+	wkt_rd_state s;
+	LWGEOM *geom = NULL;
+	int srid = SRID_UNKNOWN;
+
+	/* Clean up our global parser result. */
+	global_parser_result.geom = NULL;
+	global_parser_result.message = NULL;
+	global_parser_result.serialized_lwgeom = NULL;
+	global_parser_result.errcode = 0;
+	global_parser_result.errlocation = 0;
+	global_parser_result.size = 0;
+
+	/* Set the input text string, and parse checks. */
+	global_parser_result.wkinput = wktstr;
+	global_parser_result.parser_check_flags = parser_check_flags;
+
+	wkt_yylloc.first_line = wkt_yylloc.last_line = 1;
+	wkt_yylloc.first_column = wkt_yylloc.last_column = 0;
+
+	s.wkt = s.pos = wktstr;
+	s.have_token = LW_FALSE;
+	s.dims = NULL;
+
+	if ( wkt_rd_accept(&s, SRID_TOK) )
+	{
+		srid = s.ival;
+		if ( wkt_rd_expect(&s, SEMICOLON_TOK) )
+			geom = wkt_rd_geometry(&s);
+	}
+	else
+	{
+		geom = wkt_rd_geometry(&s);
+	}
+
+	/*
+	* As in the grammar, the geometry is stored before looking at what 
+	* follows, so trailing tokens fail the parse but leave the geometry in
+	* the result, and junk right at the end is flagged without failing.
+	*/
+	if ( geom )
+	{
+		wkt_parser_geometry_new(geom, srid);
+		if ( wkt_rd_peek(&s) == 0 )
+		{
+			*parser_result = global_parser_result;
+			return LW_SUCCESS;
+		}
+		wkt_rd_syntax_error();
+	}
+
+	if( ! global_parser_result.errcode )
+	{
+		global_parser_result.errcode = PARSER_ERROR_OTHER;
+		global_parser_result.message = parser_error_messages[PARSER_ERROR_OTHER];
+		global_parser_result.errlocation = wkt_yylloc.last_column;
+	}
+
+	LWDEBUGF(5, "error returned by lwgeom_parse_wkt_rd() @ %d: [%d] '%s'",
+	            global_parser_result.errlocation,
+	            global_parser_result.errcode,
+	            global_parser_result.message);
+
+	*parser_result = global_parser_result;
+	return LW_FAILURE;
+}
@@ -12,63 +12,68 @@
  **********************************************************************/
 
 #include "liblwgeom_internal.h"
-#include <string.h>	/* strlen */
+#include "stringbuffer.h"
 
-static char *asgeojson_point(const LWPOINT *point, char *srs, GBOX *bbox, int precision);
-static char *asgeojson_line(const LWLINE *line, char *srs, GBOX *bbox, int precision);
-static char *asgeojson_poly(const LWPOLY *poly, char *srs, GBOX *bbox, int precision);
-static char * asgeojson_multipoint(const LWMPOINT *mpoint, char *srs, GBOX *bbox, int precision);
-static char * asgeojson_multiline(const LWMLINE *mline, char *srs, GBOX *bbox, int precision);
-static char * asgeojson_multipolygon(const LWMPOLY *mpoly, char *srs, GBOX *bbox, int precision);
-static char * asgeojson_collection(const LWCOLLECTION *col, char *srs, GBOX *bbox, int precision);
-static size_t asgeojson_geom_size(const LWGEOM *geom, GBOX *bbox, int precision);
-static size_t asgeojson_geom_buf(const LWGEOM *geom, char *output, GBOX *bbox, int precision);
+static int asgeojson_geom_sb(const LWGEOM *geom, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb);
+static int asgeojson_point_sb(const LWPOINT *point, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb);
+static int asgeojson_line_sb(const LWLINE *line, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb);
+static int asgeojson_poly_sb(const LWPOLY *poly, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb);
+static int asgeojson_multipoint_sb(const LWMPOINT *mpoint, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb);
+static int asgeojson_multiline_sb(const LWMLINE *mline, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb);
+static int asgeojson_multipolygon_sb(const LWMPOLY *mpoly, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb);
+static int asgeojson_collection_sb(const LWCOLLECTION *col, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb);
 
-static size_t pointArray_to_geojson(POINTARRAY *pa, char *buf, int precision);
-static size_t pointArray_geojson_size(POINTARRAY *pa, int precision);
+static void pointArray_to_geojson(const POINTARRAY *pa, int precision, stringbuffer_t *sb);
 
 /**
  * Takes a GEOMETRY and returns a GeoJson representation
+ *
+ * The output is written in a single pass into a stringbuffer_t,
+ * which grows as needed, rather than sized beforehand for the
+ * longest possible rendering of every coordinate.
  */
 char *
 lwgeom_to_geojson(const LWGEOM *geom, char *srs, int precision, int has_bbox)
 {
-	int type = geom->type;
 	GBOX *bbox = NULL;
 	GBOX tmp;
-	int rv;
+	stringbuffer_t *sb;
+	char *geojson;
 
 	if (has_bbox) 
 	{
 		/* Whether these are geography or geometry, 
 		   the GeoJSON expects a cartesian bounding box */
-		rv = lwgeom_calculate_gbox_cartesian(geom, &tmp);
+		lwgeom_calculate_gbox_cartesian(geom, &tmp);
 		bbox = &tmp;
 	}		
 
-	switch (type)
+	sb = stringbuffer_create();
+
+	switch (geom->type)
 	{
 	case POINTTYPE:
-		return asgeojson_point((LWPOINT*)geom, srs, bbox, precision);
 	case LINETYPE:
-		return asgeojson_line((LWLINE*)geom, srs, bbox, precision);
 	case POLYGONTYPE:
-		return asgeojson_poly((LWPOLY*)geom, srs, bbox, precision);
 	case MULTIPOINTTYPE:
-		return asgeojson_multipoint((LWMPOINT*)geom, srs, bbox, precision);
 	case MULTILINETYPE:
-		return asgeojson_multiline((LWMLINE*)geom, srs, bbox, precision);
 	case MULTIPOLYGONTYPE:
-		return asgeojson_multipolygon((LWMPOLY*)geom, srs, bbox, precision);
+		asgeojson_geom_sb(geom, srs, bbox, precision, sb);
+		break;
 	case COLLECTIONTYPE:
-		return asgeojson_collection((LWCOLLECTION*)geom, srs, bbox, precision);
+		asgeojson_collection_sb((LWCOLLECTION*)geom, srs, bbox, precision, sb);
+		break;
 	default:
+		stringbuffer_destroy(sb);
 		lwerror("lwgeom_to_geojson: '%s' geometry type not supported",
-		        lwtype_name(type));
+		        lwtype_name(geom->type));
+		return NULL;
 	}
 
-	/* Never get here */
-	return NULL;
+	geojson = stringbuffer_getstringcopy(sb);
+	stringbuffer_destroy(sb);
+
+	return geojson;
 }
 
 
@@ -76,27 +81,11 @@ lwgeom_to_geojson(const LWGEOM *geom, char *srs, int precision, int has_bbox)
 /**
  * Handle SRS
  */
-static size_t
-asgeojson_srs_size(char *srs)
+static void
+asgeojson_srs_sb(char *srs, stringbuffer_t *sb)
 {
-	int size;
-
-	size = sizeof("'crs':{'type':'name',");
-	size += sizeof("'properties':{'name':''}},");
-	size += strlen(srs) * sizeof(char);
-
-	return size;
-}
-
-static size_t
-asgeojson_srs_buf(char *output, char *srs)
-{
-	char *ptr = output;
-
-	ptr += sprintf(ptr, "\"crs\":{\"type\":\"name\",");
-	ptr += sprintf(ptr, "\"properties\":{\"name\":\"%s\"}},", srs);
-
-	return (ptr-output);
+	stringbuffer_append(sb, "\"crs\":{\"type\":\"name\",");
+	stringbuffer_aprintf(sb, "\"properties\":{\"name\":\"%s\"}},", srs);
 }
 
 
@@ -104,89 +93,46 @@ asgeojson_srs_buf(char *output, char *srs)
 /**
  * Handle Bbox
  */
-static size_t
-asgeojson_bbox_size(int hasz, int precision)
-{
-	int size;
-
-	if (!hasz)
-	{
-		size = sizeof("\"bbox\":[,,,],");
-		size +=	2 * 2 * (OUT_MAX_DIGS_DOUBLE + precision);
-	}
-	else
-	{
-		size = sizeof("\"bbox\":[,,,,,],");
-		size +=	2 * 3 * (OUT_MAX_DIGS_DOUBLE + precision);
-	}
-
-	return size;
-}
-
-static size_t
-asgeojson_bbox_buf(char *output, GBOX *bbox, int hasz, int precision)
+static void
+asgeojson_bbox_sb(GBOX *bbox, int hasz, int precision, stringbuffer_t *sb)
 {
-	char *ptr = output;
-
 	if (!hasz)
-		ptr += sprintf(ptr, "\"bbox\":[%.*f,%.*f,%.*f,%.*f],",
+		stringbuffer_aprintf(sb, "\"bbox\":[%.*f,%.*f,%.*f,%.*f],",
 		               precision, bbox->xmin, precision, bbox->ymin,
 		               precision, bbox->xmax, precision, bbox->ymax);
 	else
-		ptr += sprintf(ptr, "\"bbox\":[%.*f,%.*f,%.*f,%.*f,%.*f,%.*f],",
+		stringbuffer_aprintf(sb, "\"bbox\":[%.*f,%.*f,%.*f,%.*f,%.*f,%.*f],",
 		               precision, bbox->xmin, precision, bbox->ymin, precision, bbox->zmin,
 		               precision, bbox->xmax, precision, bbox->ymax, precision, bbox->zmax);
-
-	return (ptr-output);
 }
 
 
-
 /**
- * Point Geometry
+ * Geometry header: type, then srs and bbox if any
  */
-
-static size_t
-asgeojson_point_size(const LWPOINT *point, char *srs, GBOX *bbox, int precision)
+static void
+asgeojson_header_sb(const char *type, uint8_t flags, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb)
 {
-	int size;
-
-	size = pointArray_geojson_size(point->point, precision);
-	size += sizeof("{'type':'Point',");
-	size += sizeof("'coordinates':}");
-
-	if (srs) size += asgeojson_srs_size(srs);
-	if (bbox) size += asgeojson_bbox_size(FLAGS_GET_Z(point->flags), precision);
-
-	return size;
+	stringbuffer_aprintf(sb, "{\"type\":\"%s\",", type);
+	if (srs) asgeojson_srs_sb(srs, sb);
+	if (bbox) asgeojson_bbox_sb(bbox, FLAGS_GET_Z(flags), precision, sb);
 }
 
-static size_t
-asgeojson_point_buf(const LWPOINT *point, char *srs, char *output, GBOX *bbox, int precision)
-{
-	char *ptr = output;
-
-	ptr += sprintf(ptr, "{\"type\":\"Point\",");
-	if (srs) ptr += asgeojson_srs_buf(ptr, srs);
-	if (bbox) ptr += asgeojson_bbox_buf(ptr, bbox, FLAGS_GET_Z(point->flags), precision);
 
-	ptr += sprintf(ptr, "\"coordinates\":");
-	ptr += pointArray_to_geojson(point->point, ptr, precision);
-	ptr += sprintf(ptr, "}");
 
-	return (ptr-output);
-}
+/**
+ * Point Geometry
+ */
 
-static char *
-asgeojson_point(const LWPOINT *point, char *srs, GBOX *bbox, int precision)
+static int
+asgeojson_point_sb(const LWPOINT *point, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb)
 {
-	char *output;
-	int size;
+	asgeojson_header_sb("Point", point->flags, srs, bbox, precision, sb);
+	stringbuffer_append(sb, "\"coordinates\":");
+	pointArray_to_geojson(point->point, precision, sb);
+	stringbuffer_append(sb, "}");
 
-	size = asgeojson_point_size(point, srs, bbox, precision);
-	output = lwalloc(size);
-	asgeojson_point_buf(point, srs, output, bbox, precision);
-	return output;
+	return LW_SUCCESS;
 }
 
 
@@ -195,46 +141,15 @@ asgeojson_point(const LWPOINT *point, char *srs, GBOX *bbox, int precision)
  * Line Geometry
  */
 
-static size_t
-asgeojson_line_size(const LWLINE *line, char *srs, GBOX *bbox, int precision)
+static int
+asgeojson_line_sb(const LWLINE *line, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb)
 {
-	int size;
-
-	size = sizeof("{'type':'LineString',");
-	if (srs) size += asgeojson_srs_size(srs);
-	if (bbox) size += asgeojson_bbox_size(FLAGS_GET_Z(line->flags), precision);
-	size += sizeof("'coordinates':[]}");
-	size += pointArray_geojson_size(line->points, precision);
+	asgeojson_header_sb("LineString", line->flags, srs, bbox, precision, sb);
+	stringbuffer_append(sb, "\"coordinates\":[");
+	pointArray_to_geojson(line->points, precision, sb);
+	stringbuffer_append(sb, "]}");
 
-	return size;
-}
-
-static size_t
-asgeojson_line_buf(const LWLINE *line, char *srs, char *output, GBOX *bbox, int precision)
-{
-	char *ptr=output;
-
-	ptr += sprintf(ptr, "{\"type\":\"LineString\",");
-	if (srs) ptr += asgeojson_srs_buf(ptr, srs);
-	if (bbox) ptr += asgeojson_bbox_buf(ptr, bbox, FLAGS_GET_Z(line->flags), precision);
-	ptr += sprintf(ptr, "\"coordinates\":[");
-	ptr += pointArray_to_geojson(line->points, ptr, precision);
-	ptr += sprintf(ptr, "]}");
-
-	return (ptr-output);
-}
-
-static char *
-asgeojson_line(const LWLINE *line, char *srs, GBOX *bbox, int precision)
-{
-	char *output;
-	int size;
-
-	size = asgeojson_line_size(line, srs, bbox, precision);
-	output = lwalloc(size);
-	asgeojson_line_buf(line, srs, output, bbox, precision);
-
-	return output;
+	return LW_SUCCESS;
 }
 
 
@@ -243,60 +158,23 @@ asgeojson_line(const LWLINE *line, char *srs, GBOX *bbox, int precision)
  * Polygon Geometry
  */
 
-static size_t
-asgeojson_poly_size(const LWPOLY *poly, char *srs, GBOX *bbox, int precision)
-{
-	size_t size;
-	int i;
-
-	size = sizeof("{\"type\":\"Polygon\",");
-	if (srs) size += asgeojson_srs_size(srs);
-	if (bbox) size += asgeojson_bbox_size(FLAGS_GET_Z(poly->flags), precision);
-	size += sizeof("\"coordinates\":[");
-	for (i=0, size=0; i<poly->nrings; i++)
-	{
-		size += pointArray_geojson_size(poly->rings[i], precision);
-		size += sizeof("[]");
-	}
-	size += sizeof(",") * i;
-	size += sizeof("]}");
-
-	return size;
-}
-
-static size_t
-asgeojson_poly_buf(const LWPOLY *poly, char *srs, char *output, GBOX *bbox, int precision)
+static int
+asgeojson_poly_sb(const LWPOLY *poly, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb)
 {
 	int i;
-	char *ptr=output;
 
-	ptr += sprintf(ptr, "{\"type\":\"Polygon\",");
-	if (srs) ptr += asgeojson_srs_buf(ptr, srs);
-	if (bbox) ptr += asgeojson_bbox_buf(ptr, bbox, FLAGS_GET_Z(poly->flags), precision);
-	ptr += sprintf(ptr, "\"coordinates\":[");
+	asgeojson_header_sb("Polygon", poly->flags, srs, bbox, precision, sb);
+	stringbuffer_append(sb, "\"coordinates\":[");
 	for (i=0; i<poly->nrings; i++)
 	{
-		if (i) ptr += sprintf(ptr, ",");
-		ptr += sprintf(ptr, "[");
-		ptr += pointArray_to_geojson(poly->rings[i], ptr, precision);
-		ptr += sprintf(ptr, "]");
+		if (i) stringbuffer_append(sb, ",");
+		stringbuffer_append(sb, "[");
+		pointArray_to_geojson(poly->rings[i], precision, sb);
+		stringbuffer_append(sb, "]");
 	}
-	ptr += sprintf(ptr, "]}");
-
-	return (ptr-output);
-}
-
-static char *
-asgeojson_poly(const LWPOLY *poly, char *srs, GBOX *bbox, int precision)
-{
-	char *output;
-	int size;
-
-	size = asgeojson_poly_size(poly, srs, bbox, precision);
-	output = lwalloc(size);
-	asgeojson_poly_buf(poly, srs, output, bbox, precision);
+	stringbuffer_append(sb, "]}");
 
-	return output;
+	return LW_SUCCESS;
 }
 
 
@@ -305,62 +183,21 @@ asgeojson_poly(const LWPOLY *poly, char *srs, GBOX *bbox, int precision)
  * Multipoint Geometry
  */
 
-static size_t
-asgeojson_multipoint_size(const LWMPOINT *mpoint, char *srs, GBOX *bbox, int precision)
+static int
+asgeojson_multipoint_sb(const LWMPOINT *mpoint, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb)
 {
-	LWPOINT * point;
-	int size;
 	int i;
 
-	size = sizeof("{'type':'MultiPoint',");
-	if (srs) size += asgeojson_srs_size(srs);
-	if (bbox) size += asgeojson_bbox_size(FLAGS_GET_Z(mpoint->flags), precision);
-	size += sizeof("'coordinates':[]}");
-
+	asgeojson_header_sb("MultiPoint", mpoint->flags, srs, bbox, precision, sb);
+	stringbuffer_append(sb, "\"coordinates\":[");
 	for (i=0; i<mpoint->ngeoms; i++)
 	{
-		point = mpoint->geoms[i];
-		size += pointArray_geojson_size(point->point, precision);
+		if (i) stringbuffer_append(sb, ",");
+		pointArray_to_geojson(mpoint->geoms[i]->point, precision, sb);
 	}
-	size += sizeof(",") * i;
+	stringbuffer_append(sb, "]}");
 
-	return size;
-}
-
-static size_t
-asgeojson_multipoint_buf(const LWMPOINT *mpoint, char *srs, char *output, GBOX *bbox, int precision)
-{
-	LWPOINT *point;
-	int i;
-	char *ptr=output;
-
-	ptr += sprintf(ptr, "{\"type\":\"MultiPoint\",");
-	if (srs) ptr += asgeojson_srs_buf(ptr, srs);
-	if (bbox) ptr += asgeojson_bbox_buf(ptr, bbox, FLAGS_GET_Z(mpoint->flags), precision);
-	ptr += sprintf(ptr, "\"coordinates\":[");
-
-	for (i=0; i<mpoint->ngeoms; i++)
-	{
-		if (i) ptr += sprintf(ptr, ",");
-		point = mpoint->geoms[i];
-		ptr += pointArray_to_geojson(point->point, ptr, precision);
-	}
-	ptr += sprintf(ptr, "]}");
-
-	return (ptr - output);
-}
-
-static char *
-asgeojson_multipoint(const LWMPOINT *mpoint, char *srs, GBOX *bbox, int precision)
-{
-	char *output;
-	int size;
-
-	size = asgeojson_multipoint_size(mpoint, srs, bbox, precision);
-	output = lwalloc(size);
-	asgeojson_multipoint_buf(mpoint, srs, output, bbox, precision);
-
-	return output;
+	return LW_SUCCESS;
 }
 
 
@@ -369,66 +206,23 @@ asgeojson_multipoint(const LWMPOINT *mpoint, char *srs, GBOX *bbox, int precisio
  * Multiline Geometry
  */
 
-static size_t
-asgeojson_multiline_size(const LWMLINE *mline, char *srs, GBOX *bbox, int precision)
+static int
+asgeojson_multiline_sb(const LWMLINE *mline, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb)
 {
-	LWLINE * line;
-	int size;
 	int i;
 
-	size = sizeof("{'type':'MultiLineString',");
-	if (srs) size += asgeojson_srs_size(srs);
-	if (bbox) size += asgeojson_bbox_size(FLAGS_GET_Z(mline->flags), precision);
-	size += sizeof("'coordinates':[]}");
-
-	for (i=0 ; i<mline->ngeoms; i++)
-	{
-		line = mline->geoms[i];
-		size += pointArray_geojson_size(line->points, precision);
-		size += sizeof("[]");
-	}
-	size += sizeof(",") * i;
-
-	return size;
-}
-
-static size_t
-asgeojson_multiline_buf(const LWMLINE *mline, char *srs, char *output, GBOX *bbox, int precision)
-{
-	LWLINE *line;
-	int i;
-	char *ptr=output;
-
-	ptr += sprintf(ptr, "{\"type\":\"MultiLineString\",");
-	if (srs) ptr += asgeojson_srs_buf(ptr, srs);
-	if (bbox) ptr += asgeojson_bbox_buf(ptr, bbox, FLAGS_GET_Z(mline->flags), precision);
-	ptr += sprintf(ptr, "\"coordinates\":[");
-
+	asgeojson_header_sb("MultiLineString", mline->flags, srs, bbox, precision, sb);
+	stringbuffer_append(sb, "\"coordinates\":[");
 	for (i=0; i<mline->ngeoms; i++)
 	{
-		if (i) ptr += sprintf(ptr, ",");
-		ptr += sprintf(ptr, "[");
-		line = mline->geoms[i];
-		ptr += pointArray_to_geojson(line->points, ptr, precision);
-		ptr += sprintf(ptr, "]");
+		if (i) stringbuffer_append(sb, ",");
+		stringbuffer_append(sb, "[");
+		pointArray_to_geojson(mline->geoms[i]->points, precision, sb);
+		stringbuffer_append(sb, "]");
 	}
+	stringbuffer_append(sb, "]}");
 
-	ptr += sprintf(ptr, "]}");
-
-	return (ptr - output);
-}
-
-static char *
-asgeojson_multiline(const LWMLINE *mline, char *srs, GBOX *bbox, int precision)
-{
-	char *output;
-	int size;
-
-	size = asgeojson_multiline_size(mline, srs, bbox, precision);
-	output = lwalloc(size);
-	asgeojson_multiline_buf(mline, srs, output, bbox, precision);
-
-	return output;
+	return LW_SUCCESS;
 }
 
 
@@ -437,75 +231,31 @@ asgeojson_multiline(const LWMLINE *mline, char *srs, GBOX *bbox, int precision)
  * MultiPolygon Geometry
  */
 
-static size_t
-asgeojson_multipolygon_size(const LWMPOLY *mpoly, char *srs, GBOX *bbox, int precision)
-{
-	LWPOLY *poly;
-	int size;
-	int i, j;
-
-	size = sizeof("{'type':'MultiPolygon',");
-	if (srs) size += asgeojson_srs_size(srs);
-	if (bbox) size += asgeojson_bbox_size(FLAGS_GET_Z(mpoly->flags), precision);
-	size += sizeof("'coordinates':[]}");
-
-	for (i=0; i < mpoly->ngeoms; i++)
-	{
-		poly = mpoly->geoms[i];
-		for (j=0 ; j <poly->nrings ; j++)
-		{
-			size += pointArray_geojson_size(poly->rings[j], precision);
-			size += sizeof("[]");
-		}
-		size += sizeof("[]");
-	}
-	size += sizeof(",") * i;
-	size += sizeof("]}");
-
-	return size;
-}
-
-static size_t
-asgeojson_multipolygon_buf(const LWMPOLY *mpoly, char *srs, char *output, GBOX *bbox, int precision)
+static int
+asgeojson_multipolygon_sb(const LWMPOLY *mpoly, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb)
 {
 	LWPOLY *poly;
 	int i, j;
-	char *ptr=output;
 
-	ptr += sprintf(ptr, "{\"type\":\"MultiPolygon\",");
-	if (srs) ptr += asgeojson_srs_buf(ptr, srs);
-	if (bbox) ptr += asgeojson_bbox_buf(ptr, bbox, FLAGS_GET_Z(mpoly->flags), precision);
-	ptr += sprintf(ptr, "\"coordinates\":[");
+	asgeojson_header_sb("MultiPolygon", mpoly->flags, srs, bbox, precision, sb);
+	stringbuffer_append(sb, "\"coordinates\":[");
 	for (i=0; i<mpoly->ngeoms; i++)
 	{
-		if (i) ptr += sprintf(ptr, ",");
-		ptr += sprintf(ptr, "[");
+		if (i) stringbuffer_append(sb, ",");
+		stringbuffer_append(sb, "[");
 		poly = mpoly->geoms[i];
 		for (j=0 ; j < poly->nrings ; j++)
 		{
-			if (j) ptr += sprintf(ptr, ",");
-			ptr += sprintf(ptr, "[");
-			ptr += pointArray_to_geojson(poly->rings[j], ptr, precision);
-			ptr += sprintf(ptr, "]");
+			if (j) stringbuffer_append(sb, ",");
+			stringbuffer_append(sb, "[");
+			pointArray_to_geojson(poly->rings[j], precision, sb);
+			stringbuffer_append(sb, "]");
 		}
-		ptr += sprintf(ptr, "]");
+		stringbuffer_append(sb, "]");
 	}
-	ptr += sprintf(ptr, "]}");
-
-	return (ptr - output);
-}
-
-static char *
-asgeojson_multipolygon(const LWMPOLY *mpoly, char *srs, GBOX *bbox, int precision)
-{
-	char *output;
-	int size;
-
-	size = asgeojson_multipolygon_size(mpoly, srs, bbox, precision);
-	output = lwalloc(size);
-	asgeojson_multipolygon_buf(mpoly, srs, output, bbox, precision);
+	stringbuffer_append(sb, "]}");
 
-	return output;
+	return LW_SUCCESS;
 }
 
 
@@ -514,159 +264,64 @@ asgeojson_multipolygon(const LWMPOLY *mpoly, char *srs, GBOX *bbox, int precisio
  * Collection Geometry
  */
 
-static size_t
-asgeojson_collection_size(const LWCOLLECTION *col, char *srs, GBOX *bbox, int precision)
-{
-	int i;
-	int size;
-	LWGEOM *subgeom;
-
-	size = sizeof("{'type':'GeometryCollection',");
-	if (srs) size += asgeojson_srs_size(srs);
-	if (bbox) size += asgeojson_bbox_size(FLAGS_GET_Z(col->flags), precision);
-	size += sizeof("'geometries':");
-
-	for (i=0; i<col->ngeoms; i++)
-	{
-		subgeom = col->geoms[i];
-		size += asgeojson_geom_size(subgeom, NULL, precision);
-	}
-	size += sizeof(",") * i;
-	size += sizeof("]}");
-
-	return size;
-}
-
-static size_t
-asgeojson_collection_buf(const LWCOLLECTION *col, char *srs, char *output, GBOX *bbox, int precision)
+static int
+asgeojson_collection_sb(const LWCOLLECTION *col, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb)
 {
 	int i;
-	char *ptr=output;
-	LWGEOM *subgeom;
-
-	ptr += sprintf(ptr, "{\"type\":\"GeometryCollection\",");
-	if (srs) ptr += asgeojson_srs_buf(ptr, srs);
-	if (col->ngeoms && bbox) ptr += asgeojson_bbox_buf(ptr, bbox, FLAGS_GET_Z(col->flags), precision);
-	ptr += sprintf(ptr, "\"geometries\":[");
 
+	asgeojson_header_sb("GeometryCollection", col->flags, srs,
+	                    col->ngeoms ? bbox : NULL, precision, sb);
+	stringbuffer_append(sb, "\"geometries\":[");
 	for (i=0; i<col->ngeoms; i++)
 	{
-		if (i) ptr += sprintf(ptr, ",");
-		subgeom = col->geoms[i];
-		ptr += asgeojson_geom_buf(subgeom, ptr, NULL, precision);
+		if (i) stringbuffer_append(sb, ",");
+		asgeojson_geom_sb(col->geoms[i], NULL, NULL, precision, sb);
 	}
+	stringbuffer_append(sb, "]}");
 
-	ptr += sprintf(ptr, "]}");
-
-	return (ptr - output);
+	return LW_SUCCESS;
 }
 
-static char *
-asgeojson_collection(const LWCOLLECTION *col, char *srs, GBOX *bbox, int precision)
-{
-	char *output;
-	int size;
-
-	size = asgeojson_collection_size(col, srs, bbox, precision);
-	output = lwalloc(size);
-	asgeojson_collection_buf(col, srs, output, bbox, precision);
 
-	return output;
-}
 
-
-
-static size_t
-asgeojson_geom_size(const LWGEOM *geom, GBOX *bbox, int precision)
+static int
+asgeojson_geom_sb(const LWGEOM *geom, char *srs, GBOX *bbox, int precision, stringbuffer_t *sb)
 {
-	int type = geom->type;
-	size_t size = 0;
-
-	switch (type)
+	switch (geom->type)
 	{
 	case POINTTYPE:
-		size = asgeojson_point_size((LWPOINT*)geom, NULL, bbox, precision);
-		break;
+		return asgeojson_point_sb((LWPOINT*)geom, srs, bbox, precision, sb);
 
 	case LINETYPE:
-		size = asgeojson_line_size((LWLINE*)geom, NULL, bbox, precision);
-		break;
+		return asgeojson_line_sb((LWLINE*)geom, srs, bbox, precision, sb);
 
 	case POLYGONTYPE:
-		size = asgeojson_poly_size((LWPOLY*)geom, NULL, bbox, precision);
-		break;
+		return asgeojson_poly_sb((LWPOLY*)geom, srs, bbox, precision, sb);
 
 	case MULTIPOINTTYPE:
-		size = asgeojson_multipoint_size((LWMPOINT*)geom, NULL, bbox, precision);
-		break;
+		return asgeojson_multipoint_sb((LWMPOINT*)geom, srs, bbox, precision, sb);
 
 	case MULTILINETYPE:
-		size = asgeojson_multiline_size((LWMLINE*)geom, NULL, bbox, precision);
-		break;
+		return asgeojson_multiline_sb((LWMLINE*)geom, srs, bbox, precision, sb);
 
 	case MULTIPOLYGONTYPE:
-		size = asgeojson_multipolygon_size((LWMPOLY*)geom, NULL, bbox, precision);
-		break;
+		return asgeojson_multipolygon_sb((LWMPOLY*)geom, srs, bbox, precision, sb);
 
 	default:
 		lwerror("GeoJson: geometry not supported.");
 	}
 
-	return size;
+	return LW_FAILURE;
 }
 
 
-static size_t
-asgeojson_geom_buf(const LWGEOM *geom, char *output, GBOX *bbox, int precision)
-{
-	int type = geom->type;
-	char *ptr=output;
-
-	switch (type)
-	{
-	case POINTTYPE:
-		ptr += asgeojson_point_buf((LWPOINT*)geom, NULL, ptr, bbox, precision);
-		break;
-
-	case LINETYPE:
-		ptr += asgeojson_line_buf((LWLINE*)geom, NULL, ptr, bbox, precision);
-		break;
-
-	case POLYGONTYPE:
-		ptr += asgeojson_poly_buf((LWPOLY*)geom, NULL, ptr, bbox, precision);
-		break;
-
-	case MULTIPOINTTYPE:
-		ptr += asgeojson_multipoint_buf((LWMPOINT*)geom, NULL, ptr, bbox, precision);
-		break;
-
-	case MULTILINETYPE:
-		ptr += asgeojson_multiline_buf((LWMLINE*)geom, NULL, ptr, bbox, precision);
-		break;
-
-	case MULTIPOLYGONTYPE:
-		ptr += asgeojson_multipolygon_buf((LWMPOLY*)geom, NULL, ptr, bbox, precision);
-		break;
-
-	default:
-		if (bbox) lwfree(bbox);
-		lwerror("GeoJson: geometry not supported.");
-	}
-
-	return (ptr-output);
-}
-
-
-static size_t
-pointArray_to_geojson(POINTARRAY *pa, char *output, int precision)
+static void
+pointArray_to_geojson(const POINTARRAY *pa, int precision, stringbuffer_t *sb)
 {
 	int i;
-	char *ptr;
-	char x[OUT_MAX_DIGS_DOUBLE+OUT_MAX_DOUBLE_PRECISION+1];
-	char y[OUT_MAX_DIGS_DOUBLE+OUT_MAX_DOUBLE_PRECISION+1];
-	char z[OUT_MAX_DIGS_DOUBLE+OUT_MAX_DOUBLE_PRECISION+1];
-
-	ptr = output;
+	char x[OUT_DOUBLE_BUFFER_SIZE];
+	char y[OUT_DOUBLE_BUFFER_SIZE];
+	char z[OUT_DOUBLE_BUFFER_SIZE];
 
 	if (!FLAGS_GET_Z(pa->flags))
 	{
@@ -675,20 +330,11 @@ pointArray_to_geojson(POINTARRAY *pa, char *output, int precision)
 			POINT2D pt;
 			getPoint2d_p(pa, i, &pt);
 
-			if (fabs(pt.x) < OUT_MAX_DOUBLE)
-				sprintf(x, "%.*f", precision, pt.x);
-			else
-				sprintf(x, "%g", pt.x);
-			trim_trailing_zeros(x);
+			lwprint_double(pt.x, precision, x, OUT_DOUBLE_BUFFER_SIZE);
 
-			if (fabs(pt.y) < OUT_MAX_DOUBLE)
-				sprintf(y, "%.*f", precision, pt.y);
-			else
-				sprintf(y, "%g", pt.y);
-			trim_trailing_zeros(y);
+			lwprint_double(pt.y, precision, y, OUT_DOUBLE_BUFFER_SIZE);
 
-			if ( i ) ptr += sprintf(ptr, ",");
-			ptr += sprintf(ptr, "[%s,%s]", x, y);
+			stringbuffer_aprintf(sb, i ? ",[%s,%s]" : "[%s,%s]", x, y);
 		}
 	}
 	else
@@ -698,44 +344,13 @@ pointArray_to_geojson(POINTARRAY *pa, char *output, int precision)
 			POINT4D pt;
 			getPoint4d_p(pa, i, &pt);
 
-			if (fabs(pt.x) < OUT_MAX_DOUBLE)
-				sprintf(x, "%.*f", precision, pt.x);
-			else
-				sprintf(x, "%g", pt.x);
-			trim_trailing_zeros(x);
-
-			if (fabs(pt.y) < OUT_MAX_DOUBLE)
-				sprintf(y, "%.*f", precision, pt.y);
-			else
-				sprintf(y, "%g", pt.y);
-			trim_trailing_zeros(y);
-
-			if (fabs(pt.z) < OUT_MAX_DOUBLE)
-				sprintf(z, "%.*f", precision, pt.z);
-			else
-				sprintf(z, "%g", pt.z);
-			trim_trailing_zeros(z);
-
-			if ( i ) ptr += sprintf(ptr, ",");
-			ptr += sprintf(ptr, "[%s,%s,%s]", x, y, z);
-		}
-	}
-
-	return (ptr-output);
-}
-
+			lwprint_double(pt.x, precision, x, OUT_DOUBLE_BUFFER_SIZE);
 
+			lwprint_double(pt.y, precision, y, OUT_DOUBLE_BUFFER_SIZE);
 
-/**
- * Returns maximum size of rendered pointarray in bytes.
- */
-static size_t
-pointArray_geojson_size(POINTARRAY *pa, int precision)
-{
-	if (FLAGS_NDIMS(pa->flags) == 2)
-		return (OUT_MAX_DIGS_DOUBLE + precision + sizeof(","))
-		       * 2 * pa->npoints + sizeof(",[]");
+			lwprint_double(pt.z, precision, z, OUT_DOUBLE_BUFFER_SIZE);
 
-	return (OUT_MAX_DIGS_DOUBLE + precision + sizeof(",,"))
-	       * 3 * pa->npoints + sizeof(",[]");
+			stringbuffer_aprintf(sb, i ? ",[%s,%s,%s]" : "[%s,%s,%s]", x, y, z);
+		}
+	}
 }
@@ -0,0 +1,343 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/**
+* @file
+* Geometry encoding for Mapbox Vector Tiles (version 2 of the spec).
+*
+* A tile geometry is a list of command integers, (id & 0x7) | (count << 3),
+* each followed by count pairs of zig-zag encoded X/Y offsets from the
+* previous cursor position. The cursor starts at 0,0 for each feature and
+* carries across the parts of a multi-geometry. Tile space has its origin
+* in the top left corner, with Y growing downwards, so exterior rings must
+* have a positive area there and interior rings a negative one.
+*/
+
+#include "liblwgeom_internal.h"
+#include "lwgeom_log.h"
+#include "bytebuffer.h"
+
+#include <math.h>
+
+/* Command ids */
+#define MVT_CMD_MOVETO 1
+#define MVT_CMD_LINETO 2
+#define MVT_CMD_CLOSEPATH 7
+
+/**
+* Used for passing the encoding state between the writing functions.
+*/
+typedef struct
+{
+	bytebuffer_t *buf;   /* Output command integers */
+	double xmin;         /* Tile bounds, in map units */
+	double ymax;
+	double xscale;       /* Tile units per map unit */
+	double yscale;
+	int64_t cursor_x;    /* Last position written, in tile units */
+	int64_t cursor_y;
+}
+mvt_state;
+
+static inline void mvt_command(mvt_state *s, uint32_t id, uint32_t count)
+{
+	bytebuffer_append_uvarint(s->buf, (uint64_t)((id & 0x7) | (count << 3)));
+}
+
+static inline void mvt_point(mvt_state *s, const POINT2D *pt)
+{
+	int64_t x = (int64_t)pt->x;
+	int64_t y = (int64_t)pt->y;
+	bytebuffer_append_varint(s->buf, x - s->cursor_x);
+	bytebuffer_append_varint(s->buf, y - s->cursor_y);
+	s->cursor_x = x;
+	s->cursor_y = y;
+}
+
+/*
+* Snap a point array onto the tile grid and drop the vertices that
+* land on the one before. Returns a new 2D array.
+*/
+static POINTARRAY* ptarray_to_mvt_grid(const POINTARRAY *pa, const mvt_state *s)
+{
+	POINTARRAY *snapped = ptarray_construct(0, 0, pa->npoints);
+	POINTARRAY *deduped;
+	POINT2D pt;
+	POINT4D p4d;
+	int i;
+
+	p4d.z = p4d.m = 0.0;
+	for ( i = 0; i < pa->npoints; i++ )
+	{
+		getPoint2d_p(pa, i, &pt);
+		p4d.x = floor((pt.x - s->xmin) * s->xscale + 0.5);
+		p4d.y = floor((s->ymax - pt.y) * s->yscale + 0.5);
+		ptarray_set_point4d(snapped, i, &p4d);
+	}
+
+	deduped = ptarray_remove_repeated_points(snapped);
+	ptarray_free(snapped);
+	return deduped;
+}
+
+/*
+* Twice the signed area of a ring, positive when it runs clockwise
+* on screen (Y down).
+*/
+static double ptarray_mvt_area(const POINTARRAY *pa)
+{
+	double area = 0.0;
+	POINT2D p1, p2;
+	int i;
+
+	for ( i = 0; i < pa->npoints - 1; i++ )
+	{
+		getPoint2d_p(pa, i, &p1);
+		getPoint2d_p(pa, i+1, &p2);
+		area += p1.x * p2.y - p2.x * p1.y;
+	}
+	return area;
+}
+
+static int lwpoint_count_mvt(const LWGEOM *geom)
+{
+	if ( geom->type == POINTTYPE )
+		return lwpoint_is_empty((LWPOINT*)geom) ? 0 : 1;
+	else
+	{
+		const LWCOLLECTION *col = (LWCOLLECTION*)geom;
+		int i, count = 0;
+		for ( i = 0; i < col->ngeoms; i++ )
+			count += lwpoint_count_mvt(col->geoms[i]);
+		return count;
+	}
+}
+
+static void lwpoint_to_mvt_buf(const LWGEOM *geom, mvt_state *s)
+{
+	if ( geom->type == POINTTYPE )
+	{
+		const LWPOINT *point = (LWPOINT*)geom;
+		POINTARRAY *pa;
+		POINT2D pt;
+
+		if ( lwpoint_is_empty(point) )
+			return;
+
+		pa = ptarray_to_mvt_grid(point->point, s);
+		getPoint2d_p(pa, 0, &pt);
+		mvt_point(s, &pt);
+		ptarray_free(pa);
+	}
+	else
+	{
+		const LWCOLLECTION *col = (LWCOLLECTION*)geom;
+		int i;
+		for ( i = 0; i < col->ngeoms; i++ )
+			lwpoint_to_mvt_buf(col->geoms[i], s);
+	}
+}
+
+/* Returns the number of parts written */
+static int lwline_to_mvt_buf(const LWLINE *line, mvt_state *s)
+{
+	POINTARRAY *pa;
+	POINT2D p1, p2;
+	int i;
+
+	if ( lwline_is_empty(line) )
+		return 0;
+
+	pa = ptarray_to_mvt_grid(line->points, s);
+
+	/* Collapsed onto a single grid cell */
+	getPoint2d_p(pa, 0, &p1);
+	getPoint2d_p(pa, pa->npoints - 1, &p2);
+	if ( pa->npoints < 2 || (pa->npoints == 2 && p1.x == p2.x && p1.y == p2.y) )
+	{
+		ptarray_free(pa);
+		return 0;
+	}
+
+	mvt_command(s, MVT_CMD_MOVETO, 1);
+	mvt_point(s, &p1);
+	mvt_command(s, MVT_CMD_LINETO, pa->npoints - 1);
+	for ( i = 1; i < pa->npoints; i++ )
+	{
+		getPoint2d_p(pa, i, &p1);
+		mvt_point(s, &p1);
+	}
+
+	ptarray_free(pa);
+	return 1;
+}
+
+/* Returns the number of parts written */
+static int lwpoly_to_mvt_buf(const LWPOLY *poly, mvt_state *s)
+{
+	POINT2D pt;
+	int i, j;
+
+	for ( i = 0; i < poly->nrings; i++ )
+	{
+		POINTARRAY *pa = ptarray_to_mvt_grid(poly->rings[i], s);
+		double area = ptarray_mvt_area(pa);
+
+		/* Rings that collapse are left out, and holes go with their shell */
+		if ( pa->npoints < 4 || area == 0.0 )
+		{
+			ptarray_free(pa);
+			if ( i == 0 )
+				return 0;
+			continue;
+		}
+
+		/* Shells run clockwise on screen, holes anticlockwise */
+		if ( (i == 0) != (area > 0) )
+			ptarray_reverse(pa);
+
+		/* The closing point is implied by ClosePath */
+		getPoint2d_p(pa, 0, &pt);
+		mvt_command(s, MVT_CMD_MOVETO, 1);
+		mvt_point(s, &pt);
+		mvt_command(s, MVT_CMD_LINETO, pa->npoints - 2);
+		for ( j = 1; j < pa->npoints - 1; j++ )
+		{
+			getPoint2d_p(pa, j, &pt);
+			mvt_point(s, &pt);
+		}
+		mvt_command(s, MVT_CMD_CLOSEPATH, 1);
+
+		ptarray_free(pa);
+	}
+	return 1;
+}
+
+static int lwgeom_to_mvt_buf(const LWGEOM *geom, mvt_state *s)
+{
+	int i, parts = 0;
+
+	switch ( geom->type )
+	{
+	case POINTTYPE:
+	case MULTIPOINTTYPE:
+		parts = lwpoint_count_mvt(geom);
+		if ( parts )
+		{
+			mvt_command(s, MVT_CMD_MOVETO, parts);
+			lwpoint_to_mvt_buf(geom, s);
+		}
+		return parts;
+	case LINETYPE:
+		return lwline_to_mvt_buf((LWLINE*)geom, s);
+	case POLYGONTYPE:
+		return lwpoly_to_mvt_buf((LWPOLY*)geom, s);
+	case MULTILINETYPE:
+	case MULTIPOLYGONTYPE:
+	{
+		const LWCOLLECTION *col = (LWCOLLECTION*)geom;
+		for ( i = 0; i < col->ngeoms; i++ )
+			parts += lwgeom_to_mvt_buf(col->geoms[i], s);
+		return parts;
+	}
+	default:
+		lwerror("Unsupported geometry type: %s [%d]", lwtype_name(geom->type), geom->type);
+	}
+	return 0;
+}
+
+/**
+* Encode a geometry as the command integers of a vector tile feature.
+* Caller is responsible for freeing the returned array.
+*
+* Coordinates are mapped from @a bounds onto a grid of @a extent by
+* @a extent tile units, and vertices that snap onto the one before
+* are dropped. Geometries whose box lies further than @a buffer tile
+* units outside the tile, or that collapse entirely, give NULL.
+* Curves are stroked, and collections are only accepted when they
+* can be made homogeneous.
+*
+* @param mvt_type returns MVT_POINT, MVT_LINESTRING or MVT_POLYGON
+* @param size returns the size of the output
+*/
+uint8_t* lwgeom_to_mvt_geom(const LWGEOM *geom, const GBOX *bounds, uint32_t extent, uint32_t buffer,
+                            uint8_t *mvt_type, size_t *size)
+{
+	mvt_state s;
+	GBOX box;
+	LWGEOM *tmp = NULL;
+	uint8_t *result = NULL;
+	int parts;
+
+	*mvt_type = 0;
+	*size = 0;
+
+	if ( bounds->xmax <= bounds->xmin || bounds->ymax <= bounds->ymin || extent == 0 )
+	{
+		lwerror("lwgeom_to_mvt_geom: tile bounds and extent must not be empty");
+		return NULL;
+	}
+
+	if ( lwgeom_is_empty(geom) || lwgeom_calculate_gbox(geom, &box) != LW_SUCCESS )
+		return NULL;
+
+	s.xmin = bounds->xmin;
+	s.ymax = bounds->ymax;
+	s.xscale = extent / (bounds->xmax - bounds->xmin);
+	s.yscale = extent / (bounds->ymax - bounds->ymin);
+	s.cursor_x = s.cursor_y = 0;
+
+	/* Nothing to draw in this tile */
+	if ( (box.xmax - s.xmin) * s.xscale < -(double)buffer ||
+	     (box.xmin - s.xmin) * s.xscale > (double)(extent + buffer) ||
+	     (s.ymax - box.ymin) * s.yscale < -(double)buffer ||
+	     (s.ymax - box.ymax) * s.yscale > (double)(extent + buffer) )
+		return NULL;
+
+	if ( lwgeom_has_arc(geom) )
+		geom = tmp = lwgeom_segmentize((LWGEOM*)geom, 32);
+
+	if ( geom->type == COLLECTIONTYPE )
+	{
+		LWGEOM *homog = lwgeom_homogenize(geom);
+		if ( tmp ) lwgeom_free(tmp);
+		geom = tmp = homog;
+		if ( geom->type == COLLECTIONTYPE )
+		{
+			lwgeom_free(tmp);
+			return NULL;
+		}
+	}
+
+	s.buf = bytebuffer_create();
+	parts = lwgeom_to_mvt_buf(geom, &s);
+	if ( parts )
+	{
+		switch ( geom->type )
+		{
+		case POINTTYPE:
+		case MULTIPOINTTYPE:
+			*mvt_type = MVT_POINT;
+			break;
+		case LINETYPE:
+		case MULTILINETYPE:
+			*mvt_type = MVT_LINESTRING;
+			break;
+		default:
+			*mvt_type = MVT_POLYGON;
+		}
+		result = bytebuffer_get_buffer_copy(s.buf, size);
+	}
+
+	bytebuffer_destroy(s.buf);
+	if ( tmp ) lwgeom_free(tmp);
+	return result;
+}
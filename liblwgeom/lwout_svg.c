@@ -20,28 +20,30 @@
 **********************************************************************/
 
 #include "liblwgeom_internal.h"
+#include "stringbuffer.h"
 
-static char * assvg_point(const LWPOINT *point, int relative, int precision);
-static char * assvg_line(const LWLINE *line, int relative, int precision);
-static char * assvg_polygon(const LWPOLY *poly, int relative, int precision);
-static char * assvg_multipoint(const LWMPOINT *mpoint, int relative, int precision);
-static char * assvg_multiline(const LWMLINE *mline, int relative, int precision);
-static char * assvg_multipolygon(const LWMPOLY *mpoly, int relative, int precision);
-static char * assvg_collection(const LWCOLLECTION *col, int relative, int precision);
+static void assvg_point_sb(const LWPOINT *point, int relative, int precision, stringbuffer_t *sb);
+static void assvg_line_sb(const LWLINE *line, int relative, int precision, stringbuffer_t *sb);
+static void assvg_polygon_sb(const LWPOLY *poly, int relative, int precision, stringbuffer_t *sb);
+static void assvg_multipoint_sb(const LWMPOINT *mpoint, int relative, int precision, stringbuffer_t *sb);
+static void assvg_multiline_sb(const LWMLINE *mline, int relative, int precision, stringbuffer_t *sb);
+static void assvg_multipolygon_sb(const LWMPOLY *mpoly, int relative, int precision, stringbuffer_t *sb);
+static void assvg_collection_sb(const LWCOLLECTION *col, int relative, int precision, stringbuffer_t *sb);
 
-static size_t assvg_geom_size(const LWGEOM *geom, int relative, int precision);
-static size_t assvg_geom_buf(const LWGEOM *geom, char *output, int relative, int precision);
-static size_t pointArray_svg_size(POINTARRAY *pa, int precision);
-static size_t pointArray_svg_rel(POINTARRAY *pa, char * output, int close_ring, int precision);
-static size_t pointArray_svg_abs(POINTARRAY *pa, char * output, int close_ring, int precision);
+static void assvg_geom_sb(const LWGEOM *geom, int relative, int precision, stringbuffer_t *sb);
+static void pointArray_svg_rel(POINTARRAY *pa, int close_ring, int precision, stringbuffer_t *sb);
+static void pointArray_svg_abs(POINTARRAY *pa, int close_ring, int precision, stringbuffer_t *sb);
 
 
 /**
  * Takes a GEOMETRY and returns a SVG representation
+ *
+ * Output is written in a single pass into a growing stringbuffer_t.
  */
 char *
 lwgeom_to_svg(const LWGEOM *geom, int precision, int relative)
 {
+	stringbuffer_t *sb;
 	char *ret = NULL;
 	int type = geom->type;
 
@@ -52,36 +54,43 @@ lwgeom_to_svg(const LWGEOM *geom, int precision, int relative)
 		ret[0] = '\0';
 		return ret;
 	}
-	
+
+	sb = stringbuffer_create();
+
 	switch (type)
 	{
 	case POINTTYPE:
-		ret = assvg_point((LWPOINT*)geom, relative, precision);
+		assvg_point_sb((LWPOINT*)geom, relative, precision, sb);
 		break;
 	case LINETYPE:
-		ret = assvg_line((LWLINE*)geom, relative, precision);
+		assvg_line_sb((LWLINE*)geom, relative, precision, sb);
 		break;
 	case POLYGONTYPE:
-		ret = assvg_polygon((LWPOLY*)geom, relative, precision);
+		assvg_polygon_sb((LWPOLY*)geom, relative, precision, sb);
 		break;
 	case MULTIPOINTTYPE:
-		ret = assvg_multipoint((LWMPOINT*)geom, relative, precision);
+		assvg_multipoint_sb((LWMPOINT*)geom, relative, precision, sb);
 		break;
 	case MULTILINETYPE:
-		ret = assvg_multiline((LWMLINE*)geom, relative, precision);
+		assvg_multiline_sb((LWMLINE*)geom, relative, precision, sb);
 		break;
 	case MULTIPOLYGONTYPE:
-		ret = assvg_multipolygon((LWMPOLY*)geom, relative, precision);
+		assvg_multipolygon_sb((LWMPOLY*)geom, relative, precision, sb);
 		break;
 	case COLLECTIONTYPE:
-		ret = assvg_collection((LWCOLLECTION*)geom, relative, precision);
+		assvg_collection_sb((LWCOLLECTION*)geom, relative, precision, sb);
 		break;
 
 	default:
+		stringbuffer_destroy(sb);
 		lwerror("lwgeom_to_svg: '%s' geometry type not supported",
 		        lwtype_name(type));
+		return NULL;
 	}
 
+	ret = stringbuffer_getstringcopy(sb);
+	stringbuffer_destroy(sb);
+
 	return ret;
 }
 
@@ -90,58 +99,20 @@ lwgeom_to_svg(const LWGEOM *geom, int precision, int relative)
  * Point Geometry
  */
 
-static size_t
-assvg_point_size(const LWPOINT *point, int circle, int precision)
-{
-	size_t size;
-
-	size = (OUT_MAX_DIGS_DOUBLE + precision) * 2;
-	if (circle) size += sizeof("cx='' cy=''");
-	else size += sizeof("x='' y=''");
-
-	return size;
-}
-
-static size_t
-assvg_point_buf(const LWPOINT *point, char * output, int circle, int precision)
+static void
+assvg_point_sb(const LWPOINT *point, int circle, int precision, stringbuffer_t *sb)
 {
-	char *ptr=output;
-	char x[OUT_MAX_DIGS_DOUBLE+OUT_MAX_DOUBLE_PRECISION+1];
-	char y[OUT_MAX_DIGS_DOUBLE+OUT_MAX_DOUBLE_PRECISION+1];
+	char x[OUT_DOUBLE_BUFFER_SIZE];
+	char y[OUT_DOUBLE_BUFFER_SIZE];
 	POINT2D pt;
 
 	getPoint2d_p(point->point, 0, &pt);
-
-	if (fabs(pt.x) < OUT_MAX_DOUBLE)
-		sprintf(x, "%.*f", precision, pt.x);
-	else
-		sprintf(x, "%g", pt.x);
-	trim_trailing_zeros(x);
-
+	lwprint_double(pt.x, precision, x, OUT_DOUBLE_BUFFER_SIZE);
 	/* SVG Y axis is reversed, an no need to transform 0 into -0 */
-	if (fabs(pt.y) < OUT_MAX_DOUBLE)
-		sprintf(y, "%.*f", precision, fabs(pt.y) ? pt.y * -1 : pt.y);
-	else
-		sprintf(y, "%g", fabs(pt.y) ? pt.y * -1 : pt.y);
-	trim_trailing_zeros(y);
-
-	if (circle) ptr += sprintf(ptr, "x=\"%s\" y=\"%s\"", x, y);
-	else ptr += sprintf(ptr, "cx=\"%s\" cy=\"%s\"", x, y);
-
-	return (ptr-output);
-}
-
-static char *
-assvg_point(const LWPOINT *point, int circle, int precision)
-{
-	char *output;
-	int size;
+	lwprint_double(fabs(pt.y) ? pt.y * -1 : pt.y, precision, y, OUT_DOUBLE_BUFFER_SIZE);
 
-	size = assvg_point_size(point, circle, precision);
-	output = lwalloc(size);
-	assvg_point_buf(point, output, circle, precision);
-
-	return output;
+	if (circle) stringbuffer_aprintf(sb, "x=\"%s\" y=\"%s\"", x, y);
+	else stringbuffer_aprintf(sb, "cx=\"%s\" cy=\"%s\"", x, y);
 }
 
 
@@ -149,43 +120,15 @@ assvg_point(const LWPOINT *point, int circle, int precision)
  * Line Geometry
  */
 
-static size_t
-assvg_line_size(const LWLINE *line, int relative, int precision)
-{
-	size_t size;
-
-	size = sizeof("M ");
-	size += pointArray_svg_size(line->points, precision);
-
-	return size;
-}
-
-static size_t
-assvg_line_buf(const LWLINE *line, char * output, int relative, int precision)
+static void
+assvg_line_sb(const LWLINE *line, int relative, int precision, stringbuffer_t *sb)
 {
-	char *ptr=output;
-
 	/* Start path with SVG MoveTo */
-	ptr += sprintf(ptr, "M ");
+	stringbuffer_append(sb, "M ");
 	if (relative)
-		ptr += pointArray_svg_rel(line->points, ptr, 1, precision);
+		pointArray_svg_rel(line->points, 1, precision, sb);
 	else
-		ptr += pointArray_svg_abs(line->points, ptr, 1, precision);
-
-	return (ptr-output);
-}
-
-static char *
-assvg_line(const LWLINE *line, int relative, int precision)
-{
-	char *output;
-	int size;
-
-	size = assvg_line_size(line, relative, precision);
-	output = lwalloc(size);
-	assvg_line_buf(line, output, relative, precision);
-
-	return output;
+		pointArray_svg_abs(line->points, 1, precision, sb);
 }
 
 
@@ -193,56 +136,27 @@ assvg_line(const LWLINE *line, int relative, int precision)
  * Polygon Geometry
  */
 
-static size_t
-assvg_polygon_size(const LWPOLY *poly, int relative, int precision)
-{
-	int i;
-	size_t size=0;
-
-	for (i=0; i<poly->nrings; i++)
-		size += pointArray_svg_size(poly->rings[i], precision) + sizeof(" ");
-	size += sizeof("M  Z") * poly->nrings;
-
-	return size;
-}
-
-static size_t
-assvg_polygon_buf(const LWPOLY *poly, char * output, int relative, int precision)
+static void
+assvg_polygon_sb(const LWPOLY *poly, int relative, int precision, stringbuffer_t *sb)
 {
 	int i;
-	char *ptr=output;
 
 	for (i=0; i<poly->nrings; i++)
 	{
-		if (i) ptr += sprintf(ptr, " ");	/* Space beetween each ring */
-		ptr += sprintf(ptr, "M ");		/* Start path with SVG MoveTo */
+		if (i) stringbuffer_append(sb, " ");	/* Space beetween each ring */
+		stringbuffer_append(sb, "M ");		/* Start path with SVG MoveTo */
 
 		if (relative)
 		{
-			ptr += pointArray_svg_rel(poly->rings[i], ptr, 0, precision);
-			ptr += sprintf(ptr, " z");	/* SVG closepath */
+			pointArray_svg_rel(poly->rings[i], 0, precision, sb);
+			stringbuffer_append(sb, " z");	/* SVG closepath */
 		}
 		else
 		{
-			ptr += pointArray_svg_abs(poly->rings[i], ptr, 0, precision);
-			ptr += sprintf(ptr, " Z");	/* SVG closepath */
+			pointArray_svg_abs(poly->rings[i], 0, precision, sb);
+			stringbuffer_append(sb, " Z");	/* SVG closepath */
 		}
 	}
-
-	return (ptr-output);
-}
-
-static char *
-assvg_polygon(const LWPOLY *poly, int relative, int precision)
-{
-	char *output;
-	int size;
-
-	size = assvg_polygon_size(poly, relative, precision);
-	output = lwalloc(size);
-	assvg_polygon_buf(poly, output, relative, precision);
-
-	return output;
 }
 
 
@@ -250,51 +164,16 @@ assvg_polygon(const LWPOLY *poly, int relative, int precision)
  * Multipoint Geometry
  */
 
-static size_t
-assvg_multipoint_size(const LWMPOINT *mpoint, int relative, int precision)
-{
-	const LWPOINT *point;
-	size_t size=0;
-	int i;
-
-	for (i=0 ; i<mpoint->ngeoms ; i++)
-	{
-		point = mpoint->geoms[i];
-		size += assvg_point_size(point, relative, precision);
-	}
-	size += sizeof(",") * --i;  /* Arbitrary comma separator */
-
-	return size;
-}
-
-static size_t
-assvg_multipoint_buf(const LWMPOINT *mpoint, char *output, int relative, int precision)
+static void
+assvg_multipoint_sb(const LWMPOINT *mpoint, int relative, int precision, stringbuffer_t *sb)
 {
-	const LWPOINT *point;
 	int i;
-	char *ptr=output;
 
 	for (i=0 ; i<mpoint->ngeoms ; i++)
 	{
-		if (i) ptr += sprintf(ptr, ",");  /* Arbitrary comma separator */
-		point = mpoint->geoms[i];
-		ptr += assvg_point_buf(point, ptr, relative, precision);
+		if (i) stringbuffer_append(sb, ",");  /* Arbitrary comma separator */
+		assvg_point_sb(mpoint->geoms[i], relative, precision, sb);
 	}
-
-	return (ptr-output);
-}
-
-static char *
-assvg_multipoint(const LWMPOINT *mpoint, int relative, int precision)
-{
-	char *output;
-	int size;
-
-	size = assvg_multipoint_size(mpoint, relative, precision);
-	output = lwalloc(size);
-	assvg_multipoint_buf(mpoint, output, relative, precision);
-
-	return output;
 }
 
 
@@ -302,51 +181,16 @@ assvg_multipoint(const LWMPOINT *mpoint, int relative, int precision)
  * Multiline Geometry
  */
 
-static size_t
-assvg_multiline_size(const LWMLINE *mline, int relative, int precision)
+static void
+assvg_multiline_sb(const LWMLINE *mline, int relative, int precision, stringbuffer_t *sb)
 {
-	const LWLINE *line;
-	size_t size=0;
 	int i;
 
 	for (i=0 ; i<mline->ngeoms ; i++)
 	{
-		line = mline->geoms[i];
-		size += assvg_line_size(line, relative, precision);
+		if (i) stringbuffer_append(sb, " ");  /* SVG whitespace Separator */
+		assvg_line_sb(mline->geoms[i], relative, precision, sb);
 	}
-	size += sizeof(" ") * --i;   /* SVG whitespace Separator */
-
-	return size;
-}
-
-static size_t
-assvg_multiline_buf(const LWMLINE *mline, char *output, int relative, int precision)
-{
-	const LWLINE *line;
-	int i;
-	char *ptr=output;
-
-	for (i=0 ; i<mline->ngeoms ; i++)
-	{
-		if (i) ptr += sprintf(ptr, " ");  /* SVG whitespace Separator */
-		line = mline->geoms[i];
-		ptr += assvg_line_buf(line, ptr, relative, precision);
-	}
-
-	return (ptr-output);
-}
-
-static char *
-assvg_multiline(const LWMLINE *mline, int relative, int precision)
-{
-	char *output;
-	int size;
-
-	size = assvg_multiline_size(mline, relative, precision);
-	output = lwalloc(size);
-	assvg_multiline_buf(mline, output, relative, precision);
-
-	return output;
 }
 
 
@@ -354,51 +198,16 @@ assvg_multiline(const LWMLINE *mline, int relative, int precision)
  * Multipolygon Geometry
  */
 
-static size_t
-assvg_multipolygon_size(const LWMPOLY *mpoly, int relative, int precision)
-{
-	const LWPOLY *poly;
-	size_t size=0;
-	int i;
-
-	for (i=0 ; i<mpoly->ngeoms ; i++)
-	{
-		poly = mpoly->geoms[i];
-		size += assvg_polygon_size(poly, relative, precision);
-	}
-	size += sizeof(" ") * --i;   /* SVG whitespace Separator */
-
-	return size;
-}
-
-static size_t
-assvg_multipolygon_buf(const LWMPOLY *mpoly, char *output, int relative, int precision)
+static void
+assvg_multipolygon_sb(const LWMPOLY *mpoly, int relative, int precision, stringbuffer_t *sb)
 {
-	const LWPOLY *poly;
 	int i;
-	char *ptr=output;
 
 	for (i=0 ; i<mpoly->ngeoms ; i++)
 	{
-		if (i) ptr += sprintf(ptr, " ");  /* SVG whitespace Separator */
-		poly = mpoly->geoms[i];
-		ptr += assvg_polygon_buf(poly, ptr, relative, precision);
+		if (i) stringbuffer_append(sb, " ");  /* SVG whitespace Separator */
+		assvg_polygon_sb(mpoly->geoms[i], relative, precision, sb);
 	}
-
-	return (ptr-output);
-}
-
-static char *
-assvg_multipolygon(const LWMPOLY *mpoly, int relative, int precision)
-{
-	char *output;
-	int size;
-
-	size = assvg_multipolygon_size(mpoly, relative, precision);
-	output = lwalloc(size);
-	assvg_multipolygon_buf(mpoly, output, relative, precision);
-
-	return output;
 }
 
 
@@ -406,173 +215,75 @@ assvg_multipolygon(const LWMPOLY *mpoly, int relative, int precision)
 * Collection Geometry
 */
 
-static size_t
-assvg_collection_size(const LWCOLLECTION *col, int relative, int precision)
-{
-	int i = 0;
-	size_t size=0;
-	const LWGEOM *subgeom;
-
-	for (i=0; i<col->ngeoms; i++)
-	{
-		subgeom = col->geoms[i];
-		size += assvg_geom_size(subgeom, relative, precision);
-	}
-
-	if ( i ) /* We have some geometries, so add space for delimiters. */
-		size += sizeof(";") * --i;
-
-	if (size == 0) size++; /* GEOMETRYCOLLECTION EMPTY, space for null terminator */
-
-	return size;
-}
-
-static size_t
-assvg_collection_buf(const LWCOLLECTION *col, char *output, int relative, int precision)
+static void
+assvg_collection_sb(const LWCOLLECTION *col, int relative, int precision, stringbuffer_t *sb)
 {
 	int i;
-	char *ptr=output;
-	const LWGEOM *subgeom;
-
-	/* EMPTY GEOMETRYCOLLECTION */
-	if (col->ngeoms == 0) *ptr = '\0';
 
 	for (i=0; i<col->ngeoms; i++)
 	{
-		if (i) ptr += sprintf(ptr, ";");
-		subgeom = col->geoms[i];
-		ptr += assvg_geom_buf(subgeom, ptr, relative, precision);
+		if (i) stringbuffer_append(sb, ";");
+		assvg_geom_sb(col->geoms[i], relative, precision, sb);
 	}
-
-	return (ptr - output);
-}
-
-static char *
-assvg_collection(const LWCOLLECTION *col, int relative, int precision)
-{
-	char *output;
-	int size;
-
-	size = assvg_collection_size(col, relative, precision);
-	output = lwalloc(size);
-	assvg_collection_buf(col, output, relative, precision);
-
-	return output;
 }
 
 
-static size_t
-assvg_geom_buf(const LWGEOM *geom, char *output, int relative, int precision)
+static void
+assvg_geom_sb(const LWGEOM *geom, int relative, int precision, stringbuffer_t *sb)
 {
-    int type = geom->type;
-	char *ptr=output;
-
-	switch (type)
-	{
-	case POINTTYPE:
-		ptr += assvg_point_buf((LWPOINT*)geom, ptr, relative, precision);
-		break;
-
-	case LINETYPE:
-		ptr += assvg_line_buf((LWLINE*)geom, ptr, relative, precision);
-		break;
-
-	case POLYGONTYPE:
-		ptr += assvg_polygon_buf((LWPOLY*)geom, ptr, relative, precision);
-		break;
-
-	case MULTIPOINTTYPE:
-		ptr += assvg_multipoint_buf((LWMPOINT*)geom, ptr, relative, precision);
-		break;
-
-	case MULTILINETYPE:
-		ptr += assvg_multiline_buf((LWMLINE*)geom, ptr, relative, precision);
-		break;
-
-	case MULTIPOLYGONTYPE:
-		ptr += assvg_multipolygon_buf((LWMPOLY*)geom, ptr, relative, precision);
-		break;
-
-	default:
-		lwerror("assvg_geom_buf: '%s' geometry type not supported.",
-		        lwtype_name(type));
-	}
-
-	return (ptr-output);
-}
-
-
-static size_t
-assvg_geom_size(const LWGEOM *geom, int relative, int precision)
-{
-    int type = geom->type;
-	size_t size = 0;
+	int type = geom->type;
 
 	switch (type)
 	{
 	case POINTTYPE:
-		size = assvg_point_size((LWPOINT*)geom, relative, precision);
+		assvg_point_sb((LWPOINT*)geom, relative, precision, sb);
 		break;
 
 	case LINETYPE:
-		size = assvg_line_size((LWLINE*)geom, relative, precision);
+		assvg_line_sb((LWLINE*)geom, relative, precision, sb);
 		break;
 
 	case POLYGONTYPE:
-		size = assvg_polygon_size((LWPOLY*)geom, relative, precision);
+		assvg_polygon_sb((LWPOLY*)geom, relative, precision, sb);
 		break;
 
 	case MULTIPOINTTYPE:
-		size = assvg_multipoint_size((LWMPOINT*)geom, relative, precision);
+		assvg_multipoint_sb((LWMPOINT*)geom, relative, precision, sb);
 		break;
 
 	case MULTILINETYPE:
-		size = assvg_multiline_size((LWMLINE*)geom, relative, precision);
+		assvg_multiline_sb((LWMLINE*)geom, relative, precision, sb);
 		break;
 
 	case MULTIPOLYGONTYPE:
-		size = assvg_multipolygon_size((LWMPOLY*)geom, relative, precision);
+		assvg_multipolygon_sb((LWMPOLY*)geom, relative, precision, sb);
 		break;
 
 	default:
-		lwerror("assvg_geom_size: '%s' geometry type not supported.",
+		lwerror("assvg_geom_sb: '%s' geometry type not supported.",
 		        lwtype_name(type));
 	}
-
-	return size;
 }
 
 
-static size_t
-pointArray_svg_rel(POINTARRAY *pa, char *output, int close_ring, int precision)
+static void
+pointArray_svg_rel(POINTARRAY *pa, int close_ring, int precision, stringbuffer_t *sb)
 {
 	int i, end;
-	char *ptr;
-	char x[OUT_MAX_DIGS_DOUBLE+OUT_MAX_DOUBLE_PRECISION+1];
-	char y[OUT_MAX_DIGS_DOUBLE+OUT_MAX_DOUBLE_PRECISION+1];
+	char x[OUT_DOUBLE_BUFFER_SIZE];
+	char y[OUT_DOUBLE_BUFFER_SIZE];
 	POINT2D pt, lpt;
 
-	ptr = output;
-
 	if (close_ring) end = pa->npoints;
 	else end = pa->npoints - 1;
 
 	/* Starting point */
 	getPoint2d_p(pa, 0, &pt);
 
-	if (fabs(pt.x) < OUT_MAX_DOUBLE)
-		sprintf(x, "%.*f", precision, pt.x);
-	else
-		sprintf(x, "%g", pt.x);
-	trim_trailing_zeros(x);
+	lwprint_double(pt.x, precision, x, OUT_DOUBLE_BUFFER_SIZE);
+	lwprint_double(fabs(pt.y) ? pt.y * -1 : pt.y, precision, y, OUT_DOUBLE_BUFFER_SIZE);
 
-	if (fabs(pt.y) < OUT_MAX_DOUBLE)
-		sprintf(y, "%.*f", precision, fabs(pt.y) ? pt.y * -1 : pt.y);
-	else
-		sprintf(y, "%g", fabs(pt.y) ? pt.y * -1 : pt.y);
-	trim_trailing_zeros(y);
-
-	ptr += sprintf(ptr,"%s %s l", x, y);
+	stringbuffer_aprintf(sb, "%s %s l", x, y);
 
 	/* All the following ones */
 	for (i=1 ; i < end ; i++)
@@ -580,42 +291,23 @@ pointArray_svg_rel(POINTARRAY *pa, char *output, int close_ring, int precision)
 		lpt = pt;
 
 		getPoint2d_p(pa, i, &pt);
-		if (fabs(pt.x -lpt.x) < OUT_MAX_DOUBLE)
-			sprintf(x, "%.*f", precision, pt.x -lpt.x);
-		else
-			sprintf(x, "%g", pt.x -lpt.x);
-		trim_trailing_zeros(x);
-
+		lwprint_double(pt.x -lpt.x, precision, x, OUT_DOUBLE_BUFFER_SIZE);
 		/* SVG Y axis is reversed, an no need to transform 0 into -0 */
-		if (fabs(pt.y -lpt.y) < OUT_MAX_DOUBLE)
-			sprintf(y, "%.*f", precision,
-			        fabs(pt.y -lpt.y) ? (pt.y - lpt.y) * -1: (pt.y - lpt.y));
-		else
-			sprintf(y, "%g",
-			        fabs(pt.y -lpt.y) ? (pt.y - lpt.y) * -1: (pt.y - lpt.y));
-		trim_trailing_zeros(y);
+		lwprint_double(fabs(pt.y -lpt.y) ? (pt.y - lpt.y) * -1: (pt.y - lpt.y), precision, y, OUT_DOUBLE_BUFFER_SIZE);
 
-		ptr += sprintf(ptr," %s %s", x, y);
+		stringbuffer_aprintf(sb, " %s %s", x, y);
 	}
-
-	return (ptr-output);
 }
 
 
-/**
- * Returns maximum size of rendered pointarray in bytes.
- */
-static size_t
-pointArray_svg_abs(POINTARRAY *pa, char *output, int close_ring, int precision)
+static void
+pointArray_svg_abs(POINTARRAY *pa, int close_ring, int precision, stringbuffer_t *sb)
 {
 	int i, end;
-	char *ptr;
-	char x[OUT_MAX_DIGS_DOUBLE+OUT_MAX_DOUBLE_PRECISION+1];
-	char y[OUT_MAX_DIGS_DOUBLE+OUT_MAX_DOUBLE_PRECISION+1];
+	char x[OUT_DOUBLE_BUFFER_SIZE];
+	char y[OUT_DOUBLE_BUFFER_SIZE];
 	POINT2D pt;
 
-	ptr = output;
-
 	if (close_ring) end = pa->npoints;
 	else end = pa->npoints - 1;
 
@@ -623,34 +315,12 @@ pointArray_svg_abs(POINTARRAY *pa, char *output, int close_ring, int precision)
 	{
 		getPoint2d_p(pa, i, &pt);
 
-		if (fabs(pt.x) < OUT_MAX_DOUBLE)
-			sprintf(x, "%.*f", precision, pt.x);
-		else
-			sprintf(x, "%g", pt.x);
-		trim_trailing_zeros(x);
-
+		lwprint_double(pt.x, precision, x, OUT_DOUBLE_BUFFER_SIZE);
 		/* SVG Y axis is reversed, an no need to transform 0 into -0 */
-		if (fabs(pt.y) < OUT_MAX_DOUBLE)
-			sprintf(y, "%.*f", precision, fabs(pt.y) ? pt.y * -1:pt.y);
-		else
-			sprintf(y, "%g", fabs(pt.y) ? pt.y * -1:pt.y);
-		trim_trailing_zeros(y);
+		lwprint_double(fabs(pt.y) ? pt.y * -1:pt.y, precision, y, OUT_DOUBLE_BUFFER_SIZE);
 
-		if (i == 1) ptr += sprintf(ptr, " L ");
-		else if (i) ptr += sprintf(ptr, " ");
-		ptr += sprintf(ptr,"%s %s", x, y);
+		if (i == 1) stringbuffer_append(sb, " L ");
+		else if (i) stringbuffer_append(sb, " ");
+		stringbuffer_aprintf(sb, "%s %s", x, y);
 	}
-
-	return (ptr-output);
-}
-
-
-/**
- * Returns maximum size of rendered pointarray in bytes.
- */
-static size_t
-pointArray_svg_size(POINTARRAY *pa, int precision)
-{
-	return (OUT_MAX_DIGS_DOUBLE + precision + sizeof(" "))
-	       * 2 * pa->npoints + sizeof(" L ");
 }
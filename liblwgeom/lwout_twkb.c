@@ -0,0 +1,413 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#include "lwout_twkb.h"
+
+#include <math.h>
+
+/**
+* Settings shared by a whole output run
+*/
+typedef struct
+{
+	uint8_t variant;     /* TWKB_BBOX, TWKB_SIZE */
+	int8_t prec_xy;
+	int8_t prec_z;
+	int8_t prec_m;
+	bytebuffer_t *ring;  /* Scratch space for point arrays */
+}
+twkb_globals;
+
+/**
+* State of one geometry being written, members of a collection get their own
+*/
+typedef struct
+{
+	const int64_t *idlist; /* Ids of the members, for a top level multi or collection */
+	int ndims;
+	int64_t accum[4];      /* Last vertex written, as integers */
+	int64_t bbox_min[4];
+	int64_t bbox_max[4];
+	int has_points;        /* Has anything gone into the box? */
+	double factor[4];      /* 10^precision for each ordinate in use */
+}
+twkb_state;
+
+static void lwgeom_to_twkb_buf(const LWGEOM *geom, twkb_globals *globals, const int64_t *idlist, bytebuffer_t *out);
+
+/*
+* Round half away from zero
+*/
+static inline int64_t twkb_round(double d)
+{
+	return (int64_t)(d < 0 ? ceil(d - 0.5) : floor(d + 0.5));
+}
+
+static uint8_t lwgeom_twkb_type(const LWGEOM *geom)
+{
+	switch ( geom->type )
+	{
+	case POINTTYPE:
+		return TWKB_POINT_TYPE;
+	case LINETYPE:
+		return TWKB_LINESTRING_TYPE;
+	case POLYGONTYPE:
+		return TWKB_POLYGON_TYPE;
+	case MULTIPOINTTYPE:
+		return TWKB_MULTIPOINT_TYPE;
+	case MULTILINETYPE:
+		return TWKB_MULTILINESTRING_TYPE;
+	case MULTIPOLYGONTYPE:
+		return TWKB_MULTIPOLYGON_TYPE;
+	case COLLECTIONTYPE:
+		return TWKB_GEOMETRYCOLLECTION_TYPE;
+	default:
+		lwerror("Unsupported geometry type: %s [%d]", lwtype_name(geom->type), geom->type);
+	}
+	return 0;
+}
+
+/*
+* Write the vertices of a point array as deltas. Vertices that round to
+* the same integers as the one before are dropped, as long as at least
+* minpoints remain. With minpoints == 0 every vertex is written and no
+* count is output.
+*/
+static void ptarray_to_twkb_buf(const POINTARRAY *pa, twkb_globals *globals, twkb_state *ts, int minpoints, bytebuffer_t *out)
+{
+	bytebuffer_t *b = out;
+	int ndims = ts->ndims;
+	int npoints = 0;
+	int dropped = 0;
+	int i, j;
+
+	/* Vertices go to scratch space first, as the count comes before them */
+	if ( minpoints )
+	{
+		b = globals->ring;
+		bytebuffer_clear(b);
+	}
+
+	for ( i = 0; i < pa->npoints; i++ )
+	{
+		double *dbl_ptr = (double*)getPoint_internal(pa, i);
+		int64_t val[4];
+		int64_t diff = 0;
+
+		for ( j = 0; j < ndims; j++ )
+		{
+			val[j] = twkb_round(dbl_ptr[j] * ts->factor[j]);
+			diff |= val[j] - ts->accum[j];
+		}
+
+		/* Nothing moved, skip it if we can spare it */
+		if ( minpoints && i > 0 && diff == 0 && pa->npoints - dropped - 1 >= minpoints )
+		{
+			dropped++;
+			continue;
+		}
+
+		for ( j = 0; j < ndims; j++ )
+		{
+			bytebuffer_append_varint(b, val[j] - ts->accum[j]);
+			ts->accum[j] = val[j];
+
+			if ( ! ts->has_points || val[j] < ts->bbox_min[j] )
+				ts->bbox_min[j] = val[j];
+			if ( ! ts->has_points || val[j] > ts->bbox_max[j] )
+				ts->bbox_max[j] = val[j];
+		}
+		ts->has_points = LW_TRUE;
+		npoints++;
+	}
+
+	if ( minpoints )
+	{
+		bytebuffer_append_uvarint(out, (uint64_t)npoints);
+		bytebuffer_append_bytebuffer(out, b);
+	}
+}
+
+static void lwpoint_to_twkb_buf(const LWPOINT *pt, twkb_globals *globals, twkb_state *ts, bytebuffer_t *out)
+{
+	if ( lwpoint_is_empty(pt) )
+		lwerror("TWKB cannot represent an empty point inside a multipoint");
+	ptarray_to_twkb_buf(pt->point, globals, ts, 0, out);
+}
+
+static void lwline_to_twkb_buf(const LWLINE *line, twkb_globals *globals, twkb_state *ts, bytebuffer_t *out)
+{
+	ptarray_to_twkb_buf(line->points, globals, ts, 2, out);
+}
+
+static void lwpoly_to_twkb_buf(const LWPOLY *poly, twkb_globals *globals, twkb_state *ts, bytebuffer_t *out)
+{
+	int i;
+
+	bytebuffer_append_uvarint(out, (uint64_t)poly->nrings);
+	for ( i = 0; i < poly->nrings; i++ )
+		ptarray_to_twkb_buf(poly->rings[i], globals, ts, 4, out);
+}
+
+static void lwmulti_to_twkb_buf(const LWCOLLECTION *col, twkb_globals *globals, twkb_state *ts, bytebuffer_t *out)
+{
+	int i;
+
+	bytebuffer_append_uvarint(out, (uint64_t)col->ngeoms);
+
+	if ( ts->idlist )
+		for ( i = 0; i < col->ngeoms; i++ )
+			bytebuffer_append_varint(out, ts->idlist[i]);
+
+	/* Members share the delta state, so they run on from each other */
+	for ( i = 0; i < col->ngeoms; i++ )
+	{
+		const LWGEOM *sub = col->geoms[i];
+		switch ( sub->type )
+		{
+		case POINTTYPE:
+			lwpoint_to_twkb_buf((LWPOINT*)sub, globals, ts, out);
+			break;
+		case LINETYPE:
+			lwline_to_twkb_buf((LWLINE*)sub, globals, ts, out);
+			break;
+		case POLYGONTYPE:
+			lwpoly_to_twkb_buf((LWPOLY*)sub, globals, ts, out);
+			break;
+		default:
+			lwerror("Unsupported geometry type: %s [%d]", lwtype_name(sub->type), sub->type);
+		}
+	}
+}
+
+static void lwcollection_to_twkb_buf(const LWCOLLECTION *col, twkb_globals *globals, twkb_state *ts, bytebuffer_t *out)
+{
+	int i, j;
+
+	bytebuffer_append_uvarint(out, (uint64_t)col->ngeoms);
+
+	if ( ts->idlist )
+		for ( i = 0; i < col->ngeoms; i++ )
+			bytebuffer_append_varint(out, ts->idlist[i]);
+
+	/* Members are complete TWKB geometries of their own */
+	for ( i = 0; i < col->ngeoms; i++ )
+	{
+		twkb_state sub;
+		GBOX box;
+
+		lwgeom_to_twkb_buf(col->geoms[i], globals, NULL, out);
+
+		/* The collection box covers its members */
+		if ( lwgeom_calculate_gbox(col->geoms[i], &box) != LW_SUCCESS )
+			continue;
+		sub.bbox_min[0] = twkb_round(box.xmin * ts->factor[0]);
+		sub.bbox_max[0] = twkb_round(box.xmax * ts->factor[0]);
+		sub.bbox_min[1] = twkb_round(box.ymin * ts->factor[1]);
+		sub.bbox_max[1] = twkb_round(box.ymax * ts->factor[1]);
+		j = 2;
+		if ( FLAGS_GET_Z(col->flags) )
+		{
+			sub.bbox_min[j] = twkb_round(box.zmin * ts->factor[j]);
+			sub.bbox_max[j] = twkb_round(box.zmax * ts->factor[j]);
+			j++;
+		}
+		if ( FLAGS_GET_M(col->flags) )
+		{
+			sub.bbox_min[j] = twkb_round(box.mmin * ts->factor[j]);
+			sub.bbox_max[j] = twkb_round(box.mmax * ts->factor[j]);
+		}
+		for ( j = 0; j < ts->ndims; j++ )
+		{
+			if ( ! ts->has_points || sub.bbox_min[j] < ts->bbox_min[j] )
+				ts->bbox_min[j] = sub.bbox_min[j];
+			if ( ! ts->has_points || sub.bbox_max[j] > ts->bbox_max[j] )
+				ts->bbox_max[j] = sub.bbox_max[j];
+		}
+		ts->has_points = LW_TRUE;
+	}
+}
+
+/*
+* Write one complete TWKB geometry: header, optional size and box, body
+*/
+static void lwgeom_to_twkb_buf(const LWGEOM *geom, twkb_globals *globals, const int64_t *idlist, bytebuffer_t *out)
+{
+	uint8_t type = lwgeom_twkb_type(geom);
+	int has_z = FLAGS_GET_Z(geom->flags);
+	int has_m = FLAGS_GET_M(geom->flags);
+	uint8_t meta = 0;
+	bytebuffer_t *body;
+	bytebuffer_t *box = NULL;
+	twkb_state ts;
+	int j;
+
+	memset(&ts, 0, sizeof(twkb_state));
+	ts.idlist = idlist;
+	ts.ndims = 2 + has_z + has_m;
+
+	ts.factor[0] = ts.factor[1] = pow(10, globals->prec_xy);
+	j = 2;
+	if ( has_z )
+		ts.factor[j++] = pow(10, globals->prec_z);
+	if ( has_m )
+		ts.factor[j++] = pow(10, globals->prec_m);
+
+	if ( has_z || has_m )
+		meta |= TWKB_HAS_EXTENDED_DIMS;
+
+	if ( lwgeom_is_empty(geom) )
+	{
+		meta |= TWKB_IS_EMPTY;
+		body = NULL;
+	}
+	else
+	{
+		body = bytebuffer_create();
+		switch ( geom->type )
+		{
+		case POINTTYPE:
+			lwpoint_to_twkb_buf((LWPOINT*)geom, globals, &ts, body);
+			break;
+		case LINETYPE:
+			lwline_to_twkb_buf((LWLINE*)geom, globals, &ts, body);
+			break;
+		case POLYGONTYPE:
+			lwpoly_to_twkb_buf((LWPOLY*)geom, globals, &ts, body);
+			break;
+		case MULTIPOINTTYPE:
+		case MULTILINETYPE:
+		case MULTIPOLYGONTYPE:
+			lwmulti_to_twkb_buf((LWCOLLECTION*)geom, globals, &ts, body);
+			break;
+		case COLLECTIONTYPE:
+			lwcollection_to_twkb_buf((LWCOLLECTION*)geom, globals, &ts, body);
+			break;
+		}
+
+		if ( idlist )
+			meta |= TWKB_HAS_IDLIST;
+		if ( globals->variant & TWKB_SIZE )
+			meta |= TWKB_HAS_SIZE;
+		/* A single point is its own box */
+		if ( (globals->variant & TWKB_BBOX) && geom->type != POINTTYPE && ts.has_points )
+		{
+			meta |= TWKB_HAS_BBOX;
+			box = bytebuffer_create_with_size(ts.ndims * 2 * VARINT_MAX_SIZE);
+			for ( j = 0; j < ts.ndims; j++ )
+			{
+				bytebuffer_append_varint(box, ts.bbox_min[j]);
+				bytebuffer_append_varint(box, ts.bbox_max[j] - ts.bbox_min[j]);
+			}
+		}
+	}
+
+	bytebuffer_append_byte(out, (uint8_t)((zigzag64(globals->prec_xy) << 4) | type));
+	bytebuffer_append_byte(out, meta);
+	if ( meta & TWKB_HAS_EXTENDED_DIMS )
+	{
+		uint8_t ext = 0;
+		if ( has_z )
+			ext |= 0x01 | (globals->prec_z << 2);
+		if ( has_m )
+			ext |= 0x02 | (globals->prec_m << 5);
+		bytebuffer_append_byte(out, ext);
+	}
+
+	if ( meta & TWKB_HAS_SIZE )
+		bytebuffer_append_uvarint(out, (uint64_t)(bytebuffer_getlength(body) + (box ? bytebuffer_getlength(box) : 0)));
+
+	if ( box )
+	{
+		bytebuffer_append_bytebuffer(out, box);
+		bytebuffer_destroy(box);
+	}
+
+	if ( body )
+	{
+		bytebuffer_append_bytebuffer(out, body);
+		bytebuffer_destroy(body);
+	}
+}
+
+/**
+* Convert LWGEOM to TWKB, with an id for each member of a top level
+* multi-geometry or collection. Caller is responsible for freeing the
+* returned array.
+*
+* @param idlist one id per member, or NULL for none
+* @param variant any of TWKB_BBOX, TWKB_SIZE
+* @param precision_xy decimal digits kept in X and Y, -7 to 7
+* @param precision_z decimal digits kept in Z, 0 to 7
+* @param precision_m decimal digits kept in M, 0 to 7
+* @param twkb_size returns the size of the output
+*/
+uint8_t* lwgeom_to_twkb_with_idlist(const LWGEOM *geom, const int64_t *idlist, uint8_t variant,
+                                   int8_t precision_xy, int8_t precision_z, int8_t precision_m,
+                                   size_t *twkb_size)
+{
+	twkb_globals globals;
+	bytebuffer_t *out;
+	uint8_t *twkb;
+
+	if ( twkb_size ) *twkb_size = 0;
+
+	if ( geom == NULL )
+	{
+		lwerror("Cannot convert NULL into TWKB.");
+		return NULL;
+	}
+
+	if ( abs(precision_xy) > TWKB_MAX_PRECISION )
+	{
+		lwerror("TWKB XY precision must be between %d and %d", -TWKB_MAX_PRECISION, TWKB_MAX_PRECISION);
+		return NULL;
+	}
+	if ( precision_z < 0 || precision_z > TWKB_MAX_PRECISION ||
+	     precision_m < 0 || precision_m > TWKB_MAX_PRECISION )
+	{
+		lwerror("TWKB Z and M precision must be between 0 and %d", TWKB_MAX_PRECISION);
+		return NULL;
+	}
+
+	if ( idlist && ! (geom->type == MULTIPOINTTYPE || geom->type == MULTILINETYPE ||
+	                  geom->type == MULTIPOLYGONTYPE || geom->type == COLLECTIONTYPE) )
+	{
+		lwerror("TWKB id lists are only allowed on multi-geometries and collections");
+		return NULL;
+	}
+
+	memset(&globals, 0, sizeof(twkb_globals));
+	globals.variant = variant;
+	globals.prec_xy = precision_xy;
+	globals.prec_z = precision_z;
+	globals.prec_m = precision_m;
+	globals.ring = bytebuffer_create();
+
+	out = bytebuffer_create();
+	lwgeom_to_twkb_buf(geom, &globals, idlist, out);
+	twkb = bytebuffer_get_buffer_copy(out, twkb_size);
+
+	bytebuffer_destroy(out);
+	bytebuffer_destroy(globals.ring);
+	return twkb;
+}
+
+/**
+* Convert LWGEOM to TWKB. Caller is responsible for freeing the returned
+* array. See lwgeom_to_twkb_with_idlist for the parameters.
+*/
+uint8_t* lwgeom_to_twkb(const LWGEOM *geom, uint8_t variant,
+                       int8_t precision_xy, int8_t precision_z, int8_t precision_m,
+                       size_t *twkb_size)
+{
+	return lwgeom_to_twkb_with_idlist(geom, NULL, variant, precision_xy, precision_z, precision_m, twkb_size);
+}
@@ -0,0 +1,66 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#ifndef _LIBLWGEOM_TWKB_H
+#define _LIBLWGEOM_TWKB_H 1
+
+/**
+* TWKB ("tiny WKB") is a compact binary form for sending geometries over
+* the wire. Ordinates are scaled by 10^precision and rounded to integers,
+* each vertex is stored as the difference from the one before it, and all
+* numbers are zig-zag encoded varints (see varint.h).
+*
+* Every geometry starts with:
+*
+*   <type_and_precision> 1 byte: low nibble is the type (1-7, as in WKB),
+*                        high nibble is the zig-zag encoded XY precision
+*   <metadata_header>    1 byte: TWKB_HAS_* bits
+*   [extended_dims]      1 byte, if TWKB_HAS_EXTENDED_DIMS: bit 0 for Z,
+*                        bit 1 for M, bits 2-4 Z precision, 5-7 M precision
+*   [size]               varint, bytes remaining after the size itself
+*   [bbox]               per dimension: varint min, varint (max - min)
+*
+* then, unless TWKB_IS_EMPTY, the body:
+*
+*   POINT       ordinates
+*   LINESTRING  npoints, ordinates
+*   POLYGON     nrings, then npoints and ordinates for each ring
+*   MULTI*      ngeoms, [idlist], then each member's body, without header
+*   COLLECTION  ngeoms, [idlist], then each member as a full TWKB
+*
+* The running delta is carried through the members of a multi-geometry.
+*/
+
+#include "liblwgeom_internal.h"
+#include "lwgeom_log.h"
+#include "bytebuffer.h"
+#include "varint.h"
+
+/* Type numbers */
+#define TWKB_POINT_TYPE 1
+#define TWKB_LINESTRING_TYPE 2
+#define TWKB_POLYGON_TYPE 3
+#define TWKB_MULTIPOINT_TYPE 4
+#define TWKB_MULTILINESTRING_TYPE 5
+#define TWKB_MULTIPOLYGON_TYPE 6
+#define TWKB_GEOMETRYCOLLECTION_TYPE 7
+
+/* Metadata header bits */
+#define TWKB_HAS_BBOX 0x01
+#define TWKB_HAS_SIZE 0x02
+#define TWKB_HAS_IDLIST 0x04
+#define TWKB_HAS_EXTENDED_DIMS 0x08
+#define TWKB_IS_EMPTY 0x10
+
+/* Largest precision that fits the header fields */
+#define TWKB_MAX_PRECISION 7
+
+#endif /* _LIBLWGEOM_TWKB_H */
@@ -63,11 +63,11 @@ static int lwgeom_wkb_needs_srid(const LWGEOM *geom, uint8_t variant)
 /*
 * GeometryType
 */
-static uint32_t lwgeom_wkb_type(const LWGEOM *geom, uint8_t variant)
+static uint32_t wkb_type_from_lwtype(uint8_t type, uint8_t flags, int needs_srid, uint8_t variant)
 {
 	uint32_t wkb_type = 0;
 
-	switch ( geom->type )
+	switch ( type )
 	{
 	case POINTTYPE:
 		wkb_type = WKB_POINT_TYPE;
@@ -116,32 +116,36 @@ static uint32_t lwgeom_wkb_type(const LWGEOM *geom, uint8_t variant)
 		break;
 	default:
 		lwerror("Unsupported geometry type: %s [%d]",
-			lwtype_name(geom->type), geom->type);
+			lwtype_name(type), type);
 	}
 
 	if ( variant & WKB_EXTENDED )
 	{
-		if ( FLAGS_GET_Z(geom->flags) )
+		if ( FLAGS_GET_Z(flags) )
 			wkb_type |= WKBZOFFSET;
-		if ( FLAGS_GET_M(geom->flags) )
+		if ( FLAGS_GET_M(flags) )
 			wkb_type |= WKBMOFFSET;
-/*		if ( geom->srid != SRID_UNKNOWN && ! (variant & WKB_NO_SRID) ) */
-		if ( lwgeom_wkb_needs_srid(geom, variant) )
+		if ( needs_srid )
 			wkb_type |= WKBSRIDFLAG;
 	}
 	else if ( variant & WKB_ISO )
 	{
 		/* Z types are in the 1000 range */
-		if ( FLAGS_GET_Z(geom->flags) )
+		if ( FLAGS_GET_Z(flags) )
 			wkb_type += 1000;
 		/* M types are in the 2000 range */
-		if ( FLAGS_GET_M(geom->flags) )
+		if ( FLAGS_GET_M(flags) )
 			wkb_type += 2000;
 		/* ZM types are in the 1000 + 2000 = 3000 range, see above */
 	}
 	return wkb_type;
 }
 
+static uint32_t lwgeom_wkb_type(const LWGEOM *geom, uint8_t variant)
+{
+	return wkb_type_from_lwtype(geom->type, geom->flags, lwgeom_wkb_needs_srid(geom, variant), variant);
+}
+
 /*
 * Endian
 */
@@ -770,3 +774,396 @@ char* lwgeom_to_hexwkb(const LWGEOM *geom, uint8_t variant, size_t *size_out)
 	return (char*)lwgeom_to_wkb(geom, variant | WKB_HEX, size_out);
 }
 
+
+/***********************************************************************
+* GSERIALIZED to WKB, without building an LWGEOM first.
+*
+* The serialized form carries all the counts we need, so we walk it once
+* to size the output and once more to write it, reading the ordinates
+* straight out of the serialized buffer.
+*/
+
+/*
+* Look-up table for the GSERIALIZED hex writer, two characters per byte
+*/
+static const char hexpairs[] =
+	"000102030405060708090A0B0C0D0E0F"
+	"101112131415161718191A1B1C1D1E1F"
+	"202122232425262728292A2B2C2D2E2F"
+	"303132333435363738393A3B3C3D3E3F"
+	"404142434445464748494A4B4C4D4E4F"
+	"505152535455565758595A5B5C5D5E5F"
+	"606162636465666768696A6B6C6D6E6F"
+	"707172737475767778797A7B7C7D7E7F"
+	"808182838485868788898A8B8C8D8E8F"
+	"909192939495969798999A9B9C9D9E9F"
+	"A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+	"B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+	"C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+	"D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+	"E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+	"F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+/*
+* Write nbytes of raw data, flipping byte order if asked to
+*/
+static inline uint8_t* bytes_to_wkb_buf(const uint8_t *bytes, size_t nbytes, int swap, uint8_t *buf, uint8_t variant)
+{
+	size_t i;
+
+	if ( variant & WKB_HEX )
+	{
+		for ( i = 0; i < nbytes; i++ )
+		{
+			const char *pair = hexpairs + 2 * bytes[swap ? nbytes - 1 - i : i];
+			*buf++ = pair[0];
+			*buf++ = pair[1];
+		}
+		return buf;
+	}
+
+	if ( swap )
+	{
+		for ( i = 0; i < nbytes; i++ )
+			buf[i] = bytes[nbytes - 1 - i];
+	}
+	else
+	{
+		memcpy(buf, bytes, nbytes);
+	}
+	return buf + nbytes;
+}
+
+static inline uint8_t* uint32_to_wkb_buf(uint32_t ival, int swap, uint8_t *buf, uint8_t variant)
+{
+	return bytes_to_wkb_buf((uint8_t*)(&ival), WKB_INT_SIZE, swap, buf, variant);
+}
+
+/*
+* Number of ordinates per point in the output
+*/
+static inline int gserialized_wkb_dims(uint8_t flags, uint8_t variant)
+{
+	/* SFSQL is always 2-d. Extended and ISO use all available dimensions */
+	if ( variant & (WKB_ISO | WKB_EXTENDED) )
+		return FLAGS_NDIMS(flags);
+	return 2;
+}
+
+static uint8_t* gserialized_ordinates_to_wkb_buf(const uint8_t *data, uint32_t npoints, uint8_t flags, int swap, uint8_t *buf, uint8_t variant)
+{
+	int ndims = FLAGS_NDIMS(flags);
+	int dims = gserialized_wkb_dims(flags, variant);
+	size_t i;
+	int j;
+
+	/* Binary output in machine order with every dimension is a straight copy */
+	if ( dims == ndims && ! swap && ! (variant & WKB_HEX) )
+	{
+		size_t size = (size_t)npoints * ndims * WKB_DOUBLE_SIZE;
+		memcpy(buf, data, size);
+		return buf + size;
+	}
+
+	for ( i = 0; i < npoints; i++ )
+	{
+		const uint8_t *pt = data + i * ndims * WKB_DOUBLE_SIZE;
+		for ( j = 0; j < dims; j++ )
+			buf = bytes_to_wkb_buf(pt + j * WKB_DOUBLE_SIZE, WKB_DOUBLE_SIZE, swap, buf, variant);
+	}
+	return buf;
+}
+
+/*
+* Endian flag, type number and optional SRID
+*/
+static uint8_t* gserialized_header_to_wkb_buf(uint32_t type, uint8_t flags, int32_t srid, int swap, uint8_t *buf, uint8_t variant)
+{
+	int needs_srid = (variant & WKB_EXTENDED) && srid != SRID_UNKNOWN;
+
+	buf = endian_to_wkb_buf(buf, variant);
+	buf = uint32_to_wkb_buf(wkb_type_from_lwtype(type, flags, needs_srid, variant), swap, buf, variant);
+	if ( needs_srid )
+		buf = uint32_to_wkb_buf((uint32_t)srid, swap, buf, variant);
+	return buf;
+}
+
+static size_t gserialized_buffer_to_wkb_size(const uint8_t *data, uint8_t flags, int needs_srid, uint8_t variant, size_t *g_size, int *is_empty)
+{
+	uint32_t type = lw_get_uint32_t(data);
+	uint32_t count = lw_get_uint32_t(data + 4);
+	size_t ptsize = gserialized_wkb_dims(flags, variant) * WKB_DOUBLE_SIZE;
+	/* Endian flag + type number + npoints/nrings/ngeoms */
+	size_t size = WKB_BYTE_SIZE + WKB_INT_SIZE + WKB_INT_SIZE;
+	size_t gsize = 8;
+	int empty = (count == 0);
+	int i;
+
+	if ( needs_srid )
+		size += WKB_INT_SIZE;
+
+	switch ( type )
+	{
+	case POINTTYPE:
+		/* Points have no npoints, but an empty point is written as an
+		   empty MULTIPOINT, which has one */
+		if ( count > 0 )
+			size += ptsize - WKB_INT_SIZE;
+		gsize += count * FLAGS_NDIMS(flags) * sizeof(double);
+		break;
+	case LINETYPE:
+	case CIRCSTRINGTYPE:
+		size += count * ptsize;
+		gsize += count * FLAGS_NDIMS(flags) * sizeof(double);
+		break;
+	case TRIANGLETYPE:
+		/* One ring, with its npoints */
+		if ( count > 0 )
+			size += WKB_INT_SIZE + count * ptsize;
+		gsize += count * FLAGS_NDIMS(flags) * sizeof(double);
+		break;
+	case POLYGONTYPE:
+		gsize += count * 4;
+		if ( count % 2 ) /* Padding */
+			gsize += 4;
+		for ( i = 0; i < count; i++ )
+		{
+			uint32_t npoints = lw_get_uint32_t(data + 8 + 4 * i);
+			size += WKB_INT_SIZE + npoints * ptsize;
+			gsize += npoints * FLAGS_NDIMS(flags) * sizeof(double);
+		}
+		break;
+	case MULTIPOINTTYPE:
+	case MULTILINETYPE:
+	case MULTIPOLYGONTYPE:
+	case COMPOUNDTYPE:
+	case CURVEPOLYTYPE:
+	case MULTICURVETYPE:
+	case MULTISURFACETYPE:
+	case POLYHEDRALSURFACETYPE:
+	case TINTYPE:
+	case COLLECTIONTYPE:
+	{
+		size_t subs = 0;
+		empty = LW_TRUE;
+		for ( i = 0; i < count; i++ )
+		{
+			uint32_t subtype = lw_get_uint32_t(data + gsize);
+			size_t subsize = 0;
+			int subempty = LW_TRUE;
+
+			if ( ! lwcollection_allows_subtype(type, subtype) )
+			{
+				lwerror("Invalid subtype (%s) for collection type (%s)", lwtype_name(subtype), lwtype_name(type));
+				return 0;
+			}
+			/* Sub-geometries inherit their SRID from the parent */
+			subs += gserialized_buffer_to_wkb_size(data + gsize, flags, LW_FALSE, variant, &subsize, &subempty);
+			if ( ! subempty )
+				empty = LW_FALSE;
+			gsize += subsize;
+		}
+		/* A collection of empties is written as an empty collection */
+		if ( ! empty )
+			size += subs;
+		break;
+	}
+	default:
+		lwerror("Unsupported geometry type: %s [%d]", lwtype_name(type), type);
+		return 0;
+	}
+
+	if ( g_size )
+		*g_size = gsize;
+	if ( is_empty )
+		*is_empty = empty;
+	return size;
+}
+
+static uint8_t* gserialized_buffer_to_wkb_buf(const uint8_t *data, uint8_t flags, int32_t srid, int swap, uint8_t *buf, uint8_t variant, size_t *g_size)
+{
+	uint32_t type = lw_get_uint32_t(data);
+	uint32_t count = lw_get_uint32_t(data + 4);
+	size_t ptsize = FLAGS_NDIMS(flags) * sizeof(double);
+	size_t gsize = 8;
+	int empty;
+	int i;
+
+	switch ( type )
+	{
+	case POINTTYPE:
+		if ( count == 0 )
+		{
+			/* Empty POINT is written as an empty MULTIPOINT */
+			buf = gserialized_header_to_wkb_buf(MULTIPOINTTYPE, flags, srid, swap, buf, variant);
+			buf = uint32_to_wkb_buf(0, swap, buf, variant);
+			break;
+		}
+		buf = gserialized_header_to_wkb_buf(type, flags, srid, swap, buf, variant);
+		buf = gserialized_ordinates_to_wkb_buf(data + gsize, 1, flags, swap, buf, variant);
+		gsize += ptsize;
+		break;
+	case LINETYPE:
+	case CIRCSTRINGTYPE:
+		buf = gserialized_header_to_wkb_buf(type, flags, srid, swap, buf, variant);
+		buf = uint32_to_wkb_buf(count, swap, buf, variant);
+		buf = gserialized_ordinates_to_wkb_buf(data + gsize, count, flags, swap, buf, variant);
+		gsize += count * ptsize;
+		break;
+	case TRIANGLETYPE:
+		buf = gserialized_header_to_wkb_buf(type, flags, srid, swap, buf, variant);
+		if ( count == 0 )
+		{
+			buf = uint32_to_wkb_buf(0, swap, buf, variant);
+			break;
+		}
+		buf = uint32_to_wkb_buf(1, swap, buf, variant);
+		buf = uint32_to_wkb_buf(count, swap, buf, variant);
+		buf = gserialized_ordinates_to_wkb_buf(data + gsize, count, flags, swap, buf, variant);
+		gsize += count * ptsize;
+		break;
+	case POLYGONTYPE:
+	{
+		const uint8_t *ords = data + gsize + count * 4;
+		if ( count % 2 ) /* Padding */
+			ords += 4;
+		buf = gserialized_header_to_wkb_buf(type, flags, srid, swap, buf, variant);
+		buf = uint32_to_wkb_buf(count, swap, buf, variant);
+		for ( i = 0; i < count; i++ )
+		{
+			uint32_t npoints = lw_get_uint32_t(data + 8 + 4 * i);
+			buf = uint32_to_wkb_buf(npoints, swap, buf, variant);
+			buf = gserialized_ordinates_to_wkb_buf(ords, npoints, flags, swap, buf, variant);
+			ords += npoints * ptsize;
+		}
+		gsize = ords - data;
+		break;
+	}
+	case MULTIPOINTTYPE:
+	case MULTILINETYPE:
+	case MULTIPOLYGONTYPE:
+	case COMPOUNDTYPE:
+	case CURVEPOLYTYPE:
+	case MULTICURVETYPE:
+	case MULTISURFACETYPE:
+	case POLYHEDRALSURFACETYPE:
+	case TINTYPE:
+	case COLLECTIONTYPE:
+		buf = gserialized_header_to_wkb_buf(type, flags, srid, swap, buf, variant);
+		/* A collection of empties is written as an empty collection */
+		gsize = gserialized_buffer_summary(data, flags, &empty, NULL, NULL);
+		if ( empty )
+		{
+			buf = uint32_to_wkb_buf(0, swap, buf, variant);
+			break;
+		}
+		buf = uint32_to_wkb_buf(count, swap, buf, variant);
+		gsize = 8;
+		for ( i = 0; i < count; i++ )
+		{
+			size_t subsize = 0;
+			/* Sub-geometries inherit their SRID from the parent */
+			buf = gserialized_buffer_to_wkb_buf(data + gsize, flags, SRID_UNKNOWN, swap, buf, variant, &subsize);
+			gsize += subsize;
+		}
+		break;
+	default:
+		lwerror("Unsupported geometry type: %s [%d]", lwtype_name(type), type);
+		return NULL;
+	}
+
+	if ( g_size )
+		*g_size = gsize;
+	return buf;
+}
+
+/**
+* Convert a GSERIALIZED directly to WKB, producing the same output as
+* lwgeom_to_wkb(lwgeom_from_gserialized(g), variant, size_out) without
+* building the intermediate LWGEOM. Caller is responsible for freeing
+* the returned array.
+*/
+uint8_t* gserialized_to_wkb(const GSERIALIZED *g, uint8_t variant, size_t *size_out)
+{
+	const uint8_t *data;
+	int32_t srid;
+	size_t buf_size;
+	uint8_t *buf = NULL;
+	uint8_t *wkb_out = NULL;
+	int swap;
+
+	/* Initialize output size */
+	if ( size_out ) *size_out = 0;
+
+	if ( g == NULL )
+	{
+		lwerror("Cannot convert NULL into WKB.");
+		return NULL;
+	}
+
+	data = g->data;
+	if ( FLAGS_GET_BBOX(g->flags) )
+		data += gbox_serialized_size(g->flags);
+
+	/* Only the outermost geometry carries the SRID, and only in EWKB */
+	srid = SRID_UNKNOWN;
+	if ( (variant & WKB_EXTENDED) && ! (variant & WKB_NO_SRID) )
+		srid = gserialized_get_srid(g);
+
+	/* Calculate the required size of the output buffer */
+	buf_size = gserialized_buffer_to_wkb_size(data, g->flags, srid != SRID_UNKNOWN, variant, NULL, NULL);
+	LWDEBUGF(4, "WKB output size: %d", buf_size);
+
+	if ( buf_size == 0 )
+	{
+		lwerror("Error calculating output WKB buffer size.");
+		return NULL;
+	}
+
+	/* Hex string takes twice as much space as binary + a null character */
+	if ( variant & WKB_HEX )
+		buf_size = 2 * buf_size + 1;
+
+	/* If neither or both variants are specified, choose the native order */
+	if ( ! (variant & WKB_NDR || variant & WKB_XDR) ||
+	       (variant & WKB_NDR && variant & WKB_XDR) )
+	{
+		if ( getMachineEndian() == NDR )
+			variant = variant | WKB_NDR;
+		else
+			variant = variant | WKB_XDR;
+	}
+	swap = wkb_swap_bytes(variant);
+
+	buf = lwalloc(buf_size);
+	if ( buf == NULL )
+	{
+		lwerror("Unable to allocate %d bytes for WKB output buffer.", buf_size);
+		return NULL;
+	}
+	wkb_out = buf;
+
+	buf = gserialized_buffer_to_wkb_buf(data, g->flags, srid, swap, buf, variant, NULL);
+
+	/* Null the last byte if this is a hex output */
+	if ( variant & WKB_HEX )
+		*buf++ = '\0';
+
+	/* The buffer pointer should now land at the end of the allocated buffer space. Let's check. */
+	if ( buf_size != (buf - wkb_out) )
+	{
+		lwerror("Output WKB is not the same size as the allocated buffer.");
+		lwfree(wkb_out);
+		return NULL;
+	}
+
+	/* Report output size */
+	if ( size_out ) *size_out = buf_size;
+
+	return wkb_out;
+}
+
+char* gserialized_to_hexwkb(const GSERIALIZED *g, uint8_t variant, size_t *size_out)
+{
+	return (char*)gserialized_to_wkb(g, variant | WKB_HEX, size_out);
+}
@@ -71,6 +71,7 @@ static void ptarray_to_wkt_sb(const POINTARRAY *ptarray, stringbuffer_t *sb, int
 	/* OGC only includes X/Y */
 	int dimensions = 2;
 	int i, j;
+	char buf[OUT_DOUBLE_BUFFER_SIZE];
 
 	/* ISO and extended formats include all dimensions */
 	if ( variant & ( WKT_ISO | WKT_EXTENDED ) )
@@ -96,7 +97,10 @@ static void ptarray_to_wkt_sb(const POINTARRAY *ptarray, stringbuffer_t *sb, int
 			/* Spaces before every ordinate but the first */
 			if ( j > 0 )
 				stringbuffer_append(sb, " ");
-			stringbuffer_aprintf(sb, "%.*g", precision, d);
+			if ( lwprint_double_sig(d, precision, buf, OUT_DOUBLE_BUFFER_SIZE) < OUT_DOUBLE_BUFFER_SIZE )
+				stringbuffer_append(sb, buf);
+			else
+				stringbuffer_aprintf(sb, "%.*g", precision, d);
 		}
 	}
 
@@ -779,9 +779,9 @@ pointArray_toX3D3(POINTARRAY *pa, char *output, int precision, int opts, int is_
 {
 	int i;
 	char *ptr;
-	char x[OUT_MAX_DIGS_DOUBLE+OUT_MAX_DOUBLE_PRECISION+1];
-	char y[OUT_MAX_DIGS_DOUBLE+OUT_MAX_DOUBLE_PRECISION+1];
-	char z[OUT_MAX_DIGS_DOUBLE+OUT_MAX_DOUBLE_PRECISION+1];
+	char x[OUT_DOUBLE_BUFFER_SIZE];
+	char y[OUT_DOUBLE_BUFFER_SIZE];
+	char z[OUT_DOUBLE_BUFFER_SIZE];
 
 	ptr = output;
 
@@ -795,17 +795,9 @@ pointArray_toX3D3(POINTARRAY *pa, char *output, int precision, int opts, int is_
 				POINT2D pt;
 				getPoint2d_p(pa, i, &pt);
 
-				if (fabs(pt.x) < OUT_MAX_DOUBLE)
-					sprintf(x, "%.*f", precision, pt.x);
-				else
-					sprintf(x, "%g", pt.x);
-				trim_trailing_zeros(x);
+				lwprint_double(pt.x, precision, x, OUT_DOUBLE_BUFFER_SIZE);
 
-				if (fabs(pt.y) < OUT_MAX_DOUBLE)
-					sprintf(y, "%.*f", precision, pt.y);
-				else
-					sprintf(y, "%g", pt.y);
-				trim_trailing_zeros(y);
+				lwprint_double(pt.y, precision, y, OUT_DOUBLE_BUFFER_SIZE);
 
 				if ( i )
 					ptr += sprintf(ptr, " ");
@@ -823,23 +815,11 @@ pointArray_toX3D3(POINTARRAY *pa, char *output, int precision, int opts, int is_
 				POINT4D pt;
 				getPoint4d_p(pa, i, &pt);
 
-				if (fabs(pt.x) < OUT_MAX_DOUBLE)
-					sprintf(x, "%.*f", precision, pt.x);
-				else
-					sprintf(x, "%g", pt.x);
-				trim_trailing_zeros(x);
-
-				if (fabs(pt.y) < OUT_MAX_DOUBLE)
-					sprintf(y, "%.*f", precision, pt.y);
-				else
-					sprintf(y, "%g", pt.y);
-				trim_trailing_zeros(y);
-
-				if (fabs(pt.z) < OUT_MAX_DOUBLE)
-					sprintf(z, "%.*f", precision, pt.z);
-				else
-					sprintf(z, "%g", pt.z);
-				trim_trailing_zeros(z);
+				lwprint_double(pt.x, precision, x, OUT_DOUBLE_BUFFER_SIZE);
+
+				lwprint_double(pt.y, precision, y, OUT_DOUBLE_BUFFER_SIZE);
+
+				lwprint_double(pt.z, precision, z, OUT_DOUBLE_BUFFER_SIZE);
 
 				if ( i )
 					ptr += sprintf(ptr, " ");
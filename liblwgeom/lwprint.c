@@ -8,6 +8,8 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
+#include <float.h>
 #include "liblwgeom_internal.h"
 
 /* Ensures the given lat and lon are in the "normal" range:
@@ -402,3 +404,193 @@ char* lwpoint_to_latlon(const LWPOINT * pt, const char *format)
 	getPoint2d_p(pt->point, 0, &p);
 	return lwdoubles_to_latlon(p.y, p.x, format);
 }
+
+/*
+* Powers of ten that are exact in a double
+*/
+static const double lwprint_pow10[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+* The same, as integers
+*/
+static const uint64_t lwprint_pow10u[] =
+{
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+	10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+	100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+	100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+	100000000000000000ULL
+};
+
+/*
+* Round a * 10^dec to the nearest integer, as printf would. Returns LW_FALSE
+* when that cannot be decided cheaply: the scaled value is beyond 2^53, or
+* its fraction is so close to one half that the rounding error of the
+* multiplication could change the result.
+*/
+static int lwprint_round_scaled(double a, int dec, uint64_t *r)
+{
+	double scaled, ipart, frac;
+
+	if ( dec < 0 || dec > 22 )
+		return LW_FALSE;
+
+	scaled = a * lwprint_pow10[dec];
+	/* 2^53, this also turns away NaN and infinity */
+	if ( ! (scaled < 9007199254740992.0) )
+		return LW_FALSE;
+
+	ipart = floor(scaled);
+	frac = scaled - ipart;
+	/* The product is within half an ulp of the exact value */
+	if ( fabs(frac - 0.5) <= scaled * DBL_EPSILON )
+		return LW_FALSE;
+
+	*r = (uint64_t)ipart + (frac > 0.5 ? 1 : 0);
+	return LW_TRUE;
+}
+
+/*
+* Write r / 10^dec with at most dec decimals and no trailing zeros
+*/
+static int lwprint_scaled_to_buf(uint64_t r, int dec, int negative, char *buf)
+{
+	char digits[24];
+	int ndigits = 0;
+	int len = 0;
+	int i;
+
+	/* Trailing zeros are never written, rather than trimmed afterwards */
+	while ( dec > 0 && r % 10 == 0 )
+	{
+		r /= 10;
+		dec--;
+	}
+
+	do
+	{
+		digits[ndigits++] = '0' + (r % 10);
+		r /= 10;
+	}
+	while ( r );
+
+	if ( negative )
+		buf[len++] = '-';
+
+	if ( ndigits <= dec )
+		buf[len++] = '0';
+	else
+		for ( i = ndigits - 1; i >= dec; i-- )
+			buf[len++] = digits[i];
+
+	if ( dec > 0 )
+	{
+		buf[len++] = '.';
+		for ( i = dec - 1; i >= 0; i-- )
+			buf[len++] = (i < ndigits ? digits[i] : '0');
+	}
+
+	buf[len] = '\0';
+	return len;
+}
+
+/*
+* printf honours LC_NUMERIC, our output never does
+*/
+static void lwprint_fix_decimal_point(char *buf)
+{
+	for ( ; *buf; buf++ )
+		if ( *buf == ',' ) *buf = '.';
+}
+
+/**
+* Print a double with at most maxdd decimals, without trailing zeros,
+* as sprintf("%.*f") followed by trim_trailing_zeros() used to. Values
+* beyond OUT_MAX_DOUBLE are printed with "%g". The decimal point is
+* always a '.', whatever the locale.
+*
+* Most values are rounded with a single multiplication and written
+* digit by digit; printf is only called for the rare near-ties and for
+* out of range values.
+*
+* @return the length of the output, or the length it would have had if
+*         bufsize is too small (as snprintf)
+*/
+int lwprint_double(double d, int maxdd, char *buf, size_t bufsize)
+{
+	double a = fabs(d);
+	uint64_t r;
+	int len;
+
+	if ( a < OUT_MAX_DOUBLE )
+	{
+		/* Sign, 16 digits, point, decimals and the terminator */
+		if ( maxdd >= 0 && bufsize >= maxdd + 19 && lwprint_round_scaled(a, maxdd, &r) )
+			return lwprint_scaled_to_buf(r, maxdd, signbit(d), buf);
+
+		len = snprintf(buf, bufsize, "%.*f", maxdd, d);
+		if ( len < bufsize )
+			trim_trailing_zeros(buf);
+	}
+	else
+	{
+		len = snprintf(buf, bufsize, "%g", d);
+	}
+
+	lwprint_fix_decimal_point(buf);
+	return ( len < bufsize ) ? strlen(buf) : len;
+}
+
+/**
+* Print a double with at most sigdigits significant digits, exactly as
+* sprintf("%.*g") but always with a '.' decimal point. Values needing an
+* exponent are left to printf.
+*
+* @return the length of the output, or the length it would have had if
+*         bufsize is too small (as snprintf)
+*/
+int lwprint_double_sig(double d, int sigdigits, char *buf, size_t bufsize)
+{
+	static const double negpow10[] = { 1e-1, 1e-2, 1e-3, 1e-4 };
+	double a = fabs(d);
+	uint64_t r;
+	int len;
+	int e;
+
+	if ( sigdigits == 0 )
+		sigdigits = 1;
+
+	if ( a == 0.0 && bufsize > 2 )
+		return lwprint_scaled_to_buf(0, 0, signbit(d), buf);
+
+	/* Plain notation is used for exponents in [-4, sigdigits) */
+	if ( sigdigits > 0 && sigdigits <= 17 && bufsize >= sigdigits + 8 &&
+	     a >= 1e-4 && a < lwprint_pow10[sigdigits] )
+	{
+		if ( a >= 1.0 )
+		{
+			e = 0;
+			while ( a >= lwprint_pow10[e + 1] )
+				e++;
+		}
+		else
+		{
+			e = -1;
+			while ( a < negpow10[-e - 1] )
+				e--;
+		}
+
+		/* If the rounding carries into another digit, let printf do it */
+		if ( lwprint_round_scaled(a, sigdigits - 1 - e, &r) &&
+		     r >= lwprint_pow10u[sigdigits - 1] && r < lwprint_pow10u[sigdigits] )
+			return lwprint_scaled_to_buf(r, sigdigits - 1 - e, signbit(d), buf);
+	}
+
+	len = snprintf(buf, bufsize, "%.*g", sigdigits, d);
+	lwprint_fix_decimal_point(buf);
+	return ( len < bufsize ) ? strlen(buf) : len;
+}
@@ -389,3 +389,125 @@ clamp_srid(int srid)
 	
 	return newsrid;
 }
+
+/* Powers of ten that are exact in a double */
+static const double lwread_pow10[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+	1e21, 1e22
+};
+
+#define LWREAD_ISDIGIT(c) ((c) >= '0' && (c) <= '9')
+
+/**
+* Read a number matching the WKT lexer's
+* -?(([0-9]+\.?)|([0-9]*\.?[0-9]+)([eE][-+]?[0-9]+)?)
+* Returns the first character after it, or NULL if there is no number.
+*
+* Up to 15 significant digits scaled by at most 10^22 are converted
+* with a single correctly rounded multiplication or division, which
+* gives the same answer as strtod(). Anything else goes to strtod().
+*/
+const char* lwread_double(const char *str, double *d)
+{
+	const char *p = str;
+	uint64_t mant = 0;
+	int ndigits = 0, intdigits = 0, fracdigits = 0;
+	int exp10 = 0, neg = 0;
+
+	if ( *p == '-' )
+	{
+		neg = 1;
+		p++;
+	}
+
+	for ( ; LWREAD_ISDIGIT(*p); p++, intdigits++ )
+	{
+		if ( mant || *p != '0' )
+		{
+			if ( ndigits < 19 ) mant = 10 * mant + (*p - '0');
+			else exp10++;
+			ndigits++;
+		}
+	}
+
+	if ( *p == '.' )
+	{
+		p++;
+		for ( ; LWREAD_ISDIGIT(*p); p++, fracdigits++ )
+		{
+			if ( mant || *p != '0' )
+			{
+				if ( ndigits < 19 )
+				{
+					mant = 10 * mant + (*p - '0');
+					exp10--;
+				}
+				ndigits++;
+			}
+			else
+			{
+				exp10--;
+			}
+		}
+		/* A lone "." is not a number, and "1." takes no exponent */
+		if ( ! fracdigits )
+		{
+			if ( ! intdigits ) return NULL;
+			goto convert;
+		}
+	}
+	else if ( ! intdigits )
+	{
+		return NULL;
+	}
+
+	/* The exponent is only part of the number when it has digits */
+	if ( *p == 'e' || *p == 'E' )
+	{
+		const char *e = p + 1;
+		int eneg = 0, evalue = 0;
+
+		if ( *e == '-' || *e == '+' )
+			eneg = (*e++ == '-');
+		if ( LWREAD_ISDIGIT(*e) )
+		{
+			for ( ; LWREAD_ISDIGIT(*e); e++ )
+				if ( evalue < 100000 ) evalue = 10 * evalue + (*e - '0');
+			exp10 += eneg ? -evalue : evalue;
+			p = e;
+		}
+	}
+
+convert:
+	if ( mant == 0 )
+	{
+		*d = 0.0;
+	}
+	else if ( ndigits <= 15 && exp10 >= -22 && exp10 <= 22 )
+	{
+		*d = (double)mant;
+		if ( exp10 < 0 )
+			*d /= lwread_pow10[-exp10];
+		else
+			*d *= lwread_pow10[exp10];
+	}
+	else
+	{
+		/* Copy the token out so strtod() can't read past it */
+		char buf[64];
+		char *tmp = buf;
+		size_t len = p - str;
+
+		if ( len >= sizeof(buf) ) tmp = lwalloc(len + 1);
+		memcpy(tmp, str, len);
+		tmp[len] = '\0';
+		*d = strtod(tmp, NULL);
+		if ( tmp != buf ) lwfree(tmp);
+		return p;
+	}
+
+	if ( neg ) *d = -(*d);
+	return p;
+}
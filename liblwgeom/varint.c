@@ -0,0 +1,112 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#include "varint.h"
+#include "lwgeom_log.h"
+#include "liblwgeom.h"
+
+/**
+* Write val as an unsigned varint into buf, which must have room for
+* VARINT_MAX_SIZE bytes. Returns the number of bytes written.
+*/
+size_t
+varint_u64_encode_buf(uint64_t val, uint8_t *buf)
+{
+	uint8_t *ptr = buf;
+
+	while ( val >= 0x80 )
+	{
+		/* Low seven bits, with the continuation bit set */
+		*ptr++ = (uint8_t)(val & 0x7F) | 0x80;
+		val >>= 7;
+	}
+	/* Last group, continuation bit clear */
+	*ptr++ = (uint8_t)val;
+
+	return ptr - buf;
+}
+
+size_t
+varint_s64_encode_buf(int64_t val, uint8_t *buf)
+{
+	return varint_u64_encode_buf(zigzag64(val), buf);
+}
+
+size_t
+varint_u64_size(uint64_t val)
+{
+	size_t size = 1;
+	while ( val >= 0x80 )
+	{
+		val >>= 7;
+		size++;
+	}
+	return size;
+}
+
+size_t
+varint_s64_size(int64_t val)
+{
+	return varint_u64_size(zigzag64(val));
+}
+
+/**
+* Read an unsigned varint starting at the_start, never reading at or past
+* the_end. The number of bytes consumed is returned in size.
+*/
+uint64_t
+varint_u64_decode(const uint8_t *the_start, const uint8_t *the_end, size_t *size)
+{
+	const uint8_t *ptr = the_start;
+	uint64_t val = 0;
+	int shift = 0;
+
+	while ( ptr < the_end )
+	{
+		uint8_t b = *ptr++;
+		val |= (uint64_t)(b & 0x7F) << shift;
+		if ( ! (b & 0x80) )
+		{
+			*size = ptr - the_start;
+			return val;
+		}
+		shift += 7;
+		if ( shift > 63 )
+			break;
+	}
+
+	lwerror("varint_u64_decode: varint extends past end of buffer");
+	*size = 0;
+	return 0;
+}
+
+int64_t
+varint_s64_decode(const uint8_t *the_start, const uint8_t *the_end, size_t *size)
+{
+	return unzigzag64(varint_u64_decode(the_start, the_end, size));
+}
+
+/**
+* Map signed integers to unsigned so that values of small magnitude,
+* whatever their sign, get small codes: 0, -1, 1, -2, 2 ... become
+* 0, 1, 2, 3, 4 ...
+*/
+uint64_t
+zigzag64(int64_t val)
+{
+	return ((uint64_t)val << 1) ^ (uint64_t)(val >> 63);
+}
+
+int64_t
+unzigzag64(uint64_t val)
+{
+	return (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+}
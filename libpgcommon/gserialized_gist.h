@@ -39,6 +39,12 @@ typedef struct
 	float xmin, xmax, ymin, ymax;
 } BOX2DF;
 
+/*
+** Empty geometries are indexed with a BOX2DF of NaN ordinates, which
+** overlaps, contains and merges with nothing.
+*/
+#define BOX2DF_IS_EMPTY(box) isnan((box)->xmin)
+
 
 /*********************************************************************************
 ** GIDX support functions.
@@ -0,0 +1,71 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#include "postgres.h"
+
+#include "../postgis_config.h"
+#include "liblwgeom.h"
+#include "estimate_histogram.h"
+
+#include <math.h>
+
+
+/**
+* Find the range of histogram cells along one axis covered by the
+* [min,max] interval. Returns LW_FALSE if the interval misses the
+* histogram extent on this axis.
+*/
+int
+histogram_axis_range(double min, double max, double hmin, double hmax,
+                     double cellsize, int ncells, int *idx_min, int *idx_max)
+{
+	double d;
+
+	if ( max < hmin || min > hmax )
+		return LW_FALSE;
+
+	/* Collapsed axis: the single cell spans the whole extent */
+	if ( cellsize == 0 )
+	{
+		*idx_min = 0;
+		*idx_max = ncells - 1;
+		return LW_TRUE;
+	}
+
+	d = floor((min - hmin) / cellsize);
+	*idx_min = d < 0 ? 0 : (d >= ncells ? ncells - 1 : (int)d);
+
+	d = floor((max - hmin) / cellsize);
+	*idx_max = d < 0 ? 0 : (d >= ncells ? ncells - 1 : (int)d);
+
+	return LW_TRUE;
+}
+
+/**
+* Fraction of the [cellmin,cellmin+cellsize] histogram cell covered
+* along one axis by the [min,max] interval. Collapsed intervals or
+* cells count as fully covered if they touch at all, just like a point
+* search box picks up the whole value of the cell it falls in.
+*/
+double
+histogram_axis_overlap(double min, double max, double cellmin, double cellsize)
+{
+	double cellmax = cellmin + cellsize;
+	double ov;
+
+	if ( max < cellmin || min > cellmax )
+		return 0.0;
+
+	if ( cellsize == 0 || max == min )
+		return 1.0;
+
+	ov = Min(max, cellmax) - Max(min, cellmin);
+	return ov > 0 ? ov / cellsize : 0.0;
+}
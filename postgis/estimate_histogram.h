@@ -0,0 +1,26 @@
+/**********************************************************************
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#ifndef _ESTIMATE_HISTOGRAM_H
+#define _ESTIMATE_HISTOGRAM_H
+
+/*
+** Axis helpers shared by the geometry and geography histograms, which
+** lay regular grids of cells over the extent of the sample.
+*/
+
+/* Cells along one axis covered by [min,max], LW_FALSE if none */
+int histogram_axis_range(double min, double max, double hmin, double hmax,
+                         double cellsize, int ncells, int *idx_min, int *idx_max);
+
+/* Fraction of a cell covered along one axis by [min,max] */
+double histogram_axis_overlap(double min, double max, double cellmin, double cellsize);
+
+#endif /* _ESTIMATE_HISTOGRAM_H */
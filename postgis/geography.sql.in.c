@@ -259,6 +259,27 @@ CREATE OPERATOR && (
 );
 
 
+#if POSTGIS_PGSQL_VERSION >= 91
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geography_distance_knn(geography, geography)
+	RETURNS float8
+	AS 'MODULE_PATHNAME','geography_distance_knn'
+	LANGUAGE 'C' IMMUTABLE STRICT
+	COST 100;
+
+-- Availability: 2.0.0
+CREATE OPERATOR <-> (
+	LEFTARG = geography, RIGHTARG = geography, PROCEDURE = geography_distance_knn,
+	COMMUTATOR = '<->'
+);
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geography_gist_distance(internal, geography, int4)
+	RETURNS float8
+	AS 'MODULE_PATHNAME' ,'gserialized_gist_geog_distance'
+	LANGUAGE 'C';
+#endif
+
 -- Availability: 1.5.0
 CREATE OPERATOR CLASS gist_geography_ops
 	DEFAULT FOR TYPE geography USING GIST AS
@@ -267,6 +288,11 @@ CREATE OPERATOR CLASS gist_geography_ops
 --	OPERATOR        6        ~=	,
 --	OPERATOR        7        ~	,
 --	OPERATOR        8        @	,
+#if POSTGIS_PGSQL_VERSION >= 95
+	-- Index ordering needs the 9.5 recheck of the exact distance
+	OPERATOR        13       <-> FOR ORDER BY pg_catalog.float_ops,
+	FUNCTION        8        geography_gist_distance (internal, geography, int4),
+#endif
 	FUNCTION        1        geography_gist_consistent (internal, geography, int4),
 	FUNCTION        2        geography_gist_union (bytea, internal),
 	FUNCTION        3        geography_gist_compress (internal),
@@ -275,6 +301,43 @@ CREATE OPERATOR CLASS gist_geography_ops
 	FUNCTION        6        geography_gist_picksplit (internal, internal),
 	FUNCTION        7        geography_gist_same (box2d, box2d, internal);
 
+#if POSTGIS_PGSQL_VERSION >= 95
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION overlaps_geog(gidx, geography)
+	RETURNS boolean
+	AS 'MODULE_PATHNAME' ,'gserialized_gidx_overlaps'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OPERATOR && (
+	LEFTARG = gidx, RIGHTARG = geography, PROCEDURE = overlaps_geog
+);
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geography_brin_add_value(internal, internal, internal, internal)
+	RETURNS boolean
+	AS 'MODULE_PATHNAME' ,'gserialized_brin_add_value'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geography_brin_merge(internal, internal)
+	RETURNS internal
+	AS 'MODULE_PATHNAME' ,'gserialized_brin_merge'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OPERATOR CLASS brin_geography_inclusion_ops
+	FOR TYPE geography USING BRIN AS
+	STORAGE gidx,
+	OPERATOR        3        &&	,
+	OPERATOR        3        && (gidx, geography),
+	FUNCTION        1        brin_inclusion_opcinfo(internal),
+	FUNCTION        2        geography_brin_add_value(internal, internal, internal, internal),
+	FUNCTION        3        brin_inclusion_consistent(internal, internal, internal),
+	FUNCTION        4        brin_inclusion_union(internal, internal, internal),
+	FUNCTION        11       geography_brin_merge(internal, internal);
+#endif
+
 
 -- ---------- ---------- ---------- ---------- ---------- ---------- ----------
 -- B-Tree Functions
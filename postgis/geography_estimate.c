@@ -13,6 +13,7 @@
 
 
 #include "postgres.h"
+#include "catalog/pg_statistic.h"
 #include "commands/vacuum.h"
 #include "nodes/relation.h"
 #include "parser/parsetree.h"
@@ -22,6 +23,7 @@
 #include "../postgis_config.h"
 #include "liblwgeom.h"
 #include "lwgeom_pg.h"
+#include "estimate_histogram.h"
 
 /* Prototypes */
 Datum geography_gist_selectivity(PG_FUNCTION_ARGS);
@@ -574,6 +576,138 @@ Datum geography_gist_selectivity(PG_FUNCTION_ARGS)
 }
 
 
+/**
+* Estimate the fraction of the (not-null) cartesian product of two
+* columns whose boxes overlap, by overlaying their GEOG_STATS
+* histograms cell by cell. This is the 3D counterpart of the
+* geometry estimator: products of overlapping cell values, scaled by
+* the share of the second cell covered by the first one, summed and
+* divided by the expected number of cells two overlapping average
+* features have in common.
+*/
+static float8
+estimate_join_selectivity(const GEOG_STATS *s1, const GEOG_STATS *s2)
+{
+	int ux1 = s1->unitsx, uy1 = s1->unitsy, uz1 = s1->unitsz;
+	int ux2 = s2->unitsx, uy2 = s2->unitsy, uz2 = s2->unitsz;
+	double cx1 = (s1->xmax - s1->xmin) / ux1;
+	double cy1 = (s1->ymax - s1->ymin) / uy1;
+	double cz1 = (s1->zmax - s1->zmin) / uz1;
+	double cx2 = (s2->xmax - s2->xmin) / ux2;
+	double cy2 = (s2->ymax - s2->ymin) / uy2;
+	double cz2 = (s2->zmax - s2->zmin) / uz2;
+	double cell_ratio = 1.0;
+	double side1, side2, common_cells;
+	int ndims = 0;
+	double value = 0.0;
+	float8 selectivity;
+	int x1, y1, z1, x2, y2, z2;
+
+	/* The two histograms do not even touch */
+	if ( s1->xmax < s2->xmin || s1->xmin > s2->xmax ||
+	     s1->ymax < s2->ymin || s1->ymin > s2->ymax ||
+	     s1->zmax < s2->zmin || s1->zmin > s2->zmax )
+	{
+		POSTGIS_DEBUG(3, " histogram extents do not overlap, returning 0");
+		return 0.0;
+	}
+
+	for (z1 = 0; z1 < uz1; z1++)
+	{
+		double c1zmin = s1->zmin + z1 * cz1;
+		double c1zmax = c1zmin + cz1;
+		int z2min, z2max;
+
+		if ( ! histogram_axis_range(c1zmin, c1zmax, s2->zmin, s2->zmax,
+		                            cz2, uz2, &z2min, &z2max) )
+			continue;
+
+		for (y1 = 0; y1 < uy1; y1++)
+		{
+			double c1ymin = s1->ymin + y1 * cy1;
+			double c1ymax = c1ymin + cy1;
+			int y2min, y2max;
+
+			if ( ! histogram_axis_range(c1ymin, c1ymax, s2->ymin, s2->ymax,
+			                            cy2, uy2, &y2min, &y2max) )
+				continue;
+
+			for (x1 = 0; x1 < ux1; x1++)
+			{
+				double c1xmin = s1->xmin + x1 * cx1;
+				double c1xmax = c1xmin + cx1;
+				double val1 = s1->value[x1 + y1 * ux1 + z1 * ux1 * uy1];
+				int x2min, x2max;
+
+				if ( ! val1 ) continue;
+
+				if ( ! histogram_axis_range(c1xmin, c1xmax, s2->xmin, s2->xmax,
+				                            cx2, ux2, &x2min, &x2max) )
+					continue;
+
+				for (z2 = z2min; z2 <= z2max; z2++)
+				{
+					double fz = histogram_axis_overlap(c1zmin, c1zmax,
+					                                   s2->zmin + z2 * cz2, cz2);
+					if ( ! fz ) continue;
+
+					for (y2 = y2min; y2 <= y2max; y2++)
+					{
+						double fy = histogram_axis_overlap(c1ymin, c1ymax,
+						                                   s2->ymin + y2 * cy2, cy2);
+						if ( ! fy ) continue;
+
+						for (x2 = x2min; x2 <= x2max; x2++)
+						{
+							double val2 = s2->value[x2 + y2 * ux2 + z2 * ux2 * uy2];
+							double fx;
+
+							if ( ! val2 ) continue;
+
+							fx = histogram_axis_overlap(c1xmin, c1xmax,
+							                            s2->xmin + x2 * cx2, cx2);
+							value += val1 * val2 * fx * fy * fz;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/*
+	 * Convert the first side's average cell occupation to second
+	 * histogram units and work out the expected number of cells
+	 * shared by two overlapping average features, taken as cubes
+	 * (or squares, for 2D histograms) over the non-collapsed axes.
+	 */
+	if ( cx1 > 0 && cx2 > 0 ) { cell_ratio *= cx1 / cx2; ndims++; }
+	if ( cy1 > 0 && cy2 > 0 ) { cell_ratio *= cy1 / cy2; ndims++; }
+	if ( cz1 > 0 && cz2 > 0 ) { cell_ratio *= cz1 / cz2; ndims++; }
+
+	common_cells = 1;
+	if ( ndims )
+	{
+		side1 = Max(pow(s1->avgFeatureCells * cell_ratio, 1.0 / ndims) - 1, 0);
+		side2 = Max(pow(s2->avgFeatureCells, 1.0 / ndims) - 1, 0);
+		if ( side1 + side2 > 0 )
+			common_cells += side1 * side2 / (side1 + side2);
+		common_cells = pow(common_cells, ndims);
+	}
+
+	selectivity = value / common_cells;
+
+	POSTGIS_DEBUGF(3, " SUM(overlaid cells)=%.15g", value);
+	POSTGIS_DEBUGF(3, " common cells=%.15g", common_cells);
+	POSTGIS_DEBUGF(3, " join selectivity=%.15g", selectivity);
+
+	/* prevent rounding overflows */
+	if (selectivity > 1.0) selectivity = 1.0;
+	else if (selectivity < 0) selectivity = 0.0;
+
+	return selectivity;
+}
+
+
 /**
 * JOIN selectivity in the GiST && operator
 * for all PG versions
@@ -600,18 +734,14 @@ Datum geography_gist_join_selectivity(PG_FUNCTION_ARGS)
 	*/
 	GEOG_STATS **gs1ptr=&geogstats1, **gs2ptr=&geogstats2;
 	int geogstats1_nvalues = 0, geogstats2_nvalues = 0;
-	float8 selectivity1 = 0.0, selectivity2 = 0.0;
-	float4 num1_tuples = 0.0, num2_tuples = 0.0;
-	float4 total_tuples = 0.0, rows_returned = 0.0;
-	GBOX search_box;
+	float4 nullfrac1, nullfrac2;
+	float8 selectivity;
 
 
 	/**
-	* Join selectivity algorithm. To calculation the selectivity we
-	* calculate the intersection of the two column sample extents,
-	* sum the results, and then multiply by two since for each
-	* geometry in col 1 that intersects a geometry in col 2, the same
-	* will also be true.
+	* Join selectivity algorithm. The two column histograms are
+	* overlaid cell by cell (see estimate_join_selectivity), giving
+	* the fraction of not-null row pairs whose boxes overlap.
 	*/
 
 	POSTGIS_DEBUGF(3, "geography_gist_join_selectivity called with jointype %d", jointype);
@@ -693,41 +823,38 @@ Datum geography_gist_join_selectivity(PG_FUNCTION_ARGS)
 	}
 
 
-	/**
-	* Setup the search box - this is the intersection of the two column
-	* extents.
+	/*
+	* Histograms with no unit along some axis cannot be overlaid,
+	* stick to the default estimate.
 	*/
-	search_box.xmin = Max(geogstats1->xmin, geogstats2->xmin);
-	search_box.ymin = Max(geogstats1->ymin, geogstats2->ymin);
-	search_box.zmin = Max(geogstats1->zmin, geogstats2->zmin);
-	search_box.xmax = Min(geogstats1->xmax, geogstats2->xmax);
-	search_box.ymax = Min(geogstats1->ymax, geogstats2->ymax);
-	search_box.zmax = Min(geogstats1->zmax, geogstats2->zmax);
-
-	/* If the extents of the two columns don't intersect, return zero */
-	if (search_box.xmin > search_box.xmax || search_box.ymin > search_box.ymax ||
-	        search_box.zmin > search_box.zmax)
-		PG_RETURN_FLOAT8(0.0);
+	if ( geogstats1->unitsx < 1 || geogstats1->unitsy < 1 || geogstats1->unitsz < 1 ||
+	     geogstats2->unitsx < 1 || geogstats2->unitsy < 1 || geogstats2->unitsz < 1 )
+	{
+		POSTGIS_DEBUG(3, " degenerate histogram grid - returning default geography join selectivity");
+
+		free_attstatsslot(0, NULL, 0, (float *)geogstats1, geogstats1_nvalues);
+		free_attstatsslot(0, NULL, 0, (float *)geogstats2, geogstats2_nvalues);
+		ReleaseSysCache(stats2_tuple);
+		ReleaseSysCache(stats1_tuple);
+		PG_RETURN_FLOAT8(DEFAULT_GEOGRAPHY_SEL);
+	}
 
 	POSTGIS_DEBUGF(3, " -- geomstats1 box: %.15g %.15g %.15g, %.15g %.15g %.15g", geogstats1->xmin, geogstats1->ymin, geogstats1->zmin, geogstats1->xmax, geogstats1->ymax, geogstats1->zmax);
 	POSTGIS_DEBUGF(3, " -- geomstats2 box: %.15g %.15g %.15g, %.15g %.15g %.15g", geogstats2->xmin, geogstats2->ymin, geogstats2->zmin, geogstats2->xmax, geogstats2->ymax, geogstats2->zmax);
-	POSTGIS_DEBUGF(3, " -- calculated intersection box is : %.15g %.15g %.15g, %.15g %.15g %.15g", search_box.xmin, search_box.ymin, search_box.zmin, search_box.xmax, search_box.ymax, search_box.zmax);
-
-
-	/* Do the selectivity */
-	selectivity1 = estimate_selectivity(&search_box, geogstats1);
-	selectivity2 = estimate_selectivity(&search_box, geogstats2);
 
-	POSTGIS_DEBUGF(3, "selectivity1: %.15g   selectivity2: %.15g", selectivity1, selectivity2);
+	/* Overlay the two histograms */
+	selectivity = estimate_join_selectivity(geogstats1, geogstats2);
 
 	/*
-	* OK, so before we calculate the join selectivity we also need to
-	* know the number of tuples in each of the columns since
-	* estimate_selectivity returns the number of estimated tuples
-	* divided by the total number of tuples.
+	* The histograms only describe not-null values, which are the
+	* only ones that can ever match.
 	*/
-	num1_tuples = geogstats1->totalrows;
-	num2_tuples = geogstats2->totalrows;
+	nullfrac1 = ((Form_pg_statistic) GETSTRUCT(stats1_tuple))->stanullfrac;
+	nullfrac2 = ((Form_pg_statistic) GETSTRUCT(stats2_tuple))->stanullfrac;
+	selectivity *= (1.0 - nullfrac1) * (1.0 - nullfrac2);
+
+	POSTGIS_DEBUGF(3, "null fractions: %g %g", nullfrac1, nullfrac2);
+	POSTGIS_DEBUGF(3, "returning join selectivity: %.15g", selectivity);
 
 	/* Free the statistic tuples */
 	free_attstatsslot(0, NULL, 0, (float *)geogstats1, geogstats1_nvalues);
@@ -736,41 +863,7 @@ Datum geography_gist_join_selectivity(PG_FUNCTION_ARGS)
 	free_attstatsslot(0, NULL, 0, (float *)geogstats2, geogstats2_nvalues);
 	ReleaseSysCache(stats2_tuple);
 
-	/*
-	* Finally calculate the estimate of the number of rows returned
-	*
-	*    = 2 * (nrows from col1 + nrows from col2) /
-	*	total nrows in col1 x total nrows in col2
-	*
-	* The factor of 2 accounts for the fact that for each tuple in
-	* col 1 matching col 2,
-	* there will be another match in col 2 matching col 1
-	*/
-	total_tuples = num1_tuples * num2_tuples;
-	rows_returned = 2 * ((num1_tuples * selectivity1) + (num2_tuples * selectivity2));
-
-	POSTGIS_DEBUGF(3, "Rows from rel1: %f", num1_tuples * selectivity1);
-	POSTGIS_DEBUGF(3, "Rows from rel2: %f", num2_tuples * selectivity2);
-	POSTGIS_DEBUGF(3, "Estimated rows returned: %f", rows_returned);
-
-	/*
-	* One (or both) tuple count is zero...
-	* We return default selectivity estimate.
-	* We could probably attempt at an estimate
-	* w/out looking at tables tuple count, with
-	* a function of selectivity1, selectivity2.
-	*/
-	if ( ! total_tuples )
-	{
-		POSTGIS_DEBUG(3, "Total tuples == 0, returning default join selectivity");
-
-		PG_RETURN_FLOAT8(DEFAULT_GEOGRAPHY_SEL);
-	}
-
-	if ( rows_returned > total_tuples )
-		PG_RETURN_FLOAT8(1.0);
-
-	PG_RETURN_FLOAT8(rows_returned / total_tuples);
+	PG_RETURN_FLOAT8(selectivity);
 }
 
 
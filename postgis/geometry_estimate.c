@@ -15,17 +15,37 @@
 #include "postgres.h"
 #include "executor/spi.h"
 #include "fmgr.h"
+#include "access/genam.h"
+#include "access/gist_private.h" /* For GIST_ROOT_BLKNO */
+#include "access/heapam.h"
+#include "access/itup.h"
+#include "lib/stringinfo.h"
+#include "catalog/pg_am.h"
+#include "catalog/pg_opfamily.h"
+#include "catalog/pg_statistic.h"
 #include "commands/vacuum.h"
+#include "miscadmin.h"
 #include "nodes/relation.h"
 #include "parser/parsetree.h"
+#include "storage/bufmgr.h"
+#include "utils/acl.h"
 #include "utils/array.h"
+#include "utils/builtins.h"
 #include "utils/lsyscache.h"
+#include "utils/rel.h"
+#include "utils/selfuncs.h"
+#include "utils/snapmgr.h"
 #include "utils/syscache.h"
 
 #include "../postgis_config.h"
 #include "liblwgeom.h"
 #include "lwgeom_pg.h"       /* For debugging macros. */
 #include "gserialized_gist.h" /* For index common functions */
+#include "estimate_histogram.h" /* For the histogram axis helpers */
+
+#if POSTGIS_PGSQL_VERSION >= 92
+#include "access/visibilitymap.h" /* For the all-visible test of find_extent */
+#endif
 
 
 #include <math.h>
@@ -49,41 +69,117 @@
  * 	10000-32767: reserved for private site-local use
  *
  */
-#define STATISTIC_KIND_GEOMETRY 100
-
 /*
- * Define this if you want to use standard deviation based
- * histogram extent computation. If you do, you can also
- * tweak the deviation factor used in computation with
- * SDFACTOR.
+ * The 2D histogram used to be a uniform grid under kind 100. The
+ * bucket based one got a new number so that statistics gathered by
+ * older versions are ignored rather than misread until the next
+ * ANALYZE.
+ */
+#define STATISTIC_KIND_GEOMETRY 103
+
+/**
+ * Statistics kind of the N-dimensional histogram used by the
+ * estimators of the &&& operator. It is stored in the slot following
+ * the STATISTIC_KIND_GEOMETRY one.
+ */
+#define STATISTIC_KIND_ND 102
+
+/**
+ * Maximum number of dimensions of the N-D histogram. Matches the
+ * GIDX index keys, which are at most 4-dimensional.
+ */
+#define ND_DIMS 4
+
+/**
+ * Number of bins of the per-dimension histograms of feature centers
+ * used to spread the N-D histogram cells among the dimensions.
  */
-#define USE_STANDARD_DEVIATION 1
-#define SDFACTOR 3.25
+#define ND_BINS 50
+
+/**
+ * A bucket of the adaptive 2D histogram. Each bucket holds about
+ * the same number of sample features, grouped by the position of
+ * their bounding box centers, so crowded areas get many small
+ * buckets and sparse ones a few large buckets.
+ */
+typedef struct GEOM_BUCKET_T
+{
+	/* extent of the box centers of the bucket features */
+	float4 xmin, ymin, xmax, ymax;
+
+	/* average half width and half height of the bucket features */
+	float4 halfwidth, halfheight;
+
+	/* fraction of the sample features falling in this bucket */
+	float4 frac;
+}
+GEOM_BUCKET;
 
 typedef struct GEOM_STATS_T
 {
-	/* cols * rows = total boxes in grid */
-	float4 cols;
-	float4 rows;
+	/* number of buckets in the histogram */
+	float4 nbuckets;
 
 	/* average bounding box area of not-null features */
 	float4 avgFeatureArea;
 
+	/* average bounding box width and height of not-null features */
+	float4 avgFeatureWidth;
+	float4 avgFeatureHeight;
+
+	/*
+	 * BOX of area, read by geometry_estimated_extent
+	 * so it must stay at this offset
+	 */
+	float4 xmin,ymin, xmax, ymax;
+
+	/*
+	 * variable length # of buckets
+	 */
+	GEOM_BUCKET bucket[1];
+}
+GEOM_STATS;
+
+/**
+ * N-dimensional box with single precision ordinates, as found in
+ * the GIDX index keys. Dimensions missing from a key are set to 0,
+ * which is how the ND GiST operators compare keys of different
+ * dimensionality.
+ */
+typedef struct ND_BOX_T
+{
+	float4 min[ND_DIMS];
+	float4 max[ND_DIMS];
+}
+ND_BOX;
+
+typedef struct ND_STATS_T
+{
+	/* dimensionality of the sampled features */
+	float4 ndims;
+
+	/*
+	 * number of cells along each dimension,
+	 * 1 for collapsed or unused ones
+	 */
+	float4 size[ND_DIMS];
+
+	/* histogram extent, 0 on unused dimensions */
+	ND_BOX extent;
+
 	/*
 	 * average number of histogram cells
 	 * covered by the sample not-null features
 	 */
 	float4 avgFeatureCells;
 
-	/* BOX of area */
-	float4 xmin,ymin, xmax, ymax;
-
 	/*
-	 * variable length # of floats for histogram
+	 * variable length # of floats for histogram,
+	 * first dimension varying fastest
 	 */
 	float4 value[1];
 }
-GEOM_STATS;
+ND_STATS;
 
 static float8 estimate_selectivity(GBOX *box, GEOM_STATS *geomstats);
 
@@ -111,8 +207,14 @@ static float8 estimate_selectivity(GBOX *box, GEOM_STATS *geomstats);
 
 Datum geometry_gist_sel_2d(PG_FUNCTION_ARGS);
 Datum geometry_gist_joinsel_2d(PG_FUNCTION_ARGS);
+Datum geometry_gist_sel_nd(PG_FUNCTION_ARGS);
+Datum geometry_gist_joinsel_nd(PG_FUNCTION_ARGS);
+Datum gidx_gist_sel_nd(PG_FUNCTION_ARGS);
+Datum gidx_gist_joinsel_nd(PG_FUNCTION_ARGS);
+Datum gidx_analyze_nd(PG_FUNCTION_ARGS);
 Datum geometry_analyze_2d(PG_FUNCTION_ARGS);
 Datum geometry_estimated_extent(PG_FUNCTION_ARGS);
+Datum geometry_find_extent(PG_FUNCTION_ARGS);
 
 
 #if ! REALLY_DO_JOINSEL
@@ -131,30 +233,161 @@ Datum geometry_gist_joinsel(PG_FUNCTION_ARGS)
 
 #else /* REALLY_DO_JOINSEL */
 
+/**
+* Integral from -inf to s of the [0,l] clamped identity, the
+* building block of bucket_axis_band().
+*/
+static double
+bucket_axis_ramp(double s, double l)
+{
+	if ( s <= 0 ) return 0.0;
+	if ( s <= l ) return s * s / 2.0;
+	return l * l / 2.0 + l * (s - l);
+}
+
+/**
+* Area of the part of the [lo,hi]x[0,l] rectangle where y <= x + t.
+*/
+static double
+bucket_axis_band(double lo, double hi, double l, double t)
+{
+	return bucket_axis_ramp(hi + t, l) - bucket_axis_ramp(lo + t, l);
+}
+
+/**
+* Probability that two values drawn evenly from [a1,a2] and [c1,c2]
+* lie no more than r apart.
+*/
+static double
+bucket_axis_match(double a1, double a2, double c1, double c2, double r)
+{
+	double l1 = a2 - a1;
+	double l2 = c2 - c1;
+	double area;
+
+	if ( a1 - r > c2 || c1 - r > a2 )
+		return 0.0;
+
+	/* Collapsed ranges: share of the other range within r */
+	if ( l1 == 0 && l2 == 0 )
+		return 1.0;
+	if ( l1 == 0 )
+		return (Min(c2, a1 + r) - Max(c1, a1 - r)) / l2;
+	if ( l2 == 0 )
+		return (Min(a2, c1 + r) - Max(a1, c1 - r)) / l1;
+
+	/*
+	 * Area of the part of the [a1,a2]x[c1,c2] rectangle
+	 * where x - r <= y <= x + r, over the rectangle area.
+	 */
+	area = bucket_axis_band(a1 - c1, a2 - c1, l2, r) -
+	       bucket_axis_band(a1 - c1, a2 - c1, l2, -r);
+
+	area /= l1 * l2;
+	if ( area > 1.0 ) area = 1.0;
+	if ( area < 0.0 ) area = 0.0;
+	return area;
+}
+
 static int
-calculate_column_intersection(GBOX *search_box, GEOM_STATS *geomstats1, GEOM_STATS *geomstats2)
+geom_bucket_cmp_xmin(const void *a, const void *b)
 {
-	/**
-	* Calculate the intersection of two columns from their geomstats extents - return true
-	* if a valid intersection was found, false if there is no overlap
-	*/
+	float4 ax = (*(const GEOM_BUCKET **)a)->xmin;
+	float4 bx = (*(const GEOM_BUCKET **)b)->xmin;
+	return ax < bx ? -1 : (ax > bx ? 1 : 0);
+}
+
+/**
+* Estimate the fraction of the (not-null) cartesian product of two
+* columns whose boxes overlap, by matching the buckets of the first
+* histogram against the buckets of the second one.
+*
+* Two features overlap when their centers are closer, along each
+* axis, than the sum of their half sizes. With the features of a
+* bucket taken as having the bucket average size and centers evenly
+* spread over the bucket center extent, each pair of buckets
+* contributes the product of their fractions of features times the
+* probability of that happening on both axes.
+*
+* Histograms have up to 10 buckets per unit of statistics target, so
+* trying every pair gets far too slow for a planner estimate. The
+* buckets of the second histogram are sorted by xmin instead, and
+* each bucket of the first one only visits the window of xmin values
+* that can reach it: no further than its own half width plus the
+* largest half width and center extent width of the second histogram.
+*/
+static float8
+estimate_join_selectivity(const GEOM_STATS *s1, const GEOM_STATS *s2)
+{
+	int i, j;
+	int nb1 = s1->nbuckets, nb2 = s2->nbuckets;
+	const GEOM_BUCKET **sorted;
+	double maxhw2 = 0, maxw2 = 0;
+	float8 selectivity = 0.0;
+
+	/* The two histograms do not even touch */
+	if ( s1->xmax < s2->xmin || s1->xmin > s2->xmax ||
+	     s1->ymax < s2->ymin || s1->ymin > s2->ymax )
+	{
+		POSTGIS_DEBUG(3, " histogram extents do not overlap, returning 0");
+		return 0.0;
+	}
+
+	sorted = palloc(sizeof(GEOM_BUCKET *) * nb2);
+	for (j = 0; j < nb2; j++)
+	{
+		sorted[j] = &(s2->bucket[j]);
+		maxhw2 = Max(maxhw2, sorted[j]->halfwidth);
+		maxw2 = Max(maxw2, sorted[j]->xmax - sorted[j]->xmin);
+	}
+	qsort(sorted, nb2, sizeof(GEOM_BUCKET *), geom_bucket_cmp_xmin);
 
-	float8 i_xmin = Max(geomstats1->xmin, geomstats2->xmin);
-	float8 i_ymin = Max(geomstats1->ymin, geomstats2->ymin);
-	float8 i_xmax = Min(geomstats1->xmax, geomstats2->xmax);
-	float8 i_ymax = Min(geomstats1->ymax, geomstats2->ymax);
+	for (i = 0; i < nb1; i++)
+	{
+		const GEOM_BUCKET *b1 = &(s1->bucket[i]);
+		double lo = b1->xmin - b1->halfwidth - maxhw2 - maxw2;
+		double hi = b1->xmax + b1->halfwidth + maxhw2;
+		int first = 0, last = nb2;
+
+		/* First bucket with an xmin of at least lo */
+		while ( first < last )
+		{
+			int mid = (first + last) / 2;
+			if ( sorted[mid]->xmin < lo )
+				first = mid + 1;
+			else
+				last = mid;
+		}
+
+		for (j = first; j < nb2 && sorted[j]->xmin <= hi; j++)
+		{
+			const GEOM_BUCKET *b2 = sorted[j];
+			double rx = b1->halfwidth + b2->halfwidth;
+			double ry = b1->halfheight + b2->halfheight;
+			double px, py;
+
+			/* Quick reject of far away buckets */
+			if ( b1->xmin - rx > b2->xmax || b2->xmin - rx > b1->xmax ||
+			     b1->ymin - ry > b2->ymax || b2->ymin - ry > b1->ymax )
+				continue;
+
+			px = bucket_axis_match(b1->xmin, b1->xmax, b2->xmin, b2->xmax, rx);
+			if ( ! px ) continue;
+			py = bucket_axis_match(b1->ymin, b1->ymax, b2->ymin, b2->ymax, ry);
 
-	/* If the rectangles don't intersect, return false */
-	if (i_xmin > i_xmax || i_ymin > i_ymax)
-		return FALSE;
+			selectivity += b1->frac * b2->frac * px * py;
+		}
+	}
+
+	pfree(sorted);
+
+	POSTGIS_DEBUGF(3, " join selectivity=%.15g", selectivity);
 
-	/* Otherwise return the rectangle in search_box */
-	search_box->xmin = i_xmin;
-	search_box->ymin = i_ymin;
-	search_box->xmax = i_xmax;
-	search_box->ymax = i_ymax;
+	/* prevent rounding overflows */
+	if (selectivity > 1.0) selectivity = 1.0;
+	else if (selectivity < 0) selectivity = 0.0;
 
-	return TRUE;
+	return selectivity;
 }
 
 /**
@@ -174,7 +407,7 @@ Datum geometry_gist_joinsel_2d(PG_FUNCTION_ARGS)
 	Var *var1, *var2;
 	Oid relid1, relid2;
 
-	HeapTuple stats1_tuple, stats2_tuple, class_tuple;
+	HeapTuple stats1_tuple, stats2_tuple;
 	GEOM_STATS *geomstats1, *geomstats2;
 	/*
 	* These are to avoid casting the corresponding
@@ -183,18 +416,14 @@ Datum geometry_gist_joinsel_2d(PG_FUNCTION_ARGS)
 	*/
 	GEOM_STATS **gs1ptr=&geomstats1, **gs2ptr=&geomstats2;
 	int geomstats1_nvalues = 0, geomstats2_nvalues = 0;
-	float8 selectivity1 = 0.0, selectivity2 = 0.0;
-	float4 num1_tuples = 0.0, num2_tuples = 0.0;
-	float4 total_tuples = 0.0, rows_returned = 0.0;
-	GBOX search_box;
+	float4 nullfrac1, nullfrac2;
+	float8 selectivity;
 
 
 	/**
-	* Join selectivity algorithm. To calculation the selectivity we
-	* calculate the intersection of the two column sample extents,
-	* sum the results, and then multiply by two since for each
-	* geometry in col 1 that intersects a geometry in col 2, the same
-	* will also be true.
+	* Join selectivity algorithm. The two column histograms are
+	* matched bucket by bucket (see estimate_join_selectivity), giving
+	* the fraction of not-null row pairs whose boxes overlap.
 	*/
 
 
@@ -282,22 +511,22 @@ Datum geometry_gist_joinsel_2d(PG_FUNCTION_ARGS)
 	}
 
 
-	/**
-	* Setup the search box - this is the intersection of the two column
-	* extents.
-	*/
-	calculate_column_intersection(&search_box, geomstats1, geomstats2);
-
 	POSTGIS_DEBUGF(3, " -- geomstats1 box: %.15g %.15g, %.15g %.15g",geomstats1->xmin,geomstats1->ymin,geomstats1->xmax,geomstats1->ymax);
 	POSTGIS_DEBUGF(3, " -- geomstats2 box: %.15g %.15g, %.15g %.15g",geomstats2->xmin,geomstats2->ymin,geomstats2->xmax,geomstats2->ymax);
-	POSTGIS_DEBUGF(3, " -- calculated intersection box is : %.15g %.15g, %.15g %.15g",search_box.xmin,search_box.ymin,search_box.xmax,search_box.ymax);
 
+	/* Overlay the two histograms */
+	selectivity = estimate_join_selectivity(geomstats1, geomstats2);
 
-	/* Do the selectivity */
-	selectivity1 = estimate_selectivity(&search_box, geomstats1);
-	selectivity2 = estimate_selectivity(&search_box, geomstats2);
+	/*
+	* The histograms only describe not-null values, which are the
+	* only ones that can ever match.
+	*/
+	nullfrac1 = ((Form_pg_statistic) GETSTRUCT(stats1_tuple))->stanullfrac;
+	nullfrac2 = ((Form_pg_statistic) GETSTRUCT(stats2_tuple))->stanullfrac;
+	selectivity *= (1.0 - nullfrac1) * (1.0 - nullfrac2);
 
-	POSTGIS_DEBUGF(3, "selectivity1: %.15g   selectivity2: %.15g", selectivity1, selectivity2);
+	POSTGIS_DEBUGF(3, "null fractions: %g %g", nullfrac1, nullfrac2);
+	POSTGIS_DEBUGF(3, "returning join selectivity: %.15g", selectivity);
 
 	/* Free the statistic tuples */
 	free_attstatsslot(0, NULL, 0, (float *)geomstats1, geomstats1_nvalues);
@@ -306,106 +535,49 @@ Datum geometry_gist_joinsel_2d(PG_FUNCTION_ARGS)
 	free_attstatsslot(0, NULL, 0, (float *)geomstats2, geomstats2_nvalues);
 	ReleaseSysCache(stats2_tuple);
 
-	/*
-	* OK, so before we calculate the join selectivity we also need to
-	* know the number of tuples in each of the columns since
-	* estimate_selectivity returns the number of estimated tuples
-	* divided by the total number of tuples - hence we need to
-	* multiply out the returned selectivity by the total number of rows.
-	*/
-	class_tuple = SearchSysCache(RELOID, ObjectIdGetDatum(relid1),
-	                             0, 0, 0);
-
-	if (HeapTupleIsValid(class_tuple))
-	{
-		Form_pg_class reltup = (Form_pg_class) GETSTRUCT(class_tuple);
-		num1_tuples = reltup->reltuples;
-	}
-
-	ReleaseSysCache(class_tuple);
-
-
-	class_tuple = SearchSysCache(RELOID, ObjectIdGetDatum(relid2),
-	                             0, 0, 0);
-
-	if (HeapTupleIsValid(class_tuple))
-	{
-		Form_pg_class reltup = (Form_pg_class) GETSTRUCT(class_tuple);
-		num2_tuples = reltup->reltuples;
-	}
-
-	ReleaseSysCache(class_tuple);
-
-
-	/*
-	* Finally calculate the estimate of the number of rows returned
-	*
-	*    = 2 * (nrows from col1 + nrows from col2) /
-	*	total nrows in col1 x total nrows in col2
-	*
-	* The factor of 2 accounts for the fact that for each tuple in
-	* col 1 matching col 2,
-	* there will be another match in col 2 matching col 1
-	*/
+	PG_RETURN_FLOAT8(selectivity);
+}
 
-	total_tuples = num1_tuples * num2_tuples;
-	rows_returned = 2 * ((num1_tuples * selectivity1) +
-	                     (num2_tuples * selectivity2));
+#endif /* REALLY_DO_JOINSEL */
 
-	POSTGIS_DEBUGF(3, "Rows from rel1: %g", num1_tuples * selectivity1);
-	POSTGIS_DEBUGF(3, "Rows from rel2: %g", num2_tuples * selectivity2);
-	POSTGIS_DEBUGF(3, "Estimated rows returned: %g", rows_returned);
+/**************************** FROM POSTGIS ****************/
 
-	/*
-	* One (or both) tuple count is zero...
-	* We return default selectivity estimate.
-	* We could probably attempt at an estimate
-	* w/out looking at tables tuple count, with
-	* a function of selectivity1, selectivity2.
-	*/
-	if ( ! total_tuples )
-	{
-		POSTGIS_DEBUG(3, "Total tuples == 0, returning default join selectivity");
 
-		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_JOINSEL);
-	}
+/**
+ * Fraction of the [cmin,cmax] range of centers falling within
+ * [lo,hi], taking centers as evenly spread over their range.
+ */
+static double
+bucket_axis_fraction(double cmin, double cmax, double lo, double hi)
+{
+	if ( cmax < lo || cmin > hi )
+		return 0.0;
 
-	if ( rows_returned > total_tuples )
-		PG_RETURN_FLOAT8(1.0);
+	if ( cmax == cmin )
+		return 1.0;
 
-	PG_RETURN_FLOAT8(rows_returned / total_tuples);
+	return (Min(cmax, hi) - Max(cmin, lo)) / (cmax - cmin);
 }
 
-#endif /* REALLY_DO_JOINSEL */
-
-/**************************** FROM POSTGIS ****************/
-
-
 /**
  * This function returns an estimate of the selectivity
  * of a search_box looking at data in the GEOM_STATS
  * structure.
- * */
-/**
-* TODO: handle box dimension collapses (probably should be handled
-* by the statistic generator, avoiding GEOM_STATS with collapsed
-* dimensions)
-*/
+ *
+ * A feature overlaps the search box whenever its center is within
+ * the search box expanded by half the feature size. Taking the
+ * features of each bucket as having the bucket average size and
+ * their centers as evenly spread over the bucket center extent,
+ * each bucket contributes its fraction of features times the share
+ * of its center extent covered by the search box expanded by the
+ * bucket average half width and height.
+ */
 static float8
 estimate_selectivity(GBOX *box, GEOM_STATS *geomstats)
 {
-	int x, y;
-	int x_idx_min, x_idx_max, y_idx_min, y_idx_max;
-	double intersect_x, intersect_y, AOI;
-	double cell_area, box_area;
-	double geow, geoh; /* width and height of histogram */
-	int histocols, historows; /* histogram grid size */
-	double value;
-	float overlapping_cells;
-	float avg_feat_cells;
-	double gain;
-	float8 selectivity;
-
+	int i;
+	int nbuckets = geomstats->nbuckets;
+	float8 selectivity = 0.0;
 
 	/*
 	 * Search box completely miss histogram extent
@@ -433,172 +605,23 @@ estimate_selectivity(GBOX *box, GEOM_STATS *geomstats)
 		return 1.0;
 	}
 
-	geow = geomstats->xmax-geomstats->xmin;
-	geoh = geomstats->ymax-geomstats->ymin;
-
-	histocols = geomstats->cols;
-	historows = geomstats->rows;
-
-	POSTGIS_DEBUGF(3, " histogram has %d cols, %d rows", histocols, historows);
-	POSTGIS_DEBUGF(3, " histogram geosize is %fx%f", geow, geoh);
-
-	cell_area = (geow*geoh) / (histocols*historows);
-	box_area = (box->xmax-box->xmin)*(box->ymax-box->ymin);
-	value = 0;
-
-	/* Find first overlapping column */
-	x_idx_min = (box->xmin-geomstats->xmin) / geow * histocols;
-	if (x_idx_min < 0)
-	{
-		POSTGIS_DEBUGF(3, " search_box overlaps %d columns on the left of histogram grid", -x_idx_min);
-
-		/* should increment the value somehow */
-		x_idx_min = 0;
-	}
-	if (x_idx_min >= histocols)
-	{
-		POSTGIS_DEBUGF(3, " search_box overlaps %d columns on the right of histogram grid", x_idx_min-histocols+1);
-
-		/* should increment the value somehow */
-		x_idx_min = histocols-1;
-	}
-
-	/* Find first overlapping row */
-	y_idx_min = (box->ymin-geomstats->ymin) / geoh * historows;
-	if (y_idx_min <0)
-	{
-		POSTGIS_DEBUGF(3, " search_box overlaps %d columns on the bottom of histogram grid", -y_idx_min);
-
-		/* should increment the value somehow */
-		y_idx_min = 0;
-	}
-	if (y_idx_min >= historows)
-	{
-		POSTGIS_DEBUGF(3, " search_box overlaps %d columns on the top of histogram grid", y_idx_min-historows+1);
-
-		/* should increment the value somehow */
-		y_idx_min = historows-1;
-	}
-
-	/* Find last overlapping column */
-	x_idx_max = (box->xmax-geomstats->xmin) / geow * histocols;
-	if (x_idx_max <0)
-	{
-		/* should increment the value somehow */
-		x_idx_max = 0;
-	}
-	if (x_idx_max >= histocols )
-	{
-		/* should increment the value somehow */
-		x_idx_max = histocols-1;
-	}
-
-	/* Find last overlapping row */
-	y_idx_max = (box->ymax-geomstats->ymin) / geoh * historows;
-	if (y_idx_max <0)
+	for (i=0; i<nbuckets; i++)
 	{
-		/* should increment the value somehow */
-		y_idx_max = 0;
-	}
-	if (y_idx_max >= historows)
-	{
-		/* should increment the value somehow */
-		y_idx_max = historows-1;
-	}
-
-	/*
-	 * the {x,y}_idx_{min,max}
-	 * define the grid squares that the box intersects
-	 */
-	for (y=y_idx_min; y<=y_idx_max; y++)
-	{
-		for (x=x_idx_min; x<=x_idx_max; x++)
-		{
-			double val;
-			double gain;
+		const GEOM_BUCKET *b = &(geomstats->bucket[i]);
+		double fx, fy;
 
-			val = geomstats->value[x+y*histocols];
+		fx = bucket_axis_fraction(b->xmin, b->xmax,
+		                          box->xmin - b->halfwidth, box->xmax + b->halfwidth);
+		if ( ! fx ) continue;
 
-			/*
-			 * Of the cell value we get
-			 * only the overlap fraction.
-			 */
+		fy = bucket_axis_fraction(b->ymin, b->ymax,
+		                          box->ymin - b->halfheight, box->ymax + b->halfheight);
 
-			intersect_x = Min(box->xmax, geomstats->xmin + (x+1) * geow / histocols) - Max(box->xmin, geomstats->xmin + x * geow / histocols );
-			intersect_y = Min(box->ymax, geomstats->ymin + (y+1) * geoh / historows) - Max(box->ymin, geomstats->ymin+ y * geoh / historows) ;
+		POSTGIS_DEBUGF(4, " bucket %d: frac %g, fx %g, fy %g", i, b->frac, fx, fy);
 
-			AOI = intersect_x*intersect_y;
-			gain = AOI/cell_area;
-
-			POSTGIS_DEBUGF(4, " [%d,%d] cell val %.15f",
-			               x, y, val);
-			POSTGIS_DEBUGF(4, " [%d,%d] AOI %.15f",
-			               x, y, AOI);
-			POSTGIS_DEBUGF(4, " [%d,%d] gain %.15f",
-			               x, y, gain);
-
-			val *= gain;
-
-			POSTGIS_DEBUGF(4, " [%d,%d] adding %.15f to value",
-			               x, y, val);
-
-			value += val;
-		}
-	}
-
-
-	/*
-	 * If the search_box is a point, it will
-	 * overlap a single cell and thus get
-	 * it's value, which is the fraction of
-	 * samples (we can presume of row set also)
-	 * which bumped to that cell.
-	 *
-	 * If the table features are points, each
-	 * of them will overlap a single histogram cell.
-	 * Our search_box value would then be correctly
-	 * computed as the sum of the bumped cells values.
-	 *
-	 * If both our search_box AND the sample features
-	 * overlap more then a single histogram cell we
-	 * need to consider the fact that our sum computation
-	 * will have many duplicated included. E.g. each
-	 * single sample feature would have contributed to
-	 * raise the search_box value by as many times as
-	 * many cells in the histogram are commonly overlapped
-	 * by both search_box and feature. We should then
-	 * divide our value by the number of cells in the virtual
-	 * 'intersection' between average feature cell occupation
-	 * and occupation of the search_box. This is as
-	 * fuzzy as you understand it :)
-	 *
-	 * Consistency check: whenever the number of cells is
-	 * one of whichever part (search_box_occupation,
-	 * avg_feature_occupation) the 'intersection' must be 1.
-	 * If sounds that our 'intersaction' is actually the
-	 * minimun number between search_box_occupation and
-	 * avg_feat_occupation.
-	 *
-	 */
-	overlapping_cells = (x_idx_max-x_idx_min+1) *
-	                    (y_idx_max-y_idx_min+1);
-	avg_feat_cells = geomstats->avgFeatureCells;
-
-	POSTGIS_DEBUGF(3, " search_box overlaps %f cells", overlapping_cells);
-	POSTGIS_DEBUGF(3, " avg feat overlaps %f cells", avg_feat_cells);
-
-	if ( ! overlapping_cells )
-	{
-		POSTGIS_DEBUG(3, " no overlapping cells, returning 0.0");
-
-		return 0.0;
+		selectivity += b->frac * fx * fy;
 	}
 
-	gain = 1/Min(overlapping_cells, avg_feat_cells);
-	selectivity = value*gain;
-
-	POSTGIS_DEBUGF(3, " SUM(ov_histo_cells)=%f", value);
-	POSTGIS_DEBUGF(3, " gain=%f", gain);
 	POSTGIS_DEBUGF(3, " selectivity=%f", selectivity);
 
 	/* prevent rounding overflows */
@@ -736,10 +759,8 @@ Datum geometry_gist_sel_2d(PG_FUNCTION_ARGS)
 	               geomstats->xmin, geomstats->ymin);
 	POSTGIS_DEBUGF(4, " histo: xmax,ymax: %f,%f",
 	               geomstats->xmax, geomstats->ymax);
-	POSTGIS_DEBUGF(4, " histo: cols: %f", geomstats->rows);
-	POSTGIS_DEBUGF(4, " histo: rows: %f", geomstats->cols);
+	POSTGIS_DEBUGF(4, " histo: buckets: %f", geomstats->nbuckets);
 	POSTGIS_DEBUGF(4, " histo: avgFeatureArea: %f", geomstats->avgFeatureArea);
-	POSTGIS_DEBUGF(4, " histo: avgFeatureCells: %f", geomstats->avgFeatureCells);
 
 	/*
 	 * Do the estimation
@@ -757,89 +778,891 @@ Datum geometry_gist_sel_2d(PG_FUNCTION_ARGS)
 
 
 /**
- * This function is called by the analyze function iff
- * the geometry_analyze() function give it its pointer
- * (this is always the case so far).
- * The geometry_analyze() function is also responsible
- * of deciding the number of "sample" rows we will receive
- * here. It is able to give use other 'custom' data, but we
- * won't use them so far.
- *
- * Our job is to build some statistics on the sample data
- * for use by operator estimators.
- *
- * Currently we only need statistics to estimate the number of rows
- * overlapping a given extent (estimation function bound
- * to the && operator).
- *
+ * Fill an ND_BOX from a GIDX, setting the dimensions
+ * missing from the key to 0. Returns the key dimensionality.
  */
-static void
-compute_geometry_stats(VacAttrStats *stats, AnalyzeAttrFetchFunc fetchfunc,
-                       int samplerows, double totalrows)
+static int
+nd_box_from_gidx(GIDX *gidx, ND_BOX *nd_box)
 {
-	MemoryContext old_context;
-	int i;
-	int geom_stats_size;
-	GBOX **sampleboxes;
-	GEOM_STATS *geomstats;
-	bool isnull;
-	int null_cnt=0, notnull_cnt=0, examinedsamples=0;
-	GBOX *sample_extent=NULL;
-	double total_width=0;
-	double total_boxes_area=0;
-	int total_boxes_cells=0;
-	double cell_area;
-	double cell_width;
-	double cell_height;
-#if USE_STANDARD_DEVIATION
-	/* for standard deviation */
-	double avgLOWx, avgLOWy, avgHIGx, avgHIGy;
-	double sumLOWx=0, sumLOWy=0, sumHIGx=0, sumHIGy=0;
-	double sdLOWx=0, sdLOWy=0, sdHIGx=0, sdHIGy=0;
-	GBOX *newhistobox=NULL;
-#endif
-	double geow, geoh; /* width and height of histogram */
-	int histocells;
-	int cols, rows; /* histogram grid size */
-	GBOX histobox;
+	int d;
+	int ndims = GIDX_NDIMS(gidx);
 
-	/*
-	 * This is where geometry_analyze
-	 * should put its' custom parameters.
-	 */
-	/* void *mystats = stats->extra_data; */
+	if ( ndims > ND_DIMS ) ndims = ND_DIMS;
 
-	/*
-	 * We'll build an histogram having from 40 to 400 boxesPerSide
-	 * Total number of cells is determined by attribute stat
-	 * target. It can go from  1600 to 160000 (stat target: 10,1000)
-	 */
-	histocells = 160*stats->attr->attstattarget;
+	for ( d = 0; d < ND_DIMS; d++ )
+	{
+		if ( d < ndims )
+		{
+			nd_box->min[d] = GIDX_GET_MIN(gidx, d);
+			nd_box->max[d] = GIDX_GET_MAX(gidx, d);
+		}
+		else
+		{
+			nd_box->min[d] = nd_box->max[d] = 0.0;
+		}
+	}
+	return ndims;
+}
 
+/**
+ * Width of the N-D histogram cells along dimension d,
+ * 0 for collapsed dimensions.
+ */
+static double
+nd_stats_cell_size(const ND_STATS *nd_stats, int d)
+{
+	return (nd_stats->extent.max[d] - nd_stats->extent.min[d]) / nd_stats->size[d];
+}
 
-	POSTGIS_DEBUG(2, "compute_geometry_stats called");
-	POSTGIS_DEBUGF(3, " samplerows: %d", samplerows);
-	POSTGIS_DEBUGF(3, " histogram cells: %d", histocells);
+/**
+ * Find the range of N-D histogram cells covered by nd_box.
+ * Returns LW_FALSE if the box misses the histogram extent.
+ */
+static int
+nd_stats_cell_range(const ND_STATS *nd_stats, const ND_BOX *nd_box, int *min, int *max)
+{
+	int d;
 
-	/*
-	 * We might need less space, but don't think
-	 * its worth saving...
-	 */
-	sampleboxes = palloc(sizeof(GBOX *)*samplerows);
+	for ( d = 0; d < ND_DIMS; d++ )
+	{
+		if ( ! histogram_axis_range(nd_box->min[d], nd_box->max[d],
+		                            nd_stats->extent.min[d], nd_stats->extent.max[d],
+		                            nd_stats_cell_size(nd_stats, d), (int)nd_stats->size[d],
+		                            &(min[d]), &(max[d])) )
+			return LW_FALSE;
+	}
+	return LW_TRUE;
+}
 
-	/*
-	 * First scan:
+/**
+ * Step the at[] cell counter through the min[]/max[] range of cells,
+ * first dimension fastest. Returns LW_FALSE once the range is done.
+ */
+static int
+nd_increment(const int *min, const int *max, int *at)
+{
+	int d;
+
+	for ( d = 0; d < ND_DIMS; d++ )
+	{
+		if ( at[d] < max[d] )
+		{
+			at[d]++;
+			return LW_TRUE;
+		}
+		at[d] = min[d];
+	}
+	return LW_FALSE;
+}
+
+/**
+ * Offset in the N-D histogram values of the cell at at[].
+ */
+static int
+nd_stats_index(const ND_STATS *nd_stats, const int *at)
+{
+	int d;
+	int stride = 1;
+	int idx = 0;
+
+	for ( d = 0; d < ND_DIMS; d++ )
+	{
+		idx += at[d] * stride;
+		stride *= (int)nd_stats->size[d];
+	}
+	return idx;
+}
+
+/**
+ * Estimate the selectivity of an N-D search box looking at
+ * an ND_STATS grid: sum the histogram cell values weighted by the
+ * share of each cell covered by the search box, then correct for
+ * features spanning many cells.
+ */
+static float8
+estimate_selectivity_nd(const ND_BOX *nd_box, const ND_STATS *nd_stats)
+{
+	int d;
+	int min[ND_DIMS], max[ND_DIMS], at[ND_DIMS];
+	double cellsize[ND_DIMS];
+	double value = 0.0;
+	double overlapping_cells = 1.0;
+	int contains = LW_TRUE;
+	float8 selectivity;
+
+	if ( ! nd_stats_cell_range(nd_stats, nd_box, min, max) )
+	{
+		POSTGIS_DEBUG(3, " search_box does not overlaps histogram, returning 0");
+
+		return 0.0;
+	}
+
+	for ( d = 0; d < ND_DIMS; d++ )
+	{
+		if ( nd_box->min[d] > nd_stats->extent.min[d] ||
+		     nd_box->max[d] < nd_stats->extent.max[d] )
+			contains = LW_FALSE;
+
+		cellsize[d] = nd_stats_cell_size(nd_stats, d);
+		overlapping_cells *= max[d] - min[d] + 1;
+		at[d] = min[d];
+	}
+
+	if ( contains )
+	{
+		POSTGIS_DEBUG(3, " search_box contains histogram, returning 1");
+
+		return 1.0;
+	}
+
+	do
+	{
+		double val = nd_stats->value[nd_stats_index(nd_stats, at)];
+
+		for ( d = 0; val && d < ND_DIMS; d++ )
+		{
+			val *= histogram_axis_overlap(nd_box->min[d], nd_box->max[d],
+			                              nd_stats->extent.min[d] + at[d] * cellsize[d],
+			                              cellsize[d]);
+		}
+		value += val;
+	}
+	while ( nd_increment(min, max, at) );
+
+	/*
+	 * A feature spanning many cells was counted once per cell:
+	 * divide by the number of cells a feature shares on average
+	 * with the search box, which is at most the smallest of the
+	 * search box and average feature cell coverages.
+	 */
+	selectivity = value / Min(overlapping_cells, nd_stats->avgFeatureCells);
+
+	POSTGIS_DEBUGF(3, " SUM(ov_histo_cells)=%f", value);
+	POSTGIS_DEBUGF(3, " overlapping cells=%f", overlapping_cells);
+	POSTGIS_DEBUGF(3, " selectivity=%f", selectivity);
+
+	/* prevent rounding overflows */
+	if (selectivity > 1.0) selectivity = 1.0;
+	else if (selectivity < 0) selectivity = 0.0;
+
+	return selectivity;
+}
+
+/**
+ * Estimate the fraction of the (not-null) cartesian product of two
+ * columns whose N-D boxes overlap, by overlaying their ND_STATS
+ * grids cell by cell: for every pair of overlapping cells the
+ * product of the two values, scaled by the share of the second cell
+ * covered by the first one, is the fraction of feature pairs meeting
+ * there.
+ */
+static float8
+estimate_join_selectivity_nd(const ND_STATS *s1, const ND_STATS *s2)
+{
+	int d;
+	int min1[ND_DIMS], max1[ND_DIMS], at1[ND_DIMS];
+	int min2[ND_DIMS], max2[ND_DIMS], at2[ND_DIMS];
+	double cellsize1[ND_DIMS], cellsize2[ND_DIMS];
+	double cell_ratio = 1.0;
+	double side1, side2, common_cells;
+	int ndims = 0;
+	double value = 0.0;
+	float8 selectivity;
+
+	/* The two histograms do not even touch */
+	if ( ! nd_stats_cell_range(s2, &(s1->extent), min2, max2) )
+	{
+		POSTGIS_DEBUG(3, " histogram extents do not overlap, returning 0");
+		return 0.0;
+	}
+
+	for ( d = 0; d < ND_DIMS; d++ )
+	{
+		cellsize1[d] = nd_stats_cell_size(s1, d);
+		cellsize2[d] = nd_stats_cell_size(s2, d);
+		min1[d] = at1[d] = 0;
+		max1[d] = (int)s1->size[d] - 1;
+	}
+
+	do
+	{
+		double val1 = s1->value[nd_stats_index(s1, at1)];
+		ND_BOX cell;
+
+		if ( ! val1 ) continue;
+
+		for ( d = 0; d < ND_DIMS; d++ )
+		{
+			cell.min[d] = s1->extent.min[d] + at1[d] * cellsize1[d];
+			cell.max[d] = cell.min[d] + cellsize1[d];
+		}
+
+		if ( ! nd_stats_cell_range(s2, &cell, min2, max2) )
+			continue;
+
+		memcpy(at2, min2, sizeof(at2));
+		do
+		{
+			double val = val1 * s2->value[nd_stats_index(s2, at2)];
+
+			for ( d = 0; val && d < ND_DIMS; d++ )
+			{
+				val *= histogram_axis_overlap(cell.min[d], cell.max[d],
+				                              s2->extent.min[d] + at2[d] * cellsize2[d],
+				                              cellsize2[d]);
+			}
+			value += val;
+		}
+		while ( nd_increment(min2, max2, at2) );
+	}
+	while ( nd_increment(min1, max1, at1) );
+
+	/*
+	 * A pair of overlapping features is counted once for every
+	 * second histogram cell covered by both. Taking the average
+	 * features as cubes spanning e1 and e2 cells per side (the first
+	 * side converted to second histogram units through the cell size
+	 * ratio), two randomly placed overlapping ones share on average
+	 * L1*L2/(L1+L2) of length per side, L being e-1, plus the one cell
+	 * even touching features have in common.
+	 */
+	for ( d = 0; d < ND_DIMS; d++ )
+	{
+		if ( cellsize1[d] > 0 && cellsize2[d] > 0 )
+		{
+			cell_ratio *= cellsize1[d] / cellsize2[d];
+			ndims++;
+		}
+	}
+
+	common_cells = 1;
+	if ( ndims )
+	{
+		side1 = Max(pow(s1->avgFeatureCells * cell_ratio, 1.0 / ndims) - 1, 0);
+		side2 = Max(pow(s2->avgFeatureCells, 1.0 / ndims) - 1, 0);
+		if ( side1 + side2 > 0 )
+			common_cells += side1 * side2 / (side1 + side2);
+		common_cells = pow(common_cells, ndims);
+	}
+
+	selectivity = value / common_cells;
+
+	POSTGIS_DEBUGF(3, " SUM(overlaid cells)=%.15g", value);
+	POSTGIS_DEBUGF(3, " common cells=%.15g", common_cells);
+	POSTGIS_DEBUGF(3, " join selectivity=%.15g", selectivity);
+
+	/* prevent rounding overflows */
+	if (selectivity > 1.0) selectivity = 1.0;
+	else if (selectivity < 0) selectivity = 0.0;
+
+	return selectivity;
+}
+
+/**
+ * Restriction selectivity of the &&& operator, looking at the
+ * N-D histogram gathered by ANALYZE.
+ */
+PG_FUNCTION_INFO_V1(geometry_gist_sel_nd);
+Datum geometry_gist_sel_nd(PG_FUNCTION_ARGS)
+{
+	PlannerInfo *root = (PlannerInfo *) PG_GETARG_POINTER(0);
+
+	/* Oid operator = PG_GETARG_OID(1); */
+	List *args = (List *) PG_GETARG_POINTER(2);
+	/* int varRelid = PG_GETARG_INT32(3); */
+	Oid relid;
+	HeapTuple stats_tuple;
+	ND_STATS *nd_stats;
+	ND_STATS **nsptr = &nd_stats;
+	int nd_stats_nvalues = 0;
+	Node *other;
+	Var *self;
+	char gidxmem[GIDX_MAX_SIZE];
+	GIDX *gidx = (GIDX*)gidxmem;
+	ND_BOX search_box;
+	float8 selectivity;
+
+	POSTGIS_DEBUG(2, "geometry_gist_sel_nd called");
+
+	/* Fail if not a binary opclause (probably shouldn't happen) */
+	if (list_length(args) != 2)
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_SEL);
+
+	/*
+	 * Find the constant part
+	 */
+	other = (Node *) linitial(args);
+	if ( ! IsA(other, Const) )
+	{
+		self = (Var *)other;
+		other = (Node *) lsecond(args);
+	}
+	else
+	{
+		self = (Var *) lsecond(args);
+	}
+
+	if ( ! IsA(other, Const) || ! IsA(self, Var) )
+	{
+		POSTGIS_DEBUG(3, " not a column against constant clause - returning default selectivity");
+
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_SEL);
+	}
+
+	if ( LW_FAILURE == gserialized_datum_get_gidx_p(((Const*)other)->constvalue, gidx) )
+	{
+		POSTGIS_DEBUG(3, "search box is EMPTY");
+		PG_RETURN_FLOAT8(0.0);
+	}
+	nd_box_from_gidx(gidx, &search_box);
+
+	/*
+	 * Get pg_statistic row
+	 */
+	relid = getrelid(self->varno, root->parse->rtable);
+
+	stats_tuple = SearchSysCache(STATRELATT, ObjectIdGetDatum(relid), Int16GetDatum(self->varattno), 0, 0);
+	if ( ! stats_tuple )
+	{
+		POSTGIS_DEBUG(3, " No statistics, returning default estimate");
+
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_SEL);
+	}
+
+	if ( ! get_attstatsslot(stats_tuple, 0, 0, STATISTIC_KIND_ND, InvalidOid, NULL, NULL,
+#if POSTGIS_PGSQL_VERSION > 84
+	                        NULL,
+#endif
+	                        (float4 **)nsptr, &nd_stats_nvalues) )
+	{
+		POSTGIS_DEBUG(3, " STATISTIC_KIND_ND stats not found - returning default geometry selectivity");
+
+		ReleaseSysCache(stats_tuple);
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_SEL);
+	}
+
+	POSTGIS_DEBUGF(4, " histo: %gD, %gx%gx%gx%g cells", nd_stats->ndims,
+	               nd_stats->size[0], nd_stats->size[1], nd_stats->size[2], nd_stats->size[3]);
+
+	selectivity = estimate_selectivity_nd(&search_box, nd_stats);
+
+	POSTGIS_DEBUGF(3, " returning computed value: %f", selectivity);
+
+	free_attstatsslot(0, NULL, 0, (float *)nd_stats, nd_stats_nvalues);
+	ReleaseSysCache(stats_tuple);
+	PG_RETURN_FLOAT8(selectivity);
+}
+
+/**
+ * Join selectivity of the &&& operator, overlaying
+ * the N-D histograms of the two columns.
+ */
+PG_FUNCTION_INFO_V1(geometry_gist_joinsel_nd);
+Datum geometry_gist_joinsel_nd(PG_FUNCTION_ARGS)
+{
+	PlannerInfo *root = (PlannerInfo *) PG_GETARG_POINTER(0);
+
+	/* Oid operator = PG_GETARG_OID(1); */
+	List *args = (List *) PG_GETARG_POINTER(2);
+	JoinType jointype = (JoinType) PG_GETARG_INT16(3);
+
+	Node *arg1, *arg2;
+	Var *var1, *var2;
+	Oid relid1, relid2;
+	HeapTuple stats1_tuple, stats2_tuple;
+	ND_STATS *nd_stats1, *nd_stats2;
+	ND_STATS **ns1ptr = &nd_stats1, **ns2ptr = &nd_stats2;
+	int nd_stats1_nvalues = 0, nd_stats2_nvalues = 0;
+	float4 nullfrac1, nullfrac2;
+	float8 selectivity;
+
+	POSTGIS_DEBUGF(3, "geometry_gist_joinsel_nd called with jointype %d", jointype);
+
+	/*
+	* We'll only respond to an inner join/unknown context join
+	*/
+	if (jointype != JOIN_INNER)
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_JOINSEL);
+
+	arg1 = (Node *) linitial(args);
+	arg2 = (Node *) lsecond(args);
+
+	if (!IsA(arg1, Var) || !IsA(arg2, Var))
+	{
+		elog(DEBUG1, "geometry_gist_joinsel_nd called with arguments that are not column references");
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_JOINSEL);
+	}
+
+	var1 = (Var *)arg1;
+	var2 = (Var *)arg2;
+
+	relid1 = getrelid(var1->varno, root->parse->rtable);
+	relid2 = getrelid(var2->varno, root->parse->rtable);
+
+	/* Read the stats tuple from the first column */
+	stats1_tuple = SearchSysCache(STATRELATT, ObjectIdGetDatum(relid1), Int16GetDatum(var1->varattno), 0, 0);
+	if ( ! stats1_tuple )
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_JOINSEL);
+
+	if ( ! get_attstatsslot(stats1_tuple, 0, 0, STATISTIC_KIND_ND, InvalidOid, NULL, NULL,
+#if POSTGIS_PGSQL_VERSION > 84
+	                        NULL,
+#endif
+	                        (float4 **)ns1ptr, &nd_stats1_nvalues) )
+	{
+		ReleaseSysCache(stats1_tuple);
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_JOINSEL);
+	}
+
+	/* Read the stats tuple from the second column */
+	stats2_tuple = SearchSysCache(STATRELATT, ObjectIdGetDatum(relid2), Int16GetDatum(var2->varattno), 0, 0);
+	if ( ! stats2_tuple )
+	{
+		free_attstatsslot(0, NULL, 0, (float *)nd_stats1, nd_stats1_nvalues);
+		ReleaseSysCache(stats1_tuple);
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_JOINSEL);
+	}
+
+	if ( ! get_attstatsslot(stats2_tuple, 0, 0, STATISTIC_KIND_ND, InvalidOid, NULL, NULL,
+#if POSTGIS_PGSQL_VERSION > 84
+	                        NULL,
+#endif
+	                        (float4 **)ns2ptr, &nd_stats2_nvalues) )
+	{
+		free_attstatsslot(0, NULL, 0, (float *)nd_stats1, nd_stats1_nvalues);
+		ReleaseSysCache(stats2_tuple);
+		ReleaseSysCache(stats1_tuple);
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_JOINSEL);
+	}
+
+	selectivity = estimate_join_selectivity_nd(nd_stats1, nd_stats2);
+
+	nullfrac1 = ((Form_pg_statistic) GETSTRUCT(stats1_tuple))->stanullfrac;
+	nullfrac2 = ((Form_pg_statistic) GETSTRUCT(stats2_tuple))->stanullfrac;
+	selectivity *= (1.0 - nullfrac1) * (1.0 - nullfrac2);
+
+	POSTGIS_DEBUGF(3, "returning join selectivity: %.15g", selectivity);
+
+	free_attstatsslot(0, NULL, 0, (float *)nd_stats1, nd_stats1_nvalues);
+	ReleaseSysCache(stats1_tuple);
+
+	free_attstatsslot(0, NULL, 0, (float *)nd_stats2, nd_stats2_nvalues);
+	ReleaseSysCache(stats2_tuple);
+
+	PG_RETURN_FLOAT8(selectivity);
+}
+
+/**
+ * Read the N-D histogram of a planner variable. Unlike the geometry
+ * estimators above this also finds the statistics ANALYZE keeps for
+ * index expressions, such as the ST_STKey() of a spatio-temporal index.
+ * The slot must be released with free_attstatsslot().
+ */
+static int
+nd_stats_from_vardata(VariableStatData *vardata, ND_STATS **nd_stats, int *nvalues)
+{
+	if ( ! HeapTupleIsValid(vardata->statsTuple) )
+		return LW_FALSE;
+
+	return get_attstatsslot(vardata->statsTuple, 0, 0, STATISTIC_KIND_ND, InvalidOid, NULL, NULL,
+#if POSTGIS_PGSQL_VERSION > 84
+	                        NULL,
+#endif
+	                        (float4 **)nd_stats, nvalues) ? LW_TRUE : LW_FALSE;
+}
+
+/**
+ * Restriction selectivity of the GIDX &&& operator.
+ */
+PG_FUNCTION_INFO_V1(gidx_gist_sel_nd);
+Datum gidx_gist_sel_nd(PG_FUNCTION_ARGS)
+{
+	PlannerInfo *root = (PlannerInfo *) PG_GETARG_POINTER(0);
+
+	/* Oid operator = PG_GETARG_OID(1); */
+	List *args = (List *) PG_GETARG_POINTER(2);
+	int varRelid = PG_GETARG_INT32(3);
+	VariableStatData vardata;
+	Node *other;
+	bool varonleft;
+	ND_STATS *nd_stats;
+	int nd_stats_nvalues = 0;
+	ND_BOX search_box;
+	float8 selectivity;
+
+	POSTGIS_DEBUG(2, "gidx_gist_sel_nd called");
+
+	if ( ! get_restriction_variable(root, args, varRelid, &vardata, &other, &varonleft) )
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_SEL);
+
+	if ( ! IsA(other, Const) )
+	{
+		POSTGIS_DEBUG(3, " not a key against constant clause - returning default selectivity");
+
+		ReleaseVariableStats(vardata);
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_SEL);
+	}
+
+	/* NULL search keys, from empty search geometries, match nothing */
+	if ( ((Const*)other)->constisnull )
+	{
+		ReleaseVariableStats(vardata);
+		PG_RETURN_FLOAT8(0.0);
+	}
+
+	nd_box_from_gidx((GIDX*)PG_DETOAST_DATUM(((Const*)other)->constvalue), &search_box);
+
+	if ( ! nd_stats_from_vardata(&vardata, &nd_stats, &nd_stats_nvalues) )
+	{
+		POSTGIS_DEBUG(3, " STATISTIC_KIND_ND stats not found - returning default selectivity");
+
+		ReleaseVariableStats(vardata);
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_SEL);
+	}
+
+	selectivity = estimate_selectivity_nd(&search_box, nd_stats);
+	selectivity *= 1.0 - ((Form_pg_statistic) GETSTRUCT(vardata.statsTuple))->stanullfrac;
+
+	POSTGIS_DEBUGF(3, " returning computed value: %f", selectivity);
+
+	free_attstatsslot(0, NULL, 0, (float *)nd_stats, nd_stats_nvalues);
+	ReleaseVariableStats(vardata);
+	PG_RETURN_FLOAT8(selectivity);
+}
+
+/**
+ * Join selectivity of the GIDX &&& operator.
+ */
+PG_FUNCTION_INFO_V1(gidx_gist_joinsel_nd);
+Datum gidx_gist_joinsel_nd(PG_FUNCTION_ARGS)
+{
+	PlannerInfo *root = (PlannerInfo *) PG_GETARG_POINTER(0);
+
+	/* Oid operator = PG_GETARG_OID(1); */
+	List *args = (List *) PG_GETARG_POINTER(2);
+	JoinType jointype = (JoinType) PG_GETARG_INT16(3);
+	VariableStatData vardata1, vardata2;
+	ND_STATS *nd_stats1, *nd_stats2;
+	int nd_stats1_nvalues = 0, nd_stats2_nvalues = 0;
+	float4 nullfrac1, nullfrac2;
+	float8 selectivity = DEFAULT_GEOMETRY_JOINSEL;
+
+	POSTGIS_DEBUGF(3, "gidx_gist_joinsel_nd called with jointype %d", jointype);
+
+	if ( jointype != JOIN_INNER || list_length(args) != 2 )
+		PG_RETURN_FLOAT8(DEFAULT_GEOMETRY_JOINSEL);
+
+	examine_variable(root, (Node *) linitial(args), 0, &vardata1);
+	examine_variable(root, (Node *) lsecond(args), 0, &vardata2);
+
+	if ( nd_stats_from_vardata(&vardata1, &nd_stats1, &nd_stats1_nvalues) )
+	{
+		if ( nd_stats_from_vardata(&vardata2, &nd_stats2, &nd_stats2_nvalues) )
+		{
+			selectivity = estimate_join_selectivity_nd(nd_stats1, nd_stats2);
+
+			nullfrac1 = ((Form_pg_statistic) GETSTRUCT(vardata1.statsTuple))->stanullfrac;
+			nullfrac2 = ((Form_pg_statistic) GETSTRUCT(vardata2.statsTuple))->stanullfrac;
+			selectivity *= (1.0 - nullfrac1) * (1.0 - nullfrac2);
+
+			free_attstatsslot(0, NULL, 0, (float *)nd_stats2, nd_stats2_nvalues);
+		}
+		free_attstatsslot(0, NULL, 0, (float *)nd_stats1, nd_stats1_nvalues);
+	}
+
+	POSTGIS_DEBUGF(3, "returning join selectivity: %.15g", selectivity);
+
+	ReleaseVariableStats(vardata1);
+	ReleaseVariableStats(vardata2);
+	PG_RETURN_FLOAT8(selectivity);
+}
+
+/**
+ * Build the N-D histogram from the sample boxes collected by
+ * compute_geometry_stats(). The histogram covers the whole sample
+ * extent and gets about histocells cells in total, spread among the
+ * dimensions according to how the feature centers are scattered
+ * along each of them: the more unevenly they fall in ND_BINS equal
+ * slices of a dimension, the larger the share of the cells (as an
+ * exponent of histocells) that dimension gets. Evenly spread
+ * dimensions, such as a uniformly sampled time, get fewer cells and
+ * collapsed dimensions a single one.
+ *
+ * Returns NULL if there is nothing to build the histogram from.
+ */
+static ND_STATS*
+compute_nd_stats(VacAttrStats *stats, const ND_BOX *nd_boxes, int nboxes,
+                 int ndims, int histocells, int *nd_stats_size)
+{
+	MemoryContext old_context;
+	ND_STATS *nd_stats;
+	ND_BOX extent;
+	double weight[ND_DIMS];
+	double total_weight = 0.0;
+	int size[ND_DIMS];
+	int ncells = 1;
+	int total_cells = 0;
+	int i, d;
+
+	if ( nboxes < 1 ) return NULL;
+
+	/* Sample extent */
+	memcpy(&extent, &(nd_boxes[0]), sizeof(ND_BOX));
+	for ( i = 1; i < nboxes; i++ )
+	{
+		for ( d = 0; d < ND_DIMS; d++ )
+		{
+			extent.min[d] = Min(extent.min[d], nd_boxes[i].min[d]);
+			extent.max[d] = Max(extent.max[d], nd_boxes[i].max[d]);
+		}
+	}
+
+	/* How unevenly are the features spread along each dimension ? */
+	for ( d = 0; d < ND_DIMS; d++ )
+	{
+		double width = extent.max[d] - extent.min[d];
+		double mean = (double)nboxes / ND_BINS;
+		double variance = 0.0;
+		int bins[ND_BINS];
+
+		weight[d] = 0.0;
+		if ( d >= ndims || width <= 0 ) continue;
+
+		memset(bins, 0, sizeof(bins));
+		for ( i = 0; i < nboxes; i++ )
+		{
+			double center = (nd_boxes[i].min[d] + nd_boxes[i].max[d]) / 2.0;
+			int bin = (center - extent.min[d]) / width * ND_BINS;
+			if ( bin < 0 ) bin = 0;
+			if ( bin >= ND_BINS ) bin = ND_BINS - 1;
+			bins[bin]++;
+		}
+		for ( i = 0; i < ND_BINS; i++ )
+			variance += (bins[i] - mean) * (bins[i] - mean);
+		variance /= ND_BINS;
+
+		/* 1 plus the coefficient of variation of the bin counts */
+		weight[d] = 1.0 + sqrt(variance) / mean;
+		total_weight += weight[d];
+	}
+
+	for ( d = 0; d < ND_DIMS; d++ )
+	{
+		size[d] = 1;
+		if ( weight[d] > 0 )
+			size[d] = Max(1, (int)floor(pow(histocells, weight[d] / total_weight) + 0.5));
+		ncells *= size[d];
+
+		POSTGIS_DEBUGF(3, " dimension %d: weight %g, %d cells", d, weight[d], size[d]);
+	}
+
+	old_context = MemoryContextSwitchTo(stats->anl_context);
+	*nd_stats_size = sizeof(ND_STATS) + (ncells - 1) * sizeof(float4);
+	nd_stats = palloc0(*nd_stats_size);
+	MemoryContextSwitchTo(old_context);
+
+	nd_stats->ndims = ndims;
+	memcpy(&(nd_stats->extent), &extent, sizeof(ND_BOX));
+	for ( d = 0; d < ND_DIMS; d++ )
+		nd_stats->size[d] = size[d];
+
+	/* Count every cell touched by every feature */
+	for ( i = 0; i < nboxes; i++ )
+	{
+		int min[ND_DIMS], max[ND_DIMS], at[ND_DIMS];
+
+		/* The extent covers all boxes, so the range is never empty */
+		nd_stats_cell_range(nd_stats, &(nd_boxes[i]), min, max);
+		memcpy(at, min, sizeof(at));
+		do
+		{
+			nd_stats->value[nd_stats_index(nd_stats, at)] += 1;
+			total_cells++;
+		}
+		while ( nd_increment(min, max, at) );
+
+		/* give backend a chance of interrupting us */
+		vacuum_delay_point();
+	}
+
+	nd_stats->avgFeatureCells = (float4)total_cells / nboxes;
+
+	/* Normalize histogram */
+	for ( i = 0; i < ncells; i++ )
+		nd_stats->value[i] /= nboxes;
+
+	POSTGIS_DEBUGF(3, " nd histogram: %dD, %d cells, avgFeatureCells %f",
+	               ndims, ncells, nd_stats->avgFeatureCells);
+
+	return nd_stats;
+}
+
+
+/**
+ * Center and half sizes of a sample feature box,
+ * as used to build the adaptive histogram.
+ */
+typedef struct GEOM_SAMPLE_T
+{
+	double x, y;
+	double halfwidth, halfheight;
+}
+GEOM_SAMPLE;
+
+static int
+geom_sample_cmp_x(const void *a, const void *b)
+{
+	double ax = ((const GEOM_SAMPLE *)a)->x;
+	double bx = ((const GEOM_SAMPLE *)b)->x;
+	return ax < bx ? -1 : (ax > bx ? 1 : 0);
+}
+
+static int
+geom_sample_cmp_y(const void *a, const void *b)
+{
+	double ay = ((const GEOM_SAMPLE *)a)->y;
+	double by = ((const GEOM_SAMPLE *)b)->y;
+	return ay < by ? -1 : (ay > by ? 1 : 0);
+}
+
+/**
+ * Recursively split the samples into nbuckets buckets of about
+ * the same size, cutting across the longest side of the centers
+ * extent at the matching quantile (a kd-tree with the buckets as
+ * leaves). The cut falls at a fixed rank, so samples sharing a
+ * center may end up on both sides of it. A group whose centers all
+ * coincide is not split any further, so fewer buckets than requested
+ * may come out: they are appended to geomstats, whose nbuckets gets
+ * updated.
+ */
+static void
+build_geometry_buckets(GEOM_SAMPLE *samples, int nsamples, int nbuckets,
+                       int totalsamples, GEOM_STATS *geomstats)
+{
+	GEOM_BUCKET *b;
+	double xmin, ymin, xmax, ymax;
+	double sumhw = 0, sumhh = 0;
+	int i;
+
+	xmin = xmax = samples[0].x;
+	ymin = ymax = samples[0].y;
+	for (i=1; i<nsamples; i++)
+	{
+		xmin = Min(xmin, samples[i].x);
+		xmax = Max(xmax, samples[i].x);
+		ymin = Min(ymin, samples[i].y);
+		ymax = Max(ymax, samples[i].y);
+	}
+
+	if ( nbuckets > 1 && nsamples > 1 && (xmax > xmin || ymax > ymin) )
+	{
+		int nleft_buckets = nbuckets / 2;
+		int nleft = (double)nsamples * nleft_buckets / nbuckets;
+
+		if ( nleft < 1 ) nleft = 1;
+		if ( nleft > nsamples - 1 ) nleft = nsamples - 1;
+
+		qsort(samples, nsamples, sizeof(GEOM_SAMPLE),
+		      (xmax - xmin) >= (ymax - ymin) ? geom_sample_cmp_x : geom_sample_cmp_y);
+
+		build_geometry_buckets(samples, nleft, nleft_buckets,
+		                       totalsamples, geomstats);
+		build_geometry_buckets(samples + nleft, nsamples - nleft, nbuckets - nleft_buckets,
+		                       totalsamples, geomstats);
+		return;
+	}
+
+	for (i=0; i<nsamples; i++)
+	{
+		sumhw += samples[i].halfwidth;
+		sumhh += samples[i].halfheight;
+	}
+
+	b = &(geomstats->bucket[(int)geomstats->nbuckets]);
+	b->xmin = xmin;
+	b->ymin = ymin;
+	b->xmax = xmax;
+	b->ymax = ymax;
+	b->halfwidth = sumhw / nsamples;
+	b->halfheight = sumhh / nsamples;
+	b->frac = (float4)nsamples / totalsamples;
+	geomstats->nbuckets++;
+
+	POSTGIS_DEBUGF(4, " bucket %g: %d samples, centers %g %g, %g %g",
+	               geomstats->nbuckets, nsamples, xmin, ymin, xmax, ymax);
+}
+
+/**
+ * This function is called by the analyze function iff
+ * the geometry_analyze() function give it its pointer
+ * (this is always the case so far).
+ * The geometry_analyze() function is also responsible
+ * of deciding the number of "sample" rows we will receive
+ * here. It is able to give use other 'custom' data, but we
+ * won't use them so far.
+ *
+ * Our job is to build some statistics on the sample data
+ * for use by operator estimators.
+ *
+ * Currently we only need statistics to estimate the number of rows
+ * overlapping a given extent (estimation function bound
+ * to the && operator).
+ *
+ */
+static void
+compute_geometry_stats(VacAttrStats *stats, AnalyzeAttrFetchFunc fetchfunc,
+                       int samplerows, double totalrows)
+{
+	MemoryContext old_context;
+	int i;
+	int geom_stats_size;
+	GEOM_SAMPLE *samples;
+	GEOM_STATS *geomstats;
+	ND_BOX *sample_nd_boxes;
+	ND_STATS *nd_stats;
+	int nd_stats_size;
+	int nd_ndims = 0;
+	bool isnull;
+	int null_cnt=0, notnull_cnt=0;
+	GBOX *sample_extent=NULL;
+	double total_width=0;
+	double total_boxes_area=0;
+	double total_boxes_width=0;
+	double total_boxes_height=0;
+	int nbuckets;
+
+	/*
+	 * This is where geometry_analyze
+	 * should put its' custom parameters.
+	 */
+	/* void *mystats = stats->extra_data; */
+
+	POSTGIS_DEBUG(2, "compute_geometry_stats called");
+	POSTGIS_DEBUGF(3, " samplerows: %d", samplerows);
+
+	/*
+	 * We might need less space, but don't think
+	 * its worth saving...
+	 */
+	samples = palloc(sizeof(GEOM_SAMPLE)*samplerows);
+	sample_nd_boxes = palloc(sizeof(ND_BOX)*samplerows);
+
+	/*
+	 * First scan:
 	 *  o find extent of the sample rows
 	 *  o count null-infinite/not-null values
 	 *  o compute total_width
 	 *  o compute total features's box area (for avgFeatureArea)
-	 *  o sum features box coordinates (for standard deviation)
+	 *  o record box centers and sizes (for the buckets)
 	 */
 	for (i=0; i<samplerows; i++)
 	{
 		Datum datum;
 		GSERIALIZED *geom;
 		GBOX box;
+		char gidxmem[GIDX_MAX_SIZE];
+		GIDX *gidx = (GIDX*)gidxmem;
+		int ndims;
 
 		datum = fetchfunc(stats, i, &isnull);
 
@@ -876,11 +1699,19 @@ compute_geometry_stats(VacAttrStats *stats, AnalyzeAttrFetchFunc fetchfunc,
 		}
 
 		/*
-		 * Cache bounding box
-		 * TODO: reduce BOX2DFLOAT4 copies
+		 * Keep box center and half sizes
+		 */
+		samples[notnull_cnt].x = (box.xmin + box.xmax) / 2.0;
+		samples[notnull_cnt].y = (box.ymin + box.ymax) / 2.0;
+		samples[notnull_cnt].halfwidth = (box.xmax - box.xmin) / 2.0;
+		samples[notnull_cnt].halfheight = (box.ymax - box.ymin) / 2.0;
+
+		/*
+		 * Keep the full dimensional box for the N-D histogram
 		 */
-		sampleboxes[notnull_cnt] = palloc(sizeof(GBOX));
-		memcpy(sampleboxes[notnull_cnt], &box, sizeof(GBOX));
+		gserialized_get_gidx_p(geom, gidx);
+		ndims = nd_box_from_gidx(gidx, &(sample_nd_boxes[notnull_cnt]));
+		if ( ndims > nd_ndims ) nd_ndims = ndims;
 
 		/*
 		 * Add to sample extent union
@@ -905,17 +1736,8 @@ compute_geometry_stats(VacAttrStats *stats, AnalyzeAttrFetchFunc fetchfunc,
 		/** TODO: ask if we need geom or bvol size for stawidth */
 		total_width += geom->size;
 		total_boxes_area += (box.xmax-box.xmin)*(box.ymax-box.ymin);
-
-#if USE_STANDARD_DEVIATION
-		/*
-		 * Add bvol coordinates to sum for standard deviation
-		 * computation.
-		 */
-		sumLOWx += box.xmin;
-		sumLOWy += box.ymin;
-		sumHIGx += box.xmax;
-		sumHIGy += box.ymax;
-#endif
+		total_boxes_width += box.xmax-box.xmin;
+		total_boxes_height += box.ymax-box.ymin;
 
 		notnull_cnt++;
 
@@ -931,391 +1753,353 @@ compute_geometry_stats(VacAttrStats *stats, AnalyzeAttrFetchFunc fetchfunc,
 		return;
 	}
 
-#if USE_STANDARD_DEVIATION
-
 	POSTGIS_DEBUGF(3, " sample_extent: xmin,ymin: %f,%f",
 	               sample_extent->xmin, sample_extent->ymin);
 	POSTGIS_DEBUGF(3, " sample_extent: xmax,ymax: %f,%f",
 	               sample_extent->xmax, sample_extent->ymax);
 
 	/*
-	 * Second scan:
-	 *  o compute standard deviation
+	 * We'll build an histogram having from 100 to 10000
+	 * buckets, depending on the attribute stat target
+	 * (10 to 1000), with no less than 10 samples each.
 	 */
-	avgLOWx = sumLOWx/notnull_cnt;
-	avgLOWy = sumLOWy/notnull_cnt;
-	avgHIGx = sumHIGx/notnull_cnt;
-	avgHIGy = sumHIGy/notnull_cnt;
-	for (i=0; i<notnull_cnt; i++)
-	{
-		GBOX *box;
-		box = (GBOX *)sampleboxes[i];
-
-		sdLOWx += (box->xmin - avgLOWx) * (box->xmin - avgLOWx);
-		sdLOWy += (box->ymin - avgLOWy) * (box->ymin - avgLOWy);
-		sdHIGx += (box->xmax - avgHIGx) * (box->xmax - avgHIGx);
-		sdHIGy += (box->ymax - avgHIGy) * (box->ymax - avgHIGy);
-	}
-	sdLOWx = sqrt(sdLOWx/notnull_cnt);
-	sdLOWy = sqrt(sdLOWy/notnull_cnt);
-	sdHIGx = sqrt(sdHIGx/notnull_cnt);
-	sdHIGy = sqrt(sdHIGy/notnull_cnt);
-
-	POSTGIS_DEBUG(3, " standard deviations:");
-	POSTGIS_DEBUGF(3, "  LOWx - avg:%f sd:%f", avgLOWx, sdLOWx);
-	POSTGIS_DEBUGF(3, "  LOWy - avg:%f sd:%f", avgLOWy, sdLOWy);
-	POSTGIS_DEBUGF(3, "  HIGx - avg:%f sd:%f", avgHIGx, sdHIGx);
-	POSTGIS_DEBUGF(3, "  HIGy - avg:%f sd:%f", avgHIGy, sdHIGy);
-
-	histobox.xmin = Max((avgLOWx - SDFACTOR * sdLOWx),
-	                       sample_extent->xmin);
-	histobox.ymin = Max((avgLOWy - SDFACTOR * sdLOWy),
-	                       sample_extent->ymin);
-	histobox.xmax = Min((avgHIGx + SDFACTOR * sdHIGx),
-	                       sample_extent->xmax);
-	histobox.ymax = Min((avgHIGy + SDFACTOR * sdHIGy),
-	                       sample_extent->ymax);
-
-	POSTGIS_DEBUGF(3, " sd_extent: xmin,ymin: %f,%f",
-	               histobox.xmin, histobox.ymin);
-	POSTGIS_DEBUGF(3, " sd_extent: xmax,ymax: %f,%f",
-	               histobox.xmin, histobox.ymax);
+	nbuckets = Min(10*stats->attr->attstattarget, notnull_cnt/10);
+	if ( nbuckets < 1 ) nbuckets = 1;
+
+	POSTGIS_DEBUGF(3, " histogram buckets: %d", nbuckets);
 
 	/*
-	 * Third scan:
-	 *   o skip hard deviants
-	 *   o compute new histogram box
+	 * Create the histogram (GEOM_STATS)
 	 */
-	for (i=0; i<notnull_cnt; i++)
-	{
-		GBOX *box;
-		box = (GBOX *)sampleboxes[i];
-
-		if ( box->xmin > histobox.xmax ||
-		        box->xmax < histobox.xmin ||
-		        box->ymin > histobox.ymax ||
-		        box->ymax < histobox.ymin )
-		{
-			POSTGIS_DEBUGF(4, " feat %d is an hard deviant, skipped", i);
+	old_context = MemoryContextSwitchTo(stats->anl_context);
+	geom_stats_size=sizeof(GEOM_STATS)+(nbuckets-1)*sizeof(GEOM_BUCKET);
+	geomstats = palloc(geom_stats_size);
+	MemoryContextSwitchTo(old_context);
 
-			sampleboxes[i] = NULL;
-			continue;
-		}
-		if ( ! newhistobox )
-		{
-			newhistobox = palloc(sizeof(GBOX));
-			memcpy(newhistobox, box, sizeof(GBOX));
-		}
-		else
-		{
-			if ( box->xmin < newhistobox->xmin )
-				newhistobox->xmin = box->xmin;
-			if ( box->ymin < newhistobox->ymin )
-				newhistobox->ymin = box->ymin;
-			if ( box->xmax > newhistobox->xmax )
-				newhistobox->xmax = box->xmax;
-			if ( box->ymax > newhistobox->ymax )
-				newhistobox->ymax = box->ymax;
-		}
-	}
+	geomstats->avgFeatureArea = total_boxes_area/notnull_cnt;
+	geomstats->avgFeatureWidth = total_boxes_width/notnull_cnt;
+	geomstats->avgFeatureHeight = total_boxes_height/notnull_cnt;
+	geomstats->xmin = sample_extent->xmin;
+	geomstats->ymin = sample_extent->ymin;
+	geomstats->xmax = sample_extent->xmax;
+	geomstats->ymax = sample_extent->ymax;
+	geomstats->nbuckets = 0;
 
 	/*
-	 * Set histogram extent as the intersection between
-	 * standard deviation based histogram extent
-	 * and computed sample extent after removal of
-	 * hard deviants (there might be no hard deviants).
+	 * Second scan:
+	 *  o split samples in equal-frequency buckets
 	 */
-	if ( histobox.xmin < newhistobox->xmin )
-		histobox.xmin = newhistobox->xmin;
-	if ( histobox.ymin < newhistobox->ymin )
-		histobox.ymin = newhistobox->ymin;
-	if ( histobox.xmax > newhistobox->xmax )
-		histobox.xmax = newhistobox->xmax;
-	if ( histobox.ymax > newhistobox->ymax )
-		histobox.ymax = newhistobox->ymax;
+	build_geometry_buckets(samples, notnull_cnt, nbuckets, notnull_cnt, geomstats);
 
+	/* Duplicated centers may have given us less buckets */
+	geom_stats_size = sizeof(GEOM_STATS)+((int)geomstats->nbuckets-1)*sizeof(GEOM_BUCKET);
 
-#else /* ! USE_STANDARD_DEVIATION */
+	POSTGIS_DEBUGF(3, " histo: buckets: %g", geomstats->nbuckets);
+	POSTGIS_DEBUGF(3, " histo: avgFeatureArea: %f", geomstats->avgFeatureArea);
 
 	/*
-	* Set histogram extent box
-	*/
-	histobox.xmin = sample_extent->xmin;
-	histobox.ymin = sample_extent->ymin;
-	histobox.xmax = sample_extent->xmax;
-	histobox.ymax = sample_extent->ymax;
-#endif /* USE_STANDARD_DEVIATION */
-
-
-	POSTGIS_DEBUGF(3, " histogram_extent: xmin,ymin: %f,%f",
-	               histobox.xmin, histobox.ymin);
-	POSTGIS_DEBUGF(3, " histogram_extent: xmax,ymax: %f,%f",
-	               histobox.xmax, histobox.ymax);
-
-
-	geow = histobox.xmax - histobox.xmin;
-	geoh = histobox.ymax - histobox.ymin;
+	 * Write the statistics data
+	 */
+	stats->stakind[0] = STATISTIC_KIND_GEOMETRY;
+	stats->staop[0] = InvalidOid;
+	stats->stanumbers[0] = (float4 *)geomstats;
+	stats->numnumbers[0] = geom_stats_size/sizeof(float4);
 
 	/*
-	 * Compute histogram cols and rows based on aspect ratio
-	 * of histogram extent
+	 * Write the N-D histogram data
 	 */
-	if ( ! geow && ! geoh )
-	{
-		cols = 1;
-		rows = 1;
-		histocells = 1;
-	}
-	else if ( ! geow )
-	{
-		cols = 1;
-		rows = histocells;
-	}
-	else if ( ! geoh )
-	{
-		cols = histocells;
-		rows = 1;
-	}
-	else
+	nd_stats = compute_nd_stats(stats, sample_nd_boxes, notnull_cnt,
+	                            nd_ndims, 160*stats->attr->attstattarget, &nd_stats_size);
+	if ( nd_stats )
 	{
-		if ( geow<geoh)
-		{
-			cols = ceil(sqrt((double)histocells*(geow/geoh)));
-			rows = ceil((double)histocells/cols);
-		}
-		else
-		{
-			rows = ceil(sqrt((double)histocells*(geoh/geow)));
-			cols = ceil((double)histocells/rows);
-		}
-		histocells = cols*rows;
+		stats->stakind[1] = STATISTIC_KIND_ND;
+		stats->staop[1] = InvalidOid;
+		stats->stanumbers[1] = (float4 *)nd_stats;
+		stats->numnumbers[1] = nd_stats_size/sizeof(float4);
 	}
 
-	POSTGIS_DEBUGF(3, " computed histogram grid size (CxR): %dx%d (%d cells)", cols, rows, histocells);
-
+	stats->stanullfrac = (float4)null_cnt/samplerows;
+	stats->stawidth = total_width/notnull_cnt;
+	stats->stadistinct = -1.0;
 
-	/*
-	 * Create the histogram (GEOM_STATS)
-	 */
-	old_context = MemoryContextSwitchTo(stats->anl_context);
-	geom_stats_size=sizeof(GEOM_STATS)+(histocells-1)*sizeof(float4);
-	geomstats = palloc(geom_stats_size);
-	MemoryContextSwitchTo(old_context);
+	POSTGIS_DEBUGF(3, " out: slot 0: kind %d (STATISTIC_KIND_GEOMETRY)",
+	               stats->stakind[0]);
+	POSTGIS_DEBUGF(3, " out: slot 0: op %d (InvalidOid)", stats->staop[0]);
+	POSTGIS_DEBUGF(3, " out: slot 0: numnumbers %d", stats->numnumbers[0]);
+	POSTGIS_DEBUGF(3, " out: null fraction: %d/%d=%g", null_cnt, samplerows, stats->stanullfrac);
+	POSTGIS_DEBUGF(3, " out: average width: %d bytes", stats->stawidth);
+	POSTGIS_DEBUG(3, " out: distinct values: all (no check done)");
 
-	geomstats->avgFeatureArea = total_boxes_area/notnull_cnt;
-	geomstats->xmin = histobox.xmin;
-	geomstats->ymin = histobox.ymin;
-	geomstats->xmax = histobox.xmax;
-	geomstats->ymax = histobox.ymax;
-	geomstats->cols = cols;
-	geomstats->rows = rows;
+	stats->stats_valid = true;
+}
 
-	/* Initialize all values to 0 */
-	for (i=0; i<histocells; i++) geomstats->value[i] = 0;
+/**
+ * This function will be called when the ANALYZE command is run
+ * on a column of the "geometry" type.
+ *
+ * It will need to return a stats builder function reference
+ * and a "minimum" sample rows to feed it.
+ * If we want analisys to be completely skipped we can return
+ * FALSE and leave output vals untouched.
+ *
+ * What we know from this call is:
+ *
+ * 	o The pg_attribute row referring to the specific column.
+ * 	  Could be used to get reltuples from pg_class (which
+ * 	  might quite inexact though...) and use them to set an
+ * 	  appropriate minimum number of sample rows to feed to
+ * 	  the stats builder. The stats builder will also receive
+ * 	  a more accurate "estimation" of the number or rows.
+ *
+ * 	o The pg_type row for the specific column.
+ * 	  Could be used to set stat builder / sample rows
+ * 	  based on domain type (when postgis will be implemented
+ * 	  that way).
+ *
+ * Being this experimental we'll stick to a static stat_builder/sample_rows
+ * value for now.
+ *
+ */
+PG_FUNCTION_INFO_V1(geometry_analyze_2d);
+Datum geometry_analyze_2d(PG_FUNCTION_ARGS)
+{
+	VacAttrStats *stats = (VacAttrStats *)PG_GETARG_POINTER(0);
+	Form_pg_attribute attr = stats->attr;
 
-	cell_width = geow/cols;
-	cell_height = geoh/rows;
-	cell_area = cell_width*cell_height;
+	POSTGIS_DEBUG(2, "geometry_analyze called");
 
-	POSTGIS_DEBUGF(4, "cell_width: %f", cell_width);
-	POSTGIS_DEBUGF(4, "cell_height: %f", cell_height);
+	/* If the attstattarget column is negative, use the default value */
+	/* NB: it is okay to scribble on stats->attr since it's a copy */
+	if (attr->attstattarget < 0)
+		attr->attstattarget = default_statistics_target;
 
+	POSTGIS_DEBUGF(3, " attribute stat target: %d", attr->attstattarget);
 
-	/*
-	 * Fourth scan:
-	 *  o fill histogram values with the number of
-	 *    features' bbox overlaps: a feature's bvol
-	 *    can fully overlap (1) or partially overlap
-	 *    (fraction of 1) an histogram cell.
-	 *
-	 *  o compute total cells occupation
-	 *
-	 */
-	for (i=0; i<notnull_cnt; i++)
-	{
-		GBOX *box;
-		int x_idx_min, x_idx_max, x;
-		int y_idx_min, y_idx_max, y;
-		int numcells=0;
+	/* Setup the minimum rows and the algorithm function */
+	stats->minrows = 300 * stats->attr->attstattarget;
+	stats->compute_stats = compute_geometry_stats;
 
-		box = (GBOX *)sampleboxes[i];
-		if ( ! box ) continue; /* hard deviant.. */
+	POSTGIS_DEBUGF(3, " minrows: %d", stats->minrows);
 
-		/* give backend a chance of interrupting us */
-		vacuum_delay_point();
+	/* Indicate we are done successfully */
+	PG_RETURN_BOOL(true);
+}
 
-		POSTGIS_DEBUGF(4, " feat %d box is %f %f, %f %f",
-		               i, box->xmax, box->ymax,
-		               box->xmin, box->ymin);
+/**
+ * Build the N-D histogram of a gidx value, which ANALYZE samples for
+ * the expressions of gist_gidx_ops indexes.
+ */
+static void
+compute_gidx_stats(VacAttrStats *stats, AnalyzeAttrFetchFunc fetchfunc,
+                   int samplerows, double totalrows)
+{
+	ND_BOX *sample_nd_boxes;
+	ND_STATS *nd_stats;
+	int nd_stats_size;
+	int nd_ndims = 0;
+	bool isnull;
+	int null_cnt=0, notnull_cnt=0;
+	double total_width=0;
+	int i, d;
 
-		/* Find first overlapping column */
-		x_idx_min = (box->xmin-geomstats->xmin) / geow * cols;
-		if (x_idx_min <0) x_idx_min = 0;
-		if (x_idx_min >= cols) x_idx_min = cols-1;
+	POSTGIS_DEBUG(2, "compute_gidx_stats called");
 
-		/* Find first overlapping row */
-		y_idx_min = (box->ymin-geomstats->ymin) / geoh * rows;
-		if (y_idx_min <0) y_idx_min = 0;
-		if (y_idx_min >= rows) y_idx_min = rows-1;
+	sample_nd_boxes = palloc(sizeof(ND_BOX)*samplerows);
 
-		/* Find last overlapping column */
-		x_idx_max = (box->xmax-geomstats->xmin) / geow * cols;
-		if (x_idx_max <0) x_idx_max = 0;
-		if (x_idx_max >= cols ) x_idx_max = cols-1;
+	for (i=0; i<samplerows; i++)
+	{
+		Datum datum;
+		GIDX *gidx;
+		int ndims;
 
-		/* Find last overlapping row */
-		y_idx_max = (box->ymax-geomstats->ymin) / geoh * rows;
-		if (y_idx_max <0) y_idx_max = 0;
-		if (y_idx_max >= rows) y_idx_max = rows-1;
+		datum = fetchfunc(stats, i, &isnull);
+		if ( isnull )
+		{
+			null_cnt++;
+			continue;
+		}
 
-		POSTGIS_DEBUGF(4, " feat %d overlaps columns %d-%d, rows %d-%d",
-		               i, x_idx_min, x_idx_max, y_idx_min, y_idx_max);
+		gidx = (GIDX *)PG_DETOAST_DATUM(datum);
+		ndims = nd_box_from_gidx(gidx, &(sample_nd_boxes[notnull_cnt]));
 
-		/*
-		 * the {x,y}_idx_{min,max}
-		 * define the grid squares that the box intersects
-		 */
-		for (y=y_idx_min; y<=y_idx_max; y++)
+		/* Skip open-ended search keys */
+		for ( d = 0; d < ndims; d++ )
 		{
-			for (x=x_idx_min; x<=x_idx_max; x++)
-			{
-				geomstats->value[x+y*cols] += 1;
-				numcells++;
-			}
+			if ( ! finite(sample_nd_boxes[notnull_cnt].min[d]) ||
+			     ! finite(sample_nd_boxes[notnull_cnt].max[d]) ||
+			     sample_nd_boxes[notnull_cnt].min[d] <= -FLT_MAX ||
+			     sample_nd_boxes[notnull_cnt].max[d] >= FLT_MAX )
+				break;
 		}
+		if ( d < ndims )
+			continue;
 
-		/*
-		 * before adding to the total cells
-		 * we could decide if we really
-		 * want this feature to count
-		 */
-		total_boxes_cells += numcells;
+		if ( ndims > nd_ndims ) nd_ndims = ndims;
+		total_width += VARSIZE(gidx);
+		notnull_cnt++;
 
-		examinedsamples++;
+		/* give backend a chance of interrupting us */
+		vacuum_delay_point();
 	}
 
-	POSTGIS_DEBUGF(3, " examined_samples: %d/%d", examinedsamples, samplerows);
-
-	if ( ! examinedsamples )
+	if ( ! notnull_cnt )
 	{
-		elog(NOTICE, " no examined values, invalid stats");
 		stats->stats_valid = false;
-
-		POSTGIS_DEBUG(3, " no stats have been gathered");
-
 		return;
 	}
 
-	/** TODO: what about null features (TODO) */
-	geomstats->avgFeatureCells = (float4)total_boxes_cells/examinedsamples;
-
-	POSTGIS_DEBUGF(3, " histo: total_boxes_cells: %d", total_boxes_cells);
-	POSTGIS_DEBUGF(3, " histo: avgFeatureArea: %f", geomstats->avgFeatureArea);
-	POSTGIS_DEBUGF(3, " histo: avgFeatureCells: %f", geomstats->avgFeatureCells);
-
-
-	/*
-	 * Normalize histogram
-	 *
-	 * We divide each histogram cell value
-	 * by the number of samples examined.
-	 *
-	 */
-	for (i=0; i<histocells; i++)
-		geomstats->value[i] /= examinedsamples;
-
-	{
-		int x, y;
-		for (x=0; x<cols; x++)
-		{
-			for (y=0; y<rows; y++)
-			{
-				POSTGIS_DEBUGF(4, " histo[%d,%d] = %.15f", x, y, geomstats->value[x+y*cols]);
-			}
-		}
-	}
-
-
-	/*
-	 * Write the statistics data
-	 */
-	stats->stakind[0] = STATISTIC_KIND_GEOMETRY;
-	stats->staop[0] = InvalidOid;
-	stats->stanumbers[0] = (float4 *)geomstats;
-	stats->numnumbers[0] = geom_stats_size/sizeof(float4);
+	nd_stats = compute_nd_stats(stats, sample_nd_boxes, notnull_cnt,
+	                            nd_ndims, 160*stats->attr->attstattarget, &nd_stats_size);
+	if ( nd_stats )
+	{
+		stats->stakind[0] = STATISTIC_KIND_ND;
+		stats->staop[0] = InvalidOid;
+		stats->stanumbers[0] = (float4 *)nd_stats;
+		stats->numnumbers[0] = nd_stats_size/sizeof(float4);
+	}
 
 	stats->stanullfrac = (float4)null_cnt/samplerows;
 	stats->stawidth = total_width/notnull_cnt;
 	stats->stadistinct = -1.0;
-
-	POSTGIS_DEBUGF(3, " out: slot 0: kind %d (STATISTIC_KIND_GEOMETRY)",
-	               stats->stakind[0]);
-	POSTGIS_DEBUGF(3, " out: slot 0: op %d (InvalidOid)", stats->staop[0]);
-	POSTGIS_DEBUGF(3, " out: slot 0: numnumbers %d", stats->numnumbers[0]);
-	POSTGIS_DEBUGF(3, " out: null fraction: %d/%d=%g", null_cnt, samplerows, stats->stanullfrac);
-	POSTGIS_DEBUGF(3, " out: average width: %d bytes", stats->stawidth);
-	POSTGIS_DEBUG(3, " out: distinct values: all (no check done)");
-
 	stats->stats_valid = true;
 }
 
 /**
- * This function will be called when the ANALYZE command is run
- * on a column of the "geometry" type.
- *
- * It will need to return a stats builder function reference
- * and a "minimum" sample rows to feed it.
- * If we want analisys to be completely skipped we can return
- * FALSE and leave output vals untouched.
- *
- * What we know from this call is:
- *
- * 	o The pg_attribute row referring to the specific column.
- * 	  Could be used to get reltuples from pg_class (which
- * 	  might quite inexact though...) and use them to set an
- * 	  appropriate minimum number of sample rows to feed to
- * 	  the stats builder. The stats builder will also receive
- * 	  a more accurate "estimation" of the number or rows.
- *
- * 	o The pg_type row for the specific column.
- * 	  Could be used to set stat builder / sample rows
- * 	  based on domain type (when postgis will be implemented
- * 	  that way).
- *
- * Being this experimental we'll stick to a static stat_builder/sample_rows
- * value for now.
- *
+ * Type analyze function of gidx, see geometry_analyze_2d.
  */
-PG_FUNCTION_INFO_V1(geometry_analyze_2d);
-Datum geometry_analyze_2d(PG_FUNCTION_ARGS)
+PG_FUNCTION_INFO_V1(gidx_analyze_nd);
+Datum gidx_analyze_nd(PG_FUNCTION_ARGS)
 {
 	VacAttrStats *stats = (VacAttrStats *)PG_GETARG_POINTER(0);
 	Form_pg_attribute attr = stats->attr;
 
-	POSTGIS_DEBUG(2, "geometry_analyze called");
+	POSTGIS_DEBUG(2, "gidx_analyze_nd called");
 
-	/* If the attstattarget column is negative, use the default value */
-	/* NB: it is okay to scribble on stats->attr since it's a copy */
 	if (attr->attstattarget < 0)
 		attr->attstattarget = default_statistics_target;
 
-	POSTGIS_DEBUGF(3, " attribute stat target: %d", attr->attstattarget);
-
-	/* Setup the minimum rows and the algorithm function */
 	stats->minrows = 300 * stats->attr->attstattarget;
-	stats->compute_stats = compute_geometry_stats;
+	stats->compute_stats = compute_gidx_stats;
 
-	POSTGIS_DEBUGF(3, " minrows: %d", stats->minrows);
-
-	/* Indicate we are done successfully */
 	PG_RETURN_BOOL(true);
 }
 
+/* geometry_index_extent() result when the root keys cannot be trusted */
+#define INDEX_EXTENT_UNUSABLE -1
+
+/*
+* Is a gist_geometry_ops_2d key a usable box? The compress function
+* clamps infinite boxes to the float range and stores empty geometries
+* with an empty key, which the caller is expected to skip first, so
+* anything else is a damaged key.
+*/
+static int
+index_key_is_box(const BOX2DF *key)
+{
+	if ( ! finite(key->xmin) || ! finite(key->xmax) ||
+	     ! finite(key->ymin) || ! finite(key->ymax) )
+		return LW_FALSE;
+
+	if ( key->xmin > key->xmax || key->ymin > key->ymax )
+		return LW_FALSE;
+
+	return LW_TRUE;
+}
+
 /**
- * Return the estimated extent of the table
- * looking at gathered statistics (or NULL if
- * no statistics have been gathered).
- */
+* Read the extent of a gist_geometry_ops_2d index off its root page.
+* The keys on the root page cover every key below them, so their
+* union bounds the whole column without touching the heap or any
+* other index page. Keys only grow on insert, so the result is never
+* smaller than the real extent, though it may be larger after deletes.
+* Returns LW_FAILURE if the index holds no keys, and
+* INDEX_EXTENT_UNUSABLE if a root key is not a valid box.
+*/
+static int
+geometry_index_extent(Oid idxoid, GBOX *gbox)
+{
+	Relation idx;
+	Buffer buffer;
+	Page page;
+	OffsetNumber offset, maxoff;
+	int result = LW_FAILURE;
+
+	idx = index_open(idxoid, AccessShareLock);
+	buffer = ReadBuffer(idx, GIST_ROOT_BLKNO);
+	LockBuffer(buffer, GIST_SHARE);
+	page = BufferGetPage(buffer);
+	maxoff = PageGetMaxOffsetNumber(page);
+
+	for ( offset = FirstOffsetNumber; offset <= maxoff; offset = OffsetNumberNext(offset) )
+	{
+		ItemId iid = PageGetItemId(page, offset);
+		IndexTuple itup;
+		BOX2DF *key;
+		bool isnull;
+
+		if ( ItemIdIsDead(iid) )
+			continue;
+
+		itup = (IndexTuple) PageGetItem(page, iid);
+
+#ifdef GistTupleIsInvalid
+		/* Left behind by an interrupted split, carries no key: give up */
+		if ( GistTupleIsInvalid(itup) )
+		{
+			result = LW_FAILURE;
+			break;
+		}
+#endif
+
+		key = (BOX2DF*)DatumGetPointer(index_getattr(itup, 1, RelationGetDescr(idx), &isnull));
+		if ( isnull || ! key )
+			continue;
+
+		/* Subtrees holding only empty geometries add nothing */
+		if ( BOX2DF_IS_EMPTY(key) )
+			continue;
+
+		/* Should not happen, but rather than trust the page use the stats */
+		if ( ! index_key_is_box(key) )
+		{
+			POSTGIS_DEBUGF(3, " root key %d is not a box", offset);
+			result = INDEX_EXTENT_UNUSABLE;
+			break;
+		}
+
+		POSTGIS_DEBUGF(4, " root key %d: %g %g, %g %g", offset,
+		               key->xmin, key->ymin, key->xmax, key->ymax);
+
+		if ( result == LW_FAILURE )
+		{
+			gbox->xmin = key->xmin;
+			gbox->ymin = key->ymin;
+			gbox->xmax = key->xmax;
+			gbox->ymax = key->ymax;
+			result = LW_SUCCESS;
+		}
+		else
+		{
+			gbox->xmin = Min(gbox->xmin, key->xmin);
+			gbox->ymin = Min(gbox->ymin, key->ymin);
+			gbox->xmax = Max(gbox->xmax, key->xmax);
+			gbox->ymax = Max(gbox->ymax, key->ymax);
+		}
+	}
+
+	UnlockReleaseBuffer(buffer);
+	index_close(idx, AccessShareLock);
+
+	return result;
+}
+
+/**
+* Return the extent of a geometry column. When the column has a
+* gist_geometry_ops_2d index the extent is read off the index root
+* page, which is current and costs a single page read. Otherwise, or
+* when the root page holds keys that are not boxes, the extent
+* recorded by the last ANALYZE is returned.
+*/
 PG_FUNCTION_INFO_V1(geometry_estimated_extent);
 Datum geometry_estimated_extent(PG_FUNCTION_ARGS)
 {
@@ -1337,6 +2121,8 @@ Datum geometry_estimated_extent(PG_FUNCTION_ARGS)
 	GEOM_STATS geomstats;
 	float reltuples;
 	Datum binval;
+	GBOX idxbox;
+	int idxresult = INDEX_EXTENT_UNUSABLE;
 
 	if ( PG_NARGS() == 3 )
 	{
@@ -1365,7 +2151,7 @@ Datum geometry_estimated_extent(PG_FUNCTION_ARGS)
 		PG_RETURN_NULL() ;
 	}
 
-	querysize = VARSIZE(txtbl)+VARSIZE(txcol)+516;
+	querysize = VARSIZE(txtbl)+VARSIZE(txcol)+768;
 
 	if ( txnsp )
 	{
@@ -1432,7 +2218,13 @@ Datum geometry_estimated_extent(PG_FUNCTION_ARGS)
 	if ( txnsp )
 	{
 	  sprintf(query, 
-	    "SELECT s.stanumbers1[5:8], c.reltuples FROM pg_class c"
+	    "SELECT s.stanumbers1[5:8], c.reltuples, "
+	    " (SELECT i.indexrelid FROM pg_index i, pg_opclass o"
+	    "  WHERE i.indrelid = c.oid AND i.indkey[0] = a.attnum"
+	    "  AND i.indisvalid AND i.indpred IS NULL"
+	    "  AND o.oid = i.indclass[0]"
+	    "  AND o.opcname = 'gist_geometry_ops_2d' LIMIT 1)"
+	    " FROM pg_class c"
 	    " LEFT OUTER JOIN pg_namespace n ON (n.oid = c.relnamespace)"
 	    " LEFT OUTER JOIN pg_attribute a ON (a.attrelid = c.oid )"
 	    " LEFT OUTER JOIN pg_statistic s ON (s.starelid = c.oid AND "
@@ -1444,7 +2236,13 @@ Datum geometry_estimated_extent(PG_FUNCTION_ARGS)
 	else
 	{
 	  sprintf(query, 
-	    "SELECT s.stanumbers1[5:8], c.reltuples FROM pg_class c"
+	    "SELECT s.stanumbers1[5:8], c.reltuples, "
+	    " (SELECT i.indexrelid FROM pg_index i, pg_opclass o"
+	    "  WHERE i.indrelid = c.oid AND i.indkey[0] = a.attnum"
+	    "  AND i.indisvalid AND i.indpred IS NULL"
+	    "  AND o.oid = i.indclass[0]"
+	    "  AND o.opcname = 'gist_geometry_ops_2d' LIMIT 1)"
+	    " FROM pg_class c"
 	    " LEFT OUTER JOIN pg_namespace n ON (n.oid = c.relnamespace)"
 	    " LEFT OUTER JOIN pg_attribute a ON (a.attrelid = c.oid )"
 	    " LEFT OUTER JOIN pg_statistic s ON (s.starelid = c.oid AND "
@@ -1479,7 +2277,44 @@ Datum geometry_estimated_extent(PG_FUNCTION_ARGS)
 	tupdesc = SPI_tuptable->tupdesc;
 	tuple = tuptable->vals[0];
 
-	/* Check if the table has zero rows first */
+	/* Prefer the index root page when there is one */
+	binval = SPI_getbinval(tuple, tupdesc, 3, &isnull);
+	if ( ! isnull )
+	{
+		POSTGIS_DEBUGF(3, " reading extent from index %u", DatumGetObjectId(binval));
+		idxresult = geometry_index_extent(DatumGetObjectId(binval), &idxbox);
+	}
+
+	if ( idxresult == LW_FAILURE )
+	{
+		elog(NOTICE, "\"%s\".\"%s\".\"%s\" is empty",
+			( nsp ? nsp : "<current>" ), tbl, col);
+		SPI_finish();
+		PG_RETURN_NULL();
+	}
+
+	if ( idxresult == LW_SUCCESS )
+	{
+		box = SPI_palloc(sizeof(GBOX));
+		box->flags = 0;
+		box->xmin = idxbox.xmin;
+		box->ymin = idxbox.ymin;
+		box->xmax = idxbox.xmax;
+		box->ymax = idxbox.ymax;
+
+		POSTGIS_DEBUGF(3, " index extent = %g %g, %g %g", box->xmin,
+		               box->ymin, box->xmax, box->ymax);
+
+		SPIcode = SPI_finish();
+		if (SPIcode != SPI_OK_FINISH )
+		{
+			elog(ERROR, "geometry_estimated_extent: couldn't disconnect from SPI");
+		}
+
+		PG_RETURN_POINTER(box);
+	}
+
+	/* No usable index: check if the table has zero rows first */
 	binval = SPI_getbinval(tuple, tupdesc, 2, &isnull);
 	if (isnull)
 	{
@@ -1556,3 +2391,414 @@ Datum geometry_estimated_extent(PG_FUNCTION_ARGS)
 
 	PG_RETURN_POINTER(box);
 }
+
+
+/*
+ * Exact extent of a geometry column read off its gist_geometry_ops_2d
+ * index. Every leaf key is a float box that contains the box of its
+ * geometry, rounded outwards by next_float_down()/next_float_up(). As
+ * that rounding is monotone, the union of the keys of the visible rows
+ * is the exact extent rounded the same way, and the only rows that can
+ * hold an exact bound are those whose key lies on the matching side of
+ * that union. So a single pass over the leaf pages collects the union
+ * and those few candidates, and only the candidates are read from the
+ * heap to get the double precision answer ST_Extent would give.
+ *
+ * Rows on heap pages marked all-visible (PgSQL 9.2+) are taken as
+ * visible straight from the index. Other rows have their visibility
+ * checked in the heap, as an index scan would. Empty geometries have
+ * empty keys and add nothing, as with ST_Extent.
+ */
+
+/* Sides of the extent, in the order of the BOX2DF members */
+#define EXTENT_XMIN 0
+#define EXTENT_XMAX 1
+#define EXTENT_YMIN 2
+#define EXTENT_YMAX 3
+
+typedef struct
+{
+	Relation heap;
+	AttrNumber attnum;
+	Snapshot snapshot;
+	Buffer vmbuffer;
+	/* Union of the keys of the visible rows */
+	bool has_key;
+	float bound[4];
+	/* Rows whose key reaches each side of that union */
+	ItemPointerData *cand[4];
+	int ncand[4];
+	int maxcand[4];
+	/* A key that is not a box was met */
+	bool unusable;
+	/* Exact extent of the candidates */
+	bool has_box;
+	GBOX box;
+} IndexExtentState;
+
+
+/* Expand box to include the exact box of a geometry datum, skipping empties */
+static void
+index_extent_add_geom(Datum datum, GBOX *box, bool *has_box)
+{
+	GSERIALIZED *g = (GSERIALIZED*)PG_DETOAST_DATUM(datum);
+	LWGEOM *lwgeom = lwgeom_from_gserialized(g);
+	GBOX gbox;
+	int rv = lwgeom_calculate_gbox(lwgeom, &gbox);
+
+	lwgeom_free(lwgeom);
+	if ( (Pointer)g != DatumGetPointer(datum) )
+		pfree(g);
+
+	if ( rv == LW_FAILURE )
+		return;
+
+	if ( ! *has_box )
+	{
+		box->xmin = gbox.xmin;
+		box->xmax = gbox.xmax;
+		box->ymin = gbox.ymin;
+		box->ymax = gbox.ymax;
+		*has_box = true;
+	}
+	else
+	{
+		box->xmin = Min(box->xmin, gbox.xmin);
+		box->xmax = Max(box->xmax, gbox.xmax);
+		box->ymin = Min(box->ymin, gbox.ymin);
+		box->ymax = Max(box->ymax, gbox.ymax);
+	}
+}
+
+/*
+ * Look up the heap row an index entry points to. Returns false if no
+ * version of it is visible to our snapshot. When box is not NULL the
+ * exact box of the geometry is added to it.
+ */
+static bool
+index_extent_fetch(IndexExtentState *state, ItemPointer tid, GBOX *box, bool *has_box)
+{
+	ItemPointerData htid = *tid;
+	bool all_dead;
+	bool isnull;
+	Datum datum;
+	HeapTupleData tuple;
+	Buffer buffer;
+
+	if ( ! heap_hot_search(&htid, state->heap, state->snapshot, &all_dead) )
+		return false;
+
+	if ( box )
+	{
+		tuple.t_self = htid;
+		if ( ! heap_fetch(state->heap, state->snapshot, &tuple, &buffer, false, NULL) )
+			return false;
+
+		datum = heap_getattr(&tuple, state->attnum, RelationGetDescr(state->heap), &isnull);
+		if ( ! isnull )
+			index_extent_add_geom(datum, box, has_box);
+		ReleaseBuffer(buffer);
+	}
+
+	return true;
+}
+
+/* Is the heap row an index entry points to visible without looking? */
+static bool
+index_extent_all_visible(IndexExtentState *state, ItemPointer tid)
+{
+#if POSTGIS_PGSQL_VERSION >= 96
+	return VM_ALL_VISIBLE(state->heap, ItemPointerGetBlockNumber(tid), &(state->vmbuffer));
+#elif POSTGIS_PGSQL_VERSION >= 92
+	return visibilitymap_test(state->heap, ItemPointerGetBlockNumber(tid), &(state->vmbuffer));
+#else
+	/* The visibility map is only a hint before 9.2 */
+	return false;
+#endif
+}
+
+/* Record a row whose key reaches the given side of the union */
+static void
+index_extent_candidate(IndexExtentState *state, int side, float value, ItemPointer tid)
+{
+	bool lower = (side == EXTENT_XMIN || side == EXTENT_YMIN);
+
+	if ( state->ncand[side] && value != state->bound[side] )
+	{
+		/* Not as far out as the current candidates */
+		if ( lower ? value > state->bound[side] : value < state->bound[side] )
+			return;
+		/* Further out, the current candidates are out of the running */
+		state->ncand[side] = 0;
+	}
+
+	if ( state->ncand[side] == state->maxcand[side] )
+	{
+		state->maxcand[side] = state->maxcand[side] ? 2 * state->maxcand[side] : 8;
+		if ( state->cand[side] )
+			state->cand[side] = repalloc(state->cand[side], state->maxcand[side] * sizeof(ItemPointerData));
+		else
+			state->cand[side] = palloc(state->maxcand[side] * sizeof(ItemPointerData));
+	}
+
+	state->bound[side] = value;
+	state->cand[side][state->ncand[side]++] = *tid;
+}
+
+/* Collect the visible entries of one leaf page */
+static void
+index_extent_scan_page(IndexExtentState *state, Relation idx, BlockNumber blkno, bool *recycled)
+{
+	Buffer buffer;
+	Page page;
+	OffsetNumber offset, maxoff;
+	BOX2DF *keys;
+	ItemPointerData *tids;
+	int i, nkeys = 0;
+
+	buffer = ReadBuffer(idx, blkno);
+	LockBuffer(buffer, GIST_SHARE);
+	page = BufferGetPage(buffer);
+
+	if ( PageIsNew(page) || GistPageIsDeleted(page) )
+	{
+		*recycled = true;
+		UnlockReleaseBuffer(buffer);
+		return;
+	}
+	*recycled = false;
+
+	if ( ! GistPageIsLeaf(page) )
+	{
+		UnlockReleaseBuffer(buffer);
+		return;
+	}
+
+	/* Copy the entries out, so as not to hold the page while visiting the heap */
+	maxoff = PageGetMaxOffsetNumber(page);
+	keys = palloc(sizeof(BOX2DF) * (maxoff + 1));
+	tids = palloc(sizeof(ItemPointerData) * (maxoff + 1));
+	for ( offset = FirstOffsetNumber; offset <= maxoff; offset = OffsetNumberNext(offset) )
+	{
+		ItemId iid = PageGetItemId(page, offset);
+		IndexTuple itup;
+		Datum key;
+		bool isnull;
+
+		if ( ItemIdIsDead(iid) )
+			continue;
+
+		itup = (IndexTuple) PageGetItem(page, iid);
+		key = index_getattr(itup, 1, RelationGetDescr(idx), &isnull);
+		if ( isnull || BOX2DF_IS_EMPTY((BOX2DF*)DatumGetPointer(key)) )
+			continue;
+
+		if ( ! index_key_is_box((BOX2DF*)DatumGetPointer(key)) )
+		{
+			state->unusable = true;
+			continue;
+		}
+
+		memcpy(&(keys[nkeys]), DatumGetPointer(key), sizeof(BOX2DF));
+		tids[nkeys] = itup->t_tid;
+		nkeys++;
+	}
+	UnlockReleaseBuffer(buffer);
+
+	for ( i = 0; i < nkeys; i++ )
+	{
+		if ( ! index_extent_all_visible(state, &(tids[i])) &&
+		     ! index_extent_fetch(state, &(tids[i]), NULL, NULL) )
+			continue;
+
+		index_extent_candidate(state, EXTENT_XMIN, keys[i].xmin, &(tids[i]));
+		index_extent_candidate(state, EXTENT_XMAX, keys[i].xmax, &(tids[i]));
+		index_extent_candidate(state, EXTENT_YMIN, keys[i].ymin, &(tids[i]));
+		index_extent_candidate(state, EXTENT_YMAX, keys[i].ymax, &(tids[i]));
+		state->has_key = true;
+	}
+
+	pfree(keys);
+	pfree(tids);
+}
+
+/*
+ * Visit every leaf page of the index. Splits move keys either to pages
+ * appended to the index, which we reach by reading the block count again
+ * until it stops growing, or to recycled pages, which we read again at
+ * the end. Keys met twice do no harm to a union.
+ */
+static void
+index_extent_scan(IndexExtentState *state, Relation idx)
+{
+	BlockNumber blkno = GIST_ROOT_BLKNO;
+	BlockNumber nblocks;
+	BlockNumber *recycled = NULL;
+	int nrecycled = 0, maxrecycled = 0;
+	int i;
+
+	while ( blkno < (nblocks = RelationGetNumberOfBlocks(idx)) )
+	{
+		for ( ; blkno < nblocks; blkno++ )
+		{
+			bool is_recycled;
+
+			CHECK_FOR_INTERRUPTS();
+			index_extent_scan_page(state, idx, blkno, &is_recycled);
+
+			if ( ! is_recycled )
+				continue;
+
+			if ( nrecycled == maxrecycled )
+			{
+				maxrecycled = maxrecycled ? 2 * maxrecycled : 8;
+				recycled = recycled ? repalloc(recycled, maxrecycled * sizeof(BlockNumber))
+				                    : palloc(maxrecycled * sizeof(BlockNumber));
+			}
+			recycled[nrecycled++] = blkno;
+		}
+	}
+
+	for ( i = 0; i < nrecycled; i++ )
+	{
+		bool is_recycled;
+		index_extent_scan_page(state, idx, recycled[i], &is_recycled);
+	}
+}
+
+/*
+ * Extent of the indexed column by a plain ST_Extent() query, for when
+ * the index keys do not match the rows. Returns false if it is NULL.
+ */
+static bool
+index_extent_query(IndexExtentState *state, GBOX *box)
+{
+	StringInfoData query;
+	Datum datum;
+	bool isnull;
+	GBOX *result;
+
+	initStringInfo(&query);
+	appendStringInfo(&query, "SELECT ST_Extent(%s) FROM %s",
+	                 quote_identifier(get_attname(RelationGetRelid(state->heap), state->attnum)),
+	                 quote_qualified_identifier(get_namespace_name(RelationGetNamespace(state->heap)),
+	                                            RelationGetRelationName(state->heap)));
+
+	POSTGIS_DEBUGF(3, " query: %s", query.data);
+
+	if ( SPI_connect() != SPI_OK_CONNECT )
+		elog(ERROR, "find_extent: could not connect to SPI manager");
+
+	if ( SPI_execute(query.data, true, 1) != SPI_OK_SELECT || SPI_processed != 1 )
+		elog(ERROR, "find_extent: couldnt execute sql via SPI");
+
+	datum = SPI_getbinval(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 1, &isnull);
+	if ( ! isnull )
+	{
+		/* box2d datums are shorter than a GBOX, only copy the box */
+		result = (GBOX*)DatumGetPointer(datum);
+		box->xmin = result->xmin;
+		box->xmax = result->xmax;
+		box->ymin = result->ymin;
+		box->ymax = result->ymax;
+	}
+
+	SPI_finish();
+	pfree(query.data);
+
+	return ! isnull;
+}
+
+/*
+ * Return the extent of the rows indexed by a gist_geometry_ops_2d index,
+ * the same box ST_Extent() would return for the indexed column.
+ */
+PG_FUNCTION_INFO_V1(geometry_find_extent);
+Datum geometry_find_extent(PG_FUNCTION_ARGS)
+{
+	Oid idxoid = PG_GETARG_OID(0);
+	IndexExtentState state;
+	Relation idx;
+	HeapTuple opftup;
+	bool is_2d_index;
+	GBOX *box;
+	int side, i;
+
+	idx = index_open(idxoid, AccessShareLock);
+
+	/* Only the keys of our 2D opclass can be read as BOX2DF */
+	opftup = SearchSysCache(OPFAMILYOID, ObjectIdGetDatum(idx->rd_opfamily[0]), 0, 0, 0);
+	is_2d_index = HeapTupleIsValid(opftup) &&
+	              idx->rd_rel->relam == GIST_AM_OID &&
+	              idx->rd_index->indkey.values[0] != 0 &&
+	              strcmp(NameStr(((Form_pg_opfamily) GETSTRUCT(opftup))->opfname), "gist_geometry_ops_2d") == 0;
+	if ( HeapTupleIsValid(opftup) )
+		ReleaseSysCache(opftup);
+
+	if ( ! is_2d_index )
+	{
+		elog(ERROR, "find_extent: \"%s\" is not a gist_geometry_ops_2d index on a table column",
+		     RelationGetRelationName(idx));
+		PG_RETURN_NULL();
+	}
+
+	memset(&state, 0, sizeof(IndexExtentState));
+	state.heap = relation_open(idx->rd_index->indrelid, AccessShareLock);
+	state.attnum = idx->rd_index->indkey.values[0];
+	state.snapshot = GetActiveSnapshot();
+	state.vmbuffer = InvalidBuffer;
+
+	/* The keys tell what the rows hold, so check the rows may be read */
+	if ( pg_class_aclcheck(RelationGetRelid(state.heap), GetUserId(), ACL_SELECT) != ACLCHECK_OK )
+	{
+		elog(ERROR, "find_extent: permission denied for relation %s",
+		     RelationGetRelationName(state.heap));
+		PG_RETURN_NULL();
+	}
+
+	index_extent_scan(&state, idx);
+
+	/* Read the candidates from the heap */
+	for ( side = 0; side < 4; side++ )
+	{
+		for ( i = 0; i < state.ncand[side]; i++ )
+			index_extent_fetch(&state, &(state.cand[side][i]), &(state.box), &(state.has_box));
+	}
+
+	POSTGIS_DEBUGF(3, " index extent %g %g, %g %g from %d/%d/%d/%d candidates",
+	               state.bound[EXTENT_XMIN], state.bound[EXTENT_YMIN],
+	               state.bound[EXTENT_XMAX], state.bound[EXTENT_YMAX],
+	               state.ncand[EXTENT_XMIN], state.ncand[EXTENT_YMIN],
+	               state.ncand[EXTENT_XMAX], state.ncand[EXTENT_YMAX]);
+
+	/*
+	 * The candidates must account for the whole union of the keys. They
+	 * don't when a key is not the rounded box of its row: a box clamped
+	 * from infinite coordinates, or a key left by an older version. Fall
+	 * back on ST_Extent() then, as a sequential scan beats fetching every
+	 * row in index order.
+	 */
+	if ( state.unusable || ( state.has_key && ( ! state.has_box ||
+	     next_float_down(state.box.xmin) != state.bound[EXTENT_XMIN] ||
+	     next_float_up(state.box.xmax) != state.bound[EXTENT_XMAX] ||
+	     next_float_down(state.box.ymin) != state.bound[EXTENT_YMIN] ||
+	     next_float_up(state.box.ymax) != state.bound[EXTENT_YMAX] ) ) )
+	{
+		POSTGIS_DEBUG(3, " index keys do not match the rows, running ST_Extent");
+		state.has_box = index_extent_query(&state, &(state.box));
+	}
+
+	if ( BufferIsValid(state.vmbuffer) )
+		ReleaseBuffer(state.vmbuffer);
+	relation_close(state.heap, AccessShareLock);
+	index_close(idx, AccessShareLock);
+
+	if ( ! state.has_box )
+		PG_RETURN_NULL();
+
+	box = palloc(sizeof(GBOX));
+	memcpy(box, &(state.box), sizeof(GBOX));
+	box->flags = 0;
+
+	PG_RETURN_POINTER(box);
+}
@@ -26,6 +26,9 @@
 #include "access/gist.h"    /* For GiST */
 #include "access/itup.h"
 #include "access/skey.h"
+#include "utils/builtins.h" /* For get_float4_nan */
+
+#include <math.h>           /* For isnan */
 
 #include "../postgis_config.h"
 
@@ -34,6 +37,17 @@
 #include "gserialized_gist.h"	     /* For utility functions. */
 #include "liblwgeom_internal.h"  /* For MAXFLOAT */
 
+#if POSTGIS_PGSQL_VERSION >= 92
+#include "access/spgist.h"     /* For SP-GiST */
+#include "catalog/pg_type.h"   /* For POINTOID, FLOAT8OID */
+#include "utils/geo_decls.h"   /* For Point */
+#endif
+
+#if POSTGIS_PGSQL_VERSION >= 95
+#include "access/brin_tuple.h" /* For BRIN */
+#include "utils/datum.h"
+#endif
+
 /*
 ** When is a node split not so good? If more than 90% of the entries
 ** end up in one of the children.
@@ -116,12 +130,38 @@ static BOX2DF* box2df_copy(BOX2DF *b)
 
 
 
+/* Key of an empty geometry, see BOX2DF_IS_EMPTY */
+static inline void box2df_set_empty(BOX2DF *a)
+{
+	a->xmin = a->xmax = a->ymin = a->ymax = get_float4_nan();
+}
+
+/* Clamp infinite or NaN ordinates to the float range */
+static inline void box2df_set_finite(BOX2DF *a)
+{
+	if ( ! finite(a->xmin) ) a->xmin = -1 * MAXFLOAT;
+	if ( ! finite(a->ymin) ) a->ymin = -1 * MAXFLOAT;
+	if ( ! finite(a->xmax) ) a->xmax = MAXFLOAT;
+	if ( ! finite(a->ymax) ) a->ymax = MAXFLOAT;
+}
+
 /* Enlarge b_union to contain b_new. If b_new contains more
-   dimensions than b_union, expand b_union to contain those dimensions. */
+   dimensions than b_union, expand b_union to contain those dimensions.
+   Empty boxes add nothing to a union. */
 static void box2df_merge(BOX2DF *b_union, BOX2DF *b_new)
 {
 
 	POSTGIS_DEBUGF(5, "merging %s with %s", box2df_to_string(b_union), box2df_to_string(b_new));
+
+	if ( BOX2DF_IS_EMPTY(b_new) )
+		return;
+
+	if ( BOX2DF_IS_EMPTY(b_union) )
+	{
+		memcpy((void*)b_union, (void*)b_new, sizeof(BOX2DF));
+		return;
+	}
+
 	/* Adjust minimums */
 	b_union->xmin = Min(b_union->xmin, b_new->xmin);
 	b_union->ymin = Min(b_union->ymin, b_new->ymin);
@@ -141,6 +181,9 @@ static bool box2df_intersection(const BOX2DF *a, const BOX2DF *b, BOX2DF *n)
 
 	if( a == NULL || b == NULL || n == NULL ) 
 		return FALSE;
+
+	if ( BOX2DF_IS_EMPTY(a) || BOX2DF_IS_EMPTY(b) )
+		return FALSE;
 		
 	n->xmax = Min(a->xmax, b->xmax);
 	n->ymax = Min(a->ymax, b->ymax);
@@ -159,7 +202,7 @@ static float box2df_size(const BOX2DF *a)
 {
 	float result;
 
-	if ( a == NULL ) 
+	if ( a == NULL || BOX2DF_IS_EMPTY(a) ) 
 		return (float)0.0;
 		
 	if ( (a->xmax <= a->xmin) || (a->ymax <= a->ymin) )
@@ -186,10 +229,10 @@ static float box2df_union_size(const BOX2DF *a, const BOX2DF *b)
 		return 0.0;
 	}
 	
-	if ( a == NULL )
+	if ( a == NULL || BOX2DF_IS_EMPTY(a) )
 		return box2df_size(b);
 
-	if ( b == NULL )
+	if ( b == NULL || BOX2DF_IS_EMPTY(b) )
 		return box2df_size(a);
 
 	result = ((double)Max(a->xmax,b->xmax) - (double)Min(a->xmin,b->xmin)) * 
@@ -238,7 +281,8 @@ static inline void box2df_validate(BOX2DF *b)
 
 static bool box2df_overlaps(const BOX2DF *a, const BOX2DF *b)
 {
-	if ( ! a || ! b ) return FALSE; /* TODO: might be smarter for EMPTY */
+	if ( ! a || ! b ) return FALSE;
+	if ( BOX2DF_IS_EMPTY(a) || BOX2DF_IS_EMPTY(b) ) return FALSE;
 
 	if ( (a->xmin > b->xmax) || (b->xmin > a->xmax) ||
 	     (a->ymin > b->ymax) || (b->ymin > a->ymax) )
@@ -251,7 +295,8 @@ static bool box2df_overlaps(const BOX2DF *a, const BOX2DF *b)
 
 static bool box2df_contains(const BOX2DF *a, const BOX2DF *b)
 {
-	if ( ! a || ! b ) return FALSE; /* TODO: might be smarter for EMPTY */
+	if ( ! a || ! b ) return FALSE;
+	if ( BOX2DF_IS_EMPTY(a) || BOX2DF_IS_EMPTY(b) ) return FALSE;
 
 	if ( (a->xmin > b->xmin) || (a->xmax < b->xmax) ||
 	     (a->ymin > b->ymin) || (a->ymax < b->ymax) )
@@ -264,7 +309,8 @@ static bool box2df_contains(const BOX2DF *a, const BOX2DF *b)
 
 static bool box2df_within(const BOX2DF *a, const BOX2DF *b)
 {
-	if ( ! a || ! b ) return FALSE; /* TODO: might be smarter for EMPTY */
+	if ( ! a || ! b ) return FALSE;
+	if ( BOX2DF_IS_EMPTY(a) || BOX2DF_IS_EMPTY(b) ) return FALSE;
 
 	POSTGIS_DEBUG(5, "entered function");
 	return box2df_contains(b,a);
@@ -273,6 +319,8 @@ static bool box2df_within(const BOX2DF *a, const BOX2DF *b)
 static bool box2df_equals(const BOX2DF *a, const BOX2DF *b)
 {
 	if ( a &&  b ) {
+		if ( BOX2DF_IS_EMPTY(a) || BOX2DF_IS_EMPTY(b) )
+			return BOX2DF_IS_EMPTY(a) && BOX2DF_IS_EMPTY(b);
 		if ( (a->xmin != b->xmin) || (a->xmax != b->xmax) ||
 		     (a->ymin != b->ymin) || (a->ymax != b->ymax) )
 		{
@@ -290,7 +338,8 @@ static bool box2df_equals(const BOX2DF *a, const BOX2DF *b)
 
 static bool box2df_overleft(const BOX2DF *a, const BOX2DF *b)
 {
-	if ( ! a || ! b ) return FALSE; /* TODO: might be smarter for EMPTY */
+	if ( ! a || ! b ) return FALSE;
+	if ( BOX2DF_IS_EMPTY(a) || BOX2DF_IS_EMPTY(b) ) return FALSE;
 
 	/* a.xmax <= b.xmax */
 	return a->xmax <= b->xmax;
@@ -298,7 +347,8 @@ static bool box2df_overleft(const BOX2DF *a, const BOX2DF *b)
 
 static bool box2df_left(const BOX2DF *a, const BOX2DF *b)
 {
-	if ( ! a || ! b ) return FALSE; /* TODO: might be smarter for EMPTY */
+	if ( ! a || ! b ) return FALSE;
+	if ( BOX2DF_IS_EMPTY(a) || BOX2DF_IS_EMPTY(b) ) return FALSE;
 
 	/* a.xmax < b.xmin */
 	return a->xmax < b->xmin;
@@ -306,7 +356,8 @@ static bool box2df_left(const BOX2DF *a, const BOX2DF *b)
 
 static bool box2df_right(const BOX2DF *a, const BOX2DF *b)
 {
-	if ( ! a || ! b ) return FALSE; /* TODO: might be smarter for EMPTY */
+	if ( ! a || ! b ) return FALSE;
+	if ( BOX2DF_IS_EMPTY(a) || BOX2DF_IS_EMPTY(b) ) return FALSE;
 
 	/* a.xmin > b.xmax */
 	return a->xmin > b->xmax;
@@ -314,7 +365,8 @@ static bool box2df_right(const BOX2DF *a, const BOX2DF *b)
 
 static bool box2df_overright(const BOX2DF *a, const BOX2DF *b)
 {
-	if ( ! a || ! b ) return FALSE; /* TODO: might be smarter for EMPTY */
+	if ( ! a || ! b ) return FALSE;
+	if ( BOX2DF_IS_EMPTY(a) || BOX2DF_IS_EMPTY(b) ) return FALSE;
 
 	/* a.xmin >= b.xmin */
 	return a->xmin >= b->xmin;
@@ -322,7 +374,8 @@ static bool box2df_overright(const BOX2DF *a, const BOX2DF *b)
 
 static bool box2df_overbelow(const BOX2DF *a, const BOX2DF *b)
 {
-	if ( ! a || ! b ) return FALSE; /* TODO: might be smarter for EMPTY */
+	if ( ! a || ! b ) return FALSE;
+	if ( BOX2DF_IS_EMPTY(a) || BOX2DF_IS_EMPTY(b) ) return FALSE;
 
 	/* a.ymax <= b.ymax */
 	return a->ymax <= b->ymax;
@@ -330,7 +383,8 @@ static bool box2df_overbelow(const BOX2DF *a, const BOX2DF *b)
 
 static bool box2df_below(const BOX2DF *a, const BOX2DF *b)
 {
-	if ( ! a || ! b ) return FALSE; /* TODO: might be smarter for EMPTY */
+	if ( ! a || ! b ) return FALSE;
+	if ( BOX2DF_IS_EMPTY(a) || BOX2DF_IS_EMPTY(b) ) return FALSE;
 
 	/* a.ymax < b.ymin */
 	return a->ymax < b->ymin;
@@ -338,7 +392,8 @@ static bool box2df_below(const BOX2DF *a, const BOX2DF *b)
 
 static bool box2df_above(const BOX2DF *a, const BOX2DF *b)
 {
-	if ( ! a || ! b ) return FALSE; /* TODO: might be smarter for EMPTY */
+	if ( ! a || ! b ) return FALSE;
+	if ( BOX2DF_IS_EMPTY(a) || BOX2DF_IS_EMPTY(b) ) return FALSE;
 
 	/* a.ymin > b.ymax */
 	return a->ymin > b->ymax;
@@ -346,7 +401,8 @@ static bool box2df_above(const BOX2DF *a, const BOX2DF *b)
 
 static bool box2df_overabove(const BOX2DF *a, const BOX2DF *b)
 {
-	if ( ! a || ! b ) return FALSE; /* TODO: might be smarter for EMPTY */
+	if ( ! a || ! b ) return FALSE;
+	if ( BOX2DF_IS_EMPTY(a) || BOX2DF_IS_EMPTY(b) ) return FALSE;
 
 	/* a.ymin >= b.ymin */
 	return a->ymin >= b->ymin;
@@ -784,21 +840,28 @@ Datum gserialized_gist_compress_2d(PG_FUNCTION_ARGS)
 	/* Extract our index key from the GiST entry. */
 	result = gserialized_datum_get_box2df_p(entry_in->key, &bbox_out);
 
-	/* Is the bounding box valid (non-empty, non-infinite)? If not, return input uncompressed. */
+	/*
+	** Empty geometries have no box. Store an empty key rather than the
+	** geometry itself, whose head would be read as a box by the union,
+	** penalty and picksplit functions and leak into the parent keys.
+	*/
 	if ( result == LW_FAILURE )
 	{
 		POSTGIS_DEBUG(4, "[GIST] empty geometry!");
-		PG_RETURN_POINTER(entry_in);
+		box2df_set_empty(&bbox_out);
+		gistentryinit(*entry_out, PointerGetDatum(box2df_copy(&bbox_out)),
+		              entry_in->rel, entry_in->page, entry_in->offset, FALSE);
+		PG_RETURN_POINTER(entry_out);
 	}
 
 	POSTGIS_DEBUGF(4, "[GIST] got entry_in->key: %s", box2df_to_string(&bbox_out));
 
-	/* Check all the dimensions for finite values */
+	/* Check all the dimensions for finite values, clamp the others */
 	if ( ! finite(bbox_out.xmax) || ! finite(bbox_out.xmin) ||
 	     ! finite(bbox_out.ymax) || ! finite(bbox_out.ymin) )
 	{
 		POSTGIS_DEBUG(4, "[GIST] infinite geometry!");
-		PG_RETURN_POINTER(entry_in);
+		box2df_set_finite(&bbox_out);
 	}
 
 	/* Enure bounding box has minimums below maximums. */
@@ -997,8 +1060,10 @@ Datum gserialized_gist_distance_2d(PG_FUNCTION_ARGS)
 		PG_RETURN_FLOAT8(MAXFLOAT);
 	}
 
-	/* Get the entry box */
+	/* Get the entry box, empty geometries are infinitely far */
     entry_box = (BOX2DF*)DatumGetPointer(entry->key);
+	if ( BOX2DF_IS_EMPTY(entry_box) )
+		PG_RETURN_FLOAT8(MAXFLOAT);
 	
 	/* Box-style distance test */
 	if ( strategy == 14 )
@@ -1119,10 +1184,8 @@ KBsort;
 static int
 compare_KB(const void* a, const void* b)
 {
-	BOX2DF *abox = ((KBsort*)a)->key;
-	BOX2DF *bbox = ((KBsort*)b)->key;
-	float sa = (abox->xmax - abox->xmin) * (abox->ymax - abox->ymin);
-	float sb = (bbox->xmax - bbox->xmin) * (bbox->ymax - bbox->ymin);
+	float sa = box2df_size(((KBsort*)a)->key);
+	float sb = box2df_size(((KBsort*)b)->key);
 
 	if ( sa==sb ) return 0;
 	return ( sa>sb ) ? 1 : -1;
@@ -1149,21 +1212,32 @@ Datum gserialized_gist_picksplit_2d(PG_FUNCTION_ARGS)
 	bool allisequal = true;
 	OffsetNumber maxoff;
 	int nbytes;
+	int nempty = 0;
 
 	POSTGIS_DEBUG(3, "[GIST] 'picksplit' entered");
 
 	posL = posR = posB = posT = 0;
 
 	maxoff = entryvec->n - 1;
-	cur = (BOX2DF*) DatumGetPointer(entryvec->vector[FirstOffsetNumber].key);
-
-	memcpy((void *) &pageunion, (void *) cur, sizeof(BOX2DF));
+	box2df_set_empty(&pageunion);
 
-	/* find MBR */
-	for (i = OffsetNumberNext(FirstOffsetNumber); i <= maxoff; i = OffsetNumberNext(i))
+	/* find MBR, empty keys are placed once the split is chosen */
+	for (i = FirstOffsetNumber; i <= maxoff; i = OffsetNumberNext(i))
 	{
 		cur = (BOX2DF *) DatumGetPointer(entryvec->vector[i].key);
 
+		if ( BOX2DF_IS_EMPTY(cur) )
+		{
+			nempty++;
+			continue;
+		}
+
+		if ( BOX2DF_IS_EMPTY(&pageunion) )
+		{
+			memcpy((void *) &pageunion, (void *) cur, sizeof(BOX2DF));
+			continue;
+		}
+
 		if ( allisequal == true &&  (
 		            pageunion.xmax != cur->xmax ||
 		            pageunion.ymax != cur->ymax ||
@@ -1197,7 +1271,7 @@ Datum gserialized_gist_picksplit_2d(PG_FUNCTION_ARGS)
 		cur = (BOX2DF*) DatumGetPointer(entryvec->vector[OffsetNumberNext(FirstOffsetNumber)].key);
 
 
-		if (memcmp((void *) cur, (void *) &pageunion, sizeof(BOX2DF)) == 0)
+		if (nempty == 0 && memcmp((void *) cur, (void *) &pageunion, sizeof(BOX2DF)) == 0)
 		{
 			v->spl_left = listL;
 			v->spl_right = listR;
@@ -1230,6 +1304,12 @@ Datum gserialized_gist_picksplit_2d(PG_FUNCTION_ARGS)
 	unionB = (BOX2DF *) palloc(sizeof(BOX2DF));
 	unionT = (BOX2DF *) palloc(sizeof(BOX2DF));
 
+	/* A side may end up with empty keys only */
+	box2df_set_empty(unionL);
+	box2df_set_empty(unionR);
+	box2df_set_empty(unionB);
+	box2df_set_empty(unionT);
+
 #define ADDLIST( list, unionD, pos, num ) do { \
 	if ( pos ) { \
 		if ( unionD->xmax < cur->xmax )    unionD->xmax	= cur->xmax; \
@@ -1247,6 +1327,9 @@ Datum gserialized_gist_picksplit_2d(PG_FUNCTION_ARGS)
 	{
 		cur = (BOX2DF*) DatumGetPointer(entryvec->vector[i].key);
 
+		if ( BOX2DF_IS_EMPTY(cur) )
+			continue;
+
 		if (cur->xmin - pageunion.xmin < pageunion.xmax - cur->xmax)
 			ADDLIST(listL, unionL, posL,i);
 		else
@@ -1276,6 +1359,8 @@ Datum gserialized_gist_picksplit_2d(PG_FUNCTION_ARGS)
 		for (i = FirstOffsetNumber; i <= maxoff; i = OffsetNumberNext(i))
 		{
 			cur = arr[i-1].key;
+			if ( BOX2DF_IS_EMPTY(cur) )
+				continue;
 			if (cur->xmin - pageunion.xmin < pageunion.xmax - cur->xmax)
 				ADDLIST(listL, unionL, posL,arr[i-1].pos);
 			else if ( cur->xmin - pageunion.xmin == pageunion.xmax - cur->xmax )
@@ -1359,6 +1444,20 @@ Datum gserialized_gist_picksplit_2d(PG_FUNCTION_ARGS)
 		v->spl_ldatum = PointerGetDatum(unionB);
 		v->spl_rdatum = PointerGetDatum(unionT);
 	}
+
+	/* Empty keys leave the unions alone, spread them to balance the sides */
+	for (i = FirstOffsetNumber; nempty && i <= maxoff; i = OffsetNumberNext(i))
+	{
+		cur = (BOX2DF*) DatumGetPointer(entryvec->vector[i].key);
+
+		if ( ! BOX2DF_IS_EMPTY(cur) )
+			continue;
+
+		if ( v->spl_nleft <= v->spl_nright )
+			v->spl_left[v->spl_nleft++] = i;
+		else
+			v->spl_right[v->spl_nright++] = i;
+	}
 	
 	POSTGIS_DEBUG(4, "[GIST] 'picksplit' completed");
 	
@@ -1385,3 +1484,559 @@ Datum box2df_out(PG_FUNCTION_ARGS)
 	               errmsg("function box2df_out not implemented")));
 	PG_RETURN_POINTER(NULL);
 }
+
+
+
+/***********************************************************************
+** SP-GiST 2-D point index support.
+**
+** Point-only columns do not need the overlapping boxes of the R-Tree:
+** a space partitioning tree splits the plane into disjoint cells, so
+** a search only descends into the cells its query box overlaps, and
+** inner tuples carry one split point rather than a box per child. Two
+** variants are provided, a quadtree splitting on the median point of
+** each page and a kd-tree alternating between x and y medians.
+**
+** Before PostgreSQL 11 the leaf type must be the column type, so the
+** leaves hold the whole serialized point: 32 bytes plus a 16 byte leaf
+** header, against 24 bytes for a GiST leaf tuple with a BOX2DF. Leaves
+** are nearly the whole index, which ends up larger than a GiST one.
+**
+** Leaf values are the point geometries themselves, tested with the
+** same BOX2DF predicates as the GiST opclass above so both indexes
+** answer queries identically. Points are routed on the centre of their
+** float box; since the float box of a point is never more than one
+** float wide, next_float_down()/next_float_up() of a split coordinate
+** bound the boxes on either side of it and make inner pruning safe.
+*/
+
+#if POSTGIS_PGSQL_VERSION >= 92
+
+Datum gserialized_spgist_config_quad_2d(PG_FUNCTION_ARGS);
+Datum gserialized_spgist_choose_quad_2d(PG_FUNCTION_ARGS);
+Datum gserialized_spgist_picksplit_quad_2d(PG_FUNCTION_ARGS);
+Datum gserialized_spgist_inner_consistent_quad_2d(PG_FUNCTION_ARGS);
+Datum gserialized_spgist_config_kd_2d(PG_FUNCTION_ARGS);
+Datum gserialized_spgist_choose_kd_2d(PG_FUNCTION_ARGS);
+Datum gserialized_spgist_picksplit_kd_2d(PG_FUNCTION_ARGS);
+Datum gserialized_spgist_inner_consistent_kd_2d(PG_FUNCTION_ARGS);
+Datum gserialized_spgist_leaf_consistent_2d(PG_FUNCTION_ARGS);
+
+/*
+** Quadrant bits: set when the point is above the split on that axis.
+*/
+#define SPGIST_X_HIGH 0x01
+#define SPGIST_Y_HIGH 0x02
+
+/**
+* Read the routing point of a geometry on the way into the index.
+* Anything but a point is refused. Empty points are sent to -Infinity:
+* they land on the low side of every split and never match a query.
+*/
+static void
+gserialized_datum_get_spgist_point(Datum gsdatum, Point *pt)
+{
+	GSERIALIZED *g = (GSERIALIZED*)PG_DETOAST_DATUM(gsdatum);
+	GBOX gbox;
+	BOX2DF box;
+
+	if ( gserialized_get_type(g) != POINTTYPE )
+	{
+		elog(ERROR, "SP-GiST point index does not support %s geometries",
+		     lwtype_name(gserialized_get_type(g)));
+	}
+
+	if ( gserialized_get_gbox_p(g, &gbox) == LW_FAILURE )
+	{
+		pt->x = pt->y = -HUGE_VAL;
+		return;
+	}
+
+	box2df_from_gbox_p(&gbox, &box);
+	pt->x = ((double)box.xmin + (double)box.xmax) / 2.0;
+	pt->y = ((double)box.ymin + (double)box.ymax) / 2.0;
+}
+
+static int
+spgist_quadrant_2d(const Point *centroid, const Point *pt)
+{
+	int q = 0;
+	if ( pt->x > centroid->x ) q |= SPGIST_X_HIGH;
+	if ( pt->y > centroid->y ) q |= SPGIST_Y_HIGH;
+	return q;
+}
+
+static int
+spgist_cmp_double(const void *a, const void *b)
+{
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	if ( x < y ) return -1;
+	if ( x > y ) return 1;
+	return 0;
+}
+
+/**
+* Read the query box of every scan key. Returns LW_FAILURE if one of
+* them has no box (empty geometry), in which case nothing can match.
+*/
+static int
+spgist_scankey_boxes(ScanKey keys, int nkeys, BOX2DF *boxes)
+{
+	int i;
+	for ( i = 0; i < nkeys; i++ )
+	{
+		if ( gserialized_datum_get_box2df_p(keys[i].sk_argument, &boxes[i]) == LW_FAILURE )
+			return LW_FAILURE;
+	}
+	return LW_SUCCESS;
+}
+
+/**
+* Bit mask of the sides of a split at coordinate c that can hold a
+* point whose box overlaps [qmin, qmax]. All supported strategies
+* imply overlap for points, so overlap pruning serves them all.
+* Bit 0 is the low side (coordinate <= c), bit 1 the high side.
+*/
+static int
+spgist_split_sides(double c, float qmin, float qmax)
+{
+	int sides = 0x03;
+	if ( next_float_down(c) > qmax ) sides &= ~0x02;
+	if ( next_float_up(c) < qmin ) sides &= ~0x01;
+	return sides;
+}
+
+
+/**
+* Report every node of an allTheSame inner tuple as a match.
+*/
+static void
+spgist_all_nodes(spgInnerConsistentIn *in, spgInnerConsistentOut *out, int leveladd)
+{
+	int i;
+	out->nNodes = in->nNodes;
+	out->nodeNumbers = palloc(sizeof(int) * in->nNodes);
+	out->levelAdds = palloc(sizeof(int) * in->nNodes);
+	for ( i = 0; i < in->nNodes; i++ )
+	{
+		out->nodeNumbers[i] = i;
+		out->levelAdds[i] = leveladd;
+	}
+}
+
+
+/*
+** Quadtree variant: the prefix is the median point of the split page,
+** the four nodes are the quadrants around it.
+*/
+
+PG_FUNCTION_INFO_V1(gserialized_spgist_config_quad_2d);
+Datum gserialized_spgist_config_quad_2d(PG_FUNCTION_ARGS)
+{
+	spgConfigOut *cfg = (spgConfigOut *) PG_GETARG_POINTER(1);
+
+	cfg->prefixType = POINTOID;
+	cfg->labelType = VOIDOID;
+	cfg->canReturnData = true;
+	cfg->longValuesOK = false;
+	PG_RETURN_VOID();
+}
+
+PG_FUNCTION_INFO_V1(gserialized_spgist_choose_quad_2d);
+Datum gserialized_spgist_choose_quad_2d(PG_FUNCTION_ARGS)
+{
+	spgChooseIn *in = (spgChooseIn *) PG_GETARG_POINTER(0);
+	spgChooseOut *out = (spgChooseOut *) PG_GETARG_POINTER(1);
+	Point pt;
+
+	out->resultType = spgMatchNode;
+	out->result.matchNode.levelAdd = 0;
+	out->result.matchNode.restDatum = in->datum;
+
+	/* The core picks the node of an allTheSame tuple itself */
+	if ( in->allTheSame )
+		PG_RETURN_VOID();
+
+	gserialized_datum_get_spgist_point(in->datum, &pt);
+	out->result.matchNode.nodeN = spgist_quadrant_2d(DatumGetPointP(in->prefixDatum), &pt);
+
+	PG_RETURN_VOID();
+}
+
+PG_FUNCTION_INFO_V1(gserialized_spgist_picksplit_quad_2d);
+Datum gserialized_spgist_picksplit_quad_2d(PG_FUNCTION_ARGS)
+{
+	spgPickSplitIn *in = (spgPickSplitIn *) PG_GETARG_POINTER(0);
+	spgPickSplitOut *out = (spgPickSplitOut *) PG_GETARG_POINTER(1);
+	Point *pts = palloc(sizeof(Point) * in->nTuples);
+	double *xs = palloc(sizeof(double) * in->nTuples);
+	double *ys = palloc(sizeof(double) * in->nTuples);
+	Point *centroid = palloc0(sizeof(Point));
+	int i, n = 0;
+
+	for ( i = 0; i < in->nTuples; i++ )
+	{
+		gserialized_datum_get_spgist_point(in->datums[i], &pts[i]);
+		if ( isinf(pts[i].x) )
+			continue;
+		xs[n] = pts[i].x;
+		ys[n] = pts[i].y;
+		n++;
+	}
+
+	/* Median on each axis, robust against clustered points */
+	if ( n > 0 )
+	{
+		qsort(xs, n, sizeof(double), spgist_cmp_double);
+		qsort(ys, n, sizeof(double), spgist_cmp_double);
+		centroid->x = xs[n / 2];
+		centroid->y = ys[n / 2];
+	}
+
+	out->hasPrefix = true;
+	out->prefixDatum = PointPGetDatum(centroid);
+	out->nNodes = 4;
+	out->nodeLabels = NULL;
+	out->mapTuplesToNodes = palloc(sizeof(int) * in->nTuples);
+	out->leafTupleDatums = palloc(sizeof(Datum) * in->nTuples);
+
+	for ( i = 0; i < in->nTuples; i++ )
+	{
+		out->mapTuplesToNodes[i] = spgist_quadrant_2d(centroid, &pts[i]);
+		out->leafTupleDatums[i] = in->datums[i];
+	}
+
+	pfree(pts);
+	pfree(xs);
+	pfree(ys);
+	PG_RETURN_VOID();
+}
+
+PG_FUNCTION_INFO_V1(gserialized_spgist_inner_consistent_quad_2d);
+Datum gserialized_spgist_inner_consistent_quad_2d(PG_FUNCTION_ARGS)
+{
+	spgInnerConsistentIn *in = (spgInnerConsistentIn *) PG_GETARG_POINTER(0);
+	spgInnerConsistentOut *out = (spgInnerConsistentOut *) PG_GETARG_POINTER(1);
+	BOX2DF *queries = palloc(sizeof(BOX2DF) * Max(in->nkeys, 1));
+	Point *centroid;
+	int i, q;
+	int quadrants = 0x0F;
+
+	if ( in->allTheSame )
+	{
+		spgist_all_nodes(in, out, 0);
+		PG_RETURN_VOID();
+	}
+
+	centroid = DatumGetPointP(in->prefixDatum);
+
+	if ( spgist_scankey_boxes(in->scankeys, in->nkeys, queries) == LW_FAILURE )
+		quadrants = 0;
+
+	for ( i = 0; i < in->nkeys && quadrants; i++ )
+	{
+		int xsides = spgist_split_sides(centroid->x, queries[i].xmin, queries[i].xmax);
+		int ysides = spgist_split_sides(centroid->y, queries[i].ymin, queries[i].ymax);
+
+		for ( q = 0; q < 4; q++ )
+		{
+			if ( ! (xsides & ((q & SPGIST_X_HIGH) ? 0x02 : 0x01)) ||
+			     ! (ysides & ((q & SPGIST_Y_HIGH) ? 0x02 : 0x01)) )
+				quadrants &= ~(1 << q);
+		}
+	}
+
+	out->nNodes = 0;
+	out->nodeNumbers = palloc(sizeof(int) * 4);
+	for ( q = 0; q < 4; q++ )
+	{
+		if ( quadrants & (1 << q) )
+			out->nodeNumbers[out->nNodes++] = q;
+	}
+
+	pfree(queries);
+	PG_RETURN_VOID();
+}
+
+
+/*
+** Kd-tree variant: the prefix is the median coordinate of the split
+** page, on x at even levels and y at odd ones; node 0 holds the points
+** at or below it, node 1 the points above.
+*/
+
+PG_FUNCTION_INFO_V1(gserialized_spgist_config_kd_2d);
+Datum gserialized_spgist_config_kd_2d(PG_FUNCTION_ARGS)
+{
+	spgConfigOut *cfg = (spgConfigOut *) PG_GETARG_POINTER(1);
+
+	cfg->prefixType = FLOAT8OID;
+	cfg->labelType = VOIDOID;
+	cfg->canReturnData = true;
+	cfg->longValuesOK = false;
+	PG_RETURN_VOID();
+}
+
+PG_FUNCTION_INFO_V1(gserialized_spgist_choose_kd_2d);
+Datum gserialized_spgist_choose_kd_2d(PG_FUNCTION_ARGS)
+{
+	spgChooseIn *in = (spgChooseIn *) PG_GETARG_POINTER(0);
+	spgChooseOut *out = (spgChooseOut *) PG_GETARG_POINTER(1);
+	Point pt;
+	double coord;
+
+	out->resultType = spgMatchNode;
+	out->result.matchNode.levelAdd = 1;
+	out->result.matchNode.restDatum = in->datum;
+
+	if ( in->allTheSame )
+		PG_RETURN_VOID();
+
+	gserialized_datum_get_spgist_point(in->datum, &pt);
+	coord = (in->level % 2) ? pt.y : pt.x;
+	out->result.matchNode.nodeN = (coord > DatumGetFloat8(in->prefixDatum)) ? 1 : 0;
+
+	PG_RETURN_VOID();
+}
+
+PG_FUNCTION_INFO_V1(gserialized_spgist_picksplit_kd_2d);
+Datum gserialized_spgist_picksplit_kd_2d(PG_FUNCTION_ARGS)
+{
+	spgPickSplitIn *in = (spgPickSplitIn *) PG_GETARG_POINTER(0);
+	spgPickSplitOut *out = (spgPickSplitOut *) PG_GETARG_POINTER(1);
+	double *coords = palloc(sizeof(double) * in->nTuples);
+	double *sorted = palloc(sizeof(double) * in->nTuples);
+	double split;
+	int i;
+
+	for ( i = 0; i < in->nTuples; i++ )
+	{
+		Point pt;
+		gserialized_datum_get_spgist_point(in->datums[i], &pt);
+		coords[i] = sorted[i] = (in->level % 2) ? pt.y : pt.x;
+	}
+
+	qsort(sorted, in->nTuples, sizeof(double), spgist_cmp_double);
+	split = sorted[(in->nTuples - 1) / 2];
+
+	out->hasPrefix = true;
+	out->prefixDatum = Float8GetDatum(split);
+	out->nNodes = 2;
+	out->nodeLabels = NULL;
+	out->mapTuplesToNodes = palloc(sizeof(int) * in->nTuples);
+	out->leafTupleDatums = palloc(sizeof(Datum) * in->nTuples);
+
+	for ( i = 0; i < in->nTuples; i++ )
+	{
+		out->mapTuplesToNodes[i] = (coords[i] > split) ? 1 : 0;
+		out->leafTupleDatums[i] = in->datums[i];
+	}
+
+	pfree(coords);
+	pfree(sorted);
+	PG_RETURN_VOID();
+}
+
+PG_FUNCTION_INFO_V1(gserialized_spgist_inner_consistent_kd_2d);
+Datum gserialized_spgist_inner_consistent_kd_2d(PG_FUNCTION_ARGS)
+{
+	spgInnerConsistentIn *in = (spgInnerConsistentIn *) PG_GETARG_POINTER(0);
+	spgInnerConsistentOut *out = (spgInnerConsistentOut *) PG_GETARG_POINTER(1);
+	BOX2DF *queries = palloc(sizeof(BOX2DF) * Max(in->nkeys, 1));
+	double split;
+	int i;
+	int sides = 0x03;
+	int yaxis = in->level % 2;
+
+	if ( in->allTheSame )
+	{
+		spgist_all_nodes(in, out, 1);
+		PG_RETURN_VOID();
+	}
+
+	split = DatumGetFloat8(in->prefixDatum);
+
+	if ( spgist_scankey_boxes(in->scankeys, in->nkeys, queries) == LW_FAILURE )
+		sides = 0;
+
+	for ( i = 0; i < in->nkeys && sides; i++ )
+	{
+		if ( yaxis )
+			sides &= spgist_split_sides(split, queries[i].ymin, queries[i].ymax);
+		else
+			sides &= spgist_split_sides(split, queries[i].xmin, queries[i].xmax);
+	}
+
+	out->nNodes = 0;
+	out->nodeNumbers = palloc(sizeof(int) * 2);
+	out->levelAdds = palloc(sizeof(int) * 2);
+	for ( i = 0; i < 2; i++ )
+	{
+		if ( sides & (1 << i) )
+		{
+			out->nodeNumbers[out->nNodes] = i;
+			out->levelAdds[out->nNodes] = 1;
+			out->nNodes++;
+		}
+	}
+
+	pfree(queries);
+	PG_RETURN_VOID();
+}
+
+
+/*
+** Leaf test, shared by both variants: the leaf is the point geometry
+** itself, so the GiST leaf predicates give exact operator semantics.
+*/
+
+PG_FUNCTION_INFO_V1(gserialized_spgist_leaf_consistent_2d);
+Datum gserialized_spgist_leaf_consistent_2d(PG_FUNCTION_ARGS)
+{
+	spgLeafConsistentIn *in = (spgLeafConsistentIn *) PG_GETARG_POINTER(0);
+	spgLeafConsistentOut *out = (spgLeafConsistentOut *) PG_GETARG_POINTER(1);
+	BOX2DF leaf, query;
+	BOX2DF *leafp = NULL;
+	int i;
+
+	out->recheck = false;
+	out->leafValue = in->leafDatum;
+
+	if ( gserialized_datum_get_box2df_p(in->leafDatum, &leaf) == LW_SUCCESS )
+		leafp = &leaf;
+
+	for ( i = 0; i < in->nkeys; i++ )
+	{
+		if ( gserialized_datum_get_box2df_p(in->scankeys[i].sk_argument, &query) == LW_FAILURE )
+			PG_RETURN_BOOL(FALSE);
+
+		if ( ! gserialized_gist_consistent_leaf_2d(leafp, &query, in->scankeys[i].sk_strategy) )
+			PG_RETURN_BOOL(FALSE);
+	}
+
+	PG_RETURN_BOOL(TRUE);
+}
+
+#endif /* POSTGIS_PGSQL_VERSION >= 92 */
+
+
+
+/***********************************************************************
+** BRIN 2-D inclusion support.
+**
+** A BRIN index keeps one BOX2DF per range of heap pages, the union of
+** every box in the range. For append-only tables loaded in spatial
+** order this is a tiny index, nearly free to maintain, that still lets
+** a bitmap scan skip most ranges. The range bookkeeping and the lossy
+** bitmaps come from the core "inclusion" opclass framework; only the
+** geometry-to-box step, the box merge and the box-vs-geometry
+** operators it looks up in the opfamily are provided here.
+*/
+
+#if POSTGIS_PGSQL_VERSION >= 95
+
+/*
+** Slots of the inclusion opclass summary, private to brin_inclusion.c
+*/
+#define INCLUSION_UNION 0
+#define INCLUSION_UNMERGEABLE 1
+#define INCLUSION_CONTAINS_EMPTY 2
+
+Datum gserialized_brin_add_value_2d(PG_FUNCTION_ARGS);
+Datum gserialized_brin_merge_2d(PG_FUNCTION_ARGS);
+Datum gserialized_overlaps_box2df_geom_2d(PG_FUNCTION_ARGS);
+Datum gserialized_contains_box2df_geom_2d(PG_FUNCTION_ARGS);
+
+/*
+** BRIN support function. Grow the range summary to cover a new value.
+** Empty geometries have no box: a range holding only empties gets an
+** inverted box that overlaps nothing and vanishes in the next merge.
+*/
+PG_FUNCTION_INFO_V1(gserialized_brin_add_value_2d);
+Datum gserialized_brin_add_value_2d(PG_FUNCTION_ARGS)
+{
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	Datum newval = PG_GETARG_DATUM(2);
+	bool isnull = PG_GETARG_BOOL(3);
+	BOX2DF box;
+	BOX2DF *key;
+	bool empty = false;
+
+	if ( isnull )
+	{
+		if ( column->bv_hasnulls )
+			PG_RETURN_BOOL(false);
+		column->bv_hasnulls = true;
+		PG_RETURN_BOOL(true);
+	}
+
+	if ( gserialized_datum_get_box2df_p(newval, &box) == LW_FAILURE )
+	{
+		box.xmin = box.ymin = MAXFLOAT;
+		box.xmax = box.ymax = -MAXFLOAT;
+		empty = true;
+	}
+
+	if ( column->bv_allnulls )
+	{
+		column->bv_values[INCLUSION_UNION] = datumCopy(PointerGetDatum(&box), false, sizeof(BOX2DF));
+		column->bv_values[INCLUSION_UNMERGEABLE] = BoolGetDatum(false);
+		column->bv_values[INCLUSION_CONTAINS_EMPTY] = BoolGetDatum(empty);
+		column->bv_allnulls = false;
+		PG_RETURN_BOOL(true);
+	}
+
+	if ( empty )
+	{
+		if ( DatumGetBool(column->bv_values[INCLUSION_CONTAINS_EMPTY]) )
+			PG_RETURN_BOOL(false);
+		column->bv_values[INCLUSION_CONTAINS_EMPTY] = BoolGetDatum(true);
+		PG_RETURN_BOOL(true);
+	}
+
+	key = (BOX2DF*)DatumGetPointer(column->bv_values[INCLUSION_UNION]);
+	if ( box2df_contains(key, &box) )
+		PG_RETURN_BOOL(false);
+
+	box2df_merge(key, &box);
+	PG_RETURN_BOOL(true);
+}
+
+/*
+** BRIN support function. Return the union of two range summaries.
+*/
+PG_FUNCTION_INFO_V1(gserialized_brin_merge_2d);
+Datum gserialized_brin_merge_2d(PG_FUNCTION_ARGS)
+{
+	BOX2DF *b = box2df_copy((BOX2DF*)PG_GETARG_POINTER(0));
+	box2df_merge(b, (BOX2DF*)PG_GETARG_POINTER(1));
+	PG_RETURN_POINTER(b);
+}
+
+/*
+** BRIN operator functions, range summary against a query geometry.
+*/
+PG_FUNCTION_INFO_V1(gserialized_overlaps_box2df_geom_2d);
+Datum gserialized_overlaps_box2df_geom_2d(PG_FUNCTION_ARGS)
+{
+	BOX2DF query;
+
+	if ( gserialized_datum_get_box2df_p(PG_GETARG_DATUM(1), &query) == LW_FAILURE )
+		PG_RETURN_BOOL(FALSE);
+
+	PG_RETURN_BOOL(box2df_overlaps((BOX2DF*)PG_GETARG_POINTER(0), &query));
+}
+
+PG_FUNCTION_INFO_V1(gserialized_contains_box2df_geom_2d);
+Datum gserialized_contains_box2df_geom_2d(PG_FUNCTION_ARGS)
+{
+	BOX2DF query;
+
+	if ( gserialized_datum_get_box2df_p(PG_GETARG_DATUM(1), &query) == LW_FAILURE )
+		PG_RETURN_BOOL(FALSE);
+
+	PG_RETURN_BOOL(box2df_contains((BOX2DF*)PG_GETARG_POINTER(0), &query));
+}
+
+#endif /* POSTGIS_PGSQL_VERSION >= 95 */
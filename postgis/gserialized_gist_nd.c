@@ -26,6 +26,7 @@
 #include "access/gist.h"    /* For GiST */
 #include "access/itup.h"
 #include "access/skey.h"
+#include "utils/timestamp.h" /* For the spatio-temporal keys */
 
 #include "../postgis_config.h"
 
@@ -33,12 +34,21 @@
 #include "lwgeom_pg.h"       /* For debugging macros. */
 #include "gserialized_gist.h"	     /* For utility functions. */
 #include "geography.h"
+#include "lwgeom_transform.h" /* For spheroid_init_from_srid */
+
+#include <math.h>
+#include <float.h>
+
+#if POSTGIS_PGSQL_VERSION >= 95
+#include "access/brin_tuple.h" /* For BRIN */
+#include "utils/datum.h"
+#endif
 
 /*
-** When is a node split not so good? If more than 90% of the entries
-** end up in one of the children.
+** Minimum share of the entries each half of a node split must get.
+** Beckmann et al. [3] found 40% to perform best.
 */
-#define LIMIT_RATIO 0.1
+#define RSTAR_MIN_FILL 0.4
 
 /*
 ** For debugging
@@ -64,6 +74,8 @@ Datum gserialized_gist_penalty(PG_FUNCTION_ARGS);
 Datum gserialized_gist_picksplit(PG_FUNCTION_ARGS);
 Datum gserialized_gist_union(PG_FUNCTION_ARGS);
 Datum gserialized_gist_same(PG_FUNCTION_ARGS);
+Datum gserialized_gist_distance(PG_FUNCTION_ARGS);
+Datum gserialized_gist_geog_distance(PG_FUNCTION_ARGS);
 
 /*
 ** ND Operator prototypes
@@ -71,6 +83,7 @@ Datum gserialized_gist_same(PG_FUNCTION_ARGS);
 Datum gserialized_overlaps(PG_FUNCTION_ARGS);
 Datum gserialized_contains(PG_FUNCTION_ARGS);
 Datum gserialized_within(PG_FUNCTION_ARGS);
+Datum gserialized_distance_centroid_nd(PG_FUNCTION_ARGS);
 
 /*
 ** GIDX true/false test function type
@@ -126,6 +139,12 @@ static void gidx_merge(GIDX **b_union, GIDX *b_new)
 		POSTGIS_DEBUGF(5, "reallocating b_union from %d dims to %d dims", dims_union, dims_new);
 		*b_union = (GIDX*)repalloc(*b_union, GIDX_SIZE(dims_new));
 		SET_VARSIZE(*b_union, VARSIZE(b_new));
+		/* Missing dimensions count as zero, see gidx_overlaps() */
+		for ( i = dims_union; i < dims_new; i++ )
+		{
+			GIDX_SET_MIN(*b_union, i, 0.0);
+			GIDX_SET_MAX(*b_union, i, 0.0);
+		}
 		dims_union = dims_new;
 	}
 
@@ -137,6 +156,13 @@ static void gidx_merge(GIDX **b_union, GIDX *b_new)
 		GIDX_SET_MAX(*b_union, i, Max(GIDX_GET_MAX(*b_union,i),GIDX_GET_MAX(b_new,i)));
 	}
 
+	/* Dimensions absent from b_new count as zero, see gidx_overlaps() */
+	for ( i = dims_new; i < dims_union; i++ )
+	{
+		GIDX_SET_MIN(*b_union, i, Min(GIDX_GET_MIN(*b_union,i), 0.0));
+		GIDX_SET_MAX(*b_union, i, Max(GIDX_GET_MAX(*b_union,i), 0.0));
+	}
+
 	POSTGIS_DEBUGF(5, "merge complete (%s)", gidx_to_string(*b_union));
 	return;
 }
@@ -366,6 +392,93 @@ static bool gidx_equals(GIDX *a, GIDX *b)
 	return TRUE;
 }
 
+/*
+** Distance GIDX helpers. As in gidx_overlaps(), dimensions missing
+** from one of the boxes count as zero.
+*/
+
+static inline float gidx_get_min(GIDX *a, int i)
+{
+	return i < GIDX_NDIMS(a) ? GIDX_GET_MIN(a,i) : 0.0;
+}
+
+static inline float gidx_get_max(GIDX *a, int i)
+{
+	return i < GIDX_NDIMS(a) ? GIDX_GET_MAX(a,i) : 0.0;
+}
+
+/* Distance between the box centres. */
+static double gidx_distance_leaf_centroid(GIDX *a, GIDX *b)
+{
+	int i;
+	int ndims = Max(GIDX_NDIMS(a), GIDX_NDIMS(b));
+	double sum = 0.0;
+
+	for ( i = 0; i < ndims; i++ )
+	{
+		double ca = ((double)gidx_get_min(a,i) + gidx_get_max(a,i)) / 2.0;
+		double cb = ((double)gidx_get_min(b,i) + gidx_get_max(b,i)) / 2.0;
+		sum += (ca - cb) * (ca - cb);
+	}
+	return sqrt(sum);
+}
+
+/* Smallest distance from the centre of the query to the node box. */
+static double gidx_distance_node_centroid(GIDX *node, GIDX *query)
+{
+	int i;
+	int ndims = Max(GIDX_NDIMS(node), GIDX_NDIMS(query));
+	double sum = 0.0;
+
+	for ( i = 0; i < ndims; i++ )
+	{
+		double c = ((double)gidx_get_min(query,i) + gidx_get_max(query,i)) / 2.0;
+		double d = 0.0;
+		if ( c < gidx_get_min(node,i) )
+			d = gidx_get_min(node,i) - c;
+		else if ( c > gidx_get_max(node,i) )
+			d = c - gidx_get_max(node,i);
+		sum += d * d;
+	}
+	return sqrt(sum);
+}
+
+/* Smallest distance between any two points of the boxes. */
+static double gidx_distance(GIDX *a, GIDX *b)
+{
+	int i;
+	int ndims = Max(GIDX_NDIMS(a), GIDX_NDIMS(b));
+	double sum = 0.0;
+
+	for ( i = 0; i < ndims; i++ )
+	{
+		double d = 0.0;
+		if ( gidx_get_max(a,i) < gidx_get_min(b,i) )
+			d = (double)gidx_get_min(b,i) - gidx_get_max(a,i);
+		else if ( gidx_get_max(b,i) < gidx_get_min(a,i) )
+			d = (double)gidx_get_min(a,i) - gidx_get_max(b,i);
+		sum += d * d;
+	}
+	return sqrt(sum);
+}
+
+/**
+* Lower bound, in metres, of the spheroid distance between anything in
+* two geocentric boxes. The box distance bounds the chord between the
+* unit vectors, hence the central angle, from below. Every path on the
+* spheroid is at least as long as on a sphere of the smallest radius of
+* curvature, b^2/a, so that sphere bounds the geodesic from below.
+*/
+static double gidx_distance_spheroid_bound(GIDX *a, GIDX *b, const SPHEROID *s)
+{
+	double chord = gidx_distance(a, b);
+	double radius = s->b * s->b / s->a;
+
+	if ( chord >= 2.0 )
+		return M_PI * radius;
+	return 2.0 * asin(chord / 2.0) * radius;
+}
+
 /**
 * Support function. Based on two datums return true if
 * they satisfy the predicate and false otherwise.
@@ -464,6 +577,27 @@ Datum gserialized_overlaps(PG_FUNCTION_ARGS)
 	PG_RETURN_BOOL(FALSE);
 }
 
+/*
+** '<<->>' operator function. Distance between the centres of the
+** N-D bounding boxes.
+*/
+PG_FUNCTION_INFO_V1(gserialized_distance_centroid_nd);
+Datum gserialized_distance_centroid_nd(PG_FUNCTION_ARGS)
+{
+	char boxmem1[GIDX_MAX_SIZE];
+	char boxmem2[GIDX_MAX_SIZE];
+	GIDX *gidx1 = (GIDX*)boxmem1;
+	GIDX *gidx2 = (GIDX*)boxmem2;
+
+	/* Must be able to build box for each argument (ie, not empty geometry). */
+	if ( (gserialized_datum_get_gidx_p(PG_GETARG_DATUM(0), gidx1) == LW_SUCCESS) &&
+	     (gserialized_datum_get_gidx_p(PG_GETARG_DATUM(1), gidx2) == LW_SUCCESS) )
+	{
+		PG_RETURN_FLOAT8(gidx_distance_leaf_centroid(gidx1, gidx2));
+	}
+	PG_RETURN_FLOAT8(FLT_MAX);
+}
+
 /***********************************************************************
 * GiST Index  Support Functions
 */
@@ -688,10 +822,213 @@ Datum gserialized_gist_consistent(PG_FUNCTION_ARGS)
 }
 
 
+/*
+** GiST support function. Take in a query and an entry and return the
+** smallest distance any geometry below the entry can have from the
+** query, for the N-D geometry '<<->>' ordering operator (strategy 13).
+** Leaves return the centre distance, exactly what the operator computes.
+*/
+PG_FUNCTION_INFO_V1(gserialized_gist_distance);
+Datum gserialized_gist_distance(PG_FUNCTION_ARGS)
+{
+	GISTENTRY *entry = (GISTENTRY*) PG_GETARG_POINTER(0);
+	StrategyNumber strategy = (StrategyNumber) PG_GETARG_UINT16(2);
+	char query_box_mem[GIDX_MAX_SIZE];
+	GIDX *query_box = (GIDX*)query_box_mem;
+	GIDX *entry_box;
+
+	POSTGIS_DEBUG(4, "[GIST] 'distance' function called");
+
+	if ( strategy != 13 )
+	{
+		elog(ERROR, "unrecognized strategy number: %d", strategy);
+		PG_RETURN_FLOAT8(FLT_MAX);
+	}
+
+	/* Null box should never make this far. */
+	if ( gserialized_datum_get_gidx_p(PG_GETARG_DATUM(1), query_box) == LW_FAILURE )
+	{
+		POSTGIS_DEBUG(4, "[GIST] null query_gbox_index!");
+		PG_RETURN_FLOAT8(FLT_MAX);
+	}
+
+	entry_box = (GIDX*)DatumGetPointer(entry->key);
+
+	if ( GIST_LEAF(entry) )
+		PG_RETURN_FLOAT8(gidx_distance_leaf_centroid(entry_box, query_box));
+
+	PG_RETURN_FLOAT8(gidx_distance_node_centroid(entry_box, query_box));
+}
+
+/*
+** GiST support function for the geography '<->' ordering operator
+** (strategy 13). Returns a lower bound of the spheroid distance from
+** the geocentric boxes. Leaf results are flagged for recheck, so the
+** executor reorders on the exact distance. The opclass binds this
+** function only from PostgreSQL 9.5, the first release with that recheck.
+*/
+PG_FUNCTION_INFO_V1(gserialized_gist_geog_distance);
+Datum gserialized_gist_geog_distance(PG_FUNCTION_ARGS)
+{
+	GISTENTRY *entry = (GISTENTRY*) PG_GETARG_POINTER(0);
+	Datum query = PG_GETARG_DATUM(1);
+	StrategyNumber strategy = (StrategyNumber) PG_GETARG_UINT16(2);
+	char query_box_mem[GIDX_MAX_SIZE];
+	GIDX *query_box = (GIDX*)query_box_mem;
+	GSERIALIZED *g;
+	SPHEROID s;
+
+#if POSTGIS_PGSQL_VERSION >= 95
+	bool *recheck = (bool *) PG_GETARG_POINTER(4);
+	if ( GIST_LEAF(entry) )
+		*recheck = true;
+#endif
+
+	POSTGIS_DEBUG(4, "[GIST] 'distance' function called");
+
+	if ( strategy != 13 )
+	{
+		elog(ERROR, "unrecognized strategy number: %d", strategy);
+		PG_RETURN_FLOAT8(FLT_MAX);
+	}
+
+	/* Null box should never make this far. */
+	if ( gserialized_datum_get_gidx_p(query, query_box) == LW_FAILURE )
+	{
+		POSTGIS_DEBUG(4, "[GIST] null query_gbox_index!");
+		PG_RETURN_FLOAT8(FLT_MAX);
+	}
+
+	g = (GSERIALIZED*)PG_DETOAST_DATUM_SLICE(query, 0, 8);
+	spheroid_init_from_srid(fcinfo, gserialized_get_srid(g), &s);
+
+	PG_RETURN_FLOAT8(gidx_distance_spheroid_bound((GIDX*)DatumGetPointer(entry->key), query_box, &s));
+}
+
+
+/* Calculate the margin (sum of the edge lengths, as in [3]) of the GIDX */
+static float gidx_edge(GIDX *a)
+{
+	float result;
+	int i;
+	if ( a == NULL )
+		return 0.0;
+	result = GIDX_GET_MAX(a,0) - GIDX_GET_MIN(a,0);
+	for ( i = 1; i < GIDX_NDIMS(a); i++ )
+		result += (GIDX_GET_MAX(a,i) - GIDX_GET_MIN(a,i));
+	POSTGIS_DEBUGF(5, "calculated edge of %s as %.8g", gidx_to_string(a), result);
+	return result;
+}
+
+/* Calculate the margin of the union of the boxes. Avoids creating an intermediate box. */
+static float gidx_union_edge(GIDX *a, GIDX *b)
+{
+	float result;
+	int i;
+	int ndims_a, ndims_b;
+
+	if ( a == NULL )
+		return gidx_edge(b);
+
+	if ( b == NULL )
+		return gidx_edge(a);
+
+	/* Ensure 'a' has the most dimensions. */
+	gidx_dimensionality_check(&a, &b);
+
+	ndims_a = GIDX_NDIMS(a);
+	ndims_b = GIDX_NDIMS(b);
+
+	result = 0.0;
+	for ( i = 0; i < ndims_b; i++ )
+		result += (Max(GIDX_GET_MAX(a,i),GIDX_GET_MAX(b,i)) - Min(GIDX_GET_MIN(a,i),GIDX_GET_MIN(b,i)));
+
+	/* Add in dimensions of higher dimensional box. */
+	for ( i = ndims_b; i < ndims_a; i++ )
+		result += (GIDX_GET_MAX(a,i) - GIDX_GET_MIN(a,i));
+
+	POSTGIS_DEBUGF(5, "edge( %s union %s ) = %.12g", gidx_to_string(a), gidx_to_string(b), result);
+	return result;
+}
+
+/*
+** Volume of the GIDX counting only the dimensions flagged in 'live'.
+** The picksplit function ignores dimensions in which the whole page is
+** flat, as they would make every volume and every overlap zero.
+*/
+static double gidx_live_volume(GIDX *a, const bool *live, int ndims)
+{
+	double result = 1.0;
+	int i;
+	for ( i = 0; i < ndims; i++ )
+	{
+		if ( live[i] )
+			result *= (gidx_get_max(a,i) - gidx_get_min(a,i));
+	}
+	return result;
+}
+
+/* Volume of the intersection of the boxes, counting only the 'live' dimensions. */
+static double gidx_live_inter_volume(GIDX *a, GIDX *b, const bool *live, int ndims)
+{
+	double result = 1.0;
+	int i;
+	for ( i = 0; i < ndims; i++ )
+	{
+		double width;
+		if ( ! live[i] )
+			continue;
+		width = Min(gidx_get_max(a,i),gidx_get_max(b,i)) - Max(gidx_get_min(a,i),gidx_get_min(b,i));
+		if ( width <= 0.0 )
+			return 0.0;
+		result *= width;
+	}
+	return result;
+}
+
+/*
+** Pack a non-negative penalty value and a "realm" (0-3) into a single float,
+** such that any value of a higher realm compares greater than any value of a
+** lower one. Positive IEEE floats order like their bit patterns, so we shift
+** the value bits down to make room for the realm under the sign bit. The
+** value loses two bits of exponent range; very large values saturate.
+*/
+static float pack_float(const float value, const int realm)
+{
+	union
+	{
+		float f;
+		uint32 u;
+	} a;
+
+	a.f = value;
+	a.u = ((uint32)realm << 29) | ((a.u & 0x7FFFFFFF) >> 2);
+
+	/* Stay clear of the infinity and NaN bit patterns */
+	if ( a.u > 0x7F7FFFFF )
+		a.u = 0x7F7FFFFF;
+
+	return a.f;
+}
+
 /*
 ** GiST support function. Calculate the "penalty" cost of adding this entry into an existing entry.
-** Calculate the change in volume of the old entry once the new entry is added.
-** TODO: Re-evaluate this in light of R*Tree penalty approaches.
+**
+** The primary criterion is the growth in volume of the old entry once the new
+** entry is added, as in Guttman [1]. Points, and boxes that are flat in some
+** dimension (2D data in a 3D index, constant Z, ...) have no volume, so where
+** the volume does not change we fall back on the growth in margin, the sum of
+** the edge lengths used throughout [3]. Where neither grows, we prefer the
+** smaller of the candidate entries.
+**
+** The GiST core only compares penalties as plain floats, so the criterion
+** that decided the penalty is packed into its top bits (see pack_float), in
+** order of increasing cost:
+**
+**   0: no growth, the old entry has no volume, penalty is its margin
+**   1: no growth, penalty is the volume of the old entry
+**   2: no growth in volume, penalty is the growth in margin
+**   3: penalty is the growth in volume
 */
 PG_FUNCTION_INFO_V1(gserialized_gist_penalty);
 Datum gserialized_gist_penalty(PG_FUNCTION_ARGS)
@@ -700,7 +1037,7 @@ Datum gserialized_gist_penalty(PG_FUNCTION_ARGS)
 	GISTENTRY *newentry = (GISTENTRY*) PG_GETARG_POINTER(1);
 	float *result = (float*) PG_GETARG_POINTER(2);
 	GIDX *gbox_index_orig, *gbox_index_new;
-	float size_union, size_orig;
+	float size_union, size_orig, edge_union, edge_orig;
 
 	POSTGIS_DEBUG(4, "[GIST] 'penalty' function called");
 
@@ -720,18 +1057,22 @@ Datum gserialized_gist_penalty(PG_FUNCTION_ARGS)
 	size_orig = gidx_volume(gbox_index_orig);
 	*result = size_union - size_orig;
 
-	/* All things being equal, we prefer to expand small boxes rather than large boxes.
-	   NOTE: This code seemed to be causing badly balanced trees to be built
-	   and therefore has been commented out. Not sure why it didn't work,
-	   but it didn't.
-	if( FP_IS_ZERO(*result) )
-		if( FP_IS_ZERO(size_orig) )
-			*result = 0.0;
-		else
-			*result = 1.0 - (1.0/(1.0 + size_orig));
+	if ( *result > 0.0 )
+	{
+		*result = pack_float(*result, 3);
+	}
 	else
-		*result += 1.0;
-	*/
+	{
+		edge_union = gidx_union_edge(gbox_index_orig, gbox_index_new);
+		edge_orig = gidx_edge(gbox_index_orig);
+
+		if ( edge_union - edge_orig > 0.0 )
+			*result = pack_float(edge_union - edge_orig, 2);
+		else if ( size_orig > 0.0 )
+			*result = pack_float(size_orig, 1);
+		else
+			*result = pack_float(edge_orig, 0);
+	}
 
 	POSTGIS_DEBUGF(4, "[GIST] union size (%.12f), original size (%.12f), penalty (%.12f)", size_union, size_orig, *result);
 
@@ -792,46 +1133,6 @@ Datum gserialized_gist_same(PG_FUNCTION_ARGS)
 
 
 
-/*
-** Utility function to add entries to the axis partition lists in the
-** picksplit function.
-*/
-static void gserialized_gist_picksplit_addlist(OffsetNumber *list, GIDX **box_union, GIDX *box_current, int *pos, int num)
-{
-	if ( *pos )
-		gidx_merge(box_union,  box_current);
-	else
-		memcpy((void*)(*box_union), (void*)box_current, VARSIZE(box_current));
-	list[*pos] = num;
-	(*pos)++;
-}
-
-/*
-** Utility function check whether the number of entries two halves of the
-** space constitute a "bad ratio" (poor balance).
-*/
-static int gserialized_gist_picksplit_badratio(int x, int y)
-{
-	POSTGIS_DEBUGF(4, "[GIST] checking split ratio (%d, %d)", x, y);
-	if ( (y == 0) || (((float)x / (float)y) < LIMIT_RATIO) ||
-	     (x == 0) || (((float)y / (float)x) < LIMIT_RATIO) )
-		return TRUE;
-
-	return FALSE;
-}
-
-static bool gserialized_gist_picksplit_badratios(int *pos, int dims)
-{
-	int i;
-	for ( i = 0; i < dims; i++ )
-	{
-		if ( gserialized_gist_picksplit_badratio(pos[2*i],pos[2*i+1]) == FALSE )
-			return FALSE;
-	}
-	return TRUE;
-}
-
-
 /*
 ** Where the picksplit algorithm cannot find any basis for splitting one way
 ** or another, we simply split the overflowing node in half.
@@ -981,15 +1282,88 @@ static void gserialized_gist_picksplit_constructsplit(GIST_SPLITVEC *v, OffsetNu
 }
 
 
-#define BELOW(d) (2*(d))
-#define ABOVE(d) ((2*(d))+1)
+/*
+** An entry of the node being split, with its extent along the axis the
+** entries are currently sorted on.
+*/
+typedef struct
+{
+	OffsetNumber index;
+	float lower;
+	float upper;
+	GIDX *box;
+} gidx_split_entry;
+
+/* Order split entries by lower bound, then upper bound. */
+static int gidx_split_entry_cmp_lower(const void *a, const void *b)
+{
+	const gidx_split_entry *ea = (const gidx_split_entry*)a;
+	const gidx_split_entry *eb = (const gidx_split_entry*)b;
+	if ( ea->lower != eb->lower )
+		return ea->lower < eb->lower ? -1 : 1;
+	if ( ea->upper != eb->upper )
+		return ea->upper < eb->upper ? -1 : 1;
+	return 0;
+}
+
+/* Order split entries by upper bound, then lower bound. */
+static int gidx_split_entry_cmp_upper(const void *a, const void *b)
+{
+	const gidx_split_entry *ea = (const gidx_split_entry*)a;
+	const gidx_split_entry *eb = (const gidx_split_entry*)b;
+	if ( ea->upper != eb->upper )
+		return ea->upper < eb->upper ? -1 : 1;
+	if ( ea->lower != eb->lower )
+		return ea->lower < eb->lower ? -1 : 1;
+	return 0;
+}
+
+/*
+** Sort the split entries along axis 'dim', by lower bound if 'by_upper' is
+** false and by upper bound otherwise, then fill in the unions of every
+** prefix (box_head[k] covers entries 0..k) and every suffix (box_tail[k]
+** covers entries k..n-1) of the sorted array.
+*/
+static void gserialized_gist_picksplit_sort(gidx_split_entry *entries, int n, int dim, bool by_upper, GIDX **box_head, GIDX **box_tail)
+{
+	int k;
+
+	for ( k = 0; k < n; k++ )
+	{
+		entries[k].lower = gidx_get_min(entries[k].box, dim);
+		entries[k].upper = gidx_get_max(entries[k].box, dim);
+	}
+
+	qsort(entries, n, sizeof(gidx_split_entry),
+	      by_upper ? gidx_split_entry_cmp_upper : gidx_split_entry_cmp_lower);
+
+	box_head[0] = gidx_copy(entries[0].box);
+	for ( k = 1; k < n; k++ )
+	{
+		box_head[k] = gidx_copy(box_head[k-1]);
+		gidx_merge(&(box_head[k]), entries[k].box);
+	}
+
+	box_tail[n-1] = gidx_copy(entries[n-1].box);
+	for ( k = n - 2; k >= 0; k-- )
+	{
+		box_tail[k] = gidx_copy(box_tail[k+1]);
+		gidx_merge(&(box_tail[k]), entries[k].box);
+	}
+}
 
 /*
 ** GiST support function. Split an overflowing node into two new nodes.
-** Uses linear algorithm from Ang & Tan [2], dividing node extent into
-** four quadrants, and splitting along the axis that most evenly distributes
-** entries between the new nodes.
-** TODO: Re-evaluate this in light of R*Tree picksplit approaches.
+** Uses the split algorithm of the R*-tree [3]. For every axis the entries
+** are sorted by lower and by upper bound, and every distribution of the
+** sorted entries into a head and a tail holding at least RSTAR_MIN_FILL of
+** the entries each is considered. The split axis is the one with the
+** smallest sum of margins over its distributions, which favours square-ish
+** nodes; along that axis we pick the distribution with the least overlap
+** between the halves, then with the least total volume, then with the least
+** total margin. Dimensions in which the whole node is flat are left out of
+** the volume and overlap computations, so that sets of points, or of
+** boxes sharing a Z value, still split on the dimensions that vary.
 */
 PG_FUNCTION_INFO_V1(gserialized_gist_picksplit);
 Datum gserialized_gist_picksplit(PG_FUNCTION_ARGS)
@@ -999,19 +1373,24 @@ Datum gserialized_gist_picksplit(PG_FUNCTION_ARGS)
 
 	GIST_SPLITVEC *v = (GIST_SPLITVEC*) PG_GETARG_POINTER(1);
 	OffsetNumber i;
-	/* One union box for each half of the space. */
-	GIDX **box_union;
-	/* One offset number list for each half of the space. */
-	OffsetNumber **list;
-	/* One position index for each half of the space. */
-	int *pos;
 	GIDX *box_pageunion;
 	GIDX *box_current;
-	int direction = -1;
+	/* Entries of the node, and the unions of the head and tail of each distribution. */
+	gidx_split_entry *entries;
+	GIDX **box_head, **box_tail;
+	/* Dimensions in which the page has some extent. */
+	bool *live;
 	bool all_entries_equal = true;
 	OffsetNumber max_offset;
-	int nbytes, ndims_pageunion, d;
-	int posmax = -1;
+	OffsetNumber *list_head, *list_tail;
+	int nentries, minfill, ndims_pageunion, d, k, s;
+	int direction = -1;
+	int best_k = -1;
+	bool best_upper = false;
+	double best_margin = DBL_MAX;
+	double best_overlap = DBL_MAX;
+	double best_volume = DBL_MAX;
+	double best_edge = DBL_MAX;
 
 	POSTGIS_DEBUG(4, "[GIST] 'picksplit' function called");
 
@@ -1045,146 +1424,108 @@ Datum gserialized_gist_picksplit(PG_FUNCTION_ARGS)
 	}
 
 	/* Initialize memory structures. */
-	nbytes = (max_offset + 2) * sizeof(OffsetNumber);
+	nentries = max_offset - FirstOffsetNumber + 1;
+	minfill = Max(1, (int)(nentries * RSTAR_MIN_FILL));
 	ndims_pageunion = GIDX_NDIMS(box_pageunion);
 	POSTGIS_DEBUGF(4, "[GIST] ndims_pageunion == %d", ndims_pageunion);
-	pos = palloc(2*ndims_pageunion * sizeof(int));
-	list = palloc(2*ndims_pageunion * sizeof(OffsetNumber*));
-	box_union = palloc(2*ndims_pageunion * sizeof(GIDX*));
-	for ( d = 0; d < ndims_pageunion; d++ )
-	{
-		list[BELOW(d)] = (OffsetNumber*) palloc(nbytes);
-		list[ABOVE(d)] = (OffsetNumber*) palloc(nbytes);
-		box_union[BELOW(d)] = gidx_new(ndims_pageunion);
-		box_union[ABOVE(d)] = gidx_new(ndims_pageunion);
-		pos[BELOW(d)] = 0;
-		pos[ABOVE(d)] = 0;
-	}
 
-	/*
-	** Assign each entry in the node to the volume partitions it belongs to,
-	** such as "above the x/y plane, left of the y/z plane, below the x/z plane".
-	** Each entry thereby ends up in three of the six partitions.
-	*/
-	POSTGIS_DEBUG(4, "[GIST] 'picksplit' calculating best split axis");
+	entries = palloc(nentries * sizeof(gidx_split_entry));
+	box_head = palloc(nentries * sizeof(GIDX*));
+	box_tail = palloc(nentries * sizeof(GIDX*));
+	live = palloc(ndims_pageunion * sizeof(bool));
+
 	for ( i = FirstOffsetNumber; i <= max_offset; i = OffsetNumberNext(i) )
 	{
-		box_current = (GIDX*) DatumGetPointer(entryvec->vector[i].key);
-
-		for ( d = 0; d < ndims_pageunion; d++ )
-		{
-			if ( GIDX_GET_MIN(box_current,d)-GIDX_GET_MIN(box_pageunion,d) < GIDX_GET_MAX(box_pageunion,d)-GIDX_GET_MAX(box_current,d) )
-			{
-				gserialized_gist_picksplit_addlist(list[BELOW(d)], &(box_union[BELOW(d)]), box_current, &(pos[BELOW(d)]), i);
-			}
-			else
-			{
-				gserialized_gist_picksplit_addlist(list[ABOVE(d)], &(box_union[ABOVE(d)]), box_current, &(pos[ABOVE(d)]), i);
-			}
-
-		}
-
+		entries[i - FirstOffsetNumber].index = i;
+		entries[i - FirstOffsetNumber].box = (GIDX*) DatumGetPointer(entryvec->vector[i].key);
 	}
 
+	for ( d = 0; d < ndims_pageunion; d++ )
+		live[d] = GIDX_GET_MAX(box_pageunion,d) > GIDX_GET_MIN(box_pageunion,d);
+
 	/*
-	** "Bad disposition", too many entries fell into one octant of the space, so no matter which
-	** plane we choose to split on, we're going to end up with a mostly full node. Where the
-	** data is pretty homogeneous (lots of duplicates) entries that are equidistant from the
-	** sides of the page union box can occasionally all end up in one place, leading
-	** to this condition.
+	** Choose the split axis: the one where the distributions have the
+	** smallest margins overall.
 	*/
-	if ( gserialized_gist_picksplit_badratios(pos,ndims_pageunion) == TRUE )
+	POSTGIS_DEBUG(4, "[GIST] 'picksplit' calculating best split axis");
+	for ( d = 0; d < ndims_pageunion; d++ )
 	{
-		/*
-		** Instead we split on center points and see if we do better.
-		** First calculate the average center point for each axis.
-		*/
-		double *avgCenter = palloc(ndims_pageunion * sizeof(double));
+		double margin = 0.0;
 
-		for ( d = 0; d < ndims_pageunion; d++ )
-		{
-			avgCenter[d] = 0.0;
-		}
-
-		POSTGIS_DEBUG(4, "[GIST] picksplit can't find good split axis, trying center point method");
+		if ( ! live[d] )
+			continue;
 
-		for ( i = FirstOffsetNumber; i <= max_offset; i = OffsetNumberNext(i) )
+		for ( s = 0; s < 2; s++ )
 		{
-			box_current = (GIDX*) DatumGetPointer(entryvec->vector[i].key);
-			for ( d = 0; d < ndims_pageunion; d++ )
-			{
-				avgCenter[d] += (GIDX_GET_MAX(box_current,d) + GIDX_GET_MIN(box_current,d)) / 2.0;
-			}
-		}
-		for ( d = 0; d < ndims_pageunion; d++ )
-		{
-			avgCenter[d] /= max_offset;
-			pos[BELOW(d)] = pos[ABOVE(d)] = 0; /* Re-initialize our counters. */
-			POSTGIS_DEBUGF(4, "[GIST] picksplit average center point[%d] = %.12g", d, avgCenter[d]);
+			gserialized_gist_picksplit_sort(entries, nentries, d, s, box_head, box_tail);
+			for ( k = minfill; k <= nentries - minfill; k++ )
+				margin += gidx_edge(box_head[k-1]) + gidx_edge(box_tail[k]);
 		}
 
-		/* For each of our entries... */
-		for ( i = FirstOffsetNumber; i <= max_offset; i = OffsetNumberNext(i) )
-		{
-			double center;
-			box_current = (GIDX*) DatumGetPointer(entryvec->vector[i].key);
+		POSTGIS_DEBUGF(4, "[GIST] picksplit axis %d margin %.12g", d, margin);
 
-			for ( d = 0; d < ndims_pageunion; d++ )
-			{
-				center = (GIDX_GET_MIN(box_current,d)+GIDX_GET_MAX(box_current,d))/2.0;
-				if ( center < avgCenter[d] )
-					gserialized_gist_picksplit_addlist(list[BELOW(d)], &(box_union[BELOW(d)]), box_current, &(pos[BELOW(d)]), i);
-				else if ( FPeq(center, avgCenter[d]) )
-					if ( pos[BELOW(d)] > pos[ABOVE(d)] )
-						gserialized_gist_picksplit_addlist(list[ABOVE(d)], &(box_union[ABOVE(d)]), box_current, &(pos[ABOVE(d)]), i);
-					else
-						gserialized_gist_picksplit_addlist(list[BELOW(d)], &(box_union[BELOW(d)]), box_current, &(pos[BELOW(d)]), i);
-				else
-					gserialized_gist_picksplit_addlist(list[ABOVE(d)], &(box_union[ABOVE(d)]), box_current, &(pos[ABOVE(d)]), i);
-			}
-
-		}
-
-		/* Do we have a good disposition now? If not, screw it, just cut the node in half. */
-		if ( gserialized_gist_picksplit_badratios(pos,ndims_pageunion) == TRUE )
+		if ( margin < best_margin )
 		{
-			POSTGIS_DEBUG(4, "[GIST] picksplit still cannot find a good split! just cutting the node in half");
-			gserialized_gist_picksplit_fallback(entryvec, v);
-			PG_RETURN_POINTER(v);
+			best_margin = margin;
+			direction = d;
 		}
+	}
 
+	/* The page has no extent at all, so there is nothing to split on. */
+	if ( direction == -1 )
+	{
+		POSTGIS_DEBUG(4, "[GIST] picksplit finds no axis with any extent!");
+		gserialized_gist_picksplit_fallback(entryvec, v);
+		PG_RETURN_POINTER(v);
 	}
 
+	POSTGIS_DEBUGF(3, "[GIST] 'picksplit' splitting on axis %d", direction);
+
 	/*
-	** Now, what splitting plane gives us the most even ratio of
-	** entries in our child pages? Since each split region has been apportioned entries
-	** against the same number of total entries, the axis that has the smallest maximum
-	** number of entries in its regions is the most evenly distributed.
-	** TODO: what if the distributions are equal in two or more axes?
+	** Choose the distribution along that axis with the least overlap,
+	** then the least volume, then the least margin.
 	*/
-	for ( d = 0; d < ndims_pageunion; d++ )
+	for ( s = 0; s < 2; s++ )
 	{
-		int posd = Max(pos[ABOVE(d)],pos[BELOW(d)]);
-		if ( posd > posmax )
+		gserialized_gist_picksplit_sort(entries, nentries, direction, s, box_head, box_tail);
+		for ( k = minfill; k <= nentries - minfill; k++ )
 		{
-			direction = d;
-			posmax = posd;
+			double overlap = gidx_live_inter_volume(box_head[k-1], box_tail[k], live, ndims_pageunion);
+			double volume = gidx_live_volume(box_head[k-1], live, ndims_pageunion) +
+			                gidx_live_volume(box_tail[k], live, ndims_pageunion);
+			double edge = gidx_edge(box_head[k-1]) + gidx_edge(box_tail[k]);
+
+			if ( overlap < best_overlap ||
+			     ( overlap == best_overlap && volume < best_volume ) ||
+			     ( overlap == best_overlap && volume == best_volume && edge < best_edge ) )
+			{
+				best_overlap = overlap;
+				best_volume = volume;
+				best_edge = edge;
+				best_k = k;
+				best_upper = s;
+			}
 		}
 	}
-	if ( direction == -1 || posmax == -1 )
-	{
-		/* ERROR OUT HERE */
-		elog(ERROR, "Error in building split, unable to determine split direction.");
-	}
 
-	POSTGIS_DEBUGF(3, "[GIST] 'picksplit' splitting on axis %d", direction);
+	POSTGIS_DEBUGF(4, "[GIST] picksplit distribution %d/%d by %s bound, overlap %.12g, volume %.12g",
+	               best_k, nentries - best_k, best_upper ? "upper" : "lower", best_overlap, best_volume);
 
-	gserialized_gist_picksplit_constructsplit(v, list[BELOW(direction)],
-	                                        pos[BELOW(direction)],
-	                                        &(box_union[BELOW(direction)]),
-	                                        list[ABOVE(direction)],
-	                                        pos[ABOVE(direction)],
-	                                        &(box_union[ABOVE(direction)]) );
+	/* Bring the entries back into the order of the winning distribution. */
+	if ( ! best_upper )
+		gserialized_gist_picksplit_sort(entries, nentries, direction, best_upper, box_head, box_tail);
+
+	list_head = (OffsetNumber*) palloc((nentries + 1) * sizeof(OffsetNumber));
+	list_tail = (OffsetNumber*) palloc((nentries + 1) * sizeof(OffsetNumber));
+	for ( k = 0; k < best_k; k++ )
+		list_head[k] = entries[k].index;
+	for ( k = best_k; k < nentries; k++ )
+		list_tail[k - best_k] = entries[k].index;
+
+	gserialized_gist_picksplit_constructsplit(v, list_head, best_k,
+	                                        &(box_head[best_k-1]),
+	                                        list_tail, nentries - best_k,
+	                                        &(box_tail[best_k]) );
 
 	POSTGIS_DEBUGF(4, "[GIST] spl_ldatum: %s", gidx_to_string((GIDX*)v->spl_ldatum));
 	POSTGIS_DEBUGF(4, "[GIST] spl_rdatum: %s", gidx_to_string((GIDX*)v->spl_rdatum));
@@ -1218,3 +1559,350 @@ Datum gidx_out(PG_FUNCTION_ARGS)
 	               errmsg("function gidx_out not implemented")));
 	PG_RETURN_POINTER(NULL);
 }
+
+
+
+/***********************************************************************
+** Spatio-temporal keys, for a single GiST descent on queries like
+** "geom && box AND ts BETWEEN t1 AND t2". ST_STKey() folds a geometry
+** and a timestamp into a 4-D GIDX, the x/y/z of the geometry box plus
+** the time in the fourth (M) dimension, and the gist_gidx_ops operator
+** class indexes such keys with the N-D union, penalty and picksplit.
+**
+** The time is stored as float seconds since 2020-01-01 and rounded
+** outward to the next float. The float spacing doubles with each
+** doubling of the distance to 2020: it is at most 16 seconds from
+** mid-2011 to mid-2028 and 32 seconds from 2003 to 2037, so each end
+** of a key may widen by that much and the key test is a pre-filter
+** for the exact one. Counted from the PostgreSQL epoch, 2000-01-01,
+** the spacing would be 64 seconds for present-day timestamps.
+*/
+
+#define ST_KEY_NDIMS 4
+#define ST_KEY_TIME 3
+/* 2020-01-01 in seconds since the PostgreSQL epoch */
+#define ST_KEY_EPOCH 631152000.0
+
+Datum gserialized_st_key(PG_FUNCTION_ARGS);
+Datum gserialized_st_key_range(PG_FUNCTION_ARGS);
+Datum gidx_gidx_overlaps(PG_FUNCTION_ARGS);
+Datum gidx_gist_compress(PG_FUNCTION_ARGS);
+Datum gidx_gist_consistent(PG_FUNCTION_ARGS);
+
+/*
+** Bound of the time dimension for a timestamp or timestamptz,
+** which share the same representation.
+*/
+static float st_key_time_bound(Timestamp t, bool upper)
+{
+	double seconds;
+
+	if ( TIMESTAMP_IS_NOBEGIN(t) )
+		return -FLT_MAX;
+	if ( TIMESTAMP_IS_NOEND(t) )
+		return FLT_MAX;
+
+#if POSTGIS_PGSQL_VERSION >= 100 || defined(HAVE_INT64_TIMESTAMP)
+	seconds = (double)t / USECS_PER_SEC - ST_KEY_EPOCH;
+#else
+	seconds = (double)t - ST_KEY_EPOCH;
+#endif
+
+	return upper ? next_float_up(seconds) : next_float_down(seconds);
+}
+
+/*
+** Fill the spatial dimensions of a spatio-temporal key. Geometries
+** without Z get z = 0 in stored keys, the way the N-D operators read
+** missing dimensions, and an unbounded z in search keys, so that a 2-D
+** search box matches keys at any height. Returns LW_FAILURE on empties.
+*/
+static int st_key_from_datum(Datum gsdatum, bool search, GIDX *key)
+{
+	char boxmem[GIDX_MAX_SIZE];
+	GIDX *box = (GIDX*)boxmem;
+	GSERIALIZED *gpart;
+	int i;
+
+	if ( gserialized_datum_get_gidx_p(gsdatum, box) == LW_FAILURE )
+		return LW_FAILURE;
+
+	/* Only the header is needed to find out about Z */
+	gpart = (GSERIALIZED*)PG_DETOAST_DATUM_SLICE(gsdatum, 0, 8);
+
+	SET_VARSIZE(key, GIDX_SIZE(ST_KEY_NDIMS));
+	for ( i = 0; i < 2; i++ )
+	{
+		GIDX_SET_MIN(key, i, GIDX_GET_MIN(box, i));
+		GIDX_SET_MAX(key, i, GIDX_GET_MAX(box, i));
+	}
+
+	if ( FLAGS_GET_Z(gpart->flags) )
+	{
+		GIDX_SET_MIN(key, 2, GIDX_GET_MIN(box, 2));
+		GIDX_SET_MAX(key, 2, GIDX_GET_MAX(box, 2));
+	}
+	else if ( search )
+	{
+		GIDX_SET_MIN(key, 2, -FLT_MAX);
+		GIDX_SET_MAX(key, 2, FLT_MAX);
+	}
+	else
+	{
+		GIDX_SET_MIN(key, 2, 0.0);
+		GIDX_SET_MAX(key, 2, 0.0);
+	}
+
+	return LW_SUCCESS;
+}
+
+/*
+** ST_STKey(geometry, timestamp[tz]), the key stored in the index.
+** NULL for empty or infinite geometries and for infinite timestamps,
+** which are left out of the index.
+*/
+PG_FUNCTION_INFO_V1(gserialized_st_key);
+Datum gserialized_st_key(PG_FUNCTION_ARGS)
+{
+	Timestamp t = PG_GETARG_TIMESTAMP(1);
+	GIDX *key = gidx_new(ST_KEY_NDIMS);
+	int i;
+
+	if ( TIMESTAMP_NOT_FINITE(t) )
+		PG_RETURN_NULL();
+
+	if ( st_key_from_datum(PG_GETARG_DATUM(0), false, key) == LW_FAILURE )
+		PG_RETURN_NULL();
+
+	for ( i = 0; i < ST_KEY_TIME; i++ )
+	{
+		if ( ! finite(GIDX_GET_MIN(key, i)) || ! finite(GIDX_GET_MAX(key, i)) )
+			PG_RETURN_NULL();
+	}
+
+	GIDX_SET_MIN(key, ST_KEY_TIME, st_key_time_bound(t, false));
+	GIDX_SET_MAX(key, ST_KEY_TIME, st_key_time_bound(t, true));
+
+	PG_RETURN_POINTER(key);
+}
+
+/*
+** ST_STKey(geometry, timestamp[tz], timestamp[tz]), a search key for
+** the geometry box and the closed time range, which may be open-ended
+** with -infinity and infinity.
+*/
+PG_FUNCTION_INFO_V1(gserialized_st_key_range);
+Datum gserialized_st_key_range(PG_FUNCTION_ARGS)
+{
+	Timestamp t1 = PG_GETARG_TIMESTAMP(1);
+	Timestamp t2 = PG_GETARG_TIMESTAMP(2);
+	GIDX *key = gidx_new(ST_KEY_NDIMS);
+
+	if ( st_key_from_datum(PG_GETARG_DATUM(0), true, key) == LW_FAILURE )
+		PG_RETURN_NULL();
+
+	GIDX_SET_MIN(key, ST_KEY_TIME, st_key_time_bound(t1, false));
+	GIDX_SET_MAX(key, ST_KEY_TIME, st_key_time_bound(t2, true));
+
+	PG_RETURN_POINTER(key);
+}
+
+/*
+** GIDX &&& GIDX operator function.
+*/
+PG_FUNCTION_INFO_V1(gidx_gidx_overlaps);
+Datum gidx_gidx_overlaps(PG_FUNCTION_ARGS)
+{
+	GIDX *a = (GIDX*)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
+	GIDX *b = (GIDX*)PG_DETOAST_DATUM(PG_GETARG_DATUM(1));
+
+	PG_RETURN_BOOL(gidx_overlaps(a, b));
+}
+
+/*
+** GiST support function. Indexed values already are GIDX keys,
+** so leaf keys only need to be detoasted.
+*/
+PG_FUNCTION_INFO_V1(gidx_gist_compress);
+Datum gidx_gist_compress(PG_FUNCTION_ARGS)
+{
+	GISTENTRY *entry_in = (GISTENTRY*)PG_GETARG_POINTER(0);
+	GISTENTRY *entry_out;
+	GIDX *key;
+
+	if ( ! entry_in->leafkey || DatumGetPointer(entry_in->key) == NULL )
+		PG_RETURN_POINTER(entry_in);
+
+	key = (GIDX*)PG_DETOAST_DATUM(entry_in->key);
+	if ( (Pointer)key == DatumGetPointer(entry_in->key) )
+		PG_RETURN_POINTER(entry_in);
+
+	entry_out = palloc(sizeof(GISTENTRY));
+	gistentryinit(*entry_out, PointerGetDatum(key),
+	              entry_in->rel, entry_in->page, entry_in->offset, FALSE);
+	PG_RETURN_POINTER(entry_out);
+}
+
+/*
+** GiST support function. As gserialized_gist_consistent, with a GIDX
+** query. Keys are compared to keys, so no recheck is needed.
+*/
+PG_FUNCTION_INFO_V1(gidx_gist_consistent);
+Datum gidx_gist_consistent(PG_FUNCTION_ARGS)
+{
+	GISTENTRY *entry = (GISTENTRY*) PG_GETARG_POINTER(0);
+	StrategyNumber strategy = (StrategyNumber) PG_GETARG_UINT16(2);
+	GIDX *query;
+
+#if POSTGIS_PGSQL_VERSION >= 84
+	bool *recheck = (bool *) PG_GETARG_POINTER(4);
+	*recheck = false;
+#endif
+
+	if ( DatumGetPointer(PG_GETARG_DATUM(1)) == NULL ||
+	     DatumGetPointer(entry->key) == NULL )
+		PG_RETURN_BOOL(FALSE);
+
+	query = (GIDX*)PG_DETOAST_DATUM(PG_GETARG_DATUM(1));
+
+	if (GIST_LEAF(entry))
+		PG_RETURN_BOOL(gserialized_gist_consistent_leaf(
+		                   (GIDX*)DatumGetPointer(entry->key), query, strategy));
+
+	PG_RETURN_BOOL(gserialized_gist_consistent_internal(
+	                   (GIDX*)DatumGetPointer(entry->key), query, strategy));
+}
+
+
+/***********************************************************************
+** BRIN N-D inclusion support, for geometry (&&&) and geography (&&).
+** Same scheme as the 2-D support in gserialized_gist_2d.c, with a GIDX
+** union per range of heap pages.
+*/
+
+#if POSTGIS_PGSQL_VERSION >= 95
+
+/*
+** Slots of the inclusion opclass summary, private to brin_inclusion.c
+*/
+#define INCLUSION_UNION 0
+#define INCLUSION_UNMERGEABLE 1
+#define INCLUSION_CONTAINS_EMPTY 2
+
+Datum gserialized_brin_add_value(PG_FUNCTION_ARGS);
+Datum gserialized_brin_merge(PG_FUNCTION_ARGS);
+Datum gserialized_gidx_overlaps(PG_FUNCTION_ARGS);
+
+/*
+** True if gidx_merge(key, b) would leave key unchanged, so that
+** unchanged summaries are not rewritten on every insert.
+*/
+static bool gidx_covers(GIDX *key, GIDX *b)
+{
+	int i;
+	int dims_key = GIDX_NDIMS(key);
+	int dims_b = GIDX_NDIMS(b);
+
+	if ( dims_b > dims_key )
+		return FALSE;
+
+	for ( i = 0; i < dims_key; i++ )
+	{
+		float bmin = i < dims_b ? GIDX_GET_MIN(b,i) : 0.0;
+		float bmax = i < dims_b ? GIDX_GET_MAX(b,i) : 0.0;
+		if ( GIDX_GET_MIN(key,i) > bmin || GIDX_GET_MAX(key,i) < bmax )
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+** BRIN support function. Grow the range summary to cover a new value.
+** A range holding only empties gets an inverted 2-D box that overlaps
+** nothing and vanishes in the next merge.
+*/
+PG_FUNCTION_INFO_V1(gserialized_brin_add_value);
+Datum gserialized_brin_add_value(PG_FUNCTION_ARGS)
+{
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	Datum newval = PG_GETARG_DATUM(2);
+	bool isnull = PG_GETARG_BOOL(3);
+	char boxmem[GIDX_MAX_SIZE];
+	GIDX *gidx = (GIDX*)boxmem;
+	GIDX *key;
+	bool empty = false;
+
+	if ( isnull )
+	{
+		if ( column->bv_hasnulls )
+			PG_RETURN_BOOL(false);
+		column->bv_hasnulls = true;
+		PG_RETURN_BOOL(true);
+	}
+
+	if ( gserialized_datum_get_gidx_p(newval, gidx) == LW_FAILURE )
+	{
+		SET_VARSIZE(gidx, GIDX_SIZE(2));
+		GIDX_SET_MIN(gidx, 0, FLT_MAX); GIDX_SET_MAX(gidx, 0, -FLT_MAX);
+		GIDX_SET_MIN(gidx, 1, FLT_MAX); GIDX_SET_MAX(gidx, 1, -FLT_MAX);
+		empty = true;
+	}
+
+	if ( column->bv_allnulls )
+	{
+		column->bv_values[INCLUSION_UNION] = datumCopy(PointerGetDatum(gidx), false, -1);
+		column->bv_values[INCLUSION_UNMERGEABLE] = BoolGetDatum(false);
+		column->bv_values[INCLUSION_CONTAINS_EMPTY] = BoolGetDatum(empty);
+		column->bv_allnulls = false;
+		PG_RETURN_BOOL(true);
+	}
+
+	if ( empty )
+	{
+		if ( DatumGetBool(column->bv_values[INCLUSION_CONTAINS_EMPTY]) )
+			PG_RETURN_BOOL(false);
+		column->bv_values[INCLUSION_CONTAINS_EMPTY] = BoolGetDatum(true);
+		PG_RETURN_BOOL(true);
+	}
+
+	key = (GIDX*)DatumGetPointer(column->bv_values[INCLUSION_UNION]);
+	if ( gidx_covers(key, gidx) )
+		PG_RETURN_BOOL(false);
+
+	gidx_merge(&key, gidx);
+	column->bv_values[INCLUSION_UNION] = PointerGetDatum(key);
+	PG_RETURN_BOOL(true);
+}
+
+/*
+** BRIN support function. Return the union of two range summaries.
+*/
+PG_FUNCTION_INFO_V1(gserialized_brin_merge);
+Datum gserialized_brin_merge(PG_FUNCTION_ARGS)
+{
+	GIDX *a = (GIDX*)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
+	GIDX *b = (GIDX*)PG_DETOAST_DATUM(PG_GETARG_DATUM(1));
+	GIDX *u = gidx_copy(a);
+
+	gidx_merge(&u, b);
+	PG_RETURN_POINTER(u);
+}
+
+/*
+** BRIN operator function, range summary overlaps a query geometry or
+** geography.
+*/
+PG_FUNCTION_INFO_V1(gserialized_gidx_overlaps);
+Datum gserialized_gidx_overlaps(PG_FUNCTION_ARGS)
+{
+	GIDX *key = (GIDX*)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
+	char boxmem[GIDX_MAX_SIZE];
+	GIDX *query = (GIDX*)boxmem;
+
+	if ( gserialized_datum_get_gidx_p(PG_GETARG_DATUM(1), query) == LW_FAILURE )
+		PG_RETURN_BOOL(FALSE);
+
+	PG_RETURN_BOOL(gidx_overlaps(key, query));
+}
+
+#endif /* POSTGIS_PGSQL_VERSION >= 95 */
@@ -21,6 +21,7 @@
 
 #include "liblwgeom.h"
 #include "lwgeom_pg.h"
+#include "lwgeom_out_mvt.h"
 
 /* Local prototypes */
 Datum PGISDirectFunctionCall1(PGFunction func, Datum arg1);
@@ -30,6 +31,10 @@ Datum pgis_geometry_union_finalfn(PG_FUNCTION_ARGS);
 Datum pgis_geometry_collect_finalfn(PG_FUNCTION_ARGS);
 Datum pgis_geometry_polygonize_finalfn(PG_FUNCTION_ARGS);
 Datum pgis_geometry_makeline_finalfn(PG_FUNCTION_ARGS);
+Datum pgis_twkb_accum_transfn(PG_FUNCTION_ARGS);
+Datum pgis_twkb_accum_finalfn(PG_FUNCTION_ARGS);
+Datum pgis_asmvt_transfn(PG_FUNCTION_ARGS);
+Datum pgis_asmvt_finalfn(PG_FUNCTION_ARGS);
 Datum pgis_abs_in(PG_FUNCTION_ARGS);
 Datum pgis_abs_out(PG_FUNCTION_ARGS);
 
@@ -38,6 +43,7 @@ Datum pgis_union_geometry_array(PG_FUNCTION_ARGS);
 Datum LWGEOM_collect_garray(PG_FUNCTION_ARGS);
 Datum polygonize_garray(PG_FUNCTION_ARGS);
 Datum LWGEOM_makeline_garray(PG_FUNCTION_ARGS);
+Datum TWKBFromLWGEOMArray(PG_FUNCTION_ARGS);
 
 
 /** @file
@@ -301,6 +307,208 @@ pgis_geometry_makeline_finalfn(PG_FUNCTION_ARGS)
 	PG_RETURN_DATUM(result);
 }
 
+/**
+** The TWKB aggregate collects ids alongside the geometries, so its
+** state lives in the aggregate memory context and only the pointer
+** to it travels in the pgis_abs.
+*/
+typedef struct
+{
+	ArrayBuildState *geoms;
+	ArrayBuildState *ids;
+	int32 precision;
+}
+pgis_twkb_state;
+
+/**
+** Accumulates (geometry, id [, precision]) for ST_AsTWKBAgg. The
+** precision is taken from the first row.
+*/
+PG_FUNCTION_INFO_V1(pgis_twkb_accum_transfn);
+Datum
+pgis_twkb_accum_transfn(PG_FUNCTION_ARGS)
+{
+	Oid geom_typeid = get_fn_expr_argtype(fcinfo->flinfo, 1);
+	Oid id_typeid = get_fn_expr_argtype(fcinfo->flinfo, 2);
+	MemoryContext aggcontext;
+	pgis_twkb_state *state;
+	pgis_abs *p;
+
+	if (geom_typeid == InvalidOid || id_typeid == InvalidOid)
+		ereport(ERROR,
+		        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+		         errmsg("could not determine input data type")));
+
+	if (fcinfo->context && IsA(fcinfo->context, AggState))
+		aggcontext = ((AggState *) fcinfo->context)->aggcontext;
+#if POSTGIS_PGSQL_VERSION == 84
+
+	else if (fcinfo->context && IsA(fcinfo->context, WindowAggState))
+		aggcontext = ((WindowAggState *) fcinfo->context)->wincontext;
+#endif
+#if POSTGIS_PGSQL_VERSION > 84
+
+	else if (fcinfo->context && IsA(fcinfo->context, WindowAggState))
+		aggcontext = ((WindowAggState *) fcinfo->context)->aggcontext;
+#endif
+
+	else
+	{
+		/* cannot be called directly because of dummy-type argument */
+		elog(ERROR, "pgis_twkb_accum_transfn called in non-aggregate context");
+		aggcontext = NULL;  /* keep compiler quiet */
+	}
+
+	if ( PG_ARGISNULL(0) )
+	{
+		p = (pgis_abs*) palloc(sizeof(pgis_abs));
+		state = (pgis_twkb_state*) MemoryContextAllocZero(aggcontext, sizeof(pgis_twkb_state));
+		if ( PG_NARGS() > 3 && ! PG_ARGISNULL(3) )
+			state->precision = PG_GETARG_INT32(3);
+		p->a = (ArrayBuildState*) state;
+	}
+	else
+	{
+		p = (pgis_abs*) PG_GETARG_POINTER(0);
+		state = (pgis_twkb_state*) p->a;
+	}
+
+	/* Rows without a geometry are left out altogether */
+	if ( PG_ARGISNULL(1) )
+		PG_RETURN_POINTER(p);
+
+	if ( PG_ARGISNULL(2) )
+		elog(ERROR, "ST_AsTWKBAgg: id must not be NULL");
+
+	state->geoms = accumArrayResult(state->geoms, PG_GETARG_DATUM(1), false,
+	                                geom_typeid, aggcontext);
+	state->ids = accumArrayResult(state->ids, PG_GETARG_DATUM(2), false,
+	                              id_typeid, aggcontext);
+
+	PG_RETURN_POINTER(p);
+}
+
+/**
+* The "twkb" final function passes the geometry[] and id[] to the
+* TWKB array writer.
+*/
+PG_FUNCTION_INFO_V1(pgis_twkb_accum_finalfn);
+Datum
+pgis_twkb_accum_finalfn(PG_FUNCTION_ARGS)
+{
+	pgis_abs *p;
+	pgis_twkb_state *state;
+	pgis_abs geoms, ids;
+	Datum geometry_array, id_array;
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();   /* returns null iff no input values */
+
+	p = (pgis_abs*) PG_GETARG_POINTER(0);
+	state = (pgis_twkb_state*) p->a;
+
+	if ( ! state->geoms )
+		PG_RETURN_NULL();
+
+	geoms.a = state->geoms;
+	ids.a = state->ids;
+	geometry_array = pgis_accum_finalfn(&geoms, CurrentMemoryContext, fcinfo);
+	id_array = pgis_accum_finalfn(&ids, CurrentMemoryContext, fcinfo);
+
+	PG_RETURN_DATUM(DirectFunctionCall3(TWKBFromLWGEOMArray, geometry_array, id_array,
+	                                    Int32GetDatum(state->precision)));
+}
+
+/**
+** Adds a row to the vector tile layer for ST_AsMVT. The arguments are
+** layer name, tile bounds, optionally extent and buffer (both in tile
+** units), and the row itself last. The settings come from the first row.
+*/
+PG_FUNCTION_INFO_V1(pgis_asmvt_transfn);
+Datum
+pgis_asmvt_transfn(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext, oldcontext;
+	mvt_agg_context *ctx;
+	pgis_abs *p;
+	int rowarg = PG_NARGS() - 1;
+
+	if (fcinfo->context && IsA(fcinfo->context, AggState))
+		aggcontext = ((AggState *) fcinfo->context)->aggcontext;
+#if POSTGIS_PGSQL_VERSION == 84
+
+	else if (fcinfo->context && IsA(fcinfo->context, WindowAggState))
+		aggcontext = ((WindowAggState *) fcinfo->context)->wincontext;
+#endif
+#if POSTGIS_PGSQL_VERSION > 84
+
+	else if (fcinfo->context && IsA(fcinfo->context, WindowAggState))
+		aggcontext = ((WindowAggState *) fcinfo->context)->aggcontext;
+#endif
+
+	else
+	{
+		/* cannot be called directly because of dummy-type argument */
+		elog(ERROR, "pgis_asmvt_transfn called in non-aggregate context");
+		aggcontext = NULL;  /* keep compiler quiet */
+	}
+
+	if ( ! type_is_rowtype(get_fn_expr_argtype(fcinfo->flinfo, rowarg)) )
+		ereport(ERROR, (errcode(ERRCODE_DATATYPE_MISMATCH),
+		                errmsg("ST_AsMVT: the last argument must be a row")));
+
+	if ( PG_ARGISNULL(0) )
+	{
+		int32 extent = 4096;
+		int32 buffer = 256;
+		char *name;
+
+		if ( PG_ARGISNULL(1) || PG_ARGISNULL(2) )
+			elog(ERROR, "ST_AsMVT: layer name and bounds must not be NULL");
+		if ( PG_NARGS() > 4 && ! PG_ARGISNULL(3) )
+			extent = PG_GETARG_INT32(3);
+		if ( PG_NARGS() > 5 && ! PG_ARGISNULL(4) )
+			buffer = PG_GETARG_INT32(4);
+		if ( extent <= 0 || buffer < 0 )
+			elog(ERROR, "ST_AsMVT: extent must be positive and buffer must not be negative");
+
+		name = text2cstring(PG_GETARG_TEXT_P(1));
+		oldcontext = MemoryContextSwitchTo(aggcontext);
+		ctx = mvt_agg_init(name, (GBOX*)PG_GETARG_POINTER(2), extent, buffer);
+		MemoryContextSwitchTo(oldcontext);
+
+		p = (pgis_abs*) palloc(sizeof(pgis_abs));
+		p->a = (ArrayBuildState*) ctx;
+	}
+	else
+	{
+		p = (pgis_abs*) PG_GETARG_POINTER(0);
+		ctx = (mvt_agg_context*) p->a;
+	}
+
+	if ( ! PG_ARGISNULL(rowarg) )
+		mvt_agg_transfn(ctx, PG_GETARG_HEAPTUPLEHEADER(rowarg), aggcontext);
+
+	PG_RETURN_POINTER(p);
+}
+
+/**
+* The "asmvt" final function writes out the encoded tile.
+*/
+PG_FUNCTION_INFO_V1(pgis_asmvt_finalfn);
+Datum
+pgis_asmvt_finalfn(PG_FUNCTION_ARGS)
+{
+	pgis_abs *p;
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();   /* returns null iff no input values */
+
+	p = (pgis_abs*) PG_GETARG_POINTER(0);
+
+	PG_RETURN_BYTEA_P(mvt_agg_finalfn((mvt_agg_context*) p->a));
+}
+
 /**
 * A modified version of PostgreSQL's DirectFunctionCall1 which allows NULL results; this
 * is required for aggregates that return NULL.
@@ -16,6 +16,8 @@
 
 #include "postgres.h"
 #include "executor/spi.h"
+#include "storage/proc.h"
+#include "utils/memutils.h"
 
 #include "../postgis_config.h"
 #include "lwgeom_pg.h"
@@ -28,6 +30,99 @@ Datum LWGEOM_asGeoJson(PG_FUNCTION_ARGS);
 Datum LWGEOM_asSVG(PG_FUNCTION_ARGS);
 Datum LWGEOM_asX3D(PG_FUNCTION_ARGS);
 
+/*
+ * Single-entry cache of the last geometry handed to an export function.
+ *
+ * Queries often emit the same column in several formats (GeoJSON, SVG,
+ * KML...) and each function would otherwise detoast and deserialize it
+ * on its own. fn_extra is private to a single call site, so it can't
+ * be shared between those functions: the cache lives at backend level
+ * instead, in a memory context owned by the current transaction, and
+ * is keyed on the raw argument bytes (a toast pointer for out-of-line
+ * values, so a hit skips fetching and decompressing too).
+ */
+typedef struct
+{
+	LocalTransactionId lxid;  /* transaction owning the context */
+	MemoryContext context;    /* child of TopTransactionContext */
+	struct varlena *key;      /* raw, possibly toasted, argument */
+	LWGEOM *lwgeom;           /* deserialized from the detoasted copy */
+} ExportCache;
+
+static ExportCache export_cache = { InvalidLocalTransactionId, NULL, NULL, NULL };
+
+/*
+ * Return the deserialized geometry for argument argnum, reusing
+ * the one from the previous export call when the datum is the same.
+ * The result belongs to the cache and must not be freed; it stays
+ * valid until the next call.
+ */
+static LWGEOM *
+export_cache_get_lwgeom(FunctionCallInfo fcinfo, int argnum)
+{
+	struct varlena *raw = (struct varlena *) PG_GETARG_POINTER(argnum);
+	size_t size = VARSIZE_ANY(raw);
+	MemoryContext old_context;
+	GSERIALIZED *geom;
+	struct varlena *key;
+	LWGEOM *lwgeom;
+
+	if ( export_cache.lxid == MyProc->lxid && export_cache.key &&
+	     VARSIZE_ANY(export_cache.key) == size &&
+	     memcmp(export_cache.key, raw, size) == 0 )
+	{
+		POSTGIS_DEBUG(3, "export_cache_get_lwgeom: cache hit");
+		return export_cache.lwgeom;
+	}
+
+	if ( export_cache.lxid != MyProc->lxid )
+	{
+		/* The old context went away with its transaction */
+		export_cache.context = AllocSetContextCreate(TopTransactionContext,
+		                       "PostGIS export cache",
+		                       ALLOCSET_DEFAULT_MINSIZE,
+		                       ALLOCSET_DEFAULT_INITSIZE,
+		                       ALLOCSET_DEFAULT_MAXSIZE);
+		export_cache.lxid = MyProc->lxid;
+	}
+	else
+	{
+		MemoryContextReset(export_cache.context);
+	}
+
+	/* Stay invalid if anything below errors out */
+	export_cache.key = NULL;
+	export_cache.lwgeom = NULL;
+
+	old_context = MemoryContextSwitchTo(export_cache.context);
+
+	geom = (GSERIALIZED *) PG_DETOAST_DATUM_COPY(PG_GETARG_DATUM(argnum));
+	if ( VARATT_IS_EXTENDED(raw) )
+	{
+		key = palloc(size);
+		memcpy(key, raw, size);
+	}
+	else
+	{
+		/* Plain inline value, the copy is the key */
+		key = (struct varlena *) geom;
+	}
+
+	lwgeom = lwgeom_from_gserialized(geom);
+	/*
+	 * Compute the bbox now, so lwgeom_get_bbox() in an exporter
+	 * doesn't hang a short-lived allocation off a cached geometry
+	 */
+	lwgeom_add_bbox(lwgeom);
+
+	MemoryContextSwitchTo(old_context);
+
+	export_cache.key = key;
+	export_cache.lwgeom = lwgeom;
+
+	return lwgeom;
+}
+
 /*
  * Retrieve an SRS from a given SRID
  * Require valid spatial_ref_sys table entry
@@ -162,7 +257,6 @@ int getSRIDbySRS(const char* srs)
 PG_FUNCTION_INFO_V1(LWGEOM_asGML);
 Datum LWGEOM_asGML(PG_FUNCTION_ARGS)
 {
-	GSERIALIZED *geom;
 	LWGEOM *lwgeom;
 	char *gml = NULL;
 	text *result;
@@ -187,7 +281,7 @@ Datum LWGEOM_asGML(PG_FUNCTION_ARGS)
 
 	/* Get the geometry */
 	if ( PG_ARGISNULL(1) ) PG_RETURN_NULL();
-	geom = (GSERIALIZED *)PG_DETOAST_DATUM(PG_GETARG_DATUM(1));
+	lwgeom = export_cache_get_lwgeom(fcinfo, 1);
 
 	/* Retrieve precision if any (default is max) */
 	if (PG_NARGS() >2 && !PG_ARGISNULL(2))
@@ -223,7 +317,7 @@ Datum LWGEOM_asGML(PG_FUNCTION_ARGS)
 		}
 	}
 
-	srid = gserialized_get_srid(geom);
+	srid = lwgeom->srid;
 	if (srid == SRID_UNKNOWN)      srs = NULL;
 	else if (option & 1) srs = getSRSbySRID(srid, false);
 	else                 srs = getSRSbySRID(srid, true);
@@ -233,8 +327,6 @@ Datum LWGEOM_asGML(PG_FUNCTION_ARGS)
 	if (option & 16) lwopts |= LW_GML_IS_DEGREE;
         if (option & 32) lwopts |= LW_GML_EXTENT;
 
-	lwgeom = lwgeom_from_gserialized(geom);
-
 	if (version == 2 && lwopts & LW_GML_EXTENT)
 		gml = lwgeom_extent_to_gml2(lwgeom, srs, precision, prefix);
 	else if (version == 2)
@@ -244,9 +336,6 @@ Datum LWGEOM_asGML(PG_FUNCTION_ARGS)
 	else if (version == 3) 
 		gml = lwgeom_to_gml3(lwgeom, srs, precision, lwopts, prefix);
 
-	lwgeom_free(lwgeom);
-	PG_FREE_IF_COPY(geom, 1);
-
 	/* Return null on null */
 	if ( ! gml )
 		PG_RETURN_NULL();
@@ -263,7 +352,6 @@ Datum LWGEOM_asGML(PG_FUNCTION_ARGS)
 PG_FUNCTION_INFO_V1(LWGEOM_asKML);
 Datum LWGEOM_asKML(PG_FUNCTION_ARGS)
 {
-	GSERIALIZED *geom;
 	LWGEOM *lwgeom;
 	char *kml;
 	text *result;
@@ -285,7 +373,7 @@ Datum LWGEOM_asKML(PG_FUNCTION_ARGS)
 
 	/* Get the geometry */
 	if ( PG_ARGISNULL(1) ) PG_RETURN_NULL();
-	geom = (GSERIALIZED *)PG_DETOAST_DATUM(PG_GETARG_DATUM(1));
+	lwgeom = export_cache_get_lwgeom(fcinfo, 1);
 
 	/* Retrieve precision if any (default is max) */
 	if (PG_NARGS() >2 && !PG_ARGISNULL(2))
@@ -317,10 +405,7 @@ Datum LWGEOM_asKML(PG_FUNCTION_ARGS)
 		}
 	}
 
-	lwgeom = lwgeom_from_gserialized(geom);
 	kml = lwgeom_to_kml2(lwgeom, precision, prefix);
-	lwgeom_free(lwgeom);
-	PG_FREE_IF_COPY(geom, 1);
 	
 	if( ! kml ) 
 		PG_RETURN_NULL();	
@@ -338,7 +423,6 @@ Datum LWGEOM_asKML(PG_FUNCTION_ARGS)
 PG_FUNCTION_INFO_V1(LWGEOM_asGeoJson);
 Datum LWGEOM_asGeoJson(PG_FUNCTION_ARGS)
 {
-	GSERIALIZED *geom;
 	LWGEOM *lwgeom;
 	char *geojson;
 	text *result;
@@ -359,7 +443,7 @@ Datum LWGEOM_asGeoJson(PG_FUNCTION_ARGS)
 
 	/* Get the geometry */
 	if (PG_ARGISNULL(1) ) PG_RETURN_NULL();
-	geom = (GSERIALIZED *)PG_DETOAST_DATUM(PG_GETARG_DATUM(1));
+	lwgeom = export_cache_get_lwgeom(fcinfo, 1);
 
 	/* Retrieve precision if any (default is max) */
 	if (PG_NARGS() >2 && !PG_ARGISNULL(2))
@@ -381,7 +465,7 @@ Datum LWGEOM_asGeoJson(PG_FUNCTION_ARGS)
 
 	if (option & 2 || option & 4)
 	{
-		srid = gserialized_get_srid(geom);
+		srid = lwgeom->srid;
 		if ( srid != SRID_UNKNOWN )
 		{
 			if (option & 2) srs = getSRSbySRID(srid, true);
@@ -398,11 +482,8 @@ Datum LWGEOM_asGeoJson(PG_FUNCTION_ARGS)
 
 	if (option & 1) has_bbox = 1;
 
-	lwgeom = lwgeom_from_gserialized(geom);
 	geojson = lwgeom_to_geojson(lwgeom, srs, precision, has_bbox);
-	lwgeom_free(lwgeom);
 
-	PG_FREE_IF_COPY(geom, 1);
 	if (srs) pfree(srs);
 
 	result = cstring2text(geojson);
@@ -419,7 +500,6 @@ Datum LWGEOM_asGeoJson(PG_FUNCTION_ARGS)
 PG_FUNCTION_INFO_V1(LWGEOM_asSVG);
 Datum LWGEOM_asSVG(PG_FUNCTION_ARGS)
 {
-	GSERIALIZED *geom;
 	LWGEOM *lwgeom;
 	char *svg;
 	text *result;
@@ -428,7 +508,7 @@ Datum LWGEOM_asSVG(PG_FUNCTION_ARGS)
 
 	if ( PG_ARGISNULL(0) ) PG_RETURN_NULL();
 
-	geom = (GSERIALIZED *)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
+	lwgeom = export_cache_get_lwgeom(fcinfo, 0);
 
 	/* check for relative path notation */
 	if ( PG_NARGS() > 1 && ! PG_ARGISNULL(1) )
@@ -442,12 +522,9 @@ Datum LWGEOM_asSVG(PG_FUNCTION_ARGS)
 		else if ( precision < 0 ) precision = 0;
 	}
 
-	lwgeom = lwgeom_from_gserialized(geom);
 	svg = lwgeom_to_svg(lwgeom, precision, relative);
 	result = cstring2text(svg);
-	lwgeom_free(lwgeom);
 	pfree(svg);
-	PG_FREE_IF_COPY(geom, 0);
 
 	PG_RETURN_TEXT_P(result);
 }
@@ -458,7 +535,6 @@ Datum LWGEOM_asSVG(PG_FUNCTION_ARGS)
 PG_FUNCTION_INFO_V1(LWGEOM_asX3D);
 Datum LWGEOM_asX3D(PG_FUNCTION_ARGS)
 {
-	GSERIALIZED *geom;
 	LWGEOM *lwgeom;
 	char *x3d;
 	text *result;
@@ -484,7 +560,7 @@ Datum LWGEOM_asX3D(PG_FUNCTION_ARGS)
 
 	/* Get the geometry */
 	if ( PG_ARGISNULL(1) ) PG_RETURN_NULL();
-	geom = (GSERIALIZED *)PG_DETOAST_DATUM(PG_GETARG_DATUM(1));
+	lwgeom = export_cache_get_lwgeom(fcinfo, 1);
 
 	/* Retrieve precision if any (default is max) */
 	if (PG_NARGS() >2 && !PG_ARGISNULL(2))
@@ -520,7 +596,7 @@ Datum LWGEOM_asX3D(PG_FUNCTION_ARGS)
 		}
 	}
 
-	srid = gserialized_get_srid(geom);
+	srid = lwgeom->srid;
 	if (srid == SRID_UNKNOWN)      srs = NULL;
 	else if (option & 1) srs = getSRSbySRID(srid, false);
 	else                 srs = getSRSbySRID(srid, true);
@@ -528,14 +604,8 @@ Datum LWGEOM_asX3D(PG_FUNCTION_ARGS)
 	if (option & 2)  is_dims = 0;
 	if (option & 16) is_deegree = 1;
 
-	lwgeom = lwgeom_from_gserialized(geom);
-
-
 	x3d = lwgeom_to_x3d3(lwgeom, srs, precision,option, defid);
 
-	lwgeom_free(lwgeom);
-	PG_FREE_IF_COPY(geom, 1);
-
 	result = cstring2text(x3d);
 	lwfree(x3d);
 
@@ -211,11 +211,9 @@ PG_FUNCTION_INFO_V1(LWGEOM_npoints);
 Datum LWGEOM_npoints(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = (GSERIALIZED *)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
 	int npoints = 0;
 
-	npoints = lwgeom_count_vertices(lwgeom);
-	lwgeom_free(lwgeom);
+	npoints = gserialized_count_vertices(geom);
 
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_INT32(npoints);
@@ -226,11 +224,9 @@ PG_FUNCTION_INFO_V1(LWGEOM_nrings);
 Datum LWGEOM_nrings(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = (GSERIALIZED *)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
 	int nrings = 0;
 
-	nrings = lwgeom_count_rings(lwgeom);
-	lwgeom_free(lwgeom);
+	nrings = gserialized_count_rings(geom);
 
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_INT32(nrings);
@@ -1785,10 +1781,8 @@ PG_FUNCTION_INFO_V1(LWGEOM_isempty);
 Datum LWGEOM_isempty(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = (GSERIALIZED *) PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
-	bool empty = lwgeom_is_empty(lwgeom);
+	bool empty = gserialized_is_empty(geom);
 
-	lwgeom_free(lwgeom);
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_BOOL(empty);
 }
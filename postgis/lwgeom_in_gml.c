@@ -29,28 +29,95 @@
 *
 * NOTA: this code doesn't (yet ?) support SQL/MM curves
 *
+* The document is read with the libxml2 SAX2 interface rather than
+* built as a tree. Only a skeleton of the elements is kept, and the
+* text of gml:pos, gml:posList, gml:coordinates and gml:X/Y/Z is
+* converted to doubles as it streams in, straight into the point
+* arrays later handed over to the geometry. So memory use follows
+* the size of the geometry, not of the GML text.
+*
 * Written by Olivier Courtin - Oslandia
 *
 **********************************************************************/
 
 
-#include <libxml/tree.h>
 #include <libxml/parser.h>
-#include <libxml/xpath.h>
-#include <libxml/xpathInternals.h>
 
 #include "postgres.h"
 #include "executor/spi.h"
 
 #include "../postgis_config.h"
 #include "lwgeom_pg.h"
-#include "liblwgeom.h"
+#include "liblwgeom_internal.h"
 #include "lwgeom_transform.h"
 
 
-Datum geom_from_gml(PG_FUNCTION_ARGS);
-static LWGEOM* lwgeom_from_gml(const char *wkt);
-static LWGEOM* parse_gml(xmlNodePtr xnode, bool *hasz, int *root_srid);
+/**
+ * Coordinates held by a gml:pos, gml:posList, gml:coordinates
+ * or gml:X/Y/Z element, converted while the text was read
+ */
+typedef struct struct_gmlData
+{
+	POINTARRAY *pa;		/* Points read, 2D or 3D upon the data */
+	double ordinate;	/* Value of a gml:X, gml:Y or gml:Z */
+	int error;		/* First error met, raised when the data is used */
+	bool shared;		/* Reachable through an XLink, copy it on use */
+}
+gmlData;
+
+/**
+ * Element of the document skeleton built by the SAX reader
+ */
+typedef struct struct_gmlNode
+{
+	char *name;		/* Local name */
+	bool is_gml;		/* False if bound to a non GML namespace */
+	bool has_children;	/* Any child node, text and comments too */
+	char *id;
+	char *srsname;
+	char *dimension;	/* srsDimension, or dimension in GML 3.0.0 */
+	char *interpolation;
+	char *href;		/* Simple XLink reference, without the '#' */
+	gmlData *data;		/* Coordinates element only */
+	struct struct_gmlNode *parent;
+	struct struct_gmlNode *children;
+	struct struct_gmlNode *last;
+	struct struct_gmlNode *next;
+}
+gmlNode;
+
+/* Kinds of coordinates elements */
+#define GML_POS		1
+#define GML_POSLIST	2
+#define GML_COORDINATES	3
+#define GML_ORDINATE	4
+
+/* Longest number text accepted in coordinates */
+#define GML_NUMBER_MAXLEN 64
+
+/**
+ * SAX reader state
+ */
+typedef struct struct_gmlParser
+{
+	gmlNode *root;
+	gmlNode *current;	/* Innermost open element */
+	int xml_size;
+
+	/* Coordinates element whose text is being read */
+	gmlNode *data_node;
+	int kind;
+	int dim;		/* gml:pos and gml:posList ordinates per point */
+	char cs, ts, dec;	/* gml:coordinates separators */
+	char num[GML_NUMBER_MAXLEN + 1];
+	int numlen;
+	bool numend;		/* Number ended by a whitespace */
+	bool after_cs;		/* Coordinate separator met, value expected */
+	bool gap;		/* Whitespace out of place, no more data allowed */
+	double ords[3];
+	int nords;
+}
+gmlParser;
 
 typedef struct struct_gmlSrs
 {
@@ -59,13 +126,17 @@ typedef struct struct_gmlSrs
 }
 gmlSrs;
 
+Datum geom_from_gml(PG_FUNCTION_ARGS);
+static LWGEOM* lwgeom_from_gml(const char *wkt);
+static LWGEOM* parse_gml(gmlNode *xnode, bool *hasz, int *root_srid);
+
 #define XLINK_NS	((char *) "http://www.w3.org/1999/xlink")
 #define GML_NS		((char *) "http://www.opengis.net/gml")
 #define GML32_NS	((char *) "http://www.opengis.net/gml/3.2")
 
 
 
-static void gml_lwerror(char *msg, int error_code) 
+static void gml_lwerror(char *msg, int error_code)
 {
         POSTGIS_DEBUGF(3, "ST_GeomFromGML ERROR %i", error_code);
         lwerror("%s", msg);
@@ -110,170 +181,639 @@ Datum geom_from_gml(PG_FUNCTION_ARGS)
 
 
 /**
- * Return false if current element namespace is not a GML one
- * Return true otherwise.
+ * Return true if the namespace URI is a GML one
+ *  - http://www.opengis.net/gml      (GML 3.1.1 and priors)
+ *  - http://www.opengis.net/gml/3.2  (GML 3.2.1)
  */
-static bool is_gml_namespace(xmlNodePtr xnode, bool is_strict)
+static bool is_gml_uri(const xmlChar *uri)
 {
-	xmlNsPtr *ns, *p;
+	return !strcmp((char *) uri, GML_NS) || !strcmp((char *) uri, GML32_NS);
+}
 
-	ns = xmlGetNsList(xnode->doc, xnode);
-	/*
-	 * If no namespace is available we could return true anyway
-	 * (because we work only on GML fragment, we don't want to
-	 *  'oblige' to add namespace on the geometry root node)
-	 */
-	if (ns == NULL) { return !is_strict; }
 
-	/*
-	 * Handle namespaces:
-	 *  - http://www.opengis.net/gml      (GML 3.1.1 and priors)
-	 *  - http://www.opengis.net/gml/3.2  (GML 3.2.1)
-	 */
-	for (p=ns ; *p ; p++)
+/**
+ * Copy a string from the parser, up to end if not NULL
+ */
+static char* gml_strdup(const xmlChar *str, const xmlChar *end)
+{
+	size_t len = end ? end - str : strlen((char *) str);
+	char *s = lwalloc(len + 1);
+
+	memcpy(s, str, len);
+	s[len] = '\0';
+	return s;
+}
+
+
+/**
+ * Read a gml:coordinates separator attribute
+ * Return false if it is not a single non digit character
+ */
+static bool gml_separator(const xmlChar *value, const xmlChar *end, char *sep)
+{
+	if (end - value > 1 || isdigit(*value)) return false;
+	*sep = (value == end) ? '\0' : *value;
+	return true;
+}
+
+
+/**
+ * Drop the Z of a POINTARRAY, in place
+ */
+static void gml_ptarray_force_2d(POINTARRAY *pa)
+{
+	POINT2D p;
+	int i;
+
+	if (!FLAGS_GET_Z(pa->flags)) return;
+
+	/* Points only move backward, so none is overwritten before read */
+	for (i=0 ; i < pa->npoints ; i++)
 	{
-                if ((*p)->href == NULL || (*p)->prefix == NULL ||
-                     xnode->ns == NULL || xnode->ns->prefix == NULL) continue;
+		getPoint2d_p(pa, i, &p);
+		memcpy(pa->serialized_pointlist + i * sizeof(POINT2D), &p, sizeof(POINT2D));
+	}
+	pa->maxpoints = pa->maxpoints * sizeof(POINT3DZ) / sizeof(POINT2D);
+	FLAGS_SET_Z(pa->flags, 0);
+}
+
+
+/**
+ * Drop the Z of a whole geometry, in place
+ */
+static void gml_lwgeom_force_2d(LWGEOM *geom)
+{
+	LWCOLLECTION *coll;
+	LWPOLY *poly;
+	int i;
+
+	switch (geom->type)
+	{
+	case POINTTYPE:
+		gml_ptarray_force_2d(((LWPOINT *) geom)->point);
+		break;
+	case LINETYPE:
+		gml_ptarray_force_2d(((LWLINE *) geom)->points);
+		break;
+	case TRIANGLETYPE:
+		gml_ptarray_force_2d(((LWTRIANGLE *) geom)->points);
+		break;
+	case POLYGONTYPE:
+		poly = (LWPOLY *) geom;
+		for (i=0 ; i < poly->nrings ; i++)
+			gml_ptarray_force_2d(poly->rings[i]);
+		break;
+	default:
+		coll = (LWCOLLECTION *) geom;
+		for (i=0 ; i < coll->ngeoms ; i++)
+			gml_lwgeom_force_2d(coll->geoms[i]);
+	}
+	FLAGS_SET_Z(geom->flags, 0);
+}
+
+
+/**
+ * Convert a number matching
+ * [-|\+]?[0-9]+(\.)?([0-9]+)?([Ee](\+|-)?[0-9]+)?
+ * Return false if the text is something else
+ */
+static bool gml_number(const char *num, double *d)
+{
+	const char *p = num;
+
+	if (*p == '-' || *p == '+') p++;
+	if (!isdigit(*p)) return false;
+	while (isdigit(*p)) p++;
+	if (*p == '.')
+	{
+		p++;
+		if (*p && !isdigit(*p)) return false;
+		while (isdigit(*p)) p++;
+	}
+	if (*p == 'e' || *p == 'E')
+	{
+		p++;
+		if (*p == '-' || *p == '+') p++;
+		if (!isdigit(*p)) return false;
+		while (isdigit(*p)) p++;
+	}
+	if (*p) return false;
+
+	return lwread_double(*num == '+' ? num + 1 : num, d) != NULL;
+}
+
+
+static void gml_data_error(gmlParser *p, int error_code)
+{
+	if (!p->data_node->data->error) p->data_node->data->error = error_code;
+}
+
+
+/**
+ * Append the point read to the coordinates
+ */
+static void gml_data_point(gmlParser *p)
+{
+	gmlData *data = p->data_node->data;
+	POINT4D pt;
+
+	/* gml:coordinates tuples decide the dimension. Once a 2D one is
+	   met the whole geometry ends up 2D, so Z is no longer kept */
+	if (data->pa == NULL)
+		data->pa = ptarray_construct_empty(p->nords == 3, 0, 8);
+	else if (p->nords == 2)
+		gml_ptarray_force_2d(data->pa);
+
+	pt.x = p->ords[0];
+	pt.y = p->ords[1];
+	pt.z = (p->nords == 3) ? p->ords[2] : 0.0;
+	pt.m = 0.0;
+	ptarray_append_point(data->pa, &pt, LW_FALSE);
+	p->nords = 0;
+}
+
+
+/**
+ * Convert the number text read so far
+ */
+static void gml_data_value(gmlParser *p)
+{
+	double d;
+
+	p->num[p->numlen] = '\0';
+	p->numlen = 0;
+	p->numend = false;
+	p->after_cs = false;
+
+	if (!gml_number(p->num, &d))
+	{
+		gml_data_error(p, 7);
+		return;
+	}
+	if (p->nords < 3) p->ords[p->nords] = d;
+	p->nords++;
+
+	if (p->kind == GML_POSLIST && p->nords == p->dim)
+		gml_data_point(p);
+}
+
+
+/**
+ * End of a gml:coordinates tuple
+ */
+static void gml_data_tuple(gmlParser *p)
+{
+	if (p->after_cs) gml_data_error(p, 19);
+	else if (p->nords < 2 || p->nords > 3) gml_data_error(p, 20);
+	else gml_data_point(p);
+}
+
 
-		if (!xmlStrcmp(xnode->ns->prefix, (*p)->prefix))
-                {
-			if (    !strcmp((char *) (*p)->href, GML_NS)
-                             || !strcmp((char *) (*p)->href, GML32_NS))
+/**
+ * Read one character of coordinates text
+ *
+ * gml:pos, gml:posList and gml:X/Y/Z hold whitespace separated
+ * numbers. gml:coordinates holds tuples, with cs between values
+ * and ts between tuples, and dec as decimal separator. When ts
+ * is a whitespace any whitespace ends a tuple, otherwise they are
+ * allowed after values. Leading and trailing ones are skipped.
+ */
+static void gml_data_char(gmlParser *p, char c)
+{
+	bool space = isspace((unsigned char) c);
+
+	if (p->kind == GML_COORDINATES)
+	{
+		if (space && !p->numlen)
+		{
+			/* Only leading and trailing ones */
+			if (p->after_cs) gml_data_error(p, 19);
+			else if (p->data_node->data->pa) p->gap = true;
+			return;
+		}
+		if (p->gap)
+		{
+			gml_data_error(p, 20);
+			return;
+		}
+		if (c == p->cs)
+		{
+			if (!p->numlen) gml_data_error(p, 19);
+			else
 			{
-				xmlFree(ns);
-                                return true;
-			} else {
-                                xmlFree(ns);
-                                return false; 
-                        }
+				gml_data_value(p);
+				p->after_cs = true;
+			}
+			return;
+		}
+		if (c == p->ts || (space && isspace((unsigned char) p->ts)))
+		{
+			if (!p->numlen) gml_data_error(p, 19);
+			else
+			{
+				gml_data_value(p);
+				gml_data_tuple(p);
+			}
+			return;
+		}
+		if (space)
+		{
+			p->numend = true;
+			return;
+		}
+		if (p->numend)
+		{
+			gml_data_error(p, 11);
+			return;
+		}
+		if (c == p->dec) c = '.';
+	}
+	else if (space)
+	{
+		if (p->numlen) gml_data_value(p);
+		return;
+	}
+
+	if (p->numlen == GML_NUMBER_MAXLEN)
+	{
+		gml_data_error(p, 13);
+		return;
+	}
+	p->num[p->numlen++] = c;
+}
+
+
+/**
+ * Begin to read a coordinates element
+ */
+static void gml_data_start(gmlParser *p, gmlNode *node, int kind,
+                           char cs, char ts, char dec, int count, int error_code)
+{
+	gmlData *data;
+	int maxpoints = 1;
+
+	data = lwalloc(sizeof(gmlData));
+	memset(data, 0, sizeof(gmlData));
+	data->error = error_code;
+	node->data = data;
+
+	p->data_node = node;
+	p->kind = kind;
+	p->cs = cs;
+	p->ts = ts;
+	p->dec = dec;
+	p->numlen = p->nords = 0;
+	p->numend = p->after_cs = p->gap = false;
+
+	if (kind != GML_POS && kind != GML_POSLIST) return;
+
+	if (node->dimension == NULL) p->dim = 2;	/* We assume that we are in 2D */
+	else
+	{
+		p->dim = atoi(node->dimension);
+		if (p->dim < 2 || p->dim > 3)
+		{
+			gml_data_error(p, kind == GML_POS ? 25 : 27);
+			p->dim = 2;
+		}
+	}
+
+	/* gml:posList count gives the size to allocate, but don't trust
+	   it beyond what the text could hold */
+	if (kind == GML_POSLIST)
+	{
+		maxpoints = p->xml_size / (2 * p->dim) + 1;
+		if (count > 0 && count < maxpoints) maxpoints = count;
+		else if (maxpoints > 8) maxpoints = 8;
+	}
+	data->pa = ptarray_construct_empty(p->dim == 3, 0, maxpoints);
+}
+
+
+/**
+ * End of a coordinates element
+ */
+static void gml_data_end(gmlParser *p)
+{
+	gmlData *data = p->data_node->data;
+	POINTARRAY *pa;
+
+	if (!data->error && p->numlen) gml_data_value(p);
+	if (!data->error)
+	{
+		switch (p->kind)
+		{
+		case GML_POS:
+			/* gml:pos pattern: 	x1 y1
+			 * 			x1 y1 z1
+			 */
+			if (p->nords != p->dim) gml_data_error(p, 26);
+			else gml_data_point(p);
+			break;
+		case GML_POSLIST:
+			/* gml:posList pattern: 	x1 y1 x2 y2
+			 * 				x1 y1 z1 x2 y2 z2
+			 */
+			if (p->nords) gml_data_error(p, 28);
+			break;
+		case GML_COORDINATES:
+			/* Default GML coordinates pattern: 	x1,y1 x2,y2
+			 * 					x1,y1,z1 x2,y2,z2
+			 *
+			 * Cf GML 2.1.2 -> 4.3.1 (p18)
+			 */
+			if (p->nords || p->after_cs) gml_data_tuple(p);
+			break;
+		case GML_ORDINATE:
+			if (p->nords != 1) gml_data_error(p, 24);
+			else data->ordinate = p->ords[0];
+			break;
 		}
 	}
 
-	xmlFree(ns);
-	return !is_strict; /* Same reason here to not return false */
+	/* HasZ, !HasM, no point */
+	if (data->pa == NULL && p->kind != GML_ORDINATE)
+		data->pa = ptarray_construct_empty(1, 0, 1);
+
+	/* Give back the room left over */
+	pa = data->pa;
+	if (pa && pa->npoints && pa->npoints < pa->maxpoints)
+	{
+		pa->maxpoints = pa->npoints;
+		pa->serialized_pointlist = lwrealloc(pa->serialized_pointlist,
+		                                     ptarray_point_size(pa) * pa->maxpoints);
+	}
+
+	p->data_node = NULL;
 }
 
 
 /**
- * Retrieve a GML propertie from a node or NULL otherwise
- * Respect namespaces if presents in the node element
+ * SAX start of element: add it to the skeleton, with the attributes
+ * we care about, and begin to read coordinates if any.
  */
-static xmlChar *gmlGetProp(xmlNodePtr xnode, xmlChar *prop)
+static void gml_sax_start(void *ctx, const xmlChar *localname, const xmlChar *prefix,
+                          const xmlChar *URI, int nb_namespaces, const xmlChar **namespaces,
+                          int nb_attributes, int nb_defaulted, const xmlChar **attributes)
 {
-	xmlChar *value;
+	gmlParser *p = (gmlParser *) ctx;
+	gmlNode *node, *parent = p->current;
+	const xmlChar **attr;
+	const xmlChar *href = NULL, *hrefend = NULL;
+	char *srsdimension = NULL, *dimension = NULL;
+	char cs = ',', ts = ' ', dec = '.';
+	bool strict, simple = false;
+	int i, kind = 0, count = 0, error_code = 0;
+
+	node = lwalloc(sizeof(gmlNode));
+	memset(node, 0, sizeof(gmlNode));
+	node->name = gml_strdup(localname, NULL);
 
-	if (!is_gml_namespace(xnode, true))
-		return xmlGetProp(xnode, prop);
 	/*
-	 * Handle namespaces:
-	 *  - http://www.opengis.net/gml      (GML 3.1.1 and priors)
-	 *  - http://www.opengis.net/gml/3.2  (GML 3.2.1)
+	 * If no namespace is available we could take it as GML anyway
+	 * (because we work only on GML fragment, we don't want to
+	 *  'oblige' to add namespace on the geometry root node)
 	 */
-	value = xmlGetNsProp(xnode, prop, (xmlChar *) GML_NS);
-	if (value == NULL) value = xmlGetNsProp(xnode, prop, (xmlChar *) GML32_NS);
+	node->is_gml = !(prefix && URI && !is_gml_uri(URI));
+	strict = prefix && URI && is_gml_uri(URI);
+
+	/* Attributes come as localname/prefix/URI/value/end */
+	for (i=0, attr=attributes ; i < nb_attributes ; i++, attr += 5)
+	{
+		if (attr[2] && !strcmp((char *) attr[2], XLINK_NS))
+		{
+			if (!strcmp((char *) attr[0], "type"))
+				simple = (attr[4] - attr[3] == 6 && !strncmp((char *) attr[3], "simple", 6));
+			else if (!strcmp((char *) attr[0], "href"))
+			{
+				href = attr[3];
+				hrefend = attr[4];
+			}
+			continue;
+		}
+
+		/* Respect namespaces if presents in the node element */
+		if (strict && attr[2] && !is_gml_uri(attr[2])) continue;
+
+		if (!strcmp((char *) attr[0], "id"))
+			node->id = gml_strdup(attr[3], attr[4]);
+		else if (!strcmp((char *) attr[0], "srsName"))
+			node->srsname = gml_strdup(attr[3], attr[4]);
+		else if (!strcmp((char *) attr[0], "srsDimension"))
+			srsdimension = gml_strdup(attr[3], attr[4]);
+		else if (!strcmp((char *) attr[0], "dimension"))
+			dimension = gml_strdup(attr[3], attr[4]);
+		else if (!strcmp((char *) attr[0], "interpolation"))
+			node->interpolation = gml_strdup(attr[3], attr[4]);
+		else if (!strcmp((char *) attr[0], "count"))
+			count = atoi((char *) attr[3]);
+		else if (!strcmp((char *) attr[0], "cs"))
+		{
+			if (!gml_separator(attr[3], attr[4], &cs)) error_code = 16;
+		}
+		else if (!strcmp((char *) attr[0], "ts"))
+		{
+			if (!gml_separator(attr[3], attr[4], &ts)) error_code = 15;
+		}
+		else if (!strcmp((char *) attr[0], "decimal"))
+		{
+			if (!gml_separator(attr[3], attr[4], &dec)) error_code = 17;
+		}
+	}
+
+	/* in GML 3.0.0 it was dimension */
+	if (srsdimension)
+	{
+		node->dimension = srsdimension;
+		if (dimension) lwfree(dimension);
+	}
+	else node->dimension = dimension;
+
+	if (simple && href && hrefend > href && *href == '#')
+		node->href = gml_strdup(href + 1, hrefend);
+
+	node->parent = parent;
+	if (parent)
+	{
+		parent->has_children = true;
+		if (parent->last) parent->last->next = node;
+		else parent->children = node;
+		parent->last = node;
+	}
+	else p->root = node;
+	p->current = node;
+
+	/* Text of a coordinates element descendants belongs to it */
+	if (p->data_node || !node->is_gml) return;
+
+	if (!strcmp(node->name, "pos")) kind = GML_POS;
+	else if (!strcmp(node->name, "posList")) kind = GML_POSLIST;
+	else if (!strcmp(node->name, "coordinates")) kind = GML_COORDINATES;
+	else if (parent && parent->is_gml && !strcmp(parent->name, "coord")
+	         && (!strcmp(node->name, "X") || !strcmp(node->name, "Y")
+	             || !strcmp(node->name, "Z"))) kind = GML_ORDINATE;
+	else return;
 
-	/* In last case try without explicit namespace */
-	if (value == NULL) value = xmlGetNoNsProp(xnode, prop);
+	if (kind == GML_COORDINATES && (cs == ts || cs == dec || ts == dec))
+		error_code = 18;
 
-	return value;
+	gml_data_start(p, node, kind, cs, ts, dec, count, kind == GML_COORDINATES ? error_code : 0);
+}
+
+
+static void gml_sax_end(void *ctx, const xmlChar *localname,
+                        const xmlChar *prefix, const xmlChar *URI)
+{
+	gmlParser *p = (gmlParser *) ctx;
+
+	if (p->current == NULL) return;
+	if (p->current == p->data_node) gml_data_end(p);
+	p->current = p->current->parent;
+}
+
+
+static void gml_sax_characters(void *ctx, const xmlChar *ch, int len)
+{
+	gmlParser *p = (gmlParser *) ctx;
+	int i;
+
+	if (p->current == NULL) return;
+	p->current->has_children = true;
+
+	if (p->data_node == NULL) return;
+	for (i=0 ; i < len && !p->data_node->data->error ; i++)
+		gml_data_char(p, (char) ch[i]);
+}
+
+
+static void gml_sax_comment(void *ctx, const xmlChar *value)
+{
+	gmlParser *p = (gmlParser *) ctx;
+
+	if (p->current) p->current->has_children = true;
+}
+
+
+static void gml_sax_pi(void *ctx, const xmlChar *target, const xmlChar *data)
+{
+	gml_sax_comment(ctx, data);
+}
+
+
+static void gml_sax_error(void *ctx, xmlErrorPtr error)
+{
+	/* Reported as invalid GML once the parser returns */
 }
 
 
 /**
- * Return true if current node contains a simple XLink
- * Return false otherwise.
+ * Free the skeleton, and the coordinates no geometry took
  */
-static bool is_xlink(xmlNodePtr node)
+static void gml_free_node(gmlNode *node)
 {
-	xmlChar *prop;
+	gmlNode *child, *next;
 
-	prop = xmlGetNsProp(node, (xmlChar *)"type", (xmlChar *) XLINK_NS);
-	if (prop == NULL) return false;
-	if (strcmp((char *) prop, "simple"))
+	if (node == NULL) return;
+	for (child = node->children ; child != NULL ; child = next)
 	{
-		xmlFree(prop);
-		return false;
+		next = child->next;
+		gml_free_node(child);
 	}
 
-	prop = xmlGetNsProp(node, (xmlChar *)"href", (xmlChar *) XLINK_NS);
-	if (prop == NULL) return false;
-	if (prop[0] != '#')
+	if (node->data)
 	{
-		xmlFree(prop);
-		return false;
+		if (node->data->pa) ptarray_free(node->data->pa);
+		lwfree(node->data);
 	}
-	xmlFree(prop);
+	if (node->id) lwfree(node->id);
+	if (node->srsname) lwfree(node->srsname);
+	if (node->dimension) lwfree(node->dimension);
+	if (node->interpolation) lwfree(node->interpolation);
+	if (node->href) lwfree(node->href);
+	lwfree(node->name);
+	lwfree(node);
+}
 
-	return true;
+
+/**
+ * Count the nodes named name with the given gml:id,
+ * and return the first one met
+ */
+static int gml_find_id(gmlNode *node, const char *name, const char *id, gmlNode **found)
+{
+	int n = 0;
+
+	for ( ; node != NULL ; node = node->next)
+	{
+		if (node->id && !strcmp(node->id, id) && !strcmp(node->name, name))
+		{
+			if (!n && !*found) *found = node;
+			n++;
+		}
+		n += gml_find_id(node->children, name, id, found);
+	}
+	return n;
 }
 
 
 /**
- * Return a xmlNodePtr on a node referenced by a XLink or NULL otherwise
+ * Flag the coordinates under node as shared
  */
-static xmlNodePtr get_xlink_node(xmlNodePtr xnode)
+static void gml_share_data(gmlNode *node)
 {
-	char *id;
-	xmlNsPtr *ns, *n;
-	xmlXPathContext *ctx;
-	xmlXPathObject *xpath;
-	xmlNodePtr node, ret_node;
-	xmlChar *href, *p, *node_id;
-
-	href = xmlGetNsProp(xnode, (xmlChar *)"href", (xmlChar *) XLINK_NS);
-	id = lwalloc((xmlStrlen(xnode->ns->prefix) * 2 + xmlStrlen(xnode->name)
-	              + xmlStrlen(href) + sizeof("//:[@:id='']") + 1));
-	p = href;
-	p++; /* ignore '#' first char */
-
-	/* XPath pattern look like: //gml:point[@gml:id='p1'] */
-	sprintf(id, "//%s:%s[@%s:id='%s']", 	(char *) xnode->ns->prefix,
-	        (char *) xnode->name,
-	        (char *) xnode->ns->prefix,
-	        (char *) p);
-
-	ctx = xmlXPathNewContext(xnode->doc);
-	if (ctx == NULL)
+	for ( ; node != NULL ; node = node->next)
 	{
-		xmlFree(href);
-		lwfree(id);
-		return NULL;
+		if (node->data) node->data->shared = true;
+		gml_share_data(node->children);
 	}
+}
 
-	/* Handle namespaces */
-	ns = xmlGetNsList(xnode->doc, xnode);
-	for (n=ns ; *n; n++) xmlXPathRegisterNs(ctx, (*n)->prefix, (*n)->href);
-	xmlFree(ns);
 
-	/* Execute XPath expression */
-	xpath = xmlXPathEvalExpression((xmlChar *) id, ctx);
-	lwfree(id);
-	if (xpath == NULL || xpath->nodesetval == NULL || xpath->nodesetval->nodeNr != 1)
+/**
+ * Flag the coordinates of every XLink target as shared, as they
+ * could be read more than once
+ */
+static void gml_share_links(gmlNode *root, gmlNode *node)
+{
+	gmlNode *target;
+
+	for ( ; node != NULL ; node = node->next)
 	{
-		xmlFree(href);
-		xmlXPathFreeObject(xpath);
-		xmlXPathFreeContext(ctx);
-		return NULL;
+		if (node->href)
+		{
+			target = NULL;
+			if (gml_find_id(root, node->name, node->href, &target) == 1)
+			{
+				if (target->data) target->data->shared = true;
+				gml_share_data(target->children);
+			}
+		}
+		gml_share_links(root, node->children);
 	}
-	ret_node = xpath->nodesetval->nodeTab[0];
-	xmlXPathFreeObject(xpath);
-	xmlXPathFreeContext(ctx);
+}
+
+
+/**
+ * Return the node referenced by a XLink
+ */
+static gmlNode* get_xlink_node(gmlNode *xnode)
+{
+	gmlNode *root, *node, *target = NULL;
+
+	for (root = xnode ; root->parent != NULL ; root = root->parent);
+
+	/* Exactly one element of that name with that gml:id */
+	if (gml_find_id(root, xnode->name, xnode->href, &target) != 1)
+		gml_lwerror("invalid GML representation", 2);
 
 	/* Protection against circular calls */
 	for (node = xnode ; node != NULL ; node = node->parent)
 	{
-		if (node->type != XML_ELEMENT_NODE) continue;
-		node_id = gmlGetProp(node, (xmlChar *) "id");
-		if (node_id != NULL)
-		{
-			if (!xmlStrcmp(node_id, p))
-				gml_lwerror("invalid GML representation", 2);
-			xmlFree(node_id);
-		}
+		if (node->id != NULL && !strcmp(node->id, xnode->href))
+			gml_lwerror("invalid GML representation", 2);
 	}
 
-	xmlFree(href);
-	return ret_node;
+	return target;
 }
 
 
@@ -351,17 +891,17 @@ static int gml_is_srid_planar(int srid)
 /**
  * Parse gml srsName attribute
  */
-static void parse_gml_srs(xmlNodePtr xnode, gmlSrs *srs)
+static void parse_gml_srs(gmlNode *xnode, gmlSrs *srs)
 {
 	char *p;
 	int is_planar;
-	xmlNodePtr node;
-	xmlChar *srsname;
+	gmlNode *node;
+	char *srsname;
 	bool latlon = false;
 	char sep = ':';
 
 	node = xnode;
-	srsname = gmlGetProp(node, (xmlChar *) "srsName");
+	srsname = node->srsname;
 	/*printf("srsname %s\n",srsname);*/
 	if (!srsname)
 	{
@@ -392,19 +932,19 @@ static void parse_gml_srs(xmlNodePtr xnode, gmlSrs *srs)
 					http://www.epsg.org/6.11.2/4326
 		*/
 
-		if (!strncmp((char *) srsname, "EPSG:", 5))
+		if (!strncmp(srsname, "EPSG:", 5))
 		{
 			sep = ':';
 			latlon = false;
 		}
-		else if (!strncmp((char *) srsname, "urn:ogc:def:crs:EPSG:", 21)
-		         || !strncmp((char *) srsname, "urn:x-ogc:def:crs:EPSG:", 23)
-		         || !strncmp((char *) srsname, "urn:EPSG:geographicCRS:", 23))
+		else if (!strncmp(srsname, "urn:ogc:def:crs:EPSG:", 21)
+		         || !strncmp(srsname, "urn:x-ogc:def:crs:EPSG:", 23)
+		         || !strncmp(srsname, "urn:EPSG:geographicCRS:", 23))
 		{
 			sep = ':';
 			latlon = true;
 		}
-		else if (!strncmp((char *) srsname,
+		else if (!strncmp(srsname,
 		                  "http://www.opengis.net/gml/srs/epsg.xml#", 40))
 		{
 			sep = '#';
@@ -413,7 +953,7 @@ static void parse_gml_srs(xmlNodePtr xnode, gmlSrs *srs)
 		else gml_lwerror("unknown spatial reference system", 4);
 
 		/* retrieve the last ':' or '#' char */
-		for (p = (char *) srsname ; *p ; p++);
+		for (p = srsname ; *p ; p++);
 		for (--p ; *p != sep ; p--)
 			if (!isdigit(*p)) gml_lwerror("unknown spatial reference system", 5);
 
@@ -426,398 +966,120 @@ static void parse_gml_srs(xmlNodePtr xnode, gmlSrs *srs)
 
 		/* About lat/lon issue, Cf: http://tinyurl.com/yjpr55z */
 		srs->reverse_axis = !is_planar && latlon;
-
-		xmlFree(srsname);
-		return;
 	}
 }
 
 
 /**
- * Parse a string supposed to be a double
+ * Take the points read in a coordinates element
  */
-static double parse_gml_double(char *d, bool space_before, bool space_after)
+static POINTARRAY* gml_data_pa(gmlNode *xnode, bool *hasz)
 {
-	char *p;
-	int st;
-	enum states
-	{
-		INIT     	= 0,
-		NEED_DIG  	= 1,
-		DIG	  	= 2,
-		NEED_DIG_DEC 	= 3,
-		DIG_DEC 	= 4,
-		EXP	 	= 5,
-		NEED_DIG_EXP 	= 6,
-		DIG_EXP 	= 7,
-		END 		= 8
-	};
-
-	/*
-	 * Double pattern
-	 * [-|\+]?[0-9]+(\.)?([0-9]+)?([Ee](\+|-)?[0-9]+)?
-	 * We could also meet spaces before and/or after
-	 * this pattern upon parameters
-	 */
-
-	if (space_before) while (isspace(*d)) d++;
-	for (st = INIT, p = d ; *p ; p++)
-	{
-
-		if (isdigit(*p))
-		{
-			if (st == INIT || st == NEED_DIG) 		st = DIG;
-			else if (st == NEED_DIG_DEC) 			st = DIG_DEC;
-			else if (st == NEED_DIG_EXP || st == EXP) 	st = DIG_EXP;
-			else if (st == DIG || st == DIG_DEC || st == DIG_EXP);
-			else gml_lwerror("invalid GML representation", 7);
-		}
-		else if (*p == '.')
-		{
-			if      (st == DIG) 				st = NEED_DIG_DEC;
-			else    gml_lwerror("invalid GML representation", 8);
-		}
-		else if (*p == '-' || *p == '+')
-		{
-			if      (st == INIT) 				st = NEED_DIG;
-			else if (st == EXP) 				st = NEED_DIG_EXP;
-			else    gml_lwerror("invalid GML representation", 9);
-		}
-		else if (*p == 'e' || *p == 'E')
-		{
-			if      (st == DIG || st == DIG_DEC) 		st = EXP;
-			else    gml_lwerror("invalid GML representation", 10);
-		}
-		else if (isspace(*p))
-		{
-			if (!space_after) gml_lwerror("invalid GML representation", 11);
-			if (st == DIG || st == DIG_DEC || st == DIG_EXP)st = END;
-			else if (st == NEED_DIG_DEC)			st = END;
-			else if (st == END);
-			else    gml_lwerror("invalid GML representation", 12);
-		}
-		else  gml_lwerror("invalid GML representation", 13);
-	}
-
-	if (st != DIG && st != NEED_DIG_DEC && st != DIG_DEC && st != DIG_EXP && st != END)
-		gml_lwerror("invalid GML representation", 14);
-
-	return atof(d);
-}
-
-
-/**
- * Parse gml:coordinates
- */
-static POINTARRAY* parse_gml_coordinates(xmlNodePtr xnode, bool *hasz)
-{
-	xmlChar *gml_coord, *gml_ts, *gml_cs, *gml_dec;
-	char cs, ts, dec;
-	POINTARRAY *dpa;
-	int gml_dims;
-	char *p, *q;
-	bool digit;
-	POINT4D pt;
-
-	/* We begin to retrieve coordinates string */
-	gml_coord = xmlNodeGetContent(xnode);
-	p = (char *) gml_coord;
-
-	/* Default GML coordinates pattern: 	x1,y1 x2,y2
-	 * 					x1,y1,z1 x2,y2,z2
-	 *
-	 * Cf GML 2.1.2 -> 4.3.1 (p18)
-	 */
-
-	/* Retrieve separator between coordinates tuples */
-	gml_ts = gmlGetProp(xnode, (xmlChar *) "ts");
-	if (gml_ts == NULL) ts = ' ';
-	else
-	{
-		if (xmlStrlen(gml_ts) > 1 || isdigit(gml_ts[0]))
-			gml_lwerror("invalid GML representation", 15);
-		ts = gml_ts[0];
-		xmlFree(gml_ts);
-	}
+	gmlData *data = xnode->data;
+	POINTARRAY *pa;
 
-	/* Retrieve separator between each coordinate */
-	gml_cs = gmlGetProp(xnode, (xmlChar *) "cs");
-	if (gml_cs == NULL) cs = ',';
-	else
-	{
-		if (xmlStrlen(gml_cs) > 1 || isdigit(gml_cs[0]))
-			gml_lwerror("invalid GML representation", 16);
-		cs = gml_cs[0];
-		xmlFree(gml_cs);
-	}
+	if (data->error) gml_lwerror("invalid GML representation", data->error);
+	if (data->pa == NULL) gml_lwerror("invalid GML representation", 33);
 
-	/* Retrieve decimal separator */
-	gml_dec = gmlGetProp(xnode, (xmlChar *) "decimal");
-	if (gml_dec == NULL) dec = '.';
+	/* Coordinates reachable through a XLink are copied, others taken */
+	if (data->shared) pa = ptarray_clone_deep(data->pa);
 	else
 	{
-		if (xmlStrlen(gml_dec) > 1 || isdigit(gml_dec[0]))
-			gml_lwerror("invalid GML representation", 17);
-		dec = gml_dec[0];
-		xmlFree(gml_dec);
+		pa = data->pa;
+		data->pa = NULL;
 	}
 
-	if (cs == ts || cs == dec || ts == dec)
-		gml_lwerror("invalid GML representation", 18);
-
-	/* HasZ, !HasM, 1 Point */
-	dpa = ptarray_construct_empty(1, 0, 1);
-
-	while (isspace(*p)) p++;		/* Eat extra whitespaces if any */
-	for (q = p, gml_dims=0, digit = false ; *p ; p++)
-	{
-
-		if (isdigit(*p)) digit = true;	/* One state parser */
-
-		/* Coordinate Separator */
-		if (*p == cs)
-		{
-			*p = '\0';
-			gml_dims++;
-
-			if (*(p+1) == '\0') gml_lwerror("invalid GML representation", 19);
-
-			if 	(gml_dims == 1) pt.x = parse_gml_double(q, false, true);
-			else if (gml_dims == 2) pt.y = parse_gml_double(q, false, true);
-
-			q = p+1;
-
-			/* Tuple Separator (or end string) */
-		}
-		else if (digit && (*p == ts || *(p+1) == '\0'))
-		{
-			if (*p == ts) *p = '\0';
-			gml_dims++;
-
-			if (gml_dims < 2 || gml_dims > 3)
-				gml_lwerror("invalid GML representation", 20);
-
-			if (gml_dims == 3)
-				pt.z = parse_gml_double(q, false, true);
-			else
-			{
-				pt.y = parse_gml_double(q, false, true);
-				*hasz = false;
-			}
-
-			ptarray_append_point(dpa, &pt, LW_FALSE);
-			digit = false;
-
-			q = p+1;
-			gml_dims = 0;
-
-			/* Need to put standard decimal separator to atof handle */
-		}
-		else if (*p == dec && dec != '.') *p = '.';
-	}
-
-	xmlFree(gml_coord);
-
-	return dpa; /* ptarray_clone_deep(dpa); */
+	if (!FLAGS_GET_Z(pa->flags)) *hasz = false;
+	return pa;
 }
 
 
 /**
  * Parse gml:coord
  */
-static POINTARRAY* parse_gml_coord(xmlNodePtr xnode, bool *hasz)
+static POINTARRAY* parse_gml_coord(gmlNode *xnode, bool *hasz)
 {
-	xmlNodePtr xyz;
+	gmlNode *xyz;
 	POINTARRAY *dpa;
 	bool x,y,z;
-	xmlChar *c;
 	POINT4D p;
 
-	/* HasZ?, !HasM, 1 Point */
-	dpa = ptarray_construct_empty(1, 0, 1);
-	
 	x = y = z = false;
+	p.z = p.m = 0.0;
 	for (xyz = xnode->children ; xyz != NULL ; xyz = xyz->next)
 	{
-		if (xyz->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xyz, false)) continue;
+		if (!xyz->is_gml || xyz->data == NULL) continue;
+		if (xyz->data->error)
+			gml_lwerror("invalid GML representation", xyz->data->error);
 
-		if (!strcmp((char *) xyz->name, "X"))
+		if (!strcmp(xyz->name, "X"))
 		{
 			if (x) gml_lwerror("invalid GML representation", 21);
-			c = xmlNodeGetContent(xyz);
-			p.x = parse_gml_double((char *) c, true, true);
+			p.x = xyz->data->ordinate;
 			x = true;
-			xmlFree(c);
 		}
-		else  if (!strcmp((char *) xyz->name, "Y"))
+		else  if (!strcmp(xyz->name, "Y"))
 		{
 			if (y) gml_lwerror("invalid GML representation", 22);
-			c = xmlNodeGetContent(xyz);
-			p.y = parse_gml_double((char *) c, true, true);
+			p.y = xyz->data->ordinate;
 			y = true;
-			xmlFree(c);
 		}
-		else if (!strcmp((char *) xyz->name, "Z"))
+		else if (!strcmp(xyz->name, "Z"))
 		{
 			if (z) gml_lwerror("invalid GML representation", 23);
-			c = xmlNodeGetContent(xyz);
-			p.z = parse_gml_double((char *) c, true, true);
+			p.z = xyz->data->ordinate;
 			z = true;
-			xmlFree(c);
 		}
 	}
 	/* Check dimension consistancy */
 	if (!x || !y) gml_lwerror("invalid GML representation", 24);
 	if (!z) *hasz = false;
 
+	/* HasZ?, !HasM, 1 Point */
+	dpa = ptarray_construct_empty(z, 0, 1);
 	ptarray_append_point(dpa, &p, LW_FALSE);
-	x = y = z = false;
 
-	return ptarray_clone_deep(dpa);
+	return dpa;
 }
 
 
 /**
- * Parse gml:pos
+ * Concatenate two POINTARRAY, dropping Z if only one has it
  */
-static POINTARRAY* parse_gml_pos(xmlNodePtr xnode, bool *hasz)
+static POINTARRAY* gml_merge_pa(POINTARRAY *pa, POINTARRAY *tmp_pa)
 {
-	xmlChar *dimension, *gmlpos;
-	xmlNodePtr posnode;
-	int dim, gml_dim;
-	POINTARRAY *dpa;
-	char *pos, *p;
-	bool digit;
-	POINT4D pt;
+	if (pa == NULL) return tmp_pa;
 
-	/* HasZ, !HasM, 1 Point */
-	dpa = ptarray_construct_empty(1, 0, 1);
-
-	for (posnode = xnode ; posnode != NULL ; posnode = posnode->next)
+	if (FLAGS_GET_Z(pa->flags) != FLAGS_GET_Z(tmp_pa->flags))
 	{
-		/* We only care about gml:pos element */
-		if (posnode->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(posnode, false)) continue;
-		if (strcmp((char *) posnode->name, "pos")) continue;
-
-		dimension = gmlGetProp(xnode, (xmlChar *) "srsDimension");
-		if (dimension == NULL) /* in GML 3.0.0 it was dimension */
-			dimension = gmlGetProp(xnode, (xmlChar *) "dimension");
-		if (dimension == NULL) dim = 2;	/* We assume that we are in 2D */
-		else
-		{
-			dim = atoi((char *) dimension);
-			xmlFree(dimension);
-			if (dim < 2 || dim > 3)
-				gml_lwerror("invalid GML representation", 25);
-		}
-		if (dim == 2) *hasz = false;
-
-		/* We retrieve gml:pos string */
-		gmlpos = xmlNodeGetContent(posnode);
-		pos = (char *) gmlpos;
-		while (isspace(*pos)) pos++;	/* Eat extra whitespaces if any */
-
-		/* gml:pos pattern: 	x1 y1
-		 * 			x1 y1 z1
-		 */
-		for (p=pos, gml_dim=0, digit=false ; *pos ; pos++)
-		{
-			if (isdigit(*pos)) digit = true;
-			if (digit && (*pos == ' ' || *(pos+1) == '\0'))
-			{
-				if (*pos == ' ') *pos = '\0';
-				gml_dim++;
-				if 	(gml_dim == 1)
-					pt.x = parse_gml_double(p, true, true);
-				else if (gml_dim == 2)
-					pt.y = parse_gml_double(p, true, true);
-				else if (gml_dim == 3)
-					pt.z = parse_gml_double(p, true, true);
-
-				p = pos+1;
-				digit = false;
-			}
-		}
-		xmlFree(gmlpos);
-
-		/* Test again coherent dimensions on each coord */
-		if (gml_dim == 2) *hasz = false;
-		if (gml_dim < 2 || gml_dim > 3 || gml_dim != dim)
-			gml_lwerror("invalid GML representation", 26);
-
-		ptarray_append_point(dpa, &pt, LW_FALSE);
+		gml_ptarray_force_2d(pa);
+		gml_ptarray_force_2d(tmp_pa);
 	}
-
-	return ptarray_clone_deep(dpa);
+	return ptarray_merge(pa, tmp_pa);
 }
 
 
 /**
- * Parse gml:posList
+ * Make the rings of a surface all 2D or all 3D
  */
-static POINTARRAY* parse_gml_poslist(xmlNodePtr xnode, bool *hasz)
+static void gml_rings_dims(POINTARRAY **ppa, int nrings, bool hasz)
 {
-	xmlChar *dimension, *gmlposlist;
-	char *poslist, *p;
-	int dim, gml_dim;
-	POINTARRAY *dpa;
-	POINT4D pt;
-	bool digit;
-
-	/* Retrieve gml:srsDimension attribute if any */
-	dimension = gmlGetProp(xnode, (xmlChar *) "srsDimension");
-	if (dimension == NULL) /* in GML 3.0.0 it was dimension */
-		dimension = gmlGetProp(xnode, (xmlChar *) "dimension");
-	if (dimension == NULL) dim = 2;	/* We assume that we are in common 2D */
-	else
-	{
-		dim = atoi((char *) dimension);
-		xmlFree(dimension);
-		if (dim < 2 || dim > 3) gml_lwerror("invalid GML representation", 27);
-	}
-	if (dim == 2) *hasz = false;
-
-	/* Retrieve gml:posList string */
-	gmlposlist = xmlNodeGetContent(xnode);
-	poslist = (char *) gmlposlist;
-
-	/* HasZ?, !HasM, 1 point */
-	dpa = ptarray_construct_empty(1, 0, 1);
-
-	/* gml:posList pattern: 	x1 y1 x2 y2
-	 * 				x1 y1 z1 x2 y2 z2
-	 */
-	while (isspace(*poslist)) poslist++;	/* Eat extra whitespaces if any */
-	for (p=poslist, gml_dim=0, digit=false ; *poslist ; poslist++)
-	{
-		if (isdigit(*poslist)) digit = true;
-		if (digit && (*poslist == ' ' || *(poslist+1) == '\0'))
-		{
-			if (*poslist == ' ') *poslist = '\0';
-
-			gml_dim++;
-			if 	(gml_dim == 1) pt.x = parse_gml_double(p, true, true);
-			else if (gml_dim == 2) pt.y = parse_gml_double(p, true, true);
-			else if (gml_dim == 3) pt.z = parse_gml_double(p, true, true);
-
-			if (gml_dim == dim)
-			{
-				ptarray_append_point(dpa, &pt, LW_FALSE);
-				gml_dim = 0;
-			}
-			else if (*(poslist+1) == '\0')
-				gml_lwerror("invalid GML representation", 28);
+	int i;
 
-			p = poslist+1;
-			digit = false;
-		}
-	}
+	if (hasz) return;
+	for (i=0 ; i < nrings ; i++)
+		gml_ptarray_force_2d(ppa[i]);
+}
 
-	xmlFree(gmlposlist);
 
-	return ptarray_clone_deep(dpa);
+/**
+ * Check that a ring has enough points, and is closed
+ */
+static bool gml_ring_is_valid(POINTARRAY *pa, int minpoints, bool hasz)
+{
+	if (pa->npoints < minpoints) return false;
+	if (hasz && FLAGS_GET_Z(pa->flags)) return ptarray_isclosed3d(pa);
+	return ptarray_isclosed2d(pa);
 }
 
 
@@ -833,69 +1095,38 @@ static POINTARRAY* parse_gml_poslist(xmlNodePtr xnode, bool *hasz)
  *  - gml:coordinate element with tuples string inside 	(deprecated in 3.1.0)
  *  - gml:coord elements with X,Y(,Z) nested elements 	(deprecated in 3.0.0)
  */
-static POINTARRAY* parse_gml_data(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static POINTARRAY* parse_gml_data(gmlNode *xnode, bool *hasz, int *root_srid)
 {
-	POINTARRAY *pa = 0, *tmp_pa = 0;
-	xmlNodePtr xa, xb;
+	POINTARRAY *pa = NULL, *tmp_pa;
+	gmlNode *xa, *xb;
 	gmlSrs srs;
-	bool found;
-
-	pa = NULL;
 
 	for (xa = xnode ; xa != NULL ; xa = xa->next)
 	{
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (xa->name == NULL) continue;
-
-		if (!strcmp((char *) xa->name, "pos"))
-		{
-			tmp_pa = parse_gml_pos(xa, hasz);
-			if (pa == NULL) pa = tmp_pa;
-			else pa = ptarray_merge(pa, tmp_pa);
-
-		}
-		else if (!strcmp((char *) xa->name, "posList"))
-		{
-			tmp_pa = parse_gml_poslist(xa, hasz);
-			if (pa == NULL) pa = tmp_pa;
-			else pa = ptarray_merge(pa, tmp_pa);
+		if (!xa->is_gml) continue;
 
-		}
-		else if (!strcmp((char *) xa->name, "coordinates"))
+		if (!strcmp(xa->name, "pos")
+		        || !strcmp(xa->name, "posList")
+		        || !strcmp(xa->name, "coordinates"))
 		{
-			tmp_pa = parse_gml_coordinates(xa, hasz);
-			if (pa == NULL) pa = tmp_pa;
-			else pa = ptarray_merge(pa, tmp_pa);
-
+			pa = gml_merge_pa(pa, gml_data_pa(xa, hasz));
 		}
-		else if (!strcmp((char *) xa->name, "coord"))
+		else if (!strcmp(xa->name, "coord"))
 		{
-			tmp_pa = parse_gml_coord(xa, hasz);
-			if (pa == NULL) pa = tmp_pa;
-			else pa = ptarray_merge(pa, tmp_pa);
-
+			pa = gml_merge_pa(pa, parse_gml_coord(xa, hasz));
 		}
-		else if (!strcmp((char *) xa->name, "pointRep") ||
-		         !strcmp((char *) xa->name, "pointProperty"))
+		else if (!strcmp(xa->name, "pointRep") ||
+		         !strcmp(xa->name, "pointProperty"))
 		{
-
-			found = false;
 			for (xb = xa->children ; xb != NULL ; xb = xb->next)
 			{
-				if (xb->type != XML_ELEMENT_NODE) continue;
-				if (!is_gml_namespace(xb, false)) continue;
-				if (!strcmp((char *) xb->name, "Point"))
-				{
-					found = true;
-					break;
-				}
+				if (xb->is_gml && !strcmp(xb->name, "Point")) break;
 			}
-			if (!found || xb == NULL)
+			if (xb == NULL)
 				gml_lwerror("invalid GML representation", 29);
 
-			if (is_xlink(xb)) xb = get_xlink_node(xb);
-			if (xb == NULL || xb->children == NULL)
+			if (xb->href) xb = get_xlink_node(xb);
+			if (!xb->has_children)
 				gml_lwerror("invalid GML representation", 30);
 
 			tmp_pa = parse_gml_data(xb->children, hasz, root_srid);
@@ -907,8 +1138,7 @@ static POINTARRAY* parse_gml_data(xmlNodePtr xnode, bool *hasz, int *root_srid)
 			if (*root_srid == SRID_UNKNOWN) *root_srid = srs.srid;
 			else if (srs.srid != *root_srid)
 				gml_reproject_pa(tmp_pa, srs.srid, *root_srid);
-			if (pa == NULL) pa = tmp_pa;
-			else pa = ptarray_merge(pa, tmp_pa);
+			pa = gml_merge_pa(pa, tmp_pa);
 		}
 	}
 
@@ -921,15 +1151,15 @@ static POINTARRAY* parse_gml_data(xmlNodePtr xnode, bool *hasz, int *root_srid)
 /**
  * Parse GML point (2.1.2, 3.1.1)
  */
-static LWGEOM* parse_gml_point(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_point(gmlNode *xnode, bool *hasz, int *root_srid)
 {
 	gmlSrs srs;
 	LWGEOM *geom;
 	POINTARRAY *pa;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
-	if (xnode->children == NULL) 
+	if (!xnode->has_children)
 		return lwpoint_as_lwgeom(lwpoint_construct_empty(*root_srid, 0, 0));
 
 	pa = parse_gml_data(xnode->children, hasz, root_srid);
@@ -956,17 +1186,17 @@ static LWGEOM* parse_gml_point(xmlNodePtr xnode, bool *hasz, int *root_srid)
 /**
  * Parse GML lineString (2.1.2, 3.1.1)
  */
-static LWGEOM* parse_gml_line(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_line(gmlNode *xnode, bool *hasz, int *root_srid)
 {
 	gmlSrs srs;
 	LWGEOM *geom;
 	POINTARRAY *pa;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
-	if (xnode->children == NULL) 
+	if (!xnode->has_children)
 		return lwline_as_lwgeom(lwline_construct_empty(*root_srid, 0, 0));
-		
+	
 	pa = parse_gml_data(xnode->children, hasz, root_srid);
 	if (pa->npoints < 2) gml_lwerror("invalid GML representation", 36);
 
@@ -991,26 +1221,24 @@ static LWGEOM* parse_gml_line(xmlNodePtr xnode, bool *hasz, int *root_srid)
 /**
  * Parse GML Curve (3.1.1)
  */
-static LWGEOM* parse_gml_curve(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_curve(gmlNode *xnode, bool *hasz, int *root_srid)
 {
-	xmlNodePtr xa;
-	int lss, last, i;
+	gmlNode *xa;
+	int lss, i;
 	bool found=false;
 	gmlSrs srs;
 	LWGEOM *geom=NULL;
 	POINTARRAY *pa=NULL;
 	POINTARRAY **ppa=NULL;
 	uint32 npoints=0;
-	xmlChar *interpolation=NULL;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
 	/* Looking for gml:segments */
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (!strcmp((char *) xa->name, "segments"))
+		if (!xa->is_gml) continue;
+		if (!strcmp(xa->name, "segments"))
 		{
 			found = true;
 			break;
@@ -1023,18 +1251,12 @@ static LWGEOM* parse_gml_curve(xmlNodePtr xnode, bool *hasz, int *root_srid)
 	/* Processing each gml:LineStringSegment */
 	for (xa = xa->children, lss=0; xa != NULL ; xa = xa->next)
 	{
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "LineStringSegment")) continue;
+		if (!xa->is_gml) continue;
+		if (strcmp(xa->name, "LineStringSegment")) continue;
 
 		/* GML SF is resticted to linear interpolation  */
-		interpolation = gmlGetProp(xa, (xmlChar *) "interpolation");
-		if (interpolation != NULL)
-		{
-			if (strcmp((char *) interpolation, "linear"))
-				gml_lwerror("invalid GML representation", 38);
-			xmlFree(interpolation);
-		}
+		if (xa->interpolation != NULL && strcmp(xa->interpolation, "linear"))
+			gml_lwerror("invalid GML representation", 38);
 
 		if (lss > 0) ppa = (POINTARRAY**) lwrealloc((POINTARRAY *) ppa,
 			                   sizeof(POINTARRAY*) * (lss + 1));
@@ -1060,23 +1282,23 @@ static LWGEOM* parse_gml_curve(xmlNodePtr xnode, bool *hasz, int *root_srid)
 	 */
 	if (lss > 1)
 	{
-		pa = ptarray_construct(1, 0, npoints - (lss - 1));
-		for (last = npoints = i = 0; i < lss ; i++)
+		gml_rings_dims(ppa, lss, *hasz);
+		pa = ptarray_construct(FLAGS_GET_Z(ppa[0]->flags), 0, npoints - (lss - 1));
+		for (npoints = i = 0; i < lss ; i++)
 		{
-			if (i + 1 == lss) last = 1;
 			/* Check if segments are not disjoints */
 			if (i > 0 && memcmp(	getPoint_internal(pa, npoints),
 			                     getPoint_internal(ppa[i], 0),
-			                     *hasz?sizeof(POINT3D):sizeof(POINT2D)))
+			                     ptarray_point_size(pa)))
 				gml_lwerror("invalid GML representation", 41);
 
 			/* Aggregate stuff */
 			memcpy(	getPoint_internal(pa, npoints),
 			        getPoint_internal(ppa[i], 0),
-			        ptarray_point_size(ppa[i]) * (ppa[i]->npoints + last));
+			        ptarray_point_size(ppa[i]) * ppa[i]->npoints);
 
 			npoints += ppa[i]->npoints - 1;
-			lwfree(ppa[i]);
+			ptarray_free(ppa[i]);
 		}
 		lwfree(ppa);
 	}
@@ -1094,29 +1316,27 @@ static LWGEOM* parse_gml_curve(xmlNodePtr xnode, bool *hasz, int *root_srid)
 /**
  * Parse GML LinearRing (3.1.1)
  */
-static LWGEOM* parse_gml_linearring(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_linearring(gmlNode *xnode, bool *hasz, int *root_srid)
 {
 	gmlSrs srs;
 	LWGEOM *geom;
 	POINTARRAY **ppa = NULL;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 	parse_gml_srs(xnode, &srs);
 
 	ppa = (POINTARRAY**) lwalloc(sizeof(POINTARRAY*));
 	ppa[0] = parse_gml_data(xnode->children, hasz, root_srid);
 
-	if (ppa[0]->npoints < 4
-            || (!*hasz && !ptarray_isclosed2d(ppa[0]))
-            ||  (*hasz && !ptarray_isclosed3d(ppa[0])))
+	if (!gml_ring_is_valid(ppa[0], 4, *hasz))
 	    gml_lwerror("invalid GML representation", 42);
 
-	if (srs.reverse_axis) 
+	if (srs.reverse_axis)
 		ppa[0] = ptarray_flip_coordinates(ppa[0]);
-	
-	if (srs.srid != *root_srid && *root_srid != SRID_UNKNOWN) 
+
+	if (srs.srid != *root_srid && *root_srid != SRID_UNKNOWN)
 		gml_reproject_pa(ppa[0], srs.srid, *root_srid);
-		
+	
 	geom = (LWGEOM *) lwpoly_construct(*root_srid, NULL, 1, ppa);
 
 	return geom;
@@ -1126,17 +1346,17 @@ static LWGEOM* parse_gml_linearring(xmlNodePtr xnode, bool *hasz, int *root_srid
 /**
  * Parse GML Polygon (2.1.2, 3.1.1)
  */
-static LWGEOM* parse_gml_polygon(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_polygon(gmlNode *xnode, bool *hasz, int *root_srid)
 {
 	gmlSrs srs;
 	int i, ring;
 	LWGEOM *geom;
-	xmlNodePtr xa, xb;
+	gmlNode *xa, *xb;
 	POINTARRAY **ppa = NULL;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
-	if (xnode->children == NULL) 
+	if (!xnode->has_children)
 		return lwpoly_as_lwgeom(lwpoly_construct_empty(*root_srid, 0, 0));
 
 	parse_gml_srs(xnode, &srs);
@@ -1145,23 +1365,19 @@ static LWGEOM* parse_gml_polygon(xmlNodePtr xnode, bool *hasz, int *root_srid)
 	{
 		/* Polygon/outerBoundaryIs -> GML 2.1.2 */
 		/* Polygon/exterior        -> GML 3.1.1 */
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if  (strcmp((char *) xa->name, "outerBoundaryIs") &&
-		        strcmp((char *) xa->name, "exterior")) continue;
+		if (!xa->is_gml) continue;
+		if  (strcmp(xa->name, "outerBoundaryIs") &&
+		        strcmp(xa->name, "exterior")) continue;
 
 		for (xb = xa->children ; xb != NULL ; xb = xb->next)
 		{
-			if (xb->type != XML_ELEMENT_NODE) continue;
-			if (!is_gml_namespace(xb, false)) continue;
-			if (strcmp((char *) xb->name, "LinearRing")) continue;
+			if (!xb->is_gml) continue;
+			if (strcmp(xb->name, "LinearRing")) continue;
 
 			ppa = (POINTARRAY**) lwalloc(sizeof(POINTARRAY*));
 			ppa[0] = parse_gml_data(xb->children, hasz, root_srid);
 
-			if (ppa[0]->npoints < 4
-			        || (!*hasz && !ptarray_isclosed2d(ppa[0]))
-			        ||  (*hasz && !ptarray_isclosed3d(ppa[0])))
+			if (!gml_ring_is_valid(ppa[0], 4, *hasz))
 				gml_lwerror("invalid GML representation", 43);
 
 			if (srs.reverse_axis) ppa[0] = ptarray_flip_coordinates(ppa[0]);
@@ -1172,24 +1388,20 @@ static LWGEOM* parse_gml_polygon(xmlNodePtr xnode, bool *hasz, int *root_srid)
 	{
 		/* Polygon/innerBoundaryIs -> GML 2.1.2 */
 		/* Polygon/interior        -> GML 3.1.1 */
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if  (strcmp((char *) xa->name, "innerBoundaryIs") &&
-		        strcmp((char *) xa->name, "interior")) continue;
+		if (!xa->is_gml) continue;
+		if  (strcmp(xa->name, "innerBoundaryIs") &&
+		        strcmp(xa->name, "interior")) continue;
 
 		for (xb = xa->children ; xb != NULL ; xb = xb->next)
 		{
-			if (xb->type != XML_ELEMENT_NODE) continue;
-			if (!is_gml_namespace(xb, false)) continue;
-			if (strcmp((char *) xb->name, "LinearRing")) continue;
+			if (!xb->is_gml) continue;
+			if (strcmp(xb->name, "LinearRing")) continue;
 
 			ppa = (POINTARRAY**) lwrealloc((POINTARRAY *) ppa,
 			                               sizeof(POINTARRAY*) * (ring + 1));
 			ppa[ring] = parse_gml_data(xb->children, hasz, root_srid);
 
-			if (ppa[ring]->npoints < 4
-			        || (!*hasz && !ptarray_isclosed2d(ppa[ring]))
-			        ||  (*hasz && !ptarray_isclosed3d(ppa[ring])))
+			if (!gml_ring_is_valid(ppa[ring], 4, *hasz))
 				gml_lwerror("invalid GML representation", 43);
 
 			if (srs.reverse_axis) ppa[ring] = ptarray_flip_coordinates(ppa[ring]);
@@ -1205,6 +1417,7 @@ static LWGEOM* parse_gml_polygon(xmlNodePtr xnode, bool *hasz, int *root_srid)
 		for (i=0 ; i < ring ; i++)
 			gml_reproject_pa(ppa[i], srs.srid, *root_srid);
 	}
+	gml_rings_dims(ppa, ring, *hasz);
 	geom = (LWGEOM *) lwpoly_construct(*root_srid, NULL, ring, ppa);
 
 	return geom;
@@ -1214,52 +1427,41 @@ static LWGEOM* parse_gml_polygon(xmlNodePtr xnode, bool *hasz, int *root_srid)
 /**
  * Parse GML Triangle (3.1.1)
  */
-static LWGEOM* parse_gml_triangle(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_triangle(gmlNode *xnode, bool *hasz, int *root_srid)
 {
 	gmlSrs srs;
 	LWGEOM *geom;
-	xmlNodePtr xa, xb;
+	gmlNode *xa, *xb;
 	POINTARRAY *pa = NULL;
-	xmlChar *interpolation=NULL;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
-	if (xnode->children == NULL) 
+	if (!xnode->has_children)
 		return lwtriangle_as_lwgeom(lwtriangle_construct_empty(*root_srid, 0, 0));
 
 	/* GML SF is resticted to planar interpolation
 	       NOTA: I know Triangle is not part of SF, but
 	       we have to be consistent with other surfaces */
-	interpolation = gmlGetProp(xnode, (xmlChar *) "interpolation");
-	if (interpolation != NULL)
-	{
-		if (strcmp((char *) interpolation, "planar"))
-			gml_lwerror("invalid GML representation", 45);
-		xmlFree(interpolation);
-	}
+	if (xnode->interpolation != NULL && strcmp(xnode->interpolation, "planar"))
+		gml_lwerror("invalid GML representation", 45);
 
 	parse_gml_srs(xnode, &srs);
 
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
 		/* Triangle/exterior */
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "exterior")) continue;
+		if (!xa->is_gml) continue;
+		if (strcmp(xa->name, "exterior")) continue;
 
 		for (xb = xa->children ; xb != NULL ; xb = xb->next)
 		{
 			/* Triangle/exterior/LinearRing */
-			if (xb->type != XML_ELEMENT_NODE) continue;
-			if (!is_gml_namespace(xb, false)) continue;
-			if (strcmp((char *) xb->name, "LinearRing")) continue;
+			if (!xb->is_gml) continue;
+			if (strcmp(xb->name, "LinearRing")) continue;
 
-			pa = (POINTARRAY*) lwalloc(sizeof(POINTARRAY));
 			pa = parse_gml_data(xb->children, hasz, root_srid);
 
-			if (pa->npoints != 4
-			        || (!*hasz && !ptarray_isclosed2d(pa))
-			        ||  (*hasz && !ptarray_isclosed3d(pa)))
+			if (pa->npoints != 4 || !gml_ring_is_valid(pa, 4, *hasz))
 				gml_lwerror("invalid GML representation", 46);
 
 			if (srs.reverse_axis) pa = ptarray_flip_coordinates(pa);
@@ -1281,49 +1483,40 @@ static LWGEOM* parse_gml_triangle(xmlNodePtr xnode, bool *hasz, int *root_srid)
 /**
  * Parse GML PolygonPatch (3.1.1)
  */
-static LWGEOM* parse_gml_patch(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_patch(gmlNode *xnode, bool *hasz, int *root_srid)
 {
-	xmlChar *interpolation=NULL;
 	POINTARRAY **ppa=NULL;
 	LWGEOM *geom=NULL;
-	xmlNodePtr xa, xb;
+	gmlNode *xa, *xb;
 	int i, ring=0;
 	gmlSrs srs;
 
 	/* PolygonPatch */
-	if (strcmp((char *) xnode->name, "PolygonPatch"))
+	if (strcmp(xnode->name, "PolygonPatch"))
 		gml_lwerror("invalid GML representation", 48);
 
 	/* GML SF is resticted to planar interpolation  */
-	interpolation = gmlGetProp(xnode, (xmlChar *) "interpolation");
-	if (interpolation != NULL)
-	{
-		if (strcmp((char *) interpolation, "planar"))
-			gml_lwerror("invalid GML representation", 48);
-		xmlFree(interpolation);
-	}
+	if (xnode->interpolation != NULL && strcmp(xnode->interpolation, "planar"))
+		gml_lwerror("invalid GML representation", 48);
 
 	parse_gml_srs(xnode, &srs);
 
 	/* PolygonPatch/exterior */
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
-		if (!is_gml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "exterior")) continue;
+		if (!xa->is_gml) continue;
+		if (strcmp(xa->name, "exterior")) continue;
 
 		/* PolygonPatch/exterior/LinearRing */
 		for (xb = xa->children ; xb != NULL ; xb = xb->next)
 		{
-			if (xb->type != XML_ELEMENT_NODE) continue;
-			if (!is_gml_namespace(xb, false)) continue;
-			if (strcmp((char *) xb->name, "LinearRing")) continue;
+			if (!xb->is_gml) continue;
+			if (strcmp(xb->name, "LinearRing")) continue;
 
 			ppa = (POINTARRAY**) lwalloc(sizeof(POINTARRAY*));
 			ppa[0] = parse_gml_data(xb->children, hasz, root_srid);
 
-			if (ppa[0]->npoints < 4
-			        || (!*hasz && !ptarray_isclosed2d(ppa[0]))
-			        ||  (*hasz && !ptarray_isclosed3d(ppa[0])))
+			if (!gml_ring_is_valid(ppa[0], 4, *hasz))
 				gml_lwerror("invalid GML representation", 48);
 
 			if (srs.reverse_axis)
@@ -1334,23 +1527,19 @@ static LWGEOM* parse_gml_patch(xmlNodePtr xnode, bool *hasz, int *root_srid)
 	/* PolygonPatch/interior */
 	for (ring=1, xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "interior")) continue;
+		if (!xa->is_gml) continue;
+		if (strcmp(xa->name, "interior")) continue;
 
 		/* PolygonPatch/interior/LinearRing */
 		for (xb = xa->children ; xb != NULL ; xb = xb->next)
 		{
-			if (xb->type != XML_ELEMENT_NODE) continue;
-			if (strcmp((char *) xb->name, "LinearRing")) continue;
+			if (strcmp(xb->name, "LinearRing")) continue;
 
 			ppa = (POINTARRAY**) lwrealloc((POINTARRAY *) ppa,
 			                               sizeof(POINTARRAY*) * (ring + 1));
 			ppa[ring] = parse_gml_data(xb->children, hasz, root_srid);
 
-			if (ppa[ring]->npoints < 4
-			        || (!*hasz && !ptarray_isclosed2d(ppa[ring]))
-			        || ( *hasz && !ptarray_isclosed3d(ppa[ring])))
+			if (!gml_ring_is_valid(ppa[ring], 4, *hasz))
 				gml_lwerror("invalid GML representation", 49);
 
 			if (srs.reverse_axis)
@@ -1368,6 +1557,7 @@ static LWGEOM* parse_gml_patch(xmlNodePtr xnode, bool *hasz, int *root_srid)
 		for (i=0 ; i < ring ; i++)
 			gml_reproject_pa(ppa[i], srs.srid, *root_srid);
 	}
+	gml_rings_dims(ppa, ring, *hasz);
 	geom = (LWGEOM *) lwpoly_construct(*root_srid, NULL, ring, ppa);
 
 	return geom;
@@ -1377,21 +1567,20 @@ static LWGEOM* parse_gml_patch(xmlNodePtr xnode, bool *hasz, int *root_srid)
 /**
  * Parse GML Surface (3.1.1)
  */
-static LWGEOM* parse_gml_surface(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_surface(gmlNode *xnode, bool *hasz, int *root_srid)
 {
-	xmlNodePtr xa;
+	gmlNode *xa;
 	int patch;
 	LWGEOM *geom=NULL;
 	bool found=false;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
 	/* Looking for gml:patches */
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (!strcmp((char *) xa->name, "patches"))
+		if (!xa->is_gml) continue;
+		if (!strcmp(xa->name, "patches"))
 		{
 			found = true;
 			break;
@@ -1402,9 +1591,8 @@ static LWGEOM* parse_gml_surface(xmlNodePtr xnode, bool *hasz, int *root_srid)
 	/* Processing gml:PolygonPatch */
 	for (patch=0, xa = xa->children ; xa != NULL ; xa = xa->next)
 	{
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "PolygonPatch")) continue;
+		if (!xa->is_gml) continue;
+		if (strcmp(xa->name, "PolygonPatch")) continue;
 		patch++;
 
 		/* SQL/MM define ST_CurvePolygon as a single patch only,
@@ -1429,14 +1617,14 @@ static LWGEOM* parse_gml_surface(xmlNodePtr xnode, bool *hasz, int *root_srid)
  * - maxLength
  * - position
  */
-static LWGEOM* parse_gml_tin(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_tin(gmlNode *xnode, bool *hasz, int *root_srid)
 {
 	gmlSrs srs;
-	xmlNodePtr xa;
+	gmlNode *xa;
 	LWGEOM *geom=NULL;
 	bool found=false;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
 	parse_gml_srs(xnode, &srs);
 	if (*root_srid == SRID_UNKNOWN && srs.srid != SRID_UNKNOWN)
@@ -1444,16 +1632,15 @@ static LWGEOM* parse_gml_tin(xmlNodePtr xnode, bool *hasz, int *root_srid)
 
 	geom = (LWGEOM *)lwcollection_construct_empty(TINTYPE, *root_srid, 1, 0);
 
-	if (xnode->children == NULL) 
+	if (!xnode->has_children)
 		return geom;
 
 	/* Looking for gml:patches or gml:trianglePatches */
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (!strcmp((char *) xa->name, "patches") ||
-		        !strcmp((char *) xa->name, "trianglePatches"))
+		if (!xa->is_gml) continue;
+		if (!strcmp(xa->name, "patches") ||
+		        !strcmp(xa->name, "trianglePatches"))
 		{
 			found = true;
 			break;
@@ -1464,11 +1651,10 @@ static LWGEOM* parse_gml_tin(xmlNodePtr xnode, bool *hasz, int *root_srid)
 	/* Processing each gml:Triangle */
 	for (xa = xa->children ; xa != NULL ; xa = xa->next)
 	{
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "Triangle")) continue;
+		if (!xa->is_gml) continue;
+		if (strcmp(xa->name, "Triangle")) continue;
 
-		if (xa->children != NULL)
+		if (xa->has_children)
 			geom = (LWGEOM*) lwtin_add_lwtriangle((LWTIN *) geom,
 			       (LWTRIANGLE *) parse_gml_triangle(xa, hasz, root_srid));
 	}
@@ -1480,13 +1666,13 @@ static LWGEOM* parse_gml_tin(xmlNodePtr xnode, bool *hasz, int *root_srid)
 /**
  * Parse gml:MultiPoint (2.1.2, 3.1.1)
  */
-static LWGEOM* parse_gml_mpoint(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_mpoint(gmlNode *xnode, bool *hasz, int *root_srid)
 {
 	gmlSrs srs;
-	xmlNodePtr xa;
+	gmlNode *xa;
 	LWGEOM *geom = NULL;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
 	parse_gml_srs(xnode, &srs);
 	if (*root_srid == SRID_UNKNOWN && srs.srid != SRID_UNKNOWN)
@@ -1494,16 +1680,15 @@ static LWGEOM* parse_gml_mpoint(xmlNodePtr xnode, bool *hasz, int *root_srid)
 
 	geom = (LWGEOM *)lwcollection_construct_empty(MULTIPOINTTYPE, *root_srid, 1, 0);
 
-	if (xnode->children == NULL) 
+	if (!xnode->has_children)
 		return geom;
 
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
 		/* MultiPoint/pointMember */
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "pointMember")) continue;
-		if (xa->children != NULL)
+		if (!xa->is_gml) continue;
+		if (strcmp(xa->name, "pointMember")) continue;
+		if (xa->has_children)
 			geom = (LWGEOM*)lwmpoint_add_lwpoint((LWMPOINT*)geom,
 			                                     (LWPOINT*)parse_gml(xa->children, hasz, root_srid));
 	}
@@ -1515,13 +1700,13 @@ static LWGEOM* parse_gml_mpoint(xmlNodePtr xnode, bool *hasz, int *root_srid)
 /**
  * Parse gml:MultiLineString (2.1.2, 3.1.1)
  */
-static LWGEOM* parse_gml_mline(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_mline(gmlNode *xnode, bool *hasz, int *root_srid)
 {
 	gmlSrs srs;
-	xmlNodePtr xa;
+	gmlNode *xa;
 	LWGEOM *geom = NULL;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
 	parse_gml_srs(xnode, &srs);
 	if (*root_srid == SRID_UNKNOWN && srs.srid != SRID_UNKNOWN)
@@ -1529,16 +1714,15 @@ static LWGEOM* parse_gml_mline(xmlNodePtr xnode, bool *hasz, int *root_srid)
 
 	geom = (LWGEOM *)lwcollection_construct_empty(MULTILINETYPE, *root_srid, 1, 0);
 
-	if (xnode->children == NULL) 
+	if (!xnode->has_children)
 		return geom;
 
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
 		/* MultiLineString/lineStringMember */
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "lineStringMember")) continue;
-		if (xa->children != NULL)
+		if (!xa->is_gml) continue;
+		if (strcmp(xa->name, "lineStringMember")) continue;
+		if (xa->has_children)
 			geom = (LWGEOM*)lwmline_add_lwline((LWMLINE*)geom,
 			                                   (LWLINE*)parse_gml(xa->children, hasz, root_srid));
 	}
@@ -1550,13 +1734,13 @@ static LWGEOM* parse_gml_mline(xmlNodePtr xnode, bool *hasz, int *root_srid)
 /**
  * Parse GML MultiCurve (3.1.1)
  */
-static LWGEOM* parse_gml_mcurve(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_mcurve(gmlNode *xnode, bool *hasz, int *root_srid)
 {
 	gmlSrs srs;
-	xmlNodePtr xa;
+	gmlNode *xa;
 	LWGEOM *geom = NULL;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
 	parse_gml_srs(xnode, &srs);
 	if (*root_srid == SRID_UNKNOWN && srs.srid != SRID_UNKNOWN)
@@ -1564,17 +1748,16 @@ static LWGEOM* parse_gml_mcurve(xmlNodePtr xnode, bool *hasz, int *root_srid)
 
 	geom = (LWGEOM *)lwcollection_construct_empty(MULTILINETYPE, *root_srid, 1, 0);
 
-	if (xnode->children == NULL) 
+	if (!xnode->has_children)
 		return geom;
 
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
 
 		/* MultiCurve/curveMember */
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "curveMember")) continue;
-		if (xa->children != NULL)
+		if (!xa->is_gml) continue;
+		if (strcmp(xa->name, "curveMember")) continue;
+		if (xa->has_children)
 			geom = (LWGEOM*)lwmline_add_lwline((LWMLINE*)geom,
 			                                   (LWLINE*)parse_gml(xa->children, hasz, root_srid));
 	}
@@ -1586,13 +1769,13 @@ static LWGEOM* parse_gml_mcurve(xmlNodePtr xnode, bool *hasz, int *root_srid)
 /**
  * Parse GML MultiPolygon (2.1.2, 3.1.1)
  */
-static LWGEOM* parse_gml_mpoly(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_mpoly(gmlNode *xnode, bool *hasz, int *root_srid)
 {
 	gmlSrs srs;
-	xmlNodePtr xa;
+	gmlNode *xa;
 	LWGEOM *geom = NULL;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
 	parse_gml_srs(xnode, &srs);
 	if (*root_srid == SRID_UNKNOWN && srs.srid != SRID_UNKNOWN)
@@ -1600,16 +1783,15 @@ static LWGEOM* parse_gml_mpoly(xmlNodePtr xnode, bool *hasz, int *root_srid)
 
 	geom = (LWGEOM *)lwcollection_construct_empty(MULTIPOLYGONTYPE, *root_srid, 1, 0);
 
-	if (xnode->children == NULL) 
+	if (!xnode->has_children)
 		return geom;
 
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
 		/* MultiPolygon/polygonMember */
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "polygonMember")) continue;
-		if (xa->children != NULL)
+		if (!xa->is_gml) continue;
+		if (strcmp(xa->name, "polygonMember")) continue;
+		if (xa->has_children)
 			geom = (LWGEOM*)lwmpoly_add_lwpoly((LWMPOLY*)geom,
 			                                   (LWPOLY*)parse_gml(xa->children, hasz, root_srid));
 	}
@@ -1621,13 +1803,13 @@ static LWGEOM* parse_gml_mpoly(xmlNodePtr xnode, bool *hasz, int *root_srid)
 /**
  * Parse GML MultiSurface (3.1.1)
  */
-static LWGEOM* parse_gml_msurface(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_msurface(gmlNode *xnode, bool *hasz, int *root_srid)
 {
 	gmlSrs srs;
-	xmlNodePtr xa;
+	gmlNode *xa;
 	LWGEOM *geom = NULL;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
 	parse_gml_srs(xnode, &srs);
 	if (*root_srid == SRID_UNKNOWN && srs.srid != SRID_UNKNOWN)
@@ -1635,16 +1817,15 @@ static LWGEOM* parse_gml_msurface(xmlNodePtr xnode, bool *hasz, int *root_srid)
 
 	geom = (LWGEOM *)lwcollection_construct_empty(MULTIPOLYGONTYPE, *root_srid, 1, 0);
 
-	if (xnode->children == NULL) 
+	if (!xnode->has_children)
 		return geom;
 
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
 		/* MultiSurface/surfaceMember */
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "surfaceMember")) continue;
-		if (xa->children != NULL)
+		if (!xa->is_gml) continue;
+		if (strcmp(xa->name, "surfaceMember")) continue;
+		if (xa->has_children)
 			geom = (LWGEOM*)lwmpoly_add_lwpoly((LWMPOLY*)geom,
 			                                   (LWPOLY*)parse_gml(xa->children, hasz, root_srid));
 	}
@@ -1657,14 +1838,14 @@ static LWGEOM* parse_gml_msurface(xmlNodePtr xnode, bool *hasz, int *root_srid)
  * Parse GML PolyhedralSurface (3.1.1)
  * Nota: It's not part of SF-2
  */
-static LWGEOM* parse_gml_psurface(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_psurface(gmlNode *xnode, bool *hasz, int *root_srid)
 {
 	gmlSrs srs;
-	xmlNodePtr xa;
+	gmlNode *xa;
 	bool found = false;
 	LWGEOM *geom = NULL;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
 	parse_gml_srs(xnode, &srs);
 	if (*root_srid == SRID_UNKNOWN && srs.srid != SRID_UNKNOWN)
@@ -1672,15 +1853,14 @@ static LWGEOM* parse_gml_psurface(xmlNodePtr xnode, bool *hasz, int *root_srid)
 
 	geom = (LWGEOM *)lwcollection_construct_empty(POLYHEDRALSURFACETYPE, *root_srid, 1, 0);
 
-	if (xnode->children == NULL) 
+	if (!xnode->has_children)
 		return geom;
 
 	/* Looking for gml:polygonPatches */
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (!strcmp((char *) xa->name, "polygonPatches"))
+		if (!xa->is_gml) continue;
+		if (!strcmp(xa->name, "polygonPatches"))
 		{
 			found = true;
 			break;
@@ -1691,9 +1871,8 @@ static LWGEOM* parse_gml_psurface(xmlNodePtr xnode, bool *hasz, int *root_srid)
 	for (xa = xa->children ; xa != NULL ; xa = xa->next)
 	{
 		/* PolyhedralSurface/polygonPatches/PolygonPatch */
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "PolygonPatch")) continue;
+		if (!xa->is_gml) continue;
+		if (strcmp(xa->name, "PolygonPatch")) continue;
 
 		geom = (LWGEOM*)lwpsurface_add_lwpoly((LWPSURFACE*)geom,
 		                                      (LWPOLY*)parse_gml_patch(xa, hasz, root_srid));
@@ -1706,13 +1885,13 @@ static LWGEOM* parse_gml_psurface(xmlNodePtr xnode, bool *hasz, int *root_srid)
 /**
  * Parse GML MultiGeometry (2.1.2, 3.1.1)
  */
-static LWGEOM* parse_gml_coll(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml_coll(gmlNode *xnode, bool *hasz, int *root_srid)
 {
 	gmlSrs srs;
-	xmlNodePtr xa;
+	gmlNode *xa;
 	LWGEOM *geom = NULL;
 
-	if (is_xlink(xnode)) xnode = get_xlink_node(xnode);
+	if (xnode->href) xnode = get_xlink_node(xnode);
 
 	parse_gml_srs(xnode, &srs);
 	if (*root_srid == SRID_UNKNOWN && srs.srid != SRID_UNKNOWN)
@@ -1720,25 +1899,24 @@ static LWGEOM* parse_gml_coll(xmlNodePtr xnode, bool *hasz, int *root_srid)
 
 	geom = (LWGEOM *)lwcollection_construct_empty(COLLECTIONTYPE, *root_srid, 1, 0);
 
-	if (xnode->children == NULL) 
+	if (!xnode->has_children)
 		return geom;
 
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_gml_namespace(xa, false)) continue;
+		if (!xa->is_gml) continue;
 
 		/*
 		 * In GML 2.1.2 pointMember, lineStringMember and
 		 * polygonMember are parts of geometryMember
 		 * substitution group
 		 */
-		if (	   !strcmp((char *) xa->name, "pointMember")
-		        || !strcmp((char *) xa->name, "lineStringMember")
-		        || !strcmp((char *) xa->name, "polygonMember")
-		        || !strcmp((char *) xa->name, "geometryMember"))
+		if (	   !strcmp(xa->name, "pointMember")
+		        || !strcmp(xa->name, "lineStringMember")
+		        || !strcmp(xa->name, "polygonMember")
+		        || !strcmp(xa->name, "geometryMember"))
 		{
-			if (xa->children == NULL) break;
+			if (!xa->has_children) break;
 			geom = (LWGEOM*)lwcollection_add_lwgeom((LWCOLLECTION *)geom,
 			                                        parse_gml(xa->children, hasz, root_srid));
 		}
@@ -1752,50 +1930,56 @@ static LWGEOM* parse_gml_coll(xmlNodePtr xnode, bool *hasz, int *root_srid)
  */
 static LWGEOM* lwgeom_from_gml(const char* xml)
 {
-	xmlDocPtr xmldoc;
-	xmlNodePtr xmlroot=NULL;
+	xmlSAXHandler sax;
+	gmlParser parser;
 	int xml_size = strlen(xml);
 	LWGEOM *lwgeom;
 	bool hasz=true;
 	int root_srid=SRID_UNKNOWN;
+	int ret;
+
+	memset(&sax, 0, sizeof(xmlSAXHandler));
+	sax.initialized = XML_SAX2_MAGIC;
+	sax.startElementNs = gml_sax_start;
+	sax.endElementNs = gml_sax_end;
+	sax.characters = gml_sax_characters;
+	sax.ignorableWhitespace = gml_sax_characters;
+	sax.cdataBlock = gml_sax_characters;
+	sax.comment = gml_sax_comment;
+	sax.processingInstruction = gml_sax_pi;
+	sax.serror = gml_sax_error;
+
+	memset(&parser, 0, sizeof(gmlParser));
+	parser.xml_size = xml_size;
 
 	/* Begin to Parse XML doc */
 	xmlInitParser();
-	xmldoc = xmlParseMemory(xml, xml_size);
-	if (!xmldoc || (xmlroot = xmlDocGetRootElement(xmldoc)) == NULL)
+	ret = xmlSAXUserParseMemory(&sax, &parser, xml, xml_size);
+	xmlCleanupParser();
+
+	if (ret != 0 || parser.root == NULL)
 	{
-		xmlFreeDoc(xmldoc);
-		xmlCleanupParser();
+		gml_free_node(parser.root);
 		gml_lwerror("invalid GML representation", 1);
 	}
 
+	gml_share_links(parser.root, parser.root);
+	lwgeom = parse_gml(parser.root, &hasz, &root_srid);
+	gml_free_node(parser.root);
 
-	lwgeom = parse_gml(xmlroot, &hasz, &root_srid);
-
-	xmlFreeDoc(xmldoc);
-	xmlCleanupParser();
-	/* shouldn't we be releasing xmldoc too here ? */
-
-
-	if ( root_srid != SRID_UNKNOWN ) 
+	if ( root_srid != SRID_UNKNOWN )
 		lwgeom->srid = root_srid;
 
-	/* Should we really do this here ? */
-	lwgeom_add_bbox(lwgeom);
-
 	/* GML geometries could be either 2 or 3D and can be nested mixed.
 	 * Missing Z dimension is even tolerated inside some GML coords
 	 *
-	 * So we deal with 3D in all structures allocation, and flag hasz
-	 * to false if we met once a missing Z dimension
+	 * So we flag hasz to false if we met once a missing Z dimension
 	 * In this case, we force recursive 2D.
 	 */
-	if (!hasz)
-	{
-		LWGEOM *tmp = lwgeom_force_2d(lwgeom);
-		lwgeom_free(lwgeom);
-		lwgeom = tmp;
-	}
+	if (!hasz) gml_lwgeom_force_2d(lwgeom);
+
+	/* Should we really do this here ? */
+	lwgeom_add_bbox(lwgeom);
 
 	return lwgeom;
 }
@@ -1804,13 +1988,12 @@ static LWGEOM* lwgeom_from_gml(const char* xml)
 /**
  * Parse GML
  */
-static LWGEOM* parse_gml(xmlNodePtr xnode, bool *hasz, int *root_srid)
+static LWGEOM* parse_gml(gmlNode *xnode, bool *hasz, int *root_srid)
 {
-	xmlNodePtr xa = xnode;
+	gmlNode *xa = xnode;
 	gmlSrs srs;
 
-	while (xa != NULL && (xa->type != XML_ELEMENT_NODE
-	                      || !is_gml_namespace(xa, false))) xa = xa->next;
+	while (xa != NULL && !xa->is_gml) xa = xa->next;
 
 	if (xa == NULL) gml_lwerror("invalid GML representation", 55);
 
@@ -1820,50 +2003,50 @@ static LWGEOM* parse_gml(xmlNodePtr xnode, bool *hasz, int *root_srid)
 		*root_srid = srs.srid;
 	}
 
-	if (!strcmp((char *) xa->name, "Point"))
+	if (!strcmp(xa->name, "Point"))
 		return parse_gml_point(xa, hasz, root_srid);
 
-	if (!strcmp((char *) xa->name, "LineString"))
+	if (!strcmp(xa->name, "LineString"))
 		return parse_gml_line(xa, hasz, root_srid);
 
-	if (!strcmp((char *) xa->name, "Curve"))
+	if (!strcmp(xa->name, "Curve"))
 		return parse_gml_curve(xa, hasz, root_srid);
 
-	if (!strcmp((char *) xa->name, "LinearRing"))
+	if (!strcmp(xa->name, "LinearRing"))
 		return parse_gml_linearring(xa, hasz, root_srid);
 
-	if (!strcmp((char *) xa->name, "Polygon"))
+	if (!strcmp(xa->name, "Polygon"))
 		return parse_gml_polygon(xa, hasz, root_srid);
 
-	if (!strcmp((char *) xa->name, "Triangle"))
+	if (!strcmp(xa->name, "Triangle"))
 		return parse_gml_triangle(xa, hasz, root_srid);
 
-	if (!strcmp((char *) xa->name, "Surface"))
+	if (!strcmp(xa->name, "Surface"))
 		return parse_gml_surface(xa, hasz, root_srid);
 
-	if (!strcmp((char *) xa->name, "MultiPoint"))
+	if (!strcmp(xa->name, "MultiPoint"))
 		return parse_gml_mpoint(xa, hasz, root_srid);
 
-	if (!strcmp((char *) xa->name, "MultiLineString"))
+	if (!strcmp(xa->name, "MultiLineString"))
 		return parse_gml_mline(xa, hasz, root_srid);
 
-	if (!strcmp((char *) xa->name, "MultiCurve"))
+	if (!strcmp(xa->name, "MultiCurve"))
 		return parse_gml_mcurve(xa, hasz, root_srid);
 
-	if (!strcmp((char *) xa->name, "MultiPolygon"))
+	if (!strcmp(xa->name, "MultiPolygon"))
 		return parse_gml_mpoly(xa, hasz, root_srid);
 
-	if (!strcmp((char *) xa->name, "MultiSurface"))
+	if (!strcmp(xa->name, "MultiSurface"))
 		return parse_gml_msurface(xa, hasz, root_srid);
 
-	if (!strcmp((char *) xa->name, "PolyhedralSurface"))
+	if (!strcmp(xa->name, "PolyhedralSurface"))
 		return parse_gml_psurface(xa, hasz, root_srid);
 
-	if ((!strcmp((char *) xa->name, "Tin")) ||
-	        !strcmp((char *) xa->name, "TriangulatedSurface" ))
+	if ((!strcmp(xa->name, "Tin")) ||
+	        !strcmp(xa->name, "TriangulatedSurface" ))
 		return parse_gml_tin(xa, hasz, root_srid);
 
-	if (!strcmp((char *) xa->name, "MultiGeometry"))
+	if (!strcmp(xa->name, "MultiGeometry"))
 		return parse_gml_coll(xa, hasz, root_srid);
 
 	gml_lwerror("invalid GML representation", 56);
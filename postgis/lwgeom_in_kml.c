@@ -22,19 +22,23 @@
 *  - Not support kml:Model geometries
 *  - Don't handle kml:extrude attribute
 *
+* As for GML, the document is read with the libxml2 SAX2 interface:
+* only a skeleton of the elements is kept, and kml:coordinates text
+* is converted to doubles while streaming, into the point arrays
+* the geometry is then built with.
+*
 * Written by Olivier Courtin - Oslandia
 *
 **********************************************************************/
 
 
-#include <libxml/tree.h>
 #include <libxml/parser.h>
 
 #include "postgres.h"
 
 #include "../postgis_config.h"
 #include "lwgeom_pg.h"
-#include "liblwgeom.h"
+#include "liblwgeom_internal.h"
 
 
 
@@ -46,8 +50,47 @@ TODO:
 */
 
 
+/**
+ * Element of the document skeleton built by the SAX reader
+ */
+typedef struct struct_kmlNode
+{
+	char *name;		/* Local name */
+	bool is_kml;		/* False if bound to a non KML namespace */
+	bool ns_in_scope;	/* Any namespace declared on it or above */
+	bool kml_default;	/* KML declared as default namespace */
+	bool has_children;	/* Any child node, text and comments too */
+	POINTARRAY *pa;		/* kml:coordinates only */
+	bool error;		/* kml:coordinates text is invalid */
+	struct struct_kmlNode *parent;
+	struct struct_kmlNode *children;
+	struct struct_kmlNode *last;
+	struct struct_kmlNode *next;
+}
+kmlNode;
+
+/* Longest number text accepted in coordinates */
+#define KML_NUMBER_MAXLEN 64
+
+/**
+ * SAX reader state
+ */
+typedef struct struct_kmlParser
+{
+	kmlNode *root;
+	kmlNode *current;	/* Innermost open element */
+	kmlNode *data_node;	/* kml:coordinates being read */
+	char num[KML_NUMBER_MAXLEN + 1];
+	int numlen;
+	bool after_cs;		/* Coordinate separator met, value expected */
+	double ords[3];
+	int nords;
+}
+kmlParser;
+
 Datum geom_from_kml(PG_FUNCTION_ARGS);
-static LWGEOM* parse_kml(xmlNodePtr xnode, bool *hasz);
+static LWGEOM* lwgeom_from_kml(const char *xml);
+static LWGEOM* parse_kml(kmlNode *xnode, bool *hasz);
 
 #define KML_NS		((char *) "http://www.opengis.net/kml/2.2")
 
@@ -60,293 +103,453 @@ PG_FUNCTION_INFO_V1(geom_from_kml);
 Datum geom_from_kml(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom;
-	LWGEOM *lwgeom, *hlwgeom;
-	xmlDocPtr xmldoc;
+	LWGEOM *lwgeom;
 	text *xml_input;
-	int xml_size;
 	char *xml;
-	bool hasz=true;
-	xmlNodePtr xmlroot=NULL;
 
 
 	/* Get the KML stream */
 	if (PG_ARGISNULL(0)) PG_RETURN_NULL();
 	xml_input = PG_GETARG_TEXT_P(0);
 	xml = text2cstring(xml_input);
-	xml_size = VARSIZE(xml_input) - VARHDRSZ;
 
-	/* Begin to Parse XML doc */
-	xmlInitParser();
-	xmldoc = xmlParseMemory(xml, xml_size);
-	if (!xmldoc || (xmlroot = xmlDocGetRootElement(xmldoc)) == NULL)
+	lwgeom = lwgeom_from_kml(xml);
+
+	geom = geometry_serialize(lwgeom);
+	lwgeom_free(lwgeom);
+
+	PG_RETURN_POINTER(geom);
+}
+
+
+/**
+ * Drop the Z of a POINTARRAY, in place
+ */
+static void kml_ptarray_force_2d(POINTARRAY *pa)
+{
+	POINT2D p;
+	int i;
+
+	if (!FLAGS_GET_Z(pa->flags)) return;
+
+	/* Points only move backward, so none is overwritten before read */
+	for (i=0 ; i < pa->npoints ; i++)
 	{
-		xmlFreeDoc(xmldoc);
-		xmlCleanupParser();
-		lwerror("invalid KML representation");
+		getPoint2d_p(pa, i, &p);
+		memcpy(pa->serialized_pointlist + i * sizeof(POINT2D), &p, sizeof(POINT2D));
 	}
+	pa->maxpoints = pa->maxpoints * sizeof(POINT3DZ) / sizeof(POINT2D);
+	FLAGS_SET_Z(pa->flags, 0);
+}
 
-	lwgeom = parse_kml(xmlroot, &hasz);
 
-	/* Homogenize geometry result if needed */
-	if (lwgeom->type == COLLECTIONTYPE)
+/**
+ * Drop the Z of a whole geometry, in place
+ */
+static void kml_lwgeom_force_2d(LWGEOM *geom)
+{
+	LWCOLLECTION *coll;
+	LWPOLY *poly;
+	int i;
+
+	switch (geom->type)
 	{
-		hlwgeom = lwgeom_homogenize(lwgeom);
-		lwgeom_release(lwgeom);
-		lwgeom = hlwgeom;
+	case POINTTYPE:
+		kml_ptarray_force_2d(((LWPOINT *) geom)->point);
+		break;
+	case LINETYPE:
+		kml_ptarray_force_2d(((LWLINE *) geom)->points);
+		break;
+	case POLYGONTYPE:
+		poly = (LWPOLY *) geom;
+		for (i=0 ; i < poly->nrings ; i++)
+			kml_ptarray_force_2d(poly->rings[i]);
+		break;
+	default:
+		coll = (LWCOLLECTION *) geom;
+		for (i=0 ; i < coll->ngeoms ; i++)
+			kml_lwgeom_force_2d(coll->geoms[i]);
 	}
+	FLAGS_SET_Z(geom->flags, 0);
+}
 
-	lwgeom_add_bbox(lwgeom);
 
-	/* KML geometries could be either 2 or 3D
-	 *
-	 * So we deal with 3D in all structures allocation, and flag hasz
-	 * to false if we met once a missing Z dimension
-	 * In this case, we force recursive 2D.
-	 */
-	if (!hasz)
+/**
+ * Convert a number matching
+ * [-|\+]?[0-9]+(\.)?([0-9]+)?([Ee](\+|-)?[0-9]+)?
+ * Return false if the text is something else
+ */
+static bool kml_number(const char *num, double *d)
+{
+	const char *p = num;
+
+	if (*p == '-' || *p == '+') p++;
+	if (!isdigit(*p)) return false;
+	while (isdigit(*p)) p++;
+	if (*p == '.')
 	{
-		LWGEOM *tmp = lwgeom_force_2d(lwgeom);
-		lwgeom_free(lwgeom);
-		lwgeom = tmp;
+		p++;
+		if (*p && !isdigit(*p)) return false;
+		while (isdigit(*p)) p++;
 	}
+	if (*p == 'e' || *p == 'E')
+	{
+		p++;
+		if (*p == '-' || *p == '+') p++;
+		if (!isdigit(*p)) return false;
+		while (isdigit(*p)) p++;
+	}
+	if (*p) return false;
 
-	geom = geometry_serialize(lwgeom);
-	lwgeom_free(lwgeom);
+	return lwread_double(*num == '+' ? num + 1 : num, d) != NULL;
+}
 
-	xmlFreeDoc(xmldoc);
-	xmlCleanupParser();
 
-	PG_RETURN_POINTER(geom);
+/**
+ * Convert the number text read so far
+ */
+static void kml_data_value(kmlParser *p)
+{
+	double d;
+
+	p->num[p->numlen] = '\0';
+	p->numlen = 0;
+	p->after_cs = false;
+
+	if (!kml_number(p->num, &d))
+	{
+		p->data_node->error = true;
+		return;
+	}
+	if (p->nords < 3) p->ords[p->nords] = d;
+	p->nords++;
 }
 
 
 /**
- * Return false if current element namespace is not a KML one
- * Return true otherwise.
+ * End of a coordinates tuple, append the point read
  */
-static bool is_kml_namespace(xmlNodePtr xnode, bool is_strict)
+static void kml_data_tuple(kmlParser *p)
 {
-	xmlNsPtr *ns, *p;
+	kmlNode *node = p->data_node;
+	POINT4D pt;
 
-	ns = xmlGetNsList(xnode->doc, xnode);
-	/*
-	 * If no namespace is available we could return true anyway
-	 * (because we work only on KML fragment, we don't want to
-	 *  'oblige' to add namespace on the geometry root node)
-	 */
-	if (ns == NULL) return !is_strict;
+	if (p->nords < 2 || p->nords > 3)
+	{
+		node->error = true;
+		return;
+	}
+
+	/* Once a 2D tuple is met the whole geometry ends up 2D,
+	   so Z is no longer kept */
+	if (node->pa == NULL)
+		node->pa = ptarray_construct_empty(p->nords == 3, 0, 8);
+	else if (p->nords == 2)
+		kml_ptarray_force_2d(node->pa);
+
+	pt.x = p->ords[0];
+	pt.y = p->ords[1];
+	pt.z = (p->nords == 3) ? p->ords[2] : 0.0;
+	pt.m = 0.0;
+	ptarray_append_point(node->pa, &pt, LW_FALSE);
+	p->nords = 0;
+}
 
-	for (p=ns ; *p ; p++)
+
+/**
+ * Read one character of kml:coordinates text
+ *
+ * KML coordinates pattern:     x1,y1 x2,y2
+ *                              x1,y1,z1 x2,y2,z2
+ * Whitespaces are allowed between tuples, not inside them.
+ */
+static void kml_data_char(kmlParser *p, char c)
+{
+	if (c == ',')
 	{
-		if ((*p)->href == NULL) continue;
-		if (!strcmp((char *) (*p)->href, KML_NS))
+		if (!p->numlen) p->data_node->error = true;
+		else
 		{
-			if (	(*p)->prefix == NULL ||
-			        !xmlStrcmp(xnode->ns->prefix, (*p)->prefix))
-			{
-
-				xmlFree(ns);
-				return true;
-			}
+			kml_data_value(p);
+			p->after_cs = true;
 		}
+		return;
+	}
+	if (isspace((unsigned char) c))
+	{
+		if (p->numlen)
+		{
+			kml_data_value(p);
+			kml_data_tuple(p);
+		}
+		else if (p->after_cs) p->data_node->error = true;
+		return;
 	}
 
-	xmlFree(ns);
-	return false;
+	if (p->numlen == KML_NUMBER_MAXLEN)
+	{
+		p->data_node->error = true;
+		return;
+	}
+	p->num[p->numlen++] = c;
 }
 
 
-/* Temporarily disabling unused function. */
-#if 0
 /**
- * Retrieve a KML propertie from a node or NULL otherwise
- * Respect namespaces if presents in the node element
+ * End of a kml:coordinates element
  */
-static xmlChar *kmlGetProp(xmlNodePtr xnode, xmlChar *prop)
+static void kml_data_end(kmlParser *p)
 {
-	xmlChar *value;
+	kmlNode *node = p->data_node;
+	POINTARRAY *pa;
 
-	if (!is_kml_namespace(xnode, true))
-		return xmlGetProp(xnode, prop);
+	if (!node->error)
+	{
+		if (p->numlen)
+		{
+			kml_data_value(p);
+			if (!node->error) kml_data_tuple(p);
+		}
+		else if (p->after_cs) node->error = true;
+	}
 
-	value = xmlGetNsProp(xnode, prop, (xmlChar *) KML_NS);
+	/* HasZ, !HasM, no point */
+	if (node->pa == NULL) node->pa = ptarray_construct_empty(1, 0, 1);
 
-	/* In last case try without explicit namespace */
-	if (value == NULL) value = xmlGetNoNsProp(xnode, prop);
+	/* Give back the room left over */
+	pa = node->pa;
+	if (pa->npoints && pa->npoints < pa->maxpoints)
+	{
+		pa->maxpoints = pa->npoints;
+		pa->serialized_pointlist = lwrealloc(pa->serialized_pointlist,
+		                                     ptarray_point_size(pa) * pa->maxpoints);
+	}
 
-	return value;
+	p->data_node = NULL;
 }
-#endif
 
 
 /**
- * Parse a string supposed to be a double
+ * SAX start of element: add it to the skeleton, and begin to read
+ * coordinates if any.
  */
-static double parse_kml_double(char *d, bool space_before, bool space_after)
+static void kml_sax_start(void *ctx, const xmlChar *localname, const xmlChar *prefix,
+                          const xmlChar *URI, int nb_namespaces, const xmlChar **namespaces,
+                          int nb_attributes, int nb_defaulted, const xmlChar **attributes)
 {
-	char *p;
-	int st;
-	enum states
+	kmlParser *p = (kmlParser *) ctx;
+	kmlNode *node, *parent = p->current;
+	int i;
+
+	node = lwalloc(sizeof(kmlNode));
+	memset(node, 0, sizeof(kmlNode));
+	node->name = lwalloc(strlen((char *) localname) + 1);
+	strcpy(node->name, (char *) localname);
+
+	/* Namespaces declared come as prefix/URI pairs */
+	node->ns_in_scope = nb_namespaces > 0 || (parent && parent->ns_in_scope);
+	node->kml_default = parent && parent->kml_default;
+	for (i=0 ; i < nb_namespaces ; i++)
 	{
-		INIT     	= 0,
-		NEED_DIG  	= 1,
-		DIG	  	= 2,
-		NEED_DIG_DEC 	= 3,
-		DIG_DEC 	= 4,
-		EXP	 	= 5,
-		NEED_DIG_EXP 	= 6,
-		DIG_EXP 	= 7,
-		END 		= 8
-	};
+		if (namespaces[2*i] == NULL && namespaces[2*i+1] != NULL
+		        && !strcmp((char *) namespaces[2*i+1], KML_NS))
+			node->kml_default = true;
+	}
 
 	/*
-	 * Double pattern
-	 * [-|\+]?[0-9]+(\.)?([0-9]+)?([Ee](\+|-)?[0-9]+)?
-	 * We could also meet spaces before and/or after
-	 * this pattern upon parameters
+	 * If no namespace is available we could take it as KML anyway
+	 * (because we work only on KML fragment, we don't want to
+	 *  'oblige' to add namespace on the geometry root node)
 	 */
+	node->is_kml = !node->ns_in_scope || node->kml_default
+	               || (prefix && URI && !strcmp((char *) URI, KML_NS));
 
-	if (space_before) while (isspace(*d)) d++;
-	for (st = INIT, p = d ; *p ; p++)
+	node->parent = parent;
+	if (parent)
 	{
-
-		if (isdigit(*p))
-		{
-			if (st == INIT || st == NEED_DIG) 	st = DIG;
-			else if (st == NEED_DIG_DEC) 			st = DIG_DEC;
-			else if (st == NEED_DIG_EXP || st == EXP) 	st = DIG_EXP;
-			else if (st == DIG || st == DIG_DEC || st == DIG_EXP);
-			else lwerror("invalid KML representation");
-		}
-		else if (*p == '.')
-		{
-			if      (st == DIG) 				st = NEED_DIG_DEC;
-			else    lwerror("invalid KML representation");
-		}
-		else if (*p == '-' || *p == '+')
-		{
-			if      (st == INIT) 				st = NEED_DIG;
-			else if (st == EXP) 				st = NEED_DIG_EXP;
-			else    lwerror("invalid KML representation");
-		}
-		else if (*p == 'e' || *p == 'E')
-		{
-			if      (st == DIG || st == DIG_DEC) 		st = EXP;
-			else    lwerror("invalid KML representation");
-		}
-		else if (isspace(*p))
-		{
-			if (!space_after) lwerror("invalid KML representation");
-			if (st == DIG || st == DIG_DEC || st == DIG_EXP)st = END;
-			else if (st == NEED_DIG_DEC)			st = END;
-			else if (st == END);
-			else    lwerror("invalid KML representation");
-		}
-		else  lwerror("invalid KML representation");
+		parent->has_children = true;
+		if (parent->last) parent->last->next = node;
+		else parent->children = node;
+		parent->last = node;
 	}
+	else p->root = node;
+	p->current = node;
 
-	if (st != DIG && st != NEED_DIG_DEC && st != DIG_DEC && st != DIG_EXP && st != END)
-		lwerror("invalid KML representation");
+	/* Text of kml:coordinates descendants belongs to it */
+	if (p->data_node || !node->is_kml || strcmp(node->name, "coordinates")) return;
+
+	p->data_node = node;
+	p->numlen = p->nords = 0;
+	p->after_cs = false;
+}
+
+
+static void kml_sax_end(void *ctx, const xmlChar *localname,
+                        const xmlChar *prefix, const xmlChar *URI)
+{
+	kmlParser *p = (kmlParser *) ctx;
 
-	return atof(d);
+	if (p->current == NULL) return;
+	if (p->current == p->data_node) kml_data_end(p);
+	p->current = p->current->parent;
+}
+
+
+static void kml_sax_characters(void *ctx, const xmlChar *ch, int len)
+{
+	kmlParser *p = (kmlParser *) ctx;
+	int i;
+
+	if (p->current == NULL) return;
+	p->current->has_children = true;
+
+	if (p->data_node == NULL) return;
+	for (i=0 ; i < len && !p->data_node->error ; i++)
+		kml_data_char(p, (char) ch[i]);
+}
+
+
+static void kml_sax_comment(void *ctx, const xmlChar *value)
+{
+	kmlParser *p = (kmlParser *) ctx;
+
+	if (p->current) p->current->has_children = true;
+}
+
+
+static void kml_sax_pi(void *ctx, const xmlChar *target, const xmlChar *data)
+{
+	kml_sax_comment(ctx, data);
+}
+
+
+static void kml_sax_error(void *ctx, xmlErrorPtr error)
+{
+	/* Reported as invalid KML once the parser returns */
 }
 
 
 /**
- * Parse kml:coordinates
+ * Free the skeleton, and the coordinates no geometry took
  */
-static POINTARRAY* parse_kml_coordinates(xmlNodePtr xnode, bool *hasz)
+static void kml_free_node(kmlNode *node)
 {
-	xmlChar *kml_coord;
-	bool digit, found;
-	POINTARRAY *dpa;
-	int kml_dims;
-	char *p, *q;
-	POINT4D pt;
+	kmlNode *child, *next;
 
-	if (xnode == NULL) lwerror("invalid KML representation");
-
-	for (found = false ; xnode != NULL ; xnode = xnode->next)
+	if (node == NULL) return;
+	for (child = node->children ; child != NULL ; child = next)
 	{
-		if (xnode->type != XML_ELEMENT_NODE) continue;
-		if (!is_kml_namespace(xnode, false)) continue;
-		if (strcmp((char *) xnode->name, "coordinates")) continue;
-
-		found = true;
-		break;
+		next = child->next;
+		kml_free_node(child);
 	}
-	if (!found) lwerror("invalid KML representation");
 
-	/* We begin to retrieve coordinates string */
-	kml_coord = xmlNodeGetContent(xnode);
-	p = (char *) kml_coord;
+	if (node->pa) ptarray_free(node->pa);
+	lwfree(node->name);
+	lwfree(node);
+}
 
-	/* KML coordinates pattern:     x1,y1 x2,y2
-	 *                              x1,y1,z1 x2,y2,z2
-	*/
 
-	/* Now we create PointArray from coordinates values */
-	/* HasZ, !HasM, 1pt */
-	dpa = ptarray_construct_empty(1, 0, 1);
+/**
+ * Read KML
+ */
+static LWGEOM* lwgeom_from_kml(const char *xml)
+{
+	xmlSAXHandler sax;
+	kmlParser parser;
+	LWGEOM *lwgeom, *hlwgeom;
+	bool hasz=true;
+	int ret;
 
-	for (q = p, kml_dims=0, digit = false ; *p ; p++)
-	{
+	memset(&sax, 0, sizeof(xmlSAXHandler));
+	sax.initialized = XML_SAX2_MAGIC;
+	sax.startElementNs = kml_sax_start;
+	sax.endElementNs = kml_sax_end;
+	sax.characters = kml_sax_characters;
+	sax.ignorableWhitespace = kml_sax_characters;
+	sax.cdataBlock = kml_sax_characters;
+	sax.comment = kml_sax_comment;
+	sax.processingInstruction = kml_sax_pi;
+	sax.serror = kml_sax_error;
 
-		if (isdigit(*p)) digit = true;  /* One state parser */
+	memset(&parser, 0, sizeof(kmlParser));
 
-		/* Coordinate Separator */
-		if (*p == ',')
-		{
-			*p = '\0';
-			kml_dims++;
+	/* Begin to Parse XML doc */
+	xmlInitParser();
+	ret = xmlSAXUserParseMemory(&sax, &parser, xml, strlen(xml));
+	xmlCleanupParser();
 
-			if (*(p+1) == '\0') lwerror("invalid KML representation");
+	if (ret != 0 || parser.root == NULL)
+	{
+		kml_free_node(parser.root);
+		lwerror("invalid KML representation");
+	}
 
-			if      (kml_dims == 1) pt.x = parse_kml_double(q, true, true);
-			else if (kml_dims == 2) pt.y = parse_kml_double(q, true, true);
-			q = p+1;
+	lwgeom = parse_kml(parser.root, &hasz);
+	kml_free_node(parser.root);
 
-			/* Tuple Separator (or end string) */
-		}
-		else if (digit && (isspace(*p) || *(p+1) == '\0'))
-		{
-			if (isspace(*p)) *p = '\0';
-			kml_dims++;
+	/* KML geometries could be either 2 or 3D
+	 *
+	 * So we flag hasz to false if we met once a missing Z dimension
+	 * In this case, we force recursive 2D.
+	 */
+	if (!hasz) kml_lwgeom_force_2d(lwgeom);
 
-			if (kml_dims < 2 || kml_dims > 3)
-				lwerror("invalid KML representation");
+	/* Homogenize geometry result if needed */
+	if (lwgeom->type == COLLECTIONTYPE)
+	{
+		hlwgeom = lwgeom_homogenize(lwgeom);
+		lwgeom_release(lwgeom);
+		lwgeom = hlwgeom;
+	}
 
-			if (kml_dims == 3)
-				pt.z = parse_kml_double(q, true, true);
-			else
-			{
-				pt.y = parse_kml_double(q, true, true);
-				*hasz = false;
-			}
+	lwgeom_add_bbox(lwgeom);
 
-			ptarray_append_point(dpa, &pt, LW_FALSE);
-			digit = false;
-			q = p+1;
-			kml_dims = 0;
+	return lwgeom;
+}
 
-		}
+
+/**
+ * Take the points read in kml:coordinates
+ */
+static POINTARRAY* parse_kml_coordinates(kmlNode *xnode, bool *hasz)
+{
+	POINTARRAY *pa;
+
+	for ( ; xnode != NULL ; xnode = xnode->next)
+	{
+		if (!xnode->is_kml) continue;
+		if (!strcmp(xnode->name, "coordinates")) break;
 	}
+	if (xnode == NULL || xnode->pa == NULL || xnode->error)
+		lwerror("invalid KML representation");
 
-	xmlFree(kml_coord);
+	pa = xnode->pa;
+	xnode->pa = NULL;
 
-	/* TODO: we shouldn't need to clone here */
-	return ptarray_clone_deep(dpa);
+	if (!FLAGS_GET_Z(pa->flags)) *hasz = false;
+	return pa;
+}
+
+
+/**
+ * Check that a ring has enough points, and is closed
+ */
+static bool kml_ring_is_valid(POINTARRAY *pa, bool hasz)
+{
+	if (pa->npoints < 4) return false;
+	if (hasz && FLAGS_GET_Z(pa->flags)) return ptarray_isclosed3d(pa);
+	return ptarray_isclosed2d(pa);
 }
 
 
 /**
  * Parse KML point
  */
-static LWGEOM* parse_kml_point(xmlNodePtr xnode, bool *hasz)
+static LWGEOM* parse_kml_point(kmlNode *xnode, bool *hasz)
 {
 	POINTARRAY *pa;
 
-	if (xnode->children == NULL) lwerror("invalid KML representation");
+	if (!xnode->has_children) lwerror("invalid KML representation");
 	pa = parse_kml_coordinates(xnode->children, hasz);
 	if (pa->npoints != 1) lwerror("invalid KML representation");
 
@@ -357,11 +560,11 @@ static LWGEOM* parse_kml_point(xmlNodePtr xnode, bool *hasz)
 /**
  * Parse KML lineString
  */
-static LWGEOM* parse_kml_line(xmlNodePtr xnode, bool *hasz)
+static LWGEOM* parse_kml_line(kmlNode *xnode, bool *hasz)
 {
 	POINTARRAY *pa;
 
-	if (xnode->children == NULL) lwerror("invalid KML representation");
+	if (!xnode->has_children) lwerror("invalid KML representation");
 	pa = parse_kml_coordinates(xnode->children, hasz);
 	if (pa->npoints < 2) lwerror("invalid KML representation");
 
@@ -372,33 +575,29 @@ static LWGEOM* parse_kml_line(xmlNodePtr xnode, bool *hasz)
 /**
  * Parse KML Polygon
  */
-static LWGEOM* parse_kml_polygon(xmlNodePtr xnode, bool *hasz)
+static LWGEOM* parse_kml_polygon(kmlNode *xnode, bool *hasz)
 {
-	int ring;
-	xmlNodePtr xa, xb;
+	int i, ring;
+	kmlNode *xa, *xb;
 	POINTARRAY **ppa = NULL;
 
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
 
 		/* Polygon/outerBoundaryIs */
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_kml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "outerBoundaryIs")) continue;
+		if (!xa->is_kml) continue;
+		if (strcmp(xa->name, "outerBoundaryIs")) continue;
 
 		for (xb = xa->children ; xb != NULL ; xb = xb->next)
 		{
 
-			if (xb->type != XML_ELEMENT_NODE) continue;
-			if (!is_kml_namespace(xb, false)) continue;
-			if (strcmp((char *) xb->name, "LinearRing")) continue;
+			if (!xb->is_kml) continue;
+			if (strcmp(xb->name, "LinearRing")) continue;
 
 			ppa = (POINTARRAY**) lwalloc(sizeof(POINTARRAY*));
 			ppa[0] = parse_kml_coordinates(xb->children, hasz);
 
-			if (ppa[0]->npoints < 4
-			        || (!*hasz && !ptarray_isclosed2d(ppa[0]))
-			        ||  (*hasz && !ptarray_isclosed3d(ppa[0])))
+			if (!kml_ring_is_valid(ppa[0], *hasz))
 				lwerror("invalid KML representation");
 		}
 	}
@@ -407,24 +606,20 @@ static LWGEOM* parse_kml_polygon(xmlNodePtr xnode, bool *hasz)
 	{
 
 		/* Polygon/innerBoundaryIs */
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_kml_namespace(xa, false)) continue;
-		if (strcmp((char *) xa->name, "innerBoundaryIs")) continue;
+		if (!xa->is_kml) continue;
+		if (strcmp(xa->name, "innerBoundaryIs")) continue;
 
 		for (xb = xa->children ; xb != NULL ; xb = xb->next)
 		{
 
-			if (xb->type != XML_ELEMENT_NODE) continue;
-			if (!is_kml_namespace(xb, false)) continue;
-			if (strcmp((char *) xb->name, "LinearRing")) continue;
+			if (!xb->is_kml) continue;
+			if (strcmp(xb->name, "LinearRing")) continue;
 
 			ppa = (POINTARRAY**) lwrealloc((POINTARRAY *) ppa,
 			                               sizeof(POINTARRAY*) * (ring + 1));
 			ppa[ring] = parse_kml_coordinates(xb->children, hasz);
 
-			if (ppa[ring]->npoints < 4
-			        || (!*hasz && !ptarray_isclosed2d(ppa[ring]))
-			        ||  (*hasz && !ptarray_isclosed3d(ppa[ring])))
+			if (!kml_ring_is_valid(ppa[ring], *hasz))
 				lwerror("invalid KML representation");
 
 			ring++;
@@ -434,6 +629,13 @@ static LWGEOM* parse_kml_polygon(xmlNodePtr xnode, bool *hasz)
 	/* Exterior Ring is mandatory */
 	if (ppa == NULL || ppa[0] == NULL) lwerror("invalid KML representation");
 
+	/* Rings must share their dimension */
+	if (!*hasz)
+	{
+		for (i=0 ; i < ring ; i++)
+			kml_ptarray_force_2d(ppa[i]);
+	}
+
 	return (LWGEOM *) lwpoly_construct(4326, NULL, ring, ppa);
 }
 
@@ -441,26 +643,25 @@ static LWGEOM* parse_kml_polygon(xmlNodePtr xnode, bool *hasz)
 /**
  * Parse KML MultiGeometry
  */
-static LWGEOM* parse_kml_multi(xmlNodePtr xnode, bool *hasz)
+static LWGEOM* parse_kml_multi(kmlNode *xnode, bool *hasz)
 {
 	LWGEOM *geom;
-	xmlNodePtr xa;
+	kmlNode *xa;
 
 	geom = (LWGEOM *)lwcollection_construct_empty(COLLECTIONTYPE, 4326, 1, 0);
 
 	for (xa = xnode->children ; xa != NULL ; xa = xa->next)
 	{
 
-		if (xa->type != XML_ELEMENT_NODE) continue;
-		if (!is_kml_namespace(xa, false)) continue;
+		if (!xa->is_kml) continue;
 
-		if (	   !strcmp((char *) xa->name, "Point")
-		        || !strcmp((char *) xa->name, "LineString")
-		        || !strcmp((char *) xa->name, "Polygon")
-		        || !strcmp((char *) xa->name, "MultiGeometry"))
+		if (	   !strcmp(xa->name, "Point")
+		        || !strcmp(xa->name, "LineString")
+		        || !strcmp(xa->name, "Polygon")
+		        || !strcmp(xa->name, "MultiGeometry"))
 		{
 
-			if (xa->children == NULL) break;
+			if (!xa->has_children) break;
 			geom = (LWGEOM*)lwcollection_add_lwgeom((LWCOLLECTION*)geom, parse_kml(xa, hasz));
 		}
 	}
@@ -472,25 +673,24 @@ static LWGEOM* parse_kml_multi(xmlNodePtr xnode, bool *hasz)
 /**
  * Parse KML
  */
-static LWGEOM* parse_kml(xmlNodePtr xnode, bool *hasz)
+static LWGEOM* parse_kml(kmlNode *xnode, bool *hasz)
 {
-	xmlNodePtr xa = xnode;
+	kmlNode *xa = xnode;
 
-	while (xa != NULL && (xa->type != XML_ELEMENT_NODE
-	                      || !is_kml_namespace(xa, false))) xa = xa->next;
+	while (xa != NULL && !xa->is_kml) xa = xa->next;
 
 	if (xa == NULL) lwerror("invalid KML representation");
 
-	if (!strcmp((char *) xa->name, "Point"))
+	if (!strcmp(xa->name, "Point"))
 		return parse_kml_point(xa, hasz);
 
-	if (!strcmp((char *) xa->name, "LineString"))
+	if (!strcmp(xa->name, "LineString"))
 		return parse_kml_line(xa, hasz);
 
-	if (!strcmp((char *) xa->name, "Polygon"))
+	if (!strcmp(xa->name, "Polygon"))
 		return parse_kml_polygon(xa, hasz);
 
-	if (!strcmp((char *) xa->name, "MultiGeometry"))
+	if (!strcmp(xa->name, "MultiGeometry"))
 		return parse_kml_multi(xa, hasz);
 
 	lwerror("invalid KML representation");
@@ -13,6 +13,7 @@
 #include "access/itup.h"
 
 #include "fmgr.h"
+#include "utils/array.h"
 #include "utils/elog.h"
 #include "mb/pg_wchar.h"
 # include "lib/stringinfo.h" /* for binary input */
@@ -33,6 +34,9 @@ Datum parse_WKT_lwgeom(PG_FUNCTION_ARGS);
 Datum LWGEOM_recv(PG_FUNCTION_ARGS);
 Datum LWGEOM_send(PG_FUNCTION_ARGS);
 Datum LWGEOM_to_latlon(PG_FUNCTION_ARGS);
+Datum TWKBFromLWGEOM(PG_FUNCTION_ARGS);
+Datum TWKBFromLWGEOMArray(PG_FUNCTION_ARGS);
+Datum LWGEOMFromTWKB(PG_FUNCTION_ARGS);
 
 
 /*
@@ -229,13 +233,11 @@ PG_FUNCTION_INFO_V1(LWGEOM_out);
 Datum LWGEOM_out(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = (GSERIALIZED*)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
-	LWGEOM *lwgeom;
 	char *hexwkb;
 	size_t hexwkb_size;
 
-	lwgeom = lwgeom_from_gserialized(geom);
-	hexwkb = lwgeom_to_hexwkb(lwgeom, WKB_EXTENDED, &hexwkb_size);
-	lwgeom_free(lwgeom);
+	/* Write straight from the serialized form, no LWGEOM needed */
+	hexwkb = gserialized_to_hexwkb(geom, WKB_EXTENDED, &hexwkb_size);
 	
 	PG_RETURN_CSTRING(hexwkb);
 }
@@ -247,7 +249,6 @@ PG_FUNCTION_INFO_V1(LWGEOM_asHEXEWKB);
 Datum LWGEOM_asHEXEWKB(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = (GSERIALIZED*)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
-	LWGEOM *lwgeom;
 	char *hexwkb;
 	size_t hexwkb_size;
 	uint8_t variant = 0;
@@ -272,9 +273,7 @@ Datum LWGEOM_asHEXEWKB(PG_FUNCTION_ARGS)
 	}
 
 	/* Create WKB hex string */
-	lwgeom = lwgeom_from_gserialized(geom);
-	hexwkb = lwgeom_to_hexwkb(lwgeom, variant | WKB_EXTENDED, &hexwkb_size);
-	lwgeom_free(lwgeom);
+	hexwkb = gserialized_to_hexwkb(geom, variant | WKB_EXTENDED, &hexwkb_size);
 	
 	/* Prepare the PgSQL text return type */
 	text_size = hexwkb_size - 1 + VARHDRSZ;
@@ -360,7 +359,6 @@ PG_FUNCTION_INFO_V1(WKBFromLWGEOM);
 Datum WKBFromLWGEOM(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = (GSERIALIZED*)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
-	LWGEOM *lwgeom;
 	uint8_t *wkb;
 	size_t wkb_size;
 	uint8_t variant = 0;
@@ -383,10 +381,8 @@ Datum WKBFromLWGEOM(PG_FUNCTION_ARGS)
 		}
 	}
 
-	/* Create WKB hex string */
-	lwgeom = lwgeom_from_gserialized(geom);
-	wkb = lwgeom_to_wkb(lwgeom, variant | WKB_EXTENDED , &wkb_size);
-	lwgeom_free(lwgeom);
+	/* Create WKB */
+	wkb = gserialized_to_wkb(geom, variant | WKB_EXTENDED , &wkb_size);
 	
 	/* Prepare the PgSQL text return type */
 	result = palloc(wkb_size + VARHDRSZ);
@@ -400,6 +396,176 @@ Datum WKBFromLWGEOM(PG_FUNCTION_ARGS)
 }
 
 
+/*
+ * Read the TWKB output options that follow the geometry arguments:
+ * xy precision, z precision, m precision, with_sizes, with_boxes.
+ */
+static uint8_t twkb_options(FunctionCallInfo fcinfo, int argnum, int8_t *prec_xy, int8_t *prec_z, int8_t *prec_m)
+{
+	uint8_t variant = 0;
+	int32 prec[3] = {0, 0, 0};
+	int i;
+
+	for ( i = 0; i < 3; i++ )
+	{
+		if ( PG_NARGS() > argnum + i && ! PG_ARGISNULL(argnum + i) )
+			prec[i] = PG_GETARG_INT32(argnum + i);
+	}
+
+	if ( prec[0] < -7 || prec[0] > 7 || prec[1] < 0 || prec[1] > 7 || prec[2] < 0 || prec[2] > 7 )
+		elog(ERROR, "TWKB precision must be between -7 and 7 for XY, and between 0 and 7 for Z and M");
+
+	*prec_xy = prec[0];
+	*prec_z = prec[1];
+	*prec_m = prec[2];
+
+	if ( PG_NARGS() > argnum + 3 && ! PG_ARGISNULL(argnum + 3) && PG_GETARG_BOOL(argnum + 3) )
+		variant |= TWKB_SIZE;
+	if ( PG_NARGS() > argnum + 4 && ! PG_ARGISNULL(argnum + 4) && PG_GETARG_BOOL(argnum + 4) )
+		variant |= TWKB_BBOX;
+
+	return variant;
+}
+
+static bytea* twkb_to_bytea(uint8_t *twkb, size_t twkb_size)
+{
+	bytea *result = palloc(twkb_size + VARHDRSZ);
+	memcpy(VARDATA(result), twkb, twkb_size);
+	SET_VARSIZE(result, twkb_size + VARHDRSZ);
+	pfree(twkb);
+	return result;
+}
+
+/*
+ * TWKBFromLWGEOM(lwgeom, [prec, prec_z, prec_m, with_sizes, with_boxes]) --> twkb
+ * The SRID is not carried in the output.
+ */
+PG_FUNCTION_INFO_V1(TWKBFromLWGEOM);
+Datum TWKBFromLWGEOM(PG_FUNCTION_ARGS)
+{
+	GSERIALIZED *geom = (GSERIALIZED*)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
+	LWGEOM *lwgeom;
+	uint8_t *twkb;
+	size_t twkb_size;
+	uint8_t variant;
+	int8_t prec_xy, prec_z, prec_m;
+
+	variant = twkb_options(fcinfo, 1, &prec_xy, &prec_z, &prec_m);
+
+	lwgeom = lwgeom_from_gserialized(geom);
+	twkb = lwgeom_to_twkb(lwgeom, variant, prec_xy, prec_z, prec_m, &twkb_size);
+	lwgeom_free(lwgeom);
+
+	PG_FREE_IF_COPY(geom, 0);
+	PG_RETURN_BYTEA_P(twkb_to_bytea(twkb, twkb_size));
+}
+
+/*
+ * TWKBFromLWGEOMArray(lwgeom[], id[], [prec, prec_z, prec_m, with_sizes, with_boxes]) --> twkb
+ * Writes the geometries as one multi-geometry, or a collection if they are
+ * of mixed types, with the ids as its id list. NULL geometries are skipped
+ * along with their ids.
+ */
+PG_FUNCTION_INFO_V1(TWKBFromLWGEOMArray);
+Datum TWKBFromLWGEOMArray(PG_FUNCTION_ARGS)
+{
+	ArrayType *arr_geoms, *arr_ids;
+	Datum *geom_values, *id_values;
+	bool *geom_nulls, *id_nulls;
+	int num_geoms, num_ids;
+	LWGEOM **lwgeoms;
+	int64_t *idlist;
+	LWCOLLECTION *col;
+	uint8_t outtype = 0;
+	int i, count = 0;
+	int srid = SRID_UNKNOWN;
+	uint8_t *twkb;
+	size_t twkb_size;
+	uint8_t variant;
+	int8_t prec_xy, prec_z, prec_m;
+
+	arr_geoms = PG_GETARG_ARRAYTYPE_P(0);
+	arr_ids = PG_GETARG_ARRAYTYPE_P(1);
+
+	variant = twkb_options(fcinfo, 2, &prec_xy, &prec_z, &prec_m);
+
+	deconstruct_array(arr_geoms, ARR_ELEMTYPE(arr_geoms), -1, false, 'd',
+	                  &geom_values, &geom_nulls, &num_geoms);
+	deconstruct_array(arr_ids, ARR_ELEMTYPE(arr_ids), sizeof(int64), FLOAT8PASSBYVAL, 'd',
+	                  &id_values, &id_nulls, &num_ids);
+
+	if ( num_geoms != num_ids )
+		elog(ERROR, "size of geometry[] (%d) and id[] (%d) do not match", num_geoms, num_ids);
+
+	lwgeoms = palloc(sizeof(LWGEOM*) * Max(num_geoms, 1));
+	idlist = palloc(sizeof(int64_t) * Max(num_geoms, 1));
+
+	for ( i = 0; i < num_geoms; i++ )
+	{
+		GSERIALIZED *geom;
+		uint8_t intype;
+
+		if ( geom_nulls[i] )
+			continue;
+
+		if ( id_nulls[i] )
+			elog(ERROR, "id list must not contain nulls");
+
+		geom = (GSERIALIZED*)PG_DETOAST_DATUM(geom_values[i]);
+		intype = gserialized_get_type(geom);
+		lwgeoms[count] = lwgeom_from_gserialized(geom);
+
+		if ( ! count )
+			srid = lwgeoms[count]->srid;
+		else if ( lwgeoms[count]->srid != srid )
+			elog(ERROR, "Operation on mixed SRID geometries");
+
+		/* Single types of one kind make a multi, anything else a collection */
+		if ( lwtype_is_collection(intype) )
+			outtype = COLLECTIONTYPE;
+		else if ( ! outtype )
+			outtype = lwtype_get_collectiontype(intype);
+		else if ( outtype != lwtype_get_collectiontype(intype) )
+			outtype = COLLECTIONTYPE;
+
+		lwgeom_drop_bbox(lwgeoms[count]);
+		idlist[count] = DatumGetInt64(id_values[i]);
+		count++;
+	}
+
+	if ( ! count )
+		PG_RETURN_NULL();
+
+	col = lwcollection_construct(outtype, srid, NULL, count, lwgeoms);
+	twkb = lwgeom_to_twkb_with_idlist(lwcollection_as_lwgeom(col), idlist, variant,
+	                                  prec_xy, prec_z, prec_m, &twkb_size);
+
+	PG_RETURN_BYTEA_P(twkb_to_bytea(twkb, twkb_size));
+}
+
+/*
+ * LWGEOMFromTWKB(twkb) --> lwgeom
+ */
+PG_FUNCTION_INFO_V1(LWGEOMFromTWKB);
+Datum LWGEOMFromTWKB(PG_FUNCTION_ARGS)
+{
+	bytea *bytea_twkb = (bytea*)PG_GETARG_BYTEA_P(0);
+	GSERIALIZED *geom;
+	LWGEOM *lwgeom;
+	uint8_t *twkb = (uint8_t*)VARDATA(bytea_twkb);
+
+	lwgeom = lwgeom_from_twkb(twkb, VARSIZE(bytea_twkb)-VARHDRSZ, LW_PARSER_CHECK_ALL);
+
+	if ( lwgeom_needs_bbox(lwgeom) )
+		lwgeom_add_bbox(lwgeom);
+
+	geom = geometry_serialize(lwgeom);
+	lwgeom_free(lwgeom);
+	PG_FREE_IF_COPY(bytea_twkb, 0);
+	PG_RETURN_POINTER(geom);
+}
+
+
 /* puts a bbox inside the geometry */
 PG_FUNCTION_INFO_V1(LWGEOM_addBBOX);
 Datum LWGEOM_addBBOX(PG_FUNCTION_ARGS)
@@ -201,13 +201,11 @@ PG_FUNCTION_INFO_V1(LWGEOM_numpoints_linestring);
 Datum LWGEOM_numpoints_linestring(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = (GSERIALIZED *)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
-	LWGEOM *lwgeom = lwgeom_from_gserialized(geom);
 	int count = -1;
 	
-	if ( lwgeom->type == LINETYPE )
-		count = lwgeom_count_vertices(lwgeom);
+	if ( gserialized_get_type(geom) == LINETYPE )
+		count = gserialized_count_vertices(geom);
 
-	lwgeom_free(lwgeom);
 	PG_FREE_IF_COPY(geom, 0);
 
 	/* OGC says this functions is only valid on LINESTRING */
@@ -221,20 +219,9 @@ PG_FUNCTION_INFO_V1(LWGEOM_numgeometries_collection);
 Datum LWGEOM_numgeometries_collection(PG_FUNCTION_ARGS)
 {
 	GSERIALIZED *geom = (GSERIALIZED *)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
-	LWGEOM *lwgeom;
-	int32 ret = 1;
+	int32 ret;
 
-	lwgeom = lwgeom_from_gserialized(geom);
-	if ( lwgeom_is_empty(lwgeom) )
-	{
-		ret = 0;
-	}
-	else if ( lwgeom_is_collection(lwgeom) )
-	{
-		LWCOLLECTION *col = lwgeom_as_lwcollection(lwgeom);
-		ret = col->ngeoms;
-	}
-	lwgeom_free(lwgeom);
+	ret = gserialized_get_ngeoms(geom);
 	PG_FREE_IF_COPY(geom, 0);
 	PG_RETURN_INT32(ret);
 }
@@ -469,17 +456,17 @@ Datum LWGEOM_interiorringn_polygon(PG_FUNCTION_ARGS)
 		PG_RETURN_NULL();
 	}
 	
-	lwgeom = lwgeom_from_gserialized(geom);
-	if( lwgeom_is_empty(lwgeom) )
+	if( gserialized_is_empty(geom) )
 	{
-		lwpoly_free(poly);
 		PG_FREE_IF_COPY(geom, 0);
 		PG_RETURN_NULL();
 	}
 	
+	lwgeom = lwgeom_from_gserialized(geom);
+
 	if ( type == POLYGONTYPE)
 	{
-		poly = lwgeom_as_lwpoly(lwgeom_from_gserialized(geom));
+		poly = lwgeom_as_lwpoly(lwgeom);
 
 		/* Ok, now we have a polygon. Let's see if it has enough holes */
 		if ( wanted_index >= poly->nrings )
@@ -508,7 +495,7 @@ Datum LWGEOM_interiorringn_polygon(PG_FUNCTION_ARGS)
 	}
 	else
 	{
-		curvepoly = lwgeom_as_lwcurvepoly(lwgeom_from_gserialized(geom));
+		curvepoly = lwgeom_as_lwcurvepoly(lwgeom);
 
 		if (wanted_index >= curvepoly->nrings)
 		{
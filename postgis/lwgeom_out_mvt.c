@@ -0,0 +1,379 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+/** @file
+** Mapbox Vector Tile (MVT) layers, written straight into the protobuf
+** wire format. The messages used, from vector_tile.proto version 2:
+**
+**   Tile    { repeated Layer layers = 3; }
+**   Layer   { required uint32 version = 15; required string name = 1;
+**             repeated Feature features = 2; repeated string keys = 3;
+**             repeated Value values = 4; optional uint32 extent = 5; }
+**   Feature { repeated uint32 tags = 2 [packed]; optional GeomType type = 3;
+**             repeated uint32 geometry = 4 [packed]; }
+**   Value   { string string_value = 1; float float_value = 2;
+**             double double_value = 3; uint64 uint_value = 5;
+**             sint64 sint_value = 6; bool bool_value = 7; }
+**
+** Keys are the column names, and values are shared between features
+** through a hash of their encoded form.
+*/
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "access/hash.h"
+#include "access/htup.h"
+#include "catalog/pg_type.h"
+#include "utils/hsearch.h"
+#include "utils/lsyscache.h"
+#include "utils/typcache.h"
+
+#include "../postgis_config.h"
+
+#include "liblwgeom.h"
+#include "bytebuffer.h"
+#include "lwgeom_pg.h"
+#include "lwgeom_out_mvt.h"
+
+Datum LWGEOM_out(PG_FUNCTION_ARGS);
+
+/* Protobuf wire types */
+#define MVT_WIRE_VARINT 0
+#define MVT_WIRE_64BIT 1
+#define MVT_WIRE_BYTES 2
+#define MVT_WIRE_32BIT 5
+
+#define MVT_VERSION 2
+
+/*
+** What we know about each column of the input rows
+*/
+typedef struct
+{
+	Oid typid;
+	Oid typoutput;      /* For values written as strings */
+	int is_geometry;
+	uint32_t key;       /* Index into the layer keys */
+}
+mvt_column;
+
+/*
+** Values are hashed on their encoded Value message
+*/
+typedef struct
+{
+	uint8_t *data;
+	size_t size;
+}
+mvt_value_key;
+
+typedef struct
+{
+	mvt_value_key key;
+	uint32_t index;
+}
+mvt_value_entry;
+
+struct mvt_agg_context
+{
+	char *name;
+	GBOX bounds;
+	uint32_t extent;
+	uint32_t buffer;
+	int ncolumns;         /* Zero until the first row is seen */
+	int geom_column;
+	mvt_column *columns;
+	uint32_t nkeys;
+	uint32_t nvalues;
+	HTAB *value_hash;
+	bytebuffer_t *features; /* Encoded Layer fields */
+	bytebuffer_t *keys;
+	bytebuffer_t *values;
+};
+
+
+static inline void mvt_write_tag(bytebuffer_t *b, uint32_t field, uint32_t wire_type)
+{
+	bytebuffer_append_uvarint(b, (uint64_t)((field << 3) | wire_type));
+}
+
+static void mvt_write_uint(bytebuffer_t *b, uint32_t field, uint64_t val)
+{
+	mvt_write_tag(b, field, MVT_WIRE_VARINT);
+	bytebuffer_append_uvarint(b, val);
+}
+
+static void mvt_write_bytes(bytebuffer_t *b, uint32_t field, const void *data, size_t size)
+{
+	mvt_write_tag(b, field, MVT_WIRE_BYTES);
+	bytebuffer_append_uvarint(b, (uint64_t)size);
+	bytebuffer_append_bulk(b, data, size);
+}
+
+/* Fixed width fields are always little endian */
+static void mvt_write_fixed(bytebuffer_t *b, uint32_t field, uint64_t bits, int nbytes)
+{
+	int i;
+	mvt_write_tag(b, field, nbytes == 8 ? MVT_WIRE_64BIT : MVT_WIRE_32BIT);
+	for ( i = 0; i < nbytes; i++ )
+		bytebuffer_append_byte(b, (uint8_t)(bits >> (8 * i)));
+}
+
+static uint32 mvt_value_hash(const void *key, Size keysize)
+{
+	const mvt_value_key *k = (const mvt_value_key*)key;
+	return DatumGetUInt32(hash_any(k->data, k->size));
+}
+
+static int mvt_value_match(const void *key1, const void *key2, Size keysize)
+{
+	const mvt_value_key *k1 = (const mvt_value_key*)key1;
+	const mvt_value_key *k2 = (const mvt_value_key*)key2;
+	if ( k1->size != k2->size )
+		return 1;
+	return memcmp(k1->data, k2->data, k1->size);
+}
+
+
+mvt_agg_context* mvt_agg_init(const char *name, const GBOX *bounds, uint32_t extent, uint32_t buffer)
+{
+	mvt_agg_context *ctx = palloc0(sizeof(mvt_agg_context));
+	HASHCTL info;
+
+	ctx->name = pstrdup(name);
+	memcpy(&(ctx->bounds), bounds, sizeof(GBOX));
+	ctx->extent = extent;
+	ctx->buffer = buffer;
+	ctx->geom_column = -1;
+	ctx->features = bytebuffer_create();
+	ctx->keys = bytebuffer_create();
+	ctx->values = bytebuffer_create();
+
+	memset(&info, 0, sizeof(info));
+	info.keysize = sizeof(mvt_value_key);
+	info.entrysize = sizeof(mvt_value_entry);
+	info.hash = mvt_value_hash;
+	info.match = mvt_value_match;
+	info.hcxt = CurrentMemoryContext;
+	ctx->value_hash = hash_create("MVT values", 256, &info,
+	                              HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
+
+	return ctx;
+}
+
+/*
+* Work out the columns from the first row: which one is the geometry,
+* and the key each of the others is written under.
+*/
+static void mvt_agg_columns(mvt_agg_context *ctx, TupleDesc tupdesc, MemoryContext aggcontext)
+{
+	int i;
+
+	ctx->ncolumns = tupdesc->natts;
+	ctx->columns = MemoryContextAllocZero(aggcontext, sizeof(mvt_column) * tupdesc->natts);
+
+	for ( i = 0; i < tupdesc->natts; i++ )
+	{
+		Form_pg_attribute att = tupdesc->attrs[i];
+		mvt_column *col = &(ctx->columns[i]);
+		bool isvarlena;
+		FmgrInfo flinfo;
+
+		if ( att->attisdropped )
+			continue;
+
+		col->typid = att->atttypid;
+		getTypeOutputInfo(att->atttypid, &(col->typoutput), &isvarlena);
+
+		/* The first column that prints like a geometry is the geometry */
+		fmgr_info(col->typoutput, &flinfo);
+		if ( ctx->geom_column < 0 && flinfo.fn_addr == LWGEOM_out )
+		{
+			col->is_geometry = LW_TRUE;
+			ctx->geom_column = i;
+			continue;
+		}
+
+		col->key = ctx->nkeys++;
+		mvt_write_bytes(ctx->keys, 3, NameStr(att->attname), strlen(NameStr(att->attname)));
+	}
+
+	if ( ctx->geom_column < 0 )
+		elog(ERROR, "ST_AsMVT: row has no geometry column");
+}
+
+/*
+* Encode a column value as a Value message, and return its index in the
+* layer values, adding it if it is new.
+*/
+static uint32_t mvt_agg_value(mvt_agg_context *ctx, const mvt_column *col, Datum datum, MemoryContext aggcontext)
+{
+	bytebuffer_t *b = bytebuffer_create_with_size(32);
+	mvt_value_key key;
+	mvt_value_entry *entry;
+	bool found;
+
+	switch ( col->typid )
+	{
+	case BOOLOID:
+		mvt_write_uint(b, 7, DatumGetBool(datum) ? 1 : 0);
+		break;
+	case INT2OID:
+	case INT4OID:
+	case INT8OID:
+	{
+		int64 val = (col->typid == INT2OID) ? DatumGetInt16(datum) :
+		            (col->typid == INT4OID) ? DatumGetInt32(datum) : DatumGetInt64(datum);
+		if ( val >= 0 )
+			mvt_write_uint(b, 5, (uint64_t)val);
+		else
+		{
+			mvt_write_tag(b, 6, MVT_WIRE_VARINT);
+			bytebuffer_append_varint(b, val);
+		}
+		break;
+	}
+	case FLOAT4OID:
+	{
+		union { float4 f; uint32 u; } v;
+		v.f = DatumGetFloat4(datum);
+		mvt_write_fixed(b, 2, v.u, 4);
+		break;
+	}
+	case FLOAT8OID:
+	{
+		union { float8 f; uint64 u; } v;
+		v.f = DatumGetFloat8(datum);
+		mvt_write_fixed(b, 3, v.u, 8);
+		break;
+	}
+	default:
+	{
+		char *str = OidOutputFunctionCall(col->typoutput, datum);
+		mvt_write_bytes(b, 1, str, strlen(str));
+		pfree(str);
+	}
+	}
+
+	key.data = b->buf_start;
+	key.size = bytebuffer_getlength(b);
+	entry = (mvt_value_entry*)hash_search(ctx->value_hash, &key, HASH_ENTER, &found);
+	if ( ! found )
+	{
+		/* The key has to outlive this row */
+		entry->key.data = MemoryContextAlloc(aggcontext, key.size);
+		memcpy(entry->key.data, key.data, key.size);
+		entry->index = ctx->nvalues++;
+		mvt_write_bytes(ctx->values, 4, key.data, key.size);
+	}
+
+	bytebuffer_destroy(b);
+	return entry->index;
+}
+
+void mvt_agg_transfn(mvt_agg_context *ctx, HeapTupleHeader rec, MemoryContext aggcontext)
+{
+	TupleDesc tupdesc;
+	HeapTupleData tuple;
+	GSERIALIZED *gser;
+	LWGEOM *lwgeom;
+	uint8_t *geom_mvt;
+	size_t geom_size;
+	uint8_t geom_type;
+	bytebuffer_t *tags, *feature;
+	Datum datum;
+	bool isnull;
+	int i;
+
+	tupdesc = lookup_rowtype_tupdesc(HeapTupleHeaderGetTypeId(rec), HeapTupleHeaderGetTypMod(rec));
+	tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+	ItemPointerSetInvalid(&(tuple.t_self));
+	tuple.t_tableOid = InvalidOid;
+	tuple.t_data = rec;
+
+	if ( ! ctx->ncolumns )
+		mvt_agg_columns(ctx, tupdesc, aggcontext);
+
+	/* No geometry, no feature */
+	datum = heap_getattr(&tuple, ctx->geom_column + 1, tupdesc, &isnull);
+	if ( isnull )
+	{
+		ReleaseTupleDesc(tupdesc);
+		return;
+	}
+
+	gser = (GSERIALIZED*)PG_DETOAST_DATUM(datum);
+	lwgeom = lwgeom_from_gserialized(gser);
+	geom_mvt = lwgeom_to_mvt_geom(lwgeom, &(ctx->bounds), ctx->extent, ctx->buffer, &geom_type, &geom_size);
+	lwgeom_free(lwgeom);
+
+	/* Nothing of it in this tile */
+	if ( ! geom_mvt )
+	{
+		ReleaseTupleDesc(tupdesc);
+		return;
+	}
+
+	tags = bytebuffer_create();
+	for ( i = 0; i < ctx->ncolumns; i++ )
+	{
+		const mvt_column *col = &(ctx->columns[i]);
+
+		if ( col->is_geometry || tupdesc->attrs[i]->attisdropped )
+			continue;
+
+		datum = heap_getattr(&tuple, i + 1, tupdesc, &isnull);
+		if ( isnull )
+			continue;
+
+		bytebuffer_append_uvarint(tags, col->key);
+		bytebuffer_append_uvarint(tags, mvt_agg_value(ctx, col, datum, aggcontext));
+	}
+	ReleaseTupleDesc(tupdesc);
+
+	feature = bytebuffer_create_with_size(bytebuffer_getlength(tags) + geom_size + 16);
+	if ( bytebuffer_getlength(tags) )
+		mvt_write_bytes(feature, 2, tags->buf_start, bytebuffer_getlength(tags));
+	mvt_write_uint(feature, 3, geom_type);
+	mvt_write_bytes(feature, 4, geom_mvt, geom_size);
+	mvt_write_bytes(ctx->features, 2, feature->buf_start, bytebuffer_getlength(feature));
+
+	bytebuffer_destroy(feature);
+	bytebuffer_destroy(tags);
+	lwfree(geom_mvt);
+}
+
+bytea* mvt_agg_finalfn(mvt_agg_context *ctx)
+{
+	bytebuffer_t *layer = bytebuffer_create_with_size(bytebuffer_getlength(ctx->features) +
+	                      bytebuffer_getlength(ctx->keys) + bytebuffer_getlength(ctx->values) + 64);
+	bytebuffer_t *tile = bytebuffer_create_with_size(bytebuffer_getlength(layer) + 16);
+	bytea *result;
+	size_t size;
+
+	mvt_write_uint(layer, 15, MVT_VERSION);
+	mvt_write_bytes(layer, 1, ctx->name, strlen(ctx->name));
+	bytebuffer_append_bytebuffer(layer, ctx->features);
+	bytebuffer_append_bytebuffer(layer, ctx->keys);
+	bytebuffer_append_bytebuffer(layer, ctx->values);
+	mvt_write_uint(layer, 5, ctx->extent);
+
+	mvt_write_bytes(tile, 3, layer->buf_start, bytebuffer_getlength(layer));
+
+	size = bytebuffer_getlength(tile);
+	result = palloc(size + VARHDRSZ);
+	memcpy(VARDATA(result), tile->buf_start, size);
+	SET_VARSIZE(result, size + VARHDRSZ);
+
+	bytebuffer_destroy(tile);
+	bytebuffer_destroy(layer);
+	return result;
+}
@@ -0,0 +1,36 @@
+/**********************************************************************
+ * $Id$
+ *
+ * PostGIS - Spatial Types for PostgreSQL
+ * http://postgis.refractions.net
+ *
+ * This is free software; you can redistribute and/or modify it under
+ * the terms of the GNU General Public Licence. See the COPYING file.
+ *
+ **********************************************************************/
+
+#ifndef _LWGEOM_OUT_MVT_H
+#define _LWGEOM_OUT_MVT_H 1
+
+typedef struct mvt_agg_context mvt_agg_context;
+
+/**
+* Start a vector tile layer. Everything the layer keeps is allocated in
+* the current memory context, so call it in the aggregate context.
+*/
+mvt_agg_context* mvt_agg_init(const char *name, const GBOX *bounds, uint32_t extent, uint32_t buffer);
+
+/**
+* Add one row to the layer as a feature: its first geometry column is
+* the feature geometry and the other non-NULL columns become its tags.
+* Allocations that outlive the call go into aggcontext.
+*/
+void mvt_agg_transfn(mvt_agg_context *ctx, HeapTupleHeader rec, MemoryContext aggcontext);
+
+/**
+* Write the layer out as a tile holding just this layer. Tiles can be
+* concatenated to get a tile with several layers.
+*/
+bytea* mvt_agg_finalfn(mvt_agg_context *ctx);
+
+#endif /* _LWGEOM_OUT_MVT_H */
@@ -231,11 +231,18 @@ CREATE OR REPLACE FUNCTION gidx_out(gidx)
 	AS 'MODULE_PATHNAME','gidx_out'
 	LANGUAGE 'C' IMMUTABLE STRICT; 
 
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION gidx_analyze_nd(internal)
+	RETURNS bool
+	AS 'MODULE_PATHNAME', 'gidx_analyze_nd'
+	LANGUAGE 'C' VOLATILE STRICT;
+
 -- Availability: 1.5.0
 CREATE TYPE gidx (
 	internallength = variable,
 	input = gidx_in,
 	output = gidx_out,
+	analyze = gidx_analyze_nd,
 	storage = plain,
 	alignment = double
 );
@@ -590,6 +597,145 @@ CREATE OPERATOR CLASS gist_geometry_ops_2d
 	FUNCTION        6        geometry_gist_picksplit_2d (internal, internal),
 	FUNCTION        7        geometry_gist_same_2d (geom1 geometry, geom2 geometry, internal);
 
+#if POSTGIS_PGSQL_VERSION >= 92
+-----------------------------------------------------------------------------
+-- SP-GiST 2D GEOMETRY-over-GSERIALIZED (points only)
+-----------------------------------------------------------------------------
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_spgist_config_quad_2d(internal, internal)
+	RETURNS void
+	AS 'MODULE_PATHNAME' ,'gserialized_spgist_config_quad_2d'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_spgist_choose_quad_2d(internal, internal)
+	RETURNS void
+	AS 'MODULE_PATHNAME' ,'gserialized_spgist_choose_quad_2d'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_spgist_picksplit_quad_2d(internal, internal)
+	RETURNS void
+	AS 'MODULE_PATHNAME' ,'gserialized_spgist_picksplit_quad_2d'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_spgist_inner_consistent_quad_2d(internal, internal)
+	RETURNS void
+	AS 'MODULE_PATHNAME' ,'gserialized_spgist_inner_consistent_quad_2d'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_spgist_config_kd_2d(internal, internal)
+	RETURNS void
+	AS 'MODULE_PATHNAME' ,'gserialized_spgist_config_kd_2d'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_spgist_choose_kd_2d(internal, internal)
+	RETURNS void
+	AS 'MODULE_PATHNAME' ,'gserialized_spgist_choose_kd_2d'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_spgist_picksplit_kd_2d(internal, internal)
+	RETURNS void
+	AS 'MODULE_PATHNAME' ,'gserialized_spgist_picksplit_kd_2d'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_spgist_inner_consistent_kd_2d(internal, internal)
+	RETURNS void
+	AS 'MODULE_PATHNAME' ,'gserialized_spgist_inner_consistent_kd_2d'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_spgist_leaf_consistent_2d(internal, internal)
+	RETURNS bool
+	AS 'MODULE_PATHNAME' ,'gserialized_spgist_leaf_consistent_2d'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OPERATOR CLASS spgist_geometry_ops_quad_2d
+	FOR TYPE geometry USING SPGIST AS
+	OPERATOR        3        &&  ,
+	OPERATOR        7        ~	 ,
+	OPERATOR        8        @	 ,
+	FUNCTION        1        geometry_spgist_config_quad_2d(internal, internal),
+	FUNCTION        2        geometry_spgist_choose_quad_2d(internal, internal),
+	FUNCTION        3        geometry_spgist_picksplit_quad_2d(internal, internal),
+	FUNCTION        4        geometry_spgist_inner_consistent_quad_2d(internal, internal),
+	FUNCTION        5        geometry_spgist_leaf_consistent_2d(internal, internal);
+
+-- Availability: 2.0.0
+CREATE OPERATOR CLASS spgist_geometry_ops_kd_2d
+	FOR TYPE geometry USING SPGIST AS
+	OPERATOR        3        &&  ,
+	OPERATOR        7        ~	 ,
+	OPERATOR        8        @	 ,
+	FUNCTION        1        geometry_spgist_config_kd_2d(internal, internal),
+	FUNCTION        2        geometry_spgist_choose_kd_2d(internal, internal),
+	FUNCTION        3        geometry_spgist_picksplit_kd_2d(internal, internal),
+	FUNCTION        4        geometry_spgist_inner_consistent_kd_2d(internal, internal),
+	FUNCTION        5        geometry_spgist_leaf_consistent_2d(internal, internal);
+#endif
+
+#if POSTGIS_PGSQL_VERSION >= 95
+-----------------------------------------------------------------------------
+-- BRIN 2D GEOMETRY-over-GSERIALIZED
+-----------------------------------------------------------------------------
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION overlaps_2d(box2df, geometry)
+	RETURNS boolean
+	AS 'MODULE_PATHNAME' ,'gserialized_overlaps_box2df_geom_2d'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION contains_2d(box2df, geometry)
+	RETURNS boolean
+	AS 'MODULE_PATHNAME' ,'gserialized_contains_box2df_geom_2d'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OPERATOR && (
+	LEFTARG = box2df, RIGHTARG = geometry, PROCEDURE = overlaps_2d
+);
+
+-- Availability: 2.0.0
+CREATE OPERATOR ~ (
+	LEFTARG = box2df, RIGHTARG = geometry, PROCEDURE = contains_2d
+);
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_brin_add_value_2d(internal, internal, internal, internal)
+	RETURNS boolean
+	AS 'MODULE_PATHNAME' ,'gserialized_brin_add_value_2d'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_brin_merge_2d(internal, internal)
+	RETURNS internal
+	AS 'MODULE_PATHNAME' ,'gserialized_brin_merge_2d'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OPERATOR CLASS brin_geometry_inclusion_ops_2d
+	FOR TYPE geometry USING BRIN AS
+	STORAGE box2df,
+	OPERATOR        3        &&  ,
+	OPERATOR        7        ~	 ,
+	OPERATOR        8        @	 ,
+	OPERATOR        3        && (box2df, geometry),
+	OPERATOR        7        ~ (box2df, geometry),
+	FUNCTION        1        brin_inclusion_opcinfo(internal),
+	FUNCTION        2        geometry_brin_add_value_2d(internal, internal, internal, internal),
+	FUNCTION        3        brin_inclusion_consistent(internal, internal, internal),
+	FUNCTION        4        brin_inclusion_union(internal, internal, internal),
+	FUNCTION        11       geometry_brin_merge_2d(internal, internal);
+#endif
+
 
 -----------------------------------------------------------------------------
 -- GiST ND GEOMETRY-over-GSERIALIZED
@@ -642,16 +788,16 @@ CREATE OR REPLACE FUNCTION geometry_gist_decompress_nd(internal)
 	LANGUAGE 'C';
 
 -- Availability: 2.0.0
---CREATE OR REPLACE FUNCTION geometry_gist_selectivity_nd (internal, oid, internal, int4)
---	RETURNS float8
---	AS 'MODULE_PATHNAME', 'geometry_gist_selectivity_nd'
---	LANGUAGE 'C';
+CREATE OR REPLACE FUNCTION geometry_gist_sel_nd (internal, oid, internal, int4)
+	RETURNS float8
+	AS 'MODULE_PATHNAME', 'geometry_gist_sel_nd'
+	LANGUAGE 'C';
 
 -- Availability: 2.0.0
---CREATE OR REPLACE FUNCTION geography_gist_join_selectivity_nd(internal, oid, internal, smallint)
---	RETURNS float8
---	AS 'MODULE_PATHNAME', 'geometry_gist_join_selectivity_nd'
---	LANGUAGE 'C';
+CREATE OR REPLACE FUNCTION geometry_gist_joinsel_nd(internal, oid, internal, smallint)
+	RETURNS float8
+	AS 'MODULE_PATHNAME', 'geometry_gist_joinsel_nd'
+	LANGUAGE 'C';
 
 -- ---------- ---------- ---------- ---------- ---------- ---------- ----------
 -- N-D GEOMETRY Operators
@@ -667,11 +813,30 @@ CREATE OR REPLACE FUNCTION geometry_overlaps_nd(geometry, geometry)
 CREATE OPERATOR &&& (
 	LEFTARG = geometry, RIGHTARG = geometry, PROCEDURE = geometry_overlaps_nd,
 	COMMUTATOR = '&&&'
-	,RESTRICT = contsel, JOIN = contjoinsel
---	,RESTRICT = geometry_gist_selectivity_nd 
---	,JOIN = geometry_gist_join_selectivity_nd
+--	,RESTRICT = contsel, JOIN = contjoinsel
+	,RESTRICT = geometry_gist_sel_nd, JOIN = geometry_gist_joinsel_nd
 );
 
+#if POSTGIS_PGSQL_VERSION >= 91
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_distance_centroid_nd(geometry, geometry)
+	RETURNS float8
+	AS 'MODULE_PATHNAME' ,'gserialized_distance_centroid_nd'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OPERATOR <<->> (
+	LEFTARG = geometry, RIGHTARG = geometry, PROCEDURE = geometry_distance_centroid_nd,
+	COMMUTATOR = '<<->>'
+);
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_gist_distance_nd(internal, geometry, int4)
+	RETURNS float8
+	AS 'MODULE_PATHNAME' ,'gserialized_gist_distance'
+	LANGUAGE 'C';
+#endif
+
 -- Availability: 2.0.0
 CREATE OPERATOR CLASS gist_geometry_ops_nd
 	FOR TYPE geometry USING GIST AS
@@ -680,6 +845,10 @@ CREATE OPERATOR CLASS gist_geometry_ops_nd
 --	OPERATOR        6        ~=	,
 --	OPERATOR        7        ~	,
 --	OPERATOR        8        @	,
+#if POSTGIS_PGSQL_VERSION >= 91
+	OPERATOR        13       <<->> FOR ORDER BY pg_catalog.float_ops,
+	FUNCTION        8        geometry_gist_distance_nd (internal, geometry, int4),
+#endif
 	FUNCTION        1        geometry_gist_consistent_nd (internal, geometry, int4),
 	FUNCTION        2        geometry_gist_union_nd (bytea, internal),
 	FUNCTION        3        geometry_gist_compress_nd (internal),
@@ -688,6 +857,157 @@ CREATE OPERATOR CLASS gist_geometry_ops_nd
 	FUNCTION        6        geometry_gist_picksplit_nd (internal, internal),
 	FUNCTION        7        geometry_gist_same_nd (geometry, geometry, internal);
 
+#if POSTGIS_PGSQL_VERSION >= 95
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION overlaps_nd(gidx, geometry)
+	RETURNS boolean
+	AS 'MODULE_PATHNAME' ,'gserialized_gidx_overlaps'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OPERATOR &&& (
+	LEFTARG = gidx, RIGHTARG = geometry, PROCEDURE = overlaps_nd
+);
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_brin_add_value_nd(internal, internal, internal, internal)
+	RETURNS boolean
+	AS 'MODULE_PATHNAME' ,'gserialized_brin_add_value'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION geometry_brin_merge_nd(internal, internal)
+	RETURNS internal
+	AS 'MODULE_PATHNAME' ,'gserialized_brin_merge'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OPERATOR CLASS brin_geometry_inclusion_ops_nd
+	FOR TYPE geometry USING BRIN AS
+	STORAGE gidx,
+	OPERATOR        3        &&&	,
+	OPERATOR        3        &&& (gidx, geometry),
+	FUNCTION        1        brin_inclusion_opcinfo(internal),
+	FUNCTION        2        geometry_brin_add_value_nd(internal, internal, internal, internal),
+	FUNCTION        3        brin_inclusion_consistent(internal, internal, internal),
+	FUNCTION        4        brin_inclusion_union(internal, internal, internal),
+	FUNCTION        11       geometry_brin_merge_nd(internal, internal);
+#endif
+
+
+-----------------------------------------------------------------------------
+-- GiST SPATIO-TEMPORAL KEYS
+-----------------------------------------------------------------------------
+--
+-- ST_STKey folds a geometry and a timestamp into a single 4-D gidx key,
+-- so that "geom && box AND ts BETWEEN t1 AND t2" is answered by one
+-- descent of a GiST index on ST_STKey(geom, ts) instead of a bitmap
+-- AND of a spatial and a btree index. The three argument forms build
+-- the matching search keys.
+--
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION ST_STKey(geometry, timestamptz)
+	RETURNS gidx
+	AS 'MODULE_PATHNAME', 'gserialized_st_key'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION ST_STKey(geometry, timestamp)
+	RETURNS gidx
+	AS 'MODULE_PATHNAME', 'gserialized_st_key'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION ST_STKey(geometry, timestamptz, timestamptz)
+	RETURNS gidx
+	AS 'MODULE_PATHNAME', 'gserialized_st_key_range'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION ST_STKey(geometry, timestamp, timestamp)
+	RETURNS gidx
+	AS 'MODULE_PATHNAME', 'gserialized_st_key_range'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION gidx_gist_sel_nd (internal, oid, internal, int4)
+	RETURNS float8
+	AS 'MODULE_PATHNAME', 'gidx_gist_sel_nd'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION gidx_gist_joinsel_nd(internal, oid, internal, smallint)
+	RETURNS float8
+	AS 'MODULE_PATHNAME', 'gidx_gist_joinsel_nd'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION overlaps_nd(gidx, gidx)
+	RETURNS boolean
+	AS 'MODULE_PATHNAME' ,'gidx_gidx_overlaps'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OPERATOR &&& (
+	LEFTARG = gidx, RIGHTARG = gidx, PROCEDURE = overlaps_nd,
+	COMMUTATOR = '&&&',
+	RESTRICT = gidx_gist_sel_nd, JOIN = gidx_gist_joinsel_nd
+);
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION gidx_gist_consistent(internal, gidx, int4)
+	RETURNS bool
+	AS 'MODULE_PATHNAME' ,'gidx_gist_consistent'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION gidx_gist_compress(internal)
+	RETURNS internal
+	AS 'MODULE_PATHNAME','gidx_gist_compress'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION gidx_gist_penalty(internal,internal,internal)
+	RETURNS internal
+	AS 'MODULE_PATHNAME' ,'gserialized_gist_penalty'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION gidx_gist_picksplit(internal, internal)
+	RETURNS internal
+	AS 'MODULE_PATHNAME' ,'gserialized_gist_picksplit'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION gidx_gist_union(bytea, internal)
+	RETURNS internal
+	AS 'MODULE_PATHNAME' ,'gserialized_gist_union'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION gidx_gist_same(gidx, gidx, internal)
+	RETURNS internal
+	AS 'MODULE_PATHNAME' ,'gserialized_gist_same'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION gidx_gist_decompress(internal)
+	RETURNS internal
+	AS 'MODULE_PATHNAME' ,'gserialized_gist_decompress'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE OPERATOR CLASS gist_gidx_ops
+	DEFAULT FOR TYPE gidx USING GIST AS
+	OPERATOR        3        &&&	,
+	FUNCTION        1        gidx_gist_consistent (internal, gidx, int4),
+	FUNCTION        2        gidx_gist_union (bytea, internal),
+	FUNCTION        3        gidx_gist_compress (internal),
+	FUNCTION        4        gidx_gist_decompress (internal),
+	FUNCTION        5        gidx_gist_penalty (internal, internal, internal),
+	FUNCTION        6        gidx_gist_picksplit (internal, internal),
+	FUNCTION        7        gidx_gist_same (gidx, gidx, internal);
 
 -----------------------------------------------------------------------------
 -- Affine transforms
@@ -863,10 +1183,21 @@ CREATE OR REPLACE FUNCTION ST_estimated_extent(text,text) RETURNS box2d AS
 	'MODULE_PATHNAME', 'geometry_estimated_extent'
 	LANGUAGE 'C' IMMUTABLE STRICT SECURITY DEFINER;
 
+-----------------------------------------------------------------------
+-- _ST_FIND_EXTENT( <index> )
+-----------------------------------------------------------------------
+-- Extent of the column under a gist_geometry_ops_2d index, read from
+-- the index keys. Equal to ST_Extent over the column.
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION _ST_find_extent(regclass) RETURNS box2d AS
+	'MODULE_PATHNAME', 'geometry_find_extent'
+	LANGUAGE 'C' STABLE STRICT;
+
 -----------------------------------------------------------------------
 -- FIND_EXTENT( <schema name>, <table name>, <column name> )
 -----------------------------------------------------------------------
 -- Availability: 1.2.2
+-- Changed: 2.0.0 reads the extent from a 2D GiST index if there is one
 CREATE OR REPLACE FUNCTION ST_find_extent(text,text,text) RETURNS box2d AS
 $$
 DECLARE
@@ -876,6 +1207,13 @@ DECLARE
 	myrec RECORD;
 
 BEGIN
+	FOR myrec IN SELECT i.indexrelid FROM pg_index i, pg_opclass o, pg_attribute a
+		WHERE i.indrelid = (quote_ident(schemaname) || '.' || quote_ident(tablename))::regclass
+		AND a.attrelid = i.indrelid AND a.attname = columnname
+		AND i.indkey[0] = a.attnum AND i.indisvalid AND i.indpred IS NULL
+		AND o.oid = i.indclass[0] AND o.opcname = 'gist_geometry_ops_2d' LIMIT 1 LOOP
+		return _ST_find_extent(myrec.indexrelid::regclass);
+	END LOOP;
 	FOR myrec IN EXECUTE 'SELECT ST_Extent("' || columnname || '") As extent FROM "' || schemaname || '"."' || tablename || '"' LOOP
 		return myrec.extent;
 	END LOOP;
@@ -888,6 +1226,7 @@ LANGUAGE 'plpgsql' IMMUTABLE STRICT;
 -- FIND_EXTENT( <table name>, <column name> )
 -----------------------------------------------------------------------
 -- Availability: 1.2.2
+-- Changed: 2.0.0 reads the extent from a 2D GiST index if there is one
 CREATE OR REPLACE FUNCTION ST_find_extent(text,text) RETURNS box2d AS
 $$
 DECLARE
@@ -896,6 +1235,13 @@ DECLARE
 	myrec RECORD;
 
 BEGIN
+	FOR myrec IN SELECT i.indexrelid FROM pg_index i, pg_opclass o, pg_attribute a
+		WHERE i.indrelid = quote_ident(tablename)::regclass
+		AND a.attrelid = i.indrelid AND a.attname = columnname
+		AND i.indkey[0] = a.attnum AND i.indisvalid AND i.indpred IS NULL
+		AND o.oid = i.indclass[0] AND o.opcname = 'gist_geometry_ops_2d' LIMIT 1 LOOP
+		return _ST_find_extent(myrec.indexrelid::regclass);
+	END LOOP;
 	FOR myrec IN EXECUTE 'SELECT ST_Extent("' || columnname || '") As extent FROM "' || tablename || '"' LOOP
 		return myrec.extent;
 	END LOOP;
@@ -1228,6 +1574,24 @@ CREATE OR REPLACE FUNCTION ST_GeomFromEWKT(text)
 	AS 'MODULE_PATHNAME','parse_WKT_lwgeom'
 	LANGUAGE 'C' IMMUTABLE STRICT;
 
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION ST_AsTWKB(geom geometry, prec int4 DEFAULT 0, prec_z int4 DEFAULT 0, prec_m int4 DEFAULT 0, with_sizes boolean DEFAULT false, with_boxes boolean DEFAULT false)
+	RETURNS bytea
+	AS 'MODULE_PATHNAME','TWKBFromLWGEOM'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION ST_AsTWKB(geom geometry[], ids bigint[], prec int4 DEFAULT 0, prec_z int4 DEFAULT 0, prec_m int4 DEFAULT 0, with_sizes boolean DEFAULT false, with_boxes boolean DEFAULT false)
+	RETURNS bytea
+	AS 'MODULE_PATHNAME','TWKBFromLWGEOMArray'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION ST_GeomFromTWKB(bytea)
+	RETURNS geometry
+	AS 'MODULE_PATHNAME','LWGEOMFromTWKB'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
 -- Availability: 1.5.0
 CREATE OR REPLACE FUNCTION postgis_cache_bbox()
 	RETURNS trigger
@@ -3115,6 +3479,70 @@ CREATE AGGREGATE ST_MakeLine (
 	FINALFUNC = pgis_geometry_makeline_finalfn
 	);
 
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION pgis_twkb_accum_transfn(pgis_abs, geometry, bigint)
+	RETURNS pgis_abs
+	AS 'MODULE_PATHNAME'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION pgis_twkb_accum_transfn(pgis_abs, geometry, bigint, int4)
+	RETURNS pgis_abs
+	AS 'MODULE_PATHNAME'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION pgis_twkb_accum_finalfn(pgis_abs)
+	RETURNS bytea
+	AS 'MODULE_PATHNAME'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE AGGREGATE ST_AsTWKBAgg(geometry, bigint) (
+	SFUNC = pgis_twkb_accum_transfn,
+	STYPE = pgis_abs,
+	FINALFUNC = pgis_twkb_accum_finalfn
+	);
+
+-- Availability: 2.0.0
+CREATE AGGREGATE ST_AsTWKBAgg(geometry, bigint, int4) (
+	SFUNC = pgis_twkb_accum_transfn,
+	STYPE = pgis_abs,
+	FINALFUNC = pgis_twkb_accum_finalfn
+	);
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION pgis_asmvt_transfn(pgis_abs, text, box2d, anyelement)
+	RETURNS pgis_abs
+	AS 'MODULE_PATHNAME'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION pgis_asmvt_transfn(pgis_abs, text, box2d, int4, int4, anyelement)
+	RETURNS pgis_abs
+	AS 'MODULE_PATHNAME'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE OR REPLACE FUNCTION pgis_asmvt_finalfn(pgis_abs)
+	RETURNS bytea
+	AS 'MODULE_PATHNAME'
+	LANGUAGE 'C';
+
+-- Availability: 2.0.0
+CREATE AGGREGATE ST_AsMVT(text, box2d, anyelement) (
+	SFUNC = pgis_asmvt_transfn,
+	STYPE = pgis_abs,
+	FINALFUNC = pgis_asmvt_finalfn
+	);
+
+-- Availability: 2.0.0
+CREATE AGGREGATE ST_AsMVT(text, box2d, int4, int4, anyelement) (
+	SFUNC = pgis_asmvt_transfn,
+	STYPE = pgis_abs,
+	FINALFUNC = pgis_asmvt_finalfn
+	);
+
 
 
 --------------------------------------------------------------------------------
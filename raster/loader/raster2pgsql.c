@@ -30,6 +30,10 @@
 #include "gdal_vrt.h"
 #include "ogr_srs_api.h"
 #include <assert.h>
+#ifdef _WIN32
+#include <fcntl.h> /* for _O_BINARY */
+#include <io.h> /* for _setmode */
+#endif
 
 /* This is needed by liblwgeom */
 void lwgeom_init_allocators(void) {
@@ -421,6 +425,17 @@ usage() {
 	printf(_(
 		"  -Y  Use COPY statements instead of INSERT statements.\n"
 	));
+	printf(_(
+		"  -B  Output only the tiles as PostgreSQL binary COPY data, for\n"
+		"      piping into psql -c \"COPY <table> (<column>) FROM STDIN\n"
+		"      WITH BINARY\".  No SQL statements are written, so the table\n"
+		"      must exist (see -p).  Cannot be used with -l.\n"
+	));
+	printf(_(
+		"  -j <threads> Number of threads converting tiles of in-db rasters.\n"
+		"      Defaults to 1.  Output order does not depend on the number\n"
+		"      of threads.\n"
+	));
 	printf(_(
 		"  -G  Print the supported GDAL raster formats.\n"
 	));
@@ -618,6 +633,8 @@ init_config(RTLOADERCFG *config) {
 	config->version = 0;
 	config->transaction = 1;
 	config->copy_statements = 0;
+	config->binary_copy = 0;
+	config->threads = 1;
 }
 
 static void
@@ -937,6 +954,74 @@ copy_from_end(STRINGBUFFER *buffer) {
 	return 1;
 }
 
+static int
+copy_binary_int(uint32_t value, int bytes) {
+	uint8_t buf[4];
+	int i = 0;
+
+	/* network byte order */
+	for (i = bytes - 1; i >= 0; i--) {
+		buf[i] = value & 0xFF;
+		value >>= 8;
+	}
+
+	return fwrite(buf, 1, bytes, stdout) == bytes;
+}
+
+static int
+copy_binary_header() {
+	/* signature, flags field and header extension length */
+	if (
+		fwrite("PGCOPY\n\377\r\n\0", 1, 11, stdout) != 11 ||
+		!copy_binary_int(0, 4) ||
+		!copy_binary_int(0, 4)
+	) {
+		rterror(_("copy_binary_header: Could not write binary COPY header"));
+		return 0;
+	}
+
+	return 1;
+}
+
+static int
+copy_binary_tuple(const uint8_t *wkb, uint32_t wkbsize, const char *filename) {
+	uint32_t len = 0;
+
+	/* field count, then length and value of each field */
+	if (
+		!copy_binary_int(filename != NULL ? 2 : 1, 2) ||
+		!copy_binary_int(wkbsize, 4) ||
+		fwrite(wkb, 1, wkbsize, stdout) != wkbsize
+	) {
+		rterror(_("copy_binary_tuple: Could not write binary COPY tuple"));
+		return 0;
+	}
+
+	if (filename != NULL) {
+		len = strlen(filename);
+		if (
+			!copy_binary_int(len, 4) ||
+			fwrite(filename, 1, len, stdout) != len
+		) {
+			rterror(_("copy_binary_tuple: Could not write binary COPY tuple"));
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static int
+copy_binary_end() {
+	/* file trailer is a field count of -1 */
+	if (!copy_binary_int(0xFFFF, 2) || fflush(stdout) != 0) {
+		rterror(_("copy_binary_end: Could not write binary COPY trailer"));
+		return 0;
+	}
+
+	return 1;
+}
+
 static int
 create_index(
 	const char *schema, const char *table, const char *column,
@@ -1386,6 +1471,303 @@ build_overview(int idx, RTLOADERCFG *config, RASTERINFO *info, int ovx, STRINGBU
 	return 1;
 }
 
+/*
+ * Convert a tile to the form written by emit_tile: WKB for binary
+ * COPY, hex WKB otherwise.
+ */
+static void *
+tile_output(RTLOADERCFG *config, rt_raster rast, uint32_t *len) {
+	if (config->binary_copy)
+		return rt_raster_to_wkb(rast, len);
+
+	return rt_raster_to_hexwkb(rast, len);
+}
+
+/*
+ * Output a tile converted by tile_output, either directly as binary
+ * COPY data or through the tileset as INSERT or COPY statements.
+ */
+static int
+emit_tile(
+	int idx, RTLOADERCFG *config,
+	void *data, uint32_t len,
+	STRINGBUFFER *tileset, STRINGBUFFER *buffer
+) {
+	if (config->binary_copy) {
+		return copy_binary_tuple(
+			(const uint8_t *) data, len,
+			(config->file_column ? config->rt_filename[idx] : NULL)
+		);
+	}
+
+	/* add hexwkb to tileset */
+	if (!append_stringbuffer(tileset, (const char *) data))
+		return 0;
+
+	/* flush if tileset gets too big */
+	if (tileset->length > 10) {
+		if (!insert_records(
+			config->schema, config->table, config->raster_column,
+			(config->file_column ? config->rt_filename[idx] : NULL), config->copy_statements,
+			tileset, buffer
+		)) {
+			rterror(_("emit_tile: Could not convert raster tiles into INSERT or COPY statements"));
+			return 0;
+		}
+
+		rtdealloc_stringbuffer(tileset, 0);
+	}
+
+	return 1;
+}
+
+/*
+ * Read one in-db tile of the source dataset through a VRT with
+ * constraints set for just the data required for the tile.
+ */
+static rt_raster
+build_tile(RTLOADERCFG *config, RASTERINFO *info, GDALDatasetH hdsSrc, int xtile, int ytile) {
+	VRTDatasetH hdsDst;
+	VRTSourcedRasterBandH hbandDst;
+	double gt[6] = {0.};
+	rt_raster rast = NULL;
+	int i = 0;
+
+	memcpy(gt, info->gt, sizeof(double) * 6);
+
+	/* compute tile's upper-left corner */
+	GDALApplyGeoTransform(
+		info->gt,
+		xtile * info->tile_size[0], ytile * info->tile_size[1],
+		&(gt[0]), &(gt[3])
+	);
+	/*
+	rtinfo(_("tile (%d, %d) gt = (%f, %f, %f, %f, %f, %f)"),
+		xtile, ytile,
+		gt[0], gt[1], gt[2], gt[3], gt[4], gt[5]
+	);
+	*/
+
+	/* create VRT dataset */
+	hdsDst = VRTCreate(info->tile_size[0], info->tile_size[1]);
+	GDALSetProjection(hdsDst, info->srs);
+	GDALSetGeoTransform(hdsDst, gt);
+
+	/* add bands as simple sources */
+	for (i = 0; i < info->nband_count; i++) {
+		GDALAddBand(hdsDst, info->gdalbandtype[i], NULL);
+		hbandDst = (VRTSourcedRasterBandH) GDALGetRasterBand(hdsDst, i + 1);
+
+		if (info->hasnodata[i])
+			GDALSetRasterNoDataValue(hbandDst, info->nodataval[i]);
+
+		VRTAddSimpleSource(
+			hbandDst, GDALGetRasterBand(hdsSrc, info->nband[i]),
+			xtile * info->tile_size[0], ytile * info->tile_size[1],
+			info->tile_size[0], info->tile_size[1],
+			0, 0,
+			info->tile_size[0], info->tile_size[1],
+			"near", VRT_NODATA_UNSET
+		);
+	}
+
+	/* make sure VRT reflects all changes */
+	VRTFlushCache(hdsDst);
+
+	/* convert VRT dataset to rt_raster */
+	rast = rt_raster_from_gdal_dataset(hdsDst);
+	GDALClose(hdsDst);
+
+	if (rast == NULL) {
+		rterror(_("build_tile: Could not convert VRT dataset to PostGIS raster"));
+		return NULL;
+	}
+
+	/* set srid if provided */
+	rt_raster_set_srid(rast, info->srid);
+
+	return rast;
+}
+
+#ifdef HAVE_PTHREAD
+static void *
+convert_tile_worker(void *arg) {
+	TILEQUEUE *queue = (TILEQUEUE *) arg;
+	GDALDatasetH hdsSrc;
+	rt_raster rast = NULL;
+	void *data = NULL;
+	uint32_t len = 0;
+	int tile = 0;
+
+	/* GDAL dataset handles must not be shared between threads */
+	hdsSrc = GDALOpen(queue->config->rt_file[queue->idx], GA_ReadOnly);
+	if (hdsSrc == NULL) {
+		rterror(_("convert_tile_worker: Could not open raster: %s"), queue->config->rt_file[queue->idx]);
+
+		pthread_mutex_lock(&(queue->lock));
+		queue->error = 1;
+		pthread_cond_broadcast(&(queue->cond));
+		pthread_mutex_unlock(&(queue->lock));
+
+		return NULL;
+	}
+
+	while (1) {
+		pthread_mutex_lock(&(queue->lock));
+
+		/* bound memory use by not running too far ahead of the output */
+		while (
+			!queue->error &&
+			queue->next < queue->count &&
+			queue->next >= queue->written + queue->window
+		) {
+			pthread_cond_wait(&(queue->cond), &(queue->lock));
+		}
+
+		if (queue->error || queue->next >= queue->count) {
+			pthread_mutex_unlock(&(queue->lock));
+			break;
+		}
+
+		tile = queue->next++;
+		pthread_mutex_unlock(&(queue->lock));
+
+		/* tiles are numbered row by row */
+		data = NULL;
+		rast = build_tile(
+			queue->config, queue->info, hdsSrc,
+			tile % queue->ntiles[0], tile / queue->ntiles[0]
+		);
+		if (rast != NULL) {
+			data = tile_output(queue->config, rast, &len);
+			raster_destroy(rast);
+		}
+
+		pthread_mutex_lock(&(queue->lock));
+		if (data == NULL)
+			queue->error = 1;
+		else {
+			queue->slot[tile % queue->window].data = data;
+			queue->slot[tile % queue->window].length = len;
+		}
+		pthread_cond_broadcast(&(queue->cond));
+		pthread_mutex_unlock(&(queue->lock));
+
+		if (data == NULL)
+			break;
+	}
+
+	GDALClose(hdsSrc);
+	return NULL;
+}
+
+/*
+ * Convert the tiles of an in-db raster with config->threads threads.
+ * Tiles are output in the same order as a single thread would.
+ */
+static int
+convert_tiles_parallel(
+	int idx, RTLOADERCFG *config, RASTERINFO *info, int *ntiles,
+	STRINGBUFFER *tileset, STRINGBUFFER *buffer
+) {
+	TILEQUEUE queue;
+	pthread_t *thread = NULL;
+	int nthread = 0;
+	int tile = 0;
+	int i = 0;
+	int rtn = 1;
+
+	queue.idx = idx;
+	queue.config = config;
+	queue.info = info;
+	queue.ntiles[0] = ntiles[0];
+	queue.ntiles[1] = ntiles[1];
+	queue.count = ntiles[0] * ntiles[1];
+	queue.next = 0;
+	queue.written = 0;
+	queue.window = config->threads * TILEWINDOW;
+	queue.error = 0;
+
+	queue.slot = rtalloc(sizeof(TILESLOT) * queue.window);
+	if (queue.slot == NULL) {
+		rterror(_("convert_tiles_parallel: Could not allocate memory for converted tiles"));
+		return 0;
+	}
+	memset(queue.slot, 0, sizeof(TILESLOT) * queue.window);
+
+	thread = rtalloc(sizeof(pthread_t) * config->threads);
+	if (thread == NULL) {
+		rterror(_("convert_tiles_parallel: Could not allocate memory for threads"));
+		rtdealloc(queue.slot);
+		return 0;
+	}
+
+	pthread_mutex_init(&(queue.lock), NULL);
+	pthread_cond_init(&(queue.cond), NULL);
+
+	for (nthread = 0; nthread < config->threads; nthread++) {
+		if (pthread_create(&(thread[nthread]), NULL, convert_tile_worker, &queue) != 0) {
+			rterror(_("convert_tiles_parallel: Could not start thread"));
+
+			pthread_mutex_lock(&(queue.lock));
+			queue.error = 1;
+			pthread_cond_broadcast(&(queue.cond));
+			pthread_mutex_unlock(&(queue.lock));
+
+			rtn = 0;
+			break;
+		}
+	}
+
+	/* output tiles in order as they become available */
+	for (tile = 0; rtn && tile < queue.count; tile++) {
+		TILESLOT *slot = &(queue.slot[tile % queue.window]);
+		void *data = NULL;
+		uint32_t len = 0;
+
+		pthread_mutex_lock(&(queue.lock));
+		while (slot->data == NULL && !queue.error)
+			pthread_cond_wait(&(queue.cond), &(queue.lock));
+
+		data = slot->data;
+		len = slot->length;
+		slot->data = NULL;
+		pthread_mutex_unlock(&(queue.lock));
+
+		if (data == NULL) {
+			rtn = 0;
+			break;
+		}
+
+		rtn = emit_tile(idx, config, data, len, tileset, buffer);
+		rtdealloc(data);
+
+		pthread_mutex_lock(&(queue.lock));
+		queue.written++;
+		if (!rtn)
+			queue.error = 1;
+		pthread_cond_broadcast(&(queue.cond));
+		pthread_mutex_unlock(&(queue.lock));
+	}
+
+	for (i = 0; i < nthread; i++)
+		pthread_join(thread[i], NULL);
+
+	/* tiles converted after an error */
+	for (i = 0; i < queue.window; i++) {
+		if (queue.slot[i].data != NULL)
+			rtdealloc(queue.slot[i].data);
+	}
+
+	pthread_cond_destroy(&(queue.cond));
+	pthread_mutex_destroy(&(queue.lock));
+	rtdealloc(thread);
+	rtdealloc(queue.slot);
+
+	return rtn;
+}
+#endif
+
 static int
 convert_raster(int idx, RTLOADERCFG *config, RASTERINFO *info, STRINGBUFFER *tileset, STRINGBUFFER *buffer) {
 	GDALDatasetH hdsSrc;
@@ -1399,8 +1781,9 @@ convert_raster(int idx, RTLOADERCFG *config, RASTERINFO *info, STRINGBUFFER *til
 	const char* pszProjectionRef = NULL;
 
 	rt_raster rast = NULL;
-	char *hex;
-	uint32_t hexlen = 0;
+	void *data = NULL;
+	uint32_t datalen = 0;
+	int rtn = 0;
 
 	info->srid = config->srid;
 
@@ -1626,124 +2009,65 @@ convert_raster(int idx, RTLOADERCFG *config, RASTERINFO *info, STRINGBUFFER *til
 					}
 				}
 
-				/* convert rt_raster to hexwkb */
-				hex = rt_raster_to_hexwkb(rast, &hexlen);
+				/* convert rt_raster to output form */
+				data = tile_output(config, rast, &datalen);
 				raster_destroy(rast);
 
-				if (hex == NULL) {
-					rterror(_("convert_raster: Could not convert PostGIS raster to hex WKB"));
+				if (data == NULL) {
+					rterror(_("convert_raster: Could not convert PostGIS raster to WKB"));
 					return 0;
 				}
 
-				/* add hexwkb to tileset */
-				append_stringbuffer(tileset, hex);
-
-				rtdealloc(hex);
-
-				/* flush if tileset gets too big */
-				if (tileset->length > 10) {
-					if (!insert_records(
-						config->schema, config->table, config->raster_column,
-						(config->file_column ? config->rt_filename[idx] : NULL), config->copy_statements,
-						tileset, buffer
-					)) {
-						rterror(_("convert_raster: Could not convert raster tiles into INSERT or COPY statements"));
-						return 0;
-					}
+				rtn = emit_tile(idx, config, data, datalen, tileset, buffer);
+				rtdealloc(data);
 
-					rtdealloc_stringbuffer(tileset, 0);
+				if (!rtn) {
+					rterror(_("convert_raster: Could not output raster tile"));
+					return 0;
 				}
 			}
 		}
 	}
+#ifdef HAVE_PTHREAD
+	/* in-db raster, tiles converted in parallel */
+	else if (config->threads > 1 && ntiles[0] * ntiles[1] > 1) {
+		/* each thread opens its own dataset */
+		GDALClose(hdsSrc);
+
+		if (!convert_tiles_parallel(idx, config, info, ntiles, tileset, buffer)) {
+			rterror(_("convert_raster: Could not convert raster tiles"));
+			return 0;
+		}
+	}
+#endif
 	/* in-db raster */
 	else {
-		VRTDatasetH hdsDst;
-		VRTSourcedRasterBandH hbandDst;
-
-		/* each tile is a VRT with constraints set for just the data required for the tile */
 		for (ytile = 0; ytile < ntiles[1]; ytile++) {
 			for (xtile = 0; xtile < ntiles[0]; xtile++) {
-
-				/* compute tile's upper-left corner */
-				GDALApplyGeoTransform(
-					info->gt,
-					xtile * info->tile_size[0], ytile * info->tile_size[1],
-					&(gt[0]), &(gt[3])
-				);
-				/*
-				rtinfo(_("tile (%d, %d) gt = (%f, %f, %f, %f, %f, %f)"),
-					xtile, ytile,
-					gt[0], gt[1], gt[2], gt[3], gt[4], gt[5]
-				);
-				*/
-
-				/* create VRT dataset */
-				hdsDst = VRTCreate(info->tile_size[0], info->tile_size[1]);
-				GDALSetProjection(hdsDst, info->srs);
-				GDALSetGeoTransform(hdsDst, gt);
-
-				/* add bands as simple sources */
-				for (i = 0; i < info->nband_count; i++) {
-					GDALAddBand(hdsDst, info->gdalbandtype[i], NULL);
-					hbandDst = (VRTSourcedRasterBandH) GDALGetRasterBand(hdsDst, i + 1);
-
-					if (info->hasnodata[i])
-						GDALSetRasterNoDataValue(hbandDst, info->nodataval[i]);
-
-					VRTAddSimpleSource(
-						hbandDst, GDALGetRasterBand(hdsSrc, info->nband[i]),
-						xtile * info->tile_size[0], ytile * info->tile_size[1],
-						info->tile_size[0], info->tile_size[1],
-						0, 0,
-						info->tile_size[0], info->tile_size[1],
-						"near", VRT_NODATA_UNSET
-					);
-				}
-
-				/* make sure VRT reflects all changes */
-				VRTFlushCache(hdsDst);
-
-				/* convert VRT dataset to rt_raster */
-				rast = rt_raster_from_gdal_dataset(hdsDst);
+				rast = build_tile(config, info, hdsSrc, xtile, ytile);
 				if (rast == NULL) {
 					rterror(_("convert_raster: Could not convert VRT dataset to PostGIS raster"));
-					GDALClose(hdsDst);
+					GDALClose(hdsSrc);
 					return 0;
 				}
 
-				/* set srid if provided */
-				rt_raster_set_srid(rast, info->srid);
-
-				/* convert rt_raster to hexwkb */
-				hex = rt_raster_to_hexwkb(rast, &hexlen);
+				/* convert rt_raster to output form */
+				data = tile_output(config, rast, &datalen);
 				raster_destroy(rast);
 
-				if (hex == NULL) {
-					rterror(_("convert_raster: Could not convert PostGIS raster to hex WKB"));
-					GDALClose(hdsDst);
+				if (data == NULL) {
+					rterror(_("convert_raster: Could not convert PostGIS raster to WKB"));
+					GDALClose(hdsSrc);
 					return 0;
 				}
 
-				/* add hexwkb to tileset */
-				append_stringbuffer(tileset, hex);
-
-				rtdealloc(hex);
-				GDALClose(hdsDst);
-
-				/* flush if tileset gets too big */
-				if (tileset->length > 10) {
-					if (!insert_records(
-						config->schema, config->table, config->raster_column,
-						(config->file_column ? config->rt_filename[idx] : NULL), config->copy_statements,
-						tileset, buffer
-					)) {
-						rterror(_("convert_raster: Could not convert raster tiles into INSERT or COPY statements"));
-						GDALClose(hdsSrc);
-						return 0;
-					}
+				rtn = emit_tile(idx, config, data, datalen, tileset, buffer);
+				rtdealloc(data);
 
-					rtdealloc_stringbuffer(tileset, 0);
+				if (!rtn) {
+					rterror(_("convert_raster: Could not output raster tile"));
+					GDALClose(hdsSrc);
+					return 0;
 				}
 			}
 		}
@@ -1762,6 +2086,35 @@ process_rasters(RTLOADERCFG *config, STRINGBUFFER *buffer) {
 	assert(config->table != NULL);
 	assert(config->raster_column != NULL);
 
+	/* binary COPY data only, no SQL statements */
+	if (config->binary_copy) {
+		/* register GDAL drivers */
+		GDALAllRegister();
+
+		if (!copy_binary_header())
+			return 0;
+
+		for (i = 0; i < config->rt_file_count; i++) {
+			RASTERINFO rastinfo;
+			STRINGBUFFER tileset;
+
+			fprintf(stderr, _("Processing %d/%d: %s\n"), i + 1, config->rt_file_count, config->rt_file[i]);
+
+			init_rastinfo(&rastinfo);
+			init_stringbuffer(&tileset);
+
+			if (!convert_raster(i, config, &rastinfo, &tileset, buffer)) {
+				rterror(_("process_rasters: Could not process raster: %s"), config->rt_file[i]);
+				rtdealloc_rastinfo(&rastinfo);
+				return 0;
+			}
+
+			rtdealloc_rastinfo(&rastinfo);
+		}
+
+		return copy_binary_end();
+	}
+
 	if (config->transaction) {
 		if (!append_sql_to_buffer(buffer, "BEGIN;")) {
 			rterror(_("process_rasters: Could not add BEGIN statement to string buffer"));
@@ -2357,6 +2710,25 @@ main(int argc, char **argv) {
 		else if (CSEQUAL(argv[i], "-Y")) {
 			config->copy_statements = 1;
 		}
+		/* binary COPY data */
+		else if (CSEQUAL(argv[i], "-B")) {
+			config->binary_copy = 1;
+		}
+		/* tiling threads */
+		else if (CSEQUAL(argv[i], "-j") && i < argc - 1) {
+			config->threads = atoi(argv[++i]);
+			if (config->threads < 1 || config->threads > MAXTHREADS) {
+				rterror(_("Number of threads must be between 1 and %d"), MAXTHREADS);
+				rtdealloc_config(config);
+				exit(1);
+			}
+#ifndef HAVE_PTHREAD
+			if (config->threads > 1) {
+				rtwarn(_("Threads are not available in this build.  Ignoring -j"));
+				config->threads = 1;
+			}
+#endif
+		}
 		/* GDAL formats */
 		else if (CSEQUAL(argv[i], "-G")) {
 			uint32_t drv_count = 0;
@@ -2404,6 +2776,32 @@ main(int argc, char **argv) {
 		}
 	}
 
+	/* binary COPY data can only go to an existing table */
+	if (config->binary_copy) {
+		if (config->overview_count) {
+			rterror(_("Overviews (-l) cannot be created with binary COPY output (-B)"));
+			rtdealloc_config(config);
+			exit(1);
+		}
+
+		if (
+			config->opt == 'd' || config->opt == 'p' ||
+			config->idx || config->maintenance ||
+			config->constraints || config->copy_statements
+		) {
+			rtwarn(_("Only tiles are output with binary COPY output (-B).  Ignoring -d, -p, -I, -M, -C and -Y"));
+		}
+		config->opt = 'a';
+		config->idx = 0;
+		config->maintenance = 0;
+		config->constraints = 0;
+		config->copy_statements = 0;
+
+#ifdef _WIN32
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	}
+
 	/* no files provided */
 	if (!config->rt_file_count) {
 		rterror(_("No raster provided"));
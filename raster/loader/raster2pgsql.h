@@ -43,6 +43,10 @@
 
 #include "../rt_core/rt_api.h"
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
 #define CSEQUAL(a,b) (strcmp(a,b)==0)
 
 /*
@@ -56,6 +60,12 @@
 #define MINOVFACTOR 2
 #define MAXOVFACTOR 1000
 
+/* maximum number of tiling threads */
+#define MAXTHREADS 64
+
+/* converted tiles each thread may run ahead of the output */
+#define TILEWINDOW 4
+
 #define RCSID "$Id$"
 
 typedef struct raster_loader_config {
@@ -138,6 +148,12 @@ typedef struct raster_loader_config {
 	/* use COPY instead of INSERT */
 	int copy_statements;
 
+	/* write binary COPY data instead of SQL, 1 = yes, 0 = no (default) */
+	int binary_copy;
+
+	/* number of threads converting tiles, default is 1 */
+	int threads;
+
 } RTLOADERCFG;
 
 typedef struct rasterinfo_t {
@@ -175,3 +191,37 @@ typedef struct stringbuffer_t {
 	uint32_t length;
 	char **line;
 } STRINGBUFFER;
+
+#ifdef HAVE_PTHREAD
+/* converted tile waiting to be output */
+typedef struct tileslot_t {
+	/* hex WKB string or WKB, NULL if not converted yet */
+	void *data;
+	uint32_t length;
+} TILESLOT;
+
+/* tiles of one raster shared by the tiling threads */
+typedef struct tilequeue_t {
+	int idx;
+	RTLOADERCFG *config;
+	RASTERINFO *info;
+
+	/* number of tiles in x and y */
+	int ntiles[2];
+	int count;
+
+	/* next tile to convert and number of tiles output */
+	int next;
+	int written;
+
+	/* converted tiles, tile n is in slot n % window */
+	int window;
+	TILESLOT *slot;
+
+	/* set when any thread fails */
+	int error;
+
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+} TILEQUEUE;
+#endif
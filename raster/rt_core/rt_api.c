@@ -307,6 +307,29 @@ rt_util_extent_type(const char *name) {
 		return ET_INTERSECTION;
 }
 
+/*
+	overview kernel from c string, OA_END if the name is unknown
+*/
+rt_overviewalg
+rt_util_overview_alg(const char *name) {
+	if (!name || !strlen(name)) return OA_NEAREST;
+
+	if (strcmp(name, "NEARESTNEIGHBOUR") == 0)
+		return OA_NEAREST;
+	else if (strcmp(name, "NEARESTNEIGHBOR") == 0)
+		return OA_NEAREST;
+	else if (strcmp(name, "NEAREST") == 0)
+		return OA_NEAREST;
+	else if (strcmp(name, "MEAN") == 0)
+		return OA_MEAN;
+	else if (strcmp(name, "AVERAGE") == 0)
+		return OA_MEAN;
+	else if (strcmp(name, "MODE") == 0)
+		return OA_MODE;
+
+	return OA_END;
+}
+
 char*
 rt_util_gdal_convert_sr(const char *srs, int proj4) {
 	OGRSpatialReferenceH hsrs;
@@ -1067,6 +1090,7 @@ rt_band_new_inline(
 	band->data.mem = data;
 	band->ownsData = 0;
 	band->isnodata = FALSE;
+	band->summary.valid = FALSE;
 	band->raster = NULL;
 
 	/* properly set nodataval as it may need to be constrained to the data type */
@@ -1126,6 +1150,7 @@ rt_band_new_offline(
 	band->hasnodata = hasnodata;
 	band->nodataval = 0;
 	band->isnodata = FALSE;
+	band->summary.valid = FALSE;
 	band->raster = NULL;
 
 	/* properly set nodataval as it may need to be constrained to the data type */
@@ -1526,6 +1551,7 @@ rt_band_set_hasnodata_flag(rt_band band, int flag) {
 
 
     band->hasnodata = (flag) ? 1 : 0;
+    band->summary.valid = FALSE;
 }
 
 void
@@ -1571,6 +1597,7 @@ rt_band_set_nodata(rt_band band, double val) {
     assert(NULL != band);
 
     pixtype = band->pixtype;
+    band->summary.valid = FALSE;
 
     RASTER_DEBUGF(3, "rt_band_set_nodata: setting nodata value %g with band type %s", val, rt_pixtype_name(pixtype));
 
@@ -1679,6 +1706,49 @@ rt_band_set_nodata(rt_band band, double val) {
     return 0;
 }
 
+/**
+ * Update a valid band summary for one pixel going from oldval to
+ * newval, both as read back from the band.  Counts and extents are
+ * adjusted in place; the summary is only dropped when a pixel holding
+ * the min or max moves inward, as the new extreme is then unknown.
+ *
+ * @param band : the band whose summary to update
+ * @param oldval : the stored pixel value before the write
+ * @param newval : the stored pixel value after the write
+ */
+static void
+rt_band_update_summary(rt_band band, double oldval, double newval) {
+	int oldvalid = !band->hasnodata || FLT_NEQ(oldval, band->nodataval);
+	int newvalid = !band->hasnodata || FLT_NEQ(newval, band->nodataval);
+
+	if (!band->summary.valid)
+		return;
+
+	if (oldvalid) {
+		if (newvalid && FLT_EQ(oldval, newval))
+			return;
+
+		/* removing an extreme value may shrink the range */
+		if (band->summary.count > 1 && (
+			(FLT_EQ(oldval, band->summary.min) && !(newvalid && newval <= band->summary.min)) ||
+			(FLT_EQ(oldval, band->summary.max) && !(newvalid && newval >= band->summary.max))
+		)) {
+			band->summary.valid = FALSE;
+			return;
+		}
+
+		band->summary.count--;
+	}
+
+	if (newvalid) {
+		if (!band->summary.count || newval < band->summary.min)
+			band->summary.min = newval;
+		if (!band->summary.count || newval > band->summary.max)
+			band->summary.max = newval;
+		band->summary.count++;
+	}
+}
+
 /**
  * Set values of multiple pixels.  Unlike rt_band_set_pixel,
  * values in vals are expected to be of the band's pixel type
@@ -1702,6 +1772,9 @@ rt_band_set_pixel_line(
 	int size = 0;
 	uint8_t *data = NULL;
 	uint32_t offset = 0;
+	double *oldvals = NULL;
+	double newval = 0;
+	uint16_t i = 0;
 
 	assert(NULL != band);
 
@@ -1728,6 +1801,25 @@ rt_band_set_pixel_line(
 		return 0;
 	}
 
+	/* keep the old values to update the band summary */
+	if (band->summary.valid && len) {
+		oldvals = rtalloc(sizeof(double) * len);
+		if (NULL == oldvals) {
+			band->summary.valid = FALSE;
+		}
+		else {
+			for (i = 0; i < len; i++) {
+				if (rt_band_get_pixel(band,
+					(offset + i) % band->width, (offset + i) / band->width,
+					&(oldvals[i])
+				) < 0) {
+					band->summary.valid = FALSE;
+					break;
+				}
+			}
+		}
+	}
+
 	switch (pixtype) {
 		case PT_1BB:
 		case PT_2BUI:
@@ -1777,10 +1869,25 @@ rt_band_set_pixel_line(
 		}
 		default: {
 			rterror("rt_band_set_pixel_line: Unknown pixeltype %d", pixtype);
+			if (NULL != oldvals) rtdealloc(oldvals);
 			return 0;
 		}
 	}
 
+	if (NULL != oldvals) {
+		for (i = 0; i < len && band->summary.valid; i++) {
+			if (rt_band_get_pixel(band,
+				(offset + i) % band->width, (offset + i) / band->width,
+				&newval
+			) < 0) {
+				band->summary.valid = FALSE;
+				break;
+			}
+			rt_band_update_summary(band, oldvals[i], newval);
+		}
+		rtdealloc(oldvals);
+	}
+
 #if POSTGIS_DEBUG_LEVEL > 0
 	{
 		double value;
@@ -1819,6 +1926,8 @@ rt_band_set_pixel(
 	float checkvalfloat = 0;
 	double checkvaldouble = 0;
 	double checkval = 0;
+	double oldval = 0;
+	double newval = 0;
 
 	assert(NULL != band);
 
@@ -1849,6 +1958,10 @@ rt_band_set_pixel(
 	data = rt_band_get_data(band);
 	offset = x + (y * band->width);
 
+	/* keep the old value to update the band summary */
+	if (band->summary.valid && rt_band_get_pixel(band, x, y, &oldval) < 0)
+		band->summary.valid = FALSE;
+
 	switch (pixtype) {
 		case PT_1BB: {
 			data[offset] = rt_util_clamp_to_1BB(val);
@@ -1917,6 +2030,13 @@ rt_band_set_pixel(
 		}
 	}
 
+	if (band->summary.valid) {
+		if (rt_band_get_pixel(band, x, y, &newval) < 0)
+			band->summary.valid = FALSE;
+		else
+			rt_band_update_summary(band, oldval, newval);
+	}
+
 	/* If the stored value is different from no data, reset the isnodata flag */
 	if (FLT_NEQ(checkval, band->nodataval)) {
 		band->isnodata = FALSE;
@@ -2115,6 +2235,12 @@ rt_band_check_is_nodata(rt_band band)
         return FALSE;
     }
 
+    /* Answer from the band summary if up to date */
+    if (band->summary.valid) {
+        band->isnodata = (band->summary.count == 0) ? TRUE : FALSE;
+        return band->isnodata;
+    }
+
     if (band->offline && band->data.offline.mem == NULL) {
 			if (rt_band_load_offline_data(band)) {
 				rterror("rt_band_check_is_nodata: Cannot load offline band's data");
@@ -2139,6 +2265,65 @@ rt_band_check_is_nodata(rt_band band)
     return TRUE;
 }
 
+/**
+ * Get the number of pixels that are not NODATA and their min and max
+ * values, computing them if out of date and compute is non-zero.
+ *
+ * @param band : the band to get info from
+ * @param compute : if non-zero, compute the summary if out of date
+ * @param count : output parameter, number of pixels that are not NODATA
+ * @param min : output parameter, min value of pixels that are not NODATA
+ * @param max : output parameter, max value of pixels that are not NODATA
+ *
+ * @return 1 if the summary is available, 0 if out of date and
+ *   compute is zero, -1 on error
+ */
+int
+rt_band_get_summary(rt_band band, int compute,
+	uint32_t *count, double *min, double *max
+) {
+	uint32_t _count = 0;
+	double _min = 0;
+	double _max = 0;
+	double val = 0;
+	int x = 0;
+	int y = 0;
+
+	assert(NULL != band);
+
+	if (!band->summary.valid) {
+		if (!compute)
+			return 0;
+
+		for (y = 0; y < band->height; y++) {
+			for (x = 0; x < band->width; x++) {
+				if (rt_band_get_pixel(band, x, y, &val) < 0) {
+					rterror("rt_band_get_summary: Unable to get pixel value");
+					return -1;
+				}
+				if (band->hasnodata && FLT_EQ(val, band->nodataval))
+					continue;
+
+				if (!_count || val < _min) _min = val;
+				if (!_count || val > _max) _max = val;
+				_count++;
+			}
+		}
+
+		band->summary.count = _count;
+		band->summary.min = _min;
+		band->summary.max = _max;
+		band->summary.valid = TRUE;
+		RASTER_DEBUGF(3, "rt_band_get_summary: count = %u, min = %f, max = %f", _count, _min, _max);
+	}
+
+	if (NULL != count) *count = band->summary.count;
+	if (NULL != min) *min = band->summary.min;
+	if (NULL != max) *max = band->summary.max;
+
+	return 1;
+}
+
 /**
  * Compare clamped value to band's clamped NODATA value.  If unclamped
  * value is exactly unclamped NODATA value, function returns -1.
@@ -4411,6 +4596,7 @@ rt_raster_new(uint16_t width, uint16_t height) {
 
     ret->numBands = 0;
     ret->bands = 0;
+    ret->serialized = NULL;
 
     return ret;
 }
@@ -4677,16 +4863,53 @@ rt_raster_get_num_bands(rt_raster raster) {
     return raster->numBands;
 }
 
+static rt_band rt_raster_deserialize_band(rt_raster rast, int nband);
+
 rt_band
 rt_raster_get_band(rt_raster raster, int n) {
 
 
     assert(NULL != raster);
 
-    if (n >= raster->numBands || n < 0) return 0;
+    if (n >= raster->numBands || n < 0 || NULL == raster->bands) return 0;
+
+    /* Read band from serialized form on first access */
+    if (NULL == raster->bands[n] && NULL != raster->serialized)
+        raster->bands[n] = rt_raster_deserialize_band(raster, n);
+
     return raster->bands[n];
 }
 
+/**
+ * Read any band not yet read from the serialized form, so the band
+ * registry can be reordered.
+ *
+ * @param raster : the raster to materialize bands of
+ *
+ * @return 0 on success, -1 on error
+ */
+static int
+rt_raster_materialize_bands(rt_raster raster) {
+    int i = 0;
+
+    assert(NULL != raster);
+
+    if (NULL == raster->serialized)
+        return 0;
+
+    for (i = 0; i < raster->numBands; ++i) {
+        if (NULL == rt_raster_get_band(raster, i)) {
+            rterror("rt_raster_materialize_bands: Could not read band %d", i);
+            return -1;
+        }
+    }
+
+    /* Band positions no longer map to the serialized form */
+    raster->serialized = NULL;
+
+    return 0;
+}
+
 /**
  * Add band data to a raster.
  *
@@ -4722,6 +4945,10 @@ rt_raster_add_band(rt_raster raster, rt_band band, int index) {
     if (index < 0)
         index = 0;
 
+    /* Inserting shifts bands, so all must be read beforehand */
+    if (rt_raster_materialize_bands(raster) < 0)
+        return -1;
+
     oldbands = raster->bands;
 
     RASTER_DEBUGF(3, "Oldbands at %p", oldbands);
@@ -6339,6 +6566,7 @@ rt_band_from_wkb(uint16_t width, uint16_t height,
 
     band->pixtype = type & BANDTYPE_PIXTYPE_MASK;
     band->offline = BANDTYPE_IS_OFFDB(type) ? 1 : 0;
+    band->summary.valid = FALSE;
     band->hasnodata = BANDTYPE_HAS_NODATA(type) ? 1 : 0;
     band->isnodata = BANDTYPE_IS_NODATA(type) ? 1 : 0;
     band->width = width;
@@ -6589,6 +6817,7 @@ rt_raster_from_wkb(const uint8_t* wkb, uint32_t wkbsize) {
         rterror("rt_raster_from_wkb: Out of memory allocating raster for wkb input");
         return 0;
     }
+    rast->serialized = NULL;
     rast->numBands = read_uint16(&ptr, endian);
     rast->scaleX = read_float64(&ptr, endian);
     rast->scaleY = read_float64(&ptr, endian);
@@ -6723,9 +6952,16 @@ rt_raster_wkb_size(rt_raster raster) {
             raster->numBands);
 
     for (i = 0; i < raster->numBands; ++i) {
-        rt_band band = raster->bands[i];
-        rt_pixtype pixtype = band->pixtype;
-        int pixbytes = rt_pixtype_size(pixtype);
+        rt_band band = rt_raster_get_band(raster, i);
+        rt_pixtype pixtype;
+        int pixbytes;
+
+        if (NULL == band) {
+            rterror("rt_raster_wkb_size: Could not get band %d", i);
+            return 0;
+        }
+        pixtype = band->pixtype;
+        pixbytes = rt_pixtype_size(pixtype);
 
         RASTER_DEBUGF(3, "rt_raster_wkb_size: adding size of band %d", i);
 
@@ -6807,7 +7043,7 @@ rt_raster_to_wkb(rt_raster raster, uint32_t *wkbsize) {
 
     /* Serialize bands now */
     for (i = 0; i < raster->numBands; ++i) {
-        rt_band band = raster->bands[i];
+        rt_band band = rt_raster_get_band(raster, i);
         rt_pixtype pixtype = band->pixtype;
         int pixbytes = rt_pixtype_size(pixtype);
 
@@ -6981,13 +7217,23 @@ rt_raster_serialized_size(rt_raster raster) {
 
     assert(NULL != raster);
 
-    RASTER_DEBUGF(3, "Serialized size with just header:%d - now adding size of %d bands",
+    /* Add space for band summaries */
+    size += raster->numBands * sizeof (struct rt_bandsummary_serialized_t);
+
+    RASTER_DEBUGF(3, "Serialized size with just header and band summaries:%d - now adding size of %d bands",
             size, raster->numBands);
 
     for (i = 0; i < raster->numBands; ++i) {
-        rt_band band = raster->bands[i];
-        rt_pixtype pixtype = band->pixtype;
-        int pixbytes = rt_pixtype_size(pixtype);
+        rt_band band = rt_raster_get_band(raster, i);
+        rt_pixtype pixtype;
+        int pixbytes;
+
+        if (NULL == band) {
+            rterror("rt_raster_serialized_size: Could not get band %d", i);
+            return 0;
+        }
+        pixtype = band->pixtype;
+        pixbytes = rt_pixtype_size(pixtype);
 
         if (pixbytes < 1) {
             rterror("rt_raster_serialized_size: Corrupted band: unknown pixtype");
@@ -7036,6 +7282,10 @@ rt_raster_serialize(rt_raster raster) {
 
     assert(NULL != raster);
 
+    /* Band size computation failed */
+    if (0 == size)
+        return 0;
+
     ret = (uint8_t*) rtalloc(size);
     if (!ret) {
         rterror("rt_raster_serialize: Out of memory allocating %d bytes for serializing a raster",
@@ -7060,7 +7310,7 @@ rt_raster_serialize(rt_raster raster) {
     raster->size = size;
 
     /* Set version */
-    raster->version = 0;
+    raster->version = 1;
 
     /* Copy header */
     memcpy(ptr, raster, sizeof (struct rt_raster_serialized_t));
@@ -7074,9 +7324,27 @@ rt_raster_serialize(rt_raster raster) {
 
     ptr += sizeof (struct rt_raster_serialized_t);
 
+    /* Serialize band summaries, computed for in-db bands if out of date */
+    for (i = 0; i < raster->numBands; ++i) {
+        struct rt_bandsummary_serialized_t summary;
+        rt_band band = rt_raster_get_band(raster, i);
+        assert(NULL != band);
+
+        memset(&summary, 0, sizeof (struct rt_bandsummary_serialized_t));
+        if (
+            rt_band_get_summary(band, !band->offline,
+                &summary.count, &summary.min, &summary.max) > 0
+        ) {
+            summary.flags |= BANDSUMMARY_FLAG_VALID;
+        }
+
+        memcpy(ptr, &summary, sizeof (struct rt_bandsummary_serialized_t));
+        ptr += sizeof (struct rt_bandsummary_serialized_t);
+    }
+
     /* Serialize bands now */
     for (i = 0; i < raster->numBands; ++i) {
-        rt_band band = raster->bands[i];
+        rt_band band = rt_raster_get_band(raster, i);
         assert(NULL != band);
 
         rt_pixtype pixtype = band->pixtype;
@@ -7219,14 +7487,198 @@ rt_raster_serialize(rt_raster raster) {
     return ret;
 }
 
-rt_raster
-rt_raster_deserialize(void* serialized, int header_only) {
-    rt_raster rast = NULL;
+/**
+ * Read one band of a deserialized raster from its serialized form.
+ * Headers of the preceding bands are walked to find the band, their
+ * data is skipped without being read.
+ *
+ * @param rast : raster returned by rt_raster_deserialize
+ * @param nband : the band to read, 0-based
+ *
+ * @return the band, or 0 on error
+ */
+static rt_band
+rt_raster_deserialize_band(rt_raster rast, int nband) {
+    rt_band band = NULL;
     const uint8_t *ptr = NULL;
     const uint8_t *beg = NULL;
-    uint16_t i = 0;
+    uint8_t type = 0;
+    int pixbytes = 0;
+    int i = 0;
     uint8_t littleEndian = isMachineLittleEndian();
 
+    assert(NULL != rast);
+    assert(NULL != rast->serialized);
+    assert(nband >= 0 && nband < rast->numBands);
+
+    beg = rast->serialized;
+
+    /* Move to the beginning of first band */
+    ptr = beg;
+    ptr += sizeof (struct rt_raster_serialized_t);
+    if (rast->version > 0)
+        ptr += rast->numBands * sizeof (struct rt_bandsummary_serialized_t);
+
+    /* Skip preceding bands */
+    for (i = 0; i < nband; ++i) {
+        type = *ptr;
+        pixbytes = rt_pixtype_size(type & BANDTYPE_PIXTYPE_MASK);
+        if (pixbytes < 1) {
+            rterror("rt_raster_deserialize_band: Corrupted band %d: unknown pixtype", i);
+            return 0;
+        }
+
+        /* Band type, data padding and nodata value */
+        ptr += 2 * pixbytes;
+
+        if (BANDTYPE_IS_OFFDB(type)) {
+            /* Band number and null-terminated path */
+            ptr += 1;
+            ptr += strlen((const char *) ptr) + 1;
+        }
+        else {
+            ptr += rast->width * rast->height * pixbytes;
+        }
+
+        /* Padding up to 8-bytes boundary */
+        while (0 != ((ptr - beg) % 8))
+            ++ptr;
+    }
+
+    RASTER_DEBUGF(3, "rt_raster_deserialize_band: band %d at offset %d", nband, ptr - beg);
+
+    band = rtalloc(sizeof (struct rt_band_t));
+    if (!band) {
+        rterror("rt_raster_deserialize_band: Out of memory allocating rt_band during deserialization");
+        return 0;
+    }
+
+    type = *ptr;
+    ptr++;
+    band->pixtype = type & BANDTYPE_PIXTYPE_MASK;
+
+    RASTER_DEBUGF(3, "rt_raster_deserialize_band: band %d with pixel type %s", nband, rt_pixtype_name(band->pixtype));
+
+    band->offline = BANDTYPE_IS_OFFDB(type) ? 1 : 0;
+    band->hasnodata = BANDTYPE_HAS_NODATA(type) ? 1 : 0;
+    band->isnodata = BANDTYPE_IS_NODATA(type) ? 1 : 0;
+    band->width = rast->width;
+    band->height = rast->height;
+    band->ownsData = 0;
+    band->raster = rast;
+
+    /* Band summary, if any */
+    band->summary.valid = FALSE;
+    if (rast->version > 0) {
+        struct rt_bandsummary_serialized_t summary;
+
+        memcpy(&summary,
+            beg + sizeof (struct rt_raster_serialized_t) + nband * sizeof (struct rt_bandsummary_serialized_t),
+            sizeof (struct rt_bandsummary_serialized_t));
+        if (summary.flags & BANDSUMMARY_FLAG_VALID) {
+            band->summary.valid = TRUE;
+            band->summary.count = summary.count;
+            band->summary.min = summary.min;
+            band->summary.max = summary.max;
+        }
+    }
+
+    /* Advance by data padding */
+    pixbytes = rt_pixtype_size(band->pixtype);
+    ptr += pixbytes - 1;
+
+    /* Read nodata value */
+    switch (band->pixtype) {
+        case PT_1BB:
+        {
+            band->nodataval = ((int) read_uint8(&ptr)) & 0x01;
+            break;
+        }
+        case PT_2BUI:
+        {
+            band->nodataval = ((int) read_uint8(&ptr)) & 0x03;
+            break;
+        }
+        case PT_4BUI:
+        {
+            band->nodataval = ((int) read_uint8(&ptr)) & 0x0F;
+            break;
+        }
+        case PT_8BSI:
+        {
+            band->nodataval = read_int8(&ptr);
+            break;
+        }
+        case PT_8BUI:
+        {
+            band->nodataval = read_uint8(&ptr);
+            break;
+        }
+        case PT_16BSI:
+        {
+            band->nodataval = read_int16(&ptr, littleEndian);
+            break;
+        }
+        case PT_16BUI:
+        {
+            band->nodataval = read_uint16(&ptr, littleEndian);
+            break;
+        }
+        case PT_32BSI:
+        {
+            band->nodataval = read_int32(&ptr, littleEndian);
+            break;
+        }
+        case PT_32BUI:
+        {
+            band->nodataval = read_uint32(&ptr, littleEndian);
+            break;
+        }
+        case PT_32BF:
+        {
+            band->nodataval = read_float32(&ptr, littleEndian);
+            break;
+        }
+        case PT_64BF:
+        {
+            band->nodataval = read_float64(&ptr, littleEndian);
+            break;
+        }
+        default:
+        {
+            rterror("rt_raster_deserialize_band: Unknown pixeltype %d", band->pixtype);
+            rtdealloc(band);
+            return 0;
+        }
+    }
+
+    RASTER_DEBUGF(3, "rt_raster_deserialize_band: has nodata flag %d", band->hasnodata);
+    RASTER_DEBUGF(3, "rt_raster_deserialize_band: nodata value %g", band->nodataval);
+
+    /* Consistency checking (ptr is pixbytes-aligned) */
+    assert(!((ptr - beg) % pixbytes));
+
+    if (band->offline) {
+        /* Read band number */
+        band->data.offline.bandNum = *ptr;
+        ptr += 1;
+
+        /* Register path */
+        band->data.offline.path = (char*) ptr;
+
+        band->data.offline.mem = NULL;
+    } else {
+        /* Register data */
+        band->data.mem = (uint8_t*) ptr;
+    }
+
+    return band;
+}
+
+rt_raster
+rt_raster_deserialize(void* serialized, int header_only) {
+    rt_raster rast = NULL;
+
 
 
     assert(NULL != serialized);
@@ -7251,156 +7703,25 @@ rt_raster_deserialize(void* serialized, int header_only) {
     RASTER_DEBUG(3, "rt_raster_deserialize: Deserialize raster header");
     memcpy(rast, serialized, sizeof (struct rt_raster_serialized_t));
 
+    rast->serialized = NULL;
     if (0 == rast->numBands || header_only) {
         rast->bands = 0;
         return rast;
     }
-    beg = (const uint8_t*) serialized;
 
     RASTER_DEBUG(3, "rt_raster_deserialize: Allocating memory for bands");
-    /* Allocate registry of raster bands */
+    /* Allocate registry of raster bands, filled by rt_raster_get_band */
     rast->bands = rtalloc(rast->numBands * sizeof (rt_band));
+    if (!rast->bands) {
+        rterror("rt_raster_deserialize: Out of memory allocating bands for deserialization");
+        rtdealloc(rast);
+        return 0;
+    }
+    memset(rast->bands, 0, rast->numBands * sizeof (rt_band));
 
     RASTER_DEBUGF(3, "rt_raster_deserialize: %d bands", rast->numBands);
 
-    /* Move to the beginning of first band */
-    ptr = beg;
-    ptr += sizeof (struct rt_raster_serialized_t);
-
-    /* Deserialize bands now */
-    for (i = 0; i < rast->numBands; ++i) {
-        rt_band band = NULL;
-        uint8_t type = 0;
-        int pixbytes = 0;
-
-        band = rtalloc(sizeof (struct rt_band_t));
-        if (!band) {
-            rterror("rt_raster_deserialize: Out of memory allocating rt_band during deserialization");
-            return 0;
-        }
-
-        rast->bands[i] = band;
-
-        type = *ptr;
-        ptr++;
-        band->pixtype = type & BANDTYPE_PIXTYPE_MASK;
-
-        RASTER_DEBUGF(3, "rt_raster_deserialize: band %d with pixel type %s", i, rt_pixtype_name(band->pixtype));
-
-        band->offline = BANDTYPE_IS_OFFDB(type) ? 1 : 0;
-        band->hasnodata = BANDTYPE_HAS_NODATA(type) ? 1 : 0;
-        band->isnodata = BANDTYPE_IS_NODATA(type) ? 1 : 0;
-        band->width = rast->width;
-        band->height = rast->height;
-        band->ownsData = 0;
-				band->raster = rast;
-
-        /* Advance by data padding */
-        pixbytes = rt_pixtype_size(band->pixtype);
-        ptr += pixbytes - 1;
-
-        /* Read nodata value */
-        switch (band->pixtype) {
-            case PT_1BB:
-            {
-                band->nodataval = ((int) read_uint8(&ptr)) & 0x01;
-                break;
-            }
-            case PT_2BUI:
-            {
-                band->nodataval = ((int) read_uint8(&ptr)) & 0x03;
-                break;
-            }
-            case PT_4BUI:
-            {
-                band->nodataval = ((int) read_uint8(&ptr)) & 0x0F;
-                break;
-            }
-            case PT_8BSI:
-            {
-                band->nodataval = read_int8(&ptr);
-                break;
-            }
-            case PT_8BUI:
-            {
-                band->nodataval = read_uint8(&ptr);
-                break;
-            }
-            case PT_16BSI:
-            {
-                band->nodataval = read_int16(&ptr, littleEndian);
-                break;
-            }
-            case PT_16BUI:
-            {
-                band->nodataval = read_uint16(&ptr, littleEndian);
-                break;
-            }
-            case PT_32BSI:
-            {
-                band->nodataval = read_int32(&ptr, littleEndian);
-                break;
-            }
-            case PT_32BUI:
-            {
-                band->nodataval = read_uint32(&ptr, littleEndian);
-                break;
-            }
-            case PT_32BF:
-            {
-                band->nodataval = read_float32(&ptr, littleEndian);
-                break;
-            }
-            case PT_64BF:
-            {
-                band->nodataval = read_float64(&ptr, littleEndian);
-                break;
-            }
-            default:
-            {
-                rterror("rt_raster_deserialize: Unknown pixeltype %d", band->pixtype);
-                rtdealloc(band);
-                rtdealloc(rast);
-                return 0;
-            }
-        }
-
-        RASTER_DEBUGF(3, "rt_raster_deserialize: has nodata flag %d", band->hasnodata);
-        RASTER_DEBUGF(3, "rt_raster_deserialize: nodata value %g", band->nodataval);
-
-        /* Consistency checking (ptr is pixbytes-aligned) */
-        assert(!((ptr - beg) % pixbytes));
-
-        if (band->offline) {
-            /* Read band number */
-            band->data.offline.bandNum = *ptr;
-            ptr += 1;
-
-            /* Register path */
-            band->data.offline.path = (char*) ptr;
-            ptr += strlen(band->data.offline.path) + 1;
-
-						band->data.offline.mem = NULL;
-        } else {
-            /* Register data */
-            const uint32_t datasize = rast->width * rast->height * pixbytes;
-            band->data.mem = (uint8_t*) ptr;
-            ptr += datasize;
-        }
-
-        /* Skip bytes of padding up to 8-bytes boundary */
-#if POSTGIS_DEBUG_LEVEL > 0
-        const uint8_t *padbeg = ptr;
-#endif
-        while (0 != ((ptr - beg) % 8)){
-            ++ptr;
-        }
-
-        RASTER_DEBUGF(3, "rt_raster_deserialize: skip %d bytes of 8-bytes boundary padding", ptr - padbeg);
-
-        /* Consistency checking (ptr is pixbytes-aligned) */
-        assert(!((ptr - beg) % pixbytes));
-    }
+    rast->serialized = (const uint8_t*) serialized;
 
     return rast;
 }
@@ -10590,6 +10911,123 @@ int rt_raster_intersects_algorithm(
 	return 0;
 }
 
+/**
+ * Intersection test for two rasters on the same grid.  Pixels of
+ * the two rasters either coincide or don't overlap, so the test is
+ * done on the valid-data masks of the overlapping area instead of
+ * on pixel boundaries.
+ *
+ * Valid pixels sharing an edge or a corner count as an intersection,
+ * as the pixel boundaries of the two rasters coincide.
+ *
+ * @return 1 if the rasters intersect, 0 if they don't, -1 on error
+ *   (caller falls back to rt_raster_intersects_algorithm)
+ */
+static int
+rt_raster_intersects_aligned(
+	rt_raster rastS, rt_raster rastL,
+	rt_band bandS, rt_band bandL,
+	int hasnodataS, int hasnodataL,
+	double nodataS, double nodataL
+) {
+	double xr;
+	double yr;
+	int ox;
+	int oy;
+	int x0, x1, y0, y1;
+	int rw, rh;
+	int x, y, i, j;
+	uint8_t *mask = NULL;
+	uint8_t *maskS = NULL;
+	uint8_t *maskL = NULL;
+	double val;
+	int rtn = 0;
+
+	/* offset of the smaller raster in the larger raster's pixel grid */
+	if (!rt_raster_geopoint_to_cell(
+		rastL,
+		rastS->ipX, rastS->ipY,
+		&xr, &yr,
+		NULL
+	)) {
+		return -1;
+	}
+	ox = (int) xr;
+	oy = (int) yr;
+
+	/*
+		area shared by the two rasters, in the larger raster's pixel grid,
+		grown by one pixel for touching pixels.  It is not clipped to
+		either raster, so that rasters sharing only an edge or a corner
+		still meet in it
+	*/
+	x0 = (ox > 0 ? ox : 0) - 1;
+	y0 = (oy > 0 ? oy : 0) - 1;
+	x1 = (ox + (int) rastS->width < (int) rastL->width ? ox + (int) rastS->width : (int) rastL->width) + 1;
+	y1 = (oy + (int) rastS->height < (int) rastL->height ? oy + (int) rastS->height : (int) rastL->height) + 1;
+	if (x0 + 1 > x1 - 1 || y0 + 1 > y1 - 1)
+		return 0;
+	rw = x1 - x0;
+	rh = y1 - y0;
+	RASTER_DEBUGF(4, "aligned rasters: offset (%d, %d), area %d x %d", ox, oy, rw, rh);
+
+	mask = rtalloc(sizeof(uint8_t) * rw * rh * 2);
+	if (NULL == mask) {
+		rterror("rt_raster_intersects_aligned: Unable to allocate memory for valid data masks");
+		return -1;
+	}
+	memset(mask, 0, sizeof(uint8_t) * rw * rh * 2);
+	maskS = mask;
+	maskL = mask + rw * rh;
+
+	for (y = y0; y < y1; y++) {
+		for (x = x0; x < x1; x++) {
+			i = (y - y0) * rw + (x - x0);
+
+			if (x >= 0 && x < (int) rastL->width && y >= 0 && y < (int) rastL->height) {
+				if (hasnodataL == FALSE)
+					maskL[i] = 1;
+				else if (rt_band_get_pixel(bandL, x, y, &val) == 0 && FLT_NEQ(val, nodataL))
+					maskL[i] = 1;
+			}
+
+			if (x < ox || x >= ox + (int) rastS->width || y < oy || y >= oy + (int) rastS->height)
+				continue;
+			if (hasnodataS == FALSE)
+				maskS[i] = 1;
+			else if (rt_band_get_pixel(bandS, x - ox, y - oy, &val) == 0 && FLT_NEQ(val, nodataS))
+				maskS[i] = 1;
+		}
+	}
+
+	/* a pair of coincident valid pixels */
+	for (i = 0; i < rw * rh; i++) {
+		if (maskS[i] && maskL[i]) {
+			rtdealloc(mask);
+			return 1;
+		}
+	}
+
+	/* valid pixels sharing an edge or a corner */
+	for (y = 0; y < rh && !rtn; y++) {
+		for (x = 0; x < rw && !rtn; x++) {
+			if (!maskS[y * rw + x]) continue;
+
+			for (j = (y > 0 ? y - 1 : 0); j <= y + 1 && j < rh && !rtn; j++) {
+				for (i = (x > 0 ? x - 1 : 0); i <= x + 1 && i < rw; i++) {
+					if (maskL[j * rw + i]) {
+						rtn = 1;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	rtdealloc(mask);
+	return rtn;
+}
+
 /**
  * Return zero if error occurred in function.
  * Parameter intersects returns non-zero if two rasters intersect
@@ -10615,6 +11053,10 @@ rt_raster_intersects(
 	int i;
 	int j;
 	int within = 0;
+	int aligned = 0;
+	int rtn = 0;
+	uint32_t countS = 0;
+	uint32_t countL = 0;
 
 	LWPOLY *hull[2] = {NULL};
 	GEOSGeometry *ghull[2] = {NULL};
@@ -10830,6 +11272,43 @@ rt_raster_intersects(
 		hasnodataL = FALSE;
 	}
 
+	/* a band with only nodata values has nothing to intersect */
+	if (
+		(hasnodataS != FALSE && (
+			rt_band_get_isnodata_flag(bandS) ||
+			(rt_band_get_summary(bandS, FALSE, &countS, NULL, NULL) > 0 && !countS)
+		)) ||
+		(hasnodataL != FALSE && (
+			rt_band_get_isnodata_flag(bandL) ||
+			(rt_band_get_summary(bandL, FALSE, &countL, NULL, NULL) > 0 && !countL)
+		))
+	) {
+		RASTER_DEBUG(3, "The two rasters do not intersect as a band is NODATA");
+		*intersects = 0;
+		return 1;
+	}
+
+	/* rasters on the same grid are tested on their valid data masks */
+	if (
+		FLT_EQ(rastS->scaleX, rastL->scaleX) &&
+		FLT_EQ(rastS->scaleY, rastL->scaleY) &&
+		rt_raster_same_alignment(rastS, rastL, &aligned) &&
+		aligned
+	) {
+		RASTER_DEBUG(4, "Using aligned rasters test");
+		rtn = rt_raster_intersects_aligned(
+			rastS, rastL,
+			bandS, bandL,
+			hasnodataS, hasnodataL,
+			nodataS, nodataL
+		);
+		if (rtn >= 0) {
+			RASTER_DEBUGF(3, "The two rasters do %sintersect", rtn ? "" : "NOT ");
+			*intersects = rtn;
+			return 1;
+		}
+	}
+
 	/* special case where a raster can fit inside another raster's pixel */
 	if (within != 0 && ((pixarea1 > area2) || (pixarea2 > area1))) {
 		RASTER_DEBUG(4, "Using special case of raster fitting into another raster's pixel");
@@ -11328,6 +11807,278 @@ rt_raster_from_two_rasters(
 	return raster;
 }
 
+static int
+rt_raster_overview_cmp(const void *a, const void *b) {
+	const double *_a = (const double *) a;
+	const double *_b = (const double *) b;
+
+	if (*_a < *_b) return -1;
+	else if (*_a > *_b) return 1;
+	return 0;
+}
+
+/**
+ * Return one overview tile computed from aligned source tiles.
+ *
+ * @param rast : array of source tiles, all aligned
+ * @param count : number of elements in rast
+ * @param ulx : X coordinate of the output's upper-left corner
+ * @param uly : Y coordinate of the output's upper-left corner
+ * @param width : width of the output in pixels
+ * @param height : height of the output in pixels
+ * @param factor : reduction factor, must be at least 1
+ * @param alg : kernel used to summarize a block of source pixels
+ *
+ * @return raster object if success, NULL otherwise
+ */
+rt_raster
+rt_raster_build_overview(
+	rt_raster *rast, int count,
+	double ulx, double uly,
+	uint16_t width, uint16_t height,
+	int factor, rt_overviewalg alg
+) {
+	rt_raster raster = NULL;
+	rt_raster grid = NULL;
+	rt_raster ref = NULL;
+	rt_band band = NULL;
+	rt_band tband = NULL;
+	rt_pixtype pixtype = PT_END;
+	int hasnodata = 0;
+	double nodata = 0;
+	int numbands = 0;
+	int aligned = 0;
+	int *off = NULL;
+	double *values = NULL;
+	int nvalues = 0;
+	double xr = 0;
+	double yr = 0;
+	double val = 0;
+	double sum = 0;
+	int bx, by, bsize;
+	int x0, x1, y0, y1;
+	int x, y, ix, iy;
+	int best, run;
+	int i, j, b;
+
+	assert(NULL != rast);
+
+	if (count < 1) {
+		rterror("rt_raster_build_overview: No source tiles provided");
+		return NULL;
+	}
+	if (factor < 1) {
+		rterror("rt_raster_build_overview: Invalid reduction factor %d", factor);
+		return NULL;
+	}
+	if ((int) alg < OA_NEAREST || alg >= OA_END) {
+		rterror("rt_raster_build_overview: Invalid overview algorithm %d", alg);
+		return NULL;
+	}
+
+	/* first non-empty tile sets the band layout and the pixel grid */
+	for (i = 0; i < count; i++) {
+		if (NULL != rast[i] && !rt_raster_is_empty(rast[i])) {
+			ref = rast[i];
+			break;
+		}
+	}
+	if (NULL == ref) {
+		rterror("rt_raster_build_overview: All source tiles are empty");
+		return NULL;
+	}
+	numbands = rt_raster_get_num_bands(ref);
+
+	/*
+		the output's footprint at source resolution, used to place each
+		source tile on the output's grid of source pixels
+	*/
+	grid = rt_raster_new(0, 0);
+	if (NULL == grid) {
+		rterror("rt_raster_build_overview: Unable to create the source pixel grid");
+		return NULL;
+	}
+	rt_raster_set_scale(grid, ref->scaleX, ref->scaleY);
+	rt_raster_set_skews(grid, ref->skewX, ref->skewY);
+	rt_raster_set_offsets(grid, ulx, uly);
+	rt_raster_set_srid(grid, ref->srid);
+
+	/* pixel offsets of each tile (x, y) and its dimensions (width, height) */
+	off = rtalloc(sizeof(int) * 4 * count);
+	if (NULL == off) {
+		rterror("rt_raster_build_overview: Unable to allocate memory for tile offsets");
+		rt_raster_destroy(grid);
+		return NULL;
+	}
+	for (i = 0; i < count; i++) {
+		off[i * 4 + 2] = 0;
+		off[i * 4 + 3] = 0;
+		if (NULL == rast[i] || rt_raster_is_empty(rast[i]))
+			continue;
+
+		if (!rt_raster_same_alignment(rast[i], grid, &aligned)) {
+			rterror("rt_raster_build_overview: Unable to test alignment of source tile %d", i);
+			rtdealloc(off);
+			rt_raster_destroy(grid);
+			return NULL;
+		}
+		if (!aligned) {
+			rterror("rt_raster_build_overview: Source tile %d is not aligned with the other tiles", i);
+			rtdealloc(off);
+			rt_raster_destroy(grid);
+			return NULL;
+		}
+
+		if (!rt_raster_geopoint_to_cell(grid, rast[i]->ipX, rast[i]->ipY, &xr, &yr, NULL)) {
+			rterror("rt_raster_build_overview: Unable to get pixel offsets of source tile %d", i);
+			rtdealloc(off);
+			rt_raster_destroy(grid);
+			return NULL;
+		}
+		off[i * 4] = (int) xr;
+		off[i * 4 + 1] = (int) yr;
+		off[i * 4 + 2] = rast[i]->width;
+		off[i * 4 + 3] = rast[i]->height;
+		RASTER_DEBUGF(4, "source tile %d at offset (%d, %d)", i, off[i * 4], off[i * 4 + 1]);
+	}
+	rt_raster_destroy(grid);
+
+	raster = rt_raster_new(width, height);
+	if (NULL == raster) {
+		rterror("rt_raster_build_overview: Unable to create output raster");
+		rtdealloc(off);
+		return NULL;
+	}
+	rt_raster_set_scale(raster, ref->scaleX * factor, ref->scaleY * factor);
+	rt_raster_set_skews(raster, ref->skewX * factor, ref->skewY * factor);
+	rt_raster_set_offsets(raster, ulx, uly);
+	rt_raster_set_srid(raster, ref->srid);
+
+	/* nearest only looks at the source pixel at the center of the block */
+	bsize = (alg == OA_NEAREST) ? 1 : factor;
+	values = rtalloc(sizeof(double) * bsize * bsize);
+	if (NULL == values) {
+		rterror("rt_raster_build_overview: Unable to allocate memory for block values");
+		rtdealloc(off);
+		rt_raster_destroy(raster);
+		return NULL;
+	}
+
+	for (b = 0; b < numbands; b++) {
+		tband = rt_raster_get_band(ref, b);
+		if (NULL == tband) {
+			rterror("rt_raster_build_overview: Unable to get band %d of source tile", b);
+			rtdealloc(values);
+			rtdealloc(off);
+			rt_raster_destroy(raster);
+			return NULL;
+		}
+		pixtype = rt_band_get_pixtype(tband);
+		hasnodata = rt_band_get_hasnodata_flag(tband);
+		nodata = hasnodata ? rt_band_get_nodata(tband) : 0;
+
+		if (rt_raster_generate_new_band(raster, pixtype, nodata, hasnodata, nodata, b) < 0) {
+			rterror("rt_raster_build_overview: Unable to add band %d to output raster", b);
+			rtdealloc(values);
+			rtdealloc(off);
+			rt_raster_destroy(raster);
+			return NULL;
+		}
+		band = rt_raster_get_band(raster, b);
+
+		for (y = 0; y < height; y++) {
+			for (x = 0; x < width; x++) {
+				bx = x * factor;
+				by = y * factor;
+				if (alg == OA_NEAREST) {
+					bx += factor / 2;
+					by += factor / 2;
+				}
+
+				/* gather valid source pixels of the block */
+				nvalues = 0;
+				for (i = 0; i < count; i++) {
+					if (!off[i * 4 + 2] || numbands > rt_raster_get_num_bands(rast[i]))
+						continue;
+
+					x0 = bx > off[i * 4] ? bx : off[i * 4];
+					x1 = bx + bsize < off[i * 4] + off[i * 4 + 2] ? bx + bsize : off[i * 4] + off[i * 4 + 2];
+					y0 = by > off[i * 4 + 1] ? by : off[i * 4 + 1];
+					y1 = by + bsize < off[i * 4 + 1] + off[i * 4 + 3] ? by + bsize : off[i * 4 + 1] + off[i * 4 + 3];
+					if (x0 >= x1 || y0 >= y1)
+						continue;
+
+					tband = rt_raster_get_band(rast[i], b);
+					if (NULL == tband || rt_band_get_isnodata_flag(tband))
+						continue;
+
+					for (iy = y0; iy < y1; iy++) {
+						for (ix = x0; ix < x1; ix++) {
+							if (rt_band_get_pixel(tband, ix - off[i * 4], iy - off[i * 4 + 1], &val) < 0) {
+								rterror("rt_raster_build_overview: Unable to get pixel of source tile %d", i);
+								rtdealloc(values);
+								rtdealloc(off);
+								rt_raster_destroy(raster);
+								return NULL;
+							}
+							if (
+								rt_band_get_hasnodata_flag(tband) &&
+								FLT_EQ(val, rt_band_get_nodata(tband))
+							) {
+								continue;
+							}
+							values[nvalues++] = val;
+						}
+					}
+				}
+
+				if (!nvalues)
+					continue;
+
+				switch (alg) {
+					case OA_MEAN:
+						sum = 0;
+						for (j = 0; j < nvalues; j++)
+							sum += values[j];
+						val = sum / nvalues;
+						if (pixtype != PT_32BF && pixtype != PT_64BF)
+							val = ROUND(val, 0);
+						break;
+					case OA_MODE:
+						/* most frequent value, smallest value on ties */
+						qsort(values, nvalues, sizeof(double), rt_raster_overview_cmp);
+						val = values[0];
+						best = 0;
+						for (j = 0; j < nvalues; j += run) {
+							for (run = 1; j + run < nvalues && FLT_EQ(values[j + run], values[j]); run++);
+							if (run > best) {
+								best = run;
+								val = values[j];
+							}
+						}
+						break;
+					case OA_NEAREST:
+					default:
+						val = values[0];
+						break;
+				}
+
+				if (rt_band_set_pixel(band, x, y, val) < 0) {
+					rterror("rt_raster_build_overview: Unable to set pixel of output raster");
+					rtdealloc(values);
+					rtdealloc(off);
+					rt_raster_destroy(raster);
+					return NULL;
+				}
+			}
+		}
+	}
+
+	rtdealloc(values);
+	rtdealloc(off);
+
+	return raster;
+}
 
 LWPOLY*
 rt_raster_pixel_as_polygon(rt_raster rast, int x, int y)
@@ -178,6 +178,13 @@ typedef enum {
 	ET_SECOND
 } rt_extenttype;
 
+typedef enum {
+	OA_NEAREST = 0,
+	OA_MEAN,
+	OA_MODE,
+	OA_END /* unknown kernel name */
+} rt_overviewalg;
+
 /**
 * Global functions for memory/logging handlers.
 */
@@ -552,6 +559,24 @@ int rt_band_is_nodata(rt_band band);
  */
 int rt_band_check_is_nodata(rt_band band);
 
+/**
+ * Get the number of pixels that are not NODATA and their min and max
+ * values.  The summary is kept with the band and stored in the
+ * serialized form, it is computed from the pixels only if out of date
+ * and compute is non-zero.
+ *
+ * @param band : the band to get info from
+ * @param compute : if non-zero, compute the summary if out of date
+ * @param count : output parameter, number of pixels that are not NODATA
+ * @param min : output parameter, min value of pixels that are not NODATA
+ * @param max : output parameter, max value of pixels that are not NODATA
+ *
+ * @return 1 if the summary is available, 0 if out of date and
+ *   compute is zero, -1 on error
+ */
+int rt_band_get_summary(rt_band band, int compute,
+	uint32_t *count, double *min, double *max);
+
 /**
  * Compare clamped value to band's clamped NODATA value
  *
@@ -1145,8 +1170,16 @@ void* rt_raster_serialize(rt_raster raster);
  *
  * Serialized form is documented in doc/RFC1-SerializedFormat.
  *
+ * Bands are not read until requested with rt_raster_get_band, so
+ * callers touching a single band of a many-band raster only pay
+ * for that band. Band data is never copied.
+ *
  * NOTE: the raster will contain pointer to the serialized
  *       form, which must be kept alive.
+ *
+ * @param serialized : the serialized raster
+ * @param header_only : if non-zero, only the raster header is read
+ *                      and serialized may be a header-sized slice
  */
 rt_raster rt_raster_deserialize(void* serialized, int header_only);
 
@@ -1401,6 +1434,34 @@ rt_raster_from_two_rasters(
 	int *err, double *offset
 );
 
+/*
+ * Return one overview tile computed from aligned source tiles.
+ * Each output pixel summarizes the factor x factor block of
+ * source pixels it covers.  Output scale and skew are those of
+ * the source tiles multiplied by factor, band pixel types and
+ * nodata values are those of the first source tile.  Output
+ * pixels without any valid source pixel are set to nodata.
+ * The raster returned should be freed by the caller
+ *
+ * @param rast : array of source tiles, all aligned
+ * @param count : number of elements in rast
+ * @param ulx : X coordinate of the output's upper-left corner
+ * @param uly : Y coordinate of the output's upper-left corner
+ * @param width : width of the output in pixels
+ * @param height : height of the output in pixels
+ * @param factor : reduction factor, must be at least 1
+ * @param alg : kernel used to summarize a block of source pixels
+ *
+ * @return raster object if success, NULL otherwise
+ */
+rt_raster
+rt_raster_build_overview(
+	rt_raster *rast, int count,
+	double ulx, double uly,
+	uint16_t width, uint16_t height,
+	int factor, rt_overviewalg alg
+);
+
 /*- utilities -------------------------------------------------------*/
 
 /*
@@ -1503,6 +1564,12 @@ rt_util_gdal_version(const char *request);
 rt_extenttype
 rt_util_extent_type(const char *name);
 
+/*
+	overview kernel from c string, OA_END if the name is unknown
+*/
+rt_overviewalg
+rt_util_overview_alg(const char *name);
+
 char*
 rt_util_gdal_convert_sr(const char *srs, int proj4);
 
@@ -1549,7 +1616,7 @@ rt_util_envelope_to_lwpoly(
 struct rt_raster_serialized_t {
     /*---[ 8 byte boundary ]---{ */
     uint32_t size; /* required by postgresql: 4 bytes */
-    uint16_t version; /* format version (this is version 0): 2 bytes */
+    uint16_t version; /* format version (this is version 1): 2 bytes */
     uint16_t numBands; /* Number of bands: 2 bytes */
 
     /* }---[ 8 byte boundary ]---{ */
@@ -1576,6 +1643,24 @@ struct rt_raster_serialized_t {
     uint16_t height; /* pixel rows: 2 bytes */
 };
 
+/* Since version 1, the header is followed by one summary per band,
+ * see raster/doc/RFC1-SerializedFormat
+ */
+#define BANDSUMMARY_FLAG_VALID (1<<0)
+
+struct rt_bandsummary_serialized_t {
+    /*---[ 8 byte boundary ]---{ */
+    uint8_t flags; /* BANDSUMMARY_FLAG_*: 1 byte */
+    uint8_t padding[3]; /* 3 bytes */
+    uint32_t count; /* pixels that are not nodata: 4 bytes */
+
+    /* }---[ 8 byte boundary ]---{ */
+    double min; /* min value of pixels that are not nodata: 8 bytes */
+
+    /* }---[ 8 byte boundary ]---{ */
+    double max; /* max value of pixels that are not nodata: 8 bytes */
+};
+
 /* NOTE: the initial part of this structure matches the layout
  *       of data in the serialized form version 0, starting
  *       from the numBands element
@@ -1601,6 +1686,10 @@ struct rt_raster_t {
     uint16_t height; /* pixel rows - max 65535 */
     rt_band *bands; /* actual bands */
 
+    /* serialized form the bands are read from on first access,
+       externally owned. NULL if bands are all materialized */
+    const uint8_t *serialized;
+
 };
 
 struct rt_extband_t {
@@ -1609,6 +1698,14 @@ struct rt_extband_t {
 		void *mem; /* loaded external band data, internally owned */
 };
 
+/* summary of the pixels that are not nodata */
+struct rt_bandsummary_t {
+    int32_t valid; /* a flag indicating if the summary is up to date */
+    uint32_t count;
+    double min;
+    double max;
+};
+
 struct rt_band_t {
     rt_pixtype pixtype;
     int32_t offline;
@@ -1619,6 +1716,7 @@ struct rt_band_t {
                            nodata values */
     double nodataval; /* int will be converted ... */
     int32_t ownsData; /* XXX mloskot: its behaviour needs to be documented */
+    struct rt_bandsummary_t summary;
 
 		rt_raster raster; /* reference to parent raster */
 
@@ -54,6 +54,7 @@
 
 #include <utils/lsyscache.h> /* for get_typlenbyvalalign */
 #include <utils/array.h> /* for ArrayType */
+#include <lib/stringinfo.h> /* for StringInfo in RASTER_recv */
 #include <catalog/pg_type.h> /* for INT2OID, INT4OID, FLOAT4OID, FLOAT8OID and TEXTOID */
 
 /* maximum char length required to hold any double or long long value */
@@ -147,6 +148,7 @@ Datum RASTER_minPossibleValue(PG_FUNCTION_ARGS);
 /* Input/output and format conversions */
 Datum RASTER_in(PG_FUNCTION_ARGS);
 Datum RASTER_out(PG_FUNCTION_ARGS);
+Datum RASTER_recv(PG_FUNCTION_ARGS);
 
 Datum RASTER_to_bytea(PG_FUNCTION_ARGS);
 Datum RASTER_to_binary(PG_FUNCTION_ARGS);
@@ -255,6 +257,9 @@ Datum RASTER_intersects(PG_FUNCTION_ARGS);
 /* determine if two rasters are aligned */
 Datum RASTER_sameAlignment(PG_FUNCTION_ARGS);
 
+/* build an overview tile from source tiles */
+Datum RASTER_overview(PG_FUNCTION_ARGS);
+
 /* two-raster MapAlgebra */
 Datum RASTER_mapAlgebra2(PG_FUNCTION_ARGS);
 
@@ -680,6 +685,38 @@ Datum RASTER_out(PG_FUNCTION_ARGS)
 	PG_RETURN_CSTRING(hexwkb);
 }
 
+/**
+ * Binary input, from WKB. This is what binary COPY uses, so tiles
+ * can be loaded without the hex encoding of the text input.
+ */
+PG_FUNCTION_INFO_V1(RASTER_recv);
+Datum RASTER_recv(PG_FUNCTION_ARGS)
+{
+	StringInfo buf = (StringInfo) PG_GETARG_POINTER(0);
+	rt_raster raster = NULL;
+	rt_pgraster *pgraster = NULL;
+
+	raster = rt_raster_from_wkb((uint8_t *) buf->data, buf->len);
+	if (!raster) {
+		elog(ERROR, "RASTER_recv: Could not parse WKB raster");
+		PG_RETURN_NULL();
+	}
+
+	pgraster = rt_raster_serialize(raster);
+	rt_raster_destroy(raster);
+	if (!pgraster) {
+		elog(ERROR, "RASTER_recv: Could not serialize raster");
+		PG_RETURN_NULL();
+	}
+
+	SET_VARSIZE(pgraster, pgraster->size);
+
+	/* Set cursor to the end of buffer (so the backend is happy) */
+	buf->cursor = buf->len;
+
+	PG_RETURN_POINTER(pgraster);
+}
+
 /**
  * Return bytea object with raster in Well-Known-Binary form.
  */
@@ -1574,7 +1611,7 @@ Datum RASTER_setGeotransform(PG_FUNCTION_ARGS)
     xoffset = PG_GETARG_FLOAT8(5);
     yoffset = PG_GETARG_FLOAT8(6);
 
-    raster = rt_raster_deserialize(pgraster, TRUE);
+    raster = rt_raster_deserialize(pgraster, FALSE);
     if (!raster) {
         elog(ERROR, "RASTER_setGeotransform: Could not deserialize raster");
         PG_RETURN_NULL();
@@ -2027,8 +2064,33 @@ Datum RASTER_bandIsNoData(PG_FUNCTION_ARGS)
         PG_RETURN_NULL();
     }
 
-    /* Deserialize raster */
     if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+    forcechecking = PG_GETARG_BOOL(2);
+
+    /* Answer from the band summary following the header if up to date */
+    if (forcechecking) {
+        pgraster = (rt_pgraster *) PG_DETOAST_DATUM_SLICE(PG_GETARG_DATUM(0), 0, sizeof(struct rt_raster_serialized_t));
+        if (
+            pgraster->version > 0 &&
+            bandindex <= pgraster->numBands &&
+            pgraster->width > 0 && pgraster->height > 0
+        ) {
+            struct rt_bandsummary_serialized_t summary;
+
+            pgraster = (rt_pgraster *) PG_DETOAST_DATUM_SLICE(PG_GETARG_DATUM(0), 0,
+                sizeof(struct rt_raster_serialized_t) + pgraster->numBands * sizeof(struct rt_bandsummary_serialized_t));
+            memcpy(&summary,
+                ((uint8_t *) pgraster) + sizeof(struct rt_raster_serialized_t) + (bandindex - 1) * sizeof(struct rt_bandsummary_serialized_t),
+                sizeof(struct rt_bandsummary_serialized_t));
+
+            if (summary.flags & BANDSUMMARY_FLAG_VALID) {
+                POSTGIS_RT_DEBUGF(3, "RASTER_bandIsNoData: band summary count = %u", summary.count);
+                PG_RETURN_BOOL(summary.count == 0);
+            }
+        }
+    }
+
+    /* Deserialize raster */
     pgraster = (rt_pgraster *)PG_DETOAST_DATUM(PG_GETARG_DATUM(0));
 
     raster = rt_raster_deserialize(pgraster, FALSE);
@@ -2045,8 +2107,6 @@ Datum RASTER_bandIsNoData(PG_FUNCTION_ARGS)
         PG_RETURN_NULL();
     }
 
-    forcechecking = PG_GETARG_BOOL(2);
-
     bandisnodata = (forcechecking) ?
         rt_band_check_is_nodata(band) : rt_band_get_isnodata_flag(band);
 
@@ -8580,6 +8640,111 @@ Datum RASTER_sameAlignment(PG_FUNCTION_ARGS)
 	PG_RETURN_BOOL(aligned);
 }
 
+/**
+ * Build one overview tile from an array of aligned source tiles
+ */
+PG_FUNCTION_INFO_V1(RASTER_overview);
+Datum RASTER_overview(PG_FUNCTION_ARGS)
+{
+	ArrayType *array;
+	Oid etype;
+	Datum *e;
+	bool *nulls;
+	int16 typlen;
+	bool typbyval;
+	char typalign;
+	int n = 0;
+
+	rt_pgraster *pgrast = NULL;
+	rt_raster *rast = NULL;
+	int count = 0;
+	double ulx;
+	double uly;
+	int width;
+	int height;
+	int factor;
+	text *algtext = NULL;
+	char *algchar = NULL;
+	rt_overviewalg alg = OA_NEAREST;
+
+	rt_raster raster = NULL;
+	int i = 0;
+
+	ulx = PG_GETARG_FLOAT8(1);
+	uly = PG_GETARG_FLOAT8(2);
+
+	width = PG_GETARG_INT32(3);
+	height = PG_GETARG_INT32(4);
+	if (width < 1 || width > 65535 || height < 1 || height > 65535) {
+		elog(ERROR, "RASTER_overview: Invalid dimensions %d x %d for overview tile", width, height);
+		PG_RETURN_NULL();
+	}
+
+	factor = PG_GETARG_INT32(5);
+	if (factor < 1) {
+		elog(ERROR, "RASTER_overview: Overview factor must be greater than zero");
+		PG_RETURN_NULL();
+	}
+
+	algtext = PG_GETARG_TEXT_P(6);
+	algchar = rtpg_trim(rtpg_strtoupper(text_to_cstring(algtext)));
+	alg = rt_util_overview_alg(algchar);
+	if (alg == OA_END) {
+		elog(ERROR, "RASTER_overview: Unknown overview algorithm %s.  Use NearestNeighbour, Mean or Mode", algchar);
+		pfree(algchar);
+		PG_RETURN_NULL();
+	}
+	pfree(algchar);
+
+	array = PG_GETARG_ARRAYTYPE_P(0);
+	etype = ARR_ELEMTYPE(array);
+	get_typlenbyvalalign(etype, &typlen, &typbyval, &typalign);
+
+	deconstruct_array(array, etype, typlen, typbyval, typalign, &e,
+		&nulls, &n);
+
+	rast = palloc(sizeof(rt_raster) * n);
+	for (i = 0; i < n; i++) {
+		if (nulls[i]) continue;
+
+		pgrast = (rt_pgraster *) PG_DETOAST_DATUM(e[i]);
+		rast[count] = rt_raster_deserialize(pgrast, FALSE);
+		if (!rast[count]) {
+			elog(ERROR, "RASTER_overview: Could not deserialize source tile at index %d", i);
+			for (; count > 0; count--) rt_raster_destroy(rast[count - 1]);
+			pfree(rast);
+			PG_RETURN_NULL();
+		}
+		count++;
+	}
+
+	if (!count) {
+		pfree(rast);
+		PG_RETURN_NULL();
+	}
+
+	raster = rt_raster_build_overview(
+		rast, count,
+		ulx, uly,
+		width, height,
+		factor, alg
+	);
+	for (i = 0; i < count; i++) rt_raster_destroy(rast[i]);
+	pfree(rast);
+
+	if (!raster) {
+		elog(ERROR, "RASTER_overview: Could not build overview tile");
+		PG_RETURN_NULL();
+	}
+
+	pgrast = (rt_pgraster *) rt_raster_serialize(raster);
+	rt_raster_destroy(raster);
+	if (!pgrast) PG_RETURN_NULL();
+
+	SET_VARSIZE(pgrast, pgrast->size);
+	PG_RETURN_POINTER(pgrast);
+}
+
 /**
  * Two raster MapAlgebra
  */
@@ -41,11 +41,23 @@ CREATE OR REPLACE FUNCTION raster_out(raster)
     AS 'MODULE_PATHNAME','RASTER_out'
     LANGUAGE 'C' IMMUTABLE STRICT;
 
+CREATE OR REPLACE FUNCTION raster_recv(internal)
+    RETURNS raster
+    AS 'MODULE_PATHNAME','RASTER_recv'
+    LANGUAGE 'C' IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION raster_send(raster)
+    RETURNS bytea
+    AS 'MODULE_PATHNAME','RASTER_to_binary'
+    LANGUAGE 'C' IMMUTABLE STRICT;
+
 CREATE TYPE raster (
     alignment = double,
     internallength = variable,
     input = raster_in,
     output = raster_out,
+    receive = raster_recv,
+    send = raster_send,
     storage = extended
 );
 
@@ -5082,6 +5094,252 @@ CREATE OR REPLACE FUNCTION DropOverviewConstraints (
 	LANGUAGE 'sql' VOLATILE STRICT
 	COST 100;
 
+------------------------------------------------------------------------------
+-- Overview builder
+------------------------------------------------------------------------------
+
+CREATE OR REPLACE FUNCTION _st_overview(
+	rasts raster[],
+	ulx double precision, uly double precision,
+	width integer, height integer,
+	factor integer,
+	algorithm text DEFAULT 'NearestNeighbour'
+)
+	RETURNS raster
+	AS 'MODULE_PATHNAME', 'RASTER_overview'
+	LANGUAGE 'C' IMMUTABLE STRICT;
+
+-----------------------------------------------------------------------
+-- ST_UpdateOverview
+-- (Re)build the tiles of an overview table intersecting extent
+-- from the tiles of the reference table.  If extent is NULL, all
+-- tiles of the overview table are rebuilt.  Overview tiles have the
+-- dimensions of the reference tiles and are laid out on a grid
+-- anchored at the upper-left corner of the reference coverage when
+-- built from scratch.  Updates keep the grid of the existing overview
+-- tiles and only read the reference tiles under extent.
+-- Returns the number of overview tiles written
+-----------------------------------------------------------------------
+CREATE OR REPLACE FUNCTION ST_UpdateOverview(
+	ovschema name, ovtable name, ovcolumn name,
+	refschema name, reftable name, refcolumn name,
+	ovfactor int,
+	algorithm text DEFAULT 'NearestNeighbour',
+	extent geometry DEFAULT NULL
+)
+	RETURNS integer
+	AS $$
+	DECLARE
+		ovfqtn text;
+		reffqtn text;
+		ref record;
+		cov box2d;
+		ulx double precision;
+		uly double precision;
+		tw double precision;
+		th double precision;
+		ncols integer;
+		nrows integer;
+		c0 integer;
+		c1 integer;
+		r0 integer;
+		r1 integer;
+		env geometry;
+		tile raster;
+		cnt integer := 0;
+	BEGIN
+		IF ovfactor IS NULL OR ovfactor < 2 THEN
+			RAISE EXCEPTION 'Overview factor must be greater than one';
+		END IF;
+
+		ovfqtn := '';
+		IF length(ovschema) > 0 THEN
+			ovfqtn := quote_ident(ovschema) || '.';
+		END IF;
+		ovfqtn := ovfqtn || quote_ident(ovtable);
+
+		reffqtn := '';
+		IF length(refschema) > 0 THEN
+			reffqtn := quote_ident(refschema) || '.';
+		END IF;
+		reffqtn := reffqtn || quote_ident(reftable);
+
+		-- tile layout of the reference coverage
+		EXECUTE 'SELECT st_scalex(r) AS scalex, st_scaley(r) AS scaley, st_skewx(r) AS skewx, st_skewy(r) AS skewy, '
+			|| 'st_width(r) AS width, st_height(r) AS height, st_srid(r) AS srid FROM (SELECT '
+			|| quote_ident(refcolumn) || ' AS r FROM ' || reffqtn
+			|| ' WHERE ' || quote_ident(refcolumn) || ' IS NOT NULL LIMIT 1) AS foo'
+			INTO ref;
+		IF ref IS NULL OR ref.width IS NULL THEN
+			RETURN 0;
+		END IF;
+
+		IF ref.skewx <> 0 OR ref.skewy <> 0 THEN
+			RAISE EXCEPTION 'Overviews of rotated rasters are not supported';
+		END IF;
+
+		tw := ref.width * ref.scalex * ovfactor;
+		th := ref.height * ref.scaley * ovfactor;
+
+		-- updates stay on the grid of the existing overview tiles,
+		-- even if new reference tiles grew the coverage up or left
+		IF extent IS NOT NULL THEN
+			EXECUTE 'SELECT st_upperleftx(r), st_upperlefty(r) FROM (SELECT '
+				|| quote_ident(ovcolumn) || ' AS r FROM ' || ovfqtn
+				|| ' WHERE ' || quote_ident(ovcolumn) || ' IS NOT NULL LIMIT 1) AS foo'
+				INTO ulx, uly;
+		END IF;
+
+		IF extent IS NOT NULL AND ulx IS NOT NULL THEN
+			-- only the overview tiles touched by extent, tiles without
+			-- reference tiles under them come out NULL and are skipped
+			c0 := least(floor((st_xmin(extent) - ulx) / tw), floor((st_xmax(extent) - ulx) / tw));
+			c1 := greatest(floor((st_xmin(extent) - ulx) / tw), floor((st_xmax(extent) - ulx) / tw));
+			r0 := least(floor((st_ymin(extent) - uly) / th), floor((st_ymax(extent) - uly) / th));
+			r1 := greatest(floor((st_ymin(extent) - uly) / th), floor((st_ymax(extent) - uly) / th));
+		ELSE
+			-- from scratch, the whole reference coverage
+			EXECUTE 'SELECT st_extent(st_envelope(' || quote_ident(refcolumn) || ')) FROM ' || reffqtn
+				INTO cov;
+
+			IF ref.scalex > 0 THEN
+				ulx := st_xmin(cov);
+			ELSE
+				ulx := st_xmax(cov);
+			END IF;
+			IF ref.scaley < 0 THEN
+				uly := st_ymax(cov);
+			ELSE
+				uly := st_ymin(cov);
+			END IF;
+
+			ncols := ceil((st_xmax(cov) - st_xmin(cov)) / abs(tw));
+			nrows := ceil((st_ymax(cov) - st_ymin(cov)) / abs(th));
+
+			EXECUTE 'DELETE FROM ' || ovfqtn;
+
+			c0 := 0;
+			c1 := ncols - 1;
+			r0 := 0;
+			r1 := nrows - 1;
+		END IF;
+
+		FOR y IN r0..r1 LOOP
+			FOR x IN c0..c1 LOOP
+				env := st_envelope(st_makeemptyraster(
+					ref.width, ref.height,
+					ulx + x * tw, uly + y * th,
+					ref.scalex * ovfactor, ref.scaley * ovfactor,
+					0, 0,
+					ref.srid
+				));
+
+				IF extent IS NOT NULL THEN
+					EXECUTE 'DELETE FROM ' || ovfqtn
+						|| ' WHERE ' || quote_ident(ovcolumn) || ' && st_centroid($1)'
+						USING env;
+				END IF;
+
+				EXECUTE 'SELECT _st_overview(array_agg(' || quote_ident(refcolumn) || '), $1, $2, $3, $4, $5, $6) FROM '
+					|| reffqtn || ' WHERE ' || quote_ident(refcolumn) || ' && $7'
+					INTO tile
+					USING ulx + x * tw, uly + y * th, ref.width, ref.height, ovfactor, algorithm, env;
+
+				IF tile IS NOT NULL THEN
+					EXECUTE 'INSERT INTO ' || ovfqtn || ' (' || quote_ident(ovcolumn) || ') VALUES ($1)'
+						USING tile;
+					cnt := cnt + 1;
+				END IF;
+			END LOOP;
+		END LOOP;
+
+		RETURN cnt;
+	END;
+	$$ LANGUAGE 'plpgsql' VOLATILE;
+
+-----------------------------------------------------------------------
+-- ST_UpdateOverviews
+-- Rebuild the tiles intersecting extent in every overview registered
+-- in raster_overviews for the reference column.  Each level is read
+-- from the reference tiles, not from the finer level: mean and mode
+-- of already summarized blocks differ from those of the pixels
+-----------------------------------------------------------------------
+CREATE OR REPLACE FUNCTION ST_UpdateOverviews(
+	refschema name, reftable name, refcolumn name,
+	extent geometry,
+	algorithm text DEFAULT 'NearestNeighbour'
+)
+	RETURNS integer
+	AS $$
+	DECLARE
+		ov record;
+		cnt integer := 0;
+	BEGIN
+		FOR ov IN
+			SELECT o_table_schema, o_table_name, o_raster_column, r_table_schema, overview_factor
+			FROM raster_overviews
+			WHERE (length(refschema) < 1 OR r_table_schema = refschema)
+				AND r_table_name = reftable
+				AND r_raster_column = refcolumn
+			ORDER BY overview_factor
+		LOOP
+			cnt := cnt + ST_UpdateOverview(
+				ov.o_table_schema, ov.o_table_name, ov.o_raster_column,
+				ov.r_table_schema, reftable, refcolumn,
+				ov.overview_factor, algorithm, extent
+			);
+		END LOOP;
+
+		RETURN cnt;
+	END;
+	$$ LANGUAGE 'plpgsql' VOLATILE;
+
+-----------------------------------------------------------------------
+-- ST_CreateOverview
+-- Create, fill, index and register the overview table o_<factor>_<table>
+-- of a reference raster column.  Returns the name of the overview table
+-----------------------------------------------------------------------
+CREATE OR REPLACE FUNCTION ST_CreateOverview(
+	refschema name, reftable name, refcolumn name,
+	ovfactor int,
+	algorithm text DEFAULT 'NearestNeighbour'
+)
+	RETURNS name
+	AS $$
+	DECLARE
+		ovtable name;
+		fqtn text;
+	BEGIN
+		ovtable := 'o_' || ovfactor || '_' || reftable;
+
+		fqtn := '';
+		IF length(refschema) > 0 THEN
+			fqtn := quote_ident(refschema) || '.';
+		END IF;
+		fqtn := fqtn || quote_ident(ovtable);
+
+		EXECUTE 'CREATE TABLE ' || fqtn
+			|| ' ("rid" serial PRIMARY KEY, ' || quote_ident(refcolumn) || ' raster)';
+
+		PERFORM ST_UpdateOverview(
+			refschema, ovtable, refcolumn,
+			refschema, reftable, refcolumn,
+			ovfactor, algorithm, NULL
+		);
+
+		EXECUTE 'CREATE INDEX ' || quote_ident(ovtable || '_' || refcolumn || '_gist')
+			|| ' ON ' || fqtn || ' USING gist (st_convexhull(' || quote_ident(refcolumn) || '))';
+
+		PERFORM AddOverviewConstraints(
+			refschema, ovtable, refcolumn,
+			refschema, reftable, refcolumn,
+			ovfactor
+		);
+
+		RETURN ovtable;
+	END;
+	$$ LANGUAGE 'plpgsql' VOLATILE;
+
 -------------------------------------------------------------------
 --  END
 -------------------------------------------------------------------
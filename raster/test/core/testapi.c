@@ -2364,6 +2364,181 @@ static void testIntersects() {
 
 	deepRelease(rast2);
 	deepRelease(rast1);
+
+	/*
+		aligned rasters
+
+		rast1
+		(0, 0)
+						+-+-+-+
+						|1|0|0|
+						+-+-+-+
+						|0|0|0|
+						+-+-+-+
+						|0|0|0|
+						+-+-+-+
+									(3, 3)
+
+		rast2
+		(1, 1)
+						+-+-+-+
+						|0|0|0|
+						+-+-+-+
+						|0|0|0|
+						+-+-+-+
+						|0|0|1|
+						+-+-+-+
+									(4, 4)
+	*/
+	rast1 = rt_raster_new(3, 3);
+	assert(rast1);
+	band1 = addBand(rast1, PT_8BUI, 1, 0);
+	CHECK(band1);
+	for (rtn = 0; rtn < 9; rtn++)
+		rt_band_set_pixel(band1, rtn % 3, rtn / 3, 0);
+	rt_band_set_pixel(band1, 0, 0, 1);
+
+	rast2 = rt_raster_new(3, 3);
+	assert(rast2);
+	rt_raster_set_offsets(rast2, 1, 1);
+	band2 = addBand(rast2, PT_8BUI, 1, 0);
+	CHECK(band2);
+	for (rtn = 0; rtn < 9; rtn++)
+		rt_band_set_pixel(band2, rtn % 3, rtn / 3, 0);
+	rt_band_set_pixel(band2, 2, 2, 1);
+
+	rtn = rt_raster_intersects(
+		rast1, 0,
+		rast2, 0,
+		&intersects
+	);
+	CHECK((rtn != 0));
+	CHECK((intersects != 1));
+
+	/* coincident valid pixels at (2, 2) */
+	rt_band_set_pixel(band1, 2, 2, 1);
+	rt_band_set_pixel(band2, 1, 1, 1);
+
+	rtn = rt_raster_intersects(
+		rast1, 0,
+		rast2, 0,
+		&intersects
+	);
+	CHECK((rtn != 0));
+	CHECK((intersects == 1));
+
+	/* a band flagged as NODATA never intersects */
+	rt_band_set_isnodata_flag(band2, 1);
+
+	rtn = rt_raster_intersects(
+		rast1, 0,
+		rast2, 0,
+		&intersects
+	);
+	CHECK((rtn != 0));
+	CHECK((intersects != 1));
+
+	deepRelease(rast2);
+	deepRelease(rast1);
+
+	/*
+		aligned rasters only sharing an edge, then a corner
+
+		rast1
+		(0, 0)
+						+-+-+
+						|1|1|
+						+-+-+
+						|1|1|
+						+-+-+
+								(2, 2)
+
+		rast2
+		(2, 0), (2, 2) and (3, 0)
+						+-+-+
+						|1|1|
+						+-+-+
+						|1|1|
+						+-+-+
+	*/
+	rast1 = rt_raster_new(2, 2);
+	assert(rast1);
+	band1 = addBand(rast1, PT_8BUI, 1, 0);
+	CHECK(band1);
+	for (rtn = 0; rtn < 4; rtn++)
+		rt_band_set_pixel(band1, rtn % 2, rtn / 2, 1);
+
+	rast2 = rt_raster_new(2, 2);
+	assert(rast2);
+	band2 = addBand(rast2, PT_8BUI, 1, 0);
+	CHECK(band2);
+	for (rtn = 0; rtn < 4; rtn++)
+		rt_band_set_pixel(band2, rtn % 2, rtn / 2, 1);
+
+	/* touching edge */
+	rt_raster_set_offsets(rast2, 2, 0);
+	rtn = rt_raster_intersects(
+		rast1, 0,
+		rast2, 0,
+		&intersects
+	);
+	CHECK((rtn != 0));
+	CHECK((intersects == 1));
+
+	/* same, the other way around */
+	rtn = rt_raster_intersects(
+		rast2, 0,
+		rast1, 0,
+		&intersects
+	);
+	CHECK((rtn != 0));
+	CHECK((intersects == 1));
+
+	/* touching corner */
+	rt_raster_set_offsets(rast2, 2, 2);
+	rtn = rt_raster_intersects(
+		rast1, 0,
+		rast2, 0,
+		&intersects
+	);
+	CHECK((rtn != 0));
+	CHECK((intersects == 1));
+
+	/* one column apart */
+	rt_raster_set_offsets(rast2, 3, 0);
+	rtn = rt_raster_intersects(
+		rast1, 0,
+		rast2, 0,
+		&intersects
+	);
+	CHECK((rtn != 0));
+	CHECK((intersects != 1));
+
+	/* touching edge, but the touching pixels are NODATA */
+	rt_raster_set_offsets(rast2, 2, 0);
+	rt_band_set_pixel(band2, 0, 0, 0);
+	rt_band_set_pixel(band2, 0, 1, 0);
+	rtn = rt_raster_intersects(
+		rast1, 0,
+		rast2, 0,
+		&intersects
+	);
+	CHECK((rtn != 0));
+	CHECK((intersects != 1));
+
+	/* touching edge, valid pixels only meet at a corner across it */
+	rt_band_set_pixel(band1, 1, 1, 0);
+	rt_band_set_pixel(band2, 0, 1, 1);
+	rtn = rt_raster_intersects(
+		rast1, 0,
+		rast2, 0,
+		&intersects
+	);
+	CHECK((rtn != 0));
+	CHECK((intersects == 1));
+
+	deepRelease(rast2);
+	deepRelease(rast1);
 }
 
 static void testAlignment() {
@@ -2528,6 +2703,279 @@ static void testFromTwoRasters() {
 	deepRelease(rast1);
 }
 
+static void testRasterDeserialize() {
+	rt_raster raster;
+	rt_raster rast;
+	rt_band band;
+	void *serialized;
+	double val;
+	int rtn;
+
+	raster = rt_raster_new(5, 5);
+	assert(raster); /* or we're out of virtual memory */
+
+	band = addBand(raster, PT_8BUI, 0, 0);
+	CHECK(band);
+	rt_band_set_pixel(band, 1, 1, 3);
+	band = addBand(raster, PT_16BSI, 1, -1);
+	CHECK(band);
+	rt_band_set_pixel(band, 2, 2, -7);
+	band = addBand(raster, PT_64BF, 1, 1.5);
+	CHECK(band);
+	rt_band_set_pixel(band, 3, 3, 2.25);
+
+	serialized = rt_raster_serialize(raster);
+	CHECK(serialized);
+
+	rast = rt_raster_deserialize(serialized, FALSE);
+	CHECK(rast);
+	CHECK_EQUALS(rt_raster_get_num_bands(rast), 3);
+
+	/* No band is read until requested */
+	CHECK(!rast->bands[0]);
+	CHECK(!rast->bands[2]);
+
+	band = rt_raster_get_band(rast, 2);
+	CHECK(band);
+	CHECK(!rast->bands[0]);
+	CHECK(!rast->bands[1]);
+	CHECK_EQUALS(rt_band_get_pixtype(band), PT_64BF);
+	CHECK(FLT_EQ(rt_band_get_nodata(band), 1.5));
+	rtn = rt_band_get_pixel(band, 3, 3, &val);
+	CHECK((rtn == 0));
+	CHECK(FLT_EQ(val, 2.25));
+
+	/* Band data is read in place */
+	CHECK(((uint8_t *) rt_band_get_data(band) > (uint8_t *) serialized));
+
+	band = rt_raster_get_band(rast, 1);
+	CHECK(band);
+	CHECK_EQUALS(rt_band_get_pixtype(band), PT_16BSI);
+	CHECK(FLT_EQ(rt_band_get_nodata(band), -1));
+	rtn = rt_band_get_pixel(band, 2, 2, &val);
+	CHECK((rtn == 0));
+	CHECK(FLT_EQ(val, -7));
+
+	/* Adding a band reads the remaining ones */
+	band = rt_band_new_inline(5, 5, PT_8BUI, 0, 0, rtalloc(25));
+	CHECK(band);
+	rtn = rt_raster_add_band(rast, band, 0);
+	CHECK((rtn == 0));
+	CHECK_EQUALS(rt_raster_get_num_bands(rast), 4);
+	band = rt_raster_get_band(rast, 1);
+	CHECK(band);
+	CHECK_EQUALS(rt_band_get_pixtype(band), PT_8BUI);
+	rtn = rt_band_get_pixel(band, 1, 1, &val);
+	CHECK((rtn == 0));
+	CHECK(FLT_EQ(val, 3));
+	band = rt_raster_get_band(rast, 3);
+	CHECK(band);
+	CHECK_EQUALS(rt_band_get_pixtype(band), PT_64BF);
+
+	/* Header only */
+	band = rt_raster_get_band(rast, 0);
+	rtdealloc(rt_band_get_data(band));
+	for (rtn = 0; rtn < rt_raster_get_num_bands(rast); rtn++)
+		rt_band_destroy(rt_raster_get_band(rast, rtn));
+	rt_raster_destroy(rast);
+
+	rast = rt_raster_deserialize(serialized, TRUE);
+	CHECK(rast);
+	CHECK_EQUALS(rt_raster_get_num_bands(rast), 3);
+	CHECK(!rt_raster_get_band(rast, 0));
+	rt_raster_destroy(rast);
+
+	rtdealloc(serialized);
+	deepRelease(raster);
+}
+
+static void testBandSummary() {
+	rt_raster raster;
+	rt_raster rast;
+	rt_band band;
+	void *serialized;
+	uint32_t count;
+	double min;
+	double max;
+	int16_t line[2];
+	int x, y;
+	int rtn;
+
+	raster = rt_raster_new(4, 4);
+	assert(raster);
+
+	band = addBand(raster, PT_16BSI, 1, 0);
+	CHECK(band);
+	for (y = 0; y < 4; y++) {
+		for (x = 0; x < 4; x++)
+			rt_band_set_pixel(band, x, y, 0);
+	}
+
+	/* not computed unless asked */
+	rtn = rt_band_get_summary(band, FALSE, &count, &min, &max);
+	CHECK((rtn == 0));
+	rtn = rt_band_get_summary(band, TRUE, &count, &min, &max);
+	CHECK((rtn == 1));
+	CHECK_EQUALS(count, 0);
+	CHECK(rt_band_check_is_nodata(band));
+
+	/* pixel writes keep a known summary up to date */
+	rt_band_set_pixel(band, 1, 2, -5);
+	rt_band_set_pixel(band, 3, 0, 12);
+	rt_band_set_pixel(band, 0, 0, 4);
+	rtn = rt_band_get_summary(band, FALSE, &count, &min, &max);
+	CHECK((rtn == 1));
+	CHECK_EQUALS(count, 3);
+	CHECK(FLT_EQ(min, -5));
+	CHECK(FLT_EQ(max, 12));
+	rt_band_set_pixel(band, 0, 0, 0);
+	rtn = rt_band_get_summary(band, FALSE, &count, &min, &max);
+	CHECK((rtn == 1));
+	CHECK_EQUALS(count, 2);
+	CHECK(!rt_band_check_is_nodata(band));
+
+	/* summary is computed on serialization and read back */
+	serialized = rt_raster_serialize(raster);
+	CHECK(serialized);
+	CHECK_EQUALS(((struct rt_raster_serialized_t *) serialized)->version, 1);
+
+	rast = rt_raster_deserialize(serialized, FALSE);
+	CHECK(rast);
+	band = rt_raster_get_band(rast, 0);
+	CHECK(band);
+	rtn = rt_band_get_summary(band, FALSE, &count, &min, &max);
+	CHECK((rtn == 1));
+	CHECK_EQUALS(count, 2);
+	CHECK(FLT_EQ(min, -5));
+	CHECK(FLT_EQ(max, 12));
+	rtn = rt_band_get_pixel(band, 3, 0, &min);
+	CHECK((rtn == 0));
+	CHECK(FLT_EQ(min, 12));
+
+	rt_band_set_nodata(band, 12);
+	rtn = rt_band_get_summary(band, FALSE, &count, &min, &max);
+	CHECK((rtn == 0));
+	rtn = rt_band_get_summary(band, TRUE, &count, &min, &max);
+	CHECK((rtn == 1));
+	CHECK_EQUALS(count, 15);
+
+	/* line writes too */
+	line[0] = 20;
+	line[1] = 12;
+	rtn = rt_band_set_pixel_line(band, 0, 1, line, 2);
+	CHECK((rtn == 1));
+	rtn = rt_band_get_summary(band, FALSE, &count, &min, &max);
+	CHECK((rtn == 1));
+	CHECK_EQUALS(count, 14);
+	CHECK(FLT_EQ(min, -5));
+	CHECK(FLT_EQ(max, 20));
+
+	/* moving the min inward makes the summary out of date */
+	rt_band_set_pixel(band, 1, 2, 3);
+	rtn = rt_band_get_summary(band, FALSE, &count, &min, &max);
+	CHECK((rtn == 0));
+	rtn = rt_band_get_summary(band, TRUE, &count, &min, &max);
+	CHECK((rtn == 1));
+	CHECK_EQUALS(count, 14);
+	CHECK(FLT_EQ(min, 0));
+	CHECK(FLT_EQ(max, 20));
+
+	rt_band_destroy(band);
+	rt_raster_destroy(rast);
+	rtdealloc(serialized);
+	deepRelease(raster);
+}
+
+static void testBuildOverview() {
+	rt_raster rast[2];
+	rt_raster ov;
+	rt_band band;
+	double val;
+	int x, y;
+	int i;
+
+	/* two 4x4 tiles side by side, nodata 0 */
+	for (i = 0; i < 2; i++) {
+		rast[i] = rt_raster_new(4, 4);
+		assert(rast[i]);
+		rt_raster_set_scale(rast[i], 1, -1);
+		rt_raster_set_offsets(rast[i], i * 4, 0);
+
+		band = addBand(rast[i], PT_8BUI, 1, 0);
+		CHECK(band);
+		for (y = 0; y < 4; y++) {
+			for (x = 0; x < 4; x++)
+				rt_band_set_pixel(band, x, y, i ? 5 : 1);
+		}
+	}
+	band = rt_raster_get_band(rast[0], 0);
+	rt_band_set_pixel(band, 0, 0, 3);
+	rt_band_set_pixel(band, 1, 0, 3);
+	rt_band_set_pixel(band, 0, 1, 0);
+
+	/* one column more than the tiles cover */
+	ov = rt_raster_build_overview(rast, 2, 0, 0, 5, 2, 2, OA_MEAN);
+	CHECK(ov);
+	CHECK_EQUALS(rt_raster_get_width(ov), 5);
+	CHECK_EQUALS(rt_raster_get_height(ov), 2);
+	CHECK(FLT_EQ(rt_raster_get_x_scale(ov), 2));
+	CHECK(FLT_EQ(rt_raster_get_y_scale(ov), -2));
+	CHECK_EQUALS(rt_raster_get_num_bands(ov), 1);
+
+	band = rt_raster_get_band(ov, 0);
+	CHECK(band);
+	CHECK(rt_band_get_hasnodata_flag(band));
+	rt_band_get_pixel(band, 0, 0, &val);
+	CHECK(FLT_EQ(val, 2));
+	rt_band_get_pixel(band, 1, 1, &val);
+	CHECK(FLT_EQ(val, 1));
+	rt_band_get_pixel(band, 2, 0, &val);
+	CHECK(FLT_EQ(val, 5));
+	rt_band_get_pixel(band, 4, 0, &val);
+	CHECK(FLT_EQ(val, 0));
+	deepRelease(ov);
+
+	ov = rt_raster_build_overview(rast, 2, 0, 0, 4, 2, 2, OA_MODE);
+	CHECK(ov);
+	band = rt_raster_get_band(ov, 0);
+	rt_band_get_pixel(band, 0, 0, &val);
+	CHECK(FLT_EQ(val, 3));
+	rt_band_get_pixel(band, 3, 1, &val);
+	CHECK(FLT_EQ(val, 5));
+	deepRelease(ov);
+
+	ov = rt_raster_build_overview(rast, 2, 0, 0, 4, 2, 2, OA_NEAREST);
+	CHECK(ov);
+	band = rt_raster_get_band(ov, 0);
+	rt_band_get_pixel(band, 0, 0, &val);
+	CHECK(FLT_EQ(val, 1));
+	deepRelease(ov);
+
+	/* overview tile starting inside the second source tile */
+	ov = rt_raster_build_overview(rast, 2, 6, -2, 2, 1, 2, OA_MEAN);
+	CHECK(ov);
+	band = rt_raster_get_band(ov, 0);
+	rt_band_get_pixel(band, 0, 0, &val);
+	CHECK(FLT_EQ(val, 5));
+	rt_band_get_pixel(band, 1, 0, &val);
+	CHECK(FLT_EQ(val, 0));
+	deepRelease(ov);
+
+	CHECK_EQUALS(rt_util_overview_alg("MODE"), OA_MODE);
+	CHECK_EQUALS(rt_util_overview_alg("AVERAGE"), OA_MEAN);
+	CHECK_EQUALS(rt_util_overview_alg("NEARESTNEIGHBOUR"), OA_NEAREST);
+	CHECK_EQUALS(rt_util_overview_alg("NEARESTNEIGHBOR"), OA_NEAREST);
+	CHECK_EQUALS(rt_util_overview_alg(""), OA_NEAREST);
+
+	/* unknown kernels are refused, not replaced by nearest */
+	CHECK_EQUALS(rt_util_overview_alg("BILINEAR"), OA_END);
+	ov = rt_raster_build_overview(rast, 2, 0, 0, 4, 2, 2, OA_END);
+	CHECK(!ov);
+
+	deepRelease(rast[0]);
+	deepRelease(rast[1]);
+}
+
 static void testLoadOfflineBand() {
 	rt_raster rast;
 	rt_band band;
@@ -2817,6 +3265,18 @@ main()
 		testFromTwoRasters();
 		printf("OK\n");
 
+		printf("Testing rt_raster_deserialize... ");
+		testRasterDeserialize();
+		printf("OK\n");
+
+		printf("Testing rt_band_get_summary... ");
+		testBandSummary();
+		printf("OK\n");
+
+		printf("Testing rt_raster_build_overview... ");
+		testBuildOverview();
+		printf("OK\n");
+
 		printf("Testing rt_raster_load_offline_band... ");
 		testLoadOfflineBand();
 		printf("OK\n");
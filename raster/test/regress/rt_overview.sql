@@ -0,0 +1,30 @@
+SET client_min_messages TO warning;
+
+DROP TABLE IF EXISTS raster_overview;
+CREATE TABLE raster_overview (
+	rid integer,
+	rast raster
+);
+
+INSERT INTO raster_overview VALUES
+	(1, ST_AddBand(ST_MakeEmptyRaster(2, 2, 0, 2, 1, -1, 0, 0, 0), 1, '8BUI', 1, 0)),
+	(2, ST_AddBand(ST_MakeEmptyRaster(2, 2, 2, 2, 1, -1, 0, 0, 0), 1, '8BUI', 2, 0));
+
+SELECT ST_CreateOverview('', 'raster_overview', 'rast', 2);
+SELECT 'create', ST_UpperLeftX(rast), ST_UpperLeftY(rast), ST_Width(rast), ST_ScaleX(rast)
+	FROM o_2_raster_overview ORDER BY 2;
+
+-- a new tile grows the coverage left, the overview keeps its grid
+INSERT INTO raster_overview VALUES
+	(3, ST_AddBand(ST_MakeEmptyRaster(2, 2, -2, 2, 1, -1, 0, 0, 0), 1, '8BUI', 3, 0));
+SELECT 'update', ST_UpdateOverview(
+	'', 'o_2_raster_overview', 'rast',
+	'', 'raster_overview', 'rast',
+	2, 'NearestNeighbour',
+	(SELECT ST_Envelope(rast) FROM raster_overview WHERE rid = 3)
+);
+SELECT 'grid', ST_UpperLeftX(rast), ST_UpperLeftY(rast)
+	FROM o_2_raster_overview ORDER BY 2;
+
+DROP TABLE o_2_raster_overview;
+DROP TABLE raster_overview;
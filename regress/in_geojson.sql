@@ -5,6 +5,9 @@ select 'geomfromgeojson_03',st_astext(st_geomfromgeojson(st_asgeojson('POINT(1 1
 select 'geomfromgeojson_04',st_astext(st_geomfromgeojson(st_asgeojson('LINESTRING(0 0,1 1)')));
 select 'geomfromgeojson_05',st_astext(st_geomfromgeojson(st_asgeojson('POLYGON((0 0,1 1,1 0,0 0))')));
 select 'geomfromgeojson_06',st_astext(st_geomfromgeojson(st_asgeojson('MULTIPOLYGON(((0 0,1 1,1 0,0 0)))')));
+select 'geomfromgeojson_07',st_asewkt(st_geomfromgeojson(st_asgeojson('GEOMETRYCOLLECTION(POINT(1 1),LINESTRING(0 0,1 1))')));
+select 'geomfromgeojson_08',st_asewkt(st_geomfromgeojson(st_asgeojson('LINESTRING(0 0 1,1 1 2)')));
+select 'geomfromgeojson_09',st_asewkt(st_geomfromgeojson('{"coordinates":[[0,0],[1,1,5]],"bbox":[0,0,1,1],"TYPE":"linestring"}'));
 
 -- #1434
 select '#1434: Next two errors';
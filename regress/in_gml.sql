@@ -920,6 +920,14 @@ SELECT 'data_1', ST_AsEWKT(ST_GeomFromGML('<gml:LineString><gml:pos>1 2</gml:pos
 -- Mixed pos, posList, pointProperty, pointRep
 SELECT 'data_2', ST_AsEWKT(ST_GeomFromGML('<gml:LineString><gml:pos>1 2</gml:pos><gml:posList>3 4 5 6</gml:posList><gml:pointProperty><gml:Point><gml:pos>7 8</gml:pos></gml:Point></gml:pointProperty><gml:pointRep><gml:Point><gml:coordinates>9,10</gml:coordinates></gml:Point></gml:pointRep></gml:LineString>'));
 
+-- Several pos siblings
+SELECT 'data_3', ST_AsEWKT(ST_GeomFromGML('<gml:LineString><gml:pos>1 2</gml:pos><gml:pos>3 4</gml:pos><gml:pos>5 6</gml:pos></gml:LineString>'));
+
+-- Tabs and newlines, count attribute
+SELECT 'data_4', ST_AsEWKT(ST_GeomFromGML('<gml:LineString><gml:posList count="3">1	2
+3	4
+5	6</gml:posList></gml:LineString>'));
+
 
 
 
@@ -0,0 +1,35 @@
+-- KNN ordering on the geography GiST opclass must match the exact
+-- spheroid distance, not the geocentric bound the index walks by
+CREATE TABLE knn_geog AS
+	SELECT i AS id, ST_MakePoint(i / 10.0, 0)::geography AS gg
+	FROM generate_series(0, 999) i;
+INSERT INTO knn_geog
+	SELECT 1000 + i, ST_MakePoint((i % 20) / 2.0, 60 + (i / 20) / 2.0)::geography
+	FROM generate_series(0, 599) i;
+
+-- Same geocentric angle from the query point, but a degree of latitude
+-- is shorter on the spheroid than the matching east-west arc
+INSERT INTO knn_geog VALUES (2001, 'POINT(0 1)'), (2002, 'POINT(0.998 0)');
+INSERT INTO knn_geog VALUES (2003, 'POINT(0 71)'), (2004, 'POINT(2.918 70)');
+DELETE FROM knn_geog WHERE gg && 'POLYGON((-0.5 -0.5, 3 -0.5, 3 0.5, -0.5 0.5, -0.5 -0.5))'::geography AND id < 2000;
+DELETE FROM knn_geog WHERE id BETWEEN 1000 AND 1999 AND gg && 'POLYGON((-0.5 68.4, 4.4 68.4, 4.4 71.6, -0.5 71.6, -0.5 68.4))'::geography;
+
+SELECT 'seq.equator', id FROM knn_geog ORDER BY gg <-> 'POINT(0 0)'::geography LIMIT 1;
+SELECT 'seq.arctic', id FROM knn_geog ORDER BY gg <-> 'POINT(0 70)'::geography LIMIT 1;
+
+CREATE INDEX knn_geog_gg ON knn_geog USING gist (gg);
+ANALYZE knn_geog;
+SET enable_seqscan = off;
+
+SELECT 'geog', id, round((gg <-> 'POINT(10.03 0)'::geography)::numeric, 0)
+	FROM knn_geog ORDER BY gg <-> 'POINT(10.03 0)'::geography LIMIT 5;
+SELECT 'idx.equator', id FROM knn_geog ORDER BY gg <-> 'POINT(0 0)'::geography LIMIT 1;
+SELECT 'idx.arctic', id FROM knn_geog ORDER BY gg <-> 'POINT(0 70)'::geography LIMIT 1;
+SELECT 'idx.grid', array_to_string(array(
+	SELECT id FROM knn_geog ORDER BY gg <-> 'POINT(3.3 62.7)'::geography LIMIT 10), ',') =
+	array_to_string(array(
+	SELECT id FROM (SELECT id, ST_Distance(gg, 'POINT(3.3 62.7)'::geography) AS d
+		FROM knn_geog OFFSET 0) AS foo ORDER BY d LIMIT 10), ',');
+
+RESET enable_seqscan;
+DROP TABLE knn_geog;
@@ -0,0 +1,14 @@
+-- KNN ordering on the N-D GiST opclass
+CREATE TABLE knn_nd AS
+	SELECT i AS id,
+		ST_MakePoint(i, 0, (i % 5) * 10) AS g
+	FROM generate_series(0, 999) i;
+CREATE INDEX knn_nd_g ON knn_nd USING gist (g gist_geometry_ops_nd);
+ANALYZE knn_nd;
+SET enable_seqscan = off;
+
+SELECT 'nd', id, round((g <<->> 'POINT(100.3 0 20)'::geometry)::numeric, 3)
+	FROM knn_nd ORDER BY g <<->> 'POINT(100.3 0 20)'::geometry LIMIT 5;
+
+RESET enable_seqscan;
+DROP TABLE knn_nd;
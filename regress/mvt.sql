@@ -0,0 +1,18 @@
+-- One feature, with an integer and a text tag
+SELECT 'mvt_01', encode(ST_AsMVT('test', 'BOX(0 0,4096 4096)'::box2d, q), 'hex')
+FROM (SELECT 1::int4 AS id, 'a'::text AS name, 'POINT(25 4079)'::geometry AS geom) AS q;
+
+-- Rows outside the tile leave an empty layer
+SELECT 'mvt_02', encode(ST_AsMVT('test', 'BOX(0 0,4096 4096)'::box2d, q), 'hex')
+FROM (SELECT 1::int4 AS id, 'a'::text AS name, 'POINT(9000 9000)'::geometry AS geom) AS q;
+
+-- Values are shared, NULL columns are left out, extent and buffer
+SELECT 'mvt_03', encode(ST_AsMVT('l', 'BOX(0 0,1 1)'::box2d, 256, 0, q), 'hex')
+FROM (SELECT 'LINESTRING(0 0,1 1)'::geometry AS geom, true AS b UNION ALL
+      SELECT 'POINT(0.5 0.5)'::geometry, NULL UNION ALL
+      SELECT 'POINT(0.5 0.5)'::geometry, true) AS q;
+
+SELECT 'mvt_04', ST_AsMVT('test', 'BOX(0 0,1 1)'::box2d, q) FROM (SELECT 1 AS id) AS q;
+
+-- The row argument must be a row
+SELECT 'mvt_05', ST_AsMVT('test', 'BOX(0 0,1 1)'::box2d, 5);
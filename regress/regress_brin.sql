@@ -0,0 +1,34 @@
+-- BRIN inclusion opclasses must answer like a sequential scan
+CREATE TABLE brin_pts AS
+	SELECT i AS id,
+		ST_MakePoint(i % 100, i / 100) AS g,
+		ST_MakePoint(i % 100, i / 100, i % 7) AS g3,
+		ST_MakePoint((i % 100) / 10.0, (i / 100) / 10.0)::geography AS gg
+	FROM generate_series(0, 9999) i;
+INSERT INTO brin_pts VALUES (10000, 'POINT EMPTY', 'POINT EMPTY', 'POINT EMPTY');
+INSERT INTO brin_pts VALUES (10001, NULL, NULL, NULL);
+
+SELECT 'seq.overlap', count(*) FROM brin_pts WHERE g && ST_MakeEnvelope(10, 10, 19.5, 20);
+SELECT 'seq.within', count(*) FROM brin_pts WHERE g @ ST_MakeEnvelope(10, 10, 19.5, 20);
+SELECT 'seq.contains', count(*) FROM brin_pts WHERE g ~ 'POINT(42 17)'::geometry;
+SELECT 'seq.nd', count(*) FROM brin_pts WHERE g3 &&& 'LINESTRING(10 10 2, 19.5 20 3)'::geometry;
+SELECT 'seq.geog', count(*) FROM brin_pts WHERE gg && 'POLYGON((1 1, 1.95 1, 1.95 2, 1 2, 1 1))'::geography;
+
+CREATE INDEX brin_pts_2d ON brin_pts USING brin (g brin_geometry_inclusion_ops_2d) WITH (pages_per_range = 4);
+CREATE INDEX brin_pts_nd ON brin_pts USING brin (g3 brin_geometry_inclusion_ops_nd) WITH (pages_per_range = 4);
+CREATE INDEX brin_pts_geog ON brin_pts USING brin (gg brin_geography_inclusion_ops) WITH (pages_per_range = 4);
+SET enable_seqscan = off;
+
+SELECT 'brin.overlap', count(*) FROM brin_pts WHERE g && ST_MakeEnvelope(10, 10, 19.5, 20);
+SELECT 'brin.within', count(*) FROM brin_pts WHERE g @ ST_MakeEnvelope(10, 10, 19.5, 20);
+SELECT 'brin.contains', count(*) FROM brin_pts WHERE g ~ 'POINT(42 17)'::geometry;
+SELECT 'brin.nd', count(*) FROM brin_pts WHERE g3 &&& 'LINESTRING(10 10 2, 19.5 20 3)'::geometry;
+SELECT 'brin.geog', count(*) FROM brin_pts WHERE gg && 'POLYGON((1 1, 1.95 1, 1.95 2, 1 2, 1 1))'::geography;
+SELECT 'brin.notnull', count(*) FROM brin_pts WHERE g IS NOT NULL;
+
+-- Summaries must grow with appended rows
+INSERT INTO brin_pts VALUES (10002, 'POINT(500 500)', 'POINT(500 500 0)', 'POINT(50 50)');
+SELECT 'brin.append', count(*) FROM brin_pts WHERE g && ST_MakeEnvelope(499, 499, 501, 501);
+
+RESET enable_seqscan;
+DROP TABLE brin_pts;
@@ -13,4 +13,22 @@ set enable_seqscan = off;
 
  select num,ST_astext(the_geom) from test where the_geom && 'BOX3D(125 125,135 135)'::box3d  order by num;
 
+-- N-D GiST index
+
+CREATE INDEX quick_gist_nd on test using gist (the_geom gist_geometry_ops_nd);
+
+ select num,ST_astext(the_geom) from test where the_geom &&& 'LINESTRING(125 125,135 135)'::geometry order by num;
+
+-- Extent read from the 2D GiST index keys
+
+ select 'find_extent', ST_find_extent('test', 'the_geom')::text = (select ST_Extent(the_geom)::text from test);
+
+ delete from test where ST_X(the_geom) < 10 or ST_Y(the_geom) > 990;
+
+ select 'find_extent_delete', ST_find_extent('test', 'the_geom')::text = (select ST_Extent(the_geom)::text from test);
+
+ insert into test values (-1, 'POINT EMPTY');
+
+ select 'find_extent_empty', ST_find_extent('test', 'the_geom')::text = (select ST_Extent(the_geom)::text from test);
+
 DROP TABLE test;
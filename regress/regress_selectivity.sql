@@ -0,0 +1,70 @@
+-- Planner row estimates from the 2-D, N-D and geography statistics.
+-- Most of the points crowd into a small "city", so a uniform grid over
+-- the extent would miss the estimates by orders of magnitude.
+CREATE TABLE sel_pts AS
+	SELECT i AS id, ST_MakePoint((i % 95) / 9.5, (i / 95) / 9.5, i % 100) AS g
+	FROM generate_series(0, 8999) i
+	UNION ALL
+	SELECT 9000 + i, ST_MakePoint(10 + (i % 40) * 25, 10 + (i / 40) * 40, i % 100)
+	FROM generate_series(0, 999) i;
+CREATE TABLE sel_polys AS
+	SELECT i AS id, ST_MakeEnvelope(i % 5, i / 5, i % 5 + 1, i / 5 + 1) AS g
+	FROM generate_series(0, 24) i;
+CREATE TABLE sel_boxes AS
+	SELECT i AS id, ST_MakeLine(ST_MakePoint(i % 5, i / 5, 0), ST_MakePoint(i % 5 + 1, i / 5 + 1, 49)) AS g
+	FROM generate_series(0, 24) i;
+CREATE TABLE sel_geog_pts AS
+	SELECT id, ST_Force_2D(ST_Scale(g, 0.01, 0.01, 1))::geography AS g FROM sel_pts;
+CREATE TABLE sel_geog_polys AS
+	SELECT id, ST_Scale(g, 0.01, 0.01)::geography AS g FROM sel_polys;
+ANALYZE sel_pts;
+ANALYZE sel_polys;
+ANALYZE sel_boxes;
+ANALYZE sel_geog_pts;
+ANALYZE sel_geog_polys;
+
+CREATE FUNCTION sel_plan_rows(q text) RETURNS int AS $$
+DECLARE
+	r record;
+BEGIN
+	FOR r IN EXECUTE 'EXPLAIN ' || q LOOP
+		RETURN substring(r."QUERY PLAN" from ' rows=([0-9]+)')::int;
+	END LOOP;
+END
+$$ LANGUAGE 'plpgsql';
+
+-- Is the planner estimate of q within a factor of 10 of the row count?
+CREATE FUNCTION sel_close(q text) RETURNS boolean AS $$
+DECLARE
+	est int;
+	cnt int;
+BEGIN
+	est := sel_plan_rows(q);
+	EXECUTE 'SELECT count(*) FROM (' || q || ') AS q' INTO cnt;
+	IF est BETWEEN cnt / 10 AND cnt * 10 THEN
+		RETURN true;
+	END IF;
+	RAISE NOTICE 'estimated % rows, got %', est, cnt;
+	RETURN false;
+END
+$$ LANGUAGE 'plpgsql';
+
+-- 2-D bucket histogram
+SELECT 'sel.2d.city', sel_close('SELECT 1 FROM sel_pts WHERE g && ST_MakeEnvelope(2, 2, 4, 4)');
+SELECT 'sel.2d.rural', sel_close('SELECT 1 FROM sel_pts WHERE g && ST_MakeEnvelope(100, 100, 600, 600)');
+
+-- N-D histogram: a height band over the whole extent
+SELECT 'sel.nd.z', sel_close('SELECT 1 FROM sel_pts WHERE g &&& ''LINESTRING(0 0 10, 1000 1000 19)''::geometry');
+
+-- Histogram overlay joins
+SELECT 'sel.2d.join', sel_close('SELECT 1 FROM sel_pts p, sel_polys a WHERE p.g && a.g');
+SELECT 'sel.nd.join', sel_close('SELECT 1 FROM sel_pts p, sel_boxes a WHERE p.g &&& a.g');
+SELECT 'sel.geog.join', sel_close('SELECT 1 FROM sel_geog_pts p, sel_geog_polys a WHERE p.g && a.g');
+
+DROP FUNCTION sel_close(text);
+DROP FUNCTION sel_plan_rows(text);
+DROP TABLE sel_pts;
+DROP TABLE sel_polys;
+DROP TABLE sel_boxes;
+DROP TABLE sel_geog_pts;
+DROP TABLE sel_geog_polys;
@@ -0,0 +1,31 @@
+-- SP-GiST point opclasses must answer like a sequential scan
+CREATE TABLE spgist_pts AS
+	SELECT i AS id, ST_MakePoint(i % 100, i / 100) AS g
+	FROM generate_series(0, 9999) i;
+INSERT INTO spgist_pts VALUES (10000, 'POINT EMPTY');
+
+SELECT 'seq.overlap', count(*) FROM spgist_pts WHERE g && ST_MakeEnvelope(10, 10, 19.5, 20);
+SELECT 'seq.within', count(*) FROM spgist_pts WHERE g @ ST_MakeEnvelope(10, 10, 19.5, 20);
+SELECT 'seq.contains', count(*) FROM spgist_pts WHERE g ~ 'POINT(42 17)'::geometry;
+
+SET enable_seqscan = off;
+
+CREATE INDEX spgist_pts_quad ON spgist_pts USING spgist (g spgist_geometry_ops_quad_2d);
+SELECT 'quad.overlap', count(*) FROM spgist_pts WHERE g && ST_MakeEnvelope(10, 10, 19.5, 20);
+SELECT 'quad.within', count(*) FROM spgist_pts WHERE g @ ST_MakeEnvelope(10, 10, 19.5, 20);
+SELECT 'quad.contains', count(*) FROM spgist_pts WHERE g ~ 'POINT(42 17)'::geometry;
+SELECT 'quad.empty', count(*) FROM spgist_pts WHERE g && 'POINT EMPTY'::geometry;
+DROP INDEX spgist_pts_quad;
+
+CREATE INDEX spgist_pts_kd ON spgist_pts USING spgist (g spgist_geometry_ops_kd_2d);
+SELECT 'kd.overlap', count(*) FROM spgist_pts WHERE g && ST_MakeEnvelope(10, 10, 19.5, 20);
+SELECT 'kd.within', count(*) FROM spgist_pts WHERE g @ ST_MakeEnvelope(10, 10, 19.5, 20);
+SELECT 'kd.contains', count(*) FROM spgist_pts WHERE g ~ 'POINT(42 17)'::geometry;
+SELECT 'kd.empty', count(*) FROM spgist_pts WHERE g && 'POINT EMPTY'::geometry;
+DROP INDEX spgist_pts_kd;
+
+-- Only points can go in
+CREATE INDEX spgist_lines_quad ON spgist_pts USING spgist (ST_MakeLine(g, g) spgist_geometry_ops_quad_2d);
+
+RESET enable_seqscan;
+DROP TABLE spgist_pts;
@@ -0,0 +1,64 @@
+-- Spatio-temporal keys must answer like the spatial and time tests
+-- they stand for, with and without a gist_gidx_ops index
+CREATE TABLE st_pts AS
+	SELECT i AS id,
+		ST_MakePoint(i % 100, i / 100) AS g,
+		'2011-01-01 00:00:00+00'::timestamptz + i * interval '1 minute' AS ts
+	FROM generate_series(0, 9999) i;
+INSERT INTO st_pts VALUES (10000, 'POINT EMPTY', '2011-01-02 12:00:00+00');
+INSERT INTO st_pts VALUES (10001, NULL, '2011-01-02 12:00:00+00');
+INSERT INTO st_pts VALUES (10002, 'POINT(15 15)', NULL);
+INSERT INTO st_pts VALUES (10003, 'POINT(15 15)', 'infinity');
+
+CREATE FUNCTION st_plan_uses(q text, idx text) RETURNS boolean AS $$
+DECLARE
+	r record;
+BEGIN
+	FOR r IN EXECUTE 'EXPLAIN ' || q LOOP
+		IF r."QUERY PLAN" LIKE '%' || idx || '%' THEN
+			RETURN true;
+		END IF;
+	END LOOP;
+	RETURN false;
+END
+$$ LANGUAGE 'plpgsql';
+
+CREATE FUNCTION st_plan_rows(q text) RETURNS int AS $$
+DECLARE
+	r record;
+BEGIN
+	FOR r IN EXECUTE 'EXPLAIN ' || q LOOP
+		RETURN substring(r."QUERY PLAN" from ' rows=([0-9]+)')::int;
+	END LOOP;
+END
+$$ LANGUAGE 'plpgsql';
+
+SELECT 'key.in', ST_STKey('POINT(1 1)'::geometry, '2011-01-01 00:00:00'::timestamp) &&& ST_STKey('POINT(1 1)'::geometry, '2011-01-01 00:00:00'::timestamp, '2011-01-01 00:00:00'::timestamp);
+SELECT 'key.before', ST_STKey('POINT(1 1)'::geometry, '2011-01-01 00:00:00'::timestamp) &&& ST_STKey('POINT(1 1)'::geometry, '2011-01-02 00:00:00'::timestamp, '2011-01-03 00:00:00'::timestamp);
+SELECT 'key.empty', ST_STKey('POINT EMPTY'::geometry, '2011-01-01 00:00:00'::timestamp) IS NULL;
+
+SELECT 'seq.exact', count(*) FROM st_pts WHERE g && ST_MakeEnvelope(10, 10, 19.5, 20) AND ts BETWEEN '2011-01-02 01:00:00+00' AND '2011-01-03 02:00:00+00';
+SELECT 'seq.key', count(*) FROM st_pts WHERE ST_STKey(g, ts) &&& ST_STKey(ST_MakeEnvelope(10, 10, 19.5, 20), '2011-01-02 01:00:00+00'::timestamptz, '2011-01-03 02:00:00+00'::timestamptz);
+
+CREATE INDEX st_pts_idx ON st_pts USING gist (ST_STKey(g, ts));
+ANALYZE st_pts;
+
+-- the index expression statistics replace the default estimate
+SELECT 'idx.sel', st_plan_rows('SELECT 1 FROM st_pts WHERE ST_STKey(g, ts) &&& ST_STKey(ST_MakeEnvelope(10, 10, 19.5, 20), ''2011-01-02 01:00:00+00''::timestamptz, ''2011-01-03 02:00:00+00''::timestamptz)') BETWEEN 6 AND 2000;
+
+SET enable_seqscan = off;
+
+SELECT 'idx.plan', st_plan_uses('SELECT 1 FROM st_pts WHERE ST_STKey(g, ts) &&& ST_STKey(ST_MakeEnvelope(10, 10, 19.5, 20), ''2011-01-02 01:00:00+00''::timestamptz, ''2011-01-03 02:00:00+00''::timestamptz)', 'st_pts_idx');
+SELECT 'idx.key', count(*) FROM st_pts WHERE ST_STKey(g, ts) &&& ST_STKey(ST_MakeEnvelope(10, 10, 19.5, 20), '2011-01-02 01:00:00+00'::timestamptz, '2011-01-03 02:00:00+00'::timestamptz);
+SELECT 'idx.exact', count(*) FROM st_pts WHERE ST_STKey(g, ts) &&& ST_STKey(ST_MakeEnvelope(10, 10, 19.5, 20), '2011-01-02 01:00:00+00'::timestamptz, '2011-01-03 02:00:00+00'::timestamptz) AND g && ST_MakeEnvelope(10, 10, 19.5, 20) AND ts BETWEEN '2011-01-02 01:00:00+00' AND '2011-01-03 02:00:00+00';
+SELECT 'idx.open', count(*) FROM st_pts WHERE ST_STKey(g, ts) &&& ST_STKey(ST_MakeEnvelope(10, 10, 19.5, 20), '-infinity'::timestamptz, '2011-01-03 02:00:00+00'::timestamptz);
+
+-- 2-D search keys match any height, 3-D ones only their own
+INSERT INTO st_pts VALUES (10004, 'POINT(15 15 100)', '2011-01-02 03:00:00+00');
+SELECT 'idx.2d', count(*) FROM st_pts WHERE ST_STKey(g, ts) &&& ST_STKey(ST_MakeEnvelope(10, 10, 19.5, 20), '2011-01-02 01:00:00+00'::timestamptz, '2011-01-03 02:00:00+00'::timestamptz);
+SELECT 'idx.3d', count(*) FROM st_pts WHERE ST_STKey(g, ts) &&& ST_STKey('LINESTRING(10 10 0, 19.5 20 1)'::geometry, '2011-01-02 01:00:00+00'::timestamptz, '2011-01-03 02:00:00+00'::timestamptz);
+
+RESET enable_seqscan;
+DROP FUNCTION st_plan_uses(text, text);
+DROP FUNCTION st_plan_rows(text);
+DROP TABLE st_pts;
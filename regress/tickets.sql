@@ -460,6 +460,34 @@ truncate t;
 select '#818.1', st_estimated_extent('t','g');
 drop table t;
 
+-- estimated extent from the index root page, no analyze needed
+create table t(g geometry);
+create index t_g on t using gist(g);
+select 'estext.1', st_estimated_extent('t','g');
+insert into t(g) values ('LINESTRING(-10 -50, 20 30)');
+insert into t(g) values ('POINT(40 5)');
+select 'estext.2', st_estimated_extent('t','g');
+drop table t;
+-- empty geometries do not count
+create table t(g geometry);
+create index t_g on t using gist(g);
+insert into t(g) values ('LINESTRING(10 20, 30 40)');
+insert into t(g) values ('POINT(35 25)');
+insert into t(g) values ('POINT EMPTY');
+analyze t;
+select 'estext.3', st_estimated_extent('t','g');
+drop table t;
+-- nor do they stretch the keys above them on deeper indexes
+create table t(g geometry);
+create index t_g on t using gist(g);
+insert into t(g) select ST_MakePoint(-i, -2*i) from generate_series(1, 5000) i;
+insert into t(g) values ('POINT EMPTY');
+insert into t(g) select ST_MakePoint(-i, -2*i) from generate_series(5001, 10000) i;
+insert into t(g) values ('SRID=4326;POINT EMPTY');
+select 'estext.4', st_estimated_extent('t','g');
+select 'estext.5', count(*) from t where g && 'LINESTRING(-10 -10, 10 10)'::geometry;
+drop table t;
+
 -- #1320
 SELECT '<#1320>';
 CREATE TABLE A ( geom geometry(MultiPolygon, 4326),
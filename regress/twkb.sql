@@ -0,0 +1,24 @@
+-- Single geometries
+SELECT 'twkb_point_01', encode(ST_AsTWKB('POINT(1 2)'::geometry), 'hex');
+SELECT 'twkb_point_02', encode(ST_AsTWKB('POINT(1.25 -2.5)'::geometry, 1), 'hex');
+SELECT 'twkb_point_03', encode(ST_AsTWKB('POINTM(1 2 3)'::geometry, 0, 0, 2), 'hex');
+SELECT 'twkb_line_01', encode(ST_AsTWKB('LINESTRING(1 1,5 5)'::geometry, 0, 0, 0, false, true), 'hex');
+SELECT 'twkb_line_02', encode(ST_AsTWKB('LINESTRING(1 1,5 5)'::geometry, 0, 0, 0, true, false), 'hex');
+SELECT 'twkb_empty_01', encode(ST_AsTWKB('POINT EMPTY'::geometry), 'hex');
+
+-- Round trips
+SELECT 'twkb_in_01', ST_AsText(ST_GeomFromTWKB(ST_AsTWKB('POINT(1.2345678 -2.3456789)'::geometry, 3)));
+SELECT 'twkb_in_02', ST_AsText(ST_GeomFromTWKB(ST_AsTWKB('MULTIPOLYGON(((0 0,0 1,1 1,0 0)),((5 5,5 6,6 6,5 5)))'::geometry, 0, 0, 0, true, true)));
+SELECT 'twkb_in_03', ST_AsText(ST_GeomFromTWKB(ST_AsTWKB('GEOMETRYCOLLECTION(POINT(1 1),LINESTRING(0 0,1 1))'::geometry)));
+
+-- Id lists
+SELECT 'twkb_array_01', encode(ST_AsTWKB(ARRAY['POINT(0 0)'::geometry, 'POINT(1 1)'::geometry], ARRAY[10, 20]::bigint[]), 'hex');
+SELECT 'twkb_array_02', encode(ST_AsTWKB(ARRAY['POINT(1 1)'::geometry, NULL, 'POINT(1 1)'::geometry], ARRAY[1, 2, 3]::bigint[]), 'hex');
+SELECT 'twkb_array_03', ST_AsText(ST_GeomFromTWKB(ST_AsTWKB(ARRAY['POINT(1 1)'::geometry, 'LINESTRING(0 0,1 1)'::geometry], ARRAY[1, 2]::bigint[])));
+SELECT 'twkb_agg_01', encode(ST_AsTWKBAgg(g, id), 'hex') FROM (SELECT 'POINT(0 0)'::geometry AS g, 10::bigint AS id UNION ALL SELECT 'POINT(1 1)', 20) AS t;
+SELECT 'twkb_agg_02', ST_AsText(ST_GeomFromTWKB(ST_AsTWKBAgg(g, id, 1))) FROM (SELECT 'POINT(0.25 0)'::geometry AS g, 1::bigint AS id UNION ALL SELECT 'POINT(1 1)', 2) AS t;
+
+-- Errors
+SELECT 'twkb_error_01', ST_AsTWKB('POINT(1 2)'::geometry, 8);
+SELECT 'twkb_error_02', ST_AsTWKB('CIRCULARSTRING(0 0,1 1,2 0)'::geometry);
+SELECT 'twkb_error_03', ST_AsTWKB(ARRAY['POINT(0 0)'::geometry], ARRAY[1, 2]::bigint[]);
@@ -0,0 +1,235 @@
+#!/usr/bin/perl -w
+
+# $Id$
+#
+# Build a GiST index on a geometry column with each of the given
+# operator classes and report the index size, the build time and the
+# number of index pages read by box queries centered on randomly picked
+# features. Run it against builds before and after a change to the
+# penalty or picksplit functions to compare the trees they produce.
+# Operator classes named spgist_* are built as SP-GiST indexes, so
+# point columns can compare both access methods.
+#
+# Page counts come from EXPLAIN (ANALYZE, BUFFERS), so PostgreSQL 9.0
+# or later is required.
+#
+
+use Pg;
+use Time::HiRes("gettimeofday");
+
+$VERBOSE = 0;
+$PROBES = 100;
+$INDEX = 'profile_gist_index_tmp';
+
+sub usage
+{
+	local($me) = `basename $0`;
+	chop($me);
+	print STDERR "$me [-v] [-probes <n>] [-opclass <opclass>[,<opclass>]] [-zsize <size>] -size <size>[,<size>] <table> [<col>]\n";
+}
+
+$TABLE='';
+$COLUMN='';
+for ($i=0; $i<@ARGV; $i++)
+{
+	if ( $ARGV[$i] =~ m/^-/ )
+	{
+		if ( $ARGV[$i] eq '-v' )
+		{
+			$VERBOSE++;
+		}
+		elsif ( $ARGV[$i] eq '-size' )
+		{
+			push(@size_list, split(',', $ARGV[++$i]));
+		}
+		elsif ( $ARGV[$i] eq '-zsize' )
+		{
+			$ZSIZE = $ARGV[++$i];
+		}
+		elsif ( $ARGV[$i] eq '-probes' )
+		{
+			$PROBES = $ARGV[++$i];
+		}
+		elsif ( $ARGV[$i] eq '-opclass' )
+		{
+			push(@opclass_list, split(',', $ARGV[++$i]));
+		}
+		else
+		{
+			print STDERR "Unknown option $ARGV[$i]:\n";
+			usage();
+			exit(1);
+		}
+	}
+	elsif ( ! $TABLE )
+	{
+		$TABLE = $ARGV[$i];
+	}
+	elsif ( ! $COLUMN )
+	{
+		$COLUMN = $ARGV[$i];
+	}
+	else
+	{
+		print STDERR "Too many options:\n";
+		usage();
+		exit(1);
+	}
+}
+
+if ( ! $TABLE || ! @size_list )
+{
+	usage();
+	exit 1;
+}
+
+@opclass_list = ('gist_geometry_ops_2d', 'gist_geometry_ops_nd')
+	if ( ! @opclass_list );
+
+$SCHEMA = 'public';
+$COLUMN = 'the_geom' if ( $COLUMN eq '' );
+if ( $TABLE =~ /(.*)\.(.*)/ )
+{
+	$SCHEMA = $1;
+	$TABLE = $2;
+}
+
+#connect
+$conn = Pg::connectdb("");
+if ( $conn->status != PGRES_CONNECTION_OK ) {
+	print STDERR $conn->errorMessage;
+	exit(1);
+}
+
+if ( $VERBOSE )
+{
+	print "Table: \"$SCHEMA\".\"$TABLE\"\n";
+	print "Column: \"$COLUMN\"\n";
+}
+
+# pick the probe boxes, keeping the Z range of the picked feature
+# so that the n-d index gets queried in all of its dimensions
+$query = 'SELECT ST_X(c), ST_Y(c), ST_ZMin(g), ST_ZMax(g), ST_SRID(g) '.
+	'FROM ( SELECT "'.$COLUMN.'" AS g, '.
+	'ST_Centroid(ST_Envelope("'.$COLUMN.'")) AS c FROM "'.
+	$SCHEMA.'"."'.$TABLE.'" WHERE "'.$COLUMN.'" IS NOT NULL '.
+	'AND NOT ST_IsEmpty("'.$COLUMN.'") '.
+	"ORDER BY random() LIMIT $PROBES ) AS foo";
+$res = $conn->exec($query);
+if ( $res->resultStatus != PGRES_TUPLES_OK )  {
+	print STDERR $conn->errorMessage;
+	exit(1);
+}
+@probes = ();
+for ($i=0; $i<$res->ntuples; $i++)
+{
+	push(@probes, [ $res->getvalue($i, 0), $res->getvalue($i, 1),
+		$res->getvalue($i, 2), $res->getvalue($i, 3) ]);
+	$SRID = $res->getvalue($i, 4);
+}
+
+print "Probes: ".@probes."\n";
+
+print "opclass\t\t\tpages\tbuild(s)\tbox\tmatches\tpages/query\n";
+print "----------------------------------------------------------------------------------\n";
+
+foreach $opclass (@opclass_list)
+{
+	$operator = ( $opclass =~ /_nd$/ ) ? '&&&' : '&&';
+	$method = ( $opclass =~ /^spgist_/ ) ? 'spgist' : 'gist';
+
+	sql('DROP INDEX IF EXISTS "'.$SCHEMA.'"."'.$INDEX.'"');
+
+	($s1, $ms1) = gettimeofday();
+	sql('CREATE INDEX "'.$INDEX.'" ON "'.$SCHEMA.'"."'.$TABLE.
+		'" USING '.$method.' ("'.$COLUMN.'" '.$opclass.')');
+	($s2, $ms2) = gettimeofday();
+	$build = ($s2-$s1) + ($ms2-$ms1)/1000000;
+
+	$res = sql('SELECT pg_relation_size(\'"'.$SCHEMA.'"."'.$INDEX.'"\') / '.
+		'current_setting(\'block_size\')::int');
+	$pages = $res->getvalue(0, 0);
+
+	sql('SET enable_seqscan = off');
+
+	foreach $size (@size_list)
+	{
+		$zsize = defined($ZSIZE) ? $ZSIZE : $size;
+		$sum_pages = 0;
+		$sum_rows = 0;
+		foreach $probe (@probes)
+		{
+			($idx_pages, $rows) = test_box($operator, $probe, $size, $zsize);
+			$sum_pages += $idx_pages;
+			$sum_rows += $rows;
+		}
+
+		print "$opclass\t$pages\t".(int($build*1000)/1000)."\t\t$size\t".
+			(int($sum_rows/@probes*100)/100)."\t".
+			(int($sum_pages/@probes*100)/100)."\n";
+	}
+
+	sql('RESET enable_seqscan');
+}
+
+sql('DROP INDEX IF EXISTS "'.$SCHEMA.'"."'.$INDEX.'"');
+
+
+##################################################################
+
+sub sql
+{
+	local($query) = shift;
+	local($res);
+
+	print "$query\n" if ( $VERBOSE > 1 );
+	$res = $conn->exec($query);
+	if ( $res->resultStatus != PGRES_TUPLES_OK &&
+	     $res->resultStatus != PGRES_COMMAND_OK )  {
+		print STDERR $conn->errorMessage;
+		exit(1);
+	}
+	return $res;
+}
+
+#
+# Run one box query through the index and return the number of
+# index pages it touched and the number of rows it returned.
+#
+sub test_box
+{
+	local($operator, $probe, $size, $zsize) = @_;
+	local($res, $row, $in_index, $idx_pages, $rows);
+
+	$query = 'EXPLAIN (ANALYZE, BUFFERS) SELECT 1 FROM "'.
+		$SCHEMA.'"."'.$TABLE.'" WHERE "'.$COLUMN.'" '.$operator.
+		' ST_SetSRID(\'LINESTRING('.
+		($probe->[0]-$size/2).' '.($probe->[1]-$size/2).' '.($probe->[2]-$zsize/2).','.
+		($probe->[0]+$size/2).' '.($probe->[1]+$size/2).' '.($probe->[3]+$zsize/2).
+		')\'::geometry, '.$SRID.')';
+	$res = sql($query);
+
+	$in_index = 0;
+	$idx_pages = 0;
+	$rows = 0;
+	while ( ($row=$res->fetchrow()) )
+	{
+		if ( $row =~ /Index Scan .* rows=([0-9]+) loops/ )
+		{
+			$rows = $1;
+			$in_index = 1;
+			next;
+		}
+		if ( $in_index && $row =~ /Buffers:/ )
+		{
+			$idx_pages += $1 if ( $row =~ /hit=([0-9]+)/ );
+			$idx_pages += $1 if ( $row =~ /read=([0-9]+)/ );
+			$in_index = 0;
+		}
+	}
+
+	print "  $operator $size: $rows rows, $idx_pages pages\n"
+		if ( $VERBOSE );
+
+	return ($idx_pages, $rows);
+}
@@ -0,0 +1,205 @@
+#!/usr/bin/perl -w
+
+# $Id$
+#
+# Compare the planner estimates for the && operator to the actual
+# row counts on search boxes centered on randomly picked features,
+# so that crowded areas get tested as often as they get queried.
+# This complements test_estimation.pl, whose evenly spaced boxes
+# mostly land on empty space when the data is clustered.
+#
+
+use Pg;
+
+$VERBOSE = 0;
+$PROBES = 100;
+
+sub usage
+{
+	local($me) = `basename $0`;
+	chop($me);
+	print STDERR "$me [-v] [-vacuum] [-probes <n>] -size <size>[,<size>] <table> [<col>]\n";
+}
+
+$TABLE='';
+$COLUMN='';
+for ($i=0; $i<@ARGV; $i++)
+{
+	if ( $ARGV[$i] =~ m/^-/ )
+	{
+		if ( $ARGV[$i] eq '-v' )
+		{
+			$VERBOSE++;
+		}
+		elsif ( $ARGV[$i] eq '-size' )
+		{
+			push(@size_list, split(',', $ARGV[++$i]));
+		}
+		elsif ( $ARGV[$i] eq '-probes' )
+		{
+			$PROBES = $ARGV[++$i];
+		}
+		elsif ( $ARGV[$i] eq '-vacuum' )
+		{
+			$VACUUM=1;
+		}
+		else
+		{
+			print STDERR "Unknown option $ARGV[$i]:\n";
+			usage();
+			exit(1);
+		}
+	}
+	elsif ( ! $TABLE )
+	{
+		$TABLE = $ARGV[$i];
+	}
+	elsif ( ! $COLUMN )
+	{
+		$COLUMN = $ARGV[$i];
+	}
+	else
+	{
+		print STDERR "Too many options:\n";
+		usage();
+		exit(1);
+	}
+}
+
+if ( ! $TABLE || ! @size_list )
+{
+	usage();
+	exit 1;
+}
+
+$SCHEMA = 'public';
+$COLUMN = 'the_geom' if ( $COLUMN eq '' );
+if ( $TABLE =~ /(.*)\.(.*)/ )
+{
+	$SCHEMA = $1;
+	$TABLE = $2;
+}
+
+#connect
+$conn = Pg::connectdb("");
+if ( $conn->status != PGRES_CONNECTION_OK ) {
+	print STDERR $conn->errorMessage;
+	exit(1);
+}
+
+if ( $VERBOSE )
+{
+	print "Table: \"$SCHEMA\".\"$TABLE\"\n";
+	print "Column: \"$COLUMN\"\n";
+}
+
+# vacuum analyze table
+if ( $VACUUM )
+{
+	print "VACUUM ANALYZE\n";
+	$query = 'vacuum analyze "'.$SCHEMA.'"."'.$TABLE.'"';
+	$res = $conn->exec($query);
+	if ( $res->resultStatus != PGRES_COMMAND_OK )  {
+		print STDERR $conn->errorMessage;
+		exit(1);
+	}
+}
+
+# get number of features from pg_class.ntuples
+# (correct if vacuum have been run after last insertion/deletions)
+$query = 'SELECT c.reltuples FROM pg_class c, pg_namespace n '.
+	"WHERE c.relnamespace = n.oid AND n.nspname = '$SCHEMA' ".
+	" AND c.relname = '$TABLE'";
+$res = $conn->exec($query);
+if ( $res->resultStatus != PGRES_TUPLES_OK )  {
+	print STDERR $conn->errorMessage;
+	exit(1);
+}
+$TOTROWS=$res->getvalue(0, 0);
+
+# pick the probe points
+$query = 'SELECT ST_X(c), ST_Y(c), ST_SRID(c) FROM ( SELECT '.
+	'ST_Centroid(ST_Envelope("'.$COLUMN.'")) AS c FROM "'.
+	$SCHEMA.'"."'.$TABLE.'" WHERE "'.$COLUMN.'" IS NOT NULL '.
+	'AND NOT ST_IsEmpty("'.$COLUMN.'") '.
+	"ORDER BY random() LIMIT $PROBES ) AS foo";
+$res = $conn->exec($query);
+if ( $res->resultStatus != PGRES_TUPLES_OK )  {
+	print STDERR $conn->errorMessage;
+	exit(1);
+}
+@probes = ();
+for ($i=0; $i<$res->ntuples; $i++)
+{
+	push(@probes, [ $res->getvalue($i, 0), $res->getvalue($i, 1) ]);
+	$SRID = $res->getvalue($i, 2);
+}
+
+print "  Rows: $TOTROWS\n";
+print "Probes: ".@probes."\n";
+
+print "  size\test\treal\tdelta\tratio\n";
+print "----------------------------------------------------------\n";
+
+foreach $size (@size_list)
+{
+	$sum_logratio=0;
+	$worst_ratio=1;
+	$count=0;
+	foreach $probe (@probes)
+	{
+		local(%box);
+		$box{'xmin'} = $probe->[0] - $size/2;
+		$box{'ymin'} = $probe->[1] - $size/2;
+		$box{'xmax'} = $probe->[0] + $size/2;
+		$box{'ymax'} = $probe->[1] + $size/2;
+
+		($est,$real) = test_extent(\%box);
+		$delta = $est-$real;
+
+		# +1 to keep empty boxes meaningful
+		$ratio = ($est+1)/($real+1);
+		$ratio = 1/$ratio if ( $ratio < 1 );
+
+		print "  $size\t$est\t$real\t$delta\t".(int($ratio*100)/100)."\n"
+			if ( $VERBOSE );
+
+		$sum_logratio += log($ratio);
+		$worst_ratio = $ratio if ( $ratio > $worst_ratio );
+		$count++;
+	}
+	next unless $count;
+
+	print "  $size\t".
+		"(avg/worst ratio)\t".
+		(int(exp($sum_logratio/$count)*100)/100)."\t".
+		(int($worst_ratio*100)/100)."\n";
+}
+
+
+##################################################################
+
+sub test_extent
+{
+	local($ext) = shift;
+	local($est, $real);
+
+	$query = 'explain analyze select 1 from "'.
+		$SCHEMA.'"."'.$TABLE.'" WHERE "'.$COLUMN.'" && '.
+		'ST_MakeEnvelope('.$ext->{'xmin'}.', '.$ext->{'ymin'}.', '.
+		$ext->{'xmax'}.', '.$ext->{'ymax'}.", $SRID)";
+	$res = $conn->exec($query);
+	if ( $res->resultStatus != PGRES_TUPLES_OK )  {
+		print STDERR $conn->errorMessage;
+		exit(1);
+	}
+	while ( ($row=$res->fetchrow()) )
+	{
+		next unless $row =~ /.* rows=([0-9]+) .* rows=([0-9]+) /;
+		$est = $1;
+		$real = $2;
+		last;
+	}
+
+	return ($est,$real);
+}